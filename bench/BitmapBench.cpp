@@ -12,6 +12,7 @@
 #include "SkColorPriv.h"
 #include "SkRandom.h"
 #include "SkString.h"
+#include "SkUtils.h"
 
 static const char* gConfigName[] = {
     "ERROR", "a1", "a8", "index8", "565", "4444", "8888"
@@ -81,6 +82,8 @@ class BitmapBench : public SkBenchmark {
     bool        fForceUpdate; //bitmap marked as dirty before each draw. forces bitmap to be updated on device cache
     bool        fIsVolatile;
     SkBitmap::Config fConfig;
+    int         fSIMDLevelCap;
+    const char* fSIMDLevelName;
     SkString    fName;
     enum { W = 128 };
     enum { H = 128 };
@@ -90,7 +93,16 @@ public:
         : fIsOpaque(isOpaque)
         , fForceUpdate(forceUpdate)
         , fIsVolatile(bitmapVolatile)
-        , fConfig(c) {
+        , fConfig(c)
+        , fSIMDLevelCap(SK_MaxS32)
+        , fSIMDLevelName(NULL) {
+    }
+
+    // Draw with procs from at most the given instruction set, e.g. SK_CPU_SSE_LEVEL_SSE2.
+    BitmapBench* capSIMDLevel(int level, const char levelName[]) {
+        fSIMDLevelCap = level;
+        fSIMDLevelName = levelName;
+        return this;
     }
 
 protected:
@@ -102,6 +114,8 @@ protected:
             fName.append("_update");
         if (fIsVolatile)
             fName.append("_volatile");
+        if (fSIMDLevelName)
+            fName.appendf("_%s", fSIMDLevelName);
 
         return fName.c_str();
     }
@@ -141,6 +155,9 @@ protected:
         const SkScalar x0 = SkIntToScalar(-bitmap.width() / 2);
         const SkScalar y0 = SkIntToScalar(-bitmap.height() / 2);
 
+        // Procs are chosen per draw, so this covers everything below.
+        const int prevCap = SkSetSIMDLevelCap(fSIMDLevelCap);
+
         for (int i = 0; i < loops; i++) {
             SkScalar x = x0 + rand.nextUScalar1() * dim.fX;
             SkScalar y = y0 + rand.nextUScalar1() * dim.fY;
@@ -150,6 +167,7 @@ protected:
 
             canvas->drawBitmap(bitmap, x, y, &paint);
         }
+        SkSetSIMDLevelCap(prevCap);
     }
 
     virtual void onDrawIntoBitmap(const SkBitmap& bm) {
@@ -383,3 +401,14 @@ DEF_BENCH( return new SourceAlphaBitmapBench(SourceAlphaBitmapBench::kOpaque_Sou
 DEF_BENCH( return new SourceAlphaBitmapBench(SourceAlphaBitmapBench::kTransparent_SourceAlpha, SkBitmap::kARGB_8888_Config); )
 DEF_BENCH( return new SourceAlphaBitmapBench(SourceAlphaBitmapBench::kTwoStripes_SourceAlpha, SkBitmap::kARGB_8888_Config); )
 DEF_BENCH( return new SourceAlphaBitmapBench(SourceAlphaBitmapBench::kThreeStripes_SourceAlpha, SkBitmap::kARGB_8888_Config); )
+
+#if defined(SK_CPU_X86) && !defined(SK_BUILD_FOR_IOS)
+// The same, per instruction set.  bitmap_8888_A -> S32A_Opaque_BlitRow32_{SSE2,AVX2}
+DEF_BENCH( return (new BitmapBench(false, SkBitmap::kARGB_8888_Config))->capSIMDLevel(SK_CPU_SSE_LEVEL_SSE2, "sse2"); )
+DEF_BENCH( return (new BitmapBench(false, SkBitmap::kARGB_8888_Config))->capSIMDLevel(SK_CPU_SSE_LEVEL_AVX2, "avx2"); )
+
+// scale filter -> S32_opaque_D32_filter_DX_{SSE2,SSSE3,AVX2}
+DEF_BENCH( return (new FilterBitmapBench(false, SkBitmap::kARGB_8888_Config, false, false, kScale_Flag | kBilerp_Flag))->capSIMDLevel(SK_CPU_SSE_LEVEL_SSE2, "sse2"); )
+DEF_BENCH( return (new FilterBitmapBench(false, SkBitmap::kARGB_8888_Config, false, false, kScale_Flag | kBilerp_Flag))->capSIMDLevel(SK_CPU_SSE_LEVEL_SSSE3, "ssse3"); )
+DEF_BENCH( return (new FilterBitmapBench(false, SkBitmap::kARGB_8888_Config, false, false, kScale_Flag | kBilerp_Flag))->capSIMDLevel(SK_CPU_SSE_LEVEL_AVX2, "avx2"); )
+#endif
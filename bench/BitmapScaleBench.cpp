@@ -6,12 +6,15 @@
  */
 
 #include "SkBenchmark.h"
+#include "SkBitmapProcState.h"
+#include "SkBitmapScaler.h"
 #include "SkCanvas.h"
 #include "SkPaint.h"
 #include "SkRandom.h"
 #include "SkShader.h"
 #include "SkString.h"
 #include "SkBlurMask.h"
+#include "SkTaskGroup.h"
 
 class BitmapScaleBench: public SkBenchmark {
     int         fLoopCount;
@@ -104,6 +107,41 @@ private:
     typedef BitmapScaleBench INHERITED;
 };
 
+// Calls SkBitmapScaler::Resize() directly, which is what the high quality filter above does,
+// optionally sharing the rows with a scheduler's threads.
+class BitmapResizeScaleBench: public BitmapScaleBench {
+ public:
+    BitmapResizeScaleBench( int is, int os, int threads) : INHERITED(is, os) {
+        fThreads = threads;
+        SkString name("resize");
+        if (threads > 0) {
+            name.appendf("_%d_threads", threads);
+        }
+        setName( name.c_str() );
+    }
+protected:
+    virtual void preBenchSetup() SK_OVERRIDE {
+        if (fThreads > 0 && NULL == fScheduler.get()) {
+            fScheduler.reset(SkNEW_ARGS(SkTaskScheduler, (fThreads)));
+        }
+        sk_bzero(&fProcs, sizeof(fProcs));
+        SkBitmapProcState state;
+        state.platformConvolutionProcs(&fProcs);
+    }
+
+    virtual void doScaleImage() SK_OVERRIDE {
+        SkBitmapScaler::Resize(&fOutputBitmap, fInputBitmap, SkBitmapScaler::RESIZE_BEST,
+                               SkIntToScalar(outputSize()), SkIntToScalar(outputSize()),
+                               fProcs, NULL, fScheduler.get());
+    }
+private:
+    int fThreads;
+    SkConvolutionProcs fProcs;
+    SkAutoTDelete<SkTaskScheduler> fScheduler;
+
+    typedef BitmapScaleBench INHERITED;
+};
+
 DEF_BENCH(return new BitmapFilterScaleBench(10, 90);)
 DEF_BENCH(return new BitmapFilterScaleBench(30, 90);)
 DEF_BENCH(return new BitmapFilterScaleBench(80, 90);)
@@ -113,3 +151,9 @@ DEF_BENCH(return new BitmapFilterScaleBench(90, 30);)
 DEF_BENCH(return new BitmapFilterScaleBench(90, 10);)
 DEF_BENCH(return new BitmapFilterScaleBench(256, 64);)
 DEF_BENCH(return new BitmapFilterScaleBench(64, 256);)
+
+// Large downscales, where the vertical pass has long filters and there are enough rows to share.
+DEF_BENCH(return new BitmapFilterScaleBench(2048, 512);)
+DEF_BENCH(return new BitmapFilterScaleBench(2048, 128);)
+DEF_BENCH(return new BitmapResizeScaleBench(2048, 512, 0);)
+DEF_BENCH(return new BitmapResizeScaleBench(2048, 512, 4);)
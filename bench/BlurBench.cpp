@@ -13,6 +13,7 @@
 #include "SkShader.h"
 #include "SkString.h"
 #include "SkBlurMaskFilter.h"
+#include "SkTaskGroup.h"
 
 #define SMALL   SkIntToScalar(2)
 #define REAL    1.5f
@@ -78,6 +79,75 @@ private:
     typedef SkBenchmark INHERITED;
 };
 
+// Calls SkBlurMask::BoxBlur directly on a large mask, to time the blur itself.
+class BlurMaskBench : public SkBenchmark {
+    SkScalar fSigma;
+    SkBlurQuality fQuality;
+    int fThreads;
+    SkMask fSrc;
+    SkString fName;
+    SkAutoTDelete<SkTaskScheduler> fScheduler;
+
+    enum { kSize = 1000 };
+
+public:
+    BlurMaskBench(SkScalar sigma, SkBlurQuality quality, int threads = 0)
+        : fSigma(sigma), fQuality(quality), fThreads(threads) {
+        fName.printf("blurmask_%d_%s", SkScalarRoundToInt(sigma),
+                     kHigh_SkBlurQuality == quality ? "high_quality" : "low_quality");
+        if (threads > 0) {
+            fName.appendf("_%d_threads", threads);
+        }
+        fSrc.fImage = NULL;
+    }
+
+    virtual ~BlurMaskBench() {
+        SkMask::FreeImage(fSrc.fImage);
+    }
+
+    virtual bool isSuitableFor(Backend backend) SK_OVERRIDE {
+        return backend == kNonRendering_Backend;
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual void onPreDraw() SK_OVERRIDE {
+        fSrc.fFormat = SkMask::kA8_Format;
+        fSrc.fBounds.set(0, 0, kSize, kSize);
+        fSrc.fRowBytes = kSize;
+        fSrc.fImage = SkMask::AllocImage(fSrc.computeImageSize());
+
+        SkRandom rand;
+        for (size_t i = 0; i < fSrc.computeImageSize(); ++i) {
+            fSrc.fImage[i] = rand.nextU() & 0xFF;
+        }
+        if (fThreads > 0) {
+            fScheduler.reset(SkNEW_ARGS(SkTaskScheduler, (fThreads)));
+        }
+    }
+
+    virtual void onDraw(const int loops, SkCanvas*) SK_OVERRIDE {
+        for (int i = 0; i < loops; i++) {
+            SkMask dst;
+            SkBlurMask::BoxBlur(&dst, fSrc, fSigma, kNormal_SkBlurStyle, fQuality,
+                                NULL, false, fScheduler.get());
+            SkMask::FreeImage(dst.fImage);
+        }
+    }
+
+    virtual void onPostDraw() SK_OVERRIDE {
+        fScheduler.free();
+        SkMask::FreeImage(fSrc.fImage);
+        fSrc.fImage = NULL;
+    }
+
+private:
+    typedef SkBenchmark INHERITED;
+};
+
 DEF_BENCH(return new BlurBench(SMALL, kNormal_SkBlurStyle);)
 DEF_BENCH(return new BlurBench(SMALL, kSolid_SkBlurStyle);)
 DEF_BENCH(return new BlurBench(SMALL, kOuter_SkBlurStyle);)
@@ -107,3 +177,16 @@ DEF_BENCH(return new BlurBench(REALBIG, kNormal_SkBlurStyle, SkBlurMaskFilter::k
 DEF_BENCH(return new BlurBench(REAL, kNormal_SkBlurStyle, SkBlurMaskFilter::kHighQuality_BlurFlag);)
 
 DEF_BENCH(return new BlurBench(0, kNormal_SkBlurStyle);)
+
+DEF_BENCH(return new BlurMaskBench(5, kLow_SkBlurQuality);)
+DEF_BENCH(return new BlurMaskBench(20, kLow_SkBlurQuality);)
+DEF_BENCH(return new BlurMaskBench(50, kLow_SkBlurQuality);)
+DEF_BENCH(return new BlurMaskBench(100, kLow_SkBlurQuality);)
+
+DEF_BENCH(return new BlurMaskBench(5, kHigh_SkBlurQuality);)
+DEF_BENCH(return new BlurMaskBench(20, kHigh_SkBlurQuality);)
+DEF_BENCH(return new BlurMaskBench(50, kHigh_SkBlurQuality);)
+DEF_BENCH(return new BlurMaskBench(100, kHigh_SkBlurQuality);)
+
+DEF_BENCH(return new BlurMaskBench(20, kHigh_SkBlurQuality, 4);)
+DEF_BENCH(return new BlurMaskBench(100, kHigh_SkBlurQuality, 4);)
@@ -20,12 +20,17 @@
 #include "SkXfermode.h"
 
 // Large blurred RR appear frequently on web pages. This benchmark measures our
-// performance in this case.
+// performance in this case.  With repeat > 1, it draws the same shadow that
+// many times per loop at different places, like a page full of cards.
 class BlurRoundRectBench : public SkBenchmark {
 public:
-    BlurRoundRectBench(int width, int height, int cornerRadius)
-        : fName("blurroundrect") {
+    BlurRoundRectBench(int width, int height, int cornerRadius, int repeat = 1)
+        : fName("blurroundrect")
+        , fRepeat(repeat) {
         fName.appendf("_WH[%ix%i]_cr[%i]", width, height, cornerRadius);
+        if (repeat > 1) {
+            fName.appendf("_repeat[%i]", repeat);
+        }
         SkRect r = SkRect::MakeWH(SkIntToScalar(width), SkIntToScalar(height));
         fRRect.setRectXY(r, SkIntToScalar(cornerRadius), SkIntToScalar(cornerRadius));
     }
@@ -72,14 +77,19 @@ public:
         loopedPaint.setColor(SK_ColorCYAN);
 
         for (int i = 0; i < loops; i++) {
-            canvas->drawRect(fRRect.rect(), dullPaint);
-            canvas->drawRRect(fRRect, loopedPaint);
+            for (int j = 0; j < fRepeat; j++) {
+                SkAutoCanvasRestore acr(canvas, true);
+                canvas->translate(SkIntToScalar(j % 8), SkIntToScalar(j / 8));
+                canvas->drawRect(fRRect.rect(), dullPaint);
+                canvas->drawRRect(fRRect, loopedPaint);
+            }
         }
     }
 
 private:
     SkString    fName;
     SkRRect     fRRect;
+    int         fRepeat;
 
     typedef     SkBenchmark INHERITED;
 };
@@ -91,3 +101,6 @@ DEF_BENCH(return new BlurRoundRectBench(100, 100, 6);)
 // Other radii options
 DEF_BENCH(return new BlurRoundRectBench(100, 100, 30);)
 DEF_BENCH(return new BlurRoundRectBench(100, 100, 90);)
+// The same shadow drawn over and over
+DEF_BENCH(return new BlurRoundRectBench(100, 100, 6, 64);)
+DEF_BENCH(return new BlurRoundRectBench(100, 100, 30, 64);)
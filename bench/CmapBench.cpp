@@ -66,18 +66,26 @@ class CMAPBench : public SkBenchmark {
     TypefaceProc fProc;
     SkString     fName;
     char         fText[NGLYPHS];
+    uint16_t     fText16[NGLYPHS];
     SkPaint      fPaint;
 
 public:
-    CMAPBench(TypefaceProc proc, const char name[]) {
+    CMAPBench(TypefaceProc proc, const char name[],
+              SkPaint::TextEncoding encoding = SkPaint::kUTF8_TextEncoding) {
         fProc = proc;
         fName.printf("cmap_%s", name);
 
         for (int i = 0; i < NGLYPHS; ++i) {
             // we're jamming values into utf8, so we must keep it legal utf8
             fText[i] = 'A' + (i & 31);
+            // and into utf16 we jam Cyrillic, to stay off the ASCII page
+            fText16[i] = 0x0410 + (i & 31);
         }
         fPaint.setTypeface(SkTypeface::RefDefault())->unref();
+        fPaint.setTextEncoding(encoding);
+        if (SkPaint::kUTF16_TextEncoding == encoding) {
+            fName.append("_utf16");
+        }
     }
 
 protected:
@@ -86,7 +94,11 @@ protected:
     }
 
     virtual void onDraw(const int loops, SkCanvas* canvas) SK_OVERRIDE {
-        fProc(loops, fPaint, fText, sizeof(fText), NGLYPHS);
+        if (SkPaint::kUTF16_TextEncoding == fPaint.getTextEncoding()) {
+            fProc(loops, fPaint, fText16, sizeof(fText16), NGLYPHS);
+        } else {
+            fProc(loops, fPaint, fText, sizeof(fText), NGLYPHS);
+        }
     }
 
 private:
@@ -100,3 +112,7 @@ DEF_BENCH( return new CMAPBench(containsText_proc, "paint_containsText"); )
 DEF_BENCH( return new CMAPBench(textToGlyphs_proc, "paint_textToGlyphs"); )
 DEF_BENCH( return new CMAPBench(charsToGlyphs_proc, "face_charsToGlyphs"); )
 DEF_BENCH( return new CMAPBench(charsToGlyphsNull_proc, "face_charsToGlyphs_null"); )
+DEF_BENCH( return new CMAPBench(textToGlyphs_proc, "paint_textToGlyphs",
+                                SkPaint::kUTF16_TextEncoding); )
+DEF_BENCH( return new CMAPBench(charsToGlyphs_proc, "face_charsToGlyphs",
+                                SkPaint::kUTF16_TextEncoding); )
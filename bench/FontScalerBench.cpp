@@ -6,26 +6,39 @@
  */
 
 #include "SkBenchmark.h"
+#include "SkBitmap.h"
 #include "SkCanvas.h"
 #include "SkGraphics.h"
 #include "SkPaint.h"
 #include "SkRandom.h"
 #include "SkString.h"
+#include "SkThreadUtils.h"
 
 class FontScalerBench : public SkBenchmark {
     SkString fName;
     SkString fText;
     bool     fDoLCD;
+    int      fThreads;
 public:
-    FontScalerBench(bool doLCD)  {
+    // With threads > 0, each of that many threads scales the text at sizes of its own, into a
+    // canvas of its own, so we measure how well glyph generation for different strikes scales.
+    FontScalerBench(bool doLCD, int threads = 0)  {
         fName.printf("fontscaler_%s", doLCD ? "lcd" : "aa");
+        if (threads > 0) {
+            fName.appendf("_threads_%d", threads);
+        }
         fText.set("abcdefghijklmnopqrstuvwxyz01234567890");
         fDoLCD = doLCD;
+        fThreads = threads;
     }
 
 protected:
     virtual const char* onGetName() { return fName.c_str(); }
     virtual void onDraw(const int loops, SkCanvas* canvas) {
+        if (fThreads > 0) {
+            this->drawThreaded(loops);
+            return;
+        }
         SkPaint paint;
         this->setupPaint(&paint);
         paint.setLCDRenderText(fDoLCD);
@@ -42,7 +55,54 @@ protected:
             }
         }
     }
+
 private:
+    struct Scaler {
+        const FontScalerBench* fBench;
+        int                    fIndex;
+
+        static void Run(void* data) {
+            const Scaler* scaler = static_cast<Scaler*>(data);
+            scaler->fBench->drawSizes(scaler->fIndex);
+        }
+    };
+
+    // Draws the text at the same number of sizes as the single threaded bench, but starting
+    // after those of the threads before this one, so no two threads share a strike.
+    void drawSizes(int index) const {
+        SkBitmap bitmap;
+        bitmap.allocN32Pixels(640, 40);
+        SkCanvas canvas(bitmap);
+        SkPaint paint;
+        paint.setAntiAlias(true);
+        paint.setLCDRenderText(fDoLCD);
+
+        const int first = 9 + index * 16;
+        for (int ps = first; ps < first + 16; ps += 2) {
+            paint.setTextSize(SkIntToScalar(ps));
+            canvas.drawText(fText.c_str(), fText.size(), 0, SkIntToScalar(20), paint);
+        }
+    }
+
+    void drawThreaded(int loops) {
+        SkAutoTMalloc<Scaler> scalers(fThreads);
+        SkAutoTMalloc<SkThread*> threads(fThreads);
+        for (int i = 0; i < loops; i++) {
+            SkGraphics::PurgeFontCache();
+
+            for (int t = 0; t < fThreads; t++) {
+                scalers[t].fBench = this;
+                scalers[t].fIndex = t;
+                threads[t] = SkNEW_ARGS(SkThread, (Scaler::Run, &scalers[t]));
+                threads[t]->start();
+            }
+            for (int t = 0; t < fThreads; t++) {
+                threads[t]->join();
+                SkDELETE(threads[t]);
+            }
+        }
+    }
+
     typedef SkBenchmark INHERITED;
 };
 
@@ -50,3 +110,5 @@ private:
 
 DEF_BENCH( return SkNEW_ARGS(FontScalerBench, (false)); )
 DEF_BENCH( return SkNEW_ARGS(FontScalerBench, (true)); )
+DEF_BENCH( return SkNEW_ARGS(FontScalerBench, (false, 1)); )
+DEF_BENCH( return SkNEW_ARGS(FontScalerBench, (false, 4)); )
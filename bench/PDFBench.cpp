@@ -0,0 +1,94 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBenchmark.h"
+#include "SkCanvas.h"
+#include "SkColorPriv.h"
+#include "SkPDFDevice.h"
+#include "SkPDFDocument.h"
+#include "SkRandom.h"
+#include "SkStream.h"
+#include "SkString.h"
+
+// Draws the same picture of a bitmap on every page of a PDF.  If shared, every
+// page draws the same SkBitmap, so the document only needs to encode and
+// compress it once.  Otherwise each page's bitmap has the same pixels in a
+// pixel ref of its own, so it's encoded again on every page, as if nothing
+// were shared.  The difference in time is what sharing saves.
+class PDFImageBench : public SkBenchmark {
+public:
+    PDFImageBench(bool shared) : fShared(shared) {
+        fName.printf("pdf_image_%s", shared ? "shared" : "unique");
+    }
+
+    virtual bool isSuitableFor(Backend backend) SK_OVERRIDE {
+        return backend == kNonRendering_Backend;
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual void onPreDraw() SK_OVERRIDE {
+        SkBitmap logo;
+        logo.allocN32Pixels(kSize, kSize, true);
+        SkRandom rand;
+        for (int y = 0; y < kSize; y++) {
+            for (int x = 0; x < kSize; x++) {
+                // A few colors, so the image compresses but not to nothing.
+                *logo.getAddr32(x, y) =
+                        SkPreMultiplyColor(0xFF000000 | (rand.nextU() & 0x030303) * 0x55);
+            }
+        }
+        for (int i = 0; i < kPages; i++) {
+            if (fShared || 0 == i) {
+                fBitmaps[i] = logo;
+            } else {
+                // Not copyTo(), which would give the copy the same generation ID.
+                fBitmaps[i].allocN32Pixels(kSize, kSize, true);
+                memcpy(fBitmaps[i].getPixels(), logo.getPixels(), logo.getSize());
+            }
+        }
+    }
+
+    virtual void onDraw(const int loops, SkCanvas*) SK_OVERRIDE {
+        for (int i = 0; i < loops; i++) {
+            SkDynamicMemoryWStream stream;
+            this->makePDF(&stream);
+        }
+    }
+
+private:
+    enum {
+        kSize = 256,
+        kPages = 16,
+    };
+
+    void makePDF(SkWStream* stream) {
+        SkPDFDocument doc;
+        for (int i = 0; i < kPages; i++) {
+            SkISize pageSize = SkISize::Make(2 * kSize, 2 * kSize);
+            SkAutoTUnref<SkPDFDevice> dev(SkNEW_ARGS(SkPDFDevice,
+                                                     (pageSize, pageSize, SkMatrix::I())));
+            SkCanvas canvas(dev);
+            canvas.drawBitmap(fBitmaps[i], 0, 0);
+            canvas.drawBitmap(fBitmaps[i], SkIntToScalar(kSize), SkIntToScalar(kSize));
+            doc.appendPage(dev);
+        }
+        doc.emitPDF(stream);
+    }
+
+    bool fShared;
+    SkString fName;
+    SkBitmap fBitmaps[kPages];
+
+    typedef SkBenchmark INHERITED;
+};
+
+DEF_BENCH( return SkNEW_ARGS(PDFImageBench, (true)); )
+DEF_BENCH( return SkNEW_ARGS(PDFImageBench, (false)); )
@@ -7,23 +7,32 @@
  */
 #include "SkBenchmark.h"
 #include "SkBitmap.h"
+#include "SkBlitter.h"
 #include "SkCanvas.h"
 #include "SkColorPriv.h"
 #include "SkPaint.h"
 #include "SkRandom.h"
+#include "SkRasterClip.h"
+#include "SkScan.h"
 #include "SkShader.h"
 #include "SkString.h"
 #include "SkTArray.h"
+#include "SkTDArray.h"
 
 enum Flags {
-    kStroke_Flag = 1 << 0,
-    kBig_Flag    = 1 << 1
+    kStroke_Flag   = 1 << 0,
+    kBig_Flag      = 1 << 1,
+    kAnalytic_Flag = 1 << 2     // Antialias with SkScan's analytic coverage, not supersampling.
 };
 
 #define FLAGS00  Flags(0)
 #define FLAGS01  Flags(kStroke_Flag)
 #define FLAGS10  Flags(kBig_Flag)
 #define FLAGS11  Flags(kStroke_Flag | kBig_Flag)
+#define FLAGS00A Flags(kAnalytic_Flag)
+#define FLAGS01A Flags(kStroke_Flag | kAnalytic_Flag)
+#define FLAGS10A Flags(kBig_Flag | kAnalytic_Flag)
+#define FLAGS11A Flags(kStroke_Flag | kBig_Flag | kAnalytic_Flag)
 
 class PathBench : public SkBenchmark {
     SkPaint     fPaint;
@@ -47,6 +56,9 @@ protected:
                      fFlags & kStroke_Flag ? "stroke" : "fill",
                      fFlags & kBig_Flag ? "big" : "small");
         this->appendName(&fName);
+        if (fFlags & kAnalytic_Flag) {
+            fName.append("_analytic");
+        }
         return fName.c_str();
     }
 
@@ -68,12 +80,41 @@ protected:
         }
         count >>= (3 * complexity());
 
+        if ((fFlags & kAnalytic_Flag) && paint.isAntiAlias()) {
+            this->analyticFill(count, path, paint, canvas);
+            return;
+        }
         for (int i = 0; i < count; i++) {
             canvas->drawPath(path, paint);
         }
     }
 
 private:
+    // SkCanvas always antialiases by supersampling, so scan convert with SkScan directly into a
+    // raster the size of the canvas.  Stroking and the matrix are applied once, up front.
+    void analyticFill(int count, const SkPath& path, const SkPaint& paint, SkCanvas* canvas) {
+        const SkISize size = canvas->getBaseLayerSize();
+        if (fDst.width() != size.width() || fDst.height() != size.height()) {
+            fDst.allocN32Pixels(size.width(), size.height());
+        }
+
+        SkPath fill;
+        paint.getFillPath(path, &fill);
+        fill.transform(canvas->getTotalMatrix());
+
+        SkPaint fillPaint(paint);
+        fillPaint.setStyle(SkPaint::kFill_Style);
+        SkTBlitterAllocator allocator;
+        SkBlitter* blitter = SkBlitter::Choose(fDst, SkMatrix::I(), fillPaint, &allocator);
+        const SkRasterClip clip(SkIRect::MakeWH(size.width(), size.height()));
+
+        for (int i = 0; i < count; i++) {
+            SkScan::AntiFillPath(fill, clip, blitter, SkScan::kAnalytic_AAType);
+        }
+    }
+
+    SkBitmap fDst;
+
     typedef SkBenchmark INHERITED;
 };
 
@@ -349,6 +390,79 @@ private:
     typedef RandomPathBench INHERITED;
 };
 
+// Builds a path of many small polygons from arrays of points, as when converting map geometry:
+// point by point, point by point after reserving room for them all, or with one addPolys().
+class PathBulkCreateBench : public SkBenchmark {
+public:
+    enum Mode {
+        kPerPoint_Mode,
+        kReserved_Mode,
+        kAddPolys_Mode,
+    };
+
+    PathBulkCreateBench(Mode mode) : fMode(mode) {
+        static const char* gModeNames[] = { "per_point", "reserved", "add_polys" };
+        fName.printf("path_bulk_create_%s", gModeNames[mode]);
+    }
+
+    virtual bool isSuitableFor(Backend backend) SK_OVERRIDE {
+        return backend == kNonRendering_Backend;
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual void onPreDraw() SK_OVERRIDE {
+        SkRandom rand;
+        fCounts.reset();
+        fPoints.reset();
+        for (int i = 0; i < kNumPolygons; ++i) {
+            int count = rand.nextRangeU(4, 16);
+            *fCounts.append() = count;
+            for (int j = 0; j < count; ++j) {
+                fPoints.append()->set(rand.nextUScalar1() * 640, rand.nextUScalar1() * 480);
+            }
+        }
+    }
+
+    virtual void onDraw(const int loops, SkCanvas*) SK_OVERRIDE {
+        for (int i = 0; i < loops; ++i) {
+            SkPath path;
+            if (kAddPolys_Mode == fMode) {
+                path.addPolys(SkPath::kLine_Verb, fPoints.begin(), fCounts.begin(),
+                              fCounts.count(), true);
+                continue;
+            }
+            if (kReserved_Mode == fMode) {
+                // Each polygon adds a verb per point, plus a close.
+                path.incReserve(fPoints.count() + fCounts.count(), fPoints.count());
+            }
+            const SkPoint* pts = fPoints.begin();
+            for (int c = 0; c < fCounts.count(); ++c) {
+                path.moveTo(pts[0]);
+                for (int j = 1; j < fCounts[c]; ++j) {
+                    path.lineTo(pts[j]);
+                }
+                path.close();
+                pts += fCounts[c];
+            }
+        }
+    }
+
+private:
+    enum {
+        kNumPolygons = 1000,
+    };
+    Mode                fMode;
+    SkString            fName;
+    SkTDArray<int>      fCounts;
+    SkTDArray<SkPoint>  fPoints;
+
+    typedef SkBenchmark INHERITED;
+};
+
 class PathCopyBench : public RandomPathBench {
 public:
     PathCopyBench()  {
@@ -1019,7 +1133,33 @@ DEF_BENCH( return new LongCurvedPathBench(FLAGS01); )
 DEF_BENCH( return new LongLinePathBench(FLAGS00); )
 DEF_BENCH( return new LongLinePathBench(FLAGS01); )
 
+DEF_BENCH( return new TrianglePathBench(FLAGS00A); )
+DEF_BENCH( return new TrianglePathBench(FLAGS01A); )
+DEF_BENCH( return new TrianglePathBench(FLAGS10A); )
+DEF_BENCH( return new TrianglePathBench(FLAGS11A); )
+
+DEF_BENCH( return new OvalPathBench(FLAGS00A); )
+DEF_BENCH( return new OvalPathBench(FLAGS01A); )
+DEF_BENCH( return new OvalPathBench(FLAGS10A); )
+DEF_BENCH( return new OvalPathBench(FLAGS11A); )
+
+DEF_BENCH( return new CirclePathBench(FLAGS00A); )
+DEF_BENCH( return new CirclePathBench(FLAGS01A); )
+DEF_BENCH( return new CirclePathBench(FLAGS10A); )
+DEF_BENCH( return new CirclePathBench(FLAGS11A); )
+
+DEF_BENCH( return new SawToothPathBench(FLAGS00A); )
+DEF_BENCH( return new SawToothPathBench(FLAGS01A); )
+
+DEF_BENCH( return new LongCurvedPathBench(FLAGS00A); )
+DEF_BENCH( return new LongCurvedPathBench(FLAGS01A); )
+DEF_BENCH( return new LongLinePathBench(FLAGS00A); )
+DEF_BENCH( return new LongLinePathBench(FLAGS01A); )
+
 DEF_BENCH( return new PathCreateBench(); )
+DEF_BENCH( return new PathBulkCreateBench(PathBulkCreateBench::kPerPoint_Mode); )
+DEF_BENCH( return new PathBulkCreateBench(PathBulkCreateBench::kReserved_Mode); )
+DEF_BENCH( return new PathBulkCreateBench(PathBulkCreateBench::kAddPolys_Mode); )
 DEF_BENCH( return new PathCopyBench(); )
 DEF_BENCH( return new PathTransformBench(true); )
 DEF_BENCH( return new PathTransformBench(false); )
@@ -0,0 +1,147 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBenchmark.h"
+#include "SkPath.h"
+#include "SkPathOps.h"
+#include "SkRandom.h"
+#include "SkString.h"
+#include "SkTArray.h"
+#include "SkTaskGroup.h"
+
+// Unions a map tile's worth of overlapping polygons of 3 to 12 sides, like building outlines,
+// either folding them in one at a time with Op(), or all at once with Union(), which combines
+// them in a tree on the calling thread or on one thread per core.
+class PathOpsUnionBench : public SkBenchmark {
+public:
+    enum Mode {
+        kFold_Mode,
+        kTree_Mode,
+        kThreadedTree_Mode,
+    };
+
+    PathOpsUnionBench(Mode mode, int count) : fMode(mode), fCount(count) {
+        static const char* gModeNames[] = { "fold", "tree", "threaded_tree" };
+        fName.printf("pathops_union_%s_%d", gModeNames[mode], count);
+    }
+
+    virtual bool isSuitableFor(Backend backend) SK_OVERRIDE {
+        return backend == kNonRendering_Backend;
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual void onPreDraw() SK_OVERRIDE {
+        SkRandom rand;
+        fPolygons.reset();
+        for (int index = 0; index < fCount; ++index) {
+            SkScalar cx = rand.nextRangeScalar(0, 512);
+            SkScalar cy = rand.nextRangeScalar(0, 512);
+            SkScalar radius = rand.nextRangeScalar(5, 25);
+            SkScalar start = rand.nextRangeScalar(0, SK_ScalarPI);
+            int sides = rand.nextRangeU(3, 12);
+            SkPath& polygon = fPolygons.push_back();
+            for (int side = 0; side < sides; ++side) {
+                SkScalar angle = start + 2 * SK_ScalarPI * side / sides;
+                SkScalar r = radius * rand.nextRangeScalar(0.7f, 1);
+                SkPoint pt = SkPoint::Make(cx + r * SkScalarCos(angle),
+                                           cy + r * SkScalarSin(angle));
+                if (0 == side) {
+                    polygon.moveTo(pt);
+                } else {
+                    polygon.lineTo(pt);
+                }
+            }
+            polygon.close();
+        }
+        if (kThreadedTree_Mode == fMode) {
+            fScheduler.reset(SkNEW_ARGS(SkTaskScheduler, (SkTaskScheduler::kThreadPerCore)));
+        }
+    }
+
+    virtual void onDraw(const int loops, SkCanvas*) SK_OVERRIDE {
+        for (int i = 0; i < loops; ++i) {
+            SkPath result;
+            if (kFold_Mode == fMode) {
+                result = fPolygons[0];
+                for (int index = 1; index < fPolygons.count(); ++index) {
+                    Op(result, fPolygons[index], kUnion_PathOp, &result);
+                }
+            } else {
+                Union(fPolygons.begin(), fPolygons.count(), &result, fScheduler.get());
+            }
+        }
+    }
+
+    virtual void onPostDraw() SK_OVERRIDE {
+        fScheduler.free();
+    }
+
+private:
+    Mode                            fMode;
+    int                             fCount;
+    SkString                        fName;
+    SkTArray<SkPath>                fPolygons;
+    SkAutoTDelete<SkTaskScheduler>  fScheduler;
+
+    typedef SkBenchmark INHERITED;
+};
+
+// Simplifies a single contour of many edges that cross each other, where most segment pairs
+// don't overlap: one star polygon, drawn by joining every third of its points.
+class PathOpsSimplifyStarBench : public SkBenchmark {
+public:
+    PathOpsSimplifyStarBench(int points) : fPoints(points) {
+        fName.printf("pathops_simplify_star_%d", points);
+    }
+
+    virtual bool isSuitableFor(Backend backend) SK_OVERRIDE {
+        return backend == kNonRendering_Backend;
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual void onPreDraw() SK_OVERRIDE {
+        fStar.reset();
+        for (int index = 0; index < fPoints; ++index) {
+            SkScalar angle = 2 * SK_ScalarPI * (index * 3 % fPoints) / fPoints;
+            SkPoint pt = SkPoint::Make(256 + 200 * SkScalarCos(angle),
+                                       256 + 200 * SkScalarSin(angle));
+            if (0 == index) {
+                fStar.moveTo(pt);
+            } else {
+                fStar.lineTo(pt);
+            }
+        }
+        fStar.close();
+    }
+
+    virtual void onDraw(const int loops, SkCanvas*) SK_OVERRIDE {
+        for (int i = 0; i < loops; ++i) {
+            SkPath result;
+            Simplify(fStar, &result);
+        }
+    }
+
+private:
+    int      fPoints;
+    SkString fName;
+    SkPath   fStar;
+
+    typedef SkBenchmark INHERITED;
+};
+
+DEF_BENCH( return SkNEW_ARGS(PathOpsUnionBench, (PathOpsUnionBench::kFold_Mode, 200)); )
+DEF_BENCH( return SkNEW_ARGS(PathOpsUnionBench, (PathOpsUnionBench::kTree_Mode, 200)); )
+DEF_BENCH( return SkNEW_ARGS(PathOpsUnionBench, (PathOpsUnionBench::kThreadedTree_Mode, 200)); )
+DEF_BENCH( return SkNEW_ARGS(PathOpsSimplifyStarBench, (301)); )
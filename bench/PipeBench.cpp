@@ -0,0 +1,105 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SamplePipeControllers.h"
+#include "SharedMemoryPipeController.h"
+#include "SkBenchmark.h"
+#include "SkCanvas.h"
+#include "SkGPipe.h"
+#include "SkPaint.h"
+#include "SkString.h"
+#include "SkThreadUtils.h"
+
+// Sends loops draw calls through an SkGPipe, to measure ops per second.  The shared memory
+// version plays back on another thread as it goes, as a rasterizer process would; the sample
+// controller plays each op back synchronously as it is written.
+class PipeBench : public SkBenchmark {
+public:
+    PipeBench(bool sharedMemory) : fSharedMemory(sharedMemory) {
+        fName.printf("pipe_%s", sharedMemory ? "shared_memory" : "sample");
+    }
+
+    virtual bool isSuitableFor(Backend backend) SK_OVERRIDE {
+        return backend == kNonRendering_Backend;
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual void onPreDraw() SK_OVERRIDE {
+        fBitmap.allocN32Pixels(kSize, kSize);
+        fBitmap.eraseColor(SK_ColorWHITE);
+        if (fSharedMemory) {
+            size_t bytes = SharedMemoryPipeController::MemorySize(kRingBytes);
+            fMemory.reset(SharedMemory::Create(NULL, bytes));
+        }
+    }
+
+    virtual void onDraw(const int loops, SkCanvas*) SK_OVERRIDE {
+        SkCanvas target(fBitmap);
+        if (!fSharedMemory) {
+            PipeController controller(&target);
+            this->record(&controller, loops);
+            return;
+        }
+        if (NULL == fMemory.get() ||
+            !SharedMemoryPipeController::Initialize(fMemory->memory(), fMemory->size())) {
+            return;
+        }
+
+        Playback playback = { fMemory->memory(), &target };
+        SkThread reader(Playback::Run, &playback);
+        reader.start();
+        {
+            SharedMemoryPipeController controller(fMemory->memory());
+            this->record(&controller, loops);
+        }
+        reader.join();
+    }
+
+private:
+    enum {
+        kSize = 64,
+        kRingBytes = 1 << 20,
+    };
+
+    struct Playback {
+        void*     fMemory;
+        SkCanvas* fCanvas;
+
+        static void Run(void* data) {
+            Playback* playback = static_cast<Playback*>(data);
+            SharedMemoryPipeReader reader(playback->fMemory, playback->fCanvas);
+            reader.playbackUntilDone();
+        }
+    };
+
+    void record(SkGPipeController* controller, int loops) {
+        SkGPipeWriter writer;
+        SkCanvas* canvas = writer.startRecording(controller, SkGPipeWriter::kCrossProcess_Flag,
+                                                 kSize, kSize);
+        SkPaint paint;
+        for (int i = 0; i < loops; i++) {
+            paint.setColor(0xFF000000 | (i * 0x10204));
+            canvas->drawRect(SkRect::MakeXYWH(SkIntToScalar(i % 48), SkIntToScalar(i % 40),
+                                              16, 16), paint);
+        }
+        writer.endRecording();
+    }
+
+    bool fSharedMemory;
+    SkString fName;
+    SkBitmap fBitmap;
+    SkAutoTDelete<SharedMemory> fMemory;
+
+    typedef SkBenchmark INHERITED;
+};
+
+DEF_BENCH( return SkNEW_ARGS(PipeBench, (true)); )
+DEF_BENCH( return SkNEW_ARGS(PipeBench, (false)); )
@@ -6,11 +6,14 @@
  * found in the LICENSE file.
  */
 #include "SkBenchmark.h"
+#include "SkBitmapDevice.h"
 #include "SkCanvas.h"
 #include "SkFontHost.h"
+#include "SkGraphics.h"
 #include "SkPaint.h"
 #include "SkRandom.h"
 #include "SkString.h"
+#include "SkTaskGroup.h"
 #include "SkTemplates.h"
 
 enum FontQuality {
@@ -126,6 +129,136 @@ private:
     typedef SkBenchmark INHERITED;
 };
 
+/*  Measures the same few lines of text over and over with the same paint, as a layout engine
+    does each frame, either through the glyph cache or with the text measure cache on.
+ */
+class TextMeasureBench : public SkBenchmark {
+    SkPaint     fPaint;
+    SkString    fName;
+    bool        fUseCache;
+    size_t      fPrevLimit;
+public:
+    TextMeasureBench(bool useCache) : fUseCache(useCache), fPrevLimit(0) {
+        fPaint.setAntiAlias(true);
+        fPaint.setTextSize(SkIntToScalar(16));
+        fName.printf("text_measure_repeat%s", useCache ? "_cached" : "");
+    }
+
+    virtual bool isSuitableFor(Backend backend) SK_OVERRIDE {
+        return backend == kNonRendering_Backend;
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual void onPreDraw() SK_OVERRIDE {
+        fPrevLimit = SkGraphics::SetTextMeasureCacheLimit(fUseCache ? 1024 * 1024 : 0);
+    }
+
+    virtual void onPostDraw() SK_OVERRIDE {
+        SkGraphics::SetTextMeasureCacheLimit(fPrevLimit);
+    }
+
+    virtual void onDraw(const int loops, SkCanvas*) SK_OVERRIDE {
+        static const char* gLines[] = {
+            "The quick brown fox jumps over the lazy dog.",
+            "Sphinx of black quartz, judge my vow!",
+            "Pack my box with five dozen liquor jugs.",
+            "How vexingly quick daft zebras jump.",
+        };
+        size_t lengths[SK_ARRAY_COUNT(gLines)];
+        for (size_t i = 0; i < SK_ARRAY_COUNT(gLines); ++i) {
+            lengths[i] = strlen(gLines[i]);
+        }
+        SkScalar widths[64];
+
+        for (int i = 0; i < loops; i++) {
+            for (size_t j = 0; j < SK_ARRAY_COUNT(gLines); ++j) {
+                fPaint.measureText(gLines[j], lengths[j]);
+                fPaint.getTextWidths(gLines[j], lengths[j], widths);
+                fPaint.breakText(gLines[j], lengths[j], SkIntToScalar(120));
+            }
+        }
+    }
+
+private:
+    typedef SkBenchmark INHERITED;
+};
+
+/*  Draws a line of text at many sizes. Normally each size gets a strike of its own; with
+    distance fields, the sizes share a few strikes, scaled to fit. With cold set, the glyph
+    cache is purged each loop, so the strikes' glyphs (and fields) are made anew each time.
+    It draws into a device of its own, which makes the fields on fThreads threads, if any.
+ */
+class TextSizesBench : public SkBenchmark {
+    SkPaint     fPaint;
+    SkString    fName;
+    bool        fCold;
+    int         fThreads;
+    SkAutoTDelete<SkTaskScheduler> fScheduler;
+    SkAutoTUnref<SkBitmapDevice>   fDevice;
+
+    enum {
+        kSizeCount = 16
+    };
+public:
+    TextSizesBench(bool distanceField, bool cold, int threads = 0)
+        : fCold(cold), fThreads(threads) {
+        fPaint.setAntiAlias(true);
+        fPaint.setDistanceFieldTextTEMP(distanceField);
+        fName.printf("text_sizes%s%s", distanceField ? "_df" : "", cold ? "_cold" : "");
+        if (threads > 0) {
+            fName.appendf("_%d_threads", threads);
+        }
+    }
+
+    virtual bool isSuitableFor(Backend backend) SK_OVERRIDE {
+        return backend == kRaster_Backend;
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual void onPreDraw() SK_OVERRIDE {
+        const SkIPoint size = this->getSize();
+        fDevice.reset(SkBitmapDevice::Create(SkImageInfo::MakeN32Premul(size.fX, size.fY)));
+        if (fThreads > 0) {
+            fScheduler.reset(SkNEW_ARGS(SkTaskScheduler, (fThreads)));
+            fDevice->setTaskScheduler(fScheduler.get());
+        }
+    }
+
+    virtual void onPostDraw() SK_OVERRIDE {
+        fDevice.reset(NULL);
+        fScheduler.free();
+    }
+
+    virtual void onDraw(const int loops, SkCanvas*) SK_OVERRIDE {
+        static const char kText[] = "The quick brown fox jumps over the lazy dog";
+        SkCanvas canvas(fDevice.get());
+
+        SkPaint paint(fPaint);
+        for (int i = 0; i < loops; i++) {
+            if (fCold) {
+                SkGraphics::PurgeFontCache();
+            }
+            SkScalar y = 0;
+            for (int size = 0; size < kSizeCount; ++size) {
+                paint.setTextSize(SkIntToScalar(20 + 12 * size));
+                y += paint.getTextSize();
+                canvas.drawText(kText, sizeof(kText) - 1, 0, y, paint);
+            }
+        }
+    }
+
+private:
+    typedef SkBenchmark INHERITED;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 
 #define STR     "Hamburgefons"
@@ -143,3 +276,12 @@ DEF_BENCH( return new TextBench(STR, 16, 0xFFFF0000, kLCD); )
 DEF_BENCH( return new TextBench(STR, 16, 0x88FF0000, kLCD); )
 
 DEF_BENCH( return new TextBench(STR, 16, 0xFF000000, kAA, true); )
+
+DEF_BENCH( return new TextMeasureBench(false); )
+DEF_BENCH( return new TextMeasureBench(true); )
+
+DEF_BENCH( return new TextSizesBench(false, false); )
+DEF_BENCH( return new TextSizesBench(true, false); )
+DEF_BENCH( return new TextSizesBench(false, true); )
+DEF_BENCH( return new TextSizesBench(true, true); )
+DEF_BENCH( return new TextSizesBench(true, true, 4); )
@@ -11,7 +11,11 @@
 #include "SkPaint.h"
 #include "SkRandom.h"
 #include "SkString.h"
+#include "SkUtils.h"
 #include "SkXfermode.h"
+#include "SkXfermode_proccoeff.h"
+
+extern SkProcCoeffXfermode* SkPlatformXfermodeFactory(const ProcCoeff& rec, SkXfermode::Mode mode);
 
 // Benchmark that draws non-AA rects with an SkXfermode::Mode
 class XfermodeBench : public SkBenchmark {
@@ -28,6 +32,23 @@ public:
         fName.printf("Xfermode_%s", name);
     }
 
+    // Uses the platform's SIMD version of mode, restricted to the given instruction set.
+    XfermodeBench(SkXfermode::Mode mode, int simdLevelCap, const char* simdLevelName) {
+        ProcCoeff rec;
+        rec.fProc = SkXfermode::GetProc(mode);
+        if (!SkXfermode::ModeAsCoeff(mode, &rec.fSC, &rec.fDC)) {
+            rec.fSC = rec.fDC = CANNOT_USE_COEFF;
+        }
+        int prevCap = SkSetSIMDLevelCap(simdLevelCap);
+        fXfermode.reset(SkPlatformXfermodeFactory(rec, mode));
+        SkSetSIMDLevelCap(prevCap);
+        if (NULL == fXfermode.get()) {
+            // No SIMD version at all; measure the portable one so the names still line up.
+            fXfermode.reset(SkXfermode::Create(mode));
+        }
+        fName.printf("Xfermode_%s_%s", SkXfermode::ModeName(mode), simdLevelName);
+    }
+
 protected:
     virtual const char* onGetName() SK_OVERRIDE { return fName.c_str(); }
 
@@ -125,3 +146,21 @@ BENCH(SkXfermode::kColor_Mode)
 BENCH(SkXfermode::kLuminosity_Mode)
 
 DEF_BENCH(return new XferCreateBench;)
+
+#if defined(SK_CPU_X86) && !defined(SK_BUILD_FOR_IOS)
+// The coefficient modes again, per instruction set.
+BENCH(SkXfermode::kDstOver_Mode, SK_CPU_SSE_LEVEL_SSE2, "sse2")
+BENCH(SkXfermode::kDstOver_Mode, SK_CPU_SSE_LEVEL_AVX2, "avx2")
+BENCH(SkXfermode::kSrcIn_Mode, SK_CPU_SSE_LEVEL_SSE2, "sse2")
+BENCH(SkXfermode::kSrcIn_Mode, SK_CPU_SSE_LEVEL_AVX2, "avx2")
+BENCH(SkXfermode::kSrcATop_Mode, SK_CPU_SSE_LEVEL_SSE2, "sse2")
+BENCH(SkXfermode::kSrcATop_Mode, SK_CPU_SSE_LEVEL_AVX2, "avx2")
+BENCH(SkXfermode::kXor_Mode, SK_CPU_SSE_LEVEL_SSE2, "sse2")
+BENCH(SkXfermode::kXor_Mode, SK_CPU_SSE_LEVEL_AVX2, "avx2")
+BENCH(SkXfermode::kPlus_Mode, SK_CPU_SSE_LEVEL_SSE2, "sse2")
+BENCH(SkXfermode::kPlus_Mode, SK_CPU_SSE_LEVEL_AVX2, "avx2")
+BENCH(SkXfermode::kModulate_Mode, SK_CPU_SSE_LEVEL_SSE2, "sse2")
+BENCH(SkXfermode::kModulate_Mode, SK_CPU_SSE_LEVEL_AVX2, "avx2")
+BENCH(SkXfermode::kScreen_Mode, SK_CPU_SSE_LEVEL_SSE2, "sse2")
+BENCH(SkXfermode::kScreen_Mode, SK_CPU_SSE_LEVEL_AVX2, "avx2")
+#endif
@@ -3,10 +3,15 @@
 
 namespace DM {
 
-TaskRunner::TaskRunner(int cpuThreads, int gpuThreads) : fCpu(cpuThreads), fGpu(gpuThreads) {}
+TaskRunner::TaskRunner(int cpuThreads, int gpuThreads)
+    : fCpu(cpuThreads)
+    , fCpuTasks(&fCpu)
+    , fGpu(gpuThreads) {}
 
-void TaskRunner::add(CpuTask* task) { fCpu.add(task); }
-void TaskRunner::addNext(CpuTask* task) { fCpu.addNext(task); }
+// There's no need for addNext() to jump the queue any more: work added from a CPU thread goes to
+// the back of its own deque, which is exactly where that thread looks next.
+void TaskRunner::add(CpuTask* task) { fCpuTasks.add(task); }
+void TaskRunner::addNext(CpuTask* task) { fCpuTasks.add(task); }
 void TaskRunner::add(GpuTask* task) { fGpu.add(task); }
 
 void TaskRunner::wait() {
@@ -15,7 +20,7 @@ void TaskRunner::wait() {
     // we'll never try to add to it later.  Same can't be said of the CPU pool:
     // both CPU and GPU tasks can spawn off new CPU work, so we wait for that last.
     fGpu.wait();
-    fCpu.wait();
+    fCpuTasks.wait();
 }
 
 }  // namespace DM
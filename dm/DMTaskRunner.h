@@ -2,11 +2,14 @@
 #define DMTaskRunner_DEFINED
 
 #include "DMGpuSupport.h"
+#include "SkTaskGroup.h"
 #include "SkThreadPool.h"
 #include "SkTypes.h"
 
 // TaskRunner runs Tasks on one of two threadpools depending on the need for a GrContextFactory.
 // It's typically a good idea to run fewer GPU threads than CPU threads (go nuts with those).
+// CPU tasks run on a work-stealing SkTaskScheduler, so children spawned by a task tend to run on
+// the same thread as their parent.
 
 namespace DM {
 
@@ -23,7 +26,8 @@ public:
     void wait();
 
 private:
-    SkTThreadPool<void> fCpu;
+    SkTaskScheduler fCpu;
+    SkTaskGroup fCpuTasks;
     SkTThreadPool<GrContextFactory> fGpu;
 };
 
@@ -16,6 +16,7 @@
       ],
       'include_dirs': [
         '../include/effects',
+        '../include/utils',
         '../src/effects',
         '../src/opts',
         '../src/core',
@@ -46,6 +46,7 @@
           ],
           'dependencies': [
             'opts_ssse3',
+            'opts_avx2',
           ],
           'sources': [
             '../src/opts/opts_check_x86.cpp',
@@ -54,6 +55,7 @@
             '../src/opts/SkBlitRow_opts_SSE2.cpp',
             '../src/opts/SkBlitRect_opts_SSE2.cpp',
             '../src/opts/SkBlurImage_opts_SSE2.cpp',
+            '../src/opts/SkBlurMask_opts_SSE2.cpp',
             '../src/opts/SkMorphology_opts_SSE2.cpp',
             '../src/opts/SkUtils_opts_SSE2.cpp',
             '../src/opts/SkXfermode_opts_SSE2.cpp',
@@ -80,6 +82,7 @@
             '../src/opts/SkBlitMask_opts_arm.cpp',
             '../src/opts/SkBlitRow_opts_arm.cpp',
             '../src/opts/SkBlurImage_opts_arm.cpp',
+            '../src/opts/SkBlurMask_opts_arm.cpp',
             '../src/opts/SkMorphology_opts_arm.cpp',
             '../src/opts/SkUtils_opts_arm.cpp',
             '../src/opts/SkXfermode_opts_arm.cpp',
@@ -108,6 +111,7 @@
             '../src/opts/SkBlitMask_opts_none.cpp',
             '../src/opts/SkBlitRow_opts_none.cpp',
             '../src/opts/SkBlurImage_opts_none.cpp',
+            '../src/opts/SkBlurMask_opts_none.cpp',
             '../src/opts/SkMorphology_opts_none.cpp',
             '../src/opts/SkUtils_opts_none.cpp',
             '../src/opts/SkXfermode_opts_none.cpp',
@@ -132,6 +136,8 @@
             '../src/opts/SkBlitRow_opts_arm_neon.cpp',
             '../src/opts/SkBlurImage_opts_arm.cpp',
             '../src/opts/SkBlurImage_opts_neon.cpp',
+            '../src/opts/SkBlurMask_opts_arm.cpp',
+            '../src/opts/SkBlurMask_opts_neon.cpp',
             '../src/opts/SkMorphology_opts_arm.cpp',
             '../src/opts/SkMorphology_opts_neon.cpp',
             '../src/opts/SkUtils_opts_none.cpp',
@@ -172,6 +178,50 @@
         }],
       ],
     },
+    # Likewise for AVX2.  These are only ever called after checking CPUID at runtime.  Keep these
+    # files to intrinsics and static helpers; see the note in SkBlitRow_opts_AVX2.cpp.
+    {
+      'target_name': 'opts_avx2',
+      'product_name': 'skia_opts_avx2',
+      'type': 'static_library',
+      'standalone_static_library': 1,
+      'dependencies': [
+        'core.gyp:*',
+        'effects.gyp:*'
+      ],
+      'include_dirs': [
+        '../src/core',
+        '../src/opts',
+      ],
+      'conditions': [
+        [ 'skia_os in ["linux", "freebsd", "openbsd", "solaris", "nacl", "chromeos", "android"] \
+           and not skia_android_framework', {
+          'cflags': [
+            '-mavx2',
+          ],
+        }],
+        [ 'skia_os == "mac"', {
+          'xcode_settings': {
+            'OTHER_CPLUSPLUSFLAGS': [ '-mavx2' ],
+          },
+        }],
+        [ 'skia_os == "win"', {
+          'msvs_settings': {
+            'VCCLCompilerTool': {
+              'AdditionalOptions': [ '/arch:AVX2' ],
+            },
+          },
+        }],
+        [ 'skia_arch_type == "x86" and skia_os != "ios"', {
+          'sources': [
+            '../src/opts/SkBitmapFilter_opts_AVX2.cpp',
+            '../src/opts/SkBitmapProcState_opts_AVX2.cpp',
+            '../src/opts/SkBlitRow_opts_AVX2.cpp',
+            '../src/opts/SkXfermode_opts_AVX2.cpp',
+          ],
+        }],
+      ],
+    },
     # NEON code must be compiled with -mfpu=neon which also affects scalar
     # code. To support dynamic NEON code paths, we need to build all
     # NEON-specific sources in a separate static library. The situation
@@ -216,6 +266,7 @@
         '../src/opts/SkBlitMask_opts_arm_neon.cpp',
         '../src/opts/SkBlitRow_opts_arm_neon.cpp',
         '../src/opts/SkBlurImage_opts_neon.cpp',
+        '../src/opts/SkBlurMask_opts_neon.cpp',
         '../src/opts/SkMorphology_opts_neon.cpp',
         '../src/opts/SkXfermode_opts_arm_neon.cpp',
       ],
@@ -11,6 +11,8 @@
 
 #include "SkDevice.h"
 
+class SkTaskScheduler;
+
 ///////////////////////////////////////////////////////////////////////////////
 class SK_API SkBitmapDevice : public SkBaseDevice {
 public:
@@ -58,6 +60,14 @@ public:
      */
     virtual GrRenderTarget* accessRenderTarget() SK_OVERRIDE { return NULL; }
 
+    /**
+     *  Distance field text drawn to this device, and to the layers it makes,
+     *  generates the glyphs it's missing on the scheduler's threads.  NULL, the
+     *  default, generates them on the drawing thread.  The scheduler is not
+     *  owned, and must outlive the device.
+     */
+    void setTaskScheduler(SkTaskScheduler* scheduler) { fTaskScheduler = scheduler; }
+
 protected:
     /**
      *  Device may filter the text flags for drawing text here. If it wants to
@@ -219,6 +229,7 @@ private:
     virtual const void* peekPixels(SkImageInfo*, size_t* rowBytes) SK_OVERRIDE;
 
     SkBitmap    fBitmap;
+    SkTaskScheduler* fTaskScheduler;
 
     typedef SkBaseDevice INHERITED;
 };
@@ -80,6 +80,19 @@ public:
             SkPicture::EncodeBitmap encoder = NULL,
             SkScalar rasterDpi = SK_ScalarDefaultRasterDPI);
 
+    /**
+     *  Like CreatePDF, but each page's content and the resources it introduces
+     *  are written to the stream soon after endPage(), instead of all being
+     *  kept until close(), so long documents don't need memory for all their
+     *  pages at once.  Fonts, which are subset by their use in the whole
+     *  document, are still written by close().  An aborted document will have
+     *  left partial output in the stream.
+     */
+    static SkDocument* CreateStreamingPDF(
+            SkWStream*, void (*Done)(SkWStream*,bool aborted) = NULL,
+            SkPicture::EncodeBitmap encoder = NULL,
+            SkScalar rasterDpi = SK_ScalarDefaultRasterDPI);
+
     /**
      *  Begin a new page for the document, returning the canvas that will draw
      *  into the page. The document owns this canvas, and it will go out of
@@ -21,6 +21,7 @@ class SkMatrix;
 class SkPath;
 class SkRegion;
 class SkRasterClip;
+class SkTaskScheduler;
 struct SkDrawProcs;
 struct SkRect;
 class SkRRect;
@@ -113,6 +114,18 @@ public:
                                     const SkScalar pos[], SkScalar constY,
                                     int scalarsPerPosition, const SkPaint&) const;
 
+    /**
+     *  Returns true if the paint asks for distance field text, and the glyphs can be drawn by
+     *  scaling distance fields to the device: the text is filled, with no rasterizer or mask
+     *  filter, and the matrix only scales (positively) and translates.
+     */
+    static bool ShouldDrawTextAsDistanceFields(const SkPaint&, const SkMatrix&);
+    void        drawText_asDistanceFields(const char text[], size_t byteLength,
+                                          SkScalar x, SkScalar y, const SkPaint&) const;
+    void        drawPosText_asDistanceFields(const char text[], size_t byteLength,
+                                             const SkScalar pos[], SkScalar constY,
+                                             int scalarsPerPosition, const SkPaint&) const;
+
 private:
     void    drawDevMask(const SkMask& mask, const SkPaint&) const;
     void    drawBitmapAsMask(const SkBitmap&, const SkPaint&) const;
@@ -140,6 +153,8 @@ public:
     const SkClipStack* fClipStack;  // optional
     SkBaseDevice*   fDevice;        // optional
     SkDrawProcs*    fProcs;         // optional
+    // optional: distance field text makes its glyphs' fields on these threads
+    SkTaskScheduler* fTaskScheduler;
 
 #ifdef SK_DEBUG
     void validate() const;
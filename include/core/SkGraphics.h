@@ -79,10 +79,44 @@ public:
      */
     static void PurgeFontCache();
 
+    /**
+     *  Rasterized glyph images can be shared by several processes through a
+     *  block of memory they all map, so a glyph scaled by one of them is not
+     *  scaled again by the others.
+     *
+     *  InitSharedGlyphImageCache() lays out an empty cache in memory, which
+     *  must be 4-byte aligned, and returns false if bytes is too small. Call it
+     *  once, before any process uses the memory. SetSharedGlyphImageCache()
+     *  makes this process look there before rasterizing a glyph, and add what
+     *  it rasterizes. Pass NULL to stop. When the cache fills up it is emptied.
+     */
+    static bool InitSharedGlyphImageCache(void* memory, size_t bytes);
+    static void SetSharedGlyphImageCache(void* memory);
+
+    /**
+     *  SkPaint::measureText(), getTextWidths() and breakText() can keep the
+     *  advances of the text they measure, keyed by the text and the paint's
+     *  font settings, so measuring the same text again with the same paint
+     *  need not look up each of its glyphs. This is off (a limit of 0) by
+     *  default. SetTextMeasureCacheLimit() turns it on, and returns the
+     *  previous limit; when the cache needs more than bytes, the least
+     *  recently measured text is dropped. PurgeFontCache() empties it.
+     */
+    static size_t GetTextMeasureCacheLimit();
+    static size_t SetTextMeasureCacheLimit(size_t bytes);
+    static size_t GetTextMeasureCacheBytesUsed();
+
     static size_t GetImageCacheBytesUsed();
     static size_t GetImageCacheByteLimit();
     static size_t SetImageCacheByteLimit(size_t newLimit);
 
+    /**
+     *  Return how many image cache lookups have hit and missed, and how many
+     *  entries have been purged to stay within the limit, since startup.
+     *  Useful for tuning SetImageCacheByteLimit().  Any pointer may be NULL.
+     */
+    static void GetImageCacheStats(uint64_t* hits, uint64_t* misses, uint64_t* evictions);
+
     /**
      *  Applications with command line options may pass optional state, such
      *  as cache sizes, here, for instance:
@@ -219,6 +219,18 @@ public:
      */
     void resetSampleSize() { this->setSampleSize(1); }
 
+    /** Ask the decoder for a bitmap of exactly width x height, area-averaged
+        from the image as its rows are decoded, so the full size image is never
+        held in memory.  When set, this takes the place of the sample size.
+        It is a hint: only the JPEG and PNG decoders support it, and only when
+        decoding to premultiplied kARGB_8888_Config with a size no larger than
+        the image's.  Otherwise the image is decoded as if it were not set.
+        Pass 0 for both to go back to using the sample size.
+    */
+    void setTargetSize(int width, int height);
+    int getTargetWidth() const { return fTargetWidth; }
+    int getTargetHeight() const { return fTargetHeight; }
+
     /** Decoding is synchronous, but for long decodes, a different thread can
         call this method safely. This sets a state that the decoders will
         periodically check, and if they see it changed to cancel, they will
@@ -440,6 +452,11 @@ protected:
     // once choice available in the image file.
     bool chooseFromOneChoice(SkBitmap::Config config, int width, int height) const;
 
+    /** Returns true if a decode of a width x height image into config should
+        area-average it down to the size set with setTargetSize().
+     */
+    bool shouldDownsampleToTarget(int width, int height, SkBitmap::Config config) const;
+
     /*  Helper for subclasses. Call this to allocate the pixel memory given the bitmap's
         width/height/rowbytes/config. Returns true on success. This method handles checking
         for an optional Allocator.
@@ -472,6 +489,8 @@ private:
     Chooser*                fChooser;
     SkBitmap::Allocator*    fAllocator;
     int                     fSampleSize;
+    int                     fTargetWidth;
+    int                     fTargetHeight;
     SkBitmap::Config        fDefaultPref;   // use if fUsePrefTable is false
     PrefConfigTable         fPrefTable;     // use if fUsePrefTable is true
     bool                    fDitherImage;
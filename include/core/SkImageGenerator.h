@@ -94,8 +94,10 @@ public:
      *         to the info returned by getInfo().
      *
      *         This contract also allows the caller to specify
-     *         different output-configs, which the implementation can
-     *         decide to support or not.
+     *         different output-configs or a smaller size, which the
+     *         implementation can decide to support or not.
+     *         SkDecodingImageGenerator supports smaller kN32_SkColorType
+     *         sizes for JPEG and PNG, decoding straight to that size.
      *
      *  If info is kIndex8_SkColorType, then the caller must provide storage for up to 256
      *  SkPMColor values in ctable. On success the generator must copy N colors into that storage,
@@ -36,6 +36,8 @@ class SkPathEffect;
 struct SkPoint;
 class SkRasterizer;
 class SkShader;
+class SkTaskScheduler;
+class SkTextAdvances;
 class SkTypeface;
 
 typedef const SkGlyph& (*SkDrawCacheProc)(SkGlyphCache*, const char**,
@@ -833,6 +835,17 @@ public:
      */
     bool containsText(const void* text, size_t byteLength) const;
 
+    /** Generate, ahead of drawing, the glyphs for the specified text as it
+        would be drawn with this paint through matrix (or the identity if
+        matrix is NULL), so that drawing it finds them cached. This looks at
+        the current TextEncoding field of the paint. Images are generated, or
+        paths for text too big to draw from images. If scheduler is not NULL,
+        the glyphs are generated on its threads, several at once; otherwise
+        they are generated on the calling thread.
+    */
+    void prewarmText(const void* text, size_t byteLength, const SkMatrix* matrix,
+                     SkTaskScheduler* scheduler) const;
+
     /** Convert the glyph array into Unichars. Unconvertable glyphs are mapped
         to zero. Note: this does not look at the text-encoding setting in the
         paint, only at the typeface.
@@ -1081,6 +1094,10 @@ private:
     SkScalar measure_text(SkGlyphCache*, const char* text, size_t length,
                           int* count, SkRect* bounds) const;
 
+    // Returns the advances of text from the text measure cache, ref'd, measuring and adding them
+    // first if they aren't there, or NULL if the cache is off or the text too long for it.
+    SkTextAdvances* refCachedAdvances(const void* text, size_t length) const;
+
     SkGlyphCache* detachCache(const SkDeviceProperties* deviceProperties, const SkMatrix*) const;
 
     void descriptorProc(const SkDeviceProperties* deviceProperties, const SkMatrix* deviceMatrix,
@@ -302,6 +302,12 @@ public:
     */
     void incReserve(unsigned extraPtCount);
 
+    /** Hint to the path to prepare for adding extraVerbCount more verbs and
+        extraPtCount more points, so that adding them grows its storage at
+        most once.
+    */
+    void incReserve(int extraVerbCount, int extraPtCount);
+
     /** Set the beginning of the next contour to the point (x,y).
 
         @param x    The x-coordinate of the start of a new contour
@@ -699,6 +705,9 @@ public:
      *      if (close) {
      *          this->close();
      *      }
+     *
+     *  To add many contours at once, or contours of quads or cubics, see
+     *  addPolys().
      */
     void addPoly(const SkPoint pts[], int count, bool close);
 
@@ -825,6 +834,25 @@ public:
         kDone_Verb,     //!< iter.next returns 0 points
     };
 
+    /**
+     *  Add contourCount new contours, each made of just one verb: kLine_Verb,
+     *  kQuad_Verb or kCubic_Verb. The first counts[0] points of pts make the
+     *  first contour, the next counts[1] the second, and so on. This is a fast
+     *  version of the following for each contour, which grows the path's
+     *  storage just once:
+     *      this->moveTo(pts[0]);
+     *      for (int i = 1; i + 1 < count; i += 2) {    // for kQuad_Verb
+     *          this->quadTo(pts[i], pts[i + 1]);
+     *      }
+     *      if (close) {
+     *          this->close();
+     *      }
+     *  Points left over after a contour's last whole segment are ignored, and
+     *  contours with no points are skipped.
+     */
+    void addPolys(Verb verb, const SkPoint pts[], const int counts[], int contourCount,
+                  bool close);
+
     /** Iterate through all of the segments (lines, quadratics, cubics) of
         each contours in a path.
 
@@ -13,6 +13,7 @@
 #include "SkAdvancedTypefaceMetrics.h"
 #include "SkWeakRefCnt.h"
 
+class SkCmapCache;
 class SkDescriptor;
 class SkFontDescriptor;
 class SkScalerContext;
@@ -342,12 +343,18 @@ private:
     static SkTypeface* CreateDefault(int style);  // SkLazyPtr requires an int, not a Style.
     static void        DeleteDefault(SkTypeface*);
 
+    SkCmapCache* getCmapCache() const;
+
     SkFontID    fUniqueID;
     Style       fStyle;
     bool        fIsFixedPitch;
 
+    // Built on first use by getCmapCache().
+    mutable SkCmapCache* fCmapCache;
+
     friend class SkPaint;
-    friend class SkGlyphCache;  // GetDefaultTypeface
+    friend class SkCmapCache;   // onCharsToGlyphs
+    friend class SkGlyphCache;  // GetDefaultTypeface, getCmapCache
     // just so deprecated fonthost can call protected methods
     friend class SkFontHost;
 
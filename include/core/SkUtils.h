@@ -39,6 +39,15 @@ void sk_memcpy32(uint32_t dst[], const uint32_t src[], int count);
 typedef void (*SkMemcpy32Proc)(uint32_t dst[], const uint32_t src[], int count);
 SkMemcpy32Proc SkMemcpy32GetPlatformProc();
 
+/** Caps the SIMD level (e.g. SK_CPU_SSE_LEVEL_SSE2) the platform proc factories may choose from
+    when called on this thread, regardless of what the CPU supports.  Other threads are unaffected,
+    as are procs already chosen and cached.  This is mainly for benchmarking and testing one
+    instruction set against another on the same machine.  Pass SK_MaxS32 to remove the cap.
+    Returns this thread's previous cap.
+*/
+int SkSetSIMDLevelCap(int level);
+int SkGetSIMDLevelCap();
+
 ///////////////////////////////////////////////////////////////////////////////
 
 #define kMaxBytesInUTF8Sequence     4
@@ -66,6 +75,13 @@ SkUnichar   SkUTF8_PrevUnichar(const char**);
 */
 size_t      SkUTF8_FromUnichar(SkUnichar uni, char utf8[] = NULL);
 
+/** Return how many of the first count bytes of utf8 are ASCII (less than
+    0x80), i.e. how many unichars may be read from it a byte at a time.
+*/
+int SkUTF8_CountLeadingASCII(const char utf8[], int count);
+typedef int (*SkUTF8_CountLeadingASCIIProc)(const char utf8[], int count);
+SkUTF8_CountLeadingASCIIProc SkUTF8_CountLeadingASCIIGetPlatformProc();
+
 ///////////////////////////////////////////////////////////////////////////////
 
 #define SkUTF16_IsHighSurrogate(c)  (((c) & 0xFC00) == 0xD800)
@@ -79,6 +95,13 @@ SkUnichar SkUTF16_NextUnichar(const uint16_t**);
 SkUnichar SkUTF16_PrevUnichar(const uint16_t**);
 size_t SkUTF16_FromUnichar(SkUnichar uni, uint16_t utf16[] = NULL);
 
+/** Return how many of the first count values of utf16 are not surrogates,
+    i.e. how many unichars may be read from it a value at a time.
+*/
+int SkUTF16_CountLeadingNonSurrogates(const uint16_t utf16[], int count);
+typedef int (*SkUTF16_CountLeadingNonSurrogatesProc)(const uint16_t utf16[], int count);
+SkUTF16_CountLeadingNonSurrogatesProc SkUTF16_CountLeadingNonSurrogatesGetPlatformProc();
+
 size_t SkUTF16_ToUTF8(const uint16_t utf16[], int numberOf16BitValues,
                       char utf8[] = NULL);
 
@@ -10,6 +10,7 @@
 #ifndef SkWriter32_DEFINED
 #define SkWriter32_DEFINED
 
+#include "SkChunkAlloc.h"
 #include "SkData.h"
 #include "SkMatrix.h"
 #include "SkPath.h"
@@ -19,6 +20,7 @@
 #include "SkRegion.h"
 #include "SkScalar.h"
 #include "SkStream.h"
+#include "SkTDArray.h"
 #include "SkTemplates.h"
 #include "SkTypes.h"
 
@@ -31,7 +33,9 @@ public:
      *  first time an allocation doesn't fit.  From then it will use dynamically allocated storage.
      *  This used to be optional behavior, but pipe now relies on it.
      */
-    SkWriter32(void* external = NULL, size_t externalBytes = 0) {
+    SkWriter32(void* external = NULL, size_t externalBytes = 0)
+        : fSegmentBytes(0)
+        , fArena(NULL) {
         this->reset(external, externalBytes);
     }
 
@@ -49,12 +53,44 @@ public:
         fData = (uint8_t*)external;
         fCapacity = externalBytes;
         fUsed = 0;
+        fSegmentStart = 0;
         fExternal = external;
+        if (fSegmentBytes > 0) {
+            this->resetSegments();
+        }
     }
 
+    /**
+     *  Switch to segmented storage.  Rather than growing one contiguous buffer, the writer then
+     *  allocates blocks of segmentBytes (or larger, for a single record that needs it) from arena,
+     *  and never copies what it has already written.  Each record lies entirely within one
+     *  segment, so readTAt() and overwriteTAt() still work; use getSegments() to get at the data.
+     *
+     *  If arena is NULL the writer makes and owns one.  A caller provided arena must outlive the
+     *  writer, and is never reset by it.  Any external storage passed to reset() becomes the
+     *  first segment.  This must be called before anything is written, and lasts across reset().
+     */
+    void useSegments(size_t segmentBytes, SkChunkAlloc* arena = NULL);
+
+    bool isSegmented() const { return fSegmentBytes > 0; }
+
+    struct Segment {
+        const void* fData;
+        size_t      fSize;
+    };
+
+    /**
+     *  Fills segments with the written data as a scatter/gather list: the bytes written are the
+     *  concatenation of these, in order.  When not segmented there is at most one.
+     *  The pointers are invalidated by the next write call.
+     */
+    void getSegments(SkTDArray<Segment>* segments) const;
+
     // Returns the current buffer.
     // The pointer may be invalidated by any future write calls.
+    // Not available in segmented mode, unless everything fits in the first segment.
     const uint32_t* contiguousArray() const {
+        SkASSERT(0 == fSegmentStart);
         return (uint32_t*)fData;
     }
 
@@ -67,7 +103,7 @@ public:
             this->growToAtLeast(totalRequired);
         }
         fUsed = totalRequired;
-        return (uint32_t*)(fData + offset);
+        return (uint32_t*)(fData + (offset - fSegmentStart));
     }
 
     /**
@@ -78,7 +114,7 @@ public:
     const T& readTAt(size_t offset) const {
         SkASSERT(SkAlign4(offset) == offset);
         SkASSERT(offset < fUsed);
-        return *(T*)(fData + offset);
+        return *(const T*)this->addressAt(offset);
     }
 
     /**
@@ -90,7 +126,7 @@ public:
         SkASSERT(SkAlign4(offset) == offset);
         SkASSERT(offset < fUsed);
         SkASSERT(fSnapshot.get() == NULL);
-        *(T*)(fData + offset) = value;
+        *(T*)this->addressAt(offset) = value;
     }
 
     bool writeBool(bool value) {
@@ -215,17 +251,22 @@ public:
     void rewindToOffset(size_t offset) {
         SkASSERT(SkAlign4(offset) == offset);
         SkASSERT(offset <= bytesWritten());
+        if (offset < fSegmentStart) {
+            this->rewindSegmentsTo(offset);
+        }
         fUsed = offset;
     }
 
     // copy into a single buffer (allocated by caller). Must be at least size()
     void flatten(void* dst) const {
-        memcpy(dst, fData, fUsed);
+        if (0 == fSegmentStart) {
+            memcpy(dst, fData, fUsed);
+        } else {
+            this->flattenSegments(dst);
+        }
     }
 
-    bool writeToStream(SkWStream* stream) const {
-        return stream->write(fData, fUsed);
-    }
+    bool writeToStream(SkWStream* stream) const;
 
     // read from the stream, and write up to length bytes. Return the actual
     // number of bytes written.
@@ -248,12 +289,39 @@ public:
 private:
     void growToAtLeast(size_t size);
 
-    uint8_t* fData;                    // Points to either fInternal or fExternal.
-    size_t fCapacity;                  // Number of bytes we can write to fData.
+    // Segmented mode helpers.
+    struct SegmentRec {
+        uint8_t* fData;
+        size_t   fStart;                // Offset of fData[0] in the written data.
+        size_t   fCapacity;
+    };
+    void resetSegments();
+    void newSegment(size_t minBytes);
+    int findSegment(size_t offset) const;
+    void rewindSegmentsTo(size_t offset);
+    void flattenSegments(void* dst) const;
+
+    uint8_t* addressAt(size_t offset) const {
+        if (offset >= fSegmentStart) {
+            return fData + (offset - fSegmentStart);
+        }
+        const SegmentRec& rec = fSegments[this->findSegment(offset)];
+        return rec.fData + (offset - rec.fStart);
+    }
+
+    uint8_t* fData;                    // Points to either fInternal or fExternal, or the
+                                       // current segment.
+    size_t fCapacity;                  // Offset at which fData is full.
     size_t fUsed;                      // Number of bytes written.
+    size_t fSegmentStart;              // Offset of fData[0], 0 unless segmented.
     void* fExternal;                   // Unmanaged memory block.
     SkAutoTMalloc<uint8_t> fInternal;  // Managed memory block.
     SkAutoTUnref<SkData> fSnapshot;    // Holds the result of last asData.
+
+    size_t fSegmentBytes;              // 0 unless segmented.
+    SkChunkAlloc* fArena;              // Where segments come from.
+    SkAutoTDelete<SkChunkAlloc> fOwnedArena;
+    SkTDArray<SegmentRec> fSegments;   // All segments, the last one being fData.
 };
 
 /**
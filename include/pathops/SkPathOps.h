@@ -7,9 +7,10 @@
 #ifndef SkPathOps_DEFINED
 #define SkPathOps_DEFINED
 
-#include "SkPreConfig.h"
+#include "SkTypes.h"
 
 class SkPath;
+class SkTaskScheduler;
 
 // FIXME: move everything below into the SkPath class
 /**
@@ -54,4 +55,25 @@ bool SK_API Op(const SkPath& one, const SkPath& two, SkPathOp op, SkPath* result
   */
 bool SK_API Simplify(const SkPath& path, SkPath* result);
 
+/** Set result to the union of count paths, with non-overlapping contours.
+    The paths are unioned in pairs, then the results of those in pairs, and
+    so on, so that each step combines paths of about the same size. If
+    scheduler is not NULL, the unions of each round run in parallel on its
+    threads.
+
+    Returns true if operation was able to produce a result;
+    otherwise, result is unmodified.
+
+    @param paths The paths to union.
+    @param count The number of paths. The union of none is empty, and the
+                 union of one is that path simplified.
+    @param result The union of the paths. The result may not be one of the
+                  inputs.
+    @param scheduler The threads to run each round on, or NULL, the default,
+                     to run them on the calling thread. It is not owned.
+    @return True if all the unions succeeded.
+  */
+bool SK_API Union(const SkPath paths[], int count, SkPath* result,
+                  SkTaskScheduler* scheduler = NULL);
+
 #endif
@@ -29,6 +29,7 @@ class SkPDFFont;
 class SkPDFFormXObject;
 class SkPDFGlyphSetMap;
 class SkPDFGraphicState;
+class SkPDFImage;
 class SkPDFObject;
 class SkPDFResourceDict;
 class SkPDFShader;
@@ -192,6 +193,13 @@ public:
         return *(fFontGlyphUsage.get());
     }
 
+    /** Returns the images that show on this device, which a document may
+     *  share with other pages that show the same pixels.
+     */
+    const SkTDArray<SkPDFImage*>& getImages() const {
+        return fImages;
+    }
+
 
     /**
      *  rasterDpi - the DPI at which features without native PDF support
@@ -245,6 +253,10 @@ private:
     // Glyph ids used for each font on this device.
     SkAutoTDelete<SkPDFGlyphSetMap> fFontGlyphUsage;
 
+    // Images made for this device and the devices drawn into it, so drawing
+    // the same pixels again reuses them.
+    SkTDArray<SkPDFImage*> fImages;
+
     SkPicture::EncodeBitmap fEncoder;
     SkScalar fRasterDpi;
 
@@ -255,7 +267,7 @@ private:
     virtual SkBaseDevice* onCreateDevice(const SkImageInfo&, Usage) SK_OVERRIDE;
 
     void init();
-    void cleanUp(bool clearFontUsage);
+    void cleanUp(bool clearUsage);
     SkPDFFormXObject* createFormXObjectFromDevice();
 
     void drawFormXObjectWithMask(int xObjectIndex,
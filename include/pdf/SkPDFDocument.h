@@ -20,6 +20,8 @@ class SkPDFDevice;
 class SkPDFDict;
 class SkPDFPage;
 class SkPDFObject;
+class SkTaskGroup;
+class SkTaskScheduler;
 class SkWStream;
 template <typename T> class SkTSet;
 
@@ -41,12 +43,32 @@ public:
     /** Create a PDF document.
      */
     explicit SK_API SkPDFDocument(Flags flags = (Flags)0);
+
+    /** Create a PDF document that streams to the passed stream.  Each page's
+     *  content and any resources it introduces are written out soon after the
+     *  page is appended, rather than all at once by emitPDF().  Fonts, which
+     *  are subset by their usage across the whole document, the page tree and
+     *  the cross reference table are still written by emitPDF(), which must be
+     *  passed the same stream.  setPage() is not supported.
+     *
+     *  @param stream    The writable output stream to send the PDF to.  It is
+     *                   not owned, and must outlive the document.
+     *  @param scheduler If not NULL, page content is compressed on the
+     *                   scheduler's threads, letting the caller draw the next
+     *                   pages meanwhile.  Otherwise each page is compressed on
+     *                   the calling thread as it's appended.  It is not owned,
+     *                   and must outlive the document.
+     */
+    SK_API SkPDFDocument(SkWStream* stream, Flags flags = (Flags)0,
+                         SkTaskScheduler* scheduler = NULL);
+
     SK_API ~SkPDFDocument();
 
     /** Output the PDF to the passed stream.  It is an error to call this (it
      *  will return false and not modify stream) if no pages have been added
      *  or there are pages missing (i.e. page 1 and 3 have been added, but not
-     *  page 2).
+     *  page 2).  A streaming document must be passed the stream it was
+     *  created with, and can only be emitted once.
      *
      *  @param stream    The writable output stream to send the PDF to.
      */
@@ -86,6 +108,16 @@ private:
 
     SkPDFDict* fTrailerDict;
 
+    // Only used when streaming.  fStream is NULL otherwise.
+    SkWStream* fStream;
+    size_t fStreamStart;
+    SkPDFDict* fDests;
+    SkTSet<SkPDFObject*>* fUnwrittenFonts;      // Refs held by fOtherPageResources.
+    SkTDArray<SkPDFObject*> fUnwrittenResources;  // Likewise.
+    SkTDArray<SkPDFPage*> fUnwrittenPages;        // Refs held by fPages.
+    SkAutoTDelete<SkTaskGroup> fCompressions;
+    int fMaxUnwrittenPages;
+
     /** Output the PDF header to the passed stream.
      *  @param stream    The writable output stream to send the header to.
      */
@@ -100,6 +132,24 @@ private:
      *  @param objCount  The number of objects in the PDF.
      */
     void emitFooter(SkWStream* stream, int64_t objCount);
+
+    /** When streaming, the byte offset of the end of fStream in the PDF.
+     */
+    size_t streamOffset() const;
+
+    /** When streaming, write the objects in fUnwrittenPages and
+     *  fUnwrittenResources, once the pages' content has been compressed.
+     */
+    void writePages();
+
+    /** When streaming, write obj, noting its offset in the catalog.
+     */
+    void writeObject(SkPDFObject* obj);
+
+    /** emitPDF() for a streaming document: write what's left once all the
+     *  pages are known.
+     */
+    bool emitStreamedPDF();
 };
 
 #endif
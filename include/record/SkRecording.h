@@ -14,6 +14,9 @@
 #include "SkTypes.h"      // SkNoncopyable
 
 // These are intentionally left opaque.
+class SkBBHFactory;
+class SkBBoxHierarchy;
+class SkData;
 class SkRecord;
 class SkRecorder;
 
@@ -33,6 +36,11 @@ namespace EXPERIMENTAL {
  *  playback->draw(&someCanvas);
  *  playback->draw(&someOtherCanvas);
  *
+ *  If you pass an SkBBHFactory when creating the SkRecording, the SkPlayback will carry a bounding
+ *  box hierarchy over its commands, and draw() will only play back commands that might affect
+ *  pixels inside the target canvas's clip.  This is a win when playing back one recording tile by
+ *  tile.
+ *
  *  SkPlayback is thread safe; SkRecording is not.
  */
 
@@ -44,17 +52,31 @@ public:
     // Draw recorded commands into a canvas.
     void draw(SkCanvas*) const;
 
+    // Draw recorded commands into a raster bitmap, splitting it into tileWidth x tileHeight tiles
+    // played back in parallel on threadCount threads (one per core if negative).  All threads
+    // share this SkPlayback; nothing is copied.  Works best if the SkRecording had an SkBBHFactory.
+    void drawTiled(const SkBitmap& dst, int tileWidth, int tileHeight, int threadCount = -1) const;
+
+    // Serialize recorded commands, e.g. to send to another process.  The bounding box hierarchy,
+    // if any, is not included.  Returns a new ref.
+    SkData* serialize() const;
+
+    // Load an SkPlayback from data written by serialize().  Returns NULL if data is malformed.
+    static SkPlayback* Deserialize(const void* data, size_t length);
+
 private:
-    explicit SkPlayback(const SkRecord*);
+    SkPlayback(const SkRecord*, SkBBoxHierarchy*);
 
     SkAutoTDelete<const SkRecord> fRecord;
+    SkAutoTUnref<SkBBoxHierarchy> fBBH;  // May be NULL.
 
     friend class SkRecording;
 };
 
 class SK_API SkRecording : SkNoncopyable {
 public:
-    SkRecording(int width, int height);
+    // If bbhFactory is non-NULL, it's used to build a bounding box hierarchy for the SkPlayback.
+    SkRecording(int width, int height, SkBBHFactory* bbhFactory = NULL);
     ~SkRecording();
 
     // Draws issued to this canvas will be replayed by SkPlayback::draw().
@@ -68,6 +90,7 @@ public:
 private:
     SkAutoTDelete<SkRecord> fRecord;
     SkAutoTUnref<SkRecorder> fRecorder;
+    SkAutoTUnref<SkBBoxHierarchy> fBBH;  // May be NULL.
 };
 
 }  // namespace EXPERIMENTAL
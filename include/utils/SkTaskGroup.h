@@ -0,0 +1,108 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkTaskGroup_DEFINED
+#define SkTaskGroup_DEFINED
+
+#include "SkCondVar.h"
+#include "SkRunnable.h"
+#include "SkTDArray.h"
+#include "SkTypes.h"
+
+class SkThread;
+
+/**
+ * A pool of threads that run SkRunnables added through SkTaskGroups.
+ *
+ * Unlike SkThreadPool, there is no single shared queue: each thread keeps its own deque of work.
+ * A thread adds work spawned while running a task to the back of its own deque and takes work from
+ * there too, so related work tends to stay on one thread.  Idle threads steal work from the front
+ * of other threads' deques.  Work added from threads outside the scheduler goes to a separate deque
+ * that any scheduler thread may steal from.
+ */
+class SkTaskScheduler : SkNoncopyable {
+public:
+    /**
+     * Create a scheduler with count threads, or one thread per core if kThreadPerCore.
+     * With 0 threads, SkTaskGroups using this scheduler run their work synchronously.
+     */
+    static const int kThreadPerCore = -1;
+    explicit SkTaskScheduler(int count);
+
+    /**
+     * Blocks until all work added to this scheduler has run, then stops its threads.
+     */
+    ~SkTaskScheduler();
+
+    int threadCount() const { return fThreads.count(); }
+
+private:
+    struct Work;
+    struct Deque;
+
+    // Queue r to run, decrementing *pending after it's run.  The caller has already incremented it.
+    void add(SkRunnable* r, int32_t* pending);
+
+    // Run work (any work) on this thread until *pending drops to zero.
+    void wait(int32_t* pending);
+
+    // Returns the index of the calling thread's deque, or the index of the deque for threads
+    // outside this scheduler.
+    int currentDeque() const;
+
+    // Try to pop work from deque self, or steal it from any other deque.  Returns true if we ran it.
+    bool tryRunOne(int self);
+
+    // Sleep until there might be work to run.  Threads waiting on a group pass its pending count
+    // and will also wake when it drops to zero; our own threads pass NULL and wake to stop.
+    // Returns true if our own thread should stop.
+    bool sleep(const int32_t* pending);
+
+    static void Loop(void*);  // Static because we pass in a Deque, which points back to us.
+
+    SkTDArray<SkThread*> fThreads;
+    Deque*               fDeques;   // fThreads.count() + 1 of them; the last is for outsiders.
+    SkCondVar            fReady;    // Idle threads wait on this for work or for a group to finish.
+    int32_t              fQueued;   // Atomic.  Work added to a deque but not yet claimed.
+    int32_t              fSleepers; // Atomic.  How many threads are (about to be) waiting on fReady.
+    bool                 fStopping; // Protected by fReady.
+
+    friend class SkTaskGroup;
+};
+
+/**
+ * A set of SkRunnables that can be waited on together, independently of any other work running on
+ * the same SkTaskScheduler.  Tasks may add more work to any SkTaskGroup, including their own,
+ * and may wait() on groups themselves; a thread waiting on a group runs other work meanwhile.
+ */
+class SkTaskGroup : SkNoncopyable {
+public:
+    /**
+     * Work will run on scheduler's threads.  If scheduler is NULL, add() runs work synchronously.
+     * The scheduler must outlive this SkTaskGroup.
+     */
+    explicit SkTaskGroup(SkTaskScheduler* scheduler);
+    ~SkTaskGroup() { this->wait(); }
+
+    /**
+     * Queues up an SkRunnable to run when a thread is available.  Does not take ownership.
+     * NULL is a safe no-op.
+     */
+    void add(SkRunnable*);
+
+    /**
+     * Block until all SkRunnables added to this group have completed.  You may keep calling add()
+     * after wait() returns, and wait() again.
+     */
+    void wait();
+
+private:
+    SkTaskScheduler* fScheduler;  // Unowned.  May be NULL.
+    int32_t          fPending;    // Atomic.  Added but not yet completed.
+};
+
+#endif
@@ -57,13 +57,16 @@ static bool valid_for_bitmap_device(const SkImageInfo& info,
     return true;
 }
 
-SkBitmapDevice::SkBitmapDevice(const SkBitmap& bitmap) : fBitmap(bitmap) {
+SkBitmapDevice::SkBitmapDevice(const SkBitmap& bitmap)
+    : fBitmap(bitmap)
+    , fTaskScheduler(NULL) {
     SkASSERT(valid_for_bitmap_device(bitmap.info(), NULL));
 }
 
 SkBitmapDevice::SkBitmapDevice(const SkBitmap& bitmap, const SkDeviceProperties& deviceProperties)
     : SkBaseDevice(deviceProperties)
     , fBitmap(bitmap)
+    , fTaskScheduler(NULL)
 {
     SkASSERT(valid_for_bitmap_device(bitmap.info(), NULL));
 }
@@ -109,7 +112,11 @@ void SkBitmapDevice::replaceBitmapBackendForRasterSurface(const SkBitmap& bm) {
 }
 
 SkBaseDevice* SkBitmapDevice::onCreateDevice(const SkImageInfo& info, Usage usage) {
-    return SkBitmapDevice::Create(info, &this->getDeviceProperties());
+    SkBitmapDevice* device = SkBitmapDevice::Create(info, &this->getDeviceProperties());
+    if (device) {
+        device->fTaskScheduler = fTaskScheduler;
+    }
+    return device;
 }
 
 void SkBitmapDevice::lockPixels() {
@@ -403,12 +410,24 @@ void SkBitmapDevice::drawSprite(const SkDraw& draw, const SkBitmap& bitmap,
 
 void SkBitmapDevice::drawText(const SkDraw& draw, const void* text, size_t len,
                               SkScalar x, SkScalar y, const SkPaint& paint) {
+    if (fTaskScheduler) {
+        SkDraw threaded(draw);
+        threaded.fTaskScheduler = fTaskScheduler;
+        threaded.drawText((const char*)text, len, x, y, paint);
+        return;
+    }
     draw.drawText((const char*)text, len, x, y, paint);
 }
 
 void SkBitmapDevice::drawPosText(const SkDraw& draw, const void* text, size_t len,
                                  const SkScalar xpos[], SkScalar y,
                                  int scalarsPerPos, const SkPaint& paint) {
+    if (fTaskScheduler) {
+        SkDraw threaded(draw);
+        threaded.fTaskScheduler = fTaskScheduler;
+        threaded.drawPosText((const char*)text, len, xpos, y, scalarsPerPos, paint);
+        return;
+    }
     draw.drawPosText((const char*)text, len, xpos, y, scalarsPerPos, paint);
 }
 
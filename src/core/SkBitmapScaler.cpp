@@ -247,7 +247,8 @@ bool SkBitmapScaler::Resize(SkBitmap* resultPtr,
                             ResizeMethod method,
                             float destWidth, float destHeight,
                             const SkConvolutionProcs& convolveProcs,
-                            SkBitmap::Allocator* allocator) {
+                            SkBitmap::Allocator* allocator,
+                            SkTaskScheduler* scheduler) {
 
   SkRect destSubset = { 0, 0, destWidth, destHeight };
 
@@ -308,7 +309,7 @@ bool SkBitmapScaler::Resize(SkBitmap* resultPtr,
         !source.isOpaque(), filter.xFilter(), filter.yFilter(),
         static_cast<int>(result.rowBytes()),
         static_cast<unsigned char*>(result.getPixels()),
-        convolveProcs, true);
+        convolveProcs, true, scheduler);
 
     *resultPtr = result;
     resultPtr->lockPixels();
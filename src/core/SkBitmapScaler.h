@@ -79,12 +79,18 @@ public:
         RESIZE_LAST_ALGORITHM_METHOD = RESIZE_MITCHELL,
     };
 
+    /**
+     *  If scheduler is not NULL, large images are split into bands of rows
+     *  and convolved on the scheduler's threads, as well as the calling
+     *  thread.  NULL, the default, does everything on the calling thread.
+     */
     static bool Resize(SkBitmap* result,
                        const SkBitmap& source,
                        ResizeMethod method,
                        float dest_width, float dest_height,
                        const SkConvolutionProcs&,
-                       SkBitmap::Allocator* allocator = NULL);
+                       SkBitmap::Allocator* allocator = NULL,
+                       SkTaskScheduler* scheduler = NULL);
 };
 
 #endif
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkCmapCache.h"
+
+#include "SkThread.h"
+#include "SkUtils.h"
+
+SkCmapCache::SkCmapCache() {
+    sk_bzero(fPages, sizeof(fPages));
+}
+
+SkCmapCache::~SkCmapCache() {
+    for (int i = 0; i < kPageCount; ++i) {
+        sk_free(fPages[i]);
+    }
+}
+
+const uint16_t* SkCmapCache::getPage(const SkTypeface* typeface, int page) {
+    uint16_t* glyphs = sk_acquire_load(&fPages[page]);
+    if (NULL != glyphs) {
+        return glyphs;
+    }
+
+    SkUnichar chars[kPageSize];
+    for (int i = 0; i < kPageSize; ++i) {
+        chars[i] = (page << kPageBits) | i;
+    }
+    glyphs = (uint16_t*)sk_malloc_throw(kPageSize * sizeof(uint16_t));
+    typeface->onCharsToGlyphs(chars, SkTypeface::kUTF32_Encoding, glyphs, kPageSize);
+
+    // If another thread beat us to it, use theirs; the two are the same.
+    uint16_t* prev = (uint16_t*)sk_atomic_cas((void**)&fPages[page], NULL, glyphs);
+    if (NULL != prev) {
+        sk_free(glyphs);
+        return prev;
+    }
+    return glyphs;
+}
+
+uint16_t SkCmapCache::charToGlyph(const SkTypeface* typeface, SkUnichar uni) {
+    if ((unsigned)uni < 0x10000) {
+        return this->getPage(typeface, uni >> kPageBits)[uni & (kPageSize - 1)];
+    }
+    uint16_t glyph;
+    typeface->onCharsToGlyphs(&uni, SkTypeface::kUTF32_Encoding, &glyph, 1);
+    return glyph;
+}
+
+void SkCmapCache::convert(const SkTypeface* typeface, const void** chars,
+                          SkTypeface::Encoding encoding, uint16_t glyphs[], int count) {
+    int i = 0;
+    switch (encoding) {
+        case SkTypeface::kUTF8_Encoding: {
+            const char* text = static_cast<const char*>(*chars);
+            const uint16_t* ascii = this->getPage(typeface, 0);
+            while (i < count) {
+                // Each of the count - i unichars left takes at least a byte, so we may look
+                // that far ahead.
+                int run = SkUTF8_CountLeadingASCII(text, count - i);
+                for (int j = 0; j < run; ++j) {
+                    glyphs[i + j] = ascii[(uint8_t)text[j]];
+                }
+                text += run;
+                i += run;
+                if (i < count) {
+                    glyphs[i++] = this->charToGlyph(typeface, SkUTF8_NextUnichar(&text));
+                }
+            }
+            *chars = text;
+            break;
+        }
+        case SkTypeface::kUTF16_Encoding: {
+            const uint16_t* text = static_cast<const uint16_t*>(*chars);
+            while (i < count) {
+                int run = SkUTF16_CountLeadingNonSurrogates(text, count - i);
+                for (int j = 0; j < run; ++j) {
+                    const unsigned uni = text[j];
+                    glyphs[i + j] = this->getPage(typeface, uni >> kPageBits)
+                                                 [uni & (kPageSize - 1)];
+                }
+                text += run;
+                i += run;
+                if (i < count) {
+                    glyphs[i++] = this->charToGlyph(typeface, SkUTF16_NextUnichar(&text));
+                }
+            }
+            *chars = text;
+            break;
+        }
+        case SkTypeface::kUTF32_Encoding: {
+            const SkUnichar* text = static_cast<const SkUnichar*>(*chars);
+            for (; i < count; ++i) {
+                glyphs[i] = this->charToGlyph(typeface, text[i]);
+            }
+            *chars = text + count;
+            break;
+        }
+        default:
+            SkDEBUGFAIL("unknown encoding");
+            sk_bzero(glyphs, count * sizeof(glyphs[0]));
+            break;
+    }
+}
+
+int SkCmapCache::charsToGlyphs(const SkTypeface* typeface, const void* chars,
+                               SkTypeface::Encoding encoding, uint16_t glyphs[], int count) {
+    if (NULL != glyphs) {
+        this->convert(typeface, &chars, encoding, glyphs, count);
+        for (int i = 0; i < count; ++i) {
+            if (0 == glyphs[i]) {
+                return i;
+            }
+        }
+        return count;
+    }
+
+    // Convert a bit at a time, so we can stop at the first missing glyph.
+    uint16_t storage[64];
+    for (int done = 0; done < count; done += SK_ARRAY_COUNT(storage)) {
+        int n = SkTMin<int>(count - done, SK_ARRAY_COUNT(storage));
+        this->convert(typeface, &chars, encoding, storage, n);
+        for (int i = 0; i < n; ++i) {
+            if (0 == storage[i]) {
+                return done + i;
+            }
+        }
+    }
+    return count;
+}
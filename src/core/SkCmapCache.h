@@ -0,0 +1,57 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkCmapCache_DEFINED
+#define SkCmapCache_DEFINED
+
+#include "SkTypeface.h"
+
+/**
+ *  A typeface's mapping from unichars to glyph IDs, as a direct-mapped table
+ *  of the Basic Multilingual Plane. The table is split into pages of 256
+ *  unichars, each filled in with one call to the typeface the first time a
+ *  unichar in it is looked up, so most text is converted without calling the
+ *  typeface at all. Unichars beyond the BMP are passed on to the typeface.
+ *
+ *  Pages are never freed or changed once published, so it's safe to use from
+ *  several threads at once.
+ */
+class SkCmapCache : SkNoncopyable {
+public:
+    SkCmapCache();
+    ~SkCmapCache();
+
+    /**
+     *  Like SkTypeface::charsToGlyphs(), for the typeface this cache belongs to.
+     *  Returns the index of the first glyph that is zero, or count if none are.
+     */
+    int charsToGlyphs(const SkTypeface*, const void* chars, SkTypeface::Encoding,
+                      uint16_t glyphs[], int count);
+
+    /** Returns the glyphs for unichars 0-255, indexed by unichar. */
+    const uint16_t* getLatin1Glyphs(const SkTypeface* typeface) {
+        return this->getPage(typeface, 0);
+    }
+
+private:
+    enum {
+        kPageBits   = 8,
+        kPageSize   = 1 << kPageBits,
+        kPageCount  = 0x10000 >> kPageBits
+    };
+
+    const uint16_t* getPage(const SkTypeface*, int page);
+    uint16_t charToGlyph(const SkTypeface*, SkUnichar);
+
+    // Converts count chars, advancing *chars past them.
+    void convert(const SkTypeface*, const void** chars, SkTypeface::Encoding,
+                 uint16_t glyphs[], int count);
+
+    uint16_t* fPages[kPageCount];   // Each NULL until it's built.
+};
+
+#endif
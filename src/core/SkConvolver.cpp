@@ -4,6 +4,7 @@
 
 #include "SkConvolver.h"
 #include "SkSize.h"
+#include "SkTaskGroup.h"
 #include "SkTypes.h"
 
 namespace {
@@ -330,6 +331,161 @@ const SkConvolutionFilter1D::ConvolutionFixed* SkConvolutionFilter1D::GetSingleF
     return &fFilterValues[filter.fDataLocation];
 }
 
+namespace {
+
+    // Everything needed to convolve any range of output rows.  Each range gets its own row
+    // buffer and starts from scratch, so ranges can be convolved independently, on any
+    // thread, with the same results as convolving them all in one go.
+    struct ConvolveJob {
+        const unsigned char* fSourceData;
+        int fSourceByteRowStride;
+        bool fSourceHasAlpha;
+        const SkConvolutionFilter1D* fFilterX;
+        const SkConvolutionFilter1D* fFilterY;
+        int fOutputByteRowStride;
+        unsigned char* fOutput;
+        const SkConvolutionProcs* fConvolveProcs;
+        // See the comment in BGRAConvolve2D.
+        int fAvoidSimdRows;
+        int fLastFilterOffset;
+        int fLastFilterLength;
+
+        // Convolves output rows [startY, stopY).
+        void convolveRows(int startY, int stopY) const;
+    };
+
+    void ConvolveJob::convolveRows(int startY, int stopY) const {
+        const SkConvolutionFilter1D& filterX = *fFilterX;
+        const SkConvolutionFilter1D& filterY = *fFilterY;
+        const SkConvolutionProcs& convolveProcs = *fConvolveProcs;
+        const unsigned char* sourceData = fSourceData;
+        const int sourceByteRowStride = fSourceByteRowStride;
+        const bool sourceHasAlpha = fSourceHasAlpha;
+
+        // The next row in the input that we will generate a horizontally
+        // convolved row for. If the filter doesn't start at the beginning of the
+        // image (this is the case when we are only resizing a subset), then we
+        // don't want to generate any output rows before that. Compute the starting
+        // row for convolution as the first pixel for the first vertical filter.
+        int filterOffset, filterLength;
+        const SkConvolutionFilter1D::ConvolutionFixed* filterValues =
+            filterY.FilterForValue(startY, &filterOffset, &filterLength);
+        int nextXRow = filterOffset;
+
+        // We loop over each row in the input doing a horizontal convolution. This
+        // will result in a horizontally convolved image. We write the results into
+        // a circular buffer of convolved rows and do vertical convolution as rows
+        // are available. This prevents us from having to store the entire
+        // intermediate image and helps cache coherency.
+        // We will need four extra rows to allow horizontal convolution could be done
+        // simultaneously. We also pad each row in row buffer to be aligned-up to
+        // 16 bytes.
+        // TODO(jiesun): We do not use aligned load from row buffer in vertical
+        // convolution pass yet. Somehow Windows does not like it.
+        int rowBufferWidth = (filterX.numValues() + 15) & ~0xF;
+        int rowBufferHeight = filterY.maxFilter() +
+                              (convolveProcs.fConvolve4RowsHorizontally ? 4 : 0);
+        CircularRowBuffer rowBuffer(rowBufferWidth,
+                                    rowBufferHeight,
+                                    filterOffset);
+
+        const int lastFilterOffset = fLastFilterOffset;
+        const int lastFilterLength = fLastFilterLength;
+        const int avoidSimdRows = fAvoidSimdRows;
+
+        // Loop over every output row in our range, processing just enough horizontal
+        // convolutions to run each subsequent vertical convolution.
+        for (int outY = startY; outY < stopY; outY++) {
+            filterValues = filterY.FilterForValue(outY,
+                                                  &filterOffset, &filterLength);
+
+            // Generate output rows until we have enough to run the current filter.
+            while (nextXRow < filterOffset + filterLength) {
+                if (convolveProcs.fConvolve4RowsHorizontally &&
+                    nextXRow + 3 < lastFilterOffset + lastFilterLength -
+                    avoidSimdRows) {
+                    const unsigned char* src[4];
+                    unsigned char* outRow[4];
+                    for (int i = 0; i < 4; ++i) {
+                        src[i] = &sourceData[(nextXRow + i) * sourceByteRowStride];
+                        outRow[i] = rowBuffer.advanceRow();
+                    }
+                    convolveProcs.fConvolve4RowsHorizontally(src, filterX, outRow);
+                    nextXRow += 4;
+                } else {
+                    // Check if we need to avoid SSE2 for this row.
+                    if (convolveProcs.fConvolveHorizontally &&
+                        nextXRow < lastFilterOffset + lastFilterLength -
+                        avoidSimdRows) {
+                        convolveProcs.fConvolveHorizontally(
+                            &sourceData[nextXRow * sourceByteRowStride],
+                            filterX, rowBuffer.advanceRow(), sourceHasAlpha);
+                    } else {
+                        if (sourceHasAlpha) {
+                            ConvolveHorizontally<true>(
+                                &sourceData[nextXRow * sourceByteRowStride],
+                                filterX, rowBuffer.advanceRow());
+                        } else {
+                            ConvolveHorizontally<false>(
+                                &sourceData[nextXRow * sourceByteRowStride],
+                                filterX, rowBuffer.advanceRow());
+                        }
+                    }
+                    nextXRow++;
+                }
+            }
+
+            // Compute where in the output image this row of final data will go.
+            unsigned char* curOutputRow = &fOutput[outY * fOutputByteRowStride];
+
+            // Get the list of rows that the circular buffer has, in order.
+            int firstRowInCircularBuffer;
+            unsigned char* const* rowsToConvolve =
+                rowBuffer.GetRowAddresses(&firstRowInCircularBuffer);
+
+            // Now compute the start of the subset of those rows that the filter
+            // needs.
+            unsigned char* const* firstRowForFilter =
+                &rowsToConvolve[filterOffset - firstRowInCircularBuffer];
+
+            if (convolveProcs.fConvolveVertically) {
+                convolveProcs.fConvolveVertically(filterValues, filterLength,
+                                                   firstRowForFilter,
+                                                   filterX.numValues(), curOutputRow,
+                                                   sourceHasAlpha);
+            } else {
+                ConvolveVertically(filterValues, filterLength,
+                                   firstRowForFilter,
+                                   filterX.numValues(), curOutputRow,
+                                   sourceHasAlpha);
+            }
+        }
+    }
+
+    class ConvolveBand : public SkRunnable {
+    public:
+        void set(const ConvolveJob* job, int startY, int stopY) {
+            fJob = job;
+            fStartY = startY;
+            fStopY = stopY;
+        }
+
+        virtual void run() SK_OVERRIDE {
+            fJob->convolveRows(fStartY, fStopY);
+        }
+
+    private:
+        const ConvolveJob* fJob;
+        int fStartY, fStopY;
+    };
+
+    // Each band has to horizontally convolve the rows its first output row needs all over
+    // again, so we don't bother splitting up small images or making bands too thin.
+    static const int kMinParallelPixels = 256 * 256;
+    static const int kMinRowsPerBand = 16;
+
+}  // namespace
+
 void BGRAConvolve2D(const unsigned char* sourceData,
                     int sourceByteRowStride,
                     bool sourceHasAlpha,
@@ -338,42 +494,21 @@ void BGRAConvolve2D(const unsigned char* sourceData,
                     int outputByteRowStride,
                     unsigned char* output,
                     const SkConvolutionProcs& convolveProcs,
-                    bool useSimdIfPossible) {
-
-    int maxYFilterSize = filterY.maxFilter();
-
-    // The next row in the input that we will generate a horizontally
-    // convolved row for. If the filter doesn't start at the beginning of the
-    // image (this is the case when we are only resizing a subset), then we
-    // don't want to generate any output rows before that. Compute the starting
-    // row for convolution as the first pixel for the first vertical filter.
-    int filterOffset, filterLength;
-    const SkConvolutionFilter1D::ConvolutionFixed* filterValues =
-        filterY.FilterForValue(0, &filterOffset, &filterLength);
-    int nextXRow = filterOffset;
-
-    // We loop over each row in the input doing a horizontal convolution. This
-    // will result in a horizontally convolved image. We write the results into
-    // a circular buffer of convolved rows and do vertical convolution as rows
-    // are available. This prevents us from having to store the entire
-    // intermediate image and helps cache coherency.
-    // We will need four extra rows to allow horizontal convolution could be done
-    // simultaneously. We also pad each row in row buffer to be aligned-up to
-    // 16 bytes.
-    // TODO(jiesun): We do not use aligned load from row buffer in vertical
-    // convolution pass yet. Somehow Windows does not like it.
-    int rowBufferWidth = (filterX.numValues() + 15) & ~0xF;
-    int rowBufferHeight = maxYFilterSize +
-                          (convolveProcs.fConvolve4RowsHorizontally ? 4 : 0);
-    CircularRowBuffer rowBuffer(rowBufferWidth,
-                                rowBufferHeight,
-                                filterOffset);
-
-    // Loop over every possible output row, processing just enough horizontal
-    // convolutions to run each subsequent vertical convolution.
+                    bool useSimdIfPossible,
+                    SkTaskScheduler* scheduler) {
     SkASSERT(outputByteRowStride >= filterX.numValues() * 4);
     int numOutputRows = filterY.numValues();
 
+    ConvolveJob job;
+    job.fSourceData = sourceData;
+    job.fSourceByteRowStride = sourceByteRowStride;
+    job.fSourceHasAlpha = sourceHasAlpha;
+    job.fFilterX = &filterX;
+    job.fFilterY = &filterY;
+    job.fOutputByteRowStride = outputByteRowStride;
+    job.fOutput = output;
+    job.fConvolveProcs = &convolveProcs;
+
     // We need to check which is the last line to convolve before we advance 4
     // lines in one iteration.
     int lastFilterOffset, lastFilterLength;
@@ -387,75 +522,29 @@ void BGRAConvolve2D(const unsigned char* sourceData,
     // rows we need to avoid the SSE implementation for here.
     filterX.FilterForValue(filterX.numValues() - 1, &lastFilterOffset,
                            &lastFilterLength);
-    int avoidSimdRows = 1 + convolveProcs.fExtraHorizontalReads /
+    job.fAvoidSimdRows = 1 + convolveProcs.fExtraHorizontalReads /
         (lastFilterOffset + lastFilterLength);
 
     filterY.FilterForValue(numOutputRows - 1, &lastFilterOffset,
                            &lastFilterLength);
+    job.fLastFilterOffset = lastFilterOffset;
+    job.fLastFilterLength = lastFilterLength;
 
-    for (int outY = 0; outY < numOutputRows; outY++) {
-        filterValues = filterY.FilterForValue(outY,
-                                              &filterOffset, &filterLength);
-
-        // Generate output rows until we have enough to run the current filter.
-        while (nextXRow < filterOffset + filterLength) {
-            if (convolveProcs.fConvolve4RowsHorizontally &&
-                nextXRow + 3 < lastFilterOffset + lastFilterLength -
-                avoidSimdRows) {
-                const unsigned char* src[4];
-                unsigned char* outRow[4];
-                for (int i = 0; i < 4; ++i) {
-                    src[i] = &sourceData[(nextXRow + i) * sourceByteRowStride];
-                    outRow[i] = rowBuffer.advanceRow();
-                }
-                convolveProcs.fConvolve4RowsHorizontally(src, filterX, outRow);
-                nextXRow += 4;
-            } else {
-                // Check if we need to avoid SSE2 for this row.
-                if (convolveProcs.fConvolveHorizontally &&
-                    nextXRow < lastFilterOffset + lastFilterLength -
-                    avoidSimdRows) {
-                    convolveProcs.fConvolveHorizontally(
-                        &sourceData[nextXRow * sourceByteRowStride],
-                        filterX, rowBuffer.advanceRow(), sourceHasAlpha);
-                } else {
-                    if (sourceHasAlpha) {
-                        ConvolveHorizontally<true>(
-                            &sourceData[nextXRow * sourceByteRowStride],
-                            filterX, rowBuffer.advanceRow());
-                    } else {
-                        ConvolveHorizontally<false>(
-                            &sourceData[nextXRow * sourceByteRowStride],
-                            filterX, rowBuffer.advanceRow());
-                    }
-                }
-                nextXRow++;
-            }
-        }
-
-        // Compute where in the output image this row of final data will go.
-        unsigned char* curOutputRow = &output[outY * outputByteRowStride];
-
-        // Get the list of rows that the circular buffer has, in order.
-        int firstRowInCircularBuffer;
-        unsigned char* const* rowsToConvolve =
-            rowBuffer.GetRowAddresses(&firstRowInCircularBuffer);
-
-        // Now compute the start of the subset of those rows that the filter
-        // needs.
-        unsigned char* const* firstRowForFilter =
-            &rowsToConvolve[filterOffset - firstRowInCircularBuffer];
+    int bandCount = 1;
+    if (scheduler && filterX.numValues() * numOutputRows >= kMinParallelPixels) {
+        bandCount = SkTMin(scheduler->threadCount() + 1, numOutputRows / kMinRowsPerBand);
+    }
+    if (bandCount <= 1) {
+        job.convolveRows(0, numOutputRows);
+        return;
+    }
 
-        if (convolveProcs.fConvolveVertically) {
-            convolveProcs.fConvolveVertically(filterValues, filterLength,
-                                               firstRowForFilter,
-                                               filterX.numValues(), curOutputRow,
-                                               sourceHasAlpha);
-        } else {
-            ConvolveVertically(filterValues, filterLength,
-                               firstRowForFilter,
-                               filterX.numValues(), curOutputRow,
-                               sourceHasAlpha);
-        }
+    // The calling thread also runs bands while it waits.
+    SkAutoTArray<ConvolveBand> bands(bandCount);
+    SkTaskGroup group(scheduler);
+    for (int i = 0; i < bandCount; ++i) {
+        bands[i].set(&job, numOutputRows * i / bandCount, numOutputRows * (i + 1) / bandCount);
+        group.add(&bands[i]);
     }
+    group.wait();
 }
@@ -9,6 +9,8 @@
 #include "SkTypes.h"
 #include "SkTArray.h"
 
+class SkTaskScheduler;
+
 // avoid confusion with Mac OS X's math library (Carbon)
 #if defined(__APPLE__)
 #undef FloatToConvolutionFixed
@@ -190,6 +192,10 @@ struct SkConvolutionProcs {
 //
 // The layout in memory is assumed to be 4-bytes per pixel in B-G-R-A order
 // (this is ARGB when loaded into 32-bit words on a little-endian machine).
+//
+// If |scheduler| is not NULL, large images are split into bands of output rows,
+// each with its own row buffer, which are convolved on the scheduler's threads
+// as well as this one. The results are the same either way.
 SK_API void BGRAConvolve2D(const unsigned char* sourceData,
     int sourceByteRowStride,
     bool sourceHasAlpha,
@@ -198,6 +204,7 @@ SK_API void BGRAConvolve2D(const unsigned char* sourceData,
     int outputByteRowStride,
     unsigned char* output,
     const SkConvolutionProcs&,
-    bool useSimdIfPossible);
+    bool useSimdIfPossible,
+    SkTaskScheduler* scheduler = NULL);
 
 #endif  // SK_CONVOLVER_H
@@ -7,6 +7,8 @@
 
 #include "SkDistanceFieldGen.h"
 #include "SkPoint.h"
+#include "SkTaskGroup.h"
+#include "SkTemplates.h"
 
 struct DFData {
     float   fAlpha;      // alpha value of source texel
@@ -486,6 +488,71 @@ bool SkGenerateDistanceFieldFromA8Image(unsigned char* distanceField,
     return generate_distance_field_from_image(distanceField, copyPtr, width, height);
 }
 
+// Don't bother sharing out fewer images than this, since small glyphs take only microseconds.
+static const int kMinDistanceFieldsPerTask = 8;
+
+namespace {
+
+class DistanceFieldTask : public SkRunnable {
+public:
+    void set(const SkDistanceFieldRequest* requests, int count) {
+        fRequests = requests;
+        fCount = count;
+    }
+
+    virtual void run() SK_OVERRIDE {
+        for (int i = 0; i < fCount; ++i) {
+            const SkDistanceFieldRequest& r = fRequests[i];
+            SkGenerateDistanceFieldFromA8Image(r.fDistanceField, r.fImage,
+                                               r.fWidth, r.fHeight, r.fRowBytes);
+        }
+    }
+
+private:
+    const SkDistanceFieldRequest*   fRequests;
+    int                             fCount;
+};
+
+}  // namespace
+
+void SkGenerateDistanceFieldsFromA8Images(const SkDistanceFieldRequest requests[], int count,
+                                          SkTaskScheduler* scheduler) {
+    int taskCount = 1;
+    if (NULL != scheduler) {
+        taskCount = SkTMin(SkTMax(scheduler->threadCount(), 1),
+                           SkTMax(count / kMinDistanceFieldsPerTask, 1));
+    }
+    if (taskCount <= 1) {
+        DistanceFieldTask task;
+        task.set(requests, count);
+        task.run();
+        return;
+    }
+
+    // Split by area, not count, since one big glyph can take as long as many small ones.
+    int64_t totalArea = 0;
+    for (int i = 0; i < count; ++i) {
+        totalArea += (int64_t)requests[i].fWidth * requests[i].fHeight;
+    }
+
+    SkAutoTArray<DistanceFieldTask> tasks(taskCount);
+    SkTaskGroup group(scheduler);
+    int start = 0;
+    int64_t area = 0;
+    for (int t = 0; t < taskCount && start < count; ++t) {
+        const int64_t target = totalArea * (t + 1) / taskCount;
+        int stop = start;
+        while (stop < count && (area < target || stop == start || t == taskCount - 1)) {
+            area += (int64_t)requests[stop].fWidth * requests[stop].fHeight;
+            ++stop;
+        }
+        tasks[t].set(requests + start, stop - start);
+        group.add(&tasks[t]);
+        start = stop;
+    }
+    group.wait();
+}
+
 // assumes a 1-bit image and 8-bit distance field
 bool SkGenerateDistanceFieldFromBWImage(unsigned char* distanceField,
                                         const unsigned char* image,
@@ -9,6 +9,8 @@
 
 #include "SkTypes.h"
 
+class SkTaskScheduler;
+
 // the max magnitude for the distance field
 // distance values are limited to the range [-SK_DistanceFieldMagnitude, SK_DistanceFieldMagnitude)
 #define SK_DistanceFieldMagnitude   4
@@ -37,6 +39,23 @@ bool SkGenerateDistanceFieldFromA8Image(unsigned char* distanceField,
                                         const unsigned char* image,
                                         int w, int h, int rowBytes);
 
+/** One image for SkGenerateDistanceFieldsFromA8Images(), with the parameters
+ *  SkGenerateDistanceFieldFromA8Image() takes.
+ */
+struct SkDistanceFieldRequest {
+    unsigned char*          fDistanceField;
+    const unsigned char*    fImage;
+    int                     fWidth;
+    int                     fHeight;
+    int                     fRowBytes;
+};
+
+/** Generate the distance fields for count 8-bit masks at once. If scheduler is not NULL, the
+ *  masks are shared out among its threads, and this returns when they are all done.
+ */
+void SkGenerateDistanceFieldsFromA8Images(const SkDistanceFieldRequest requests[], int count,
+                                          SkTaskScheduler* scheduler);
+
 /** Given 1-bit mask data, generate the associated distance field
 
  *  @param distanceField     The distance field to be generated. Should already be allocated
@@ -1553,6 +1553,11 @@ void SkDraw::drawText(const char text[], size_t byteLength,
         return;
     }
 
+    if (ShouldDrawTextAsDistanceFields(paint, *fMatrix) && needsRasterTextBlit(*this)) {
+        this->drawText_asDistanceFields(text, byteLength, x, y, paint);
+        return;
+    }
+
     // SkScalarRec doesn't currently have a way of representing hairline stroke and
     // will fill if its frame-width is 0.
     if (ShouldDrawTextAsPaths(paint, *fMatrix)) {
@@ -1816,6 +1821,12 @@ void SkDraw::drawPosText(const char text[], size_t byteLength,
         return;
     }
 
+    if (ShouldDrawTextAsDistanceFields(paint, *fMatrix) && needsRasterTextBlit(*this)) {
+        this->drawPosText_asDistanceFields(text, byteLength, pos, constY,
+                                           scalarsPerPosition, paint);
+        return;
+    }
+
     if (ShouldDrawTextAsPaths(paint, *fMatrix)) {
         this->drawPosText_asPaths(text, byteLength, pos, constY,
                                   scalarsPerPosition, paint);
@@ -1950,6 +1961,290 @@ void SkDraw::drawPosText(const char text[], size_t byteLength,
 
 ///////////////////////////////////////////////////////////////////////////////
 
+#include "SkDistanceFieldGen.h"
+
+// The sizes of the distance field strikes, as in GrDistanceFieldTextContext.
+static const int kSmallDFFontSize = 32;
+static const int kSmallDFFontLimit = 32;
+static const int kMediumDFFontSize = 64;
+static const int kMediumDFFontLimit = 64;
+static const int kLargeDFFontSize = 128;
+
+bool SkDraw::ShouldDrawTextAsDistanceFields(const SkPaint& paint, const SkMatrix& ctm) {
+    if (!paint.isDistanceFieldTextTEMP() || paint.getTextSize() <= 0) {
+        return false;
+    }
+
+    // rasterizers and mask filters modify alpha, which doesn't translate well to distance,
+    // and we only fill
+    if (paint.getRasterizer() || paint.getMaskFilter() ||
+        SkPaint::kFill_Style != paint.getStyle()) {
+        return false;
+    }
+
+    // the fields are scaled, but not rotated, skewed or flipped
+    if (ctm.getType() & ~(SkMatrix::kScale_Mask | SkMatrix::kTranslate_Mask)) {
+        return false;
+    }
+    if (ctm.getScaleX() <= 0 || ctm.getScaleY() <= 0) {
+        return false;
+    }
+
+    // color glyphs have no distance field
+    SkScalerContext::Rec rec;
+    SkScalerContext::MakeRec(paint, NULL, NULL, &rec);
+    return SkMask::kARGB32_Format != rec.getFormat();
+}
+
+namespace {
+
+/**
+ *  Draws glyphs from a distance field strike, scaled and thresholded to the text's device size.
+ *  The strike is one of three sizes, picked by the device size, so text drawn at many sizes
+ *  shares a few strikes rather than making one of its own for each size.
+ */
+class DistanceFieldGlyphDrawer : SkNoncopyable {
+public:
+    DistanceFieldGlyphDrawer(const SkDraw& draw, const SkDeviceProperties* deviceProperties,
+                             const SkPaint& paint);
+
+    /** The paint the strike was made with, at the strike's text size. */
+    const SkPaint& getPaint() const { return fPaint; }
+    SkGlyphCache* getCache() const { return fAutoCache.getCache(); }
+
+    /** Device pixels per unit of the strike, which also scales its advances. */
+    SkScalar scaleX() const { return fScaleX; }
+    SkScalar scaleY() const { return fScaleY; }
+
+    /** Make sure the strike has fields for all of text, generating what's missing in a batch,
+        on the draw's fTaskScheduler if it has one. */
+    void prewarm(const char text[], size_t byteLength);
+
+    /** Draw glyph with its origin at (x, y) in device space. */
+    void drawGlyph(SkScalar x, SkScalar y, const SkGlyph& glyph);
+
+private:
+    enum {
+        // The coverage table is indexed by the top bits of a bilerped 8.16 distance value.
+        kCoverageShift = 14,
+        kCoverageCount = (255 << 16 >> kCoverageShift) + 1
+    };
+
+    SkScalar                fTextRatio;     // The text's size over the strike's.
+    SkPaint                 fPaint;
+    SkAutoGlyphCache        fAutoCache;
+    SkScalar                fScaleX;
+    SkScalar                fScaleY;
+    SkTaskScheduler*        fTaskScheduler;
+    SkAutoBlitterChoose     fBlitterChooser;
+    SkAAClipBlitterWrapper  fWrapper;
+    SkAutoSMalloc<1024>     fCoverage;
+    uint8_t                 fCoverageTable[kCoverageCount];
+};
+
+// Returns paint at the size of the distance field strike to draw it from, as
+// GrDistanceFieldTextContext sets it up, and sets textRatio to the text's size in the strike's.
+static SkPaint make_distance_field_paint(const SkPaint& paint, const SkMatrix& matrix,
+                                         SkScalar* textRatio) {
+    SkScalar textSize = paint.getTextSize();
+    SkScalar deviceSize = SkScalarMul(textSize,
+                                      SkMaxScalar(matrix.getScaleX(), matrix.getScaleY()));
+    int dfSize;
+    if (deviceSize <= kSmallDFFontLimit) {
+        dfSize = kSmallDFFontSize;
+    } else if (deviceSize <= kMediumDFFontLimit) {
+        dfSize = kMediumDFFontSize;
+    } else {
+        dfSize = kLargeDFFontSize;
+    }
+    *textRatio = textSize / dfSize;
+
+    SkPaint dfPaint(paint);
+    dfPaint.setTextSize(SkIntToScalar(dfSize));
+    dfPaint.setLCDRenderText(false);
+    dfPaint.setAutohinted(false);
+    dfPaint.setSubpixelText(true);
+    return dfPaint;
+}
+
+DistanceFieldGlyphDrawer::DistanceFieldGlyphDrawer(const SkDraw& draw,
+                                                   const SkDeviceProperties* deviceProperties,
+                                                   const SkPaint& paint)
+        : fTextRatio(0)
+        , fPaint(make_distance_field_paint(paint, *draw.fMatrix, &fTextRatio))
+        , fAutoCache(fPaint, deviceProperties, NULL)
+        , fScaleX(SkScalarMul(fTextRatio, draw.fMatrix->getScaleX()))
+        , fScaleY(SkScalarMul(fTextRatio, draw.fMatrix->getScaleY()))
+        , fTaskScheduler(draw.fTaskScheduler) {
+    fBlitterChooser.choose(*draw.fBitmap, *draw.fMatrix, paint);
+    fWrapper.init(*draw.fRC, fBlitterChooser.get());
+
+    // A field value v is SK_DistanceFieldMagnitude - v/32 texels outside the glyph's edge.
+    // Scale that to device pixels, and cover the half pixel either side of the edge.
+    const SkScalar pixelsPerTexel = SkScalarHalf(fScaleX + fScaleY);
+    for (int i = 0; i < kCoverageCount; ++i) {
+        SkScalar value = SkIntToScalar(i << kCoverageShift) / (1 << 16);
+        SkScalar distance = (SK_DistanceFieldMagnitude - value / 32) * pixelsPerTexel;
+        SkScalar coverage = SkScalarPin(SK_ScalarHalf - distance, 0, SK_Scalar1);
+        fCoverageTable[i] = SkToU8(SkScalarRoundToInt(coverage * 255));
+    }
+}
+
+void DistanceFieldGlyphDrawer::prewarm(const char text[], size_t byteLength) {
+    SkAutoSTMalloc<64, uint16_t> storage(byteLength);
+    uint16_t* glyphIDs = storage.get();
+    int count = fPaint.textToGlyphs(text, byteLength, glyphIDs);
+    this->getCache()->prewarmGlyphIDs(glyphIDs, count, SkGlyphCache::kDistanceField_PrewarmFlag,
+                                      fTaskScheduler);
+}
+
+// Texels outside the field are far outside the glyph.
+static inline unsigned field_texel(const uint8_t* field, int width, int height, int x, int y) {
+    if ((unsigned)x >= (unsigned)width || (unsigned)y >= (unsigned)height) {
+        return 0;
+    }
+    return field[y * width + x];
+}
+
+void DistanceFieldGlyphDrawer::drawGlyph(SkScalar x, SkScalar y, const SkGlyph& glyph) {
+    const uint8_t* field = (const uint8_t*)this->getCache()->findDistanceField(glyph);
+    if (NULL == field) {
+        return;
+    }
+    const int fieldWidth = glyph.fWidth + 2 * SK_DistanceFieldPad;
+    const int fieldHeight = glyph.fHeight + 2 * SK_DistanceFieldPad;
+
+    // where the field's top left corner lands on the device
+    const SkScalar left = x + (glyph.fLeft - SK_DistanceFieldPad) * fScaleX;
+    const SkScalar top = y + (glyph.fTop - SK_DistanceFieldPad) * fScaleY;
+
+    SkIRect bounds;
+    bounds.set(SkScalarFloorToInt(left), SkScalarFloorToInt(top),
+               SkScalarCeilToInt(left + fieldWidth * fScaleX),
+               SkScalarCeilToInt(top + fieldHeight * fScaleY));
+    if (!bounds.intersect(fWrapper.getBounds())) {
+        return;
+    }
+    const int width = bounds.width();
+    const int height = bounds.height();
+    uint8_t* coverage = (uint8_t*)fCoverage.reset(width * height);
+
+    // Sample the field bilinearly at each pixel center, in 16.16 texel coordinates.
+    const SkFixed du = SkScalarToFixed(SkScalarInvert(fScaleX));
+    const SkFixed dv = SkScalarToFixed(SkScalarInvert(fScaleY));
+    const SkFixed u0 = SkScalarToFixed((bounds.fLeft + SK_ScalarHalf - left) / fScaleX -
+                                       SK_ScalarHalf);
+    SkFixed v = SkScalarToFixed((bounds.fTop + SK_ScalarHalf - top) / fScaleY - SK_ScalarHalf);
+    uint8_t* row = coverage;
+    for (int j = 0; j < height; ++j) {
+        const int ty = v >> 16;
+        const unsigned fy = (v >> 8) & 0xFF;
+        SkFixed u = u0;
+        for (int i = 0; i < width; ++i) {
+            const int tx = u >> 16;
+            const unsigned fx = (u >> 8) & 0xFF;
+            unsigned upper =
+                    field_texel(field, fieldWidth, fieldHeight, tx, ty) * (256 - fx) +
+                    field_texel(field, fieldWidth, fieldHeight, tx + 1, ty) * fx;
+            unsigned lower =
+                    field_texel(field, fieldWidth, fieldHeight, tx, ty + 1) * (256 - fx) +
+                    field_texel(field, fieldWidth, fieldHeight, tx + 1, ty + 1) * fx;
+            unsigned value = upper * (256 - fy) + lower * fy;
+            row[i] = fCoverageTable[value >> kCoverageShift];
+            u += du;
+        }
+        row += width;
+        v += dv;
+    }
+
+    SkMask mask;
+    mask.fImage = coverage;
+    mask.fBounds = bounds;
+    mask.fRowBytes = width;
+    mask.fFormat = SkMask::kA8_Format;
+
+    SkBlitter* blitter = fWrapper.getBlitter();
+    SkRegion::Cliperator clipper(fWrapper.getRgn(), bounds);
+    while (!clipper.done()) {
+        blitter->blitMask(mask, clipper.rect());
+        clipper.next();
+    }
+}
+
+}  // namespace
+
+void SkDraw::drawText_asDistanceFields(const char text[], size_t byteLength,
+                                       SkScalar x, SkScalar y, const SkPaint& paint) const {
+    SkDEBUGCODE(this->validate();)
+
+    DistanceFieldGlyphDrawer drawer(*this, &fDevice->fLeakyProperties, paint);
+    SkGlyphCache* cache = drawer.getCache();
+    SkDrawCacheProc glyphCacheProc = drawer.getPaint().getDrawCacheProc();
+    drawer.prewarm(text, byteLength);
+
+    if (paint.getTextAlign() != SkPaint::kLeft_Align) {
+        SkVector stop;
+        measure_text(cache, glyphCacheProc, text, byteLength, &stop);
+        if (paint.getTextAlign() == SkPaint::kCenter_Align) {
+            stop.scale(SK_ScalarHalf);
+        }
+        x -= SkScalarMul(stop.fX, drawer.scaleX()) / fMatrix->getScaleX();
+        y -= SkScalarMul(stop.fY, drawer.scaleY()) / fMatrix->getScaleY();
+    }
+
+    SkPoint loc;
+    fMatrix->mapXY(x, y, &loc);
+
+    const char* stop = text + byteLength;
+    while (text < stop) {
+        const SkGlyph& glyph = glyphCacheProc(cache, &text, 0, 0);
+        if (glyph.fWidth) {
+            drawer.drawGlyph(loc.fX, loc.fY, glyph);
+        }
+        loc.fX += SkScalarMul(SkFixedToScalar(glyph.fAdvanceX), drawer.scaleX());
+        loc.fY += SkScalarMul(SkFixedToScalar(glyph.fAdvanceY), drawer.scaleY());
+    }
+}
+
+void SkDraw::drawPosText_asDistanceFields(const char text[], size_t byteLength,
+                                          const SkScalar pos[], SkScalar constY,
+                                          int scalarsPerPosition,
+                                          const SkPaint& paint) const {
+    SkDEBUGCODE(this->validate();)
+
+    DistanceFieldGlyphDrawer drawer(*this, &fDevice->fLeakyProperties, paint);
+    SkGlyphCache* cache = drawer.getCache();
+    SkDrawCacheProc glyphCacheProc = drawer.getPaint().getDrawCacheProc();
+    drawer.prewarm(text, byteLength);
+
+    // as for AlignProc_scalar, but with the advance scaled to the device
+    SkScalar alignScale = 0;
+    if (paint.getTextAlign() == SkPaint::kCenter_Align) {
+        alignScale = SK_ScalarHalf;
+    } else if (paint.getTextAlign() == SkPaint::kRight_Align) {
+        alignScale = SK_Scalar1;
+    }
+    const SkScalar alignX = SkScalarMul(alignScale, drawer.scaleX());
+    const SkScalar alignY = SkScalarMul(alignScale, drawer.scaleY());
+
+    const char*        stop = text + byteLength;
+    TextMapState       tms(*fMatrix, constY);
+    TextMapState::Proc tmsProc = tms.pickProc(scalarsPerPosition);
+
+    while (text < stop) {
+        const SkGlyph& glyph = glyphCacheProc(cache, &text, 0, 0);
+        if (glyph.fWidth) {
+            tmsProc(tms, pos);
+            drawer.drawGlyph(tms.fLoc.fX - SkScalarMul(SkFixedToScalar(glyph.fAdvanceX), alignX),
+                             tms.fLoc.fY - SkScalarMul(SkFixedToScalar(glyph.fAdvanceY), alignY),
+                             glyph);
+        }
+        pos += scalarsPerPosition;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 #include "SkPathMeasure.h"
 
 static void morphpoints(SkPoint dst[], const SkPoint src[], int count,
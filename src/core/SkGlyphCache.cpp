@@ -9,13 +9,17 @@
 
 #include "SkGlyphCache.h"
 #include "SkGlyphCache_Globals.h"
+#include "SkCmapCache.h"
 #include "SkDistanceFieldGen.h"
 #include "SkGraphics.h"
 #include "SkLazyPtr.h"
 #include "SkPaint.h"
 #include "SkPath.h"
+#include "SkTaskGroup.h"
 #include "SkTemplates.h"
+#include "SkThread.h"
 #include "SkTLS.h"
+#include "SkTSort.h"
 #include "SkTypeface.h"
 
 //#define SPEW_PURGE_STATUS
@@ -73,16 +77,79 @@ static SkGlyphCache_Globals& getGlobals() {
 #define kMinGlyphImageSize  (16*2)
 #define kMinAllocAmount     ((sizeof(SkGlyph) + kMinGlyphImageSize) * kMinGlyphCount)
 
-SkGlyphCache::SkGlyphCache(SkTypeface* typeface, const SkDescriptor* desc, SkScalerContext* ctx)
-        : fScalerContext(ctx), fGlyphAlloc(kMinAllocAmount) {
-    SkASSERT(typeface);
-    SkASSERT(desc);
-    SkASSERT(ctx);
+/*  The glyphs for one descriptor, and the scaler context that generates them,
+    shared by all the SkGlyphCaches for that descriptor. fMutex protects the
+    glyph array and allocator, and the scaler context.
 
-    fPrev = fNext = NULL;
+    Once a glyph is created it never moves. Other threads may be reading it
+    while we fill in its image, path or distance field, or upgrade it from
+    just-advance to full metrics, so we write those last with release stores;
+    readers that find them already set use acquire loads.
+*/
+struct SkGlyphCache::Strike {
+    Strike(const SkDescriptor* desc, SkScalerContext* ctx)
+        : fScalerContext(ctx)
+        , fGlyphAlloc(kMinAllocAmount)
+        , fNext(NULL)
+        , fPrev(NULL)
+        , fCacheCount(1)
+        , fOrphanedMemory(0) {
+        fDesc = desc->copy();
+        fScalerContext->getFontMetrics(&fFontMetrics);
+        fGlyphArray.setReserve(kMinGlyphCount);
+    }
 
-    fDesc = desc->copy();
-    fScalerContext->getFontMetrics(&fFontMetrics);
+    ~Strike() {
+        SkGlyph**   gptr = fGlyphArray.begin();
+        SkGlyph**   stop = fGlyphArray.end();
+        while (gptr < stop) {
+            SkPath* path = (*gptr)->fPath;
+            if (path) {
+                SkDELETE(path);
+            }
+            gptr += 1;
+        }
+        SkDescriptor::Free(fDesc);
+        SkDELETE(fScalerContext);
+    }
+
+    // The rest of these must be called with fMutex held.
+    // Each adds the number of bytes it allocated to *memoryUsed.
+    SkGlyph* lookupMetrics(uint32_t id, MetricsType, size_t* memoryUsed);
+    void upgradeMetrics(SkGlyph*);
+    const void* findImage(const SkGlyph&, size_t* memoryUsed);
+    const SkPath* findPath(const SkGlyph&, size_t* memoryUsed);
+    const void* findDistanceField(const SkGlyph&, size_t* memoryUsed);
+
+    // Returns the index of the glyph for id in fGlyphArray, or where it belongs if there is none.
+    int findIndex(uint32_t id) const;
+
+    // Copies full's metrics into the just-advance glyph, then publishes its mask format.
+    static void PublishFullMetrics(const SkGlyph& full, SkGlyph* glyph);
+
+    // Like lookupMetrics(), findImage() and findPath(), but taking what a prewarm task generated
+    // instead of asking fScalerContext.  addPath() takes ownership of path.
+    SkGlyph* addMetrics(const SkGlyph& generated, size_t* memoryUsed);
+    void addImage(const SkGlyph&, const void* image, size_t* memoryUsed);
+    void addPath(const SkGlyph&, SkPath* path, size_t* memoryUsed);
+
+    SkMutex              fMutex;
+    SkDescriptor*        fDesc;
+    SkScalerContext*     fScalerContext;
+    SkPaint::FontMetrics fFontMetrics;
+    SkTDArray<SkGlyph*>  fGlyphArray;
+    SkChunkAlloc         fGlyphAlloc;
+
+    // These belong to the SkGlyphCache_Globals that the caches sharing us live in.
+    Strike* fNext, *fPrev;
+    int     fCacheCount;        // how many SkGlyphCaches share us
+    size_t  fOrphanedMemory;    // glyph memory charged to SkGlyphCaches since deleted
+};
+
+SkGlyphCache::SkGlyphCache(Strike* strike) : fStrike(strike) {
+    SkASSERT(strike);
+
+    fPrev = fNext = NULL;
 
     // init to 0 so that all of the pointers will be null
     memset(fGlyphHash, 0, sizeof(fGlyphHash));
@@ -91,48 +158,25 @@ SkGlyphCache::SkGlyphCache(SkTypeface* typeface, const SkDescriptor* desc, SkSca
 
     fMemoryUsed = sizeof(*this);
 
-    fGlyphArray.setReserve(kMinGlyphCount);
-
     fAuxProcList = NULL;
+    fLatin1Glyphs = NULL;
 }
 
 SkGlyphCache::~SkGlyphCache() {
-#if 0
-    {
-        size_t ptrMem = fGlyphArray.count() * sizeof(SkGlyph*);
-        size_t glyphAlloc = fGlyphAlloc.totalCapacity();
-        size_t glyphHashUsed = 0;
-        size_t uniHashUsed = 0;
-        for (int i = 0; i < kHashCount; ++i) {
-            glyphHashUsed += fGlyphHash[i] ? sizeof(fGlyphHash[0]) : 0;
-            uniHashUsed += fCharToGlyphHash[i].fID != 0xFFFFFFFF ? sizeof(fCharToGlyphHash[0]) : 0;
-        }
-        size_t glyphUsed = fGlyphArray.count() * sizeof(SkGlyph);
-        size_t imageUsed = 0;
-        for (int i = 0; i < fGlyphArray.count(); ++i) {
-            const SkGlyph& g = *fGlyphArray[i];
-            if (g.fImage) {
-                imageUsed += g.fHeight * g.rowBytes();
-            }
-        }
+    // Our SkGlyphCache_Globals takes care of fStrike.
+    this->invokeAndRemoveAuxProcs();
+}
 
-        printf("glyphPtrArray,%zu, Alloc,%zu, imageUsed,%zu, glyphUsed,%zu, glyphHashAlloc,%zu, glyphHashUsed,%zu, unicharHashAlloc,%zu, unicharHashUsed,%zu\n",
-                 ptrMem, glyphAlloc, imageUsed, glyphUsed, sizeof(fGlyphHash), glyphHashUsed, sizeof(fCharToGlyphHash), uniHashUsed);
+const SkPaint::FontMetrics& SkGlyphCache::getFontMetrics() const {
+    return fStrike->fFontMetrics;
+}
 
-    }
-#endif
-    SkGlyph**   gptr = fGlyphArray.begin();
-    SkGlyph**   stop = fGlyphArray.end();
-    while (gptr < stop) {
-        SkPath* path = (*gptr)->fPath;
-        if (path) {
-            SkDELETE(path);
-        }
-        gptr += 1;
-    }
-    SkDescriptor::Free(fDesc);
-    SkDELETE(fScalerContext);
-    this->invokeAndRemoveAuxProcs();
+const SkDescriptor& SkGlyphCache::getDescriptor() const {
+    return *fStrike->fDesc;
+}
+
+SkScalerContext* SkGlyphCache::getScalerContext() const {
+    return fStrike->fScalerContext;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -143,6 +187,12 @@ SkGlyphCache::~SkGlyphCache() {
 #define VALIDATE()
 #endif
 
+// Is this glyph, which may be shared with other threads, missing its full metrics?
+static bool needs_metrics(const SkGlyph* glyph) {
+    return MASK_FORMAT_JUST_ADVANCE ==
+           sk_acquire_load(const_cast<uint8_t*>(&glyph->fMaskFormat));
+}
+
 uint16_t SkGlyphCache::unicharToGlyph(SkUnichar charCode) {
     VALIDATE();
     uint32_t id = SkGlyph::MakeID(charCode);
@@ -151,17 +201,33 @@ uint16_t SkGlyphCache::unicharToGlyph(SkUnichar charCode) {
     if (rec.fID == id) {
         return rec.fGlyph->getGlyphID();
     } else {
-        return fScalerContext->charToGlyphID(charCode);
+        SkAutoMutexAcquire lock(fStrike->fMutex);
+        return fStrike->fScalerContext->charToGlyphID(charCode);
     }
 }
 
+const uint16_t* SkGlyphCache::findLatin1Glyphs() const {
+    // The typeface never changes, so we don't need fStrike->fMutex for it.
+    const SkTypeface* typeface = fStrike->fScalerContext->getTypeface();
+    return typeface->getCmapCache()->getLatin1Glyphs(typeface);
+}
+
 SkUnichar SkGlyphCache::glyphToUnichar(uint16_t glyphID) {
-    return fScalerContext->glyphIDToChar(glyphID);
+    SkAutoMutexAcquire lock(fStrike->fMutex);
+    return fStrike->fScalerContext->glyphIDToChar(glyphID);
 }
 
 unsigned SkGlyphCache::getGlyphCount() {
-    return fScalerContext->getGlyphCount();
+    SkAutoMutexAcquire lock(fStrike->fMutex);
+    return fStrike->fScalerContext->getGlyphCount();
+}
+
+#ifdef SK_BUILD_FOR_ANDROID
+unsigned SkGlyphCache::getBaseGlyphCount(SkUnichar charCode) const {
+    SkAutoMutexAcquire lock(fStrike->fMutex);
+    return fStrike->fScalerContext->getBaseGlyphCount(charCode);
 }
+#endif
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -173,9 +239,7 @@ const SkGlyph& SkGlyphCache::getUnicharAdvance(SkUnichar charCode) {
     if (rec->fID != id) {
         // this ID is based on the UniChar
         rec->fID = id;
-        // this ID is based on the glyph index
-        id = SkGlyph::MakeID(fScalerContext->charToGlyphID(charCode));
-        rec->fGlyph = this->lookupMetrics(id, kJustAdvance_MetricsType);
+        rec->fGlyph = this->lookupUnicharMetrics(charCode, 0, 0, kJustAdvance_MetricsType);
     }
     return *rec->fGlyph;
 }
@@ -204,13 +268,11 @@ const SkGlyph& SkGlyphCache::getUnicharMetrics(SkUnichar charCode) {
         RecordHashCollisionIf(rec->fGlyph != NULL);
         // this ID is based on the UniChar
         rec->fID = id;
-        // this ID is based on the glyph index
-        id = SkGlyph::MakeID(fScalerContext->charToGlyphID(charCode));
-        rec->fGlyph = this->lookupMetrics(id, kFull_MetricsType);
+        rec->fGlyph = this->lookupUnicharMetrics(charCode, 0, 0, kFull_MetricsType);
     } else {
         RecordHashSuccess();
-        if (rec->fGlyph->isJustAdvance()) {
-            fScalerContext->getMetrics(rec->fGlyph);
+        if (needs_metrics(rec->fGlyph)) {
+            this->upgradeMetrics(rec->fGlyph);
         }
     }
     SkASSERT(rec->fGlyph->isFullMetrics());
@@ -227,13 +289,11 @@ const SkGlyph& SkGlyphCache::getUnicharMetrics(SkUnichar charCode,
         RecordHashCollisionIf(rec->fGlyph != NULL);
         // this ID is based on the UniChar
         rec->fID = id;
-        // this ID is based on the glyph index
-        id = SkGlyph::MakeID(fScalerContext->charToGlyphID(charCode), x, y);
-        rec->fGlyph = this->lookupMetrics(id, kFull_MetricsType);
+        rec->fGlyph = this->lookupUnicharMetrics(charCode, x, y, kFull_MetricsType);
     } else {
         RecordHashSuccess();
-        if (rec->fGlyph->isJustAdvance()) {
-            fScalerContext->getMetrics(rec->fGlyph);
+        if (needs_metrics(rec->fGlyph)) {
+            this->upgradeMetrics(rec->fGlyph);
         }
     }
     SkASSERT(rec->fGlyph->isFullMetrics());
@@ -252,8 +312,8 @@ const SkGlyph& SkGlyphCache::getGlyphIDMetrics(uint16_t glyphID) {
         fGlyphHash[index] = glyph;
     } else {
         RecordHashSuccess();
-        if (glyph->isJustAdvance()) {
-            fScalerContext->getMetrics(glyph);
+        if (needs_metrics(glyph)) {
+            this->upgradeMetrics(glyph);
         }
     }
     SkASSERT(glyph->isFullMetrics());
@@ -273,8 +333,8 @@ const SkGlyph& SkGlyphCache::getGlyphIDMetrics(uint16_t glyphID,
         fGlyphHash[index] = glyph;
     } else {
         RecordHashSuccess();
-        if (glyph->isJustAdvance()) {
-            fScalerContext->getMetrics(glyph);
+        if (needs_metrics(glyph)) {
+            this->upgradeMetrics(glyph);
         }
     }
     SkASSERT(glyph->isFullMetrics());
@@ -282,13 +342,30 @@ const SkGlyph& SkGlyphCache::getGlyphIDMetrics(uint16_t glyphID,
 }
 
 SkGlyph* SkGlyphCache::lookupMetrics(uint32_t id, MetricsType mtype) {
-    SkGlyph* glyph;
+    SkAutoMutexAcquire lock(fStrike->fMutex);
+    return fStrike->lookupMetrics(id, mtype, &fMemoryUsed);
+}
 
+SkGlyph* SkGlyphCache::lookupUnicharMetrics(SkUnichar charCode, SkFixed x, SkFixed y,
+                                            MetricsType mtype) {
+    SkAutoMutexAcquire lock(fStrike->fMutex);
+    // this ID is based on the glyph index
+    uint32_t id = SkGlyph::MakeID(fStrike->fScalerContext->charToGlyphID(charCode), x, y);
+    return fStrike->lookupMetrics(id, mtype, &fMemoryUsed);
+}
+
+SkGlyph* SkGlyphCache::upgradeMetrics(SkGlyph* glyph) {
+    SkAutoMutexAcquire lock(fStrike->fMutex);
+    fStrike->upgradeMetrics(glyph);
+    return glyph;
+}
+
+int SkGlyphCache::Strike::findIndex(uint32_t id) const {
     int     hi = 0;
     int     count = fGlyphArray.count();
 
     if (count) {
-        SkGlyph**   gptr = fGlyphArray.begin();
+        SkGlyph* const* gptr = fGlyphArray.begin();
         int     lo = 0;
 
         hi = count - 1;
@@ -300,27 +377,35 @@ SkGlyph* SkGlyphCache::lookupMetrics(uint32_t id, MetricsType mtype) {
                 hi = mid;
             }
         }
-        glyph = gptr[hi];
+        // check if we need to bump hi past the last glyph
+        if (gptr[hi]->fID < id) {
+            hi += 1;
+        }
+    }
+    return hi;
+}
+
+SkGlyph* SkGlyphCache::Strike::lookupMetrics(uint32_t id, MetricsType mtype,
+                                             size_t* memoryUsed) {
+    SkGlyph* glyph;
+
+    int hi = this->findIndex(id);
+    if (hi < fGlyphArray.count()) {
+        glyph = fGlyphArray[hi];
         if (glyph->fID == id) {
-            if (kFull_MetricsType == mtype && glyph->isJustAdvance()) {
-                fScalerContext->getMetrics(glyph);
+            if (kFull_MetricsType == mtype) {
+                this->upgradeMetrics(glyph);
             }
             return glyph;
         }
-
-        // check if we need to bump hi before falling though to the allocator
-        if (glyph->fID < id) {
-            hi += 1;
-        }
     }
 
     // not found, but hi tells us where to inser the new glyph
-    fMemoryUsed += sizeof(SkGlyph);
+    *memoryUsed += sizeof(SkGlyph);
 
     glyph = (SkGlyph*)fGlyphAlloc.alloc(sizeof(SkGlyph),
                                         SkChunkAlloc::kThrow_AllocFailType);
     glyph->init(id);
-    *fGlyphArray.insert(hi) = glyph;
 
     if (kJustAdvance_MetricsType == mtype) {
         fScalerContext->getAdvance(glyph);
@@ -328,25 +413,61 @@ SkGlyph* SkGlyphCache::lookupMetrics(uint32_t id, MetricsType mtype) {
         SkASSERT(kFull_MetricsType == mtype);
         fScalerContext->getMetrics(glyph);
     }
+    // No other thread can see glyph until we insert it.
+    *fGlyphArray.insert(hi) = glyph;
 
     return glyph;
 }
 
+void SkGlyphCache::Strike::upgradeMetrics(SkGlyph* glyph) {
+    if (!glyph->isJustAdvance()) {
+        return;  // Someone beat us to it.
+    }
+    SkGlyph full = *glyph;
+    fScalerContext->getMetrics(&full);
+    PublishFullMetrics(full, glyph);
+}
+
+void SkGlyphCache::Strike::PublishFullMetrics(const SkGlyph& full, SkGlyph* glyph) {
+    // Readers may be looking at glyph's advance, image, path and distance field right now, so we
+    // write only the fields they can't read until they've seen the new mask format.
+    glyph->fWidth    = full.fWidth;
+    glyph->fHeight   = full.fHeight;
+    glyph->fTop      = full.fTop;
+    glyph->fLeft     = full.fLeft;
+    glyph->fRsbDelta = full.fRsbDelta;
+    glyph->fLsbDelta = full.fLsbDelta;
+    sk_release_store(&glyph->fMaskFormat, full.fMaskFormat);
+}
+
 const void* SkGlyphCache::findImage(const SkGlyph& glyph) {
     if (glyph.fWidth > 0 && glyph.fWidth < kMaxGlyphWidth) {
-        if (NULL == glyph.fImage) {
-            size_t  size = glyph.computeImageSize();
-            const_cast<SkGlyph&>(glyph).fImage = fGlyphAlloc.alloc(size,
-                                        SkChunkAlloc::kReturnNil_AllocFailType);
-            // check that alloc() actually succeeded
-            if (NULL != glyph.fImage) {
-                fScalerContext->getImage(glyph);
-                // TODO: the scaler may have changed the maskformat during
-                // getImage (e.g. from AA or LCD to BW) which means we may have
-                // overallocated the buffer. Check if the new computedImageSize
-                // is smaller, and if so, strink the alloc size in fImageAlloc.
-                fMemoryUsed += size;
-            }
+        const void* image = sk_acquire_load(const_cast<void**>(&glyph.fImage));
+        if (NULL == image) {
+            SkAutoMutexAcquire lock(fStrike->fMutex);
+            image = fStrike->findImage(glyph, &fMemoryUsed);
+        }
+        return image;
+    }
+    return glyph.fImage;
+}
+
+const void* SkGlyphCache::Strike::findImage(const SkGlyph& glyph, size_t* memoryUsed) {
+    if (NULL == glyph.fImage) {
+        size_t  size = glyph.computeImageSize();
+        void* image = fGlyphAlloc.alloc(size, SkChunkAlloc::kReturnNil_AllocFailType);
+        // check that alloc() actually succeeded
+        if (NULL != image) {
+            // Generate the image before anyone else can see it.
+            SkGlyph tmp = glyph;
+            tmp.fImage = image;
+            fScalerContext->getImage(tmp);
+            // TODO: the scaler may have changed the maskformat during
+            // getImage (e.g. from AA or LCD to BW) which means we may have
+            // overallocated the buffer. Check if the new computedImageSize
+            // is smaller, and if so, strink the alloc size in fImageAlloc.
+            sk_release_store(&const_cast<SkGlyph&>(glyph).fImage, image);
+            *memoryUsed += size;
         }
     }
     return glyph.fImage;
@@ -354,48 +475,71 @@ const void* SkGlyphCache::findImage(const SkGlyph& glyph) {
 
 const SkPath* SkGlyphCache::findPath(const SkGlyph& glyph) {
     if (glyph.fWidth) {
-        if (glyph.fPath == NULL) {
-            const_cast<SkGlyph&>(glyph).fPath = SkNEW(SkPath);
-            fScalerContext->getPath(glyph, glyph.fPath);
-            fMemoryUsed += sizeof(SkPath) +
-                    glyph.fPath->countPoints() * sizeof(SkPoint);
+        const SkPath* path = sk_acquire_load(const_cast<SkPath**>(&glyph.fPath));
+        if (NULL == path) {
+            SkAutoMutexAcquire lock(fStrike->fMutex);
+            path = fStrike->findPath(glyph, &fMemoryUsed);
         }
+        return path;
+    }
+    return glyph.fPath;
+}
+
+const SkPath* SkGlyphCache::Strike::findPath(const SkGlyph& glyph, size_t* memoryUsed) {
+    if (glyph.fPath == NULL) {
+        SkPath* path = SkNEW(SkPath);
+        fScalerContext->getPath(glyph, path);
+        *memoryUsed += sizeof(SkPath) + path->countPoints() * sizeof(SkPoint);
+        sk_release_store(&const_cast<SkGlyph&>(glyph).fPath, path);
     }
     return glyph.fPath;
 }
 
 const void* SkGlyphCache::findDistanceField(const SkGlyph& glyph) {
     if (glyph.fWidth > 0 && glyph.fWidth < kMaxGlyphWidth) {
-        if (NULL == glyph.fDistanceField) {
-            size_t  size = SkComputeDistanceFieldSize(glyph.fWidth, glyph.fHeight);
-            if (size == 0) {
-                return NULL;
-            }
-            const void* image = this->findImage(glyph);
-            // now generate the distance field
-            if (NULL != image) {
-                const_cast<SkGlyph&>(glyph).fDistanceField = fGlyphAlloc.alloc(size,
-                                            SkChunkAlloc::kReturnNil_AllocFailType);
-                if (NULL != glyph.fDistanceField) {
-                    SkMask::Format maskFormat = static_cast<SkMask::Format>(glyph.fMaskFormat);
-                    if (SkMask::kA8_Format == maskFormat) {
-                        // make the distance field from the image
-                        SkGenerateDistanceFieldFromA8Image((unsigned char*)glyph.fDistanceField,
-                                                           (unsigned char*)glyph.fImage,
-                                                           glyph.fWidth, glyph.fHeight,
-                                                           glyph.rowBytes());
-                        fMemoryUsed += size;
-                    } else if (SkMask::kBW_Format == maskFormat) {
-                        // make the distance field from the image
-                        SkGenerateDistanceFieldFromBWImage((unsigned char*)glyph.fDistanceField,
-                                                           (unsigned char*)glyph.fImage,
-                                                           glyph.fWidth, glyph.fHeight,
-                                                           glyph.rowBytes());
-                        fMemoryUsed += size;
-                    } else {
-                        fGlyphAlloc.unalloc(glyph.fDistanceField);
-                        const_cast<SkGlyph&>(glyph).fDistanceField = NULL;
-                    }
+        const void* field = sk_acquire_load(const_cast<void**>(&glyph.fDistanceField));
+        if (NULL == field) {
+            SkAutoMutexAcquire lock(fStrike->fMutex);
+            field = fStrike->findDistanceField(glyph, &fMemoryUsed);
+        }
+        return field;
+    }
+    return glyph.fDistanceField;
+}
+
+const void* SkGlyphCache::Strike::findDistanceField(const SkGlyph& glyph, size_t* memoryUsed) {
+    if (NULL == glyph.fDistanceField) {
+        size_t  size = SkComputeDistanceFieldSize(glyph.fWidth, glyph.fHeight);
+        if (size == 0) {
+            return NULL;
+        }
+        const void* image = this->findImage(glyph, memoryUsed);
+        // now generate the distance field
+        if (NULL != image) {
+            unsigned char* field = (unsigned char*)fGlyphAlloc.alloc(size,
+                                        SkChunkAlloc::kReturnNil_AllocFailType);
+            if (NULL != field) {
+                SkMask::Format maskFormat = static_cast<SkMask::Format>(glyph.fMaskFormat);
+                if (SkMask::kA8_Format == maskFormat) {
+                    // make the distance field from the image
+                    SkGenerateDistanceFieldFromA8Image(field,
+                                                       (unsigned char*)glyph.fImage,
+                                                       glyph.fWidth, glyph.fHeight,
+                                                       glyph.rowBytes());
+                    *memoryUsed += size;
+                } else if (SkMask::kBW_Format == maskFormat) {
+                    // make the distance field from the image
+                    SkGenerateDistanceFieldFromBWImage(field,
+                                                       (unsigned char*)glyph.fImage,
+                                                       glyph.fWidth, glyph.fHeight,
+                                                       glyph.rowBytes());
+                    *memoryUsed += size;
+                } else {
+                    fGlyphAlloc.unalloc(field);
+                    field = NULL;
+                }
+                if (NULL != field) {
+                    sk_release_store(&const_cast<SkGlyph&>(glyph).fDistanceField, (void*)field);
                 }
             }
         }
@@ -405,6 +549,288 @@ const void* SkGlyphCache::findDistanceField(const SkGlyph& glyph) {
 
 ///////////////////////////////////////////////////////////////////////////////
 
+SkGlyph* SkGlyphCache::Strike::addMetrics(const SkGlyph& generated, size_t* memoryUsed) {
+    SkASSERT(generated.isFullMetrics());
+    int index = this->findIndex(generated.fID);
+    if (index < fGlyphArray.count() && fGlyphArray[index]->fID == generated.fID) {
+        SkGlyph* glyph = fGlyphArray[index];
+        if (glyph->isJustAdvance()) {
+            PublishFullMetrics(generated, glyph);
+        }
+        return glyph;
+    }
+
+    *memoryUsed += sizeof(SkGlyph);
+    SkGlyph* glyph = (SkGlyph*)fGlyphAlloc.alloc(sizeof(SkGlyph),
+                                                 SkChunkAlloc::kThrow_AllocFailType);
+    *glyph = generated;
+    glyph->fImage = NULL;
+    glyph->fPath = NULL;
+    glyph->fDistanceField = NULL;
+    *fGlyphArray.insert(index) = glyph;
+    return glyph;
+}
+
+void SkGlyphCache::Strike::addImage(const SkGlyph& glyph, const void* image,
+                                    size_t* memoryUsed) {
+    if (NULL != glyph.fImage) {
+        return;
+    }
+    size_t size = glyph.computeImageSize();
+    void* copy = fGlyphAlloc.alloc(size, SkChunkAlloc::kReturnNil_AllocFailType);
+    if (NULL != copy) {
+        memcpy(copy, image, size);
+        sk_release_store(&const_cast<SkGlyph&>(glyph).fImage, copy);
+        *memoryUsed += size;
+    }
+}
+
+void SkGlyphCache::Strike::addPath(const SkGlyph& glyph, SkPath* path, size_t* memoryUsed) {
+    if (NULL != glyph.fPath) {
+        SkDELETE(path);
+        return;
+    }
+    *memoryUsed += sizeof(SkPath) + path->countPoints() * sizeof(SkPoint);
+    sk_release_store(&const_cast<SkGlyph&>(glyph).fPath, path);
+}
+
+// Don't bother making a scaler context for a task with fewer glyphs than this.
+static const int kMinPrewarmGlyphsPerTask = 16;
+
+static bool wants_image(const SkGlyph& glyph) {
+    return glyph.fWidth > 0 && glyph.fWidth < kMaxGlyphWidth;
+}
+
+// Whether glyph already has everything flags asks prewarmGlyphIDs() for.  This doesn't lock, so
+// it may miss a field another thread just added, but then we only check again under the lock.
+static bool is_prewarmed(const SkGlyph* glyph, unsigned flags) {
+    if (needs_metrics(glyph)) {
+        return false;
+    }
+    SkGlyph* g = const_cast<SkGlyph*>(glyph);
+    if ((flags & SkGlyphCache::kImage_PrewarmFlag) && wants_image(*glyph) &&
+            NULL == sk_acquire_load(&g->fImage)) {
+        return false;
+    }
+    if ((flags & SkGlyphCache::kPath_PrewarmFlag) && glyph->fWidth &&
+            NULL == sk_acquire_load(&g->fPath)) {
+        return false;
+    }
+    if ((flags & SkGlyphCache::kDistanceField_PrewarmFlag) && wants_image(*glyph) &&
+            NULL == sk_acquire_load(&g->fDistanceField)) {
+        return false;
+    }
+    return true;
+}
+
+// What a prewarm task generates for one glyph, for the strike to copy in afterwards.
+struct SkGlyphCache::PrewarmGlyph {
+    SkGlyph fGlyph;
+    void*   fImage;     // sk_malloc'd
+    SkPath* fPath;
+};
+
+// Generates a run of PrewarmGlyphs with a scaler context of its own, so it need not lock the
+// strike, and can run alongside other tasks for the same strike.
+class SkGlyphCache::PrewarmTask : public SkRunnable {
+public:
+    void set(const Strike* strike, PrewarmGlyph* glyphs, int count, unsigned flags) {
+        fStrike = strike;
+        fGlyphs = glyphs;
+        fCount = count;
+        fFlags = flags;
+    }
+
+    virtual void run() SK_OVERRIDE {
+        // The typeface and descriptor never change, so we may read them without the lock.
+        SkTypeface* typeface = fStrike->fScalerContext->getTypeface();
+        SkAutoTDelete<SkScalerContext> ctx(typeface->createScalerContext(fStrike->fDesc, true));
+        if (NULL == ctx.get()) {
+            return;     // These glyphs will be generated as they're drawn instead.
+        }
+        for (int i = 0; i < fCount; ++i) {
+            PrewarmGlyph* pg = &fGlyphs[i];
+            ctx->getMetrics(&pg->fGlyph);
+            if ((fFlags & kImage_PrewarmFlag) && wants_image(pg->fGlyph)) {
+                pg->fImage = sk_malloc_flags(pg->fGlyph.computeImageSize(), 0);
+                if (NULL != pg->fImage) {
+                    SkGlyph tmp = pg->fGlyph;
+                    tmp.fImage = pg->fImage;
+                    ctx->getImage(tmp);
+                }
+            }
+            if ((fFlags & kPath_PrewarmFlag) && pg->fGlyph.fWidth) {
+                pg->fPath = SkNEW(SkPath);
+                ctx->getPath(pg->fGlyph, pg->fPath);
+            }
+        }
+    }
+
+private:
+    const Strike* fStrike;
+    PrewarmGlyph* fGlyphs;
+    int           fCount;
+    unsigned      fFlags;
+};
+
+void SkGlyphCache::prewarmGlyphIDs(const uint16_t glyphIDs[], int count, unsigned flags,
+                                   SkTaskScheduler* scheduler) {
+    VALIDATE();
+    if (NULL == scheduler) {
+        for (int i = 0; i < count; ++i) {
+            const SkGlyph& glyph = this->getGlyphIDMetrics(glyphIDs[i]);
+            if (flags & kImage_PrewarmFlag) {
+                this->findImage(glyph);
+            }
+            if (flags & kPath_PrewarmFlag) {
+                this->findPath(glyph);
+            }
+            if (flags & kDistanceField_PrewarmFlag) {
+                this->findDistanceField(glyph);
+            }
+        }
+        return;
+    }
+    if (flags & kDistanceField_PrewarmFlag) {
+        flags |= kImage_PrewarmFlag;
+    }
+
+    // Text drawn again finds its glyphs done in our own hash, and needn't lock or sort anything.
+    SkTDArray<uint16_t> ids;
+    for (int i = 0; i < count; ++i) {
+        uint32_t id = SkGlyph::MakeID(glyphIDs[i]);
+        const SkGlyph* glyph = fGlyphHash[ID2HashIndex(id)];
+        if (NULL == glyph || glyph->fID != id || !is_prewarmed(glyph, flags)) {
+            *ids.append() = glyphIDs[i];
+        }
+    }
+    if (ids.isEmpty()) {
+        return;
+    }
+    if (ids.count() > 1) {
+        SkTQSort(ids.begin(), ids.end() - 1);
+    }
+
+    // Find the glyphs that are missing something we were asked for.
+    SkTDArray<PrewarmGlyph> work;
+    {
+        SkAutoMutexAcquire lock(fStrike->fMutex);
+        for (int i = 0; i < ids.count(); ++i) {
+            if (i > 0 && ids[i] == ids[i - 1]) {
+                continue;
+            }
+            uint32_t id = SkGlyph::MakeID(ids[i]);
+            int index = fStrike->findIndex(id);
+            if (index < fStrike->fGlyphArray.count() && fStrike->fGlyphArray[index]->fID == id) {
+                const SkGlyph* glyph = fStrike->fGlyphArray[index];
+                if (!glyph->isJustAdvance() &&
+                    (!(flags & kImage_PrewarmFlag) || glyph->fImage || !wants_image(*glyph)) &&
+                    (!(flags & kPath_PrewarmFlag) || glyph->fPath || !glyph->fWidth)) {
+                    continue;
+                }
+            }
+            PrewarmGlyph* pg = work.append();
+            pg->fGlyph.init(id);
+            pg->fImage = NULL;
+            pg->fPath = NULL;
+        }
+    }
+    if (!work.isEmpty()) {
+        int taskCount = SkTMin(SkTMax(scheduler->threadCount(), 1),
+                               SkTMax(work.count() / kMinPrewarmGlyphsPerTask, 1));
+        SkAutoTArray<PrewarmTask> tasks(taskCount);
+        SkTaskGroup group(scheduler);
+        for (int i = 0, start = 0; i < taskCount; ++i) {
+            int stop = (i + 1) * work.count() / taskCount;
+            tasks[i].set(fStrike, &work[start], stop - start, flags);
+            group.add(&tasks[i]);
+            start = stop;
+        }
+        group.wait();
+
+        SkAutoMutexAcquire lock(fStrike->fMutex);
+        for (int i = 0; i < work.count(); ++i) {
+            PrewarmGlyph* pg = &work[i];
+            if (pg->fGlyph.isFullMetrics()) {
+                const SkGlyph* glyph = fStrike->addMetrics(pg->fGlyph, &fMemoryUsed);
+                if (NULL != pg->fImage) {
+                    SkASSERT(glyph->computeImageSize() == pg->fGlyph.computeImageSize());
+                    fStrike->addImage(*glyph, pg->fImage, &fMemoryUsed);
+                }
+                if (NULL != pg->fPath) {
+                    fStrike->addPath(*glyph, pg->fPath, &fMemoryUsed);
+                }
+            }
+            sk_free(pg->fImage);
+        }
+    }
+
+    if (flags & kDistanceField_PrewarmFlag) {
+        this->prewarmDistanceFields(ids, scheduler);
+    }
+}
+
+// Every glyph in ids has its image by now, if it can have one.
+void SkGlyphCache::prewarmDistanceFields(const SkTDArray<uint16_t>& ids,
+                                         SkTaskScheduler* scheduler) {
+    // Space for the fields is allocated up front, but they aren't published until they're done.
+    SkTDArray<SkDistanceFieldRequest> requests;
+    SkTDArray<const SkGlyph*> glyphs;
+    {
+        SkAutoMutexAcquire lock(fStrike->fMutex);
+        for (int i = 0; i < ids.count(); ++i) {
+            if (i > 0 && ids[i] == ids[i - 1]) {
+                continue;
+            }
+            uint32_t id = SkGlyph::MakeID(ids[i]);
+            int index = fStrike->findIndex(id);
+            if (index == fStrike->fGlyphArray.count() || fStrike->fGlyphArray[index]->fID != id) {
+                continue;
+            }
+            const SkGlyph* glyph = fStrike->fGlyphArray[index];
+            if (!wants_image(*glyph) || NULL == glyph->fImage ||
+                NULL != glyph->fDistanceField) {
+                continue;
+            }
+            if (SkMask::kA8_Format != glyph->fMaskFormat) {
+                // Only A8 images are batched; anything else is done here, or not at all.
+                fStrike->findDistanceField(*glyph, &fMemoryUsed);
+                continue;
+            }
+            void* field = fStrike->fGlyphAlloc.alloc(
+                    SkComputeDistanceFieldSize(glyph->fWidth, glyph->fHeight),
+                    SkChunkAlloc::kReturnNil_AllocFailType);
+            if (NULL == field) {
+                continue;
+            }
+            SkDistanceFieldRequest* request = requests.append();
+            request->fDistanceField = (unsigned char*)field;
+            request->fImage = (const unsigned char*)glyph->fImage;
+            request->fWidth = glyph->fWidth;
+            request->fHeight = glyph->fHeight;
+            request->fRowBytes = glyph->rowBytes();
+            *glyphs.append() = glyph;
+        }
+    }
+    if (requests.isEmpty()) {
+        return;
+    }
+
+    SkGenerateDistanceFieldsFromA8Images(requests.begin(), requests.count(), scheduler);
+
+    SkAutoMutexAcquire lock(fStrike->fMutex);
+    for (int i = 0; i < glyphs.count(); ++i) {
+        // If someone drew the glyph meanwhile, it has a field already, and ours goes to waste.
+        if (NULL == glyphs[i]->fDistanceField) {
+            fMemoryUsed += SkComputeDistanceFieldSize(glyphs[i]->fWidth, glyphs[i]->fHeight);
+            sk_release_store(&const_cast<SkGlyph*>(glyphs[i])->fDistanceField,
+                             (void*)requests[i].fDistanceField);
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 bool SkGlyphCache::getAuxProcData(void (*proc)(void*), void** dataPtr) const {
     const AuxProcRec* rec = fAuxProcList;
     while (rec) {
@@ -453,7 +879,17 @@ void SkGlyphCache::invokeAndRemoveAuxProcs() {
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
-#include "SkThread.h"
+SkGlyphCache_Globals::~SkGlyphCache_Globals() {
+    SkGlyphCache* cache = fHead;
+    while (cache) {
+        SkGlyphCache* next = cache->fNext;
+        this->internalDeleteCache(cache);
+        cache = next;
+    }
+    SkASSERT(NULL == fStrikeHead);
+
+    SkDELETE(fMutex);
+}
 
 size_t SkGlyphCache_Globals::setCacheSizeLimit(size_t newLimit) {
     static const size_t minLimit = 256 * 1024;
@@ -527,17 +963,30 @@ SkGlyphCache* SkGlyphCache::VisitCache(SkTypeface* typeface,
     globals.validate();
 
     for (cache = globals.internalGetHead(); cache != NULL; cache = cache->fNext) {
-        if (cache->fDesc->equals(*desc)) {
+        if (cache->getDescriptor().equals(*desc)) {
             globals.internalDetachCache(cache);
             goto FOUND_IT;
         }
     }
 
-    /* Release the mutex now, before we create a new entry (which might have
-        side-effects like trying to access the cache/mutex (yikes!)
-    */
-    ac.release();           // release the mutex now
-    insideMutex = false;    // can't use globals anymore
+    {
+        // Every cache for desc is in use, but we can share their glyphs.
+        SkGlyphCache::Strike* strike = globals.internalFindStrike(*desc);
+        if (strike) {
+            strike->fCacheCount += 1;  // Now it can't go away.
+        }
+
+        /* Release the mutex now, before we create a new entry (which might have
+            side-effects like trying to access the cache/mutex (yikes!)
+        */
+        ac.release();           // release the mutex now
+        insideMutex = false;    // can't use globals anymore
+
+        if (strike) {
+            cache = SkNEW_ARGS(SkGlyphCache, (strike));
+            goto FOUND_IT;
+        }
+    }
 
     // Check if we can create a scaler-context before creating the glyphcache.
     // If not, we may have exhausted OS/font resources, so try purging the
@@ -551,7 +1000,10 @@ SkGlyphCache* SkGlyphCache::VisitCache(SkTypeface* typeface,
             ctx = typeface->createScalerContext(desc, false);
             SkASSERT(ctx);
         }
-        cache = SkNEW_ARGS(SkGlyphCache, (typeface, desc, ctx));
+        SkGlyphCache::Strike* strike = SkNEW_ARGS(SkGlyphCache::Strike, (desc, ctx));
+        cache = SkNEW_ARGS(SkGlyphCache, (strike));
+        cache->fMemoryUsed += sizeof(SkGlyphCache::Strike);
+        globals.addStrike(strike);
     }
 
 FOUND_IT:
@@ -632,11 +1084,13 @@ size_t SkGlyphCache_Globals::internalPurge(size_t minBytesNeeded) {
     while (cache != NULL &&
            (bytesFreed < bytesNeeded || countFreed < countNeeded)) {
         SkGlyphCache* prev = cache->fPrev;
-        bytesFreed += cache->fMemoryUsed;
+        const size_t before = fTotalMemoryUsed;
         countFreed += 1;
 
         this->internalDetachCache(cache);
-        SkDELETE(cache);
+        this->internalDeleteCache(cache);
+        // If another cache still shares its glyphs, this frees less than cache->fMemoryUsed.
+        bytesFreed += before - fTotalMemoryUsed;
         cache = prev;
     }
 
@@ -680,22 +1134,71 @@ void SkGlyphCache_Globals::internalDetachCache(SkGlyphCache* cache) {
     cache->fPrev = cache->fNext = NULL;
 }
 
+void SkGlyphCache_Globals::internalDeleteCache(SkGlyphCache* cache) {
+    SkASSERT(NULL == cache->fPrev && NULL == cache->fNext);
+    SkGlyphCache::Strike* strike = cache->fStrike;
+    const size_t orphaned = cache->fMemoryUsed - sizeof(SkGlyphCache);
+    SkDELETE(cache);
+
+    SkASSERT(strike->fCacheCount > 0);
+    if (--strike->fCacheCount > 0) {
+        // The glyphs we allocated live on with the other caches.
+        strike->fOrphanedMemory += orphaned;
+        fTotalMemoryUsed += orphaned;
+        return;
+    }
+
+    fTotalMemoryUsed -= strike->fOrphanedMemory;
+    if (strike->fPrev) {
+        strike->fPrev->fNext = strike->fNext;
+    } else {
+        fStrikeHead = strike->fNext;
+    }
+    if (strike->fNext) {
+        strike->fNext->fPrev = strike->fPrev;
+    }
+    SkDELETE(strike);
+}
+
+SkGlyphCache::Strike* SkGlyphCache_Globals::internalFindStrike(const SkDescriptor& desc) const {
+    for (SkGlyphCache::Strike* strike = fStrikeHead; strike != NULL; strike = strike->fNext) {
+        if (strike->fDesc->equals(desc)) {
+            return strike;
+        }
+    }
+    return NULL;
+}
+
+void SkGlyphCache_Globals::addStrike(SkGlyphCache::Strike* strike) {
+    SkAutoMutexAcquire    ac(fMutex);
+
+    // We may race with another thread adding a strike for the same descriptor.
+    // That's fine; we'll just find theirs first from now on.
+    strike->fPrev = NULL;
+    strike->fNext = fStrikeHead;
+    if (fStrikeHead) {
+        fStrikeHead->fPrev = strike;
+    }
+    fStrikeHead = strike;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 #ifdef SK_DEBUG
 
 void SkGlyphCache::validate() const {
 #ifdef SK_DEBUG_GLYPH_CACHE
-    int count = fGlyphArray.count();
+    SkAutoMutexAcquire lock(fStrike->fMutex);
+    int count = fStrike->fGlyphArray.count();
     for (int i = 0; i < count; i++) {
-        const SkGlyph* glyph = fGlyphArray[i];
+        const SkGlyph* glyph = fStrike->fGlyphArray[i];
         SkASSERT(glyph);
-        SkASSERT(fGlyphAlloc.contains(glyph));
+        SkASSERT(fStrike->fGlyphAlloc.contains(glyph));
         if (glyph->fImage) {
-            SkASSERT(fGlyphAlloc.contains(glyph->fImage));
+            SkASSERT(fStrike->fGlyphAlloc.contains(glyph->fImage));
         }
         if (glyph->fDistanceField) {
-            SkASSERT(fGlyphAlloc.contains(glyph->fDistanceField));
+            SkASSERT(fStrike->fGlyphAlloc.contains(glyph->fDistanceField));
         }
     }
 #endif
@@ -711,6 +1214,10 @@ void SkGlyphCache_Globals::validate() const {
         computedCount += 1;
         head = head->fNext;
     }
+    for (const SkGlyphCache::Strike* strike = fStrikeHead; strike; strike = strike->fNext) {
+        SkASSERT(strike->fCacheCount > 0);
+        computedBytes += strike->fOrphanedMemory;
+    }
 
     SkASSERT(fTotalMemoryUsed == computedBytes);
     SkASSERT(fCacheCount == computedCount);
@@ -721,6 +1228,7 @@ void SkGlyphCache_Globals::validate() const {
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
+#include "SkTextMeasureCache.h"
 #include "SkTypefaceCache.h"
 
 size_t SkGraphics::GetFontCacheLimit() {
@@ -750,6 +1258,7 @@ int SkGraphics::GetFontCacheCountUsed() {
 void SkGraphics::PurgeFontCache() {
     getSharedGlobals().purgeAll();
     SkTypefaceCache::PurgeAll();
+    SkTextMeasureCache::PurgeAll();
 }
 
 size_t SkGraphics::GetTLSFontCacheLimit() {
@@ -22,6 +22,7 @@ struct SkDeviceProperties;
 class SkPaint;
 
 class SkGlyphCache_Globals;
+class SkTaskScheduler;
 
 /** \class SkGlyphCache
 
@@ -33,6 +34,12 @@ class SkGlyphCache_Globals;
 
     The strikes are held in a global list, available to all threads. To interact
     with one, call either VisitCache() or DetachCache().
+
+    Each SkGlyphCache is used by one thread at a time, but several may share the
+    same glyphs (and scaler context) for a descriptor. Glyphs a cache has seen
+    before are found in its own hash tables without locking; only creating a
+    glyph, or generating its image or path, locks the glyphs shared by all the
+    caches for that descriptor.
 */
 class SkGlyphCache {
 public:
@@ -67,6 +74,21 @@ public:
     */
     uint16_t unicharToGlyph(SkUnichar);
 
+    /** Return the glyphIDs for unichars 0-255, indexed by unichar, from the
+        typeface's cmap cache. Returns NULL where a strike may map unichars
+        differently from its typeface, as with Android's fallback fonts.
+    */
+#ifdef SK_BUILD_FOR_ANDROID
+    const uint16_t* getLatin1Glyphs() { return NULL; }
+#else
+    const uint16_t* getLatin1Glyphs() {
+        if (NULL == fLatin1Glyphs) {
+            fLatin1Glyphs = this->findLatin1Glyphs();
+        }
+        return fLatin1Glyphs;
+    }
+#endif
+
     /** Map the glyph to its Unicode equivalent. Unmappable glyphs map to
         a character code of zero.
     */
@@ -79,9 +101,7 @@ public:
 #ifdef SK_BUILD_FOR_ANDROID
     /** Returns the base glyph count for this strike.
     */
-    unsigned getBaseGlyphCount(SkUnichar charCode) const {
-        return fScalerContext->getBaseGlyphCount(charCode);
-    }
+    unsigned getBaseGlyphCount(SkUnichar charCode) const;
 #endif
 
     /** Return the image associated with the glyph. If it has not been generated
@@ -97,20 +117,40 @@ public:
      */
     const void* findDistanceField(const SkGlyph&);
 
+    enum PrewarmFlags {
+        kImage_PrewarmFlag          = 1 << 0,
+        kPath_PrewarmFlag           = 1 << 1,
+        kDistanceField_PrewarmFlag  = 1 << 2,   // Implies kImage_PrewarmFlag.
+    };
+
+    /** Generate, all at once, the full metrics of each of the glyphIDs, and
+        their images, paths and/or distance fields as flags asks, so that
+        drawing them later finds them in the strike. Glyphs that already have
+        them are skipped.
+
+        If scheduler is not NULL, the work is split among its threads, each
+        with a scaler context of its own, and the strike is only locked to add
+        the results. The distance fields are then made from the images in one
+        batch, also on the scheduler's threads. Otherwise the glyphs are
+        generated here, one after the other.
+
+        Only the glyphs drawn without subpixel positioning are prewarmed.
+    */
+    void prewarmGlyphIDs(const uint16_t glyphIDs[], int count, unsigned flags,
+                         SkTaskScheduler* scheduler);
+
     /** Return the vertical metrics for this strike.
     */
-    const SkPaint::FontMetrics& getFontMetrics() const {
-        return fFontMetrics;
-    }
+    const SkPaint::FontMetrics& getFontMetrics() const;
 
-    const SkDescriptor& getDescriptor() const { return *fDesc; }
+    const SkDescriptor& getDescriptor() const;
 
     SkMask::Format getMaskFormat() const {
-        return fScalerContext->getMaskFormat();
+        return this->getScalerContext()->getMaskFormat();
     }
 
     bool isSubpixel() const {
-        return fScalerContext->isSubpixel();
+        return this->getScalerContext()->isSubpixel();
     }
 
     /*  AuxProc/Data allow a client to associate data with this cache entry.
@@ -127,7 +167,10 @@ public:
     //! Add a proc/data pair to the glyphcache. proc should be non-null
     void setAuxProc(void (*auxProc)(void*), void* auxData);
 
-    SkScalerContext* getScalerContext() const { return fScalerContext; }
+    /** The scaler context may be shared with other threads' caches.  Only
+        call its const methods, or those that don't generate glyphs.
+    */
+    SkScalerContext* getScalerContext() const;
 
     /** Call proc on all cache entries, stopping early if proc returns true.
         The proc should not create or delete caches, since it could produce
@@ -153,10 +196,9 @@ public:
         Once detached, it can be queried/modified by the current thread, and
         when finished, be reattached to the global cache with AttachCache().
         While detached, if another request is made with the same descriptor,
-        a different strike will be generated. This is fine. It does mean we
-        can have more than 1 strike for the same descriptor, but that will
-        eventually get purged, and the win is that different thread will never
-        block each other while a strike is being used.
+        a different SkGlyphCache will be returned, sharing the first one's
+        glyphs. The two only contend when one of them needs a glyph neither
+        has generated yet, and extra caches eventually get purged.
     */
     static SkGlyphCache* DetachCache(SkTypeface* typeface,
                                      const SkDescriptor* desc) {
@@ -189,8 +231,10 @@ public:
     };
 
 private:
-    // we take ownership of the scalercontext
-    SkGlyphCache(SkTypeface*, const SkDescriptor*, SkScalerContext*);
+    struct Strike;
+
+    // we share ownership of the strike with any other caches using it
+    SkGlyphCache(Strike*);
     ~SkGlyphCache();
 
     enum MetricsType {
@@ -198,13 +242,18 @@ private:
         kFull_MetricsType
     };
 
+    struct PrewarmGlyph;
+    class PrewarmTask;
+    void prewarmDistanceFields(const SkTDArray<uint16_t>& sortedIDs, SkTaskScheduler*);
+
+    // These lock fStrike.
     SkGlyph* lookupMetrics(uint32_t id, MetricsType);
+    SkGlyph* lookupUnicharMetrics(SkUnichar, SkFixed x, SkFixed y, MetricsType);
+    SkGlyph* upgradeMetrics(SkGlyph*);
     static bool DetachProc(const SkGlyphCache*, void*) { return true; }
 
     SkGlyphCache*       fNext, *fPrev;
-    SkDescriptor*       fDesc;
-    SkScalerContext*    fScalerContext;
-    SkPaint::FontMetrics fFontMetrics;
+    Strike*             fStrike;
 
     enum {
         kHashBits   = 8,
@@ -212,8 +261,6 @@ private:
         kHashMask   = kHashCount - 1
     };
     SkGlyph*            fGlyphHash[kHashCount];
-    SkTDArray<SkGlyph*> fGlyphArray;
-    SkChunkAlloc        fGlyphAlloc;
 
     struct CharGlyphRec {
         uint32_t    fID;    // unichar + subpixel
@@ -228,7 +275,8 @@ private:
         return id & kHashMask;
     }
 
-    // used to track (approx) how much ram is tied-up in this cache
+    // used to track (approx) how much ram is tied-up in this cache, including
+    // the shared glyphs it caused to be allocated
     size_t  fMemoryUsed;
 
     struct AuxProcRec {
@@ -239,6 +287,9 @@ private:
     AuxProcRec* fAuxProcList;
     void invokeAndRemoveAuxProcs();
 
+    const uint16_t* fLatin1Glyphs;  // Owned by the typeface's cmap cache.
+    const uint16_t* findLatin1Glyphs() const;
+
     inline static SkGlyphCache* FindTail(SkGlyphCache* head);
 
     friend class SkGlyphCache_Globals;
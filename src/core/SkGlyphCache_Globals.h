@@ -32,6 +32,7 @@ public:
 
     SkGlyphCache_Globals(UseMutex um) {
         fHead = NULL;
+        fStrikeHead = NULL;
         fTotalMemoryUsed = 0;
         fCacheSizeLimit = SK_DEFAULT_FONT_CACHE_LIMIT;
         fCacheCount = 0;
@@ -40,16 +41,7 @@ public:
         fMutex = (kYes_UseMutex == um) ? SkNEW(SkMutex) : NULL;
     }
 
-    ~SkGlyphCache_Globals() {
-        SkGlyphCache* cache = fHead;
-        while (cache) {
-            SkGlyphCache* next = cache->fNext;
-            SkDELETE(cache);
-            cache = next;
-        }
-
-        SkDELETE(fMutex);
-    }
+    ~SkGlyphCache_Globals();
 
     SkMutex*        fMutex;
 
@@ -83,9 +75,15 @@ public:
     // call when a glyphcache is available for caching (i.e. not in use)
     void attachCacheToHead(SkGlyphCache*);
 
+    // call with a new strike, already used by one glyphcache
+    void addStrike(SkGlyphCache::Strike*);
+
     // can only be called when the mutex is already held
     void internalDetachCache(SkGlyphCache*);
     void internalAttachCacheToHead(SkGlyphCache*);
+    // deletes a detached glyphcache, and its strike if no other glyphcache shares it
+    void internalDeleteCache(SkGlyphCache*);
+    SkGlyphCache::Strike* internalFindStrike(const SkDescriptor&) const;
 
     // can return NULL
     static SkGlyphCache_Globals* FindTLS() {
@@ -100,6 +98,8 @@ public:
 
 private:
     SkGlyphCache* fHead;
+    SkGlyphCache::Strike* fStrikeHead;  // every strike used by a glyphcache we've seen
+    // includes memory charged to deleted glyphcaches whose strikes live on
     size_t  fTotalMemoryUsed;
     size_t  fCacheSizeLimit;
     int32_t fCacheCountLimit;
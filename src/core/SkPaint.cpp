@@ -28,7 +28,9 @@
 #include "SkShader.h"
 #include "SkStringUtils.h"
 #include "SkStroke.h"
+#include "SkTDArray.h"
 #include "SkTextFormatParams.h"
+#include "SkTextMeasureCache.h"
 #include "SkTextToPathIter.h"
 #include "SkTLazy.h"
 #include "SkTypeface.h"
@@ -526,6 +528,21 @@ static void DetachDescProc(SkTypeface* typeface, const SkDescriptor* desc,
     *((SkGlyphCache**)context) = SkGlyphCache::DetachCache(typeface, desc);
 }
 
+#ifndef SK_BUILD_FOR_ANDROID
+// Without fallback fonts, a strike maps unichars to glyphs just as its typeface does, so rather
+// than finding a strike and going through it a unichar at a time, we let the typeface's cmap
+// cache convert the whole text at once.
+static SkTypeface::Encoding paint_to_typeface_encoding(const SkPaint& paint) {
+    SK_COMPILE_ASSERT((int)SkPaint::kUTF8_TextEncoding == (int)SkTypeface::kUTF8_Encoding,
+                      utf8_encodings_match);
+    SK_COMPILE_ASSERT((int)SkPaint::kUTF16_TextEncoding == (int)SkTypeface::kUTF16_Encoding,
+                      utf16_encodings_match);
+    SK_COMPILE_ASSERT((int)SkPaint::kUTF32_TextEncoding == (int)SkTypeface::kUTF32_Encoding,
+                      utf32_encodings_match);
+    return (SkTypeface::Encoding)paint.getTextEncoding();
+}
+#endif
+
 int SkPaint::textToGlyphs(const void* textData, size_t byteLength,
                           uint16_t glyphs[]) const {
     if (byteLength == 0) {
@@ -559,6 +576,12 @@ int SkPaint::textToGlyphs(const void* textData, size_t byteLength,
         return SkToInt(byteLength >> 1);
     }
 
+#ifndef SK_BUILD_FOR_ANDROID
+    SkTypeface* typeface = fTypeface ? fTypeface : SkTypeface::GetDefaultTypeface();
+    int count = this->countText(textData, byteLength);
+    typeface->charsToGlyphs(textData, paint_to_typeface_encoding(*this), glyphs, count);
+    return count;
+#else
     SkAutoGlyphCache autoCache(*this, NULL, NULL);
     SkGlyphCache*    cache = autoCache.getCache();
 
@@ -592,6 +615,7 @@ int SkPaint::textToGlyphs(const void* textData, size_t byteLength,
             SkDEBUGFAIL("unknown text encoding");
     }
     return SkToInt(gptr - glyphs);
+#endif
 }
 
 bool SkPaint::containsText(const void* textData, size_t byteLength) const {
@@ -613,6 +637,12 @@ bool SkPaint::containsText(const void* textData, size_t byteLength) const {
         return true;
     }
 
+#ifndef SK_BUILD_FOR_ANDROID
+    SkTypeface* typeface = fTypeface ? fTypeface : SkTypeface::GetDefaultTypeface();
+    int count = this->countText(textData, byteLength);
+    return typeface->charsToGlyphs(textData, paint_to_typeface_encoding(*this),
+                                   NULL, count) == count;
+#else
     SkAutoGlyphCache autoCache(*this, NULL, NULL);
     SkGlyphCache*    cache = autoCache.getCache();
 
@@ -652,6 +682,7 @@ bool SkPaint::containsText(const void* textData, size_t byteLength) const {
             return false;
     }
     return true;
+#endif
 }
 
 void SkPaint::glyphsToUnichars(const uint16_t glyphs[], int count,
@@ -673,11 +704,61 @@ void SkPaint::glyphsToUnichars(const uint16_t glyphs[], int count,
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// ASCII UTF-8 and Latin-1 UTF-16 skip the strike's unichar hash: the typeface's cmap cache gives
+// their glyph IDs directly.  Each returns false, leaving *text alone, for any other unichar.
+static bool latin1_glyph_utf8_next(SkGlyphCache* cache, const char** text, uint16_t* glyphID) {
+    const uint8_t c = *(const uint8_t*)*text;
+    const uint16_t* latin1 = c < 0x80 ? cache->getLatin1Glyphs() : NULL;
+    if (NULL == latin1) {
+        return false;
+    }
+    *text += 1;
+    *glyphID = latin1[c];
+    return true;
+}
+
+static bool latin1_glyph_utf8_prev(SkGlyphCache* cache, const char** text, uint16_t* glyphID) {
+    const uint8_t c = ((const uint8_t*)*text)[-1];
+    const uint16_t* latin1 = c < 0x80 ? cache->getLatin1Glyphs() : NULL;
+    if (NULL == latin1) {
+        return false;
+    }
+    *text -= 1;
+    *glyphID = latin1[c];
+    return true;
+}
+
+static bool latin1_glyph_utf16_next(SkGlyphCache* cache, const char** text, uint16_t* glyphID) {
+    const uint16_t c = *(const uint16_t*)*text;
+    const uint16_t* latin1 = c < 0x100 ? cache->getLatin1Glyphs() : NULL;
+    if (NULL == latin1) {
+        return false;
+    }
+    *text += sizeof(uint16_t);
+    *glyphID = latin1[c];
+    return true;
+}
+
+static bool latin1_glyph_utf16_prev(SkGlyphCache* cache, const char** text, uint16_t* glyphID) {
+    const uint16_t c = ((const uint16_t*)*text)[-1];
+    const uint16_t* latin1 = c < 0x100 ? cache->getLatin1Glyphs() : NULL;
+    if (NULL == latin1) {
+        return false;
+    }
+    *text -= sizeof(uint16_t);
+    *glyphID = latin1[c];
+    return true;
+}
+
 static const SkGlyph& sk_getMetrics_utf8_next(SkGlyphCache* cache,
                                               const char** text) {
     SkASSERT(cache != NULL);
     SkASSERT(text != NULL);
 
+    uint16_t glyphID;
+    if (latin1_glyph_utf8_next(cache, text, &glyphID)) {
+        return cache->getGlyphIDMetrics(glyphID);
+    }
     return cache->getUnicharMetrics(SkUTF8_NextUnichar(text));
 }
 
@@ -686,6 +767,10 @@ static const SkGlyph& sk_getMetrics_utf8_prev(SkGlyphCache* cache,
     SkASSERT(cache != NULL);
     SkASSERT(text != NULL);
 
+    uint16_t glyphID;
+    if (latin1_glyph_utf8_prev(cache, text, &glyphID)) {
+        return cache->getGlyphIDMetrics(glyphID);
+    }
     return cache->getUnicharMetrics(SkUTF8_PrevUnichar(text));
 }
 
@@ -694,6 +779,10 @@ static const SkGlyph& sk_getMetrics_utf16_next(SkGlyphCache* cache,
     SkASSERT(cache != NULL);
     SkASSERT(text != NULL);
 
+    uint16_t glyphID;
+    if (latin1_glyph_utf16_next(cache, text, &glyphID)) {
+        return cache->getGlyphIDMetrics(glyphID);
+    }
     return cache->getUnicharMetrics(SkUTF16_NextUnichar((const uint16_t**)text));
 }
 
@@ -702,6 +791,10 @@ static const SkGlyph& sk_getMetrics_utf16_prev(SkGlyphCache* cache,
     SkASSERT(cache != NULL);
     SkASSERT(text != NULL);
 
+    uint16_t glyphID;
+    if (latin1_glyph_utf16_prev(cache, text, &glyphID)) {
+        return cache->getGlyphIDMetrics(glyphID);
+    }
     return cache->getUnicharMetrics(SkUTF16_PrevUnichar((const uint16_t**)text));
 }
 
@@ -756,6 +849,10 @@ static const SkGlyph& sk_getAdvance_utf8_next(SkGlyphCache* cache,
     SkASSERT(cache != NULL);
     SkASSERT(text != NULL);
 
+    uint16_t glyphID;
+    if (latin1_glyph_utf8_next(cache, text, &glyphID)) {
+        return cache->getGlyphIDAdvance(glyphID);
+    }
     return cache->getUnicharAdvance(SkUTF8_NextUnichar(text));
 }
 
@@ -764,6 +861,10 @@ static const SkGlyph& sk_getAdvance_utf8_prev(SkGlyphCache* cache,
     SkASSERT(cache != NULL);
     SkASSERT(text != NULL);
 
+    uint16_t glyphID;
+    if (latin1_glyph_utf8_prev(cache, text, &glyphID)) {
+        return cache->getGlyphIDAdvance(glyphID);
+    }
     return cache->getUnicharAdvance(SkUTF8_PrevUnichar(text));
 }
 
@@ -772,6 +873,10 @@ static const SkGlyph& sk_getAdvance_utf16_next(SkGlyphCache* cache,
     SkASSERT(cache != NULL);
     SkASSERT(text != NULL);
 
+    uint16_t glyphID;
+    if (latin1_glyph_utf16_next(cache, text, &glyphID)) {
+        return cache->getGlyphIDAdvance(glyphID);
+    }
     return cache->getUnicharAdvance(SkUTF16_NextUnichar((const uint16_t**)text));
 }
 
@@ -780,6 +885,10 @@ static const SkGlyph& sk_getAdvance_utf16_prev(SkGlyphCache* cache,
     SkASSERT(cache != NULL);
     SkASSERT(text != NULL);
 
+    uint16_t glyphID;
+    if (latin1_glyph_utf16_prev(cache, text, &glyphID)) {
+        return cache->getGlyphIDAdvance(glyphID);
+    }
     return cache->getUnicharAdvance(SkUTF16_PrevUnichar((const uint16_t**)text));
 }
 
@@ -873,6 +982,10 @@ static const SkGlyph& sk_getMetrics_utf8_00(SkGlyphCache* cache,
     SkASSERT(cache != NULL);
     SkASSERT(text != NULL);
 
+    uint16_t glyphID;
+    if (latin1_glyph_utf8_next(cache, text, &glyphID)) {
+        return cache->getGlyphIDMetrics(glyphID);
+    }
     return cache->getUnicharMetrics(SkUTF8_NextUnichar(text));
 }
 
@@ -881,6 +994,10 @@ static const SkGlyph& sk_getMetrics_utf8_xy(SkGlyphCache* cache,
     SkASSERT(cache != NULL);
     SkASSERT(text != NULL);
 
+    uint16_t glyphID;
+    if (latin1_glyph_utf8_next(cache, text, &glyphID)) {
+        return cache->getGlyphIDMetrics(glyphID, x, y);
+    }
     return cache->getUnicharMetrics(SkUTF8_NextUnichar(text), x, y);
 }
 
@@ -889,6 +1006,10 @@ static const SkGlyph& sk_getMetrics_utf16_00(SkGlyphCache* cache,
     SkASSERT(cache != NULL);
     SkASSERT(text != NULL);
 
+    uint16_t glyphID;
+    if (latin1_glyph_utf16_next(cache, text, &glyphID)) {
+        return cache->getGlyphIDMetrics(glyphID);
+    }
     return cache->getUnicharMetrics(SkUTF16_NextUnichar((const uint16_t**)text));
 }
 
@@ -897,6 +1018,10 @@ static const SkGlyph& sk_getMetrics_utf16_xy(SkGlyphCache* cache,
     SkASSERT(cache != NULL);
     SkASSERT(text != NULL);
 
+    uint16_t glyphID;
+    if (latin1_glyph_utf16_next(cache, text, &glyphID)) {
+        return cache->getGlyphIDMetrics(glyphID, x, y);
+    }
     return cache->getUnicharMetrics(SkUTF16_NextUnichar((const uint16_t**)text),
                                     x, y);
 }
@@ -1131,11 +1256,74 @@ SkScalar SkPaint::measure_text(SkGlyphCache* cache,
     return Sk48Dot16ToScalar(x);
 }
 
+SkTextAdvances* SkPaint::refCachedAdvances(const void* textData, size_t length) const {
+    if (!SkTextMeasureCache::CanCache(length)) {
+        return NULL;
+    }
+    SkTextAdvances* cached = SkTextMeasureCache::Find(*this, textData, length);
+    if (NULL != cached) {
+        return cached;
+    }
+
+    SkCanonicalizePaint canon(*this);
+    const SkPaint& paint = canon.getPaint();
+
+    SkAutoGlyphCache    autoCache(paint, NULL, NULL);
+    SkGlyphCache*       cache = autoCache.getCache();
+    SkMeasureCacheProc  glyphCacheProc = paint.getMeasureCacheProc(kForward_TextBufferDirection,
+                                                                   false);
+    const int           xyIndex = paint.isVerticalText() ? 1 : 0;
+
+    SkTDArray<SkTextAdvances::Advance> advances;
+    const char* text = (const char*)textData;
+    const char* stop = text + length;
+    while (text < stop) {
+        const char* curr = text;
+        const SkGlyph& g = glyphCacheProc(cache, &text);
+        SkTextAdvances::Advance* adv = advances.append();
+        adv->fAdvance = advance(g, xyIndex);
+        adv->fLsbDelta = g.fLsbDelta;
+        adv->fRsbDelta = g.fRsbDelta;
+        adv->fByteLength = SkToU8(text - curr);
+    }
+    return SkTextMeasureCache::Add(*this, textData, length, canon.getScale(),
+                                   paint.isDevKernText(), advances.begin(), advances.count());
+}
+
+// Sums the advances as measure_text() sums the glyphs'.
+static SkScalar measure_advances(const SkTextAdvances& advances) {
+    const int count = advances.count();
+    SkASSERT(count > 0);
+    Sk48Dot16 x = advances[0].fAdvance;
+    if (advances.isDevKernText()) {
+        for (int i = 1; i < count; ++i) {
+            x += SkAutoKern_AdjustF(advances[i - 1].fRsbDelta, advances[i].fLsbDelta) +
+                 advances[i].fAdvance;
+        }
+    } else {
+        for (int i = 1; i < count; ++i) {
+            x += advances[i].fAdvance;
+        }
+    }
+    SkScalar width = Sk48Dot16ToScalar(x);
+    if (advances.scale()) {
+        width = SkScalarMul(width, advances.scale());
+    }
+    return width;
+}
+
 SkScalar SkPaint::measureText(const void* textData, size_t length,
                               SkRect* bounds, SkScalar zoom) const {
     const char* text = (const char*)textData;
     SkASSERT(text != NULL || length == 0);
 
+    if (NULL == bounds && 0 == zoom) {
+        SkAutoTUnref<SkTextAdvances> advances(this->refCachedAdvances(text, length));
+        if (NULL != advances.get()) {
+            return measure_advances(*advances);
+        }
+    }
+
     SkCanonicalizePaint canon(*this);
     const SkPaint& paint = canon.getPaint();
     SkScalar scale = canon.getScale();
@@ -1195,6 +1383,44 @@ static SkTextBufferPred chooseTextBufferPred(SkPaint::TextBufferDirection tbd,
     }
 }
 
+// Breaks the advances as breakText() breaks the glyphs, returning the number of bytes measured.
+static size_t break_advances(const SkTextAdvances& advances, SkScalar maxWidth, bool devKern,
+                             SkScalar* measuredWidth, SkPaint::TextBufferDirection tbd) {
+    const SkScalar scale = advances.scale();
+    if (scale) {
+        maxWidth /= scale;
+    }
+
+    const int   count = advances.count();
+    const bool  forward = SkPaint::kForward_TextBufferDirection == tbd;
+    Sk48Dot16   max = SkScalarToFixed(maxWidth);
+    Sk48Dot16   width = 0;
+    size_t      bytes = 0;
+    int         rsb = 0;
+    for (int i = 0; i < count; ++i) {
+        const SkTextAdvances::Advance& adv = advances[forward ? i : count - 1 - i];
+        SkFixed x = adv.fAdvance;
+        if (devKern) {
+            x += SkAutoKern_AdjustF(rsb, adv.fLsbDelta);
+            rsb = adv.fRsbDelta;
+        }
+        if ((width += x) > max) {
+            width -= x;
+            break;
+        }
+        bytes += adv.fByteLength;
+    }
+
+    if (measuredWidth) {
+        SkScalar scalarWidth = Sk48Dot16ToScalar(width);
+        if (scale) {
+            scalarWidth = SkScalarMul(scalarWidth, scale);
+        }
+        *measuredWidth = scalarWidth;
+    }
+    return bytes;
+}
+
 size_t SkPaint::breakText(const void* textD, size_t length, SkScalar maxWidth,
                           SkScalar* measuredWidth,
                           TextBufferDirection tbd) const {
@@ -1215,6 +1441,11 @@ size_t SkPaint::breakText(const void* textD, size_t length, SkScalar maxWidth,
     SkASSERT(textD != NULL);
     const char* text = (const char*)textD;
 
+    SkAutoTUnref<SkTextAdvances> advances(this->refCachedAdvances(text, length));
+    if (NULL != advances.get()) {
+        return break_advances(*advances, maxWidth, this->isDevKernText(), measuredWidth, tbd);
+    }
+
     SkCanonicalizePaint canon(*this);
     const SkPaint& paint = canon.getPaint();
     SkScalar scale = canon.getScale();
@@ -1330,6 +1561,21 @@ static void set_bounds(const SkGlyph& g, SkRect* bounds, SkScalar scale) {
                 (g.fTop + g.fHeight) * scale);
 }
 
+// Computes the widths as getTextWidths() computes them from the glyphs.
+static int get_advance_widths(const SkTextAdvances& advances, bool devKern, SkScalar widths[]) {
+    const int       count = advances.count();
+    const SkScalar  scale = advances.scale();
+    for (int i = 0; i < count; ++i) {
+        SkFixed w = advances[i].fAdvance;
+        // Auto-kerning adjusts the width of the glyph before.
+        if (devKern && i + 1 < count) {
+            w += SkAutoKern_AdjustF(advances[i].fRsbDelta, advances[i + 1].fLsbDelta);
+        }
+        widths[i] = scale ? SkScalarMul(SkFixedToScalar(w), scale) : SkFixedToScalar(w);
+    }
+    return count;
+}
+
 int SkPaint::getTextWidths(const void* textData, size_t byteLength,
                            SkScalar widths[], SkRect bounds[]) const {
     if (0 == byteLength) {
@@ -1342,6 +1588,13 @@ int SkPaint::getTextWidths(const void* textData, size_t byteLength,
         return this->countText(textData, byteLength);
     }
 
+    if (NULL == bounds) {
+        SkAutoTUnref<SkTextAdvances> advances(this->refCachedAdvances(textData, byteLength));
+        if (NULL != advances.get()) {
+            return get_advance_widths(*advances, this->isDevKernText(), widths);
+        }
+    }
+
     SkCanonicalizePaint canon(*this);
     const SkPaint& paint = canon.getPaint();
     SkScalar scale = canon.getScale();
@@ -2527,6 +2780,39 @@ static bool has_thick_frame(const SkPaint& paint) {
             paint.getStyle() != SkPaint::kFill_Style;
 }
 
+void SkPaint::prewarmText(const void* text, size_t byteLength, const SkMatrix* matrix,
+                          SkTaskScheduler* scheduler) const {
+    int count = this->countText(text, byteLength);
+    if (count <= 0) {
+        return;
+    }
+    SkAutoSTMalloc<128, uint16_t> glyphs(count);
+    this->textToGlyphs(text, byteLength, glyphs.get());
+
+    SkPaint paint(*this);
+    unsigned flags = SkGlyphCache::kImage_PrewarmFlag;
+    if (SkDraw::ShouldDrawTextAsPaths(*this, matrix ? *matrix : SkMatrix::I())) {
+        // Match the strike SkTextToPathIter will draw from.
+        paint.setLinearText(true);
+        paint.setMaskFilter(NULL);
+        if (NULL == paint.getPathEffect()) {
+            SkScalar scale = paint.getTextSize() / kCanonicalTextSizeForPaths;
+            paint.setTextSize(SkIntToScalar(kCanonicalTextSizeForPaths));
+            if (has_thick_frame(paint)) {
+                paint.setStrokeWidth(SkScalarDiv(paint.getStrokeWidth(), scale));
+            }
+        }
+        if (NULL == paint.getPathEffect() && !has_thick_frame(paint)) {
+            paint.setStyle(kFill_Style);
+        }
+        matrix = NULL;
+        flags = SkGlyphCache::kPath_PrewarmFlag;
+    }
+
+    SkAutoGlyphCache autoCache(paint, NULL, matrix);
+    autoCache.getCache()->prewarmGlyphIDs(glyphs.get(), count, flags, scheduler);
+}
+
 SkTextToPathIter::SkTextToPathIter( const char text[], size_t length,
                                     const SkPaint& paint,
                                     bool applyStrokeAndPathEffects)
@@ -662,6 +662,13 @@ void SkPath::incReserve(U16CPU inc) {
     SkDEBUGCODE(this->validate();)
 }
 
+void SkPath::incReserve(int extraVerbCount, int extraPtCount) {
+    SkASSERT(extraVerbCount >= 0 && extraPtCount >= 0);
+    SkDEBUGCODE(this->validate();)
+    SkPathRef::Editor(&fPathRef, extraVerbCount, extraPtCount);
+    SkDEBUGCODE(this->validate();)
+}
+
 void SkPath::moveTo(SkScalar x, SkScalar y) {
     SkDEBUGCODE(this->validate();)
 
@@ -854,25 +861,69 @@ void SkPath::addRect(SkScalar left, SkScalar top, SkScalar right,
     this->close();
 }
 
+static int pts_in_verb(unsigned verb) {
+    static const uint8_t gPtsInVerb[] = {
+        1,  // kMove
+        1,  // kLine
+        2,  // kQuad
+        2,  // kConic
+        3,  // kCubic
+        0,  // kClose
+        0   // kDone
+    };
+
+    SkASSERT(verb < SK_ARRAY_COUNT(gPtsInVerb));
+    return gPtsInVerb[verb];
+}
+
+// The number of whole segments of verb in a contour of count points, after the moveTo.
+static int poly_segment_count(SkPath::Verb verb, int count) {
+    SkASSERT(SkPath::kLine_Verb == verb || SkPath::kQuad_Verb == verb ||
+             SkPath::kCubic_Verb == verb);
+    return (count - 1) / pts_in_verb(verb);
+}
+
 void SkPath::addPoly(const SkPoint pts[], int count, bool close) {
+    this->addPolys(kLine_Verb, pts, &count, 1, close);
+}
+
+void SkPath::addPolys(Verb verb, const SkPoint pts[], const int counts[], int contourCount,
+                      bool close) {
     SkDEBUGCODE(this->validate();)
-    if (count <= 0) {
+    int verbCount = 0;
+    int ptCount = 0;
+    for (int i = 0; i < contourCount; ++i) {
+        if (counts[i] > 0) {
+            // +close makes room for the extra kClose_Verb
+            int segments = poly_segment_count(verb, counts[i]);
+            verbCount += 1 + segments + close;
+            ptCount += 1 + segments * pts_in_verb(verb);
+        }
+    }
+    if (0 == verbCount) {
         return;
     }
 
-    fLastMoveToIndex = fPathRef->countPoints();
+    SkPathRef::Editor ed(&fPathRef, verbCount, ptCount);
 
-    // +close makes room for the extra kClose_Verb
-    SkPathRef::Editor ed(&fPathRef, count+close, count);
+    for (int i = 0; i < contourCount; ++i) {
+        int count = counts[i];
+        if (count <= 0) {
+            continue;
+        }
+        fLastMoveToIndex = fPathRef->countPoints();
 
-    ed.growForVerb(kMove_Verb)->set(pts[0].fX, pts[0].fY);
-    if (count > 1) {
-        SkPoint* p = ed.growForRepeatedVerb(kLine_Verb, count - 1);
-        memcpy(p, &pts[1], (count-1) * sizeof(SkPoint));
-    }
+        ed.growForVerb(kMove_Verb)->set(pts[0].fX, pts[0].fY);
+        int segments = poly_segment_count(verb, count);
+        if (segments > 0) {
+            SkPoint* p = ed.growForRepeatedVerb(verb, segments);
+            memcpy(p, &pts[1], segments * pts_in_verb(verb) * sizeof(SkPoint));
+        }
 
-    if (close) {
-        ed.growForVerb(kClose_Verb);
+        if (close) {
+            ed.growForVerb(kClose_Verb);
+        }
+        pts += count;
     }
 
     DIRTY_AFTER_EDIT;
@@ -1516,21 +1567,6 @@ void SkPath::addPath(const SkPath& path, const SkMatrix& matrix, AddPathMode mod
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static int pts_in_verb(unsigned verb) {
-    static const uint8_t gPtsInVerb[] = {
-        1,  // kMove
-        1,  // kLine
-        2,  // kQuad
-        2,  // kConic
-        3,  // kCubic
-        0,  // kClose
-        0   // kDone
-    };
-
-    SkASSERT(verb < SK_ARRAY_COUNT(gPtsInVerb));
-    return gPtsInVerb[verb];
-}
-
 // ignore the last point of the 1st contour
 void SkPath::reversePathTo(const SkPath& path) {
     int i, vcount = path.fPathRef->countVerbs();
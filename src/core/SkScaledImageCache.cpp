@@ -6,7 +6,9 @@
  */
 
 #include "SkScaledImageCache.h"
+#include "SkFloatBits.h"
 #include "SkMipMap.h"
+#include "SkOnce.h"
 #include "SkPixelRef.h"
 #include "SkRect.h"
 
@@ -56,47 +58,49 @@ static uint32_t compute_hash(const uint32_t data[], int count) {
 }
 
 struct SkScaledImageCache::Key {
+    // Bitmaps made from other bitmaps are keyed by their source's generation ID, their scale,
+    // and the bounds of their source within its pixelRef.
     Key(uint32_t genID,
         SkScalar scaleX,
         SkScalar scaleY,
         SkIRect  bounds)
-        : fGenID(genID)
-        , fScaleX(scaleX)
-        , fScaleY(scaleY)
-        , fBounds(bounds) {
-        fHash = compute_hash(&fGenID, 7);
-    }
-
-    bool operator<(const Key& other) const {
-        const uint32_t* a = &fGenID;
-        const uint32_t* b = &other.fGenID;
-        for (int i = 0; i < 7; ++i) {
-            if (a[i] < b[i]) {
-                return true;
-            }
-            if (a[i] > b[i]) {
-                return false;
-            }
-        }
-        return false;
+        : fFromBitmap(true)
+        , fCount(7) {
+        fData[0] = genID;
+        fData[1] = SkFloat2Bits(scaleX);
+        fData[2] = SkFloat2Bits(scaleY);
+        fData[3] = bounds.fLeft;
+        fData[4] = bounds.fTop;
+        fData[5] = bounds.fRight;
+        fData[6] = bounds.fBottom;
+        fHash = compute_hash(fData, fCount);
+    }
+
+    // Anything else is keyed by whatever words its caller says describe it.
+    Key(const uint32_t data[], int count)
+        : fFromBitmap(false)
+        , fCount(count) {
+        SkASSERT(count > 0 && count <= kMaxKeyCount);
+        memcpy(fData, data, count * sizeof(uint32_t));
+        fHash = compute_hash(fData, fCount);
     }
 
     bool operator==(const Key& other) const {
-        const uint32_t* a = &fHash;
-        const uint32_t* b = &other.fHash;
-        for (int i = 0; i < 8; ++i) {
-            if (a[i] != b[i]) {
-                return false;
-            }
-        }
-        return true;
+        return fHash == other.fHash &&
+               fFromBitmap == other.fFromBitmap &&
+               fCount == other.fCount &&
+               0 == memcmp(fData, other.fData, fCount * sizeof(uint32_t));
+    }
+
+    // SkShardedScaledImageCache keeps everything made from one bitmap in the same shard.
+    uint32_t shardID() const {
+        return fFromBitmap ? fData[0] : fHash;
     }
 
     uint32_t    fHash;
-    uint32_t    fGenID;
-    float       fScaleX;
-    float       fScaleY;
-    SkIRect     fBounds;
+    bool        fFromBitmap;
+    int32_t     fCount;
+    uint32_t    fData[kMaxKeyCount];
 };
 
 struct SkScaledImageCache::Rec {
@@ -167,6 +171,7 @@ void SkScaledImageCache::init() {
 #endif
     fBytesUsed = 0;
     fCount = 0;
+    fCountLimit = SK_DISCARDABLEMEMORY_SCALEDIMAGECACHE_COUNT_LIMIT;
     fAllocator = NULL;
 
     // One of these should be explicit set by the caller after we return.
@@ -318,17 +323,27 @@ SkScaledImageCache::Rec* SkScaledImageCache::findAndLock(uint32_t genID,
                                                         SkScalar scaleX,
                                                         SkScalar scaleY,
                                                         const SkIRect& bounds) {
-    const Key key(genID, scaleX, scaleY, bounds);
-    return this->findAndLock(key);
+    if (bounds.isEmpty()) {
+        fStats.fMisses += 1;
+        return NULL;
+    }
+    return this->findAndLockAndCount(Key(genID, scaleX, scaleY, bounds));
+}
+
+SkScaledImageCache::Rec* SkScaledImageCache::findAndLockAndCount(const Key& key) {
+    Rec* rec = this->findAndLock(key);
+    if (rec) {
+        fStats.fHits += 1;
+    } else {
+        fStats.fMisses += 1;
+    }
+    return rec;
 }
 
 /**
    This private method is the fully general record finder. All other
    record finders should call this function or the one above. */
 SkScaledImageCache::Rec* SkScaledImageCache::findAndLock(const SkScaledImageCache::Key& key) {
-    if (key.fBounds.isEmpty()) {
-        return NULL;
-    }
 #ifdef USE_HASH
     Rec* rec = fHash->find(key);
 #else
@@ -399,6 +414,16 @@ SkScaledImageCache::ID* SkScaledImageCache::findAndLockMip(const SkBitmap& orig,
     return rec_to_id(rec);
 }
 
+SkScaledImageCache::ID* SkScaledImageCache::findAndLock(const uint32_t key[], int count,
+                                                        SkBitmap* bitmap) {
+    Rec* rec = this->findAndLockAndCount(Key(key, count));
+    if (rec) {
+        SkASSERT(NULL == rec->fMip);
+        SkASSERT(rec->fBitmap.pixelRef());
+        *bitmap = rec->fBitmap;
+    }
+    return rec_to_id(rec);
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 /**
@@ -464,6 +489,12 @@ SkScaledImageCache::ID* SkScaledImageCache::addAndLockMip(const SkBitmap& orig,
     return this->addAndLock(rec);
 }
 
+SkScaledImageCache::ID* SkScaledImageCache::addAndLock(const uint32_t key[], int count,
+                                                       const SkBitmap& bitmap) {
+    Rec* rec = SkNEW_ARGS(Rec, (Key(key, count), bitmap));
+    return this->addAndLock(rec);
+}
+
 void SkScaledImageCache::unlock(SkScaledImageCache::ID* id) {
     SkASSERT(id);
 
@@ -493,17 +524,14 @@ void SkScaledImageCache::unlock(SkScaledImageCache::ID* id) {
 }
 
 void SkScaledImageCache::purgeAsNeeded() {
-    size_t byteLimit;
-    int    countLimit;
-
     if (fDiscardableFactory) {
-        countLimit = SK_DISCARDABLEMEMORY_SCALEDIMAGECACHE_COUNT_LIMIT;
-        byteLimit = SK_MaxU32;  // no limit based on bytes
+        this->purge(SK_MaxU32, fCountLimit);  // no limit based on bytes
     } else {
-        countLimit = SK_MaxS32; // no limit based on count
-        byteLimit = fByteLimit;
+        this->purge(fByteLimit, SK_MaxS32);   // no limit based on count
     }
+}
 
+void SkScaledImageCache::purge(size_t byteLimit, int countLimit) {
     size_t bytesUsed = fBytesUsed;
     int    countUsed = fCount;
 
@@ -526,6 +554,7 @@ void SkScaledImageCache::purgeAsNeeded() {
 
             bytesUsed -= used;
             countUsed -= 1;
+            fStats.fEvictions += 1;
         }
         rec = prev;
     }
@@ -666,23 +695,266 @@ void SkScaledImageCache::dump() const {
 
 ///////////////////////////////////////////////////////////////////////////////
 
-#include "SkThread.h"
+// Shards' caches don't purge by bytes on their own; we do that across all of them.
+static const size_t kNoByteLimit = ~(size_t)0;
+
+SkShardedScaledImageCache::SkShardedScaledImageCache(
+                                SkScaledImageCache::DiscardableFactory factory)
+    : fBytesUsed(0)
+    , fByteLimit(0) {
+    fShards = SkNEW_ARRAY(Shard, kShardCount);
+    for (int i = 0; i < kShardCount; ++i) {
+        fShards[i].fCache = SkNEW_ARGS(SkScaledImageCache, (factory));
+        // Split the count limit between the shards, as we do the byte limit.
+        fShards[i].fCache->fCountLimit =
+            SkTMax(1, SK_DISCARDABLEMEMORY_SCALEDIMAGECACHE_COUNT_LIMIT / kShardCount);
+    }
+}
+
+SkShardedScaledImageCache::SkShardedScaledImageCache(size_t byteLimit)
+    : fBytesUsed(0)
+    , fByteLimit(byteLimit) {
+    fShards = SkNEW_ARRAY(Shard, kShardCount);
+    for (int i = 0; i < kShardCount; ++i) {
+        fShards[i].fCache = SkNEW_ARGS(SkScaledImageCache, (kNoByteLimit));
+    }
+}
+
+SkShardedScaledImageCache::~SkShardedScaledImageCache() {
+    SkDELETE_ARRAY(fShards);
+}
+
+int SkShardedScaledImageCache::shardIndex(uint32_t genID) const {
+    return compute_hash(&genID, 1) % kShardCount;
+}
+
+SkShardedScaledImageCache::ID* SkShardedScaledImageCache::findAndLock(uint32_t genID,
+                                                                      int32_t width,
+                                                                      int32_t height,
+                                                                      SkBitmap* bitmap) {
+    Shard& shard = fShards[this->shardIndex(genID)];
+    SkAutoMutexAcquire am(shard.fMutex);
+    return shard.fCache->findAndLock(genID, width, height, bitmap);
+}
+
+SkShardedScaledImageCache::ID* SkShardedScaledImageCache::findAndLock(const SkBitmap& orig,
+                                                                      SkScalar scaleX,
+                                                                      SkScalar scaleY,
+                                                                      SkBitmap* scaled) {
+    Shard& shard = fShards[this->shardIndex(orig.getGenerationID())];
+    SkAutoMutexAcquire am(shard.fMutex);
+    return shard.fCache->findAndLock(orig, scaleX, scaleY, scaled);
+}
+
+SkShardedScaledImageCache::ID* SkShardedScaledImageCache::findAndLockMip(const SkBitmap& orig,
+                                                                SkMipMap const ** mip) {
+    Shard& shard = fShards[this->shardIndex(orig.getGenerationID())];
+    SkAutoMutexAcquire am(shard.fMutex);
+    return shard.fCache->findAndLockMip(orig, mip);
+}
+
+SkShardedScaledImageCache::ID* SkShardedScaledImageCache::findAndLock(const uint32_t key[],
+                                                                      int count,
+                                                                      SkBitmap* bitmap) {
+    Shard& shard = fShards[this->shardIndex(compute_hash(key, count))];
+    SkAutoMutexAcquire am(shard.fMutex);
+    return shard.fCache->findAndLock(key, count, bitmap);
+}
+
+SkShardedScaledImageCache::ID* SkShardedScaledImageCache::addAndLock(uint32_t genID,
+                                                                     int32_t width,
+                                                                     int32_t height,
+                                                                     const SkBitmap& bitmap) {
+    const int index = this->shardIndex(genID);
+    ID* id;
+    {
+        Shard& shard = fShards[index];
+        SkAutoMutexAcquire am(shard.fMutex);
+        const size_t oldBytesUsed = shard.fCache->getBytesUsed();
+        id = shard.fCache->addAndLock(genID, width, height, bitmap);
+        this->didChangeSize(shard, oldBytesUsed);
+    }
+    this->purgeAsNeeded(index);
+    return id;
+}
+
+SkShardedScaledImageCache::ID* SkShardedScaledImageCache::addAndLock(const SkBitmap& orig,
+                                                                     SkScalar scaleX,
+                                                                     SkScalar scaleY,
+                                                                     const SkBitmap& scaled) {
+    const int index = this->shardIndex(orig.getGenerationID());
+    ID* id;
+    {
+        Shard& shard = fShards[index];
+        SkAutoMutexAcquire am(shard.fMutex);
+        const size_t oldBytesUsed = shard.fCache->getBytesUsed();
+        id = shard.fCache->addAndLock(orig, scaleX, scaleY, scaled);
+        this->didChangeSize(shard, oldBytesUsed);
+    }
+    this->purgeAsNeeded(index);
+    return id;
+}
+
+SkShardedScaledImageCache::ID* SkShardedScaledImageCache::addAndLockMip(const SkBitmap& orig,
+                                                                        const SkMipMap* mip) {
+    const int index = this->shardIndex(orig.getGenerationID());
+    ID* id;
+    {
+        Shard& shard = fShards[index];
+        SkAutoMutexAcquire am(shard.fMutex);
+        const size_t oldBytesUsed = shard.fCache->getBytesUsed();
+        id = shard.fCache->addAndLockMip(orig, mip);
+        this->didChangeSize(shard, oldBytesUsed);
+    }
+    this->purgeAsNeeded(index);
+    return id;
+}
+
+SkShardedScaledImageCache::ID* SkShardedScaledImageCache::addAndLock(const uint32_t key[],
+                                                                     int count,
+                                                                     const SkBitmap& bitmap) {
+    const int index = this->shardIndex(compute_hash(key, count));
+    ID* id;
+    {
+        Shard& shard = fShards[index];
+        SkAutoMutexAcquire am(shard.fMutex);
+        const size_t oldBytesUsed = shard.fCache->getBytesUsed();
+        id = shard.fCache->addAndLock(key, count, bitmap);
+        this->didChangeSize(shard, oldBytesUsed);
+    }
+    this->purgeAsNeeded(index);
+    return id;
+}
+
+void SkShardedScaledImageCache::unlock(ID* id) {
+    SkASSERT(id);
+    const int index = this->shardIndex(id_to_rec(id)->fKey.shardID());
+    {
+        Shard& shard = fShards[index];
+        SkAutoMutexAcquire am(shard.fMutex);
+        const size_t oldBytesUsed = shard.fCache->getBytesUsed();
+        shard.fCache->unlock(id);
+        this->didChangeSize(shard, oldBytesUsed);
+    }
+    // we may have been over-budget, but now have released something, so check
+    // if we should purge.
+    this->purgeAsNeeded(index);
+}
+
+void SkShardedScaledImageCache::didChangeSize(const Shard& shard, size_t oldBytesUsed) {
+    const size_t bytesUsed = shard.fCache->getBytesUsed();
+    if (bytesUsed != oldBytesUsed) {
+        SkAutoMutexAcquire am(fBudgetMutex);
+        fBytesUsed = fBytesUsed - oldBytesUsed + bytesUsed;
+    }
+}
+
+void SkShardedScaledImageCache::purgeAsNeeded(int first) {
+    if (fShards[0].fCache->fDiscardableFactory) {
+        return;  // Each shard purges itself by count.
+    }
+    {
+        SkAutoMutexAcquire am(fBudgetMutex);
+        if (fBytesUsed < fByteLimit) {
+            return;
+        }
+    }
+
+    // Lock only one shard at a time, and always the shard's mutex before fBudgetMutex.
+    for (int i = 0; i < kShardCount; ++i) {
+        Shard& shard = fShards[(first + i) % kShardCount];
+        SkAutoMutexAcquire am(shard.fMutex);
+
+        size_t excess;
+        {
+            SkAutoMutexAcquire budget(fBudgetMutex);
+            if (fBytesUsed < fByteLimit) {
+                return;
+            }
+            excess = fBytesUsed - fByteLimit;
+        }
+
+        const size_t oldBytesUsed = shard.fCache->getBytesUsed();
+        if (0 == oldBytesUsed) {
+            continue;
+        }
+        // Purging down to strictly under this limit takes us strictly under fByteLimit.
+        const size_t shardLimit = oldBytesUsed > excess ? oldBytesUsed - excess : 0;
+        shard.fCache->purge(shardLimit, SK_MaxS32);
+        this->didChangeSize(shard, oldBytesUsed);
+    }
+}
+
+size_t SkShardedScaledImageCache::getBytesUsed() const {
+    SkAutoMutexAcquire am(fBudgetMutex);
+    return fBytesUsed;
+}
+
+size_t SkShardedScaledImageCache::getByteLimit() const {
+    SkAutoMutexAcquire am(fBudgetMutex);
+    return fByteLimit;
+}
+
+size_t SkShardedScaledImageCache::setByteLimit(size_t newLimit) {
+    size_t prevLimit;
+    {
+        SkAutoMutexAcquire am(fBudgetMutex);
+        prevLimit = fByteLimit;
+        fByteLimit = newLimit;
+    }
+    if (newLimit < prevLimit) {
+        this->purgeAsNeeded(0);
+    }
+    return prevLimit;
+}
+
+SkBitmap::Allocator* SkShardedScaledImageCache::allocator() const {
+    // All the shards' allocators are the same, if they have one.
+    return fShards[0].fCache->allocator();
+}
+
+void SkShardedScaledImageCache::getStats(SkScaledImageCache::Stats* stats) const {
+    *stats = SkScaledImageCache::Stats();
+    for (int i = 0; i < kShardCount; ++i) {
+        SkAutoMutexAcquire am(fShards[i].fMutex);
+        const SkScaledImageCache::Stats& shardStats = fShards[i].fCache->fStats;
+        stats->fHits      += shardStats.fHits;
+        stats->fMisses    += shardStats.fMisses;
+        stats->fEvictions += shardStats.fEvictions;
+    }
+}
+
+void SkShardedScaledImageCache::dump() const {
+    SkScaledImageCache::Stats stats;
+    this->getStats(&stats);
+    SkDebugf("SkShardedScaledImageCache: shards=%d bytes=%d limit=%d hits=%d misses=%d "
+             "evictions=%d\n",
+             kShardCount, this->getBytesUsed(), this->getByteLimit(),
+             (int)stats.fHits, (int)stats.fMisses, (int)stats.fEvictions);
+    for (int i = 0; i < kShardCount; ++i) {
+        SkAutoMutexAcquire am(fShards[i].fMutex);
+        fShards[i].fCache->dump();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
 
-SK_DECLARE_STATIC_MUTEX(gMutex);
-static SkScaledImageCache* gScaledImageCache = NULL;
+static SkShardedScaledImageCache* gScaledImageCache = NULL;
 static void cleanup_gScaledImageCache() { SkDELETE(gScaledImageCache); }
 
-/** Must hold gMutex when calling. */
-static SkScaledImageCache* get_cache() {
-    // gMutex is always held when this is called, so we don't need to be fancy in here.
-    if (NULL == gScaledImageCache) {
+static void create_cache() {
 #ifdef SK_USE_DISCARDABLE_SCALEDIMAGECACHE
-        gScaledImageCache = SkNEW_ARGS(SkScaledImageCache, (SkDiscardableMemory::Create));
+    gScaledImageCache = SkNEW_ARGS(SkShardedScaledImageCache, (SkDiscardableMemory::Create));
 #else
-        gScaledImageCache = SkNEW_ARGS(SkScaledImageCache, (SK_DEFAULT_IMAGE_CACHE_LIMIT));
+    gScaledImageCache = SkNEW_ARGS(SkShardedScaledImageCache, (SK_DEFAULT_IMAGE_CACHE_LIMIT));
 #endif
-        atexit(cleanup_gScaledImageCache);
-    }
+    atexit(cleanup_gScaledImageCache);
+}
+
+// The cache itself is thread-safe, so we only need to be careful creating it.
+static SkShardedScaledImageCache* get_cache() {
+    SK_DECLARE_STATIC_ONCE(once);
+    SkOnce(&once, create_cache);
     return gScaledImageCache;
 }
 
@@ -692,7 +964,6 @@ SkScaledImageCache::ID* SkScaledImageCache::FindAndLock(
                                 int32_t width,
                                 int32_t height,
                                 SkBitmap* scaled) {
-    SkAutoMutexAcquire am(gMutex);
     return get_cache()->findAndLock(pixelGenerationID, width, height, scaled);
 }
 
@@ -701,7 +972,6 @@ SkScaledImageCache::ID* SkScaledImageCache::AddAndLock(
                                int32_t width,
                                int32_t height,
                                const SkBitmap& scaled) {
-    SkAutoMutexAcquire am(gMutex);
     return get_cache()->addAndLock(pixelGenerationID, width, height, scaled);
 }
 
@@ -710,13 +980,11 @@ SkScaledImageCache::ID* SkScaledImageCache::FindAndLock(const SkBitmap& orig,
                                                         SkScalar scaleX,
                                                         SkScalar scaleY,
                                                         SkBitmap* scaled) {
-    SkAutoMutexAcquire am(gMutex);
     return get_cache()->findAndLock(orig, scaleX, scaleY, scaled);
 }
 
 SkScaledImageCache::ID* SkScaledImageCache::FindAndLockMip(const SkBitmap& orig,
                                                        SkMipMap const ** mip) {
-    SkAutoMutexAcquire am(gMutex);
     return get_cache()->findAndLockMip(orig, mip);
 }
 
@@ -724,45 +992,51 @@ SkScaledImageCache::ID* SkScaledImageCache::AddAndLock(const SkBitmap& orig,
                                                        SkScalar scaleX,
                                                        SkScalar scaleY,
                                                        const SkBitmap& scaled) {
-    SkAutoMutexAcquire am(gMutex);
     return get_cache()->addAndLock(orig, scaleX, scaleY, scaled);
 }
 
 SkScaledImageCache::ID* SkScaledImageCache::AddAndLockMip(const SkBitmap& orig,
                                                           const SkMipMap* mip) {
-    SkAutoMutexAcquire am(gMutex);
     return get_cache()->addAndLockMip(orig, mip);
 }
 
+SkScaledImageCache::ID* SkScaledImageCache::FindAndLock(const uint32_t key[], int count,
+                                                        SkBitmap* bitmap) {
+    return get_cache()->findAndLock(key, count, bitmap);
+}
+
+SkScaledImageCache::ID* SkScaledImageCache::AddAndLock(const uint32_t key[], int count,
+                                                       const SkBitmap& bitmap) {
+    return get_cache()->addAndLock(key, count, bitmap);
+}
+
 void SkScaledImageCache::Unlock(SkScaledImageCache::ID* id) {
-    SkAutoMutexAcquire am(gMutex);
     get_cache()->unlock(id);
 
 //    get_cache()->dump();
 }
 
 size_t SkScaledImageCache::GetBytesUsed() {
-    SkAutoMutexAcquire am(gMutex);
     return get_cache()->getBytesUsed();
 }
 
 size_t SkScaledImageCache::GetByteLimit() {
-    SkAutoMutexAcquire am(gMutex);
     return get_cache()->getByteLimit();
 }
 
 size_t SkScaledImageCache::SetByteLimit(size_t newLimit) {
-    SkAutoMutexAcquire am(gMutex);
     return get_cache()->setByteLimit(newLimit);
 }
 
 SkBitmap::Allocator* SkScaledImageCache::GetAllocator() {
-    SkAutoMutexAcquire am(gMutex);
     return get_cache()->allocator();
 }
 
+void SkScaledImageCache::GetStats(Stats* stats) {
+    get_cache()->getStats(stats);
+}
+
 void SkScaledImageCache::Dump() {
-    SkAutoMutexAcquire am(gMutex);
     get_cache()->dump();
 }
 
@@ -781,3 +1055,17 @@ size_t SkGraphics::GetImageCacheByteLimit() {
 size_t SkGraphics::SetImageCacheByteLimit(size_t newLimit) {
     return SkScaledImageCache::SetByteLimit(newLimit);
 }
+
+void SkGraphics::GetImageCacheStats(uint64_t* hits, uint64_t* misses, uint64_t* evictions) {
+    SkScaledImageCache::Stats stats;
+    SkScaledImageCache::GetStats(&stats);
+    if (hits) {
+        *hits = stats.fHits;
+    }
+    if (misses) {
+        *misses = stats.fMisses;
+    }
+    if (evictions) {
+        *evictions = stats.fEvictions;
+    }
+}
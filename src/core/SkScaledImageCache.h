@@ -9,9 +9,11 @@
 #define SkScaledImageCache_DEFINED
 
 #include "SkBitmap.h"
+#include "SkThread.h"
 
 class SkDiscardableMemory;
 class SkMipMap;
+class SkShardedScaledImageCache;
 
 /**
  *  Cache object for bitmaps (with possible scale in X Y as part of the key).
@@ -22,11 +24,24 @@ class SkMipMap;
  *
  *  As a convenience, a global instance is also defined, which can be safely
  *  access across threads via the static methods (e.g. FindAndLock, etc.).
+ *  It is an SkShardedScaledImageCache, so threads working with different
+ *  images rarely contend for the same lock.
  */
 class SkScaledImageCache {
 public:
     struct ID;
 
+    /**
+     *  Counters to help tune the cache's limits.
+     */
+    struct Stats {
+        Stats() : fHits(0), fMisses(0), fEvictions(0) {}
+
+        uint64_t fHits;         // findAndLock() calls that found what they were looking for
+        uint64_t fMisses;       // findAndLock() calls that didn't
+        uint64_t fEvictions;    // unlocked entries purged to stay within our limits
+    };
+
     /**
      *  Returns a locked/pinned SkDiscardableMemory instance for the specified
      *  number of bytes, or NULL on failure.
@@ -58,6 +73,18 @@ public:
                           SkScalar scaleY, const SkBitmap& bitmap);
     static ID* AddAndLockMip(const SkBitmap& original, const SkMipMap* mipMap);
 
+    /**
+     *  Bitmaps that aren't made from another bitmap (e.g. blurred masks of
+     *  shapes) are keyed by up to kMaxKeyCount words, which must describe
+     *  everything that affects their pixels.
+     */
+    static const int kMaxKeyCount = 16;
+
+    static ID* FindAndLock(const uint32_t key[], int count,
+                           SkBitmap* returnedBitmap);
+    static ID* AddAndLock(const uint32_t key[], int count,
+                          const SkBitmap& bitmap);
+
     static void Unlock(ID*);
 
     static size_t GetBytesUsed();
@@ -66,6 +93,8 @@ public:
 
     static SkBitmap::Allocator* GetAllocator();
 
+    static void GetStats(Stats*);
+
     /**
      *  Call SkDebugf() with diagnostic information about the state of the cache
      */
@@ -122,19 +151,26 @@ public:
     ID* findAndLockMip(const SkBitmap& original,
                        SkMipMap const** returnedMipMap);
 
+    /**
+     *  Search the cache for a bitmap with this key of count words (at most
+     *  kMaxKeyCount). These keys never match those of the methods above.
+     */
+    ID* findAndLock(const uint32_t key[], int count, SkBitmap* returnedBitmap);
+
     /**
      *  To add a new bitmap (or mipMap) to the cache, call
      *  AddAndLock. Use the returned ptr to unlock the cache when you
      *  are done using scaled.
      *
      *  Use (generationID, width, and height) or (original, scaleX,
-     *  scaleY) or (original) as a search key
+     *  scaleY) or (original) or (key, count) as a search key
      */
     ID* addAndLock(uint32_t pixelGenerationID, int32_t width, int32_t height,
                    const SkBitmap& bitmap);
     ID* addAndLock(const SkBitmap& original, SkScalar scaleX,
                    SkScalar scaleY, const SkBitmap& bitmap);
     ID* addAndLockMip(const SkBitmap& original, const SkMipMap* mipMap);
+    ID* addAndLock(const uint32_t key[], int count, const SkBitmap& bitmap);
 
     /**
      *  Given a non-null ID ptr returned by either findAndLock or addAndLock,
@@ -156,6 +192,12 @@ public:
 
     SkBitmap::Allocator* allocator() const { return fAllocator; };
 
+    /**
+     *  Returns the hits, misses, and evictions counted since this cache was
+     *  created.
+     */
+    void getStats(Stats* stats) const { *stats = fStats; }
+
     /**
      *  Call SkDebugf() with diagnostic information about the state of the cache
      */
@@ -178,14 +220,20 @@ private:
     size_t  fBytesUsed;
     size_t  fByteLimit;
     int     fCount;
+    int     fCountLimit;    // only used with fDiscardableFactory
+
+    Stats   fStats;
 
     Rec* findAndLock(uint32_t generationID, SkScalar sx, SkScalar sy,
                      const SkIRect& bounds);
     Rec* findAndLock(const Key& key);
+    Rec* findAndLockAndCount(const Key& key);   // also updates fStats
     ID* addAndLock(Rec* rec);
 
     void purgeRec(Rec*);
     void purgeAsNeeded();
+    // purge unlocked recs, oldest first, until we are under both limits
+    void purge(size_t byteLimit, int countLimit);
 
     // linklist management
     void moveToHead(Rec*);
@@ -199,5 +247,88 @@ private:
 #else
     void validate() const {}
 #endif
+
+    friend class SkShardedScaledImageCache;
 };
+
+/**
+ *  A thread-safe SkScaledImageCache, split into shards by generation ID
+ *  (or, for keys of words, by their hash).
+ *
+ *  Each shard is an SkScaledImageCache with its own mutex and its own LRU list.
+ *  The byte limit applies to all the shards together: when we go over it, we
+ *  purge the least recently used unlocked entries of the shard we just added
+ *  to, then of the other shards in turn, until we are back under.
+ */
+class SkShardedScaledImageCache : SkNoncopyable {
+public:
+    typedef SkScaledImageCache::ID ID;
+
+    /**
+     *  See the matching SkScaledImageCache constructors.
+     */
+    SkShardedScaledImageCache(SkScaledImageCache::DiscardableFactory);
+    SkShardedScaledImageCache(size_t byteLimit);
+
+    ~SkShardedScaledImageCache();
+
+    /**
+     *  These all work like their SkScaledImageCache equivalents, but are
+     *  safe to call from any thread.
+     */
+    ID* findAndLock(uint32_t pixelGenerationID, int32_t width, int32_t height,
+                    SkBitmap* returnedBitmap);
+    ID* findAndLock(const SkBitmap& original, SkScalar scaleX,
+                    SkScalar scaleY, SkBitmap* returnedBitmap);
+    ID* findAndLockMip(const SkBitmap& original,
+                       SkMipMap const** returnedMipMap);
+
+    ID* addAndLock(uint32_t pixelGenerationID, int32_t width, int32_t height,
+                   const SkBitmap& bitmap);
+    ID* addAndLock(const SkBitmap& original, SkScalar scaleX,
+                   SkScalar scaleY, const SkBitmap& bitmap);
+    ID* addAndLockMip(const SkBitmap& original, const SkMipMap* mipMap);
+
+    ID* findAndLock(const uint32_t key[], int count, SkBitmap* returnedBitmap);
+    ID* addAndLock(const uint32_t key[], int count, const SkBitmap& bitmap);
+
+    void unlock(ID*);
+
+    size_t getBytesUsed() const;
+    size_t getByteLimit() const;
+    size_t setByteLimit(size_t newLimit);
+
+    SkBitmap::Allocator* allocator() const;
+
+    /**
+     *  Sums the stats of all the shards.
+     */
+    void getStats(SkScaledImageCache::Stats*) const;
+
+    void dump() const;
+
+    static const int kShardCount = 16;
+
+private:
+    struct Shard {
+        Shard() : fCache(NULL) {}
+        ~Shard() { SkDELETE(fCache); }
+
+        mutable SkMutex     fMutex;     // protects fCache
+        SkScaledImageCache* fCache;
+    };
+
+    int shardIndex(uint32_t pixelGenerationID) const;
+    // Call with shard's mutex held, after anything that may have changed its size.
+    void didChangeSize(const Shard&, size_t oldBytesUsed);
+    // Call with no shard mutexes held.  Purges, starting with shard first, until we're in budget.
+    void purgeAsNeeded(int first);
+
+    Shard*          fShards;          // kShardCount of them
+
+    mutable SkMutex fBudgetMutex;     // protects fBytesUsed and fByteLimit
+    size_t          fBytesUsed;       // sum of all the shards' bytes used
+    size_t          fByteLimit;       // 0 if discardable
+};
+
 #endif
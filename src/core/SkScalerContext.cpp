@@ -20,6 +20,7 @@
 #include "SkPathEffect.h"
 #include "SkRasterizer.h"
 #include "SkRasterClip.h"
+#include "SkSharedGlyphImages.h"
 #include "SkStroke.h"
 #include "SkThread.h"
 
@@ -96,6 +97,8 @@ SkScalerContext::SkScalerContext(SkTypeface* typeface, const SkDescriptor* desc)
 
     , fNextContext(NULL)
 
+    , fShareImages(SkSharedGlyphImages::ComputeKey(typeface, desc, fSharedImageKey))
+
     , fPreBlend(fMaskFilter ? SkMaskGamma::PreBlend() : SkScalerContext::GetMaskPreBlend(fRec))
     , fPreBlendForFilter(fMaskFilter ? SkScalerContext::GetMaskPreBlend(fRec)
                                      : SkMaskGamma::PreBlend())
@@ -690,6 +693,11 @@ void SkScalerContext::getImage(const SkGlyph& origGlyph) {
     SkASSERT(!fGenerateImageFromPath ||
              SkMask::kARGB32_Format != origGlyph.fMaskFormat);
 
+    // Another process may have made this image already.
+    if (fShareImages && SkSharedGlyphImages::Find(fSharedImageKey, origGlyph)) {
+        return;
+    }
+
     if (fMaskFilter) {   // restore the prefilter bounds
         tmpGlyph.init(origGlyph.fID);
 
@@ -792,6 +800,10 @@ void SkScalerContext::getImage(const SkGlyph& origGlyph) {
             }
         }
     }
+
+    if (fShareImages) {
+        SkSharedGlyphImages::Add(fSharedImageKey, origGlyph);
+    }
 }
 
 void SkScalerContext::getPath(const SkGlyph& glyph, SkPath* path) {
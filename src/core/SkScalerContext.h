@@ -295,6 +295,10 @@ private:
     // link-list of context, to handle missing chars. null-terminated.
     SkScalerContext* fNextContext;
 
+    // Identifies our glyph images in SkSharedGlyphImages, if fShareImages.
+    bool     fShareImages;
+    uint32_t fSharedImageKey[2];
+
     // SkMaskGamma::PreBlend converts linear masks to gamma correcting masks.
 protected:
     // Visible to subclasses so that generateImage can apply the pre-blend directly.
@@ -24,6 +24,17 @@ typedef SkIRect SkXRect;
 
 class SkScan {
 public:
+    /**
+     *  How AntiFillPath computes coverage.  Supersampling rasterizes each pixel at 4x4 and counts
+     *  the samples inside.  Analytic computes each pixel's exact coverage from the area each edge
+     *  sweeps through it; it applies to nonzero (winding) fills and falls back to supersampling
+     *  for even-odd and inverse fills.
+     */
+    enum AAType {
+        kSupersample_AAType,
+        kAnalytic_AAType
+    };
+
     static void FillPath(const SkPath&, const SkIRect&, SkBlitter*);
 
     ///////////////////////////////////////////////////////////////////////////
@@ -36,6 +47,7 @@ public:
     static void AntiFillXRect(const SkXRect&, const SkRasterClip&, SkBlitter*);
     static void FillPath(const SkPath&, const SkRasterClip&, SkBlitter*);
     static void AntiFillPath(const SkPath&, const SkRasterClip&, SkBlitter*);
+    static void AntiFillPath(const SkPath&, const SkRasterClip&, SkBlitter*, AAType);
     static void FrameRect(const SkRect&, const SkPoint& strokeSize,
                           const SkRasterClip&, SkBlitter*);
     static void AntiFrameRect(const SkRect&, const SkPoint& strokeSize,
@@ -61,7 +73,7 @@ private:
     static void AntiFillXRect(const SkXRect&, const SkRegion*, SkBlitter*);
     static void FillPath(const SkPath&, const SkRegion& clip, SkBlitter*);
     static void AntiFillPath(const SkPath&, const SkRegion& clip, SkBlitter*,
-                             bool forceRLE = false);
+                             bool forceRLE = false, AAType = kSupersample_AAType);
     static void FillTriangle(const SkPoint pts[], const SkRegion*, SkBlitter*);
 
     static void AntiFrameRect(const SkRect&, const SkPoint& strokeSize,
@@ -0,0 +1,413 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkScanPriv.h"
+#include "SkGeometry.h"
+#include "SkPath.h"
+#include "SkTDArray.h"
+#include "SkTSort.h"
+#include "SkTemplates.h"
+
+/** @file
+    An antialiased path filler that computes each pixel's coverage exactly, rather than by
+    counting supersamples.
+
+    The path is flattened into lines.  Each line deposits into an accumulation buffer, for every
+    pixel it crosses, the signed area between it and that pixel's right edge, and the remainder of
+    its signed height (its cover) into the pixels after.  A running sum across each row then gives
+    the signed coverage of every pixel in one pass, with no per-edge sorting or sample walking.
+
+    Because coverage is summed rather than counted, overlapping regions of the same winding clamp
+    at full coverage; this is exact for the nonzero fill rule wherever edges of different contours
+    don't share a pixel.  Even-odd and inverse fills still go through the supersampler.
+
+    Everything is in coordinates relative to the top-left of the fill bounds.  Lines left of the
+    bounds are pinned to its left edge, where they contribute only their cover; lines right of it
+    are pinned to its right edge, where they contribute nothing visible.
+ */
+
+// Flattened curves stay within this many pixels of the true curve.
+static const float kTolerance = 1.0f / 16;
+// Limit how finely we subdivide huge curves.
+static const int kMaxCurveLines = 100;
+// We accumulate this many rows at a time, so the buffer stays small and hot.
+static const int kStripRows = 16;
+// We note which blocks of this many pixels each row's lines touched; coverage is constant across
+// the others, so the running sum can skip straight over them.
+static const int kBlockShift = 5;
+static const int kBlockMask = (1 << kBlockShift) - 1;
+
+namespace {
+
+inline float pin(float value, float min, float max) {
+    return SkTMax(min, SkTMin(value, max));
+}
+
+struct Line {
+    float fX0, fY0, fX1, fY1;   // fY0 < fY1
+    float fDir;                 // +1 if the original line pointed down, -1 if up.
+
+    bool operator<(const Line& that) const { return fY0 < that.fY0; }
+};
+
+class LineBuilder {
+public:
+    LineBuilder(const SkIRect& bounds)
+        : fLeft(SkIntToScalar(bounds.fLeft))
+        , fTop(SkIntToScalar(bounds.fTop))
+        , fWidth((float)bounds.width())
+        , fHeight((float)bounds.height()) {}
+
+    const SkTDArray<Line>& lines() const { return fLines; }
+    SkTDArray<Line>& lines() { return fLines; }
+
+    void addPath(const SkPath& path) {
+        SkPath::Iter iter(path, true);
+        SkPoint pts[4];
+        SkPath::Verb verb;
+        while ((verb = iter.next(pts)) != SkPath::kDone_Verb) {
+            switch (verb) {
+                case SkPath::kLine_Verb:
+                    this->addLine(pts[0], pts[1]);
+                    break;
+                case SkPath::kQuad_Verb:
+                    this->addQuad(pts);
+                    break;
+                case SkPath::kConic_Verb: {
+                    SkAutoConicToQuads quadder;
+                    SkConic conic;
+                    conic.set(pts, iter.conicWeight());
+                    const SkPoint* quadPts = quadder.computeQuads(conic, kTolerance);
+                    for (int i = 0; i < quadder.countQuads(); ++i) {
+                        this->addQuad(quadPts + 2 * i);
+                    }
+                    break;
+                }
+                case SkPath::kCubic_Verb:
+                    this->addCubic(pts);
+                    break;
+                default:  // kMove_Verb and kClose_Verb; the iterator closes contours for us.
+                    break;
+            }
+        }
+    }
+
+private:
+    // If all of pts are above, below, left of, or right of the bounds, a straight line between
+    // the ends contributes exactly what the curve would.
+    bool canSkipCurve(const SkPoint pts[], int count) const {
+        float minX = pts[0].fX, maxX = minX, minY = pts[0].fY, maxY = minY;
+        for (int i = 1; i < count; ++i) {
+            minX = SkTMin(minX, pts[i].fX);
+            maxX = SkTMax(maxX, pts[i].fX);
+            minY = SkTMin(minY, pts[i].fY);
+            maxY = SkTMax(maxY, pts[i].fY);
+        }
+        return maxY <= fTop || minY >= fTop + fHeight ||
+               maxX <= fLeft || minX >= fLeft + fWidth;
+    }
+
+    static int count_lines(float secondDifference) {
+        int n = (int)ceilf(sk_float_sqrt(secondDifference / kTolerance));
+        return SkPin32(n, 1, kMaxCurveLines);
+    }
+
+    void addQuad(const SkPoint pts[3]) {
+        if (this->canSkipCurve(pts, 3)) {
+            this->addLine(pts[0], pts[2]);
+            return;
+        }
+        // A quad's distance from its chord over a step of 1/n is at most |p0 - 2p1 + p2| / 4n^2.
+        const SkPoint a = { pts[0].fX - 2 * pts[1].fX + pts[2].fX,
+                            pts[0].fY - 2 * pts[1].fY + pts[2].fY };
+        const SkPoint b = { 2 * (pts[1].fX - pts[0].fX), 2 * (pts[1].fY - pts[0].fY) };
+        const int n = count_lines(a.length() / 4);
+
+        SkPoint prev = pts[0];
+        for (int i = 1; i < n; ++i) {
+            const float t = (float)i / n;
+            const SkPoint next = { (a.fX * t + b.fX) * t + pts[0].fX,
+                                   (a.fY * t + b.fY) * t + pts[0].fY };
+            this->addLine(prev, next);
+            prev = next;
+        }
+        this->addLine(prev, pts[2]);
+    }
+
+    void addCubic(const SkPoint pts[4]) {
+        if (this->canSkipCurve(pts, 4)) {
+            this->addLine(pts[0], pts[3]);
+            return;
+        }
+        // Likewise a cubic's is at most 3/4 of its largest second difference, over n^2.
+        const SkPoint d0 = { pts[0].fX - 2 * pts[1].fX + pts[2].fX,
+                             pts[0].fY - 2 * pts[1].fY + pts[2].fY };
+        const SkPoint d1 = { pts[1].fX - 2 * pts[2].fX + pts[3].fX,
+                             pts[1].fY - 2 * pts[2].fY + pts[3].fY };
+        const int n = count_lines(SkTMax(d0.length(), d1.length()) * 3 / 4);
+
+        const SkPoint a = { pts[3].fX + 3 * (pts[1].fX - pts[2].fX) - pts[0].fX,
+                            pts[3].fY + 3 * (pts[1].fY - pts[2].fY) - pts[0].fY };
+        const SkPoint b = { 3 * d0.fX, 3 * d0.fY };
+        const SkPoint c = { 3 * (pts[1].fX - pts[0].fX), 3 * (pts[1].fY - pts[0].fY) };
+
+        SkPoint prev = pts[0];
+        for (int i = 1; i < n; ++i) {
+            const float t = (float)i / n;
+            const SkPoint next = { ((a.fX * t + b.fX) * t + c.fX) * t + pts[0].fX,
+                                   ((a.fY * t + b.fY) * t + c.fY) * t + pts[0].fY };
+            this->addLine(prev, next);
+            prev = next;
+        }
+        this->addLine(prev, pts[3]);
+    }
+
+    void addLine(const SkPoint& p0, const SkPoint& p1) {
+        float x0 = p0.fX - fLeft, y0 = p0.fY - fTop,
+              x1 = p1.fX - fLeft, y1 = p1.fY - fTop;
+        float dir = 1;
+        if (y0 > y1) {
+            SkTSwap(x0, x1);
+            SkTSwap(y0, y1);
+            dir = -1;
+        }
+        // Rows outside the bounds are never blitted, so just trim the line to them.
+        if (y1 <= 0 || y0 >= fHeight || y0 == y1) {
+            return;
+        }
+        const float dxdy = (x1 - x0) / (y1 - y0);
+        if (y0 < 0) {
+            x0 -= y0 * dxdy;
+            y0 = 0;
+        }
+        if (y1 > fHeight) {
+            x1 -= (y1 - fHeight) * dxdy;
+            y1 = fHeight;
+        }
+
+        // Split where the line crosses the left and right edges, then pin each piece inside.
+        float splitY[2];
+        int splits = 0;
+        if ((x0 < 0) != (x1 < 0)) {
+            splitY[splits++] = y0 - x0 / dxdy;
+        }
+        if ((x0 < fWidth) != (x1 < fWidth)) {
+            splitY[splits++] = y0 + (fWidth - x0) / dxdy;
+        }
+        if (2 == splits && splitY[0] > splitY[1]) {
+            SkTSwap(splitY[0], splitY[1]);
+        }
+
+        float prevX = x0, prevY = y0;
+        for (int i = 0; i < splits; ++i) {
+            const float y = pin(splitY[i], prevY, y1);
+            const float x = x0 + (y - y0) * dxdy;
+            this->appendLine(prevX, prevY, x, y, dir);
+            prevX = x;
+            prevY = y;
+        }
+        this->appendLine(prevX, prevY, x1, y1, dir);
+    }
+
+    void appendLine(float x0, float y0, float x1, float y1, float dir) {
+        if (y0 >= y1) {
+            return;
+        }
+        Line* line = fLines.append();
+        line->fX0 = pin(x0, 0.0f, fWidth);
+        line->fY0 = y0;
+        line->fX1 = pin(x1, 0.0f, fWidth);
+        line->fY1 = y1;
+        line->fDir = dir;
+    }
+
+    const float fLeft, fTop, fWidth, fHeight;
+    SkTDArray<Line> fLines;
+};
+
+// Deposit line's signed area and cover into the rows of acc from stripTop to stripTop+rows.
+// acc has stride floats per row.  touched[] tracks the leftmost and rightmost entry we write in
+// each row, and dirty (blocks bytes per row) which blocks of entries, so the caller only has to
+// scan and clear those.
+void accumulate_line(const Line& line, int stripTop, int rows, float* acc, int stride,
+                     int touched[][2], uint8_t* dirty, int blocks) {
+    const float dxdy = (line.fX1 - line.fX0) / (line.fY1 - line.fY0);
+    const int maxX = stride - 2;
+    const int yStart = SkTMax((int)line.fY0, stripTop),
+              yStop  = SkTMin((int)ceilf(line.fY1), stripTop + rows);
+
+    for (int y = yStart; y < yStop; ++y) {
+        const float top = SkTMax((float)y, line.fY0),
+                    bot = SkTMin((float)(y + 1), line.fY1);
+        const float d = (bot - top) * line.fDir;
+        if (0 == d) {
+            continue;
+        }
+        float xa = pin(line.fX0 + (top - line.fY0) * dxdy, 0.0f, (float)maxX),
+              xb = pin(line.fX0 + (bot - line.fY0) * dxdy, 0.0f, (float)maxX);
+        if (xa > xb) {
+            SkTSwap(xa, xb);
+        }
+
+        float* row = acc + (y - stripTop) * stride;
+        const float x0floor = floorf(xa);
+        const int x0i = (int)x0floor,
+                  x1i = (int)ceilf(xb);
+        int last;
+        if (x1i <= x0i + 1) {
+            // Within one pixel: split d between it and the next by the line's mean position.
+            const float xmf = 0.5f * (xa + xb) - x0floor;
+            row[x0i]     += d - d * xmf;
+            row[x0i + 1] += d * xmf;
+            last = x0i + 1;
+        } else {
+            // Across several pixels: a triangle in the first, trapezoids through the middle,
+            // and a triangle in the last, each scaled by the line's (inverse) slope.
+            const float s = 1 / (xb - xa);
+            const float x0f = xa - x0floor;
+            const float a0 = 0.5f * s * (1 - x0f) * (1 - x0f);
+            const float x1f = xb - x1i + 1;
+            const float am = 0.5f * s * x1f * x1f;
+            row[x0i] += d * a0;
+            if (x1i == x0i + 2) {
+                row[x0i + 1] += d * (1 - a0 - am);
+            } else {
+                const float a1 = s * (1.5f - x0f);
+                row[x0i + 1] += d * (a1 - a0);
+                for (int x = x0i + 2; x < x1i - 1; ++x) {
+                    row[x] += d * s;
+                }
+                const float a2 = a1 + (x1i - x0i - 3) * s;
+                row[x1i - 1] += d * (1 - a2 - am);
+            }
+            row[x1i] += d * am;
+            last = x1i;
+        }
+
+        int* t = touched[y - stripTop];
+        t[0] = SkTMin(t[0], x0i);
+        t[1] = SkTMax(t[1], last);
+        uint8_t* rowDirty = dirty + (y - stripTop) * blocks;
+        for (int b = x0i >> kBlockShift; b <= last >> kBlockShift; ++b) {
+            rowDirty[b] = 1;
+        }
+    }
+}
+
+}  // namespace
+
+void sk_analytic_fill_path(const SkPath& path, const SkIRect& bounds, SkBlitter* blitter) {
+    SkASSERT(!path.isInverseFillType());
+    SkASSERT(SkPath::kWinding_FillType == path.getFillType());
+
+    const int width = bounds.width(),
+              height = bounds.height();
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+
+    LineBuilder builder(bounds);
+    builder.addPath(path);
+    SkTDArray<Line>& lines = builder.lines();
+    if (lines.isEmpty()) {
+        return;
+    }
+    SkTQSort(lines.begin(), lines.end() - 1);
+
+    // Lines may write up to two entries past the last pixel; those hold cover we never need.
+    const int stride = width + 2;
+    SkAutoTMalloc<float> acc(stride * kStripRows);
+    sk_bzero(acc.get(), stride * kStripRows * sizeof(float));
+    SkAutoTMalloc<SkAlpha> alpha(width + 1);
+    SkAutoTMalloc<int16_t> runs(width + 1);
+    const int blocks = (stride >> kBlockShift) + 1;
+    SkAutoTMalloc<uint8_t> dirty(blocks * kStripRows);
+    sk_bzero(dirty.get(), blocks * kStripRows);
+    int touched[kStripRows][2];
+
+    SkTDArray<int> active;
+    int next = 0;
+    for (int stripTop = 0; stripTop < height; stripTop += kStripRows) {
+        const int rows = SkTMin(kStripRows, height - stripTop);
+        const float stripBottom = (float)(stripTop + rows);
+
+        for (int i = 0; i < active.count(); ) {
+            if (lines[active[i]].fY1 <= stripTop) {
+                active.removeShuffle(i);
+            } else {
+                ++i;
+            }
+        }
+        while (next < lines.count() && lines[next].fY0 < stripBottom) {
+            *active.append() = next++;
+        }
+        if (active.isEmpty()) {
+            continue;
+        }
+
+        for (int r = 0; r < rows; ++r) {
+            touched[r][0] = stride;
+            touched[r][1] = -1;
+        }
+        for (int i = 0; i < active.count(); ++i) {
+            accumulate_line(lines[active[i]], stripTop, rows, acc.get(), stride, touched,
+                            dirty.get(), blocks);
+        }
+
+        for (int r = 0; r < rows; ++r) {
+            const int start = touched[r][0],
+                      stop  = touched[r][1] + 1;
+            if (start >= stop) {
+                continue;
+            }
+            float* row = acc.get() + r * stride;
+            uint8_t* rowDirty = dirty.get() + r * blocks;
+            const int end = SkTMin(stop, width);
+
+            // Sum across the row into coverage, merging equal neighbors into runs and skipping
+            // empty pixels at either end.
+            float sum = 0;
+            int first = -1, runStart = -1, lastCovered = -1;
+            for (int x = start; x < end; ++x) {
+                if (!rowDirty[x >> kBlockShift]) {
+                    // No line touched this block, so its coverage is the same as the last pixel's.
+                    const int blockEnd = SkTMin((x | kBlockMask) + 1, end);
+                    if (runStart >= 0) {
+                        runs[runStart] += blockEnd - x;
+                    }
+                    x = blockEnd - 1;
+                    continue;
+                }
+                sum += row[x];
+                const float cov = SkTMin(sk_float_abs(sum), 1.0f);
+                const SkAlpha a = (SkAlpha)(cov * 255 + 0.5f);
+                if (runStart >= 0 && a == alpha[runStart]) {
+                    runs[runStart] += 1;
+                } else if (runStart >= 0 || a) {
+                    runStart = x - start;
+                    alpha[runStart] = a;
+                    runs[runStart] = 1;
+                    if (first < 0) {
+                        first = runStart;
+                    }
+                }
+                if (a) {
+                    lastCovered = runStart;
+                }
+            }
+            sk_bzero(row + start, (stop - start) * sizeof(float));
+            sk_bzero(rowDirty + (start >> kBlockShift),
+                     ((stop - 1) >> kBlockShift) - (start >> kBlockShift) + 1);
+            if (lastCovered < 0) {
+                continue;
+            }
+            runs[lastCovered + runs[lastCovered]] = 0;
+            blitter->blitAntiH(bounds.fLeft + start + first, bounds.fTop + stripTop + r,
+                               alpha.get() + first, runs.get() + first);
+        }
+    }
+}
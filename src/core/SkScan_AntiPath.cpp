@@ -599,7 +599,7 @@ static bool safeRoundOut(const SkRect& src, SkIRect* dst, int32_t maxInt) {
 }
 
 void SkScan::AntiFillPath(const SkPath& path, const SkRegion& origClip,
-                          SkBlitter* blitter, bool forceRLE) {
+                          SkBlitter* blitter, bool forceRLE, AAType aaType) {
     if (origClip.isEmpty()) {
         return;
     }
@@ -670,6 +670,14 @@ void SkScan::AntiFillPath(const SkPath& path, const SkRegion& origClip,
     // now use the (possibly wrapped) blitter
     blitter = clipper.getBlitter();
 
+    if (kAnalytic_AAType == aaType && !path.isInverseFillType() &&
+            SkPath::kWinding_FillType == path.getFillType()) {
+        if (clippedIR.intersect(clipRgn->getBounds())) {
+            sk_analytic_fill_path(path, clippedIR, blitter);
+        }
+        return;
+    }
+
     if (path.isInverseFillType()) {
         sk_blit_above(blitter, ir, *clipRgn);
     }
@@ -724,18 +732,23 @@ void SkScan::FillPath(const SkPath& path, const SkRasterClip& clip,
 
 void SkScan::AntiFillPath(const SkPath& path, const SkRasterClip& clip,
                           SkBlitter* blitter) {
+    AntiFillPath(path, clip, blitter, kSupersample_AAType);
+}
+
+void SkScan::AntiFillPath(const SkPath& path, const SkRasterClip& clip,
+                          SkBlitter* blitter, AAType aaType) {
     if (clip.isEmpty()) {
         return;
     }
 
     if (clip.isBW()) {
-        AntiFillPath(path, clip.bwRgn(), blitter);
+        AntiFillPath(path, clip.bwRgn(), blitter, false, aaType);
     } else {
         SkRegion        tmp;
         SkAAClipBlitter aaBlitter;
 
         tmp.setRect(clip.getBounds());
         aaBlitter.init(blitter, &clip.aaRgn());
-        SkScan::AntiFillPath(path, tmp, &aaBlitter, true);
+        SkScan::AntiFillPath(path, tmp, &aaBlitter, true, aaType);
     }
 }
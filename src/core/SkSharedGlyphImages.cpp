@@ -0,0 +1,277 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkSharedGlyphImages.h"
+
+#include "SkChecksum.h"
+#include "SkData.h"
+#include "SkDescriptor.h"
+#include "SkGlyph.h"
+#include "SkGraphics.h"
+#include "SkScalerContext.h"
+#include "SkStream.h"
+#include "SkTDArray.h"
+#include "SkThread.h"
+#include "SkTypeface.h"
+
+namespace {
+
+// The store is laid out as a Header, then fEntryCount Entries, then fImageBytes of images.
+// The processes sharing it have nothing else in common, and any of them may die at any moment, so
+// nobody ever waits on anybody else. fSequence is a seqlock: a writer claims the store by moving it
+// from even to odd, and releases it by moving it to the next even value. A writer that finds it
+// odd just doesn't add its glyph. Readers take no lock at all: they copy optimistically, and only
+// trust the copy if fSequence was even and unchanged throughout. If a writer dies mid-update,
+// fSequence stays odd, and the store simply stops finding or adding anything.
+struct Header {
+    int32_t  fMagic;
+    int32_t  fSequence;
+    uint32_t fEntryCount;       // A power of two.
+    uint32_t fEntriesUsed;
+    uint32_t fImageBytes;
+    uint32_t fImageBytesUsed;
+};
+
+struct Entry {
+    enum {
+        kKeyCount = 5
+    };
+    // Descriptor key (2), glyph ID, width | height << 16, mask format.
+    uint32_t fKey[kKeyCount];
+    uint32_t fOffset;           // Into the images.
+    uint32_t fSize;             // 0 if the entry is empty.
+};
+
+}  // namespace
+
+static const int32_t kSharedGlyphImagesMagic = 0x49475353;  // 'SSGI'
+
+static Header* gShared = NULL;
+
+static Header* get_shared() {
+    return sk_acquire_load(&gShared);
+}
+
+static Entry* get_entries(Header* header) {
+    return reinterpret_cast<Entry*>(header + 1);
+}
+
+static uint8_t* get_images(Header* header) {
+    return reinterpret_cast<uint8_t*>(get_entries(header) + header->fEntryCount);
+}
+
+// Returns the sequence number to pass to end_write(), or -1 if someone else is writing.
+static int32_t begin_write(Header* header) {
+    const int32_t sequence = sk_acquire_load(&header->fSequence);
+    if ((sequence & 1) || !sk_atomic_cas(&header->fSequence, sequence, sequence + 1)) {
+        return -1;
+    }
+    return sequence + 1;
+}
+
+static void end_write(Header* header, int32_t sequence) {
+    sk_release_store(&header->fSequence, sequence + 1);
+}
+
+static void make_key(const uint32_t descKey[2], const SkGlyph& glyph,
+                     uint32_t key[Entry::kKeyCount]) {
+    key[0] = descKey[0];
+    key[1] = descKey[1];
+    key[2] = glyph.fID;
+    key[3] = glyph.fWidth | (glyph.fHeight << 16);
+    key[4] = glyph.fMaskFormat;
+}
+
+// Returns the entry for key, or the empty entry where it would go. Readers may race a writer
+// here, so this gives up (returning NULL) rather than probe forever.
+static Entry* find_entry(Header* header, const uint32_t key[Entry::kKeyCount]) {
+    const uint32_t mask = header->fEntryCount - 1;
+    uint32_t index = SkChecksum::Murmur3(key, Entry::kKeyCount * sizeof(uint32_t)) & mask;
+    Entry* entries = get_entries(header);
+    for (uint32_t probes = 0; probes <= mask; probes++) {
+        Entry* entry = &entries[index];
+        if (0 == entry->fSize || 0 == memcmp(entry->fKey, key, sizeof(entry->fKey))) {
+            return entry;
+        }
+        index = (index + 1) & mask;
+    }
+    return NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool SkSharedGlyphImages::Initialize(void* memory, size_t bytes) {
+    if (NULL == memory || !SkIsAlign4((intptr_t)memory) || bytes > SK_MaxU32) {
+        return false;
+    }
+    // Give about an eighth of the space to the table, which is plenty for glyphs of ~100 bytes.
+    uint32_t entryCount = 16;
+    while (entryCount * 2 * sizeof(Entry) <= bytes / 8) {
+        entryCount *= 2;
+    }
+    size_t tableBytes = sizeof(Header) + entryCount * sizeof(Entry);
+    if (bytes < tableBytes + 1024) {
+        return false;
+    }
+
+    Header* header = static_cast<Header*>(memory);
+    sk_bzero(header, tableBytes);
+    header->fMagic = kSharedGlyphImagesMagic;
+    header->fEntryCount = entryCount;
+    header->fImageBytes = SkToU32(SkAlign4(bytes - tableBytes - 3));
+    return true;
+}
+
+void SkSharedGlyphImages::Install(void* memory) {
+    Header* header = static_cast<Header*>(memory);
+    SkASSERT(NULL == header || kSharedGlyphImagesMagic == header->fMagic);
+    sk_release_store(&gShared, header);
+}
+
+// Typeface IDs are only unique within a process, so we identify typefaces to other processes by
+// a hash of their serialized form, which we remember by ID.
+struct TypefaceHash {
+    SkFontID fID;
+    uint32_t fHash;
+};
+static SkTDArray<TypefaceHash> gTypefaceHashes;
+SK_DECLARE_STATIC_MUTEX(gTypefaceHashesMutex);
+
+static uint32_t typeface_hash(SkTypeface* typeface) {
+    SkFontID id = typeface->uniqueID();
+    {
+        SkAutoMutexAcquire ac(gTypefaceHashesMutex);
+        for (int i = 0; i < gTypefaceHashes.count(); ++i) {
+            if (gTypefaceHashes[i].fID == id) {
+                return gTypefaceHashes[i].fHash;
+            }
+        }
+    }
+
+    SkDynamicMemoryWStream stream;
+    typeface->serialize(&stream);
+    // Pad to a multiple of 4 for the checksum.
+    stream.padToAlign4();
+    SkAutoDataUnref data(stream.copyToData());
+    uint32_t hash = SkChecksum::Murmur3(static_cast<const uint32_t*>(data->data()),
+                                        data->size());
+
+    SkAutoMutexAcquire ac(gTypefaceHashesMutex);
+    TypefaceHash* entry = gTypefaceHashes.append();
+    entry->fID = id;
+    entry->fHash = hash;
+    return hash;
+}
+
+bool SkSharedGlyphImages::ComputeKey(SkTypeface* typeface, const SkDescriptor* desc,
+                                     uint32_t key[2]) {
+    if (NULL == get_shared() || NULL == typeface) {
+        return false;
+    }
+
+    size_t length = desc->getLength();
+    SkAutoDescriptor ad(length);
+    SkDescriptor* copy = ad.getDesc();
+    memcpy((void*)copy, desc, length);
+    SkScalerContext::Rec* rec = static_cast<SkScalerContext::Rec*>(
+            const_cast<void*>(copy->findEntry(kRec_SkDescriptorTag, NULL)));
+    // Leave fallback fonts, whose glyphs depend on the rest of the chain, to each process.
+    if (NULL == rec || rec->fOrigFontID != rec->fFontID) {
+        return false;
+    }
+    rec->fOrigFontID = rec->fFontID = typeface_hash(typeface);
+    copy->computeChecksum();
+
+    // Two different 32 bit hashes of the descriptor, to make collisions unlikely.
+    key[0] = copy->getChecksum();
+    key[1] = SkChecksum::Murmur3(reinterpret_cast<const uint32_t*>(copy), length);
+    return true;
+}
+
+bool SkSharedGlyphImages::Find(const uint32_t descKey[2], const SkGlyph& glyph) {
+    return Find(get_shared(), descKey, glyph);
+}
+
+void SkSharedGlyphImages::Add(const uint32_t descKey[2], const SkGlyph& glyph) {
+    Add(get_shared(), descKey, glyph);
+}
+
+bool SkSharedGlyphImages::Find(void* memory, const uint32_t descKey[2], const SkGlyph& glyph) {
+    Header* header = static_cast<Header*>(memory);
+    if (NULL == header || NULL == glyph.fImage) {
+        return false;
+    }
+    uint32_t key[Entry::kKeyCount];
+    make_key(descKey, glyph, key);
+    size_t size = glyph.computeImageSize();
+
+    const int32_t sequence = sk_acquire_load(&header->fSequence);
+    if (sequence & 1) {
+        return false;
+    }
+    const Entry* entry = find_entry(header, key);
+    if (NULL == entry) {
+        return false;
+    }
+    // A writer may be changing the entry as we read it, so bounds check what we find.
+    const uint32_t offset = sk_acquire_load(&entry->fOffset),
+                   found  = sk_acquire_load(&entry->fSize);
+    if (found != size || size > header->fImageBytes || offset > header->fImageBytes - size) {
+        return false;
+    }
+    memcpy(glyph.fImage, get_images(header) + offset, size);
+    // The CAS is a full barrier, so this checks fSequence after all our reads are done.
+    return sk_atomic_cas(&header->fSequence, sequence, sequence);
+}
+
+void SkSharedGlyphImages::Add(void* memory, const uint32_t descKey[2], const SkGlyph& glyph) {
+    Header* header = static_cast<Header*>(memory);
+    if (NULL == header || NULL == glyph.fImage) {
+        return;
+    }
+    size_t size = glyph.computeImageSize();
+    // Leave big glyphs to each process, so they don't keep emptying the store.
+    if (0 == size || size > header->fImageBytes / 16) {
+        return;
+    }
+    uint32_t key[Entry::kKeyCount];
+    make_key(descKey, glyph, key);
+
+    const int32_t sequence = begin_write(header);
+    if (sequence < 0) {
+        return;
+    }
+    Entry* entry = find_entry(header, key);
+    SkASSERT(NULL != entry);  // With the table at most 3/4 full, there's always an empty entry.
+    if (0 == entry->fSize) {
+        // Keep the table at most 3/4 full, so probes stay short.
+        if (4 * (header->fEntriesUsed + 1) > 3 * header->fEntryCount ||
+            header->fImageBytesUsed + SkAlign4(size) > header->fImageBytes) {
+            sk_bzero(get_entries(header), header->fEntryCount * sizeof(Entry));
+            header->fEntriesUsed = 0;
+            header->fImageBytesUsed = 0;
+            entry = find_entry(header, key);
+        }
+        memcpy(entry->fKey, key, sizeof(entry->fKey));
+        entry->fOffset = header->fImageBytesUsed;
+        entry->fSize = SkToU32(size);
+        memcpy(get_images(header) + entry->fOffset, glyph.fImage, size);
+        header->fEntriesUsed += 1;
+        header->fImageBytesUsed += SkToU32(SkAlign4(size));
+    }
+    end_write(header, sequence);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool SkGraphics::InitSharedGlyphImageCache(void* memory, size_t bytes) {
+    return SkSharedGlyphImages::Initialize(memory, bytes);
+}
+
+void SkGraphics::SetSharedGlyphImageCache(void* memory) {
+    SkSharedGlyphImages::Install(memory);
+}
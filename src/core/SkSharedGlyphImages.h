@@ -0,0 +1,53 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkSharedGlyphImages_DEFINED
+#define SkSharedGlyphImages_DEFINED
+
+#include "SkTypes.h"
+
+class SkDescriptor;
+class SkTypeface;
+struct SkGlyph;
+
+/**
+ *  A store of rasterized glyph images in memory shared by several processes, so that a glyph one
+ *  of them has scaled need not be scaled again by the others. SkScalerContext::getImage() looks
+ *  here first, and adds what it makes.
+ *
+ *  Images are keyed by a checksum of the glyph's SkDescriptor, with the typeface's process-local
+ *  font ID swapped for a hash of its serialized form, plus the glyph's ID and dimensions. When
+ *  either the table or the image space fills up, everything is dropped and it starts over.
+ *
+ *  See SkGraphics::InitSharedGlyphImageCache() and SkGraphics::SetSharedGlyphImageCache().
+ */
+class SkSharedGlyphImages {
+public:
+    /** Lays out an empty store in memory, which must be 4-byte aligned. */
+    static bool Initialize(void* memory, size_t bytes);
+
+    /** Starts (or with NULL, stops) using the store in memory from this process. */
+    static void Install(void* memory);
+
+    /**
+     *  If a store is installed, sets key to identify desc across processes and returns true.
+     *  typeface is the one desc is for.
+     */
+    static bool ComputeKey(SkTypeface* typeface, const SkDescriptor* desc, uint32_t key[2]);
+
+    /** Copies the image for glyph into glyph.fImage, if the installed store has one. */
+    static bool Find(const uint32_t key[2], const SkGlyph& glyph);
+
+    /** Adds glyph.fImage to the installed store. */
+    static void Add(const uint32_t key[2], const SkGlyph& glyph);
+
+    /** As above, for the store in memory, installed or not. */
+    static bool Find(void* memory, const uint32_t key[2], const SkGlyph& glyph);
+    static void Add(void* memory, const uint32_t key[2], const SkGlyph& glyph);
+};
+
+#endif
@@ -0,0 +1,236 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkTextMeasureCache.h"
+
+#include "SkGraphics.h"
+#include "SkLazyPtr.h"
+#include "SkPaint.h"
+#include "SkTDynamicHash.h"
+#include "SkThread.h"
+#include "SkTypeface.h"
+
+// One round of Murmur3 (see SkChecksum::Murmur3), which we can't use directly since the text
+// needn't be aligned or a multiple of 4 bytes long.
+static uint32_t mix(uint32_t hash, uint32_t k) {
+    k *= 0xcc9e2d51;
+    k = (k << 15) | (k >> 17);
+    k *= 0x1b873593;
+
+    hash ^= k;
+    hash = (hash << 13) | (hash >> 19);
+    return hash * 5 + 0xe6546b64;
+}
+
+static uint32_t scalar_bits(SkScalar x) {
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    return bits;
+}
+
+static void make_key(const SkPaint& paint, const void* text, size_t byteLength,
+                     SkTextAdvances::Key* key) {
+    key->fFontID = SkTypeface::UniqueID(paint.getTypeface());
+    key->fTextSize = paint.getTextSize();
+    key->fTextScaleX = paint.getTextScaleX();
+    key->fTextSkewX = paint.getTextSkewX();
+    key->fFlags = paint.getFlags();
+    key->fHintingAndEncoding = paint.getHinting() | (paint.getTextEncoding() << 8);
+    key->fByteLength = SkToU32(byteLength);
+    key->fText = text;
+
+    uint32_t hash = mix(0, key->fFontID);
+    hash = mix(hash, scalar_bits(key->fTextSize));
+    hash = mix(hash, scalar_bits(key->fTextScaleX));
+    hash = mix(hash, scalar_bits(key->fTextSkewX));
+    hash = mix(hash, key->fFlags);
+    hash = mix(hash, key->fHintingAndEncoding);
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(text);
+    size_t i = 0;
+    for (; i + 4 <= byteLength; i += 4) {
+        uint32_t k;
+        memcpy(&k, bytes + i, sizeof(k));
+        hash = mix(hash, k);
+    }
+    uint32_t tail = 0;
+    for (; i < byteLength; ++i) {
+        tail = (tail << 8) | bytes[i];
+    }
+    hash = mix(hash, tail);
+
+    hash ^= key->fByteLength;
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6b;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35;
+    hash ^= hash >> 16;
+    key->fHash = hash;
+}
+
+bool SkTextAdvances::Key::operator==(const Key& other) const {
+    return fHash == other.fHash &&
+           fByteLength == other.fByteLength &&
+           fFontID == other.fFontID &&
+           fTextSize == other.fTextSize &&
+           fTextScaleX == other.fTextScaleX &&
+           fTextSkewX == other.fTextSkewX &&
+           fFlags == other.fFlags &&
+           fHintingAndEncoding == other.fHintingAndEncoding &&
+           0 == memcmp(fText, other.fText, fByteLength);
+}
+
+SkTextAdvances::SkTextAdvances(const Key& key, SkScalar scale, bool devKernText,
+                               const Advance advances[], int count)
+    : fKey(key)
+    , fScale(scale)
+    , fDevKernText(devKernText)
+    , fCount(count) {
+    // The text lives just after the advances, in the same block.
+    fAdvances = (Advance*)sk_malloc_throw(count * sizeof(Advance) + key.fByteLength);
+    memcpy(fAdvances, advances, count * sizeof(Advance));
+    void* text = fAdvances + count;
+    memcpy(text, key.fText, key.fByteLength);
+    fKey.fText = text;
+}
+
+SkTextAdvances::~SkTextAdvances() {
+    sk_free(fAdvances);
+}
+
+size_t SkTextAdvances::bytesUsed() const {
+    return sizeof(*this) + fCount * sizeof(Advance) + fKey.fByteLength;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Guarded by gTextMeasureCacheMutex, except that gLimit may be read without it.
+struct TextMeasureCache {
+    TextMeasureCache() : fBytesUsed(0) {}
+
+    ~TextMeasureCache() {
+        this->purge(0);
+    }
+
+    void remove(SkTextAdvances* advances) {
+        fHash.remove(SkTextAdvances::GetKey(*advances));
+        fLRU.remove(advances);
+        fBytesUsed -= advances->bytesUsed();
+        advances->unref();
+    }
+
+    void purge(size_t limit) {
+        while (fBytesUsed > limit) {
+            SkASSERT(NULL != fLRU.tail());
+            this->remove(fLRU.tail());
+        }
+    }
+
+    SkTDynamicHash<SkTextAdvances, SkTextAdvances::Key> fHash;
+    SkTInternalLList<SkTextAdvances>                    fLRU;   // Most recently used first.
+    size_t                                              fBytesUsed;
+};
+
+TextMeasureCache* create_cache() {
+    return SkNEW(TextMeasureCache);
+}
+
+}  // namespace
+
+SK_DECLARE_STATIC_MUTEX(gTextMeasureCacheMutex);
+static size_t gLimit = 0;
+
+static TextMeasureCache& get_cache() {
+    SK_DECLARE_STATIC_LAZY_PTR(TextMeasureCache, cache, create_cache);
+    return *cache.get();
+}
+
+bool SkTextMeasureCache::CanCache(size_t byteLength) {
+    // Don't let any one text take more than an eighth of the cache.
+    return byteLength > 0 && byteLength <= sk_acquire_load(&gLimit) / 8;
+}
+
+SkTextAdvances* SkTextMeasureCache::Find(const SkPaint& paint, const void* text,
+                                         size_t byteLength) {
+    SkTextAdvances::Key key;
+    make_key(paint, text, byteLength, &key);
+
+    TextMeasureCache& cache = get_cache();
+    SkAutoMutexAcquire ac(gTextMeasureCacheMutex);
+    SkTextAdvances* advances = cache.fHash.find(key);
+    if (NULL != advances) {
+        cache.fLRU.remove(advances);
+        cache.fLRU.addToHead(advances);
+        advances->ref();
+    }
+    return advances;
+}
+
+SkTextAdvances* SkTextMeasureCache::Add(const SkPaint& paint, const void* text, size_t byteLength,
+                                        SkScalar scale, bool devKernText,
+                                        const SkTextAdvances::Advance advances[], int count) {
+    SkTextAdvances::Key key;
+    make_key(paint, text, byteLength, &key);
+
+    TextMeasureCache& cache = get_cache();
+    SkAutoMutexAcquire ac(gTextMeasureCacheMutex);
+    SkTextAdvances* existing = cache.fHash.find(key);
+    if (NULL != existing) {
+        existing->ref();
+        return existing;
+    }
+
+    SkTextAdvances* added = SkNEW_ARGS(SkTextAdvances, (key, scale, devKernText, advances, count));
+    cache.fHash.add(added);
+    cache.fLRU.addToHead(added);
+    cache.fBytesUsed += added->bytesUsed();
+    // Ref it for the caller before purging, in case the limit has just been lowered.
+    added->ref();
+    cache.purge(gLimit);
+    return added;
+}
+
+size_t SkTextMeasureCache::GetLimit() {
+    return sk_acquire_load(&gLimit);
+}
+
+size_t SkTextMeasureCache::SetLimit(size_t bytes) {
+    TextMeasureCache& cache = get_cache();
+    SkAutoMutexAcquire ac(gTextMeasureCacheMutex);
+    size_t prev = gLimit;
+    sk_release_store(&gLimit, bytes);
+    cache.purge(bytes);
+    return prev;
+}
+
+size_t SkTextMeasureCache::GetBytesUsed() {
+    TextMeasureCache& cache = get_cache();
+    SkAutoMutexAcquire ac(gTextMeasureCacheMutex);
+    return cache.fBytesUsed;
+}
+
+void SkTextMeasureCache::PurgeAll() {
+    TextMeasureCache& cache = get_cache();
+    SkAutoMutexAcquire ac(gTextMeasureCacheMutex);
+    cache.purge(0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+size_t SkGraphics::GetTextMeasureCacheLimit() {
+    return SkTextMeasureCache::GetLimit();
+}
+
+size_t SkGraphics::SetTextMeasureCacheLimit(size_t bytes) {
+    return SkTextMeasureCache::SetLimit(bytes);
+}
+
+size_t SkGraphics::GetTextMeasureCacheBytesUsed() {
+    return SkTextMeasureCache::GetBytesUsed();
+}
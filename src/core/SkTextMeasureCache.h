@@ -0,0 +1,113 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkTextMeasureCache_DEFINED
+#define SkTextMeasureCache_DEFINED
+
+#include "SkFixed.h"
+#include "SkRefCnt.h"
+#include "SkScalar.h"
+#include "SkTInternalLList.h"
+
+class SkPaint;
+
+/**
+ *  The per-glyph advances of a run of text, as measured with a given paint. Along with each
+ *  advance we keep the glyph's auto-kerning deltas, so the advances can stand in for the glyphs
+ *  in all of SkPaint's measuring calls, and how many bytes of the text the glyph came from.
+ */
+class SkTextAdvances : public SkRefCnt {
+public:
+    struct Advance {
+        SkFixed fAdvance;       // fAdvanceX, or fAdvanceY for vertical text.
+        int8_t  fLsbDelta;
+        int8_t  fRsbDelta;
+        uint8_t fByteLength;
+    };
+
+    int count() const { return fCount; }
+    const Advance* advances() const { return fAdvances; }
+    const Advance& operator[](int index) const {
+        SkASSERT(index >= 0 && index < fCount);
+        return fAdvances[index];
+    }
+
+    /**
+     *  The advances are measured with the paint canonicalized as SkPaint's measuring calls do.
+     *  Returns what they must scale the result by, or 0 if the paint was used as it was.
+     */
+    SkScalar scale() const { return fScale; }
+
+    /** Returns the canonicalized paint's isDevKernText(). */
+    bool isDevKernText() const { return fDevKernText; }
+
+    /** Returns how much memory these advances, and their copy of the text, take up. */
+    size_t bytesUsed() const;
+
+    virtual ~SkTextAdvances();
+
+    struct Key {
+        uint32_t    fFontID;
+        SkScalar    fTextSize;
+        SkScalar    fTextScaleX;
+        SkScalar    fTextSkewX;
+        uint32_t    fFlags;
+        uint32_t    fHintingAndEncoding;
+        uint32_t    fByteLength;
+        uint32_t    fHash;          // Of all the above, and the text.
+        const void* fText;
+
+        bool operator==(const Key&) const;
+    };
+    static const Key& GetKey(const SkTextAdvances& advances) { return advances.fKey; }
+    static uint32_t Hash(const Key& key) { return key.fHash; }
+
+private:
+    SkTextAdvances(const Key&, SkScalar scale, bool devKernText, const Advance[], int count);
+
+    Key         fKey;           // fKey.fText points to our own copy.
+    SkScalar    fScale;
+    bool        fDevKernText;
+    int         fCount;
+    Advance*    fAdvances;
+
+    SK_DECLARE_INTERNAL_LLIST_INTERFACE(SkTextAdvances);
+
+    friend class SkTextMeasureCache;
+
+    typedef SkRefCnt INHERITED;
+};
+
+/**
+ *  A bounded cache of recently measured text, so that measuring the same text again with the
+ *  same font settings takes its advances from here, rather than looking up each glyph in the glyph
+ *  cache. It is off until given a limit with SkGraphics::SetTextMeasureCacheLimit(). When it
+ *  needs more space, it drops the least recently used text.
+ */
+class SkTextMeasureCache {
+public:
+    /** Returns true if the cache is on, and text of byteLength isn't too long for it. */
+    static bool CanCache(size_t byteLength);
+
+    /** Returns the advances for text measured with paint, ref'd, or NULL if they aren't here. */
+    static SkTextAdvances* Find(const SkPaint&, const void* text, size_t byteLength);
+
+    /**
+     *  Adds the advances for text measured with paint, and returns them ref'd. If another thread
+     *  has added them already, returns those instead.
+     */
+    static SkTextAdvances* Add(const SkPaint&, const void* text, size_t byteLength,
+                               SkScalar scale, bool devKernText,
+                               const SkTextAdvances::Advance[], int count);
+
+    static size_t GetLimit();
+    static size_t SetLimit(size_t bytes);
+    static size_t GetBytesUsed();
+    static void PurgeAll();
+};
+
+#endif
@@ -7,9 +7,9 @@
  */
 
 #include "SkTileGrid.h"
+#include "SkTemplates.h"
 
-SkTileGrid::SkTileGrid(int xTileCount, int yTileCount, const SkTileGridFactory::TileGridInfo& info,
-                       SkTileGridNextDatumFunctionPtr nextDatumFunction) {
+SkTileGrid::SkTileGrid(int xTileCount, int yTileCount, const SkTileGridFactory::TileGridInfo& info) {
     fXTileCount = xTileCount;
     fYTileCount = yTileCount;
     fInfo = info;
@@ -18,11 +18,9 @@ SkTileGrid::SkTileGrid(int xTileCount, int yTileCount, const SkTileGridFactory::
     fInfo.fMargin.fHeight++;
     fInfo.fMargin.fWidth++;
     fTileCount = fXTileCount * fYTileCount;
-    fInsertionCount = 0;
     fGridBounds = SkIRect::MakeXYWH(0, 0, fInfo.fTileInterval.width() * fXTileCount,
         fInfo.fTileInterval.height() * fYTileCount);
-    fNextDatumFunction = nextDatumFunction;
-    fTileData = SkNEW_ARRAY(SkTDArray<void *>, fTileCount);
+    fTileData = SkNEW_ARRAY(SkTDArray<int>, fTileCount);
 }
 
 SkTileGrid::~SkTileGrid() {
@@ -33,7 +31,7 @@ int SkTileGrid::tileCount(int x, int y) {
     return this->tile(x, y).count();
 }
 
-SkTDArray<void *>& SkTileGrid::tile(int x, int y) {
+SkTDArray<int>& SkTileGrid::tile(int x, int y) {
     return fTileData[y * fXTileCount + x];
 }
 
@@ -57,12 +55,13 @@ void SkTileGrid::insert(void* data, const SkIRect& bounds, bool) {
     int maxTileY = SkMax32(SkMin32((dilatedBounds.bottom() -1) / fInfo.fTileInterval.height(),
         fYTileCount -1), 0);
 
+    const int index = fData.count();
+    fData.push(data);
     for (int x = minTileX; x <= maxTileX; x++) {
         for (int y = minTileY; y <= maxTileY; y++) {
-            this->tile(x, y).push(data);
+            this->tile(x, y).push(index);
         }
     }
-    fInsertionCount++;
 }
 
 void SkTileGrid::search(const SkIRect& query, SkTDArray<void*>* results) {
@@ -91,23 +90,42 @@ void SkTileGrid::search(const SkIRect& query, SkTDArray<void*>* results) {
     int queryTileCount = (tileEndX - tileStartX) * (tileEndY - tileStartY);
     SkASSERT(queryTileCount);
     if (queryTileCount == 1) {
-        *results = this->tile(tileStartX, tileStartY);
+        const SkTDArray<int>& tile = this->tile(tileStartX, tileStartY);
+        results->setCount(tile.count());
+        for (int i = 0; i < tile.count(); i++) {
+            (*results)[i] = fData[tile[i]];
+        }
     } else {
+        // Each tile's indices are increasing, so merging them in index order returns the data in
+        // the order they were inserted.  A datum spanning several tiles is returned once.
         results->reset();
+        SkAutoSTArray<kStackAllocationTileCount, const SkTDArray<int>*> tiles(queryTileCount);
         SkAutoSTArray<kStackAllocationTileCount, int> curPositions(queryTileCount);
-        SkAutoSTArray<kStackAllocationTileCount, SkTDArray<void *>*> storage(queryTileCount);
-        SkTDArray<void *>** tileRange = storage.get();
         int tile = 0;
         for (int x = tileStartX; x < tileEndX; ++x) {
             for (int y = tileStartY; y < tileEndY; ++y) {
-                tileRange[tile] = &this->tile(x, y);
-                curPositions[tile] = tileRange[tile]->count() ? 0 : kTileFinished;
+                tiles[tile] = &this->tile(x, y);
+                curPositions[tile] = 0;
                 ++tile;
             }
         }
-        void *nextElement;
-        while(NULL != (nextElement = fNextDatumFunction(tileRange, curPositions))) {
-            results->push(nextElement);
+        for (;;) {
+            int next = fData.count();
+            for (tile = 0; tile < queryTileCount; ++tile) {
+                if (curPositions[tile] < tiles[tile]->count()) {
+                    next = SkMin32(next, (*tiles[tile])[curPositions[tile]]);
+                }
+            }
+            if (next == fData.count()) {
+                break;
+            }
+            results->push(fData[next]);
+            for (tile = 0; tile < queryTileCount; ++tile) {
+                if (curPositions[tile] < tiles[tile]->count() &&
+                    (*tiles[tile])[curPositions[tile]] == next) {
+                    ++curPositions[tile];
+                }
+            }
         }
     }
 }
@@ -116,16 +134,20 @@ void SkTileGrid::clear() {
     for (int i = 0; i < fTileCount; i++) {
         fTileData[i].reset();
     }
+    fData.reset();
 }
 
 int SkTileGrid::getCount() const {
-    return fInsertionCount;
+    return fData.count();
 }
 
 void SkTileGrid::rewindInserts() {
     SkASSERT(fClient);
+    while (!fData.isEmpty() && fClient->shouldRewind(fData.top())) {
+        fData.pop();
+    }
     for (int i = 0; i < fTileCount; ++i) {
-        while (!fTileData[i].isEmpty() && fClient->shouldRewind(fTileData[i].top())) {
+        while (!fTileData[i].isEmpty() && fTileData[i].top() >= fData.count()) {
             fTileData[i].pop();
         }
     }
@@ -11,7 +11,6 @@
 
 #include "SkBBHFactory.h"
 #include "SkBBoxHierarchy.h"
-#include "SkPictureStateTree.h"
 
 /**
  * Subclass of SkBBoxHierarchy that stores elements in buckets that correspond
@@ -22,6 +21,10 @@
  * Note: Current implementation of search() only supports looking-up regions
  * that are an exact match to a single tile.  Implementation could be augmented
  * to support arbitrary rectangles, but performance would be sub-optimal.
+ *
+ * Tiles hold the insertion order of their data rather than the data themselves, so results from
+ * several tiles are merged back into insertion order without knowing what the data point to.
+ * Data may be anything that fits in a void*, including NULL and small integers.
  */
 class SkTileGrid : public SkBBoxHierarchy {
 public:
@@ -33,10 +36,7 @@ public:
         kStackAllocationTileCount = 1024
     };
 
-    typedef void* (*SkTileGridNextDatumFunctionPtr)(SkTDArray<void*>** tileData, SkAutoSTArray<kStackAllocationTileCount, int>& tileIndices);
-
-    SkTileGrid(int xTileCount, int yTileCount, const SkTileGridFactory::TileGridInfo& info,
-        SkTileGridNextDatumFunctionPtr nextDatumFunction);
+    SkTileGrid(int xTileCount, int yTileCount, const SkTileGridFactory::TileGridInfo& info);
 
     virtual ~SkTileGrid();
 
@@ -67,76 +67,18 @@ public:
 
     virtual void rewindInserts() SK_OVERRIDE;
 
-    // Used by search() and in SkTileGridHelper implementations
-    enum {
-        kTileFinished = -1,
-    };
-
     int tileCount(int x, int y);  // For testing only.
 
 private:
-    SkTDArray<void*>& tile(int x, int y);
+    SkTDArray<int>& tile(int x, int y);
 
     int fXTileCount, fYTileCount, fTileCount;
     SkTileGridFactory::TileGridInfo fInfo;
-    SkTDArray<void*>* fTileData;
-    int fInsertionCount;
+    SkTDArray<void*> fData;     // Every datum inserted into at least one tile, in insertion order.
+    SkTDArray<int>* fTileData;  // Per tile, increasing indices into fData.
     SkIRect fGridBounds;
-    SkTileGridNextDatumFunctionPtr fNextDatumFunction;
 
     typedef SkBBoxHierarchy INHERITED;
 };
 
-/**
- * Generic implementation for SkTileGridNextDatumFunctionPtr. user code may instantiate
- * this template to get a valid SkTileGridNextDatumFunction implementation
- *
- * Returns the next element of tileData[i][tileIndices[i]] for all i and advances
- * tileIndices[] past them. The order in which data are returned by successive
- * calls to this method must reflect the order in which the were originally
- * recorded into the tile grid.
- *
- * \param tileData array of pointers to arrays of tile data
- * \param tileIndices per-tile data indices, indices are incremented for tiles that contain
- *     the next datum.
- * \tparam T a type to which it is safe to cast a datum and that has an operator <
- *     such that 'a < b' is true if 'a' was inserted into the tile grid before 'b'.
- */
-template <typename T>
-void* SkTileGridNextDatum(SkTDArray<void*>** tileData, SkAutoSTArray<SkTileGrid::kStackAllocationTileCount, int>& tileIndices) {
-    T* minVal = NULL;
-    int tileCount = tileIndices.count();
-    int minIndex = tileCount;
-    int maxIndex = 0;
-    // Find the next Datum; track where it's found so we reduce the size of the second loop.
-    for (int tile = 0; tile < tileCount; ++tile) {
-        int pos = tileIndices[tile];
-        if (pos != SkTileGrid::kTileFinished) {
-            T* candidate = (T*)(*tileData[tile])[pos];
-            if (NULL == minVal || (*candidate) < (*minVal)) {
-                minVal = candidate;
-                minIndex = tile;
-                maxIndex = tile;
-            } else if (!((*minVal) < (*candidate))) {
-                // We don't require operator==; if !(candidate<minVal) && !(minVal<candidate),
-                // candidate==minVal and we have to add this tile to the range searched.
-                maxIndex = tile;
-            }
-        }
-    }
-    // Increment indices past the next datum
-    if (minVal != NULL) {
-        for (int tile = minIndex; tile <= maxIndex; ++tile) {
-            int pos = tileIndices[tile];
-            if (pos != SkTileGrid::kTileFinished && (*tileData[tile])[pos] == minVal) {
-                if (++(tileIndices[tile]) >= tileData[tile]->count()) {
-                    tileIndices[tile] = SkTileGrid::kTileFinished;
-                }
-            }
-        }
-        return minVal;
-    }
-    return NULL;
-}
-
 #endif
@@ -6,6 +6,7 @@
  */
 
 #include "SkAdvancedTypefaceMetrics.h"
+#include "SkCmapCache.h"
 #include "SkFontDescriptor.h"
 #include "SkFontHost.h"
 #include "SkLazyPtr.h"
@@ -19,7 +20,7 @@
 #endif
 
 SkTypeface::SkTypeface(Style style, SkFontID fontID, bool isFixedPitch)
-    : fUniqueID(fontID), fStyle(style), fIsFixedPitch(isFixedPitch) {
+    : fUniqueID(fontID), fStyle(style), fIsFixedPitch(isFixedPitch), fCmapCache(NULL) {
 #ifdef TRACE_LIFECYCLE
     SkDebugf("SkTypeface: create  %p fontID %d total %d\n",
              this, fontID, ++gTypefaceCounter);
@@ -31,6 +32,7 @@ SkTypeface::~SkTypeface() {
     SkDebugf("SkTypeface: destroy %p fontID %d total %d\n",
              this, fUniqueID, --gTypefaceCounter);
 #endif
+    SkDELETE(fCmapCache);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -228,7 +230,21 @@ int SkTypeface::charsToGlyphs(const void* chars, Encoding encoding,
         }
         return 0;
     }
-    return this->onCharsToGlyphs(chars, encoding, glyphs, glyphCount);
+
+    return this->getCmapCache()->charsToGlyphs(this, chars, encoding, glyphs, glyphCount);
+}
+
+SkCmapCache* SkTypeface::getCmapCache() const {
+    SkCmapCache* cache = sk_acquire_load(&fCmapCache);
+    if (NULL == cache) {
+        cache = SkNEW(SkCmapCache);
+        SkCmapCache* prev = (SkCmapCache*)sk_atomic_cas((void**)&fCmapCache, NULL, cache);
+        if (NULL != prev) {
+            SkDELETE(cache);
+            cache = prev;
+        }
+    }
+    return cache;
 }
 
 int SkTypeface::countGlyphs() const {
@@ -9,6 +9,8 @@
 
 #include "SkUtils.h"
 #include "SkLazyFnPtr.h"
+#include "SkTLS.h"
+#include "SkThread.h"
 
 #if 0
 #define assign_16_longs(dst, value)             \
@@ -113,8 +115,24 @@ static void sk_memcpy32_portable(uint32_t dst[], const uint32_t src[], int count
     memcpy(dst, src, count * sizeof(uint32_t));
 }
 
+static int sk_utf8_count_leading_ascii_portable(const char utf8[], int count) {
+    int i = 0;
+    while (i < count && (utf8[i] & 0x80) == 0) {
+        i += 1;
+    }
+    return i;
+}
+
+static int sk_utf16_count_leading_non_surrogates_portable(const uint16_t utf16[], int count) {
+    int i = 0;
+    while (i < count && (utf16[i] & 0xF800) != 0xD800) {
+        i += 1;
+    }
+    return i;
+}
+
 namespace {
-// These three methods technically need external linkage to be passed as template parameters.
+// These methods technically need external linkage to be passed as template parameters.
 // Since they can't be static, we hide them in an anonymous namespace instead.
 
 SkMemset16Proc choose_memset16() {
@@ -132,8 +150,51 @@ SkMemcpy32Proc choose_memcpy32() {
     return proc ? proc : sk_memcpy32_portable;
 }
 
+SkUTF8_CountLeadingASCIIProc choose_utf8_count_leading_ascii() {
+    SkUTF8_CountLeadingASCIIProc proc = SkUTF8_CountLeadingASCIIGetPlatformProc();
+    return proc ? proc : sk_utf8_count_leading_ascii_portable;
+}
+
+SkUTF16_CountLeadingNonSurrogatesProc choose_utf16_count_leading_non_surrogates() {
+    SkUTF16_CountLeadingNonSurrogatesProc proc =
+            SkUTF16_CountLeadingNonSurrogatesGetPlatformProc();
+    return proc ? proc : sk_utf16_count_leading_non_surrogates_portable;
+}
+
 }  // namespace
 
+static void* create_simd_level_cap() {
+    return SkNEW_ARGS(int, (SK_MaxS32));
+}
+
+static void delete_simd_level_cap(void* cap) {
+    SkDELETE((int*)cap);
+}
+
+// How many threads have a cap set.  Usually none, and then we needn't look in TLS for one.
+static int32_t gCappedThreads = 0;
+
+int SkSetSIMDLevelCap(int level) {
+    int* cap = (int*)SkTLS::Get(create_simd_level_cap, delete_simd_level_cap);
+    int prev = *cap;
+    if (SK_MaxS32 == prev && SK_MaxS32 != level) {
+        sk_atomic_inc(&gCappedThreads);
+    } else if (SK_MaxS32 != prev && SK_MaxS32 == level) {
+        sk_atomic_dec(&gCappedThreads);
+    }
+    *cap = level;
+    return prev;
+}
+
+int SkGetSIMDLevelCap() {
+    // If this thread set a cap, it saw its own increment.
+    if (0 == sk_acquire_load(&gCappedThreads)) {
+        return SK_MaxS32;
+    }
+    const int* cap = (const int*)SkTLS::Find(create_simd_level_cap);
+    return NULL != cap ? *cap : SK_MaxS32;
+}
+
 void sk_memset16(uint16_t dst[], uint16_t value, int count) {
     SK_DECLARE_STATIC_LAZY_FN_PTR(SkMemset16Proc, proc, choose_memset16);
     proc.get()(dst, value, count);
@@ -149,6 +210,18 @@ void sk_memcpy32(uint32_t dst[], const uint32_t src[], int count) {
     proc.get()(dst, src, count);
 }
 
+int SkUTF8_CountLeadingASCII(const char utf8[], int count) {
+    SK_DECLARE_STATIC_LAZY_FN_PTR(SkUTF8_CountLeadingASCIIProc, proc,
+                                  choose_utf8_count_leading_ascii);
+    return proc.get()(utf8, count);
+}
+
+int SkUTF16_CountLeadingNonSurrogates(const uint16_t utf16[], int count) {
+    SK_DECLARE_STATIC_LAZY_FN_PTR(SkUTF16_CountLeadingNonSurrogatesProc, proc,
+                                  choose_utf16_count_leading_non_surrogates);
+    return proc.get()(utf16, count);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 /*  0xxxxxxx    1 total
@@ -64,6 +64,11 @@ size_t SkWriter32::WriteStringSize(const char* str, size_t len) {
 }
 
 void SkWriter32::growToAtLeast(size_t size) {
+    if (fSegmentBytes > 0) {
+        this->newSegment(size - fUsed);
+        return;
+    }
+
     const bool wasExternal = (fExternal != NULL) && (fData == fExternal);
 
     fCapacity = 4096 + SkTMax(size, fCapacity + (fCapacity / 2));
@@ -87,7 +92,11 @@ SkData* SkWriter32::snapshotAsData() const {
     }
     if (fSnapshot.get() == NULL) {
         uint8_t* buffer = NULL;
-        if ((fExternal != NULL) && (fData == fExternal)) {
+        if (fSegmentBytes > 0) {
+            // Segments are never handed out, so gather them into a new buffer.
+            buffer = (uint8_t*)sk_malloc_throw(fUsed);
+            this->flatten(buffer);
+        } else if ((fExternal != NULL) && (fData == fExternal)) {
             // We need to copy to an allocated buffer before returning.
             buffer = (uint8_t*)sk_malloc_throw(fUsed);
             memcpy(buffer, fData, fUsed);
@@ -103,3 +112,138 @@ SkData* SkWriter32::snapshotAsData() const {
     }
     return SkRef(fSnapshot.get()); // Take an extra ref for the caller.
 }
+
+bool SkWriter32::writeToStream(SkWStream* stream) const {
+    if (0 == fSegmentStart) {
+        return stream->write(fData, fUsed);
+    }
+    SkTDArray<Segment> segments;
+    this->getSegments(&segments);
+    for (int i = 0; i < segments.count(); ++i) {
+        if (!stream->write(segments[i].fData, segments[i].fSize)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void SkWriter32::useSegments(size_t segmentBytes, SkChunkAlloc* arena) {
+    SkASSERT(0 == fUsed);
+    SkASSERT(segmentBytes > 0);
+
+    fSegmentBytes = SkAlign4(segmentBytes);
+    if (NULL != arena) {
+        fOwnedArena.free();
+        fArena = arena;
+    } else {
+        fOwnedArena.reset(SkNEW_ARGS(SkChunkAlloc, (fSegmentBytes)));
+        fArena = fOwnedArena.get();
+    }
+
+    if (fData != fExternal) {
+        // Drop any buffer we grew before switching; nothing in it is kept.
+        fInternal.reset(0);
+        fData = NULL;
+        fCapacity = 0;
+        fExternal = NULL;
+    }
+    this->resetSegments();
+}
+
+void SkWriter32::resetSegments() {
+    SkASSERT(0 == fUsed);
+    fSegments.rewind();
+    if (NULL != fOwnedArena.get()) {
+        fOwnedArena->reset();
+    }
+    if (NULL != fData) {
+        SegmentRec* rec = fSegments.append();
+        rec->fData = fData;
+        rec->fStart = 0;
+        rec->fCapacity = fCapacity;
+    }
+}
+
+void SkWriter32::newSegment(size_t minBytes) {
+    size_t bytes = SkTMax(fSegmentBytes, SkAlign4(minBytes));
+    uint8_t* data = (uint8_t*)fArena->allocThrow(bytes);
+
+    // A segment nothing was written to is replaced, so no two segments ever start at the
+    // same offset, and findSegment() is unambiguous.
+    SegmentRec* rec;
+    if (fSegments.count() > 0 && fSegments.top().fStart == fUsed) {
+        rec = &fSegments.top();
+    } else {
+        rec = fSegments.append();
+    }
+    rec->fData = data;
+    rec->fStart = fUsed;
+    rec->fCapacity = bytes;
+
+    fData = data;
+    fSegmentStart = fUsed;
+    fCapacity = fUsed + bytes;
+}
+
+int SkWriter32::findSegment(size_t offset) const {
+    SkASSERT(fSegments.count() > 0);
+    SkASSERT(offset < fUsed || offset == 0);
+    // The last segment starting at or before offset.
+    int lo = 0;
+    int hi = fSegments.count() - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) >> 1;
+        if (fSegments[mid].fStart <= offset) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+void SkWriter32::rewindSegmentsTo(size_t offset) {
+    int index = this->findSegment(offset);
+    // Hand back what we can; the arena only reclaims its most recent allocation.
+    for (int i = fSegments.count() - 1; i > index; --i) {
+        fArena->unalloc(fSegments[i].fData);
+    }
+    fSegments.setCount(index + 1);
+
+    const SegmentRec& rec = fSegments[index];
+    fData = rec.fData;
+    fSegmentStart = rec.fStart;
+    fCapacity = rec.fStart + rec.fCapacity;
+}
+
+void SkWriter32::getSegments(SkTDArray<Segment>* segments) const {
+    segments->rewind();
+    if (0 == fSegmentBytes) {
+        if (fUsed > 0) {
+            Segment* seg = segments->append();
+            seg->fData = fData;
+            seg->fSize = fUsed;
+        }
+        return;
+    }
+    for (int i = 0; i < fSegments.count(); ++i) {
+        size_t end = i + 1 < fSegments.count() ? fSegments[i + 1].fStart : fUsed;
+        if (end > fSegments[i].fStart) {
+            Segment* seg = segments->append();
+            seg->fData = fSegments[i].fData;
+            seg->fSize = end - fSegments[i].fStart;
+        }
+    }
+}
+
+void SkWriter32::flattenSegments(void* dst) const {
+    SkTDArray<Segment> segments;
+    this->getSegments(&segments);
+    uint8_t* ptr = (uint8_t*)dst;
+    for (int i = 0; i < segments.count(); ++i) {
+        memcpy(ptr, segments[i].fData, segments[i].fSize);
+        ptr += segments[i].fSize;
+    }
+}
@@ -13,11 +13,12 @@ class SkDocument_PDF : public SkDocument {
 public:
     SkDocument_PDF(SkWStream* stream, void (*doneProc)(SkWStream*,bool),
                    SkPicture::EncodeBitmap encoder,
-                   SkScalar rasterDpi)
+                   SkScalar rasterDpi,
+                   bool streaming = false)
             : SkDocument(stream, doneProc)
             , fEncoder(encoder)
             , fRasterDpi(rasterDpi) {
-        fDoc = SkNEW(SkPDFDocument);
+        fDoc = streaming ? SkNEW_ARGS(SkPDFDocument, (stream)) : SkNEW(SkPDFDocument);
         fCanvas = NULL;
         fDevice = NULL;
     }
@@ -92,6 +93,12 @@ SkDocument* SkDocument::CreatePDF(SkWStream* stream, void (*done)(SkWStream*,boo
     return stream ? SkNEW_ARGS(SkDocument_PDF, (stream, done, enc, dpi)) : NULL;
 }
 
+SkDocument* SkDocument::CreateStreamingPDF(SkWStream* stream, void (*done)(SkWStream*,bool),
+                                           SkPicture::EncodeBitmap enc,
+                                           SkScalar dpi) {
+    return stream ? SkNEW_ARGS(SkDocument_PDF, (stream, done, enc, dpi, true)) : NULL;
+}
+
 static void delete_wstream(SkWStream* stream, bool aborted) {
     SkDELETE(stream);
 }
@@ -8,7 +8,9 @@
 
 
 #include "SkBlurMask.h"
+#include "SkBlurMask_opts.h"
 #include "SkMath.h"
+#include "SkTaskGroup.h"
 #include "SkTemplates.h"
 #include "SkEndian.h"
 
@@ -30,199 +32,54 @@ SkScalar SkBlurMask::ConvertSigmaToRadius(SkScalar sigma) {
     return sigma > 0.5f ? (sigma - 0.5f) / kBLUR_SIGMA_SCALE : 0.0f;
 }
 
-#define UNROLL_SEPARABLE_LOOPS
-
 /**
- * This function performs a box blur in X, of the given radius.  If the
- * "transpose" parameter is true, it will transpose the pixels on write,
- * such that X and Y are swapped. Reads are always performed from contiguous
- * memory in X, for speed. The destination buffer (dst) must be at least
- * (width + leftRadius + rightRadius) * height bytes in size.
+ * This function performs a box blur down each of the first width columns of
+ * src, which is height rows tall.  Each column is blurred independently, and
+ * the result is written to dst, new_height = height + 2 * max(leftRadius,
+ * rightRadius) rows tall.
  *
- * This is what the inner loop looks like before unrolling, and with the two
- * cases broken out separately (width < diameter, width >= diameter):
+ * With diameter = leftRadius + rightRadius, output row
+ * max(0, rightRadius - leftRadius) + y, for 0 <= y < height + diameter, is the
+ * sum of source rows y - diameter .. y (those that exist) divided by
+ * diameter + 1, in 8.24 fixed point.  The other rows are zero.
  *
- *      if (width < diameter) {
- *          for (int x = 0; x < width; ++x) {
- *              sum += *right++;
- *              *dptr = (sum * scale + half) >> 24;
- *              dptr += dst_x_stride;
- *          }
- *          for (int x = width; x < diameter; ++x) {
- *              *dptr = (sum * scale + half) >> 24;
- *              dptr += dst_x_stride;
- *          }
- *          for (int x = 0; x < width; ++x) {
- *              *dptr = (sum * scale + half) >> 24;
- *              sum -= *left++;
- *              dptr += dst_x_stride;
- *          }
- *      } else {
- *          for (int x = 0; x < diameter; ++x) {
- *              sum += *right++;
- *              *dptr = (sum * scale + half) >> 24;
- *              dptr += dst_x_stride;
- *          }
- *          for (int x = diameter; x < width; ++x) {
- *              sum += *right++;
- *              *dptr = (sum * scale + half) >> 24;
- *              sum -= *left++;
- *              dptr += dst_x_stride;
- *          }
- *          for (int x = 0; x < diameter; ++x) {
- *              *dptr = (sum * scale + half) >> 24;
- *              sum -= *left++;
- *              dptr += dst_x_stride;
- *          }
- *      }
+ * Rather than walking down one column at a time, this walks down the rows
+ * keeping a running sum for every column, so all reads and writes are
+ * contiguous.  The platform procs in SkBlurMask_opts.h compute the same thing
+ * for several columns at once.
  */
-static int boxBlur(const uint8_t* src, int src_y_stride, uint8_t* dst,
-                   int leftRadius, int rightRadius, int width, int height,
-                   bool transpose)
+static int boxBlur(const uint8_t* src, int src_y_stride, uint8_t* dst, int dst_y_stride,
+                   int leftRadius, int rightRadius, int width, int height)
 {
     int diameter = leftRadius + rightRadius;
     int kernelSize = diameter + 1;
-    int border = SkMin32(width, diameter);
     uint32_t scale = (1 << 24) / kernelSize;
-    int new_width = width + SkMax32(leftRadius, rightRadius) * 2;
-    int dst_x_stride = transpose ? height : 1;
-    int dst_y_stride = transpose ? 1 : new_width;
     uint32_t half = 1 << 23;
-    for (int y = 0; y < height; ++y) {
-        uint32_t sum = 0;
-        uint8_t* dptr = dst + y * dst_y_stride;
-        const uint8_t* right = src + y * src_y_stride;
-        const uint8_t* left = right;
-        for (int x = 0; x < rightRadius - leftRadius; x++) {
-            *dptr = 0;
-            dptr += dst_x_stride;
-        }
-#define LEFT_BORDER_ITER \
-            sum += *right++; \
-            *dptr = (sum * scale + half) >> 24; \
-            dptr += dst_x_stride;
-
-        int x = 0;
-#ifdef UNROLL_SEPARABLE_LOOPS
-        for (; x < border - 16; x += 16) {
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-        }
-#endif
-        for (; x < border; ++x) {
-            LEFT_BORDER_ITER
-        }
-#undef LEFT_BORDER_ITER
-#define TRIVIAL_ITER \
-            *dptr = (sum * scale + half) >> 24; \
-            dptr += dst_x_stride;
-        x = width;
-#ifdef UNROLL_SEPARABLE_LOOPS
-        for (; x < diameter - 16; x += 16) {
-            TRIVIAL_ITER
-            TRIVIAL_ITER
-            TRIVIAL_ITER
-            TRIVIAL_ITER
-            TRIVIAL_ITER
-            TRIVIAL_ITER
-            TRIVIAL_ITER
-            TRIVIAL_ITER
-            TRIVIAL_ITER
-            TRIVIAL_ITER
-            TRIVIAL_ITER
-            TRIVIAL_ITER
-            TRIVIAL_ITER
-            TRIVIAL_ITER
-            TRIVIAL_ITER
-            TRIVIAL_ITER
-        }
-#endif
-        for (; x < diameter; ++x) {
-            TRIVIAL_ITER
-        }
-#undef TRIVIAL_ITER
-#define CENTER_ITER \
-            sum += *right++; \
-            *dptr = (sum * scale + half) >> 24; \
-            sum -= *left++; \
-            dptr += dst_x_stride;
-
-        x = diameter;
-#ifdef UNROLL_SEPARABLE_LOOPS
-        for (; x < width - 16; x += 16) {
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-        }
-#endif
-        for (; x < width; ++x) {
-            CENTER_ITER
-        }
-#undef CENTER_ITER
-#define RIGHT_BORDER_ITER \
-            *dptr = (sum * scale + half) >> 24; \
-            sum -= *left++; \
-            dptr += dst_x_stride;
-
-        x = 0;
-#ifdef UNROLL_SEPARABLE_LOOPS
-        for (; x < border - 16; x += 16) {
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-        }
-#endif
-        for (; x < border; ++x) {
-            RIGHT_BORDER_ITER
-        }
-#undef RIGHT_BORDER_ITER
-        for (int x = 0; x < leftRadius - rightRadius; ++x) {
-            *dptr = 0;
-            dptr += dst_x_stride;
-        }
-        SkASSERT(sum == 0);
+    SkAutoSTMalloc<256, uint32_t> sum(width);
+    SkAutoSTMalloc<256, uint8_t> zeros(width);
+    sk_bzero(sum.get(), width * sizeof(uint32_t));
+    sk_bzero(zeros.get(), width);
+
+    for (int y = 0; y < rightRadius - leftRadius; ++y) {
+        sk_bzero(dst, width);
+        dst += dst_y_stride;
+    }
+    for (int y = 0; y < height + diameter; ++y) {
+        // The row entering the kernel and the one leaving it, if any.
+        const uint8_t* right = y < height ? src + y * src_y_stride : zeros.get();
+        const uint8_t* left = y >= diameter ? src + (y - diameter) * src_y_stride : zeros.get();
+        for (int x = 0; x < width; ++x) {
+            sum[x] += right[x];
+            dst[x] = (sum[x] * scale + half) >> 24;
+            sum[x] -= left[x];
+        }
+        dst += dst_y_stride;
+    }
+    for (int y = 0; y < leftRadius - rightRadius; ++y) {
+        sk_bzero(dst, width);
+        dst += dst_y_stride;
     }
-    return new_width;
+    return width;
 }
 
 /**
@@ -233,177 +90,206 @@ static int boxBlur(const uint8_t* src, int src_y_stride, uint8_t* dst,
  *  outer_weight * outer_sum / kernelSize +
  *  (1.0 - outer_weight) * innerSum / (kernelSize - 2)
  *
- * This is what the inner loop looks like before unrolling, and with the two
- * cases broken out separately (width < diameter, width >= diameter):
- *
- *      if (width < diameter) {
- *          for (int x = 0; x < width; x++) {
- *              inner_sum = outer_sum;
- *              outer_sum += *right++;
- *              *dptr = (outer_sum * outer_scale + inner_sum * inner_scale + half) >> 24;
- *              dptr += dst_x_stride;
- *          }
- *          for (int x = width; x < diameter; ++x) {
- *              *dptr = (outer_sum * outer_scale + inner_sum * inner_scale + half) >> 24;
- *              dptr += dst_x_stride;
- *          }
- *          for (int x = 0; x < width; x++) {
- *              inner_sum = outer_sum - *left++;
- *              *dptr = (outer_sum * outer_scale + inner_sum * inner_scale + half) >> 24;
- *              dptr += dst_x_stride;
- *              outer_sum = inner_sum;
- *          }
- *      } else {
- *          for (int x = 0; x < diameter; x++) {
- *              inner_sum = outer_sum;
- *              outer_sum += *right++;
- *              *dptr = (outer_sum * outer_scale + inner_sum * inner_scale + half) >> 24;
- *              dptr += dst_x_stride;
- *          }
- *          for (int x = diameter; x < width; ++x) {
- *              inner_sum = outer_sum - *left;
- *              outer_sum += *right++;
- *              *dptr = (outer_sum * outer_scale + inner_sum * inner_scale + half) >> 24;
- *              dptr += dst_x_stride;
- *              outer_sum -= *left++;
- *          }
- *          for (int x = 0; x < diameter; x++) {
- *              inner_sum = outer_sum - *left++;
- *              *dptr = (outer_sum * outer_scale + inner_sum * inner_scale + half) >> 24;
- *              dptr += dst_x_stride;
- *              outer_sum = inner_sum;
- *          }
- *      }
- *  }
- *  return new_width;
+ * Output row y, for 0 <= y < height + 2 * radius, uses the outer sum of source
+ * rows y - 2 * radius .. y, and the inner sum of the rows between those two.
+ * The platform procs in SkBlurMask_opts.h compute the same thing for several
+ * columns at once.
  */
-
-static int boxBlurInterp(const uint8_t* src, int src_y_stride, uint8_t* dst,
-                         int radius, int width, int height,
-                         bool transpose, uint8_t outer_weight)
+static int boxBlurInterp(const uint8_t* src, int src_y_stride, uint8_t* dst, int dst_y_stride,
+                         int radius, uint8_t outer_weight, int width, int height)
 {
     int diameter = radius * 2;
     int kernelSize = diameter + 1;
-    int border = SkMin32(width, diameter);
     int inner_weight = 255 - outer_weight;
     outer_weight += outer_weight >> 7;
     inner_weight += inner_weight >> 7;
     uint32_t outer_scale = (outer_weight << 16) / kernelSize;
     uint32_t inner_scale = (inner_weight << 16) / (kernelSize - 2);
     uint32_t half = 1 << 23;
-    int new_width = width + diameter;
-    int dst_x_stride = transpose ? height : 1;
-    int dst_y_stride = transpose ? 1 : new_width;
-    for (int y = 0; y < height; ++y) {
-        uint32_t outer_sum = 0, inner_sum = 0;
-        uint8_t* dptr = dst + y * dst_y_stride;
-        const uint8_t* right = src + y * src_y_stride;
-        const uint8_t* left = right;
-        int x = 0;
-
-#define LEFT_BORDER_ITER \
-            inner_sum = outer_sum; \
-            outer_sum += *right++; \
-            *dptr = (outer_sum * outer_scale + inner_sum * inner_scale + half) >> 24; \
-            dptr += dst_x_stride;
-
-#ifdef UNROLL_SEPARABLE_LOOPS
-        for (;x < border - 16; x += 16) {
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-            LEFT_BORDER_ITER
-        }
-#endif
+    SkAutoSTMalloc<256, uint32_t> outer_sum(width);
+    SkAutoSTMalloc<256, uint8_t> zeros(width);
+    sk_bzero(outer_sum.get(), width * sizeof(uint32_t));
+    sk_bzero(zeros.get(), width);
+
+    for (int y = 0; y < height + diameter; ++y) {
+        // The row entering the outer kernel and the one leaving it, if any.
+        const uint8_t* right = y < height ? src + y * src_y_stride : zeros.get();
+        const uint8_t* left = y >= diameter ? src + (y - diameter) * src_y_stride : zeros.get();
+        // The inner kernel excludes both.  If the source is shorter than the kernel, the rows
+        // between its end and the diameter keep excluding its last row.
+        const uint8_t* excluded = right;
+        if (y >= height && y < diameter && height > 0) {
+            excluded = src + (height - 1) * src_y_stride;
+        }
+        for (int x = 0; x < width; ++x) {
+            outer_sum[x] += right[x];
+            uint32_t inner_sum = outer_sum[x] - excluded[x] - left[x];
+            dst[x] = (outer_sum[x] * outer_scale + inner_sum * inner_scale + half) >> 24;
+            outer_sum[x] -= left[x];
+        }
+        dst += dst_y_stride;
+    }
+    return width;
+}
 
-        for (;x < border; ++x) {
-            LEFT_BORDER_ITER
-        }
-#undef LEFT_BORDER_ITER
-        for (int x = width; x < diameter; ++x) {
-            *dptr = (outer_sum * outer_scale + inner_sum * inner_scale + half) >> 24;
-            dptr += dst_x_stride;
-        }
-        x = diameter;
-
-#define CENTER_ITER \
-            inner_sum = outer_sum - *left; \
-            outer_sum += *right++; \
-            *dptr = (outer_sum * outer_scale + inner_sum * inner_scale + half) >> 24; \
-            dptr += dst_x_stride; \
-            outer_sum -= *left++;
-
-#ifdef UNROLL_SEPARABLE_LOOPS
-        for (; x < width - 16; x += 16) {
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-            CENTER_ITER
-        }
-#endif
-        for (; x < width; ++x) {
-            CENTER_ITER
-        }
-#undef CENTER_ITER
-
-        #define RIGHT_BORDER_ITER \
-            inner_sum = outer_sum - *left++; \
-            *dptr = (outer_sum * outer_scale + inner_sum * inner_scale + half) >> 24; \
-            dptr += dst_x_stride; \
-            outer_sum = inner_sum;
-
-        x = 0;
-#ifdef UNROLL_SEPARABLE_LOOPS
-        for (; x < border - 16; x += 16) {
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
-            RIGHT_BORDER_ITER
+/**
+ * Transposes src, height rows of width bytes, into dst, width rows of height
+ * bytes.  It works in strips 16 rows tall so each of those rows stays in cache.
+ */
+static void transpose(const uint8_t* src, int src_y_stride, uint8_t* dst, int dst_y_stride,
+                      int width, int height)
+{
+    for (int y0 = 0; y0 < height; y0 += 16) {
+        int y1 = SkMin32(y0 + 16, height);
+        for (int x = 0; x < width; ++x) {
+            const uint8_t* sptr = src + y0 * src_y_stride + x;
+            uint8_t* dptr = dst + x * dst_y_stride + y0;
+            for (int y = y0; y < y1; ++y) {
+                *dptr++ = *sptr;
+                sptr += src_y_stride;
+            }
         }
-#endif
-        for (; x < border; ++x) {
-            RIGHT_BORDER_ITER
+    }
+}
+
+namespace {
+
+// One box blur pass.  If fOuterWeight is 255 it's a plain box blur, otherwise an interpolating
+// one, in which case fLeftRadius == fRightRadius.
+struct BoxBlurPass {
+    int fLeftRadius;
+    int fRightRadius;
+    int fOuterWeight;
+};
+
+/**
+ * The whole blur.  We transpose the source, blur down its columns (the source's rows), transpose
+ * back, and blur down the columns again.  Columns never affect one another, so each step can be
+ * split into bands of columns (or for the transposes, rows) that run in parallel.
+ */
+struct BoxBlurJob {
+    BoxBlurPass             fPasses[3];
+    int                     fPassCount;
+    SkBoxBlurMaskProc       fBoxBlurProc;       // May be NULL.
+    SkBoxBlurMaskInterpProc fBoxBlurInterpProc; // May be NULL.
+    SkTransposeMaskProc     fTransposeProc;     // Never NULL.
+
+    const uint8_t*          fSrc;
+    int                     fSrcRowBytes;
+    int                     fSrcWidth, fSrcHeight;
+    int                     fDstWidth, fDstHeight;
+    uint8_t*                fTmp;   // Each of these is fDstWidth * fDstHeight bytes.
+    uint8_t*                fDst;
+
+    // Runs all the passes over columns [start, stop) of the first image, height rows tall, with
+    // the given row bytes.  Ping-pongs between fTmp and fDst, ending up in fDst.
+    void blurColumns(int start, int stop, int rowBytes, int height) const {
+        SkASSERT(fPassCount & 1);
+        uint8_t* src = fTmp + start;
+        uint8_t* dst = fDst + start;
+        for (int i = 0; i < fPassCount; ++i) {
+            const BoxBlurPass& pass = fPasses[i];
+            int width = stop - start;
+            int done = 0;
+            if (255 == pass.fOuterWeight) {
+                if (fBoxBlurProc) {
+                    done = fBoxBlurProc(src, rowBytes, dst, rowBytes,
+                                        pass.fLeftRadius, pass.fRightRadius, width, height);
+                }
+                boxBlur(src + done, rowBytes, dst + done, rowBytes,
+                        pass.fLeftRadius, pass.fRightRadius, width - done, height);
+            } else {
+                if (fBoxBlurInterpProc) {
+                    done = fBoxBlurInterpProc(src, rowBytes, dst, rowBytes,
+                                              pass.fLeftRadius, pass.fOuterWeight, width, height);
+                }
+                boxBlurInterp(src + done, rowBytes, dst + done, rowBytes,
+                              pass.fLeftRadius, pass.fOuterWeight, width - done, height);
+            }
+            height += 2 * SkMax32(pass.fLeftRadius, pass.fRightRadius);
+            SkTSwap(src, dst);
         }
-#undef RIGHT_BORDER_ITER
-        SkASSERT(outer_sum == 0 && inner_sum == 0);
     }
-    return new_width;
+};
+
+// The steps of a BoxBlurJob.  Each handles [start, stop) of the rows or columns it splits.
+typedef void (*BoxBlurStep)(const BoxBlurJob&, int start, int stop);
+
+void transpose_src(const BoxBlurJob& job, int start, int stop) {
+    job.fTransposeProc(job.fSrc + start, job.fSrcRowBytes, job.fTmp + start * job.fSrcHeight,
+                       job.fSrcHeight, stop - start, job.fSrcHeight);
+}
+
+void blur_x(const BoxBlurJob& job, int start, int stop) {
+    job.blurColumns(start, stop, job.fSrcHeight, job.fSrcWidth);
+}
+
+void transpose_back(const BoxBlurJob& job, int start, int stop) {
+    job.fTransposeProc(job.fDst + start, job.fSrcHeight, job.fTmp + start * job.fDstWidth,
+                       job.fDstWidth, stop - start, job.fDstWidth);
+}
+
+void blur_y(const BoxBlurJob& job, int start, int stop) {
+    job.blurColumns(start, stop, job.fDstWidth, job.fSrcHeight);
+}
+
+class BoxBlurBand : public SkRunnable {
+public:
+    BoxBlurBand() : fJob(NULL), fStep(NULL), fStart(0), fStop(0) {}
+
+    void set(const BoxBlurJob* job, BoxBlurStep step, int start, int stop) {
+        fJob = job;
+        fStep = step;
+        fStart = start;
+        fStop = stop;
+    }
+
+    virtual void run() SK_OVERRIDE {
+        fStep(*fJob, fStart, fStop);
+    }
+
+private:
+    const BoxBlurJob* fJob;
+    BoxBlurStep       fStep;
+    int               fStart, fStop;
+};
+
+// Don't bother splitting blurs with fewer output pixels than this, or bands narrower than this.
+const int kMinParallelArea = 256 * 256;
+const int kMinBandSize = 64;
+
+SkTaskScheduler* gScheduler = NULL;
+
+// Runs step over [0, count), split into bands of at least kMinBandSize on scheduler's threads
+// when area is big enough to be worth it.
+void run_step(const BoxBlurJob& job, BoxBlurStep step, int count, int area,
+              SkTaskScheduler* scheduler) {
+    int bands = 1;
+    if (scheduler && area >= kMinParallelArea) {
+        // The calling thread also runs bands while it waits.
+        bands = SkMin32(scheduler->threadCount() + 1, count / kMinBandSize);
+    }
+    if (bands <= 1) {
+        step(job, 0, count);
+        return;
+    }
+
+    SkAutoTArray<BoxBlurBand> runnables(bands);
+    SkTaskGroup group(scheduler);
+    for (int i = 0; i < bands; ++i) {
+        // Keep the bands a multiple of 16 wide, so the platform procs don't overlap themselves.
+        int start = (count * i / bands) & ~15;
+        int stop = i + 1 == bands ? count : (count * (i + 1) / bands) & ~15;
+        runnables[i].set(&job, step, start, stop);
+        group.add(&runnables[i]);
+    }
+    group.wait();
+}
+
+} // namespace
+
+void SkBlurMask::SetTaskScheduler(SkTaskScheduler* scheduler) {
+    gScheduler = scheduler;
 }
 
 static void get_adjusted_radii(SkScalar passRadius, int *loRadius, int *hiRadius)
@@ -482,6 +368,12 @@ void SkMask_FreeImage(uint8_t* image) {
 bool SkBlurMask::BoxBlur(SkMask* dst, const SkMask& src,
                          SkScalar sigma, SkBlurStyle style, SkBlurQuality quality,
                          SkIPoint* margin, bool force_quality) {
+    return BoxBlur(dst, src, sigma, style, quality, margin, force_quality, gScheduler);
+}
+
+bool SkBlurMask::BoxBlur(SkMask* dst, const SkMask& src,
+                         SkScalar sigma, SkBlurStyle style, SkBlurQuality quality,
+                         SkIPoint* margin, bool force_quality, SkTaskScheduler* scheduler) {
 
     if (src.fFormat != SkMask::kA8_Format) {
         return false;
@@ -546,40 +438,48 @@ bool SkBlurMask::BoxBlur(SkMask* dst, const SkMask& src,
 
         // build the blurry destination
         SkAutoTMalloc<uint8_t>  tmpBuffer(dstSize);
-        uint8_t*                tp = tmpBuffer.get();
-        int w = sw, h = sh;
 
+        BoxBlurJob job;
         if (outerWeight == 255) {
             int loRadius, hiRadius;
             get_adjusted_radii(passRadius, &loRadius, &hiRadius);
             if (kHigh_SkBlurQuality == quality) {
-                // Do three X blurs, with a transpose on the final one.
-                w = boxBlur(sp, src.fRowBytes, tp, loRadius, hiRadius, w, h, false);
-                w = boxBlur(tp, w,             dp, hiRadius, loRadius, w, h, false);
-                w = boxBlur(dp, w,             tp, hiRadius, hiRadius, w, h, true);
-                // Do three Y blurs, with a transpose on the final one.
-                h = boxBlur(tp, h,             dp, loRadius, hiRadius, h, w, false);
-                h = boxBlur(dp, h,             tp, hiRadius, loRadius, h, w, false);
-                h = boxBlur(tp, h,             dp, hiRadius, hiRadius, h, w, true);
+                BoxBlurPass passes[] = {
+                    { loRadius, hiRadius, 255 },
+                    { hiRadius, loRadius, 255 },
+                    { hiRadius, hiRadius, 255 },
+                };
+                memcpy(job.fPasses, passes, sizeof(passes));
             } else {
-                w = boxBlur(sp, src.fRowBytes, tp, rx, rx, w, h, true);
-                h = boxBlur(tp, h,             dp, ry, ry, h, w, true);
+                BoxBlurPass pass = { rx, rx, 255 };
+                job.fPasses[0] = pass;
             }
         } else {
-            if (kHigh_SkBlurQuality == quality) {
-                // Do three X blurs, with a transpose on the final one.
-                w = boxBlurInterp(sp, src.fRowBytes, tp, rx, w, h, false, outerWeight);
-                w = boxBlurInterp(tp, w,             dp, rx, w, h, false, outerWeight);
-                w = boxBlurInterp(dp, w,             tp, rx, w, h, true, outerWeight);
-                // Do three Y blurs, with a transpose on the final one.
-                h = boxBlurInterp(tp, h,             dp, ry, h, w, false, outerWeight);
-                h = boxBlurInterp(dp, h,             tp, ry, h, w, false, outerWeight);
-                h = boxBlurInterp(tp, h,             dp, ry, h, w, true, outerWeight);
-            } else {
-                w = boxBlurInterp(sp, src.fRowBytes, tp, rx, w, h, true, outerWeight);
-                h = boxBlurInterp(tp, h,             dp, ry, h, w, true, outerWeight);
-            }
-        }
+            BoxBlurPass pass = { rx, rx, outerWeight };
+            job.fPasses[0] = job.fPasses[1] = job.fPasses[2] = pass;
+        }
+        job.fPassCount = passCount;
+        if (!SkBoxBlurMaskGetPlatformProcs(&job.fBoxBlurProc, &job.fBoxBlurInterpProc,
+                                           &job.fTransposeProc)) {
+            job.fBoxBlurProc = NULL;
+            job.fBoxBlurInterpProc = NULL;
+            job.fTransposeProc = transpose;
+        }
+        job.fSrc = sp;
+        job.fSrcRowBytes = src.fRowBytes;
+        job.fSrcWidth = sw;
+        job.fSrcHeight = sh;
+        job.fDstWidth = dst->fBounds.width();
+        job.fDstHeight = dst->fBounds.height();
+        job.fTmp = tmpBuffer.get();
+        job.fDst = dp;
+
+        // Do the X blurs, between transposes, then the Y blurs.
+        int area = job.fDstWidth * job.fDstHeight;
+        run_step(job, transpose_src, sw, area, scheduler);
+        run_step(job, blur_x, sh, area, scheduler);
+        run_step(job, transpose_back, sh, area, scheduler);
+        run_step(job, blur_y, job.fDstWidth, area, scheduler);
 
         dst->fImage = dp;
         // if need be, alloc the "real" dst (same size as src) and copy/merge
@@ -13,6 +13,8 @@
 #include "SkMask.h"
 #include "SkRRect.h"
 
+class SkTaskScheduler;
+
 class SkBlurMask {
 public:
     static bool BlurRect(SkScalar sigma, SkMask *dst, const SkRect &src, SkBlurStyle,
@@ -34,6 +36,18 @@ public:
                         SkScalar sigma, SkBlurStyle style, SkBlurQuality quality,
                         SkIPoint* margin = NULL, bool force_quality=false);
 
+    // Like BoxBlur() above, but splits large masks into bands and blurs them on scheduler's
+    // threads as well as the calling thread, or blurs everything on the calling thread if
+    // scheduler is NULL, whatever SetTaskScheduler() was given.
+    static bool BoxBlur(SkMask* dst, const SkMask& src,
+                        SkScalar sigma, SkBlurStyle style, SkBlurQuality quality,
+                        SkIPoint* margin, bool force_quality, SkTaskScheduler* scheduler);
+
+    // The scheduler BoxBlur() uses when it isn't passed one.  NULL, the default, blurs everything
+    // on the calling thread.  The scheduler is not owned, and this is not thread safe: set it
+    // before any drawing starts.
+    static void SetTaskScheduler(SkTaskScheduler*);
+
     // the "ground truth" blur does a gaussian convolution; it's slow
     // but useful for comparison purposes.
     static bool BlurGroundTruth(SkScalar sigma, SkMask* dst, const SkMask& src, SkBlurStyle,
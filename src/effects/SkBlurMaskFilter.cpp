@@ -8,12 +8,14 @@
 
 #include "SkBlurMaskFilter.h"
 #include "SkBlurMask.h"
+#include "SkFloatBits.h"
 #include "SkGpuBlurUtils.h"
 #include "SkReadBuffer.h"
 #include "SkWriteBuffer.h"
 #include "SkMaskFilter.h"
 #include "SkRRect.h"
 #include "SkRTConf.h"
+#include "SkScaledImageCache.h"
 #include "SkStringUtils.h"
 #include "SkStrokeRec.h"
 
@@ -249,6 +251,51 @@ static bool draw_rects_into_mask(const SkRect rects[], int count, SkMask* mask)
     return true;
 }
 
+// Blurred nine-patch masks are kept in the SkScaledImageCache, so drawing the same shadow again
+// (at any position) just copies its mask.  The key must cover everything the mask depends on.
+
+static bool find_cached_mask(const uint32_t key[], int count, SkMask* mask) {
+    SkBitmap bitmap;
+    SkScaledImageCache::ID* id = SkScaledImageCache::FindAndLock(key, count, &bitmap);
+    if (NULL == id) {
+        return false;
+    }
+
+    bool found = false;
+    SkAutoLockPixels alp(bitmap);
+    if (bitmap.getPixels()) {
+        mask->fBounds.set(0, 0, bitmap.width(), bitmap.height());
+        mask->fRowBytes = SkToU32(bitmap.rowBytes());
+        mask->fFormat = SkMask::kA8_Format;
+        const size_t size = mask->computeImageSize();
+        mask->fImage = SkMask::AllocImage(size);
+        if (mask->fImage) {
+            memcpy(mask->fImage, bitmap.getPixels(), size);
+            found = true;
+        }
+    }
+    SkScaledImageCache::Unlock(id);
+    return found;
+}
+
+static void add_cached_mask(const uint32_t key[], int count, const SkMask& mask) {
+    SkASSERT(SkMask::kA8_Format == mask.fFormat);
+    SkASSERT(0 == mask.fBounds.fLeft && 0 == mask.fBounds.fTop);
+
+    SkBitmap bitmap;
+    if (!bitmap.allocPixels(SkImageInfo::MakeA8(mask.fBounds.width(), mask.fBounds.height()))) {
+        return;
+    }
+    for (int y = 0; y < mask.fBounds.height(); ++y) {
+        memcpy(bitmap.getAddr8(0, y), mask.getAddr8(0, y), mask.fBounds.width());
+    }
+
+    SkScaledImageCache::ID* id = SkScaledImageCache::AddAndLock(key, count, bitmap);
+    if (id) {
+        SkScaledImageCache::Unlock(id);
+    }
+}
+
 static bool rect_exceeds(const SkRect& r, SkScalar v) {
     return r.fLeft < -v || r.fTop < -v || r.fRight > v || r.fBottom > v ||
            r.width() > v || r.height() > v;
@@ -365,26 +412,45 @@ SkBlurMaskFilterImpl::filterRRectToNine(const SkRRect& rrect, const SkMatrix& ma
     radii[SkRRect::kLowerLeft_Corner] = LL;
     smallRR.setRectRadii(smallR, radii);
 
-    bool analyticBlurWorked = false;
-    if (c_analyticBlurRRect) {
-        analyticBlurWorked =
-            this->filterRRectMask(&patch->fMask, smallRR, matrix, &margin,
-                                  SkMask::kComputeBoundsAndRenderImage_CreateMode);
-    }
-
-    if (!analyticBlurWorked) {
-        if (!draw_rrect_into_mask(smallRR, &srcM)) {
-            return kFalse_FilterReturn;
+    // smallRR sits at the origin, so its mask depends only on these.
+    const uint32_t key[] = {
+        SkSetFourByteTag('b', 'r', 'r', '9'),
+        (uint32_t)SkFloat2Bits(this->computeXformedSigma(matrix)),
+        fBlurStyle,
+        this->getQuality(),
+        c_analyticBlurRRect,
+        (uint32_t)SkFloat2Bits(totalSmallWidth), (uint32_t)SkFloat2Bits(totalSmallHeight),
+        (uint32_t)SkFloat2Bits(UL.fX), (uint32_t)SkFloat2Bits(UL.fY),
+        (uint32_t)SkFloat2Bits(UR.fX), (uint32_t)SkFloat2Bits(UR.fY),
+        (uint32_t)SkFloat2Bits(LR.fX), (uint32_t)SkFloat2Bits(LR.fY),
+        (uint32_t)SkFloat2Bits(LL.fX), (uint32_t)SkFloat2Bits(LL.fY),
+    };
+    SK_COMPILE_ASSERT(SK_ARRAY_COUNT(key) <= SkScaledImageCache::kMaxKeyCount, key_too_long);
+
+    if (!find_cached_mask(key, SK_ARRAY_COUNT(key), &patch->fMask)) {
+        bool analyticBlurWorked = false;
+        if (c_analyticBlurRRect) {
+            analyticBlurWorked =
+                this->filterRRectMask(&patch->fMask, smallRR, matrix, &margin,
+                                      SkMask::kComputeBoundsAndRenderImage_CreateMode);
         }
 
-        SkAutoMaskFreeImage amf(srcM.fImage);
+        if (!analyticBlurWorked) {
+            if (!draw_rrect_into_mask(smallRR, &srcM)) {
+                return kFalse_FilterReturn;
+            }
 
-        if (!this->filterMask(&patch->fMask, srcM, matrix, &margin)) {
-            return kFalse_FilterReturn;
+            SkAutoMaskFreeImage amf(srcM.fImage);
+
+            if (!this->filterMask(&patch->fMask, srcM, matrix, &margin)) {
+                return kFalse_FilterReturn;
+            }
         }
+
+        patch->fMask.fBounds.offsetTo(0, 0);
+        add_cached_mask(key, SK_ARRAY_COUNT(key), patch->fMask);
     }
 
-    patch->fMask.fBounds.offsetTo(0, 0);
     patch->fOuterRect = dstM.fBounds;
     patch->fCenter.fX = SkScalarCeilToInt(leftUnstretched) + 1;
     patch->fCenter.fY = SkScalarCeilToInt(topUnstretched) + 1;
@@ -98,6 +98,17 @@ private:
     #define SkCheckResult(expr, value)  (void)(expr)
 #endif
 
+// Whether requested is a smaller version of info that the decoders can produce directly.
+bool is_downsample(const SkImageInfo& info, const SkImageInfo& requested) {
+    return requested.width() > 0 && requested.height() > 0 &&
+           requested.width() <= info.width() && requested.height() <= info.height() &&
+           (requested.width() != info.width() || requested.height() != info.height()) &&
+           requested.colorType() == info.colorType() &&
+           requested.alphaType() == info.alphaType() &&
+           kN32_SkColorType == requested.colorType() &&
+           kUnpremul_SkAlphaType != requested.alphaType();
+}
+
 #ifdef SK_DEBUG
 inline bool check_alpha(SkAlphaType reported, SkAlphaType actual) {
     return ((reported == actual)
@@ -153,10 +164,11 @@ SkData* DecodingImageGenerator::onRefEncodedData() {
 bool DecodingImageGenerator::onGetPixels(const SkImageInfo& info,
                                          void* pixels, size_t rowBytes,
                                          SkPMColor ctableEntries[], int* ctableCount) {
-    if (fInfo != info) {
-        // The caller has specified a different info.  This is an
-        // error for this kind of SkImageGenerator.  Use the Options
-        // to change the settings.
+    // The caller may ask for a smaller size, which the decoder area-averages
+    // down to as it decodes.  Anything else is an error for this kind of
+    // SkImageGenerator.  Use the Options to change the settings.
+    const bool downsample = is_downsample(fInfo, info);
+    if (fInfo != info && !downsample) {
         return false;
     }
 
@@ -169,9 +181,12 @@ bool DecodingImageGenerator::onGetPixels(const SkImageInfo& info,
     decoder->setSampleSize(fSampleSize);
     decoder->setRequireUnpremultipliedColors(
             info.fAlphaType == kUnpremul_SkAlphaType);
+    if (downsample) {
+        decoder->setTargetSize(info.width(), info.height());
+    }
 
     SkBitmap bitmap;
-    TargetAllocator allocator(fInfo, pixels, rowBytes);
+    TargetAllocator allocator(info, pixels, rowBytes);
     decoder->setAllocator(&allocator);
     // TODO: need to be able to pass colortype directly to decoder
     SkBitmap::Config legacyConfig = SkColorTypeToBitmapConfig(info.colorType());
@@ -181,6 +196,9 @@ bool DecodingImageGenerator::onGetPixels(const SkImageInfo& info,
     if (!success) {
         return false;
     }
+    if (downsample && (bitmap.width() != info.width() || bitmap.height() != info.height())) {
+        return false;  // This decoder can't downsample.
+    }
     if (allocator.isReady()) {  // Did not use pixels!
         SkBitmap bm;
         SkASSERT(bitmap.canCopyTo(info.colorType()));
@@ -33,6 +33,8 @@ SkImageDecoder::SkImageDecoder()
     , fChooser(NULL)
     , fAllocator(NULL)
     , fSampleSize(1)
+    , fTargetWidth(0)
+    , fTargetHeight(0)
     , fDefaultPref(SkBitmap::kNo_Config)
     , fDitherImage(true)
     , fUsePrefTable(false)
@@ -55,6 +57,7 @@ void SkImageDecoder::copyFieldsToOther(SkImageDecoder* other) {
     other->setChooser(fChooser);
     other->setAllocator(fAllocator);
     other->setSampleSize(fSampleSize);
+    other->setTargetSize(fTargetWidth, fTargetHeight);
     if (fUsePrefTable) {
         other->setPrefConfigTable(fPrefTable);
     } else {
@@ -124,6 +127,22 @@ void SkImageDecoder::setSampleSize(int size) {
     fSampleSize = size;
 }
 
+void SkImageDecoder::setTargetSize(int width, int height) {
+    if (width <= 0 || height <= 0) {
+        width = height = 0;
+    }
+    fTargetWidth = width;
+    fTargetHeight = height;
+}
+
+bool SkImageDecoder::shouldDownsampleToTarget(int width, int height,
+                                              SkBitmap::Config config) const {
+    return fTargetWidth > 0 &&
+           fTargetWidth <= width && fTargetHeight <= height &&
+           SkBitmap::kARGB_8888_Config == config &&
+           !fRequireUnpremultipliedColors;
+}
+
 bool SkImageDecoder::chooseFromOneChoice(SkBitmap::Config config, int width,
                                          int height) const {
     Chooser* chooser = fChooser;
@@ -297,6 +297,20 @@ static bool valid_output_dimensions(const jpeg_decompress_struct& cinfo) {
     return 0 != cinfo.output_width && 0 != cinfo.output_height;
 }
 
+/*  When downsampling to a target size, let libjpeg's DCT scaling take us as far
+    as it can without going below the target, and area-average the rest.
+ */
+static int dct_sampleSize_for_target(const jpeg_decompress_struct& cinfo,
+                                     int targetWidth, int targetHeight) {
+    int sampleSize = 8;
+    while (sampleSize > 1 &&
+           ((int)((cinfo.image_width + sampleSize - 1) / sampleSize) < targetWidth ||
+            (int)((cinfo.image_height + sampleSize - 1) / sampleSize) < targetHeight)) {
+        sampleSize >>= 1;
+    }
+    return sampleSize;
+}
+
 static bool skip_src_rows(jpeg_decompress_struct* cinfo, void* buffer, int count) {
     for (int i = 0; i < count; i++) {
         JSAMPLE* rowptr = (JSAMPLE*)buffer;
@@ -575,6 +589,18 @@ bool SkJPEGImageDecoder::onDecode(SkStream* stream, SkBitmap* bm, Mode mode) {
     adjust_out_color_space_and_dither(&cinfo, config, *this);
 #endif
 
+    const bool downsample = this->shouldDownsampleToTarget(cinfo.image_width,
+                                                           cinfo.image_height, config);
+    if (downsample) {
+        if (SkImageDecoder::kDecodeBounds_Mode == mode) {
+            return bm->setConfig(config, this->getTargetWidth(), this->getTargetHeight(), 0,
+                                 kOpaque_SkAlphaType);
+        }
+        sampleSize = dct_sampleSize_for_target(cinfo, this->getTargetWidth(),
+                                               this->getTargetHeight());
+        cinfo.scale_denom = sampleSize;
+    }
+
     if (1 == sampleSize && SkImageDecoder::kDecodeBounds_Mode == mode) {
         // Assume an A8 bitmap is not opaque to avoid the check of each
         // individual pixel. It is very unlikely to be opaque, since
@@ -621,6 +647,13 @@ bool SkJPEGImageDecoder::onDecode(SkStream* stream, SkBitmap* bm, Mode mode) {
     }
 
     SkScaledBitmapSampler sampler(cinfo.output_width, cinfo.output_height, sampleSize);
+    if (downsample) {
+        if ((int)cinfo.output_width < this->getTargetWidth() ||
+            (int)cinfo.output_height < this->getTargetHeight()) {
+            return return_false(cinfo, *bm, "DCT scaled below target size");
+        }
+        sampler.setAreaAverageSize(this->getTargetWidth(), this->getTargetHeight());
+    }
     // Assume an A8 bitmap is not opaque to avoid the check of each
     // individual pixel. It is very unlikely to be opaque, since
     // an opaque A8 bitmap would not be very interesting.
@@ -640,7 +673,7 @@ bool SkJPEGImageDecoder::onDecode(SkStream* stream, SkBitmap* bm, Mode mode) {
     /* short-circuit the SkScaledBitmapSampler when possible, as this gives
        a significant performance boost.
     */
-    if (sampleSize == 1 &&
+    if (sampleSize == 1 && !downsample &&
         ((config == SkBitmap::kARGB_8888_Config &&
                 cinfo.out_color_space == JCS_RGBA_8888) ||
         (config == SkBitmap::kRGB_565_Config &&
@@ -695,7 +728,7 @@ bool SkJPEGImageDecoder::onDecode(SkStream* stream, SkBitmap* bm, Mode mode) {
         if (0 == row_count) {
             // if row_count == 0, then we didn't get a scanline,
             // so return early.  We will return a partial image.
-            fill_below_level(y, bm);
+            fill_below_level(downsample ? y * bm->height() / sampler.srcRowCount() : y, bm);
             cinfo.output_scanline = cinfo.output_height;
             break;  // Skip to jpeg_finish_decompress()
         }
@@ -708,7 +741,7 @@ bool SkJPEGImageDecoder::onDecode(SkStream* stream, SkBitmap* bm, Mode mode) {
         }
 
         sampler.next(srcRow);
-        if (bm->height() - 1 == y) {
+        if (sampler.srcRowCount() - 1 == y) {
             // we're done
             break;
         }
@@ -331,6 +331,12 @@ bool SkPNGImageDecoder::onDecode(SkStream* sk_stream, SkBitmap* decodedBitmap,
 
     const int sampleSize = this->getSampleSize();
     SkScaledBitmapSampler sampler(origWidth, origHeight, sampleSize);
+    // Matching the transparent color has to happen before averaging, so leave those alone.
+    const bool downsample = 0 == theTranspColor &&
+                            this->shouldDownsampleToTarget(origWidth, origHeight, config);
+    if (downsample) {
+        sampler.setAreaAverageSize(this->getTargetWidth(), this->getTargetHeight());
+    }
     decodedBitmap->setConfig(config, sampler.scaledWidth(), sampler.scaledHeight());
 
     // we should communicate alphaType, even if we early-return in bounds-only-mode.
@@ -418,7 +424,7 @@ bool SkPNGImageDecoder::onDecode(SkStream* sk_stream, SkBitmap* decodedBitmap,
         if (!sampler.begin(decodedBitmap, sc, *this, ctLock.colors())) {
             return false;
         }
-        const int height = decodedBitmap->height();
+        const int height = sampler.srcRowCount();
 
         if (number_passes > 1) {
             SkAutoMalloc storage(origWidth * origHeight * srcBytesPerPixel);
@@ -570,6 +570,121 @@ typedef SkScaledBitmapSampler::RowProc (*RowProcChooser)(const SkImageDecoder& d
 
 #include "SkScaledBitmapSampler.h"
 
+///////////////////////////////////////////////////////////////////////////////
+
+/*  Adds each source row, converted to SkPMColor, into sums for the destination
+    rows it overlaps.  Everything is measured in units where a source pixel is
+    dstWidth x dstHeight and a destination pixel is srcWidth x srcHeight, so the
+    overlaps are whole numbers and the average is exact up to the final rounding.
+    Because the destination is no larger, each source pixel overlaps at most two
+    destination columns and two destination rows.
+ */
+class SkScaledBitmapSampler::AreaAverager {
+public:
+    AreaAverager(int srcWidth, int srcHeight, int dstWidth, int dstHeight)
+        : fSrcWidth(srcWidth), fSrcHeight(srcHeight)
+        , fDstWidth(dstWidth), fDstHeight(dstHeight)
+        , fSrcY(0)
+        , fColumn(srcWidth)
+        , fColumnWeight(srcWidth)
+        , fRow(srcWidth)
+        , fRowSums((dstWidth + 1) * 4)
+        , fSumStorage(dstWidth * 4 * 2) {
+        SkASSERT(dstWidth > 0 && dstWidth <= srcWidth);
+        SkASSERT(dstHeight > 0 && dstHeight <= srcHeight);
+        for (int x = 0; x < srcWidth; x++) {
+            int64_t left = (int64_t)x * dstWidth;
+            int column = (int)(left / srcWidth);
+            int64_t right = SkTMin<int64_t>((int64_t)(column + 1) * srcWidth, left + dstWidth);
+            fColumn[x] = column;
+            fColumnWeight[x] = (uint32_t)(right - left);
+        }
+        fSums = fSumStorage.get();
+        fNextSums = fSums + dstWidth * 4;
+        sk_bzero(fSumStorage.get(), dstWidth * 4 * 2 * sizeof(uint64_t));
+    }
+
+    // Returns true if the row had non-opaque alpha in it.
+    bool next(RowProc proc, const uint8_t* SK_RESTRICT src, int deltaSrc,
+              const SkPMColor ctable[], char** dstRow, size_t dstRowBytes) {
+        SkASSERT(fSrcY < fSrcHeight);
+        bool hadAlpha = proc(fRow.get(), src, fSrcWidth, deltaSrc, fSrcY, ctable);
+
+        // Across: the extra column at the end catches the empty remainder of the last pixel.
+        uint32_t* rowSums = fRowSums.get();
+        sk_bzero(rowSums, (fDstWidth + 1) * 4 * sizeof(uint32_t));
+        const SkPMColor* row = fRow.get();
+        for (int x = 0; x < fSrcWidth; x++) {
+            const SkPMColor c = row[x];
+            const uint32_t w0 = fColumnWeight[x];
+            const uint32_t w1 = fDstWidth - w0;
+            uint32_t* sums = rowSums + fColumn[x] * 4;
+            sums[0] += SkGetPackedA32(c) * w0;
+            sums[1] += SkGetPackedR32(c) * w0;
+            sums[2] += SkGetPackedG32(c) * w0;
+            sums[3] += SkGetPackedB32(c) * w0;
+            sums[4] += SkGetPackedA32(c) * w1;
+            sums[5] += SkGetPackedR32(c) * w1;
+            sums[6] += SkGetPackedG32(c) * w1;
+            sums[7] += SkGetPackedB32(c) * w1;
+        }
+
+        // Down: split between the destination row in progress and the next one.
+        int64_t top = (int64_t)fSrcY * fDstHeight;
+        int64_t bottom = top + fDstHeight;
+        int64_t boundary = (top / fSrcHeight + 1) * fSrcHeight;
+        const uint64_t v0 = SkTMin(boundary, bottom) - top;
+        const uint64_t v1 = fDstHeight - v0;
+        const int count = fDstWidth * 4;
+        for (int i = 0; i < count; i++) {
+            fSums[i] += rowSums[i] * v0;
+        }
+        if (v1 > 0) {
+            for (int i = 0; i < count; i++) {
+                fNextSums[i] += rowSums[i] * v1;
+            }
+        }
+        fSrcY += 1;
+
+        if (bottom >= boundary) {
+            this->finishRow((SkPMColor*)*dstRow);
+            *dstRow += dstRowBytes;
+            SkTSwap(fSums, fNextSums);
+            sk_bzero(fNextSums, count * sizeof(uint64_t));
+        }
+        return hadAlpha;
+    }
+
+private:
+    void finishRow(SkPMColor* SK_RESTRICT dst) const {
+        // Every weight adds up to this.  Rounding is monotonic, so the colors stay premultiplied.
+        const double scale = 1.0 / ((double)fSrcWidth * fSrcHeight);
+        const uint64_t* sums = fSums;
+        for (int x = 0; x < fDstWidth; x++) {
+            unsigned a = (unsigned)(sums[0] * scale + 0.5);
+            unsigned r = (unsigned)(sums[1] * scale + 0.5);
+            unsigned g = (unsigned)(sums[2] * scale + 0.5);
+            unsigned b = (unsigned)(sums[3] * scale + 0.5);
+            dst[x] = SkPackARGB32(a, r, g, b);
+            sums += 4;
+        }
+    }
+
+    const int fSrcWidth;
+    const int fSrcHeight;
+    const int fDstWidth;
+    const int fDstHeight;
+    int fSrcY;
+
+    SkAutoTMalloc<int> fColumn;             // first destination column of each source column
+    SkAutoTMalloc<uint32_t> fColumnWeight;  // its overlap with that; the rest is the next one's
+    SkAutoTMalloc<SkPMColor> fRow;
+    SkAutoTMalloc<uint32_t> fRowSums;       // A, R, G, B for each destination column
+    SkAutoTMalloc<uint64_t> fSumStorage;
+    uint64_t* fSums;                        // the destination row in progress
+    uint64_t* fNextSums;                    // and the one after it
+};
+
 SkScaledBitmapSampler::SkScaledBitmapSampler(int width, int height,
                                              int sampleSize) {
     fCTable = NULL;
@@ -580,6 +695,9 @@ SkScaledBitmapSampler::SkScaledBitmapSampler(int width, int height,
         sk_throw();
     }
 
+    fOrigWidth = width;
+    fOrigHeight = height;
+
     SkDEBUGCODE(fSampleMode = kUninitialized_SampleMode);
 
     if (sampleSize <= 1) {
@@ -612,6 +730,18 @@ SkScaledBitmapSampler::SkScaledBitmapSampler(int width, int height,
     SkASSERT(fDY > 0 && (fY0 + fDY * (fScaledHeight - 1)) < height);
 }
 
+SkScaledBitmapSampler::~SkScaledBitmapSampler() {}
+
+void SkScaledBitmapSampler::setAreaAverageSize(int dstWidth, int dstHeight) {
+    SkASSERT(dstWidth > 0 && dstWidth <= fOrigWidth);
+    SkASSERT(dstHeight > 0 && dstHeight <= fOrigHeight);
+    fScaledWidth = dstWidth;
+    fScaledHeight = dstHeight;
+    fX0 = fY0 = 0;
+    fDX = fDY = 1;
+    fAverager.reset(SkNEW_ARGS(AreaAverager, (fOrigWidth, fOrigHeight, dstWidth, dstHeight)));
+}
+
 bool SkScaledBitmapSampler::begin(SkBitmap* dst, SrcConfig sc,
                                   const SkImageDecoder& decoder,
                                   const SkPMColor ctable[]) {
@@ -704,6 +834,11 @@ bool SkScaledBitmapSampler::begin(SkBitmap* dst, SrcConfig sc,
             return false;
     }
 
+    if (fAverager.get() && (SkBitmap::kARGB_8888_Config != dst->config() ||
+                            decoder.getRequireUnpremultipliedColors())) {
+        return false;
+    }
+
     RowProcChooser chooser = gProcChoosers[index];
     if (NULL == chooser) {
         fRowProc = NULL;
@@ -719,6 +854,9 @@ bool SkScaledBitmapSampler::begin(SkBitmap* dst, SrcConfig sc,
 bool SkScaledBitmapSampler::next(const uint8_t* SK_RESTRICT src) {
     SkASSERT(kInterlaced_SampleMode != fSampleMode);
     SkDEBUGCODE(fSampleMode = kConsecutive_SampleMode);
+    if (fAverager.get()) {
+        return fAverager->next(fRowProc, src, fSrcPixelSize, fCTable, &fDstRow, fDstRowBytes);
+    }
     SkASSERT((unsigned)fCurrY < (unsigned)fScaledHeight);
 
     bool hadAlpha = fRowProc(fDstRow, src + fX0 * fSrcPixelSize, fScaledWidth,
@@ -730,6 +868,7 @@ bool SkScaledBitmapSampler::next(const uint8_t* SK_RESTRICT src) {
 
 bool SkScaledBitmapSampler::sampleInterlaced(const uint8_t* SK_RESTRICT src, int srcY) {
     SkASSERT(kConsecutive_SampleMode != fSampleMode);
+    SkASSERT(NULL == fAverager.get());
     SkDEBUGCODE(fSampleMode = kInterlaced_SampleMode);
     // Any line that should be a part of the destination can be created by the formula:
     // fY0 + (some multiplier) * fDY
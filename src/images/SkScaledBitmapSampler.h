@@ -11,16 +11,28 @@
 #include "SkTypes.h"
 #include "SkColor.h"
 #include "SkImageDecoder.h"
+#include "SkTemplates.h"
 
 class SkBitmap;
 
 class SkScaledBitmapSampler {
 public:
     SkScaledBitmapSampler(int origWidth, int origHeight, int cellSize);
+    ~SkScaledBitmapSampler();
+
+    // Instead of taking one pixel from each cell, area-average the whole
+    // source down to dstWidth x dstHeight, which must be no larger, keeping
+    // only a row's worth of sums.  Call before begin(), which then only
+    // supports premultiplied kARGB_8888_Config destinations.
+    void setAreaAverageSize(int dstWidth, int dstHeight);
 
     int scaledWidth() const { return fScaledWidth; }
     int scaledHeight() const { return fScaledHeight; }
 
+    // The number of rows to pass to next(): scaledHeight() when sampling,
+    // or every source row when area-averaging.
+    int srcRowCount() const { return fAverager.get() ? fOrigHeight : fScaledHeight; }
+
     int srcY0() const { return fY0; }
     int srcDX() const { return fDX; }
     int srcDY() const { return fDY; }
@@ -39,7 +51,7 @@ public:
     // Returns false if the request cannot be fulfulled.
     bool begin(SkBitmap* dst, SrcConfig sc, const SkImageDecoder& decoder,
                const SkPMColor* = NULL);
-    // call with row of src pixels, for y = 0...scaledHeight-1.
+    // call with row of src pixels, for y = 0...srcRowCount()-1.
     // returns true if the row had non-opaque alpha in it
     bool next(const uint8_t* SK_RESTRICT src);
 
@@ -55,6 +67,10 @@ public:
                             const SkPMColor[]);
 
 private:
+    class AreaAverager;
+
+    int fOrigWidth;
+    int fOrigHeight;
     int fScaledWidth;
     int fScaledHeight;
 
@@ -85,6 +101,9 @@ private:
     // optional reference to the src colors if the src is a palette model
     const SkPMColor* fCTable;
 
+    // set by setAreaAverageSize()
+    SkAutoTDelete<AreaAverager> fAverager;
+
 #ifdef SK_DEBUG
     // Helper class allowing a test to have access to fRowProc.
     friend class RowProcTester;
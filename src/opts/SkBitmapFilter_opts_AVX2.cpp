@@ -0,0 +1,119 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBitmapFilter_opts_AVX2.h"
+
+// See the note in SkBlitRow_opts_AVX2.cpp.
+#if !defined(SK_BUILD_FOR_ANDROID_FRAMEWORK) || SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_AVX2
+
+#include <immintrin.h>  // AVX2
+
+namespace {
+
+// This is convolveVerticallyLong_SSE2() from SkBitmapFilter_opts_SSE2.cpp, 8 pixels at a time.
+// The 256-bit unpacks work within each 128-bit lane, so each accumulator holds pixels i and
+// i + 4 of a group of 8, and the packs at the end work within the lanes too, which puts them
+// back in order.
+static const int kChunkPixels = 64;
+
+template<bool has_alpha>
+void convolve_vertically(const SkConvolutionFilter1D::ConvolutionFixed* filter_values,
+                         int filter_length,
+                         unsigned char* const* source_data_rows,
+                         int pixel_width,
+                         unsigned char* out_row) {
+    const int width = pixel_width & ~7;
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i accum[kChunkPixels / 2];  // Two pixels' 4 channels each.
+
+    for (int chunk_x = 0; chunk_x < width; chunk_x += kChunkPixels) {
+        const int chunk_width = width - chunk_x < kChunkPixels ? width - chunk_x : kChunkPixels;
+        for (int i = 0; i < chunk_width / 2; i++) {
+            accum[i] = zero;
+        }
+
+        for (int filter_y = 0; filter_y < filter_length; filter_y += 2) {
+            const bool has_next = filter_y + 1 < filter_length;
+            const int next_y = has_next ? filter_y + 1 : filter_y;
+            const uint32_t coeff0 = static_cast<uint16_t>(filter_values[filter_y]);
+            const uint32_t coeff1 = has_next ? static_cast<uint16_t>(filter_values[next_y]) : 0;
+            const __m256i coeffs = _mm256_set1_epi32((coeff1 << 16) | coeff0);
+
+            const unsigned char* row0 = &source_data_rows[filter_y][chunk_x << 2];
+            const unsigned char* row1 = &source_data_rows[next_y][chunk_x << 2];
+            __m256i* acc = accum;
+            for (int x = 0; x < chunk_width; x += 8, acc += 4) {
+                __m256i src0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row0 + (x << 2)));
+                __m256i src1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row1 + (x << 2)));
+
+                __m256i lo0 = _mm256_unpacklo_epi8(src0, zero);
+                __m256i lo1 = _mm256_unpacklo_epi8(src1, zero);
+                acc[0] = _mm256_add_epi32(acc[0],
+                    _mm256_madd_epi16(_mm256_unpacklo_epi16(lo0, lo1), coeffs));
+                acc[1] = _mm256_add_epi32(acc[1],
+                    _mm256_madd_epi16(_mm256_unpackhi_epi16(lo0, lo1), coeffs));
+
+                __m256i hi0 = _mm256_unpackhi_epi8(src0, zero);
+                __m256i hi1 = _mm256_unpackhi_epi8(src1, zero);
+                acc[2] = _mm256_add_epi32(acc[2],
+                    _mm256_madd_epi16(_mm256_unpacklo_epi16(hi0, hi1), coeffs));
+                acc[3] = _mm256_add_epi32(acc[3],
+                    _mm256_madd_epi16(_mm256_unpackhi_epi16(hi0, hi1), coeffs));
+            }
+        }
+
+        const __m256i* acc = accum;
+        for (int x = 0; x < chunk_width; x += 8, acc += 4) {
+            __m256i a0 = _mm256_srai_epi32(acc[0], SkConvolutionFilter1D::kShiftBits);
+            __m256i a1 = _mm256_srai_epi32(acc[1], SkConvolutionFilter1D::kShiftBits);
+            __m256i a2 = _mm256_srai_epi32(acc[2], SkConvolutionFilter1D::kShiftBits);
+            __m256i a3 = _mm256_srai_epi32(acc[3], SkConvolutionFilter1D::kShiftBits);
+            __m256i result = _mm256_packus_epi16(_mm256_packs_epi32(a0, a1),
+                                                 _mm256_packs_epi32(a2, a3));
+            if (has_alpha) {
+                // Make sure alpha is at least max(r, g, b).
+                __m256i b = _mm256_max_epu8(_mm256_srli_epi32(result, 8), result);
+                b = _mm256_max_epu8(_mm256_srli_epi32(result, 16), b);
+                result = _mm256_max_epu8(_mm256_slli_epi32(b, 24), result);
+            } else {
+                result = _mm256_or_si256(result, _mm256_set1_epi32(0xff000000));
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out_row + ((chunk_x + x) << 2)),
+                                result);
+        }
+    }
+}
+
+}  // namespace
+
+void convolveVertically_AVX2(const SkConvolutionFilter1D::ConvolutionFixed* filter_values,
+                             int filter_length,
+                             unsigned char* const* source_data_rows,
+                             int pixel_width,
+                             unsigned char* out_row,
+                             bool has_alpha) {
+    if (has_alpha) {
+        convolve_vertically<true>(filter_values, filter_length,
+                                  source_data_rows, pixel_width, out_row);
+    } else {
+        convolve_vertically<false>(filter_values, filter_length,
+                                   source_data_rows, pixel_width, out_row);
+    }
+}
+
+#else // !defined(SK_BUILD_FOR_ANDROID_FRAMEWORK) || SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_AVX2
+
+void convolveVertically_AVX2(const SkConvolutionFilter1D::ConvolutionFixed* filter_values,
+                             int filter_length,
+                             unsigned char* const* source_data_rows,
+                             int pixel_width,
+                             unsigned char* out_row,
+                             bool has_alpha) {
+    sk_throw();
+}
+
+#endif
@@ -0,0 +1,22 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkBitmapFilter_opts_AVX2_DEFINED
+#define SkBitmapFilter_opts_AVX2_DEFINED
+
+#include "SkConvolver.h"
+
+// convolveVertically_SSE2(), but only for the first (pixel_width & ~7) pixels; the caller does
+// the rest.  opts_check_x86.cpp hands those to the SSE2 version.
+void convolveVertically_AVX2(const SkConvolutionFilter1D::ConvolutionFixed* filter_values,
+                             int filter_length,
+                             unsigned char* const* source_data_rows,
+                             int pixel_width,
+                             unsigned char* out_row,
+                             bool has_alpha);
+
+#endif
@@ -597,12 +597,126 @@ void convolveVertically_SSE2(const SkConvolutionFilter1D::ConvolutionFixed* filt
     }
 }
 
+// Shifts, packs, and stores four pixels of |accum|, one per register, as
+// convolveVertically_SSE2() does.
+template<bool has_alpha>
+static inline void storeVertical4_SSE2(__m128i accum0, __m128i accum1,
+                                       __m128i accum2, __m128i accum3,
+                                       unsigned char* out_row) {
+    accum0 = _mm_srai_epi32(accum0, SkConvolutionFilter1D::kShiftBits);
+    accum1 = _mm_srai_epi32(accum1, SkConvolutionFilter1D::kShiftBits);
+    accum2 = _mm_srai_epi32(accum2, SkConvolutionFilter1D::kShiftBits);
+    accum3 = _mm_srai_epi32(accum3, SkConvolutionFilter1D::kShiftBits);
+    accum0 = _mm_packs_epi32(accum0, accum1);
+    accum2 = _mm_packs_epi32(accum2, accum3);
+    accum0 = _mm_packus_epi16(accum0, accum2);
+    if (has_alpha) {
+        // Make sure alpha is at least max(r, g, b).
+        __m128i b = _mm_max_epu8(_mm_srli_epi32(accum0, 8), accum0);
+        b = _mm_max_epu8(_mm_srli_epi32(accum0, 16), b);
+        accum0 = _mm_max_epu8(_mm_slli_epi32(b, 24), accum0);
+    } else {
+        accum0 = _mm_or_si128(accum0, _mm_set1_epi32(0xff000000));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out_row), accum0);
+}
+
+// The version above reads every row of the filter for each 4 output pixels,
+// which is a lot of rows to stream through at once when the filter is long, as
+// it is when scaling big images down a lot.  Instead, this sums pairs of rows
+// into a chunk of 32-bit accumulators that stays in L1 cache, multiplying and
+// adding both rows at once with _mm_madd_epi16.  The sums are the same, so the
+// results are identical.
+static const int kLongFilterChunkPixels = 64;
+
+template<bool has_alpha>
+void convolveVerticallyLong_SSE2(const SkConvolutionFilter1D::ConvolutionFixed* filter_values,
+                                 int filter_length,
+                                 unsigned char* const* source_data_rows,
+                                 int pixel_width,
+                                 unsigned char* out_row) {
+    const int width = pixel_width & ~3;
+    const __m128i zero = _mm_setzero_si128();
+    __m128i accum[kLongFilterChunkPixels];  // One pixel's 4 channels each.
+
+    for (int chunk_x = 0; chunk_x < width; chunk_x += kLongFilterChunkPixels) {
+        const int chunk_width = SkTMin(kLongFilterChunkPixels, width - chunk_x);
+        for (int i = 0; i < chunk_width; i++) {
+            accum[i] = zero;
+        }
+
+        for (int filter_y = 0; filter_y < filter_length; filter_y += 2) {
+            // Pair this row's coefficient with the next one's, or with 0 for
+            // an odd row out (which we then pair with itself).
+            const bool has_next = filter_y + 1 < filter_length;
+            const int next_y = has_next ? filter_y + 1 : filter_y;
+            const uint32_t coeff0 = static_cast<uint16_t>(filter_values[filter_y]);
+            const uint32_t coeff1 = has_next ? static_cast<uint16_t>(filter_values[next_y]) : 0;
+            // [16] c1 c0 c1 c0 c1 c0 c1 c0
+            const __m128i coeffs = _mm_set1_epi32((coeff1 << 16) | coeff0);
+
+            const unsigned char* row0 = &source_data_rows[filter_y][chunk_x << 2];
+            const unsigned char* row1 = &source_data_rows[next_y][chunk_x << 2];
+            for (int x = 0; x < chunk_width; x += 4) {
+                // [8] a3 b3 g3 r3 ... a0 b0 g0 r0, from each row.
+                __m128i src0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + (x << 2)));
+                __m128i src1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + (x << 2)));
+
+                // [16] a1 b1 g1 r1 a0 b0 g0 r0, from each row.
+                __m128i lo0 = _mm_unpacklo_epi8(src0, zero);
+                __m128i lo1 = _mm_unpacklo_epi8(src1, zero);
+                // Interleave the rows channel by channel, so madd sums
+                // row0 * c0 + row1 * c1 for each channel.
+                accum[x + 0] = _mm_add_epi32(accum[x + 0],
+                    _mm_madd_epi16(_mm_unpacklo_epi16(lo0, lo1), coeffs));
+                accum[x + 1] = _mm_add_epi32(accum[x + 1],
+                    _mm_madd_epi16(_mm_unpackhi_epi16(lo0, lo1), coeffs));
+
+                __m128i hi0 = _mm_unpackhi_epi8(src0, zero);
+                __m128i hi1 = _mm_unpackhi_epi8(src1, zero);
+                accum[x + 2] = _mm_add_epi32(accum[x + 2],
+                    _mm_madd_epi16(_mm_unpacklo_epi16(hi0, hi1), coeffs));
+                accum[x + 3] = _mm_add_epi32(accum[x + 3],
+                    _mm_madd_epi16(_mm_unpackhi_epi16(hi0, hi1), coeffs));
+            }
+        }
+
+        for (int x = 0; x < chunk_width; x += 4) {
+            storeVertical4_SSE2<has_alpha>(accum[x], accum[x + 1], accum[x + 2], accum[x + 3],
+                                           out_row + ((chunk_x + x) << 2));
+        }
+    }
+
+    // Leave the last few pixels to the usual version.
+    if (pixel_width & 3) {
+        SkAutoSTMalloc<64, unsigned char*> rows(filter_length);
+        for (int filter_y = 0; filter_y < filter_length; filter_y++) {
+            rows[filter_y] = source_data_rows[filter_y] + (width << 2);
+        }
+        convolveVertically_SSE2<has_alpha>(filter_values, filter_length, rows.get(),
+                                           pixel_width & 3, out_row + (width << 2));
+    }
+}
+
+// Filters longer than this use convolveVerticallyLong_SSE2().
+static const int kLongFilterLength = 8;
+
 void convolveVertically_SSE2(const SkConvolutionFilter1D::ConvolutionFixed* filter_values,
                              int filter_length,
                              unsigned char* const* source_data_rows,
                              int pixel_width,
                              unsigned char* out_row,
                              bool has_alpha) {
+    if (filter_length > kLongFilterLength) {
+        if (has_alpha) {
+            convolveVerticallyLong_SSE2<true>(filter_values, filter_length,
+                                              source_data_rows, pixel_width, out_row);
+        } else {
+            convolveVerticallyLong_SSE2<false>(filter_values, filter_length,
+                                               source_data_rows, pixel_width, out_row);
+        }
+        return;
+    }
     if (has_alpha) {
         convolveVertically_SSE2<true>(filter_values,
                                       filter_length,
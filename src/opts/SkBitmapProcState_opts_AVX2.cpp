@@ -0,0 +1,140 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBitmapProcState_opts_AVX2.h"
+
+// See the note in SkBlitRow_opts_AVX2.cpp.
+#if !defined(SK_BUILD_FOR_ANDROID_FRAMEWORK) || SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_AVX2
+
+#include <immintrin.h>  // AVX2
+
+namespace {
+
+// Filters 4 pixels at once, with each pixel's 4 components widened to 16 bits so the four of
+// them fill a register.  Rather than weighting each sample by x and y together as the SSE2 version
+// does, this blends the top and bottom rows horizontally first, then blends those two vertically.
+// Every intermediate still fits in 16 bits (at most 255 * 16 * 16), so the results are identical.
+template<bool has_alpha>
+void S32_generic_D32_filter_DX_AVX2(const void* pixels, size_t rb, unsigned alphaScale,
+                                    const uint32_t* xy,
+                                    int count, uint32_t* colors) {
+    SkASSERT(count > 0 && colors != NULL);
+    if (has_alpha) {
+        SkASSERT(alphaScale < 256);
+    } else {
+        SkASSERT(alphaScale == 256);
+    }
+
+    const char* srcAddr = static_cast<const char*>(pixels);
+    uint32_t XY = *xy++;
+    unsigned y0 = XY >> 14;
+    const uint32_t* row0 = reinterpret_cast<const uint32_t*>(srcAddr + (y0 >> 4) * rb);
+    const uint32_t* row1 = reinterpret_cast<const uint32_t*>(srcAddr + (XY & 0x3FFF) * rb);
+    unsigned subY = y0 & 0xF;
+
+    const __m256i sixteen = _mm256_set1_epi16(16);
+    const __m256i allY = _mm256_set1_epi16(subY);
+    const __m256i negY = _mm256_sub_epi16(sixteen, allY);
+    const __m256i alpha = _mm256_set1_epi16(alphaScale);
+
+    while (count > 0) {
+        // Past the end we just repeat the last pixel, and don't store it.
+        const int n = count < 4 ? count : 4;
+        uint32_t XX[4];
+        for (int i = 0; i < 4; i++) {
+            XX[i] = xy[i < n ? i : n - 1];  // x0:14 | 4 | x1:14
+        }
+        xy += n;
+
+        unsigned x0[4], x1[4];
+        int subX[4];
+        for (int i = 0; i < 4; i++) {
+            x0[i] = XX[i] >> 18;
+            x1[i] = XX[i] & 0x3FFF;
+            // Each pixel's x weight, repeated in all 4 bytes.
+            subX[i] = ((XX[i] >> 14) & 0x0F) * 0x01010101;
+        }
+
+        // (4 x (x, x, x, x)), (4 x (16-x, 16-x, 16-x, 16-x))
+        __m256i allX = _mm256_cvtepu8_epi16(_mm_setr_epi32(subX[0], subX[1], subX[2], subX[3]));
+        __m256i negX = _mm256_sub_epi16(sixteen, allX);
+
+        // Load 16 samples and expand to 16 bits per component.
+        __m256i a00 = _mm256_cvtepu8_epi16(_mm_setr_epi32(row0[x0[0]], row0[x0[1]],
+                                                          row0[x0[2]], row0[x0[3]]));
+        __m256i a01 = _mm256_cvtepu8_epi16(_mm_setr_epi32(row0[x1[0]], row0[x1[1]],
+                                                          row0[x1[2]], row0[x1[3]]));
+        __m256i a10 = _mm256_cvtepu8_epi16(_mm_setr_epi32(row1[x0[0]], row1[x0[1]],
+                                                          row1[x0[2]], row1[x0[3]]));
+        __m256i a11 = _mm256_cvtepu8_epi16(_mm_setr_epi32(row1[x1[0]], row1[x1[1]],
+                                                          row1[x1[2]], row1[x1[3]]));
+
+        // a00 * (16-x) + a01 * x, and a10 * (16-x) + a11 * x
+        __m256i top = _mm256_add_epi16(_mm256_mullo_epi16(a00, negX),
+                                       _mm256_mullo_epi16(a01, allX));
+        __m256i bottom = _mm256_add_epi16(_mm256_mullo_epi16(a10, negX),
+                                          _mm256_mullo_epi16(a11, allX));
+
+        // top * (16-y) + bottom * y
+        __m256i sum = _mm256_add_epi16(_mm256_mullo_epi16(top, negY),
+                                       _mm256_mullo_epi16(bottom, allY));
+
+        // Divide each 16 bit component by 256.
+        sum = _mm256_srli_epi16(sum, 8);
+
+        if (has_alpha) {
+            sum = _mm256_mullo_epi16(sum, alpha);
+            sum = _mm256_srli_epi16(sum, 8);
+        }
+
+        // Pack to bytes.  That works within each 128-bit lane, giving (p0, p1, p0, p1) and
+        // (p2, p3, p2, p3), so gather the low halves of each lane together.
+        sum = _mm256_packus_epi16(sum, sum);
+        sum = _mm256_permute4x64_epi64(sum, _MM_SHUFFLE(3, 1, 2, 0));
+        __m128i result = _mm256_castsi256_si128(sum);
+
+        if (4 == n) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(colors), result);
+        } else {
+            uint32_t tmp[4];
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(tmp), result);
+            memcpy(colors, tmp, n * sizeof(uint32_t));
+        }
+        colors += n;
+        count -= n;
+    }
+}
+
+}  // namespace
+
+void S32_opaque_D32_filter_DX_AVX2(const void* pixels, size_t rowBytes,
+                                   const uint32_t* xy,
+                                   int count, uint32_t* colors) {
+    S32_generic_D32_filter_DX_AVX2<false>(pixels, rowBytes, 256, xy, count, colors);
+}
+
+void S32_alpha_D32_filter_DX_AVX2(const void* pixels, size_t rowBytes, unsigned alphaScale,
+                                  const uint32_t* xy,
+                                  int count, uint32_t* colors) {
+    S32_generic_D32_filter_DX_AVX2<true>(pixels, rowBytes, alphaScale, xy, count, colors);
+}
+
+#else // !defined(SK_BUILD_FOR_ANDROID_FRAMEWORK) || SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_AVX2
+
+void S32_opaque_D32_filter_DX_AVX2(const void* pixels, size_t rowBytes,
+                                   const uint32_t* xy,
+                                   int count, uint32_t* colors) {
+    sk_throw();
+}
+
+void S32_alpha_D32_filter_DX_AVX2(const void* pixels, size_t rowBytes, unsigned alphaScale,
+                                  const uint32_t* xy,
+                                  int count, uint32_t* colors) {
+    sk_throw();
+}
+
+#endif
@@ -0,0 +1,22 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkBitmapProcState_opts_AVX2_DEFINED
+#define SkBitmapProcState_opts_AVX2_DEFINED
+
+#include "SkTypes.h"
+
+// S32_opaque_D32_filter_DX and S32_alpha_D32_filter_DX for N32 pixels, given the bitmap's
+// pixels and row bytes.  opts_check_x86.cpp unpacks the SkBitmapProcState for these.
+void S32_opaque_D32_filter_DX_AVX2(const void* pixels, size_t rowBytes,
+                                   const uint32_t* xy,
+                                   int count, uint32_t* colors);
+void S32_alpha_D32_filter_DX_AVX2(const void* pixels, size_t rowBytes, unsigned alphaScale,
+                                  const uint32_t* xy,
+                                  int count, uint32_t* colors);
+
+#endif
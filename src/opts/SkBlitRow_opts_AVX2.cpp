@@ -0,0 +1,221 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBlitRow_opts_AVX2.h"
+#include "SkColorPriv.h"
+
+/* As with the SSSE3 procs, the Android framework only builds this file with -mavx2 when the
+ * device is known to support it, and otherwise never calls these, so provide stubs instead.
+ *
+ * Everything compiled with -mavx2 may use AVX2 instructions, including any inline function or
+ * template that isn't static.  Those are merged with the copies in other files at link time, and
+ * the linker may keep ours, so the AVX2 files stick to intrinsics and static helpers, and take
+ * and return plain types.  Anything needing more of Skia goes in opts_check_x86.cpp.
+ */
+#if !defined(SK_BUILD_FOR_ANDROID_FRAMEWORK) || SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_AVX2
+
+#include <immintrin.h>  // AVX2
+
+/* These are the SSE2 procs from SkBlitRow_opts_SSE2.cpp, widened to 8 pixels at a time.
+ * Each lines dst up to 32 bytes, then stops short of the last few pixels.
+ */
+
+int S32_Blend_BlitRow32_AVX2(SkPMColor* SK_RESTRICT dst,
+                             const SkPMColor* SK_RESTRICT src,
+                             int count, U8CPU alpha) {
+    SkASSERT(alpha <= 255);
+    const int total = count;
+
+    if (count >= 8) {
+        uint32_t src_scale = SkAlpha255To256(alpha);
+        uint32_t dst_scale = 256 - src_scale;
+
+        SkASSERT(((size_t)dst & 0x03) == 0);
+        while (((size_t)dst & 0x1F) != 0) {
+            *dst = SkAlphaMulQ(*src, src_scale) + SkAlphaMulQ(*dst, dst_scale);
+            src++;
+            dst++;
+            count--;
+        }
+
+        const __m256i* s = reinterpret_cast<const __m256i*>(src);
+        __m256i* d = reinterpret_cast<__m256i*>(dst);
+        __m256i rb_mask = _mm256_set1_epi32(0x00FF00FF);
+        __m256i ag_mask = _mm256_set1_epi32(0xFF00FF00);
+
+        // Move scale factors to upper byte of word
+        __m256i src_scale_wide = _mm256_set1_epi16(src_scale << 8);
+        __m256i dst_scale_wide = _mm256_set1_epi16(dst_scale << 8);
+        while (count >= 8) {
+            __m256i src_pixel = _mm256_loadu_si256(s);
+            __m256i dst_pixel = _mm256_load_si256(d);
+
+            // (8 x (0, rs.h, 0, bs.h)), as in the SSE2 version.
+            __m256i src_rb = _mm256_and_si256(rb_mask, src_pixel);
+            src_rb = _mm256_mulhi_epu16(src_rb, src_scale_wide);
+            __m256i dst_rb = _mm256_and_si256(rb_mask, dst_pixel);
+            dst_rb = _mm256_mulhi_epu16(dst_rb, dst_scale_wide);
+
+            // (8 x (as.h, 0, gs.h, 0))
+            __m256i src_ag = _mm256_and_si256(ag_mask, src_pixel);
+            src_ag = _mm256_mulhi_epu16(src_ag, src_scale_wide);
+            src_ag = _mm256_and_si256(src_ag, ag_mask);
+            __m256i dst_ag = _mm256_and_si256(ag_mask, dst_pixel);
+            dst_ag = _mm256_mulhi_epu16(dst_ag, dst_scale_wide);
+            dst_ag = _mm256_and_si256(dst_ag, ag_mask);
+
+            src_pixel = _mm256_or_si256(src_rb, src_ag);
+            dst_pixel = _mm256_or_si256(dst_rb, dst_ag);
+
+            _mm256_store_si256(d, _mm256_add_epi8(src_pixel, dst_pixel));
+            s++;
+            d++;
+            count -= 8;
+        }
+    }
+
+    return total - count;
+}
+
+int S32A_Opaque_BlitRow32_AVX2(SkPMColor* SK_RESTRICT dst,
+                               const SkPMColor* SK_RESTRICT src,
+                               int count, U8CPU alpha) {
+    SkASSERT(alpha == 255);
+    const int total = count;
+
+#ifndef SK_USE_ACCURATE_BLENDING
+    if (count >= 8) {
+        SkASSERT(((size_t)dst & 0x03) == 0);
+        while (((size_t)dst & 0x1F) != 0) {
+            *dst = SkPMSrcOver(*src, *dst);
+            src++;
+            dst++;
+            count--;
+        }
+
+        const __m256i* s = reinterpret_cast<const __m256i*>(src);
+        __m256i* d = reinterpret_cast<__m256i*>(dst);
+        __m256i rb_mask = _mm256_set1_epi32(0x00FF00FF);
+        __m256i c_256 = _mm256_set1_epi16(0x0100);  // 16 copies of 256 (16-bit)
+        while (count >= 8) {
+            __m256i src_pixel = _mm256_loadu_si256(s);
+            __m256i dst_pixel = _mm256_load_si256(d);
+
+            __m256i dst_rb = _mm256_and_si256(rb_mask, dst_pixel);
+            __m256i dst_ag = _mm256_srli_epi16(dst_pixel, 8);
+
+            // (a0, g0, a1, g1, ...) -> (a0, a0, a1, a1, ...)  (low byte of each word)
+            // The shuffles work within each 64-bit half, just like the SSE2 ones.
+            __m256i alpha = _mm256_srli_epi16(src_pixel, 8);
+            alpha = _mm256_shufflehi_epi16(alpha, 0xF5);
+            alpha = _mm256_shufflelo_epi16(alpha, 0xF5);
+
+            // Subtract alphas from 256, to get 1..256
+            alpha = _mm256_sub_epi16(c_256, alpha);
+
+            dst_rb = _mm256_mullo_epi16(dst_rb, alpha);
+            dst_ag = _mm256_mullo_epi16(dst_ag, alpha);
+
+            // Divide by 256, and mask out the low bits of alpha and green.
+            dst_rb = _mm256_srli_epi16(dst_rb, 8);
+            dst_ag = _mm256_andnot_si256(rb_mask, dst_ag);
+            dst_pixel = _mm256_or_si256(dst_rb, dst_ag);
+
+            _mm256_store_si256(d, _mm256_add_epi8(src_pixel, dst_pixel));
+            s++;
+            d++;
+            count -= 8;
+        }
+    }
+#endif
+
+    return total - count;
+}
+
+int S32A_Blend_BlitRow32_AVX2(SkPMColor* SK_RESTRICT dst,
+                              const SkPMColor* SK_RESTRICT src,
+                              int count, U8CPU alpha) {
+    SkASSERT(alpha <= 255);
+    const int total = count;
+
+    if (count >= 8) {
+        while (((size_t)dst & 0x1F) != 0) {
+            *dst = SkBlendARGB32(*src, *dst, alpha);
+            src++;
+            dst++;
+            count--;
+        }
+
+        uint32_t src_scale = SkAlpha255To256(alpha);
+
+        const __m256i* s = reinterpret_cast<const __m256i*>(src);
+        __m256i* d = reinterpret_cast<__m256i*>(dst);
+        __m256i src_scale_wide = _mm256_set1_epi16(src_scale << 8);
+        __m256i rb_mask = _mm256_set1_epi32(0x00FF00FF);
+        __m256i c_256 = _mm256_set1_epi16(256);  // 16 copies of 256 (16-bit)
+        while (count >= 8) {
+            __m256i src_pixel = _mm256_loadu_si256(s);
+            __m256i dst_pixel = _mm256_load_si256(d);
+
+            __m256i dst_rb = _mm256_and_si256(rb_mask, dst_pixel);
+            __m256i src_rb = _mm256_and_si256(rb_mask, src_pixel);
+            __m256i dst_ag = _mm256_srli_epi16(dst_pixel, 8);
+            __m256i src_ag = _mm256_srli_epi16(src_pixel, 8);
+
+            // 256 - (src alpha * src_scale), in the low byte of each word.
+            __m256i dst_alpha = _mm256_shufflehi_epi16(src_ag, 0xF5);
+            dst_alpha = _mm256_shufflelo_epi16(dst_alpha, 0xF5);
+            dst_alpha = _mm256_mulhi_epu16(dst_alpha, src_scale_wide);
+            dst_alpha = _mm256_sub_epi16(c_256, dst_alpha);
+
+            // Scale dst by that, and src by the global alpha.
+            dst_rb = _mm256_mullo_epi16(dst_rb, dst_alpha);
+            dst_ag = _mm256_mullo_epi16(dst_ag, dst_alpha);
+            src_rb = _mm256_mulhi_epu16(src_rb, src_scale_wide);
+            src_ag = _mm256_mulhi_epu16(src_ag, src_scale_wide);
+
+            dst_rb = _mm256_srli_epi16(dst_rb, 8);
+            dst_ag = _mm256_andnot_si256(rb_mask, dst_ag);
+            src_ag = _mm256_slli_epi16(src_ag, 8);
+
+            dst_pixel = _mm256_or_si256(dst_rb, dst_ag);
+            src_pixel = _mm256_or_si256(src_rb, src_ag);
+
+            _mm256_store_si256(d, _mm256_add_epi8(src_pixel, dst_pixel));
+            s++;
+            d++;
+            count -= 8;
+        }
+    }
+
+    return total - count;
+}
+
+#else // !defined(SK_BUILD_FOR_ANDROID_FRAMEWORK) || SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_AVX2
+
+int S32_Blend_BlitRow32_AVX2(SkPMColor* SK_RESTRICT dst,
+                             const SkPMColor* SK_RESTRICT src,
+                             int count, U8CPU alpha) {
+    sk_throw();
+    return 0;
+}
+
+int S32A_Opaque_BlitRow32_AVX2(SkPMColor* SK_RESTRICT dst,
+                               const SkPMColor* SK_RESTRICT src,
+                               int count, U8CPU alpha) {
+    sk_throw();
+    return 0;
+}
+
+int S32A_Blend_BlitRow32_AVX2(SkPMColor* SK_RESTRICT dst,
+                              const SkPMColor* SK_RESTRICT src,
+                              int count, U8CPU alpha) {
+    sk_throw();
+    return 0;
+}
+
+#endif
@@ -0,0 +1,28 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkBlitRow_opts_AVX2_DEFINED
+#define SkBlitRow_opts_AVX2_DEFINED
+
+#include "SkColor.h"
+
+// These blit as many pixels as they can 8 at a time, and return how many that was.  The rest are
+// left to the SSE2 procs; opts_check_x86.cpp puts the two together into SkBlitRow::Proc32s.
+
+int S32_Blend_BlitRow32_AVX2(SkPMColor* SK_RESTRICT dst,
+                             const SkPMColor* SK_RESTRICT src,
+                             int count, U8CPU alpha);
+
+int S32A_Opaque_BlitRow32_AVX2(SkPMColor* SK_RESTRICT dst,
+                               const SkPMColor* SK_RESTRICT src,
+                               int count, U8CPU alpha);
+
+int S32A_Blend_BlitRow32_AVX2(SkPMColor* SK_RESTRICT dst,
+                              const SkPMColor* SK_RESTRICT src,
+                              int count, U8CPU alpha);
+
+#endif
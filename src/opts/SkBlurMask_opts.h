@@ -0,0 +1,37 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkBlurMask_opts_DEFINED
+#define SkBlurMask_opts_DEFINED
+
+#include "SkTypes.h"
+
+/**
+ * These blur each of the first width columns of an A8 image, height rows tall, down its column.
+ * The result is written to dst, height + 2 * max(leftRadius, rightRadius) rows tall (or
+ * height + 2 * radius for the interpolating version); see SkBlurMask.cpp for exactly what they
+ * compute.  Each returns how many of the leading columns it blurred, which may be 0; the caller
+ * blurs the rest.
+ */
+typedef int (*SkBoxBlurMaskProc)(const uint8_t* src, int srcRowBytes,
+                                 uint8_t* dst, int dstRowBytes,
+                                 int leftRadius, int rightRadius, int width, int height);
+typedef int (*SkBoxBlurMaskInterpProc)(const uint8_t* src, int srcRowBytes,
+                                       uint8_t* dst, int dstRowBytes,
+                                       int radius, uint8_t outerWeight, int width, int height);
+
+/**
+ * This transposes src, height rows of width bytes, into dst, width rows of height bytes.
+ */
+typedef void (*SkTransposeMaskProc)(const uint8_t* src, int srcRowBytes,
+                                    uint8_t* dst, int dstRowBytes, int width, int height);
+
+bool SkBoxBlurMaskGetPlatformProcs(SkBoxBlurMaskProc* boxBlur,
+                                   SkBoxBlurMaskInterpProc* boxBlurInterp,
+                                   SkTransposeMaskProc* transpose);
+
+#endif
@@ -0,0 +1,358 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include <emmintrin.h>
+#include "SkBlurMask_opts_SSE2.h"
+#include "SkTemplates.h"
+
+/* Like the portable code in SkBlurMask.cpp, these walk down the rows keeping a running sum for
+ * every column, adding the row entering the kernel and subtracting the one leaving it, so the
+ * results are identical.  They work on 16 columns at a time and leave any others to the caller.
+ *
+ * The portable code computes (sum * scale + (1 << 23)) >> 24 in 32 bits, and the product never
+ * overflows.  When the kernel is at most 257 pixels the sums fit in 16 bits, and so does
+ *   ((sum * scale) >> 16) + (1 << 7)
+ *       == sum * (scale >> 16) + ((sum * (scale & 0xFFFF)) >> 16) + (1 << 7),
+ * which is all we need to take the top 8 bits.  That keeps 8 sums to a register and avoids
+ * SSE2's lack of a 32-bit multiply.  Bigger kernels fall back to 32-bit sums.
+ */
+
+namespace {
+
+// Sums of up to 257 bytes fit in 16 bits.
+inline bool fits_in_16_bits(int kernelSize) {
+    return kernelSize * 255 <= 0xFFFF;
+}
+
+inline __m128i load(const void* ptr) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+}
+
+inline void store(void* ptr, const __m128i& v) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr), v);
+}
+
+// Widens 8 bytes to 8 x uint16, or 4 bytes to 4 x uint32.
+inline __m128i expand_epi16(const uint8_t* src) {
+    return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src)),
+                             _mm_setzero_si128());
+}
+
+inline __m128i expand_epi32(const uint8_t* src) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i pixels = _mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(src));
+    return _mm_unpacklo_epi16(_mm_unpacklo_epi8(pixels, zero), zero);
+}
+
+// ((sum * scale) >> 16) for each 16-bit lane, given scale split into its high and low 16 bits.
+inline __m128i mul_scale_epi16(const __m128i& sum,
+                               const __m128i& scaleHi, const __m128i& scaleLo) {
+    return _mm_add_epi16(_mm_mullo_epi16(sum, scaleHi), _mm_mulhi_epu16(sum, scaleLo));
+}
+
+// a * scale for each 32-bit lane, keeping the low 32 bits.  scale must be the same in all lanes.
+inline __m128i mullo_epi32(const __m128i& a, const __m128i& scale) {
+    // SSE2 has no PMULLD, so multiply the even and odd lanes separately.
+    __m128i even = _mm_mul_epu32(a, scale);
+    __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), scale);
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0,0,2,0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0,0,2,0)));
+}
+
+// Takes the top byte of each 16-bit lane of two registers, or each 32-bit lane of four.
+inline void store_epi16(uint8_t* dst, const __m128i& v0, const __m128i& v1) {
+    store(dst, _mm_packus_epi16(_mm_srli_epi16(v0, 8), _mm_srli_epi16(v1, 8)));
+}
+
+inline void store_epi32(uint8_t* dst, const __m128i& v0, const __m128i& v1,
+                                      const __m128i& v2, const __m128i& v3) {
+    __m128i lo = _mm_packs_epi32(_mm_srli_epi32(v0, 24), _mm_srli_epi32(v1, 24));
+    __m128i hi = _mm_packs_epi32(_mm_srli_epi32(v2, 24), _mm_srli_epi32(v3, 24));
+    store(dst, _mm_packus_epi16(lo, hi));
+}
+
+// outer * outerScale + inner * innerScale, like mul_scale_epi16().  Here the low halves of the two
+// products may carry into the high halves when added, so we track that too.
+inline __m128i interp_epi16(const __m128i& outer, const __m128i& inner,
+                            const __m128i& outerHi, const __m128i& outerLo,
+                            const __m128i& innerHi, const __m128i& innerLo,
+                            const __m128i& halfPlusOne) {
+    __m128i lo0 = _mm_mullo_epi16(outer, outerLo);
+    __m128i lo1 = _mm_mullo_epi16(inner, innerLo);
+    // -1 where lo0 + lo1 doesn't carry, 0 where it does.
+    __m128i noCarry = _mm_cmpeq_epi16(_mm_adds_epu16(lo0, lo1), _mm_add_epi16(lo0, lo1));
+    __m128i result = _mm_add_epi16(mul_scale_epi16(outer, outerHi, outerLo),
+                                   mul_scale_epi16(inner, innerHi, innerLo));
+    return _mm_add_epi16(result, _mm_add_epi16(halfPlusOne, noCarry));
+}
+
+/**
+ * Walks down height + diameter rows, calling row(entering, excluded, leaving, dst) for each.
+ * entering and leaving are the rows entering and leaving the kernel, or zeros.  excluded is the
+ * row the interpolating blur's inner kernel excludes along with leaving: usually entering, but
+ * if the source is shorter than the kernel, the rows between its end and the diameter keep
+ * excluding its last row.
+ */
+template <typename Row>
+void blur_rows(const uint8_t* src, int srcRowBytes, uint8_t* dst, int dstRowBytes,
+               int diameter, int width, int height, Row& row) {
+    SkAutoSTMalloc<1024, uint8_t> zeros(width);
+    sk_bzero(zeros.get(), width);
+    for (int y = 0; y < height + diameter; ++y) {
+        const uint8_t* entering = y < height ? src + y * srcRowBytes : zeros.get();
+        const uint8_t* leaving = y >= diameter ? src + (y - diameter) * srcRowBytes : zeros.get();
+        const uint8_t* excluded = entering;
+        if (y >= height && y < diameter && height > 0) {
+            excluded = src + (height - 1) * srcRowBytes;
+        }
+        row.blur(entering, excluded, leaving, dst);
+        dst += dstRowBytes;
+    }
+}
+
+class BoxBlurRow_epi16 {
+public:
+    BoxBlurRow_epi16(uint32_t scale, int width) : fSums(width), fWidth(width) {
+        sk_bzero(fSums.get(), width * sizeof(uint16_t));
+        fScaleHi = _mm_set1_epi16(scale >> 16);
+        fScaleLo = _mm_set1_epi16(scale & 0xFFFF);
+        fHalf = _mm_set1_epi16(1 << 7);
+    }
+
+    void blur(const uint8_t* entering, const uint8_t*, const uint8_t* leaving, uint8_t* dst) {
+        uint16_t* sums = fSums.get();
+        for (int x = 0; x < fWidth; x += 16) {
+            __m128i result[2];
+            for (int i = 0; i < 2; ++i) {
+                __m128i sum = _mm_add_epi16(load(sums + x + 8*i), expand_epi16(entering + x + 8*i));
+                store(sums + x + 8*i, _mm_sub_epi16(sum, expand_epi16(leaving + x + 8*i)));
+                result[i] = _mm_add_epi16(mul_scale_epi16(sum, fScaleHi, fScaleLo), fHalf);
+            }
+            store_epi16(dst + x, result[0], result[1]);
+        }
+    }
+
+private:
+    SkAutoSTMalloc<512, uint16_t> fSums;
+    int fWidth;
+    __m128i fScaleHi, fScaleLo, fHalf;
+};
+
+class BoxBlurRow_epi32 {
+public:
+    BoxBlurRow_epi32(uint32_t scale, int width) : fSums(width), fWidth(width) {
+        sk_bzero(fSums.get(), width * sizeof(uint32_t));
+        fScale = _mm_set1_epi32(scale);
+        fHalf = _mm_set1_epi32(1 << 23);
+    }
+
+    void blur(const uint8_t* entering, const uint8_t*, const uint8_t* leaving, uint8_t* dst) {
+        uint32_t* sums = fSums.get();
+        for (int x = 0; x < fWidth; x += 16) {
+            __m128i result[4];
+            for (int i = 0; i < 4; ++i) {
+                __m128i sum = _mm_add_epi32(load(sums + x + 4*i), expand_epi32(entering + x + 4*i));
+                store(sums + x + 4*i, _mm_sub_epi32(sum, expand_epi32(leaving + x + 4*i)));
+                result[i] = _mm_add_epi32(mullo_epi32(sum, fScale), fHalf);
+            }
+            store_epi32(dst + x, result[0], result[1], result[2], result[3]);
+        }
+    }
+
+private:
+    SkAutoSTMalloc<256, uint32_t> fSums;
+    int fWidth;
+    __m128i fScale, fHalf;
+};
+
+class BoxBlurInterpRow_epi16 {
+public:
+    BoxBlurInterpRow_epi16(uint32_t outerScale, uint32_t innerScale, int width)
+        : fSums(width), fWidth(width) {
+        sk_bzero(fSums.get(), width * sizeof(uint16_t));
+        fOuterHi = _mm_set1_epi16(outerScale >> 16);
+        fOuterLo = _mm_set1_epi16(outerScale & 0xFFFF);
+        fInnerHi = _mm_set1_epi16(innerScale >> 16);
+        fInnerLo = _mm_set1_epi16(innerScale & 0xFFFF);
+        fHalfPlusOne = _mm_set1_epi16((1 << 7) + 1);
+    }
+
+    void blur(const uint8_t* entering, const uint8_t* excluded, const uint8_t* leaving,
+              uint8_t* dst) {
+        uint16_t* sums = fSums.get();
+        for (int x = 0; x < fWidth; x += 16) {
+            __m128i result[2];
+            for (int i = 0; i < 2; ++i) {
+                __m128i out = expand_epi16(leaving + x + 8*i);
+                __m128i outer = _mm_add_epi16(load(sums + x + 8*i),
+                                              expand_epi16(entering + x + 8*i));
+                __m128i inner = _mm_sub_epi16(outer,
+                                              _mm_add_epi16(expand_epi16(excluded + x + 8*i), out));
+                store(sums + x + 8*i, _mm_sub_epi16(outer, out));
+                result[i] = interp_epi16(outer, inner, fOuterHi, fOuterLo, fInnerHi, fInnerLo,
+                                         fHalfPlusOne);
+            }
+            store_epi16(dst + x, result[0], result[1]);
+        }
+    }
+
+private:
+    SkAutoSTMalloc<512, uint16_t> fSums;
+    int fWidth;
+    __m128i fOuterHi, fOuterLo, fInnerHi, fInnerLo, fHalfPlusOne;
+};
+
+class BoxBlurInterpRow_epi32 {
+public:
+    BoxBlurInterpRow_epi32(uint32_t outerScale, uint32_t innerScale, int width)
+        : fSums(width), fWidth(width) {
+        sk_bzero(fSums.get(), width * sizeof(uint32_t));
+        fOuterScale = _mm_set1_epi32(outerScale);
+        fInnerScale = _mm_set1_epi32(innerScale);
+        fHalf = _mm_set1_epi32(1 << 23);
+    }
+
+    void blur(const uint8_t* entering, const uint8_t* excluded, const uint8_t* leaving,
+              uint8_t* dst) {
+        uint32_t* sums = fSums.get();
+        for (int x = 0; x < fWidth; x += 16) {
+            __m128i result[4];
+            for (int i = 0; i < 4; ++i) {
+                __m128i out = expand_epi32(leaving + x + 4*i);
+                __m128i outer = _mm_add_epi32(load(sums + x + 4*i),
+                                              expand_epi32(entering + x + 4*i));
+                __m128i inner = _mm_sub_epi32(outer,
+                                              _mm_add_epi32(expand_epi32(excluded + x + 4*i), out));
+                store(sums + x + 4*i, _mm_sub_epi32(outer, out));
+                result[i] = _mm_add_epi32(_mm_add_epi32(mullo_epi32(outer, fOuterScale), fHalf),
+                                          mullo_epi32(inner, fInnerScale));
+            }
+            store_epi32(dst + x, result[0], result[1], result[2], result[3]);
+        }
+    }
+
+private:
+    SkAutoSTMalloc<256, uint32_t> fSums;
+    int fWidth;
+    __m128i fOuterScale, fInnerScale, fHalf;
+};
+
+void store_zeros(uint8_t* dst, int dstRowBytes, int width, int count) {
+    for (int y = 0; y < count; ++y) {
+        sk_bzero(dst, width);
+        dst += dstRowBytes;
+    }
+}
+
+int SkBoxBlurMask_SSE2(const uint8_t* src, int srcRowBytes, uint8_t* dst, int dstRowBytes,
+                       int leftRadius, int rightRadius, int width, int height) {
+    width &= ~15;
+    if (0 == width) {
+        return 0;
+    }
+    const int diameter = leftRadius + rightRadius;
+    const uint32_t scale = (1 << 24) / (diameter + 1);
+
+    store_zeros(dst, dstRowBytes, width, rightRadius - leftRadius);
+    dst += SkMax32(rightRadius - leftRadius, 0) * dstRowBytes;
+    if (fits_in_16_bits(diameter + 1)) {
+        BoxBlurRow_epi16 row(scale, width);
+        blur_rows(src, srcRowBytes, dst, dstRowBytes, diameter, width, height, row);
+    } else {
+        BoxBlurRow_epi32 row(scale, width);
+        blur_rows(src, srcRowBytes, dst, dstRowBytes, diameter, width, height, row);
+    }
+    dst += (height + diameter) * dstRowBytes;
+    store_zeros(dst, dstRowBytes, width, leftRadius - rightRadius);
+    return width;
+}
+
+int SkBoxBlurMaskInterp_SSE2(const uint8_t* src, int srcRowBytes, uint8_t* dst, int dstRowBytes,
+                             int radius, uint8_t outerWeight, int width, int height) {
+    width &= ~15;
+    if (0 == width) {
+        return 0;
+    }
+    const int diameter = radius * 2;
+    const int kernelSize = diameter + 1;
+    int outer = outerWeight;
+    int inner = 255 - outerWeight;
+    outer += outer >> 7;
+    inner += inner >> 7;
+    const uint32_t outerScale = (outer << 16) / kernelSize;
+    const uint32_t innerScale = (inner << 16) / (kernelSize - 2);
+
+    if (fits_in_16_bits(kernelSize)) {
+        BoxBlurInterpRow_epi16 row(outerScale, innerScale, width);
+        blur_rows(src, srcRowBytes, dst, dstRowBytes, diameter, width, height, row);
+    } else {
+        BoxBlurInterpRow_epi32 row(outerScale, innerScale, width);
+        blur_rows(src, srcRowBytes, dst, dstRowBytes, diameter, width, height, row);
+    }
+    return width;
+}
+
+// Transposes one 16x16 block of bytes, by interleaving ever larger pieces of pairs of rows.
+void transpose_16x16(const uint8_t* src, int srcRowBytes, uint8_t* dst, int dstRowBytes) {
+    __m128i a[16], b[16];
+    for (int i = 0; i < 16; ++i) {
+        a[i] = load(src + i * srcRowBytes);
+    }
+    // Pairs of rows: b[2i] holds columns 0-7 of rows 2i and 2i+1, b[2i+1] columns 8-15.
+    for (int i = 0; i < 8; ++i) {
+        b[2*i + 0] = _mm_unpacklo_epi8(a[2*i], a[2*i + 1]);
+        b[2*i + 1] = _mm_unpackhi_epi8(a[2*i], a[2*i + 1]);
+    }
+    // Groups of 4 rows: a[4j + k] holds columns 4k to 4k+3 of rows 4j to 4j+3.
+    for (int j = 0; j < 4; ++j) {
+        a[4*j + 0] = _mm_unpacklo_epi16(b[4*j + 0], b[4*j + 2]);
+        a[4*j + 1] = _mm_unpackhi_epi16(b[4*j + 0], b[4*j + 2]);
+        a[4*j + 2] = _mm_unpacklo_epi16(b[4*j + 1], b[4*j + 3]);
+        a[4*j + 3] = _mm_unpackhi_epi16(b[4*j + 1], b[4*j + 3]);
+    }
+    // Groups of 8 rows: b[8k + m] holds columns 2m and 2m+1 of rows 8k to 8k+7.
+    for (int k = 0; k < 2; ++k) {
+        for (int m = 0; m < 4; ++m) {
+            b[8*k + 2*m + 0] = _mm_unpacklo_epi32(a[8*k + m], a[8*k + 4 + m]);
+            b[8*k + 2*m + 1] = _mm_unpackhi_epi32(a[8*k + m], a[8*k + 4 + m]);
+        }
+    }
+    // All 16 rows of each column.
+    for (int n = 0; n < 8; ++n) {
+        store(dst + (2*n + 0) * dstRowBytes, _mm_unpacklo_epi64(b[n], b[8 + n]));
+        store(dst + (2*n + 1) * dstRowBytes, _mm_unpackhi_epi64(b[n], b[8 + n]));
+    }
+}
+
+void SkTransposeMask_SSE2(const uint8_t* src, int srcRowBytes, uint8_t* dst, int dstRowBytes,
+                          int width, int height) {
+    const int width16 = width & ~15;
+    const int height16 = height & ~15;
+    for (int y = 0; y < height16; y += 16) {
+        for (int x = 0; x < width16; x += 16) {
+            transpose_16x16(src + y * srcRowBytes + x, srcRowBytes,
+                            dst + x * dstRowBytes + y, dstRowBytes);
+        }
+    }
+    // The right and bottom edges.
+    for (int y = 0; y < height; ++y) {
+        for (int x = y < height16 ? width16 : 0; x < width; ++x) {
+            dst[x * dstRowBytes + y] = src[y * srcRowBytes + x];
+        }
+    }
+}
+
+} // namespace
+
+bool SkBoxBlurMaskGetPlatformProcs_SSE2(SkBoxBlurMaskProc* boxBlur,
+                                        SkBoxBlurMaskInterpProc* boxBlurInterp,
+                                        SkTransposeMaskProc* transpose) {
+    *boxBlur = SkBoxBlurMask_SSE2;
+    *boxBlurInterp = SkBoxBlurMaskInterp_SSE2;
+    *transpose = SkTransposeMask_SSE2;
+    return true;
+}
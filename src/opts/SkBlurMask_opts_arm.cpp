@@ -0,0 +1,24 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBlurMask_opts_neon.h"
+#include "SkUtilsArm.h"
+
+bool SkBoxBlurMaskGetPlatformProcs(SkBoxBlurMaskProc* boxBlur,
+                                   SkBoxBlurMaskInterpProc* boxBlurInterp,
+                                   SkTransposeMaskProc* transpose) {
+#if SK_ARM_NEON_IS_NONE
+    return false;
+#else
+#if SK_ARM_NEON_IS_DYNAMIC
+    if (!sk_cpu_arm_has_neon()) {
+        return false;
+    }
+#endif
+    return SkBoxBlurMaskGetPlatformProcs_NEON(boxBlur, boxBlurInterp, transpose);
+#endif
+}
@@ -0,0 +1,214 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBlurMask_opts_neon.h"
+#include "SkTemplates.h"
+
+#include <arm_neon.h>
+
+/* NEON versions of the procs in SkBlurMask_opts_SSE2.cpp.  NEON has a 32-bit multiply, so these
+ * simply keep 32-bit sums, 16 columns at a time.
+ */
+
+namespace {
+
+// Widens 16 bytes to four registers of 4 x uint32.
+inline void expand16(const uint8_t* src, uint32x4_t v[4]) {
+    uint8x16_t pixels = vld1q_u8(src);
+    uint16x8_t lo = vmovl_u8(vget_low_u8(pixels));
+    uint16x8_t hi = vmovl_u8(vget_high_u8(pixels));
+    v[0] = vmovl_u16(vget_low_u16(lo));
+    v[1] = vmovl_u16(vget_high_u16(lo));
+    v[2] = vmovl_u16(vget_low_u16(hi));
+    v[3] = vmovl_u16(vget_high_u16(hi));
+}
+
+// Takes the top byte of each 32-bit lane of the four registers, in order.
+inline void store16(uint8_t* dst, const uint32x4_t v[4]) {
+    uint16x8_t lo = vcombine_u16(vshrn_n_u32(v[0], 16), vshrn_n_u32(v[1], 16));
+    uint16x8_t hi = vcombine_u16(vshrn_n_u32(v[2], 16), vshrn_n_u32(v[3], 16));
+    vst1q_u8(dst, vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8)));
+}
+
+void store_zeros(uint8_t* dst, int dstRowBytes, int width, int count) {
+    for (int y = 0; y < count; ++y) {
+        sk_bzero(dst, width);
+        dst += dstRowBytes;
+    }
+}
+
+// See blur_rows() in SkBlurMask_opts_SSE2.cpp.
+template <typename Row>
+void blur_rows(const uint8_t* src, int srcRowBytes, uint8_t* dst, int dstRowBytes,
+               int diameter, int width, int height, Row& row) {
+    SkAutoSTMalloc<1024, uint8_t> zeros(width);
+    sk_bzero(zeros.get(), width);
+    for (int y = 0; y < height + diameter; ++y) {
+        const uint8_t* entering = y < height ? src + y * srcRowBytes : zeros.get();
+        const uint8_t* leaving = y >= diameter ? src + (y - diameter) * srcRowBytes : zeros.get();
+        const uint8_t* excluded = entering;
+        if (y >= height && y < diameter && height > 0) {
+            excluded = src + (height - 1) * srcRowBytes;
+        }
+        row.blur(entering, excluded, leaving, dst);
+        dst += dstRowBytes;
+    }
+}
+
+class BoxBlurRow {
+public:
+    BoxBlurRow(uint32_t scale, int width) : fSums(width), fWidth(width), fScale(scale) {
+        sk_bzero(fSums.get(), width * sizeof(uint32_t));
+    }
+
+    void blur(const uint8_t* entering, const uint8_t*, const uint8_t* leaving, uint8_t* dst) {
+        const uint32x4_t half = vdupq_n_u32(1 << 23);
+        uint32_t* sums = fSums.get();
+        for (int x = 0; x < fWidth; x += 16) {
+            uint32x4_t in[4], out[4], result[4];
+            expand16(entering + x, in);
+            expand16(leaving + x, out);
+            for (int i = 0; i < 4; ++i) {
+                uint32x4_t sum = vaddq_u32(vld1q_u32(sums + x + 4*i), in[i]);
+                vst1q_u32(sums + x + 4*i, vsubq_u32(sum, out[i]));
+                result[i] = vmlaq_n_u32(half, sum, fScale);
+            }
+            store16(dst + x, result);
+        }
+    }
+
+private:
+    SkAutoSTMalloc<256, uint32_t> fSums;
+    int fWidth;
+    uint32_t fScale;
+};
+
+class BoxBlurInterpRow {
+public:
+    BoxBlurInterpRow(uint32_t outerScale, uint32_t innerScale, int width)
+        : fSums(width), fWidth(width), fOuterScale(outerScale), fInnerScale(innerScale) {
+        sk_bzero(fSums.get(), width * sizeof(uint32_t));
+    }
+
+    void blur(const uint8_t* entering, const uint8_t* excluded, const uint8_t* leaving,
+              uint8_t* dst) {
+        const uint32x4_t half = vdupq_n_u32(1 << 23);
+        uint32_t* sums = fSums.get();
+        for (int x = 0; x < fWidth; x += 16) {
+            uint32x4_t in[4], ex[4], out[4], result[4];
+            expand16(entering + x, in);
+            expand16(excluded + x, ex);
+            expand16(leaving + x, out);
+            for (int i = 0; i < 4; ++i) {
+                uint32x4_t outer = vaddq_u32(vld1q_u32(sums + x + 4*i), in[i]);
+                uint32x4_t inner = vsubq_u32(outer, vaddq_u32(ex[i], out[i]));
+                vst1q_u32(sums + x + 4*i, vsubq_u32(outer, out[i]));
+                result[i] = vmlaq_n_u32(vmlaq_n_u32(half, outer, fOuterScale), inner, fInnerScale);
+            }
+            store16(dst + x, result);
+        }
+    }
+
+private:
+    SkAutoSTMalloc<256, uint32_t> fSums;
+    int fWidth;
+    uint32_t fOuterScale, fInnerScale;
+};
+
+int SkBoxBlurMask_NEON(const uint8_t* src, int srcRowBytes, uint8_t* dst, int dstRowBytes,
+                       int leftRadius, int rightRadius, int width, int height) {
+    width &= ~15;
+    if (0 == width) {
+        return 0;
+    }
+    const int diameter = leftRadius + rightRadius;
+
+    store_zeros(dst, dstRowBytes, width, rightRadius - leftRadius);
+    dst += SkMax32(rightRadius - leftRadius, 0) * dstRowBytes;
+    BoxBlurRow row((1 << 24) / (diameter + 1), width);
+    blur_rows(src, srcRowBytes, dst, dstRowBytes, diameter, width, height, row);
+    dst += (height + diameter) * dstRowBytes;
+    store_zeros(dst, dstRowBytes, width, leftRadius - rightRadius);
+    return width;
+}
+
+int SkBoxBlurMaskInterp_NEON(const uint8_t* src, int srcRowBytes, uint8_t* dst, int dstRowBytes,
+                             int radius, uint8_t outerWeight, int width, int height) {
+    width &= ~15;
+    if (0 == width) {
+        return 0;
+    }
+    const int diameter = radius * 2;
+    const int kernelSize = diameter + 1;
+    int outer = outerWeight;
+    int inner = 255 - outerWeight;
+    outer += outer >> 7;
+    inner += inner >> 7;
+
+    BoxBlurInterpRow row((outer << 16) / kernelSize, (inner << 16) / (kernelSize - 2), width);
+    blur_rows(src, srcRowBytes, dst, dstRowBytes, diameter, width, height, row);
+    return width;
+}
+
+// Transposes one 8x8 block of bytes, by transposing ever larger pieces of pairs of rows.
+void transpose_8x8(const uint8_t* src, int srcRowBytes, uint8_t* dst, int dstRowBytes) {
+    uint8x8_t r[8];
+    for (int i = 0; i < 8; ++i) {
+        r[i] = vld1_u8(src + i * srcRowBytes);
+    }
+    uint8x8x2_t t0 = vtrn_u8(r[0], r[1]);
+    uint8x8x2_t t1 = vtrn_u8(r[2], r[3]);
+    uint8x8x2_t t2 = vtrn_u8(r[4], r[5]);
+    uint8x8x2_t t3 = vtrn_u8(r[6], r[7]);
+    // Columns (0, 4) and (2, 6), then (1, 5) and (3, 7), of rows 0-3 and then rows 4-7.
+    uint16x4x2_t u0 = vtrn_u16(vreinterpret_u16_u8(t0.val[0]), vreinterpret_u16_u8(t1.val[0]));
+    uint16x4x2_t u1 = vtrn_u16(vreinterpret_u16_u8(t0.val[1]), vreinterpret_u16_u8(t1.val[1]));
+    uint16x4x2_t u2 = vtrn_u16(vreinterpret_u16_u8(t2.val[0]), vreinterpret_u16_u8(t3.val[0]));
+    uint16x4x2_t u3 = vtrn_u16(vreinterpret_u16_u8(t2.val[1]), vreinterpret_u16_u8(t3.val[1]));
+    // Columns (0, 4), (1, 5), (2, 6), and (3, 7).
+    uint32x2x2_t v0 = vtrn_u32(vreinterpret_u32_u16(u0.val[0]), vreinterpret_u32_u16(u2.val[0]));
+    uint32x2x2_t v1 = vtrn_u32(vreinterpret_u32_u16(u1.val[0]), vreinterpret_u32_u16(u3.val[0]));
+    uint32x2x2_t v2 = vtrn_u32(vreinterpret_u32_u16(u0.val[1]), vreinterpret_u32_u16(u2.val[1]));
+    uint32x2x2_t v3 = vtrn_u32(vreinterpret_u32_u16(u1.val[1]), vreinterpret_u32_u16(u3.val[1]));
+    vst1_u8(dst + 0 * dstRowBytes, vreinterpret_u8_u32(v0.val[0]));
+    vst1_u8(dst + 1 * dstRowBytes, vreinterpret_u8_u32(v1.val[0]));
+    vst1_u8(dst + 2 * dstRowBytes, vreinterpret_u8_u32(v2.val[0]));
+    vst1_u8(dst + 3 * dstRowBytes, vreinterpret_u8_u32(v3.val[0]));
+    vst1_u8(dst + 4 * dstRowBytes, vreinterpret_u8_u32(v0.val[1]));
+    vst1_u8(dst + 5 * dstRowBytes, vreinterpret_u8_u32(v1.val[1]));
+    vst1_u8(dst + 6 * dstRowBytes, vreinterpret_u8_u32(v2.val[1]));
+    vst1_u8(dst + 7 * dstRowBytes, vreinterpret_u8_u32(v3.val[1]));
+}
+
+void SkTransposeMask_NEON(const uint8_t* src, int srcRowBytes, uint8_t* dst, int dstRowBytes,
+                          int width, int height) {
+    const int width8 = width & ~7;
+    const int height8 = height & ~7;
+    for (int y = 0; y < height8; y += 8) {
+        for (int x = 0; x < width8; x += 8) {
+            transpose_8x8(src + y * srcRowBytes + x, srcRowBytes,
+                          dst + x * dstRowBytes + y, dstRowBytes);
+        }
+    }
+    // The right and bottom edges.
+    for (int y = 0; y < height; ++y) {
+        for (int x = y < height8 ? width8 : 0; x < width; ++x) {
+            dst[x * dstRowBytes + y] = src[y * srcRowBytes + x];
+        }
+    }
+}
+
+} // namespace
+
+bool SkBoxBlurMaskGetPlatformProcs_NEON(SkBoxBlurMaskProc* boxBlur,
+                                        SkBoxBlurMaskInterpProc* boxBlurInterp,
+                                        SkTransposeMaskProc* transpose) {
+    *boxBlur = SkBoxBlurMask_NEON;
+    *boxBlurInterp = SkBoxBlurMaskInterp_NEON;
+    *transpose = SkTransposeMask_NEON;
+    return true;
+}
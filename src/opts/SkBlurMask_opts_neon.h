@@ -0,0 +1,17 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkBlurMask_opts_neon_DEFINED
+#define SkBlurMask_opts_neon_DEFINED
+
+#include "SkBlurMask_opts.h"
+
+bool SkBoxBlurMaskGetPlatformProcs_NEON(SkBoxBlurMaskProc* boxBlur,
+                                        SkBoxBlurMaskInterpProc* boxBlurInterp,
+                                        SkTransposeMaskProc* transpose);
+
+#endif
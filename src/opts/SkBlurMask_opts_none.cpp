@@ -0,0 +1,14 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBlurMask_opts.h"
+
+bool SkBoxBlurMaskGetPlatformProcs(SkBoxBlurMaskProc* boxBlur,
+                                   SkBoxBlurMaskInterpProc* boxBlurInterp,
+                                   SkTransposeMaskProc* transpose) {
+    return false;
+}
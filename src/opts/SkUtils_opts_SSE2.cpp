@@ -97,3 +97,51 @@ void sk_memcpy32_SSE2(uint32_t *dst, const uint32_t *src, int count)
         --count;
     }
 }
+
+// Returns the index of the first set bit of a nonzero _mm_movemask_epi8() result.
+static inline int first_set_byte(int mask) {
+    SkASSERT(mask != 0);
+    int index = 0;
+    while (0 == (mask & 1)) {
+        mask >>= 1;
+        index += 1;
+    }
+    return index;
+}
+
+int sk_utf8_count_leading_ascii_SSE2(const char utf8[], int count) {
+    int i = 0;
+    // The high bit of each byte is set if it's not ASCII, and movemask gathers exactly those.
+    while (i + 16 <= count) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(utf8 + i));
+        int mask = _mm_movemask_epi8(bytes);
+        if (mask) {
+            return i + first_set_byte(mask);
+        }
+        i += 16;
+    }
+    while (i < count && (utf8[i] & 0x80) == 0) {
+        i += 1;
+    }
+    return i;
+}
+
+int sk_utf16_count_leading_non_surrogates_SSE2(const uint16_t utf16[], int count) {
+    const __m128i surrogateMask = _mm_set1_epi16((short)0xF800);
+    const __m128i surrogateBits = _mm_set1_epi16((short)0xD800);
+    int i = 0;
+    while (i + 8 <= count) {
+        __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(utf16 + i));
+        __m128i isSurrogate = _mm_cmpeq_epi16(_mm_and_si128(values, surrogateMask),
+                                              surrogateBits);
+        int mask = _mm_movemask_epi8(isSurrogate);
+        if (mask) {
+            return i + first_set_byte(mask) / 2;
+        }
+        i += 8;
+    }
+    while (i < count && (utf16[i] & 0xF800) != 0xD800) {
+        i += 1;
+    }
+    return i;
+}
@@ -13,5 +13,7 @@
 void sk_memset16_SSE2(uint16_t *dst, uint16_t value, int count);
 void sk_memset32_SSE2(uint32_t *dst, uint32_t value, int count);
 void sk_memcpy32_SSE2(uint32_t *dst, const uint32_t *src, int count);
+int sk_utf8_count_leading_ascii_SSE2(const char utf8[], int count);
+int sk_utf16_count_leading_non_surrogates_SSE2(const uint16_t utf16[], int count);
 
 #endif
@@ -20,3 +20,11 @@ SkMemset32Proc SkMemset32GetPlatformProc() {
 SkMemcpy32Proc SkMemcpy32GetPlatformProc() {
     return NULL;
 }
+
+SkUTF8_CountLeadingASCIIProc SkUTF8_CountLeadingASCIIGetPlatformProc() {
+    return NULL;
+}
+
+SkUTF16_CountLeadingNonSurrogatesProc SkUTF16_CountLeadingNonSurrogatesGetPlatformProc() {
+    return NULL;
+}
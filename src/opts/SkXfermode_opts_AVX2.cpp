@@ -0,0 +1,192 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkXfermode_opts_AVX2.h"
+
+// See the note in SkBlitRow_opts_AVX2.cpp.
+#if !defined(SK_BUILD_FOR_ANDROID_FRAMEWORK) || SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_AVX2
+
+#include "SkColor_opts_AVX2.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// 8 pixels AVX2 version functions, ported from SkXfermode_opts_SSE2.cpp
+////////////////////////////////////////////////////////////////////////////////
+
+static __m256i srcover_modeproc_AVX2(const __m256i& src, const __m256i& dst) {
+    __m256i isa = _mm256_sub_epi32(_mm256_set1_epi32(256), SkGetPackedA32_AVX2(src));
+    return _mm256_add_epi32(src, SkAlphaMulQ_AVX2(dst, isa));
+}
+
+static __m256i dstover_modeproc_AVX2(const __m256i& src, const __m256i& dst) {
+    __m256i ida = _mm256_sub_epi32(_mm256_set1_epi32(256), SkGetPackedA32_AVX2(dst));
+    return _mm256_add_epi32(dst, SkAlphaMulQ_AVX2(src, ida));
+}
+
+static __m256i srcin_modeproc_AVX2(const __m256i& src, const __m256i& dst) {
+    __m256i da = SkGetPackedA32_AVX2(dst);
+    return SkAlphaMulQ_AVX2(src, SkAlpha255To256_AVX2(da));
+}
+
+static __m256i dstin_modeproc_AVX2(const __m256i& src, const __m256i& dst) {
+    __m256i sa = SkGetPackedA32_AVX2(src);
+    return SkAlphaMulQ_AVX2(dst, SkAlpha255To256_AVX2(sa));
+}
+
+static __m256i srcout_modeproc_AVX2(const __m256i& src, const __m256i& dst) {
+    __m256i ida = _mm256_sub_epi32(_mm256_set1_epi32(256), SkGetPackedA32_AVX2(dst));
+    return SkAlphaMulQ_AVX2(src, ida);
+}
+
+static __m256i dstout_modeproc_AVX2(const __m256i& src, const __m256i& dst) {
+    __m256i isa = _mm256_sub_epi32(_mm256_set1_epi32(256), SkGetPackedA32_AVX2(src));
+    return SkAlphaMulQ_AVX2(dst, isa);
+}
+
+// Returns (a * sc + b * dc) / 255 for each of r, g, and b, packed with alpha.
+static inline __m256i blend_rgb_AVX2(const __m256i& alpha,
+                                     const __m256i& a, const __m256i& src,
+                                     const __m256i& b, const __m256i& dst) {
+    __m256i r = _mm256_add_epi32(SkAlphaMulAlpha_AVX2(a, SkGetPackedR32_AVX2(src)),
+                                 SkAlphaMulAlpha_AVX2(b, SkGetPackedR32_AVX2(dst)));
+    __m256i g = _mm256_add_epi32(SkAlphaMulAlpha_AVX2(a, SkGetPackedG32_AVX2(src)),
+                                 SkAlphaMulAlpha_AVX2(b, SkGetPackedG32_AVX2(dst)));
+    __m256i bl = _mm256_add_epi32(SkAlphaMulAlpha_AVX2(a, SkGetPackedB32_AVX2(src)),
+                                  SkAlphaMulAlpha_AVX2(b, SkGetPackedB32_AVX2(dst)));
+    return SkPackARGB32_AVX2(alpha, r, g, bl);
+}
+
+static __m256i srcatop_modeproc_AVX2(const __m256i& src, const __m256i& dst) {
+    __m256i sa = SkGetPackedA32_AVX2(src);
+    __m256i da = SkGetPackedA32_AVX2(dst);
+    __m256i isa = _mm256_sub_epi32(_mm256_set1_epi32(255), sa);
+    return blend_rgb_AVX2(da, da, src, isa, dst);
+}
+
+static __m256i dstatop_modeproc_AVX2(const __m256i& src, const __m256i& dst) {
+    __m256i sa = SkGetPackedA32_AVX2(src);
+    __m256i da = SkGetPackedA32_AVX2(dst);
+    __m256i ida = _mm256_sub_epi32(_mm256_set1_epi32(255), da);
+    return blend_rgb_AVX2(sa, ida, src, sa, dst);
+}
+
+static __m256i xor_modeproc_AVX2(const __m256i& src, const __m256i& dst) {
+    __m256i sa = SkGetPackedA32_AVX2(src);
+    __m256i da = SkGetPackedA32_AVX2(dst);
+    __m256i isa = _mm256_sub_epi32(_mm256_set1_epi32(255), sa);
+    __m256i ida = _mm256_sub_epi32(_mm256_set1_epi32(255), da);
+
+    __m256i a1 = _mm256_add_epi32(sa, da);
+    __m256i a2 = SkAlphaMulAlpha_AVX2(sa, da);
+    a2 = _mm256_slli_epi32(a2, 1);
+    __m256i a = _mm256_sub_epi32(a1, a2);
+
+    return blend_rgb_AVX2(a, ida, src, isa, dst);
+}
+
+static __m256i plus_modeproc_AVX2(const __m256i& src, const __m256i& dst) {
+    __m256i c255 = _mm256_set1_epi32(255);
+    __m256i b = _mm256_min_epi32(_mm256_add_epi32(SkGetPackedB32_AVX2(src),
+                                                  SkGetPackedB32_AVX2(dst)), c255);
+    __m256i g = _mm256_min_epi32(_mm256_add_epi32(SkGetPackedG32_AVX2(src),
+                                                  SkGetPackedG32_AVX2(dst)), c255);
+    __m256i r = _mm256_min_epi32(_mm256_add_epi32(SkGetPackedR32_AVX2(src),
+                                                  SkGetPackedR32_AVX2(dst)), c255);
+    __m256i a = _mm256_min_epi32(_mm256_add_epi32(SkGetPackedA32_AVX2(src),
+                                                  SkGetPackedA32_AVX2(dst)), c255);
+    return SkPackARGB32_AVX2(a, r, g, b);
+}
+
+static __m256i modulate_modeproc_AVX2(const __m256i& src, const __m256i& dst) {
+    __m256i a = SkAlphaMulAlpha_AVX2(SkGetPackedA32_AVX2(src),
+                                     SkGetPackedA32_AVX2(dst));
+    __m256i r = SkAlphaMulAlpha_AVX2(SkGetPackedR32_AVX2(src),
+                                     SkGetPackedR32_AVX2(dst));
+    __m256i g = SkAlphaMulAlpha_AVX2(SkGetPackedG32_AVX2(src),
+                                     SkGetPackedG32_AVX2(dst));
+    __m256i b = SkAlphaMulAlpha_AVX2(SkGetPackedB32_AVX2(src),
+                                     SkGetPackedB32_AVX2(dst));
+    return SkPackARGB32_AVX2(a, r, g, b);
+}
+
+static inline __m256i srcover_byte_AVX2(const __m256i& a, const __m256i& b) {
+    // a + b - SkAlphaMulAlpha(a, b);
+    return _mm256_sub_epi32(_mm256_add_epi32(a, b), SkAlphaMulAlpha_AVX2(a, b));
+}
+
+static __m256i screen_modeproc_AVX2(const __m256i& src, const __m256i& dst) {
+    __m256i a = srcover_byte_AVX2(SkGetPackedA32_AVX2(src),
+                                  SkGetPackedA32_AVX2(dst));
+    __m256i r = srcover_byte_AVX2(SkGetPackedR32_AVX2(src),
+                                  SkGetPackedR32_AVX2(dst));
+    __m256i g = srcover_byte_AVX2(SkGetPackedG32_AVX2(src),
+                                  SkGetPackedG32_AVX2(dst));
+    __m256i b = srcover_byte_AVX2(SkGetPackedB32_AVX2(src),
+                                  SkGetPackedB32_AVX2(dst));
+    return SkPackARGB32_AVX2(a, r, g, b);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+typedef __m256i (*SkXfermodeProcAVX2)(const __m256i& src, const __m256i& dst);
+
+void SkXfermodeXfer32_AVX2(void* procAVX2, SkPMColor dst[], const SkPMColor src[], int count) {
+    SkASSERT(((size_t)dst & 0x1F) == 0 && (count & 7) == 0);
+    SkXfermodeProcAVX2 proc = reinterpret_cast<SkXfermodeProcAVX2>(procAVX2);
+
+    const __m256i* s = reinterpret_cast<const __m256i*>(src);
+    __m256i* d = reinterpret_cast<__m256i*>(dst);
+
+    while (count >= 8) {
+        __m256i src_pixel = _mm256_loadu_si256(s++);
+        __m256i dst_pixel = _mm256_load_si256(d);
+
+        dst_pixel = proc(src_pixel, dst_pixel);
+        _mm256_store_si256(d++, dst_pixel);
+        count -= 8;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// 8 pixels modeprocs with AVX2.  The separable and non-separable modes past kScreen_Mode are
+// left to SSE2; they are dominated by their clamping and division, not by width.
+static const SkXfermodeProcAVX2 gAVX2XfermodeProcs[] = {
+    NULL, // kClear_Mode
+    NULL, // kSrc_Mode
+    NULL, // kDst_Mode
+    srcover_modeproc_AVX2,
+    dstover_modeproc_AVX2,
+    srcin_modeproc_AVX2,
+    dstin_modeproc_AVX2,
+    srcout_modeproc_AVX2,
+    dstout_modeproc_AVX2,
+    srcatop_modeproc_AVX2,
+    dstatop_modeproc_AVX2,
+    xor_modeproc_AVX2,
+    plus_modeproc_AVX2,
+    modulate_modeproc_AVX2,
+    screen_modeproc_AVX2,
+};
+
+void* SkXfermodeProc_AVX2(int mode) {
+    if (mode < 0 || mode >= (int)SK_ARRAY_COUNT(gAVX2XfermodeProcs)) {
+        return NULL;
+    }
+    return reinterpret_cast<void*>(gAVX2XfermodeProcs[mode]);
+}
+
+#else // !defined(SK_BUILD_FOR_ANDROID_FRAMEWORK) || SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_AVX2
+
+void SkXfermodeXfer32_AVX2(void* procAVX2, SkPMColor dst[], const SkPMColor src[], int count) {
+    sk_throw();
+}
+
+void* SkXfermodeProc_AVX2(int mode) {
+    return NULL;
+}
+
+#endif
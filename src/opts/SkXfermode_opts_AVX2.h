@@ -0,0 +1,20 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkXfermode_opts_AVX2_DEFINED
+#define SkXfermode_opts_AVX2_DEFINED
+
+#include "SkColor.h"
+
+// Returns the 8 pixel version of mode's proc, or NULL if there isn't one.
+void* SkXfermodeProc_AVX2(int mode);
+
+// Runs procAVX2, from SkXfermodeProc_AVX2(), over count pixels.  dst must be 32 byte aligned and
+// count a multiple of 8.  SkAVX2ProcCoeffXfermode, in SkXfermode_opts_SSE2.h, does the rest.
+void SkXfermodeXfer32_AVX2(void* procAVX2, SkPMColor dst[], const SkPMColor src[], int count);
+
+#endif // SkXfermode_opts_AVX2_DEFINED
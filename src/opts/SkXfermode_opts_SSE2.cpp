@@ -10,6 +10,7 @@
 #include "SkMathPriv.h"
 #include "SkMath_opts_SSE2.h"
 #include "SkXfermode.h"
+#include "SkXfermode_opts_AVX2.h"
 #include "SkXfermode_opts_SSE2.h"
 #include "SkXfermode_proccoeff.h"
 
@@ -817,3 +818,42 @@ SkProcCoeffXfermode* SkPlatformXfermodeFactory_impl_SSE2(const ProcCoeff& rec,
     }
     return NULL;
 }
+
+////////////////////////////////////////////////////////////////////////////////
+
+void SkAVX2ProcCoeffXfermode::xfer32(SkPMColor dst[], const SkPMColor src[],
+                                     int count, const SkAlpha aa[]) const {
+    SkASSERT(dst && src && count >= 0);
+
+    if (NULL == aa && count >= 8) {
+        SkXfermodeProc proc = this->getProc();
+        SkASSERT(fProcAVX2 != NULL);
+
+        while (((size_t)dst & 0x1F) != 0) {
+            *dst = proc(*src, *dst);
+            dst++;
+            src++;
+            count--;
+        }
+
+        const int n = count & ~7;
+        SkXfermodeXfer32_AVX2(fProcAVX2, dst, src, n);
+        dst += n;
+        src += n;
+        count -= n;
+    }
+
+    // Coverage, and whatever is left over.
+    this->INHERITED::xfer32(dst, src, count, aa);
+}
+
+SkProcCoeffXfermode* SkPlatformXfermodeFactory_impl_AVX2(const ProcCoeff& rec,
+                                                         SkXfermode::Mode mode) {
+    void* procSSE2 = reinterpret_cast<void*>(gSSE2XfermodeProcs[mode]);
+    void* procAVX2 = SkXfermodeProc_AVX2(mode);
+
+    if (procSSE2 != NULL && procAVX2 != NULL) {
+        return SkNEW_ARGS(SkAVX2ProcCoeffXfermode, (rec, mode, procSSE2, procAVX2));
+    }
+    return NULL;
+}
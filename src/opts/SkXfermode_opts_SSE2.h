@@ -32,7 +32,27 @@ private:
     typedef SkProcCoeffXfermode INHERITED;
 };
 
+// Runs 8 pixels at a time through procAVX2 where it can, and falls back on the SSE2 version
+// for everything else.  This flattens as an SkSSE2ProcCoeffXfermode, so pictures recorded on an
+// AVX2 machine play back anywhere.  It lives here rather than in SkXfermode_opts_AVX2.cpp to keep
+// its inline and virtual functions out of code built with -mavx2.
+class SkAVX2ProcCoeffXfermode : public SkSSE2ProcCoeffXfermode {
+public:
+    SkAVX2ProcCoeffXfermode(const ProcCoeff& rec, SkXfermode::Mode mode,
+                            void* procSSE2, void* procAVX2)
+        : INHERITED(rec, mode, procSSE2), fProcAVX2(procAVX2) {}
+
+    virtual void xfer32(SkPMColor dst[], const SkPMColor src[], int count,
+                        const SkAlpha aa[]) const SK_OVERRIDE;
+
+private:
+    void* fProcAVX2;
+    typedef SkSSE2ProcCoeffXfermode INHERITED;
+};
+
 SkProcCoeffXfermode* SkPlatformXfermodeFactory_impl_SSE2(const ProcCoeff& rec,
                                                          SkXfermode::Mode mode);
+SkProcCoeffXfermode* SkPlatformXfermodeFactory_impl_AVX2(const ProcCoeff& rec,
+                                                         SkXfermode::Mode mode);
 
 #endif // SkXfermode_opts_SSE2_DEFINED
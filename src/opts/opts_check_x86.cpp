@@ -5,23 +5,28 @@
  * found in the LICENSE file.
  */
 
+#include "SkBitmapFilter_opts_AVX2.h"
 #include "SkBitmapFilter_opts_SSE2.h"
+#include "SkBitmapProcState_opts_AVX2.h"
 #include "SkBitmapProcState_opts_SSE2.h"
 #include "SkBitmapProcState_opts_SSSE3.h"
 #include "SkBlitMask.h"
 #include "SkBlitRect_opts_SSE2.h"
 #include "SkBlitRow.h"
+#include "SkBlitRow_opts_AVX2.h"
 #include "SkBlitRow_opts_SSE2.h"
 #include "SkBlurImage_opts_SSE2.h"
+#include "SkBlurMask_opts_SSE2.h"
 #include "SkMorphology_opts.h"
 #include "SkMorphology_opts_SSE2.h"
 #include "SkRTConf.h"
+#include "SkTemplates.h"
 #include "SkUtils.h"
 #include "SkUtils_opts_SSE2.h"
 #include "SkXfermode.h"
 #include "SkXfermode_proccoeff.h"
 
-#if defined(_MSC_VER) && defined(_WIN64)
+#if defined(_MSC_VER)
 #include <intrin.h>
 #endif
 
@@ -32,14 +37,17 @@
    compiled with -msse2 or higher. */
 
 
-/* Function to get the CPU SSE-level in runtime, for different compilers. */
+/* Function to get the CPU SSE-level in runtime, for different compilers.
+ * Leaves with sub-leaves (e.g. 7) are always queried for sub-leaf 0.
+ */
 #ifdef _MSC_VER
 static inline void getcpuid(int info_type, int info[4]) {
 #if defined(_WIN64)
-    __cpuid(info, info_type);
+    __cpuidex(info, info_type, 0);
 #else
     __asm {
         mov    eax, [info_type]
+        xor    ecx, ecx
         cpuid
         mov    edi, [info]
         mov    [edi], eax
@@ -54,7 +62,7 @@ static inline void getcpuid(int info_type, int info[4]) {
     asm volatile (
         "cpuid \n\t"
         : "=a"(info[0]), "=b"(info[1]), "=c"(info[2]), "=d"(info[3])
-        : "a"(info_type)
+        : "0"(info_type), "2"(0)
     );
 }
 #else
@@ -66,11 +74,34 @@ static inline void getcpuid(int info_type, int info[4]) {
         "movl %%ebx, %1   \n\t"
         "popl %%ebx       \n\t"
         : "=a"(info[0]), "=r"(info[1]), "=c"(info[2]), "=d"(info[3])
-        : "a"(info_type)
+        : "0"(info_type), "2"(0)
     );
 }
 #endif
 
+/* Whether the OS saves and restores the YMM registers (XCR0 bits 1 and 2).
+ * Only call this once CPUID says XGETBV is there (OSXSAVE).
+ */
+#if defined(_MSC_VER)
+static inline bool os_saves_ymm() {
+#if _MSC_FULL_VER >= 160040219  // _xgetbv arrived in VS2010 SP1.
+    return (_xgetbv(0) & 6) == 6;
+#else
+    return false;
+#endif
+}
+#else
+static inline bool os_saves_ymm() {
+    uint32_t eax, edx;
+    asm volatile (
+        ".byte 0x0f, 0x01, 0xd0 \n\t"  // xgetbv, spelled out for older assemblers
+        : "=a"(eax), "=d"(edx)
+        : "c"(0)
+    );
+    return (eax & 6) == 6;
+}
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 
 /* Fetch the SIMD level directly from the CPU, at run-time.
@@ -79,7 +110,19 @@ static inline void getcpuid(int info_type, int info[4]) {
 static int get_SIMD_level() {
     int cpu_info[4] = { 0 };
 
+    getcpuid(0, cpu_info);
+    const int max_leaf = cpu_info[0];
+
     getcpuid(1, cpu_info);
+    const bool osxsave = (cpu_info[2] & (1<<27)) != 0,
+               avx     = (cpu_info[2] & (1<<28)) != 0;
+    if (osxsave && avx && os_saves_ymm()) {
+        int leaf7[4] = { 0 };
+        if (max_leaf >= 7) {
+            getcpuid(7, leaf7);
+        }
+        return (leaf7[1] & (1<<5)) != 0 ? SK_CPU_SSE_LEVEL_AVX2 : SK_CPU_SSE_LEVEL_AVX;
+    }
     if ((cpu_info[2] & (1<<20)) != 0) {
         return SK_CPU_SSE_LEVEL_SSE42;
     } else if ((cpu_info[2] & (1<<9)) != 0) {
@@ -93,8 +136,12 @@ static int get_SIMD_level() {
 
 /* Verify that the requested SIMD level is supported in the build.
  * If not, check if the platform supports it.
+ * Either way, respect any cap set with SkSetSIMDLevelCap().
  */
 static inline bool supports_simd(int minLevel) {
+    if (minLevel > SkGetSIMDLevelCap()) {
+        return false;
+    }
 #if defined(SK_CPU_SSE_LEVEL)
     if (minLevel <= SK_CPU_SSE_LEVEL) {
         return true;
@@ -120,6 +167,48 @@ static inline bool supports_simd(int minLevel) {
 
 SK_CONF_DECLARE( bool, c_hqfilter_sse, "bitmap.filter.highQualitySSE", false, "Use SSE optimized version of high quality image filters");
 
+/* The AVX2 procs only take plain types and leave their last few pixels to us, so that nothing
+   from the rest of Skia gets compiled with -mavx2.  See SkBlitRow_opts_AVX2.cpp. */
+
+static void convolveVertically_AVX2_SSE2(
+        const SkConvolutionFilter1D::ConvolutionFixed* filter_values,
+        int filter_length,
+        unsigned char* const* source_data_rows,
+        int pixel_width,
+        unsigned char* out_row,
+        bool has_alpha) {
+    convolveVertically_AVX2(filter_values, filter_length, source_data_rows,
+                            pixel_width, out_row, has_alpha);
+
+    const int done = pixel_width & ~7;
+    if (done < pixel_width) {
+        SkAutoSTMalloc<64, unsigned char*> rows(filter_length);
+        for (int filter_y = 0; filter_y < filter_length; filter_y++) {
+            rows[filter_y] = source_data_rows[filter_y] + (done << 2);
+        }
+        convolveVertically_SSE2(filter_values, filter_length, rows.get(),
+                                pixel_width - done, out_row + (done << 2), has_alpha);
+    }
+}
+
+static void S32_opaque_D32_filter_DX_AVX2_SSE2(const SkBitmapProcState& s,
+                                               const uint32_t* xy,
+                                               int count, uint32_t* colors) {
+    SkASSERT(s.fFilterLevel != SkPaint::kNone_FilterLevel);
+    SkASSERT(kN32_SkColorType == s.fBitmap->colorType());
+    S32_opaque_D32_filter_DX_AVX2(s.fBitmap->getPixels(), s.fBitmap->rowBytes(),
+                                  xy, count, colors);
+}
+
+static void S32_alpha_D32_filter_DX_AVX2_SSE2(const SkBitmapProcState& s,
+                                              const uint32_t* xy,
+                                              int count, uint32_t* colors) {
+    SkASSERT(s.fFilterLevel != SkPaint::kNone_FilterLevel);
+    SkASSERT(kN32_SkColorType == s.fBitmap->colorType());
+    S32_alpha_D32_filter_DX_AVX2(s.fBitmap->getPixels(), s.fBitmap->rowBytes(), s.fAlphaScale,
+                                 xy, count, colors);
+}
+
 void SkBitmapProcState::platformConvolutionProcs(SkConvolutionProcs* procs) {
     if (supports_simd(SK_CPU_SSE_LEVEL_SSE2)) {
         procs->fExtraHorizontalReads = 3;
@@ -128,6 +217,9 @@ void SkBitmapProcState::platformConvolutionProcs(SkConvolutionProcs* procs) {
         procs->fConvolveHorizontally = &convolveHorizontally_SSE2;
         procs->fApplySIMDPadding = &applySIMDPadding_SSE2;
     }
+    if (supports_simd(SK_CPU_SSE_LEVEL_AVX2)) {
+        procs->fConvolveVertically = &convolveVertically_AVX2_SSE2;
+    }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -140,7 +232,9 @@ void SkBitmapProcState::platformProcs() {
 
     /* Check fSampleProc32 */
     if (fSampleProc32 == S32_opaque_D32_filter_DX) {
-        if (supports_simd(SK_CPU_SSE_LEVEL_SSSE3)) {
+        if (supports_simd(SK_CPU_SSE_LEVEL_AVX2)) {
+            fSampleProc32 = S32_opaque_D32_filter_DX_AVX2_SSE2;
+        } else if (supports_simd(SK_CPU_SSE_LEVEL_SSSE3)) {
             fSampleProc32 = S32_opaque_D32_filter_DX_SSSE3;
         } else {
             fSampleProc32 = S32_opaque_D32_filter_DX_SSE2;
@@ -150,7 +244,9 @@ void SkBitmapProcState::platformProcs() {
             fSampleProc32 = S32_opaque_D32_filter_DXDY_SSSE3;
         }
     } else if (fSampleProc32 == S32_alpha_D32_filter_DX) {
-        if (supports_simd(SK_CPU_SSE_LEVEL_SSSE3)) {
+        if (supports_simd(SK_CPU_SSE_LEVEL_AVX2)) {
+            fSampleProc32 = S32_alpha_D32_filter_DX_AVX2_SSE2;
+        } else if (supports_simd(SK_CPU_SSE_LEVEL_SSSE3)) {
             fSampleProc32 = S32_alpha_D32_filter_DX_SSSE3;
         } else {
             fSampleProc32 = S32_alpha_D32_filter_DX_SSE2;
@@ -213,8 +309,38 @@ static SkBlitRow::Proc32 platform_32_procs[] = {
     S32A_Blend_BlitRow32_SSE2,          // S32A_Blend,
 };
 
+static void S32_Blend_BlitRow32_AVX2_SSE2(SkPMColor* SK_RESTRICT dst,
+                                          const SkPMColor* SK_RESTRICT src,
+                                          int count, U8CPU alpha) {
+    int n = S32_Blend_BlitRow32_AVX2(dst, src, count, alpha);
+    S32_Blend_BlitRow32_SSE2(dst + n, src + n, count - n, alpha);
+}
+
+static void S32A_Opaque_BlitRow32_AVX2_SSE2(SkPMColor* SK_RESTRICT dst,
+                                            const SkPMColor* SK_RESTRICT src,
+                                            int count, U8CPU alpha) {
+    int n = S32A_Opaque_BlitRow32_AVX2(dst, src, count, alpha);
+    S32A_Opaque_BlitRow32_SSE2(dst + n, src + n, count - n, alpha);
+}
+
+static void S32A_Blend_BlitRow32_AVX2_SSE2(SkPMColor* SK_RESTRICT dst,
+                                           const SkPMColor* SK_RESTRICT src,
+                                           int count, U8CPU alpha) {
+    int n = S32A_Blend_BlitRow32_AVX2(dst, src, count, alpha);
+    S32A_Blend_BlitRow32_SSE2(dst + n, src + n, count - n, alpha);
+}
+
+static SkBlitRow::Proc32 platform_32_procs_AVX2[] = {
+    NULL,                               // S32_Opaque,
+    S32_Blend_BlitRow32_AVX2_SSE2,      // S32_Blend,
+    S32A_Opaque_BlitRow32_AVX2_SSE2,    // S32A_Opaque
+    S32A_Blend_BlitRow32_AVX2_SSE2,     // S32A_Blend,
+};
+
 SkBlitRow::Proc32 SkBlitRow::PlatformProcs32(unsigned flags) {
-    if (supports_simd(SK_CPU_SSE_LEVEL_SSE2)) {
+    if (supports_simd(SK_CPU_SSE_LEVEL_AVX2)) {
+        return platform_32_procs_AVX2[flags];
+    } else if (supports_simd(SK_CPU_SSE_LEVEL_SSE2)) {
         return platform_32_procs[flags];
     } else {
         return NULL;
@@ -311,6 +437,22 @@ SkMemcpy32Proc SkMemcpy32GetPlatformProc() {
     }
 }
 
+SkUTF8_CountLeadingASCIIProc SkUTF8_CountLeadingASCIIGetPlatformProc() {
+    if (supports_simd(SK_CPU_SSE_LEVEL_SSE2)) {
+        return sk_utf8_count_leading_ascii_SSE2;
+    } else {
+        return NULL;
+    }
+}
+
+SkUTF16_CountLeadingNonSurrogatesProc SkUTF16_CountLeadingNonSurrogatesGetPlatformProc() {
+    if (supports_simd(SK_CPU_SSE_LEVEL_SSE2)) {
+        return sk_utf16_count_leading_non_surrogates_SSE2;
+    } else {
+        return NULL;
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 SkMorphologyImageFilter::Proc SkMorphologyGetPlatformProc(SkMorphologyProcType type) {
@@ -347,10 +489,21 @@ bool SkBoxBlurGetPlatformProcs(SkBoxBlurProc* boxBlurX,
 #endif
 }
 
+bool SkBoxBlurMaskGetPlatformProcs(SkBoxBlurMaskProc* boxBlur,
+                                   SkBoxBlurMaskInterpProc* boxBlurInterp,
+                                   SkTransposeMaskProc* transpose) {
+    if (!supports_simd(SK_CPU_SSE_LEVEL_SSE2)) {
+        return false;
+    }
+    return SkBoxBlurMaskGetPlatformProcs_SSE2(boxBlur, boxBlurInterp, transpose);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 extern SkProcCoeffXfermode* SkPlatformXfermodeFactory_impl_SSE2(const ProcCoeff& rec,
                                                                 SkXfermode::Mode mode);
+extern SkProcCoeffXfermode* SkPlatformXfermodeFactory_impl_AVX2(const ProcCoeff& rec,
+                                                                SkXfermode::Mode mode);
 
 SkProcCoeffXfermode* SkPlatformXfermodeFactory_impl(const ProcCoeff& rec,
                                                     SkXfermode::Mode mode);
@@ -365,6 +518,12 @@ SkProcCoeffXfermode* SkPlatformXfermodeFactory(const ProcCoeff& rec,
 
 SkProcCoeffXfermode* SkPlatformXfermodeFactory(const ProcCoeff& rec,
                                                SkXfermode::Mode mode) {
+    if (supports_simd(SK_CPU_SSE_LEVEL_AVX2)) {
+        SkProcCoeffXfermode* xfermode = SkPlatformXfermodeFactory_impl_AVX2(rec, mode);
+        if (NULL != xfermode) {
+            return xfermode;
+        }
+    }
     if (supports_simd(SK_CPU_SSE_LEVEL_SSE2)) {
         return SkPlatformXfermodeFactory_impl_SSE2(rec, mode);
     } else {
@@ -6,6 +6,8 @@
  */
 #include "SkAddIntersections.h"
 #include "SkPathOpsBounds.h"
+#include "SkTDArray.h"
+#include "SkTSort.h"
 
 #if DEBUG_ADD_INTERSECTING_TS
 
@@ -174,234 +176,326 @@ static void debugShowCubicIntersection(int , const SkIntersectionHelper& ,
 }
 #endif
 
-bool AddIntersectTs(SkOpContour* test, SkOpContour* next) {
-    if (test != next) {
-        if (AlmostLessUlps(test->bounds().fBottom, next->bounds().fTop)) {
-            return false;
-        }
-        // OPTIMIZATION: outset contour bounds a smidgen instead?
-        if (!SkPathOpsBounds::Intersects(test->bounds(), next->bounds())) {
-            return true;
-        }
+static void add_intersect_ts(SkOpContour* test, SkIntersectionHelper& wt, SkOpContour* next,
+        SkIntersectionHelper& wn, bool* foundCommonContour) {
+    if (!SkPathOpsBounds::Intersects(wt.bounds(), wn.bounds())) {
+        return;
     }
-    SkIntersectionHelper wt;
-    wt.init(test);
-    bool foundCommonContour = test == next;
-    do {
-        SkIntersectionHelper wn;
-        wn.init(next);
-        if (test == next && !wn.startAfter(wt)) {
-            continue;
-        }
-        do {
-            if (!SkPathOpsBounds::Intersects(wt.bounds(), wn.bounds())) {
-                continue;
+    int pts = 0;
+    SkIntersections ts;
+    bool swap = false;
+    switch (wt.segmentType()) {
+        case SkIntersectionHelper::kHorizontalLine_Segment:
+            swap = true;
+            switch (wn.segmentType()) {
+                case SkIntersectionHelper::kHorizontalLine_Segment:
+                case SkIntersectionHelper::kVerticalLine_Segment:
+                case SkIntersectionHelper::kLine_Segment: {
+                    pts = ts.lineHorizontal(wn.pts(), wt.left(),
+                            wt.right(), wt.y(), wt.xFlipped());
+                    debugShowLineIntersection(pts, wn, wt, ts);
+                    break;
+                }
+                case SkIntersectionHelper::kQuad_Segment: {
+                    pts = ts.quadHorizontal(wn.pts(), wt.left(),
+                            wt.right(), wt.y(), wt.xFlipped());
+                    debugShowQuadLineIntersection(pts, wn, wt, ts);
+                    break;
+                }
+                case SkIntersectionHelper::kCubic_Segment: {
+                    pts = ts.cubicHorizontal(wn.pts(), wt.left(),
+                            wt.right(), wt.y(), wt.xFlipped());
+                    debugShowCubicLineIntersection(pts, wn, wt, ts);
+                    break;
+                }
+                default:
+                    SkASSERT(0);
             }
-            int pts = 0;
-            SkIntersections ts;
-            bool swap = false;
-            switch (wt.segmentType()) {
+            break;
+        case SkIntersectionHelper::kVerticalLine_Segment:
+            swap = true;
+            switch (wn.segmentType()) {
                 case SkIntersectionHelper::kHorizontalLine_Segment:
+                case SkIntersectionHelper::kVerticalLine_Segment:
+                case SkIntersectionHelper::kLine_Segment: {
+                    pts = ts.lineVertical(wn.pts(), wt.top(),
+                            wt.bottom(), wt.x(), wt.yFlipped());
+                    debugShowLineIntersection(pts, wn, wt, ts);
+                    break;
+                }
+                case SkIntersectionHelper::kQuad_Segment: {
+                    pts = ts.quadVertical(wn.pts(), wt.top(),
+                            wt.bottom(), wt.x(), wt.yFlipped());
+                    debugShowQuadLineIntersection(pts, wn, wt, ts);
+                    break;
+                }
+                case SkIntersectionHelper::kCubic_Segment: {
+                    pts = ts.cubicVertical(wn.pts(), wt.top(),
+                            wt.bottom(), wt.x(), wt.yFlipped());
+                    debugShowCubicLineIntersection(pts, wn, wt, ts);
+                    break;
+                }
+                default:
+                    SkASSERT(0);
+            }
+            break;
+        case SkIntersectionHelper::kLine_Segment:
+            switch (wn.segmentType()) {
+                case SkIntersectionHelper::kHorizontalLine_Segment:
+                    pts = ts.lineHorizontal(wt.pts(), wn.left(),
+                            wn.right(), wn.y(), wn.xFlipped());
+                    debugShowLineIntersection(pts, wt, wn, ts);
+                    break;
+                case SkIntersectionHelper::kVerticalLine_Segment:
+                    pts = ts.lineVertical(wt.pts(), wn.top(),
+                            wn.bottom(), wn.x(), wn.yFlipped());
+                    debugShowLineIntersection(pts, wt, wn, ts);
+                    break;
+                case SkIntersectionHelper::kLine_Segment: {
+                    pts = ts.lineLine(wt.pts(), wn.pts());
+                    debugShowLineIntersection(pts, wt, wn, ts);
+                    break;
+                }
+                case SkIntersectionHelper::kQuad_Segment: {
                     swap = true;
-                    switch (wn.segmentType()) {
-                        case SkIntersectionHelper::kHorizontalLine_Segment:
-                        case SkIntersectionHelper::kVerticalLine_Segment:
-                        case SkIntersectionHelper::kLine_Segment: {
-                            pts = ts.lineHorizontal(wn.pts(), wt.left(),
-                                    wt.right(), wt.y(), wt.xFlipped());
-                            debugShowLineIntersection(pts, wn, wt, ts);
-                            break;
-                        }
-                        case SkIntersectionHelper::kQuad_Segment: {
-                            pts = ts.quadHorizontal(wn.pts(), wt.left(),
-                                    wt.right(), wt.y(), wt.xFlipped());
-                            debugShowQuadLineIntersection(pts, wn, wt, ts);
-                            break;
-                        }
-                        case SkIntersectionHelper::kCubic_Segment: {
-                            pts = ts.cubicHorizontal(wn.pts(), wt.left(),
-                                    wt.right(), wt.y(), wt.xFlipped());
-                            debugShowCubicLineIntersection(pts, wn, wt, ts);
-                            break;
-                        }
-                        default:
-                            SkASSERT(0);
-                    }
+                    pts = ts.quadLine(wn.pts(), wt.pts());
+                    debugShowQuadLineIntersection(pts, wn, wt, ts);
+                    break;
+                }
+                case SkIntersectionHelper::kCubic_Segment: {
+                    swap = true;
+                    pts = ts.cubicLine(wn.pts(), wt.pts());
+                    debugShowCubicLineIntersection(pts, wn, wt,  ts);
+                    break;
+                }
+                default:
+                    SkASSERT(0);
+            }
+            break;
+        case SkIntersectionHelper::kQuad_Segment:
+            switch (wn.segmentType()) {
+                case SkIntersectionHelper::kHorizontalLine_Segment:
+                    pts = ts.quadHorizontal(wt.pts(), wn.left(),
+                            wn.right(), wn.y(), wn.xFlipped());
+                    debugShowQuadLineIntersection(pts, wt, wn, ts);
                     break;
                 case SkIntersectionHelper::kVerticalLine_Segment:
+                    pts = ts.quadVertical(wt.pts(), wn.top(),
+                            wn.bottom(), wn.x(), wn.yFlipped());
+                    debugShowQuadLineIntersection(pts, wt, wn, ts);
+                    break;
+                case SkIntersectionHelper::kLine_Segment: {
+                    pts = ts.quadLine(wt.pts(), wn.pts());
+                    debugShowQuadLineIntersection(pts, wt, wn, ts);
+                    break;
+                }
+                case SkIntersectionHelper::kQuad_Segment: {
+                    pts = ts.quadQuad(wt.pts(), wn.pts());
+                    debugShowQuadIntersection(pts, wt, wn, ts);
+                    break;
+                }
+                case SkIntersectionHelper::kCubic_Segment: {
                     swap = true;
-                    switch (wn.segmentType()) {
-                        case SkIntersectionHelper::kHorizontalLine_Segment:
-                        case SkIntersectionHelper::kVerticalLine_Segment:
-                        case SkIntersectionHelper::kLine_Segment: {
-                            pts = ts.lineVertical(wn.pts(), wt.top(),
-                                    wt.bottom(), wt.x(), wt.yFlipped());
-                            debugShowLineIntersection(pts, wn, wt, ts);
-                            break;
-                        }
-                        case SkIntersectionHelper::kQuad_Segment: {
-                            pts = ts.quadVertical(wn.pts(), wt.top(),
-                                    wt.bottom(), wt.x(), wt.yFlipped());
-                            debugShowQuadLineIntersection(pts, wn, wt, ts);
-                            break;
-                        }
-                        case SkIntersectionHelper::kCubic_Segment: {
-                            pts = ts.cubicVertical(wn.pts(), wt.top(),
-                                    wt.bottom(), wt.x(), wt.yFlipped());
-                            debugShowCubicLineIntersection(pts, wn, wt, ts);
-                            break;
-                        }
-                        default:
-                            SkASSERT(0);
-                    }
+                    pts = ts.cubicQuad(wn.pts(), wt.pts());
+                    debugShowCubicQuadIntersection(pts, wn, wt, ts);
+                    break;
+                }
+                default:
+                    SkASSERT(0);
+            }
+            break;
+        case SkIntersectionHelper::kCubic_Segment:
+            switch (wn.segmentType()) {
+                case SkIntersectionHelper::kHorizontalLine_Segment:
+                    pts = ts.cubicHorizontal(wt.pts(), wn.left(),
+                            wn.right(), wn.y(), wn.xFlipped());
+                    debugShowCubicLineIntersection(pts, wt, wn, ts);
+                    break;
+                case SkIntersectionHelper::kVerticalLine_Segment:
+                    pts = ts.cubicVertical(wt.pts(), wn.top(),
+                            wn.bottom(), wn.x(), wn.yFlipped());
+                    debugShowCubicLineIntersection(pts, wt, wn, ts);
                     break;
-                case SkIntersectionHelper::kLine_Segment:
-                    switch (wn.segmentType()) {
-                        case SkIntersectionHelper::kHorizontalLine_Segment:
-                            pts = ts.lineHorizontal(wt.pts(), wn.left(),
-                                    wn.right(), wn.y(), wn.xFlipped());
-                            debugShowLineIntersection(pts, wt, wn, ts);
-                            break;
-                        case SkIntersectionHelper::kVerticalLine_Segment:
-                            pts = ts.lineVertical(wt.pts(), wn.top(),
-                                    wn.bottom(), wn.x(), wn.yFlipped());
-                            debugShowLineIntersection(pts, wt, wn, ts);
-                            break;
-                        case SkIntersectionHelper::kLine_Segment: {
-                            pts = ts.lineLine(wt.pts(), wn.pts());
-                            debugShowLineIntersection(pts, wt, wn, ts);
-                            break;
-                        }
-                        case SkIntersectionHelper::kQuad_Segment: {
-                            swap = true;
-                            pts = ts.quadLine(wn.pts(), wt.pts());
-                            debugShowQuadLineIntersection(pts, wn, wt, ts);
-                            break;
-                        }
-                        case SkIntersectionHelper::kCubic_Segment: {
-                            swap = true;
-                            pts = ts.cubicLine(wn.pts(), wt.pts());
-                            debugShowCubicLineIntersection(pts, wn, wt,  ts);
-                            break;
-                        }
-                        default:
-                            SkASSERT(0);
-                    }
+                case SkIntersectionHelper::kLine_Segment: {
+                    pts = ts.cubicLine(wt.pts(), wn.pts());
+                    debugShowCubicLineIntersection(pts, wt, wn, ts);
                     break;
-                case SkIntersectionHelper::kQuad_Segment:
-                    switch (wn.segmentType()) {
-                        case SkIntersectionHelper::kHorizontalLine_Segment:
-                            pts = ts.quadHorizontal(wt.pts(), wn.left(),
-                                    wn.right(), wn.y(), wn.xFlipped());
-                            debugShowQuadLineIntersection(pts, wt, wn, ts);
-                            break;
-                        case SkIntersectionHelper::kVerticalLine_Segment:
-                            pts = ts.quadVertical(wt.pts(), wn.top(),
-                                    wn.bottom(), wn.x(), wn.yFlipped());
-                            debugShowQuadLineIntersection(pts, wt, wn, ts);
-                            break;
-                        case SkIntersectionHelper::kLine_Segment: {
-                            pts = ts.quadLine(wt.pts(), wn.pts());
-                            debugShowQuadLineIntersection(pts, wt, wn, ts);
-                            break;
-                        }
-                        case SkIntersectionHelper::kQuad_Segment: {
-                            pts = ts.quadQuad(wt.pts(), wn.pts());
-                            debugShowQuadIntersection(pts, wt, wn, ts);
-                            break;
-                        }
-                        case SkIntersectionHelper::kCubic_Segment: {
-                            swap = true;
-                            pts = ts.cubicQuad(wn.pts(), wt.pts());
-                            debugShowCubicQuadIntersection(pts, wn, wt, ts);
-                            break;
-                        }
-                        default:
-                            SkASSERT(0);
-                    }
+                }
+                case SkIntersectionHelper::kQuad_Segment: {
+                    pts = ts.cubicQuad(wt.pts(), wn.pts());
+                    debugShowCubicQuadIntersection(pts, wt, wn, ts);
                     break;
-                case SkIntersectionHelper::kCubic_Segment:
-                    switch (wn.segmentType()) {
-                        case SkIntersectionHelper::kHorizontalLine_Segment:
-                            pts = ts.cubicHorizontal(wt.pts(), wn.left(),
-                                    wn.right(), wn.y(), wn.xFlipped());
-                            debugShowCubicLineIntersection(pts, wt, wn, ts);
-                            break;
-                        case SkIntersectionHelper::kVerticalLine_Segment:
-                            pts = ts.cubicVertical(wt.pts(), wn.top(),
-                                    wn.bottom(), wn.x(), wn.yFlipped());
-                            debugShowCubicLineIntersection(pts, wt, wn, ts);
-                            break;
-                        case SkIntersectionHelper::kLine_Segment: {
-                            pts = ts.cubicLine(wt.pts(), wn.pts());
-                            debugShowCubicLineIntersection(pts, wt, wn, ts);
-                            break;
-                        }
-                        case SkIntersectionHelper::kQuad_Segment: {
-                            pts = ts.cubicQuad(wt.pts(), wn.pts());
-                            debugShowCubicQuadIntersection(pts, wt, wn, ts);
-                            break;
-                        }
-                        case SkIntersectionHelper::kCubic_Segment: {
-                            pts = ts.cubicCubic(wt.pts(), wn.pts());
-                            debugShowCubicIntersection(pts, wt, wn, ts);
-                            break;
-                        }
-                        default:
-                            SkASSERT(0);
-                    }
+                }
+                case SkIntersectionHelper::kCubic_Segment: {
+                    pts = ts.cubicCubic(wt.pts(), wn.pts());
+                    debugShowCubicIntersection(pts, wt, wn, ts);
                     break;
+                }
                 default:
                     SkASSERT(0);
             }
-            if (!foundCommonContour && pts > 0) {
-                test->addCross(next);
-                next->addCross(test);
-                foundCommonContour = true;
+            break;
+        default:
+            SkASSERT(0);
+    }
+    if (!*foundCommonContour && pts > 0) {
+        test->addCross(next);
+        next->addCross(test);
+        *foundCommonContour = true;
+    }
+    // in addition to recording T values, record matching segment
+    if (pts == 2) {
+        if (wn.segmentType() <= SkIntersectionHelper::kLine_Segment
+                && wt.segmentType() <= SkIntersectionHelper::kLine_Segment) {
+            if (wt.addCoincident(wn, ts, swap)) {
+                return;
+            }
+            ts.cleanUpCoincidence();  // prefer (t == 0 or t == 1)
+            pts = 1;
+        } else if (wn.segmentType() >= SkIntersectionHelper::kQuad_Segment
+                && wt.segmentType() >= SkIntersectionHelper::kQuad_Segment
+                && ts.isCoincident(0)) {
+            SkASSERT(ts.coincidentUsed() == 2);
+            if (wt.addCoincident(wn, ts, swap)) {
+                return;
             }
-            // in addition to recording T values, record matching segment
-            if (pts == 2) {
-                if (wn.segmentType() <= SkIntersectionHelper::kLine_Segment
-                        && wt.segmentType() <= SkIntersectionHelper::kLine_Segment) {
-                    if (wt.addCoincident(wn, ts, swap)) {
-                        continue;
-                    }
-                    ts.cleanUpCoincidence();  // prefer (t == 0 or t == 1)
-                    pts = 1;
-                } else if (wn.segmentType() >= SkIntersectionHelper::kQuad_Segment
-                        && wt.segmentType() >= SkIntersectionHelper::kQuad_Segment
-                        && ts.isCoincident(0)) {
-                    SkASSERT(ts.coincidentUsed() == 2);
-                    if (wt.addCoincident(wn, ts, swap)) {
-                        continue;
-                    }
+            ts.cleanUpCoincidence();  // prefer (t == 0 or t == 1)
+            pts = 1;
+        }
+    }
+    if (pts >= 2) {
+        for (int pt = 0; pt < pts - 1; ++pt) {
+            const SkDPoint& point = ts.pt(pt);
+            const SkDPoint& next = ts.pt(pt + 1);
+            if (wt.isPartial(ts[swap][pt], ts[swap][pt + 1], point, next)
+                    && wn.isPartial(ts[!swap][pt], ts[!swap][pt + 1], point, next)) {
+                if (!wt.addPartialCoincident(wn, ts, pt, swap)) {
+                    // remove extra point if two map to same float values
                     ts.cleanUpCoincidence();  // prefer (t == 0 or t == 1)
                     pts = 1;
                 }
             }
-            if (pts >= 2) {
-                for (int pt = 0; pt < pts - 1; ++pt) {
-                    const SkDPoint& point = ts.pt(pt);
-                    const SkDPoint& next = ts.pt(pt + 1);
-                    if (wt.isPartial(ts[swap][pt], ts[swap][pt + 1], point, next)
-                            && wn.isPartial(ts[!swap][pt], ts[!swap][pt + 1], point, next)) {
-                        if (!wt.addPartialCoincident(wn, ts, pt, swap)) {
-                            // remove extra point if two map to same float values
-                            ts.cleanUpCoincidence();  // prefer (t == 0 or t == 1)
-                            pts = 1;
-                        }
-                    }
-                }
+        }
+    }
+    for (int pt = 0; pt < pts; ++pt) {
+        SkASSERT(ts[0][pt] >= 0 && ts[0][pt] <= 1);
+        SkASSERT(ts[1][pt] >= 0 && ts[1][pt] <= 1);
+        SkPoint point = ts.pt(pt).asSkPoint();
+        int testTAt = wt.addT(wn, point, ts[swap][pt]);
+        int nextTAt = wn.addT(wt, point, ts[!swap][pt]);
+        wt.addOtherT(testTAt, ts[!swap][pt], nextTAt);
+        wn.addOtherT(nextTAt, ts[swap][pt], testTAt);
+    }
+}
+
+// Past this many segment pairs, find the ones whose bounds intersect by sweeping down the
+// contours' segments, rather than by testing them all.
+static const int kSweepSegmentPairs = 256;
+
+namespace {
+
+struct SweepSegment {
+    SkScalar fTop;
+    int fIndex;
+    bool fInNext;
+
+    bool operator<(const SweepSegment& rh) const {
+        return fTop < rh.fTop;
+    }
+};
+
+}  // namespace
+
+// Appends the segment pairs of test and next whose bounds intersect, each as
+// (test index << 32 | next index), sorted so they come in the same order as a nested loop.
+// When test is next, only pairs with the first index less than the second are found.
+static void find_intersecting_pairs(SkOpContour* test, SkOpContour* next,
+        SkTDArray<int64_t>* pairs) {
+    const SkTArray<SkOpSegment>& testSegments = test->segments();
+    const SkTArray<SkOpSegment>& nextSegments = next->segments();
+    bool self = test == next;
+    SkTDArray<SweepSegment> sweep;
+    for (int index = 0; index < testSegments.count(); ++index) {
+        SweepSegment* segment = sweep.append();
+        segment->fTop = testSegments[index].bounds().fTop;
+        segment->fIndex = index;
+        segment->fInNext = false;
+    }
+    for (int index = 0; !self && index < nextSegments.count(); ++index) {
+        SweepSegment* segment = sweep.append();
+        segment->fTop = nextSegments[index].bounds().fTop;
+        segment->fIndex = index;
+        segment->fInNext = true;
+    }
+    SkTQSort<SweepSegment>(sweep.begin(), sweep.end() - 1);
+
+    // The segments of each contour the sweep has reached but not yet passed the bottom of.
+    SkTDArray<int> active[2];
+    for (int s = 0; s < sweep.count(); ++s) {
+        const SweepSegment& segment = sweep[s];
+        const SkTArray<SkOpSegment>& segments = segment.fInNext ? nextSegments : testSegments;
+        const SkPathOpsBounds& bounds = segments[segment.fIndex].bounds();
+        bool otherInNext = !self && !segment.fInNext;
+        const SkTArray<SkOpSegment>& others = otherInNext ? nextSegments : testSegments;
+        SkTDArray<int>& otherActive = active[otherInNext];
+        for (int a = 0; a < otherActive.count(); ) {
+            int otherIndex = otherActive[a];
+            const SkPathOpsBounds& otherBounds = others[otherIndex].bounds();
+            // Segments still to come are no higher than this one, so can't reach this either.
+            if (!AlmostLessOrEqualUlps(bounds.fTop, otherBounds.fBottom)) {
+                otherActive.removeShuffle(a);
+                continue;
             }
-            for (int pt = 0; pt < pts; ++pt) {
-                SkASSERT(ts[0][pt] >= 0 && ts[0][pt] <= 1);
-                SkASSERT(ts[1][pt] >= 0 && ts[1][pt] <= 1);
-                SkPoint point = ts.pt(pt).asSkPoint();
-                int testTAt = wt.addT(wn, point, ts[swap][pt]);
-                int nextTAt = wn.addT(wt, point, ts[!swap][pt]);
-                wt.addOtherT(testTAt, ts[!swap][pt], nextTAt);
-                wn.addOtherT(nextTAt, ts[swap][pt], testTAt);
+            if (SkPathOpsBounds::Intersects(bounds, otherBounds)) {
+                int testIndex = segment.fInNext ? otherIndex : segment.fIndex;
+                int nextIndex = segment.fInNext ? segment.fIndex : otherIndex;
+                if (self && testIndex > nextIndex) {
+                    SkTSwap(testIndex, nextIndex);
+                }
+                *pairs->append() = ((int64_t) testIndex << 32) | nextIndex;
             }
+            ++a;
+        }
+        *active[!self && segment.fInNext].append() = segment.fIndex;
+    }
+    if (pairs->count() > 1) {
+        SkTQSort<int64_t>(pairs->begin(), pairs->end() - 1);
+    }
+}
+
+bool AddIntersectTs(SkOpContour* test, SkOpContour* next) {
+    if (test != next) {
+        if (AlmostLessUlps(test->bounds().fBottom, next->bounds().fTop)) {
+            return false;
+        }
+        // OPTIMIZATION: outset contour bounds a smidgen instead?
+        if (!SkPathOpsBounds::Intersects(test->bounds(), next->bounds())) {
+            return true;
+        }
+    }
+    SkIntersectionHelper wt;
+    wt.init(test);
+    SkIntersectionHelper wn;
+    wn.init(next);
+    bool foundCommonContour = test == next;
+    if (test->segments().count() * next->segments().count() > kSweepSegmentPairs
+            && test->bounds().isFinite() && next->bounds().isFinite()) {
+        SkTDArray<int64_t> pairs;
+        find_intersecting_pairs(test, next, &pairs);
+        for (int index = 0; index < pairs.count(); ++index) {
+            wt.setIndex((int) (pairs[index] >> 32));
+            wn.setIndex((int) (pairs[index] & 0xFFFFFFFF));
+            add_intersect_ts(test, wt, next, wn, &foundCommonContour);
+        }
+        return true;
+    }
+    do {
+        wn.init(next);
+        if (test == next && !wn.startAfter(wt)) {
+            continue;
+        }
+        do {
+            add_intersect_ts(test, wt, next, wn, &foundCommonContour);
         } while (wn.advance());
     } while (wt.advance());
     return true;
@@ -112,6 +112,11 @@ public:
         return kLine_Segment;
     }
 
+    void setIndex(int index) {
+        SkASSERT(index >= 0 && index < fLast);
+        fIndex = index;
+    }
+
     bool startAfter(const SkIntersectionHelper& after) {
         fIndex = after.fIndex;
         return advance();
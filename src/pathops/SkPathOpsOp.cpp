@@ -8,6 +8,9 @@
 #include "SkOpEdgeBuilder.h"
 #include "SkPathOpsCommon.h"
 #include "SkPathWriter.h"
+#include "SkRunnable.h"
+#include "SkTaskGroup.h"
+#include "SkTemplates.h"
 
 static SkOpSegment* findChaseOp(SkTDArray<SkOpSpan*>& chase, int* tIndex, int* endIndex) {
     while (chase.count()) {
@@ -307,3 +310,62 @@ bool Op(const SkPath& one, const SkPath& two, SkPathOp op, SkPath* result) {
     }
     return true;
 }
+
+namespace {
+
+// Unions two paths of a Union() round, replacing the first with the result.
+class UnionPair : public SkRunnable {
+public:
+    void set(SkPath* one, const SkPath* two) {
+        fOne = one;
+        fTwo = two;
+        fSucceeded = false;
+    }
+
+    bool succeeded() const { return fSucceeded; }
+
+    virtual void run() SK_OVERRIDE {
+        fSucceeded = Op(*fOne, *fTwo, kUnion_PathOp, fOne);
+    }
+
+private:
+    SkPath*       fOne;
+    const SkPath* fTwo;
+    bool          fSucceeded;
+};
+
+}  // namespace
+
+bool Union(const SkPath paths[], int count, SkPath* result, SkTaskScheduler* scheduler) {
+    if (count <= 0) {
+        result->reset();
+        return true;
+    }
+    if (1 == count) {
+        return Simplify(paths[0], result);
+    }
+    SkTArray<SkPath> work(paths, count);
+    SkAutoTArray<UnionPair> pairs(count / 2);
+    SkTaskGroup group(scheduler);
+    while (count > 1) {
+        int pairCount = count / 2;
+        for (int index = 0; index < pairCount; ++index) {
+            pairs[index].set(&work[index * 2], &work[index * 2 + 1]);
+            group.add(&pairs[index]);
+        }
+        group.wait();
+        // Pack the results, and any odd path out, at the front for the next round.
+        for (int index = 0; index < pairCount; ++index) {
+            if (!pairs[index].succeeded()) {
+                return false;
+            }
+            work[index].swap(work[index * 2]);
+        }
+        if (count & 1) {
+            work[pairCount].swap(work[count - 1]);
+        }
+        count -= pairCount;
+    }
+    result->swap(work[0]);
+    return true;
+}
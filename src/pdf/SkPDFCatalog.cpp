@@ -8,6 +8,7 @@
 
 
 #include "SkPDFCatalog.h"
+#include "SkPDFImage.h"
 #include "SkPDFTypes.h"
 #include "SkStream.h"
 #include "SkTypes.h"
@@ -28,7 +29,11 @@ SkPDFObject* SkPDFCatalog::addObject(SkPDFObject* obj, bool onFirstPage) {
     if (findObjectIndex(obj) != -1) {  // object already added
         return obj;
     }
-    SkASSERT(fNextFirstPageObjNum == 0);
+    if (fNextFirstPageObjNum != 0) {
+        // Numbering has started, so new objects can only go after it.
+        SkASSERT(fFirstPageCount == 0);
+        onFirstPage = false;
+    }
     if (onFirstPage) {
         fFirstPageCount++;
     }
@@ -39,12 +44,15 @@ SkPDFObject* SkPDFCatalog::addObject(SkPDFObject* obj, bool onFirstPage) {
 }
 
 size_t SkPDFCatalog::setFileOffset(SkPDFObject* obj, off_t offset) {
+    this->recordFileOffset(obj, offset);
+    return getSubstituteObject(obj)->getOutputSize(this, true);
+}
+
+void SkPDFCatalog::recordFileOffset(SkPDFObject* obj, off_t offset) {
     int objIndex = assignObjNum(obj) - 1;
     SkASSERT(fCatalog[objIndex].fObjNumAssigned);
     SkASSERT(fCatalog[objIndex].fFileOffset == 0);
     fCatalog[objIndex].fFileOffset = offset;
-
-    return getSubstituteObject(obj)->getOutputSize(this, true);
 }
 
 void SkPDFCatalog::emitObjectNumber(SkWStream* stream, SkPDFObject* obj) {
@@ -70,6 +78,12 @@ int SkPDFCatalog::findObjectIndex(SkPDFObject* obj) const {
             return findObjectIndex(fSubstituteMap[i].fOriginal);
         }
     }
+    // Or an image that shares another's object.
+    for (int i = 0; i < fImageAliases.count(); ++i) {
+        if (fImageAliases[i].fOriginal == obj) {
+            return findObjectIndex(fImageAliases[i].fSubstitute);
+        }
+    }
     return -1;
 }
 
@@ -213,3 +227,18 @@ SkTSet<SkPDFObject*>* SkPDFCatalog::getSubstituteList(bool firstPage) {
     return firstPage ? &fSubstituteResourcesFirstPage :
                        &fSubstituteResourcesRemaining;
 }
+
+SkPDFImage* SkPDFCatalog::canonicalizeImage(SkPDFImage* image) {
+    for (int i = 0; i < fCanonicalImages.count(); ++i) {
+        if (fCanonicalImages[i] == image) {
+            return NULL;
+        }
+        if (fCanonicalImages[i]->showsSamePixels(*image)) {
+            SubstituteMapping alias(image, fCanonicalImages[i]);
+            fImageAliases.append(1, &alias);
+            return fCanonicalImages[i];
+        }
+    }
+    fCanonicalImages.push(image);
+    return NULL;
+}
@@ -17,6 +17,8 @@
 #include "SkRefCnt.h"
 #include "SkTDArray.h"
 
+class SkPDFImage;
+
 /** \class SkPDFCatalog
 
     The PDF catalog manages object numbers and file offsets.  It is used
@@ -29,7 +31,10 @@ public:
     explicit SkPDFCatalog(SkPDFDocument::Flags flags);
     ~SkPDFCatalog();
 
-    /** Add the passed object to the catalog.  Refs obj.
+    /** Add the passed object to the catalog.  Refs obj.  Objects may still
+     *  be added once numbering has started, as when streaming, but only if
+     *  no objects have been put on the first page; onFirstPage is then
+     *  ignored.
      *  @param obj         The object to add.
      *  @param onFirstPage Is the object on the first page.
      *  @return The obj argument is returned.
@@ -44,6 +49,13 @@ public:
      */
     size_t setFileOffset(SkPDFObject* obj, off_t offset);
 
+    /** Like setFileOffset(), but for an object about to be written, so
+     *  there's no need to work out its size.
+     *  @param obj         The object to add.
+     *  @param offset      The byte offset in the output stream of this object.
+     */
+    void recordFileOffset(SkPDFObject* obj, off_t offset);
+
     /** Output the object number for the passed object.
      *  @param obj         The object of interest.
      *  @param stream      The writable output stream to send the output to.
@@ -88,6 +100,14 @@ public:
      */
     void emitSubstituteResources(SkWStream* stream, bool firstPage);
 
+    /** If an image showing the same pixels as the passed image was
+     *  canonicalized before, return it, and give the passed image its object
+     *  number, so the passed image need not be added or emitted.  Otherwise
+     *  the passed image, which should be added, is the one to use for those
+     *  pixels from now on; return NULL.
+     */
+    SkPDFImage* canonicalizeImage(SkPDFImage* image);
+
 private:
     struct Rec {
         Rec(SkPDFObject* object, bool onFirstPage)
@@ -118,6 +138,11 @@ private:
     SkTSet<SkPDFObject*> fSubstituteResourcesFirstPage;
     SkTSet<SkPDFObject*> fSubstituteResourcesRemaining;
 
+    // This should be made a hash table if performance is a problem.
+    SkTDArray<SkPDFImage*> fCanonicalImages;
+    // The original is an image numbered as the substitute, its canonical image.
+    SkTDArray<SubstituteMapping> fImageAliases;
+
     // Number of objects on the first page.
     uint32_t fFirstPageCount;
     // Next object number to assign (on page > 1).
@@ -793,7 +793,7 @@ void SkPDFDevice::init() {
     }
 }
 
-void SkPDFDevice::cleanUp(bool clearFontUsage) {
+void SkPDFDevice::cleanUp(bool clearUsage) {
     fGraphicStateResources.unrefAll();
     fXObjectResources.unrefAll();
     fFontResources.unrefAll();
@@ -802,8 +802,9 @@ void SkPDFDevice::cleanUp(bool clearFontUsage) {
     SkSafeUnref(fResourceDict);
     fNamedDestinations.deleteAll();
 
-    if (clearFontUsage) {
+    if (clearUsage) {
         fFontGlyphUsage->reset();
+        fImages.unrefAll();
     }
 }
 
@@ -1360,8 +1361,15 @@ void SkPDFDevice::drawDevice(const SkDraw& d, SkBaseDevice* device,
     SkPDFUtils::DrawFormXObject(this->addXObjectResource(xObject.get()),
                                 &content.entry()->fContent);
 
-    // Merge glyph sets from the drawn device.
+    // Merge glyph sets and images from the drawn device.
     fFontGlyphUsage->merge(pdfDevice->getFontGlyphUsage());
+    const SkTDArray<SkPDFImage*>& images = pdfDevice->getImages();
+    for (int i = 0; i < images.count(); i++) {
+        if (fImages.find(images[i]) < 0) {
+            images[i]->ref();
+            fImages.push(images[i]);
+        }
+    }
 }
 
 void SkPDFDevice::onAttachToCanvas(SkCanvas* canvas) {
@@ -1722,8 +1730,8 @@ void SkPDFDevice::appendDestinations(SkPDFDict* dict, SkPDFObject* page) {
 SkPDFFormXObject* SkPDFDevice::createFormXObjectFromDevice() {
     SkPDFFormXObject* xobject = SkNEW_ARGS(SkPDFFormXObject, (this));
     // We always draw the form xobjects that we create back into the device, so
-    // we simply preserve the font usage instead of pulling it out and merging
-    // it back in later.
+    // we simply preserve the font usage and images instead of pulling them out
+    // and merging them back in later.
     cleanUp(false);  // Reset this device to have no content.
     init();
     return xobject;
@@ -2296,7 +2304,7 @@ void SkPDFDevice::internalDrawBitmap(const SkMatrix& origMatrix,
     }
 
     SkAutoTUnref<SkPDFImage> image(
-        SkPDFImage::CreateImage(*bitmap, subset, fEncoder));
+        SkPDFImage::CreateImage(*bitmap, subset, fEncoder, &fImages));
     if (!image) {
         return;
     }
@@ -15,6 +15,7 @@
 #include "SkPDFTypes.h"
 #include "SkStream.h"
 #include "SkTSet.h"
+#include "SkTaskGroup.h"
 
 static void addResourcesToCatalog(bool firstPage,
                                   SkTSet<SkPDFObject*>* resourceSet,
@@ -24,9 +25,12 @@ static void addResourcesToCatalog(bool firstPage,
     }
 }
 
+// If unwrittenFonts is not NULL, only fonts in it are subset; the others have
+// already been written out whole.
 static void perform_font_subsetting(SkPDFCatalog* catalog,
                                     const SkTDArray<SkPDFPage*>& pages,
-                                    SkTDArray<SkPDFObject*>* substitutes) {
+                                    SkTDArray<SkPDFObject*>* substitutes,
+                                    const SkTSet<SkPDFObject*>* unwrittenFonts = NULL) {
     SkASSERT(catalog);
     SkASSERT(substitutes);
 
@@ -37,6 +41,10 @@ static void perform_font_subsetting(SkPDFCatalog* catalog,
     SkPDFGlyphSetMap::F2BIter iterator(usage);
     const SkPDFGlyphSetMap::FontGlyphSetPair* entry = iterator.next();
     while (entry) {
+        if (unwrittenFonts && !unwrittenFonts->contains(entry->fFont)) {
+            entry = iterator.next();
+            continue;
+        }
         SkPDFFont* subsetFont =
             entry->fFont->getFontSubset(entry->fGlyphSet);
         if (subsetFont) {
@@ -47,9 +55,33 @@ static void perform_font_subsetting(SkPDFCatalog* catalog,
     }
 }
 
+namespace {
+
+class CompressPageContent : public SkRunnable {
+public:
+    CompressPageContent(SkPDFPage* page, SkPDFCatalog* catalog)
+        : fPage(page), fCatalog(catalog) {}
+
+    virtual void run() SK_OVERRIDE {
+        fPage->compressContent(fCatalog);
+        SkDELETE(this);
+    }
+
+private:
+    SkPDFPage* fPage;
+    SkPDFCatalog* fCatalog;
+};
+
+}  // namespace
+
 SkPDFDocument::SkPDFDocument(Flags flags)
         : fXRefFileOffset(0),
-          fTrailerDict(NULL) {
+          fTrailerDict(NULL),
+          fStream(NULL),
+          fStreamStart(0),
+          fDests(NULL),
+          fUnwrittenFonts(NULL),
+          fMaxUnwrittenPages(0) {
     fCatalog.reset(new SkPDFCatalog(flags));
     fDocCatalog = SkNEW_ARGS(SkPDFDict, ("Catalog"));
     fCatalog->addObject(fDocCatalog, true);
@@ -57,7 +89,30 @@ SkPDFDocument::SkPDFDocument(Flags flags)
     fOtherPageResources = NULL;
 }
 
+SkPDFDocument::SkPDFDocument(SkWStream* stream, Flags flags,
+                             SkTaskScheduler* scheduler)
+        : fXRefFileOffset(0),
+          fTrailerDict(NULL),
+          fStream(stream),
+          fStreamStart(0),
+          fDests(SkNEW(SkPDFDict)),
+          fUnwrittenFonts(SkNEW(SkTSet<SkPDFObject*>)),
+          fCompressions(SkNEW_ARGS(SkTaskGroup, (scheduler))),
+          fMaxUnwrittenPages(scheduler ? scheduler->threadCount() : 0) {
+    SkASSERT(stream);
+    fCatalog.reset(new SkPDFCatalog(flags));
+    fDocCatalog = SkNEW_ARGS(SkPDFDict, ("Catalog"));
+    // Objects are numbered as they're written, so nothing goes on the first
+    // page; numbering the first page's objects last only suits emitPDF().
+    fCatalog->addObject(fDocCatalog, false);
+    fFirstPageResources = NULL;
+    fOtherPageResources = SkNEW(SkTSet<SkPDFObject*>);
+}
+
 SkPDFDocument::~SkPDFDocument() {
+    if (fCompressions.get()) {
+        fCompressions->wait();
+    }
     fPages.safeUnrefAll();
 
     // The page tree has both child and parent pointers, so it creates a
@@ -78,14 +133,22 @@ SkPDFDocument::~SkPDFDocument() {
 
     fDocCatalog->unref();
     SkSafeUnref(fTrailerDict);
+    SkSafeUnref(fDests);
     SkDELETE(fFirstPageResources);
     SkDELETE(fOtherPageResources);
+    SkDELETE(fUnwrittenFonts);
 }
 
 bool SkPDFDocument::emitPDF(SkWStream* stream) {
     if (fPages.isEmpty()) {
         return false;
     }
+    if (fStream) {
+        if (stream != fStream || !fPageTree.isEmpty()) {
+            return false;
+        }
+        return this->emitStreamedPDF();
+    }
     for (int i = 0; i < fPages.count(); i++) {
         if (fPages[i] == NULL) {
             return false;
@@ -226,8 +289,67 @@ bool SkPDFDocument::emitPDF(SkWStream* stream) {
     return true;
 }
 
+bool SkPDFDocument::emitStreamedPDF() {
+    this->writePages();
+
+    SkPDFDict* pageTreeRoot;
+    SkPDFPage::GeneratePageTree(fPages, fCatalog.get(), &fPageTree,
+                                &pageTreeRoot);
+    fDocCatalog->insert("Pages", new SkPDFObjRef(pageTreeRoot))->unref();
+    if (fDests->size() > 0) {
+        fCatalog->addObject(fDests, false);
+        fDocCatalog->insert("Dests", SkNEW_ARGS(SkPDFObjRef, (fDests)))->unref();
+    }
+
+    // Now that all the glyphs are known, the fonts can be subset and written.
+    perform_font_subsetting(fCatalog.get(), fPages, &fSubstitutes,
+                            fUnwrittenFonts);
+    for (int i = 0; i < fUnwrittenFonts->count(); i++) {
+        this->writeObject((*fUnwrittenFonts)[i]);
+    }
+    fCatalog->setSubstituteResourcesOffsets(this->streamOffset(), false);
+    fCatalog->emitSubstituteResources(fStream, false);
+
+    this->writeObject(fPages[0]);
+    for (int i = 0; i < fPageTree.count(); i++) {
+        this->writeObject(fPageTree[i]);
+    }
+    if (fDests->size() > 0) {
+        this->writeObject(fDests);
+    }
+    this->writeObject(fDocCatalog);
+
+    fXRefFileOffset = this->streamOffset();
+    int64_t objCount = fCatalog->emitXrefTable(fStream, false);
+    emitFooter(fStream, objCount);
+    return true;
+}
+
+size_t SkPDFDocument::streamOffset() const {
+    SkASSERT(fStream);
+    return fStream->bytesWritten() - fStreamStart;
+}
+
+void SkPDFDocument::writeObject(SkPDFObject* obj) {
+    fCatalog->recordFileOffset(obj, this->streamOffset());
+    obj->emit(fStream, fCatalog.get(), true);
+}
+
+void SkPDFDocument::writePages() {
+    fCompressions->wait();
+    for (int i = 0; i < fUnwrittenPages.count(); i++) {
+        fUnwrittenPages[i]->getPageSize(fCatalog.get(), this->streamOffset());
+        fUnwrittenPages[i]->emitPage(fStream, fCatalog.get());
+    }
+    for (int i = 0; i < fUnwrittenResources.count(); i++) {
+        this->writeObject(fUnwrittenResources[i]);
+    }
+    fUnwrittenPages.rewind();
+    fUnwrittenResources.rewind();
+}
+
 bool SkPDFDocument::setPage(int pageNumber, SkPDFDevice* pdfDevice) {
-    if (!fPageTree.isEmpty()) {
+    if (!fPageTree.isEmpty() || fStream) {
         return false;
     }
 
@@ -255,6 +377,54 @@ bool SkPDFDocument::appendPage(SkPDFDevice* pdfDevice) {
 
     SkPDFPage* page = new SkPDFPage(pdfDevice);
     fPages.push(page);  // Reference from new passed to fPages.
+    if (NULL == fStream) {
+        return true;
+    }
+
+    if (1 == fPages.count()) {
+        fStreamStart = fStream->bytesWritten();
+        emitHeader(fStream);
+    }
+
+    // As in emitPDF(), but everything is on the "other" pages, and the page
+    // is done with its device as soon as its resources are known.
+    SkTSet<SkPDFObject*> newResources;
+    page->finalizePage(fCatalog.get(), false, *fOtherPageResources,
+                       &newResources);
+    addResourcesToCatalog(false, &newResources, fCatalog.get());
+    page->appendDestinations(fDests);
+    page->releaseDevice();
+
+    // Fonts are subset by their glyph usage over the whole document, so they
+    // can't be written until the end.  Everything else can go right away.
+    SkTSet<SkPDFObject*> pageFonts;
+    const SkTDArray<SkPDFFont*>& fontResources = page->getFontResources();
+    for (int i = 0; i < fontResources.count(); i++) {
+        pageFonts.add(fontResources[i]);
+    }
+    SkPDFGlyphSetMap::F2BIter iterator(page->getFontGlyphUsage());
+    for (const SkPDFGlyphSetMap::FontGlyphSetPair* entry = iterator.next();
+         entry != NULL; entry = iterator.next()) {
+        pageFonts.add(entry->fFont);
+    }
+    for (int i = 0; i < newResources.count(); i++) {
+        if (pageFonts.contains(newResources[i])) {
+            fUnwrittenFonts->add(newResources[i]);
+        } else {
+            fUnwrittenResources.push(newResources[i]);
+        }
+    }
+    // The references in newResources are transfered to fOtherPageResources.
+    SkDEBUGCODE(int duplicates =) fOtherPageResources->mergeInto(newResources);
+    SkASSERT(duplicates == 0);
+
+    // Compress the content while the caller draws the next pages, only
+    // waiting once there are more pages than threads to compress them.
+    fUnwrittenPages.push(page);
+    fCompressions->add(SkNEW_ARGS(CompressPageContent, (page, fCatalog.get())));
+    if (fUnwrittenPages.count() > fMaxUnwrittenPages) {
+        this->writePages();
+    }
     return true;
 }
 
@@ -436,14 +436,53 @@ static SkBitmap unpremultiply_bitmap(const SkBitmap& bitmap,
     return outBitmap;
 }
 
+SkPDFImage::Source::Source()
+    : fGenerationID(0),
+      fSubset(SkIRect::MakeEmpty()),
+      fColorType(kUnknown_SkColorType),
+      fAlphaType(kIgnore_SkAlphaType),
+      fEncoder(NULL) {
+}
+
+SkPDFImage::Source::Source(const SkBitmap& bitmap, const SkIRect& srcRect,
+                           SkPicture::EncodeBitmap encoder)
+    // Without a pixel ref there's no generation ID to match the pixels by.
+    : fGenerationID(bitmap.pixelRef() ? bitmap.getGenerationID() : 0),
+      fSubset(srcRect.makeOffset(bitmap.pixelRefOrigin().x(),
+                                 bitmap.pixelRefOrigin().y())),
+      fColorType(bitmap.colorType()),
+      fAlphaType(bitmap.alphaType()),
+      fEncoder(encoder) {
+}
+
+bool SkPDFImage::Source::operator==(const Source& b) const {
+    return fGenerationID != 0 &&
+           fGenerationID == b.fGenerationID &&
+           fSubset == b.fSubset &&
+           fColorType == b.fColorType &&
+           fAlphaType == b.fAlphaType &&
+           fEncoder == b.fEncoder;
+}
+
 // static
 SkPDFImage* SkPDFImage::CreateImage(const SkBitmap& bitmap,
                                     const SkIRect& srcRect,
-                                    SkPicture::EncodeBitmap encoder) {
+                                    SkPicture::EncodeBitmap encoder,
+                                    SkTDArray<SkPDFImage*>* images) {
     if (bitmap.colorType() == kUnknown_SkColorType) {
         return NULL;
     }
 
+    Source source(bitmap, srcRect, encoder);
+    if (images) {
+        for (int i = 0; i < images->count(); i++) {
+            if ((*images)[i]->fSource == source) {
+                (*images)[i]->ref();
+                return (*images)[i];
+            }
+        }
+    }
+
     bool isTransparent = false;
     SkAutoTUnref<SkStream> alphaData;
     if (!bitmap.isOpaque()) {
@@ -476,6 +515,11 @@ SkPDFImage* SkPDFImage::CreateImage(const SkBitmap& bitmap,
         image->addSMask(mask);
     }
 
+    image->fSource = source;
+    if (images) {
+        image->ref();
+        images->push(image);
+    }
     return image;
 }
 
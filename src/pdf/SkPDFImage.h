@@ -22,24 +22,32 @@ struct SkIRect;
 
 /** \class SkPDFImage
 
-    An image XObject.
+    An image XObject.  Images that show the same pixels are shared, so drawing
+    them again, on any page, only encodes and compresses them once.  A device
+    shares them through the images it passes to CreateImage(), and a document
+    shares them between its pages through its SkPDFCatalog.
 */
-
-// We could play the same trick here as is done in SkPDFGraphicState, storing
-// a copy of the Bitmap object (not the pixels), the pixel generation number,
-// and settings used from the paint to canonicalize image objects.
 class SkPDFImage : public SkPDFStream {
 public:
-    /** Create a new Image XObject to represent the passed bitmap.
+    /** Create an Image XObject to represent the passed bitmap, or return one
+     *  already made for the same pixels.  Images are matched by the bitmap's
+     *  generation ID, the part of its pixel ref cut out by srcRect, and the
+     *  encoder, so the caller must notify the bitmap of any change to its
+     *  pixels, as for any other cache.
      *  @param bitmap   The image to encode.
      *  @param srcRect  The rectangle to cut out of bitmap.
-     *  @param paint    Used to calculate alpha, masks, etc.
+     *  @param encoder  A function used to encode the bitmap for compression.
+     *                  May be NULL.
+     *  @param images   If not NULL, an image in it for the same pixels is
+     *                  returned instead of a new one, and a new image is
+     *                  added to it.  It holds a reference to each image.
      *  @return  The image XObject or NUll if there is nothing to draw for
      *           the given parameters.
      */
     static SkPDFImage* CreateImage(const SkBitmap& bitmap,
                                    const SkIRect& srcRect,
-                                   SkPicture::EncodeBitmap encoder);
+                                   SkPicture::EncodeBitmap encoder,
+                                   SkTDArray<SkPDFImage*>* images = NULL);
 
     virtual ~SkPDFImage();
 
@@ -53,6 +61,13 @@ public:
         return fSrcRect.isEmpty();
     }
 
+    /** Whether this image was made by CreateImage() for the same pixels as
+     *  other, so either can be used in place of the other.
+     */
+    bool showsSamePixels(const SkPDFImage& other) const {
+        return fSource == other.fSource;
+    }
+
     // The SkPDFObject interface.
     virtual void getResources(const SkTSet<SkPDFObject*>& knownResourceObjects,
                               SkTSet<SkPDFObject*>* newResourceObjects);
@@ -66,6 +81,25 @@ private:
 
     SkTDArray<SkPDFObject*> fResources;
 
+    // What CreateImage() made the image from, to match images that show the
+    // same pixels.
+    class Source {
+    public:
+        Source();  // Matches nothing.
+        Source(const SkBitmap& bitmap, const SkIRect& srcRect,
+               SkPicture::EncodeBitmap encoder);
+        bool operator==(const Source& b) const;
+
+    private:
+        uint32_t fGenerationID;  // 0 if there's no pixel ref to match.
+        SkIRect fSubset;  // srcRect, relative to the bitmap's pixel ref.
+        SkColorType fColorType;
+        SkAlphaType fAlphaType;
+        SkPicture::EncodeBitmap fEncoder;
+    };
+
+    Source fSource;
+
     /** Create a PDF image XObject. Entries for the image properties are
      *  automatically added to the stream dictionary.
      *  @param stream     The image stream. May be NULL. Otherwise, this
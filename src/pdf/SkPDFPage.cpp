@@ -9,6 +9,8 @@
 
 #include "SkPDFCatalog.h"
 #include "SkPDFDevice.h"
+#include "SkPDFFont.h"
+#include "SkPDFImage.h"
 #include "SkPDFPage.h"
 #include "SkPDFResourceDict.h"
 #include "SkStream.h"
@@ -19,11 +21,14 @@ SkPDFPage::SkPDFPage(SkPDFDevice* content)
   SkSafeRef(content);
 }
 
-SkPDFPage::~SkPDFPage() {}
+SkPDFPage::~SkPDFPage() {
+    fFontResources.unrefAll();
+}
 
 void SkPDFPage::finalizePage(SkPDFCatalog* catalog, bool firstPage,
                              const SkTSet<SkPDFObject*>& knownResourceObjects,
                              SkTSet<SkPDFObject*>* newResourceObjects) {
+    SkASSERT(fDevice.get() != NULL);
     SkPDFResourceDict* resourceDict = fDevice->getResourceDict();
     if (fContentStream.get() == NULL) {
         insert("Resources", resourceDict);
@@ -41,9 +46,32 @@ void SkPDFPage::finalizePage(SkPDFCatalog* catalog, bool firstPage,
         insert("Contents", new SkPDFObjRef(fContentStream.get()))->unref();
     }
     catalog->addObject(fContentStream.get(), firstPage);
-    resourceDict->getReferencedResources(knownResourceObjects,
-                                         newResourceObjects,
+    SkTSet<SkPDFObject*> resources;
+    resourceDict->getReferencedResources(knownResourceObjects, &resources,
                                          true);
+
+    // Images showing pixels another page already shows use its image, so
+    // they're left out, along with their soft masks.
+    SkTSet<SkPDFObject*> duplicates;
+    const SkTDArray<SkPDFImage*>& images = fDevice->getImages();
+    for (int i = 0; i < images.count(); i++) {
+        if (resources.contains(images[i]) &&
+                catalog->canonicalizeImage(images[i]) != NULL) {
+            duplicates.add(images[i]);
+            images[i]->ref();
+            images[i]->getResources(knownResourceObjects, &duplicates);
+        }
+    }
+    newResourceObjects->setReserve(newResourceObjects->count() +
+                                   resources.count() - duplicates.count());
+    for (int i = 0; i < resources.count(); i++) {
+        if (duplicates.contains(resources[i])) {
+            resources[i]->unref();
+        } else {
+            newResourceObjects->add(resources[i]);
+        }
+    }
+    duplicates.unrefAll();
 }
 
 off_t SkPDFPage::getPageSize(SkPDFCatalog* catalog, off_t fileOffset) {
@@ -57,6 +85,25 @@ void SkPDFPage::emitPage(SkWStream* stream, SkPDFCatalog* catalog) {
     fContentStream->emitObject(stream, catalog, true);
 }
 
+void SkPDFPage::compressContent(SkPDFCatalog* catalog) {
+    SkASSERT(fContentStream.get() != NULL);
+    fContentStream->compress(catalog);
+}
+
+void SkPDFPage::releaseDevice() {
+    SkASSERT(fContentStream.get() != NULL);
+    if (fDevice.get() == NULL) {
+        return;
+    }
+    fFontResources = fDevice->getFontResources();
+    for (int i = 0; i < fFontResources.count(); i++) {
+        fFontResources[i]->ref();
+    }
+    fFontGlyphUsage.reset(SkNEW(SkPDFGlyphSetMap));
+    fFontGlyphUsage->merge(fDevice->getFontGlyphUsage());
+    fDevice.reset(NULL);
+}
+
 // static
 void SkPDFPage::GeneratePageTree(const SkTDArray<SkPDFPage*>& pages,
                                  SkPDFCatalog* catalog,
@@ -146,11 +193,11 @@ void SkPDFPage::GeneratePageTree(const SkTDArray<SkPDFPage*>& pages,
 }
 
 const SkTDArray<SkPDFFont*>& SkPDFPage::getFontResources() const {
-    return fDevice->getFontResources();
+    return fDevice.get() ? fDevice->getFontResources() : fFontResources;
 }
 
 const SkPDFGlyphSetMap& SkPDFPage::getFontGlyphUsage() const {
-    return fDevice->getFontGlyphUsage();
+    return fDevice.get() ? fDevice->getFontGlyphUsage() : *fFontGlyphUsage;
 }
 
 void SkPDFPage::appendDestinations(SkPDFDict* dict) {
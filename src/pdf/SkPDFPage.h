@@ -44,7 +44,8 @@ public:
      *  @param newResourceObjects All the resource objects (recursively) used on
      *                         the page are added to this array.  This gives
      *                         the caller a chance to deduplicate resources
-     *                         across pages.
+     *                         across pages.  Images showing the same pixels
+     *                         as an image in the catalog are left out.
      *  @param knownResourceObjects  The set of resources to be ignored.
      */
     void finalizePage(SkPDFCatalog* catalog, bool firstPage,
@@ -71,6 +72,19 @@ public:
      */
     void emitPage(SkWStream* stream, SkPDFCatalog* catalog);
 
+    /** Compress the page content.  This may be called on another thread
+     *  after finalizePage(), as long as the page isn't emitted meanwhile.
+     *  @param catalog    The active object catalog.
+     */
+    void compressContent(SkPDFCatalog* catalog);
+
+    /** Drop the page's reference to its device, keeping only the font usage
+     *  needed to subset fonts and count them.  Call this after finalizePage()
+     *  and appendDestinations() so a streaming document needn't keep every
+     *  page's drawing until the end.  The page can't be finalized again.
+     */
+    void releaseDevice();
+
     /** Generate a page tree for the passed vector of pages.  New objects are
      *  added to the catalog.  The pageTree vector is populated with all of
      *  the 'Pages' dictionaries as well as the 'Page' objects.  Page trees
@@ -103,6 +117,10 @@ private:
 
     // Once the content is finalized, put it into a stream for output.
     SkAutoTUnref<SkPDFStream> fContentStream;
+
+    // Copied from fDevice by releaseDevice().
+    SkTDArray<SkPDFFont*> fFontResources;
+    SkAutoTDelete<SkPDFGlyphSetMap> fFontGlyphUsage;
     typedef SkPDFDict INHERITED;
 };
 
@@ -46,6 +46,17 @@ public:
                             bool indirect);
     virtual size_t getOutputSize(SkPDFCatalog* catalog, bool indirect);
 
+    /** Compress the stream now, rather than when it's first sized or
+     *  emitted.  For a plain SkPDFStream this touches nothing but the stream
+     *  itself, so it may be called on another thread as long as nothing else
+     *  uses the stream until it returns.
+     */
+    void compress(SkPDFCatalog* catalog) {
+        if (fState == kUnused_State) {
+            this->populate(catalog);
+        }
+    }
+
 protected:
     enum State {
         kUnused_State,         //!< The stream hasn't been requested yet.
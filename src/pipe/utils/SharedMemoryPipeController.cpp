@@ -0,0 +1,337 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SharedMemoryPipeController.h"
+
+#include "SkCanvas.h"
+#include "SkThread.h"
+
+#if defined(SK_BUILD_FOR_WIN32)
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sched.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#if defined(__linux__)
+    #include <limits.h>
+    #include <linux/futex.h>
+    #include <sys/syscall.h>
+    #include <time.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined(SK_BUILD_FOR_WIN32)
+
+SharedMemory* SharedMemory::Create(const char name[], size_t bytes) {
+    return NULL;
+}
+
+SharedMemory* SharedMemory::Open(const char name[]) {
+    return NULL;
+}
+
+SharedMemory::~SharedMemory() {}
+
+#else
+
+SharedMemory::SharedMemory(void* memory, size_t size, const char ownedName[])
+    : fMemory(memory)
+    , fSize(size)
+    , fOwnedName(ownedName) {
+}
+
+SharedMemory* SharedMemory::Create(const char name[], size_t bytes) {
+    int fd = -1;
+    int flags = MAP_SHARED;
+    if (NULL != name) {
+        fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd < 0) {
+            return NULL;
+        }
+        if (ftruncate(fd, bytes) != 0) {
+            close(fd);
+            shm_unlink(name);
+            return NULL;
+        }
+    } else {
+        flags |= MAP_ANONYMOUS;
+    }
+
+    void* memory = mmap(NULL, bytes, PROT_READ | PROT_WRITE, flags, fd, 0);
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (MAP_FAILED == memory) {
+        if (NULL != name) {
+            shm_unlink(name);
+        }
+        return NULL;
+    }
+    return SkNEW_ARGS(SharedMemory, (memory, bytes, name));
+}
+
+SharedMemory* SharedMemory::Open(const char name[]) {
+    SkASSERT(NULL != name);
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat info;
+    void* memory = MAP_FAILED;
+    if (0 == fstat(fd, &info)) {
+        memory = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (MAP_FAILED == memory) {
+        return NULL;
+    }
+    return SkNEW_ARGS(SharedMemory, (memory, info.st_size, NULL));
+}
+
+SharedMemory::~SharedMemory() {
+    munmap(fMemory, fSize);
+    if (!fOwnedName.isEmpty()) {
+        shm_unlink(fOwnedName.c_str());
+    }
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Lives at the start of the shared memory, followed by the ring itself. The byte counts only
+ * ever grow, wrapping around at 2^32, so the reader is caught up when fHead == fTail. The writer's
+ * fields and the reader's are kept on separate cache lines.
+ */
+struct PipeRingHeader {
+    int32_t fMagic;
+    int32_t fRingBytes;
+    int32_t fPad0[14];
+
+    // Written by the controller.
+    int32_t fHead;              // Bytes published.
+    int32_t fWrapAt;            // fHead when the rest of the ring was last skipped.
+    int32_t fWraps;             // Number of such skips.
+    int32_t fWriterDone;
+    int32_t fWriterWaiting;
+    int32_t fPad1[11];
+
+    // Written by the reader.
+    int32_t fTail;              // Bytes played back.
+    int32_t fReaderDone;
+    int32_t fReaderWaiting;
+    int32_t fPad2[13];
+};
+
+static const int32_t kPipeRingMagic = 0x52474b53;   // 'SKGR'
+
+/**
+ * Waits until *addr may no longer be value. Whoever changes it must then call wake(). A change
+ * made with sk_atomic_add() is a full barrier, as is our sk_atomic_inc() of waiting, so either the
+ * waker sees we're waiting, or we see the new value.
+ */
+static void wait_for_change(int32_t* addr, int32_t value, int32_t* waiting) {
+    sk_atomic_inc(waiting);
+    if (sk_acquire_load(addr) == value) {
+#if defined(__linux__)
+        // Not FUTEX_PRIVATE_FLAG: the other side may be in another process. The timeout only
+        // guards against a peer that went away without waking us.
+        struct timespec timeout = { 0, 100 * 1000 * 1000 };
+        syscall(SYS_futex, addr, FUTEX_WAIT, value, &timeout, NULL, 0);
+#elif defined(SK_BUILD_FOR_WIN32)
+        Sleep(0);
+#else
+        sched_yield();
+#endif
+    }
+    sk_atomic_dec(waiting);
+}
+
+static void wake(int32_t* addr, int32_t* waiting) {
+    if (sk_acquire_load(waiting) > 0) {
+#if defined(__linux__)
+        syscall(SYS_futex, addr, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#endif
+    }
+}
+
+static PipeRingHeader* get_header(void* memory) {
+    SkASSERT(SkIsAlign4((intptr_t)memory));
+    PipeRingHeader* header = static_cast<PipeRingHeader*>(memory);
+    SkASSERT(kPipeRingMagic == header->fMagic);
+    return header;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+size_t SharedMemoryPipeController::MemorySize(size_t ringBytes) {
+    SkASSERT(ringBytes >= kMinRingBytes && SkIsPow2(SkToInt(ringBytes)));
+    return sizeof(PipeRingHeader) + ringBytes;
+}
+
+bool SharedMemoryPipeController::Initialize(void* memory, size_t bytes) {
+    if (NULL == memory || !SkIsAlign4((intptr_t)memory) || bytes < sizeof(PipeRingHeader)) {
+        return false;
+    }
+    size_t ringBytes = bytes - sizeof(PipeRingHeader);
+    if (ringBytes < kMinRingBytes || ringBytes > (1 << 30) || !SkIsPow2(SkToInt(ringBytes))) {
+        return false;
+    }
+    PipeRingHeader* header = static_cast<PipeRingHeader*>(memory);
+    sk_bzero(header, sizeof(PipeRingHeader));
+    header->fMagic = kPipeRingMagic;
+    header->fRingBytes = SkToS32(ringBytes);
+    return true;
+}
+
+SharedMemoryPipeController::SharedMemoryPipeController(void* memory)
+    : fHeader(get_header(memory))
+    , fRing(static_cast<uint8_t*>(memory) + sizeof(PipeRingHeader))
+    , fHead(fHeader->fHead) {
+}
+
+SharedMemoryPipeController::~SharedMemoryPipeController() {
+    sk_atomic_inc(&fHeader->fWriterDone);
+    wake(&fHeader->fHead, &fHeader->fReaderWaiting);
+}
+
+void SharedMemoryPipeController::publish(uint32_t bytes) {
+    fHead += bytes;
+    sk_atomic_add(&fHeader->fHead, SkToS32(bytes));
+    wake(&fHeader->fHead, &fHeader->fReaderWaiting);
+}
+
+bool SharedMemoryPipeController::waitForFree(uint32_t bytes, uint32_t* tail) {
+    const uint32_t ringBytes = fHeader->fRingBytes;
+    SkASSERT(bytes <= ringBytes);
+    while (true) {
+        *tail = sk_acquire_load(&fHeader->fTail);
+        if (ringBytes - (fHead - *tail) >= bytes) {
+            return true;
+        }
+        if (sk_acquire_load(&fHeader->fReaderDone)) {
+            return false;
+        }
+        wait_for_change(&fHeader->fTail, *tail, &fHeader->fWriterWaiting);
+    }
+}
+
+void* SharedMemoryPipeController::requestBlock(size_t minRequest, size_t* actual) {
+    const uint32_t ringBytes = fHeader->fRingBytes;
+    if (minRequest > ringBytes || sk_acquire_load(&fHeader->fReaderDone)) {
+        return NULL;
+    }
+
+    // Blocks must be contiguous, so skip the end of the ring if the request won't fit there.
+    // The skip and the request are waited for separately: together they may be more than the
+    // whole ring, but once the skip is published the reader can free the space it covers.
+    uint32_t offset = fHead & (ringBytes - 1);
+    uint32_t tail;
+    if (ringBytes - offset < minRequest) {
+        if (!this->waitForFree(ringBytes - offset, &tail)) {
+            return NULL;
+        }
+        // The reader has passed any previous skip, or we wouldn't have the space.
+        fHeader->fWrapAt = fHead;
+        sk_atomic_inc(&fHeader->fWraps);
+        this->publish(ringBytes - offset);
+        offset = 0;
+    }
+    if (!this->waitForFree(SkToU32(minRequest), &tail)) {
+        return NULL;
+    }
+
+    *actual = SkTMin(ringBytes - offset, ringBytes - (fHead - tail));
+    SkASSERT(*actual >= minRequest && SkIsAlign4(*actual));
+    return fRing + offset;
+}
+
+void SharedMemoryPipeController::notifyWritten(size_t bytes) {
+    SkASSERT(SkIsAlign4(bytes));
+    this->publish(SkToU32(bytes));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+SharedMemoryPipeReader::SharedMemoryPipeReader(void* memory, SkCanvas* target,
+                                               SkPicture::InstallPixelRefProc proc)
+    : fHeader(get_header(memory))
+    , fRing(static_cast<const uint8_t*>(memory) + sizeof(PipeRingHeader))
+    , fTail(fHeader->fTail)
+    , fWraps(fHeader->fWraps)
+    , fReader(target) {
+    fReader.setBitmapDecoder(proc);
+}
+
+void SharedMemoryPipeReader::release(uint32_t bytes) {
+    fTail += bytes;
+    sk_atomic_add(&fHeader->fTail, SkToS32(bytes));
+    wake(&fHeader->fTail, &fHeader->fWriterWaiting);
+}
+
+SkGPipeReader::Status SharedMemoryPipeReader::playback(bool wait) {
+    const uint32_t ringBytes = fHeader->fRingBytes;
+    bool playedAny = false;
+    while (true) {
+        uint32_t head = sk_acquire_load(&fHeader->fHead);
+        if (head == fTail) {
+            if (sk_acquire_load(&fHeader->fWriterDone)) {
+                // Anything published before the writer finished is visible now.
+                if (sk_acquire_load(&fHeader->fHead) == (int32_t)fTail) {
+                    return SkGPipeReader::kDone_Status;
+                }
+                continue;
+            }
+            if (playedAny || !wait) {
+                return SkGPipeReader::kEOF_Status;
+            }
+            wait_for_change(&fHeader->fHead, head, &fHeader->fReaderWaiting);
+            continue;
+        }
+
+        uint32_t available = head - fTail;
+        if ((uint32_t)sk_acquire_load(&fHeader->fWraps) != fWraps) {
+            uint32_t toWrap = (uint32_t)fHeader->fWrapAt - fTail;
+            if (0 == toWrap) {
+                fWraps += 1;
+                this->release(ringBytes - (fTail & (ringBytes - 1)));
+                continue;
+            }
+            available = SkTMin(available, toWrap);
+        }
+
+        SkGPipeReader::Status status = fReader.playback(fRing + (fTail & (ringBytes - 1)),
+                                                        available);
+        this->release(available);
+        playedAny = true;
+        if (SkGPipeReader::kDone_Status == status || SkGPipeReader::kError_Status == status) {
+            // Don't leave the writer waiting on us for space.
+            sk_atomic_inc(&fHeader->fReaderDone);
+            wake(&fHeader->fTail, &fHeader->fWriterWaiting);
+            return status;
+        }
+    }
+}
+
+bool SharedMemoryPipeReader::playbackUntilDone() {
+    while (true) {
+        switch (this->playback(true)) {
+            case SkGPipeReader::kDone_Status:
+                return true;
+            case SkGPipeReader::kError_Status:
+                return false;
+            default:
+                break;
+        }
+    }
+}
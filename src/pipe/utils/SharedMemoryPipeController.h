@@ -0,0 +1,118 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SharedMemoryPipeController_DEFINED
+#define SharedMemoryPipeController_DEFINED
+
+#include "SkGPipe.h"
+#include "SkPicture.h"
+#include "SkString.h"
+
+class SkCanvas;
+struct PipeRingHeader;
+
+/**
+ * A block of memory that can be mapped by more than one process. With a name it is a POSIX
+ * shared memory object, which another process can Open(); without one it is anonymous, and is
+ * shared only with children forked after it was created.
+ */
+class SharedMemory : SkNoncopyable {
+public:
+    static SharedMemory* Create(const char name[], size_t bytes);
+    static SharedMemory* Open(const char name[]);
+
+    /** Unmaps the memory, and removes the name if this process created it. */
+    ~SharedMemory();
+
+    void* memory() const { return fMemory; }
+    size_t size() const { return fSize; }
+
+private:
+    SharedMemory(void* memory, size_t size, const char ownedName[]);
+
+    void*    fMemory;
+    size_t   fSize;
+    SkString fOwnedName;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Writes the pipe into a single-producer/single-consumer ring buffer, so that it can be played
+ * back by a SharedMemoryPipeReader in another process (or thread) sharing the memory. Blocks never
+ * wrap around the end of the ring; when one does not fit, the rest of the ring is skipped.
+ *
+ * requestBlock() waits for the reader to free enough of the ring, and fails if the ring is too
+ * small for the request. Bitmaps are only shared through the stream, so use
+ * SkGPipeWriter::kCrossProcess_Flag without kSharedAddressSpace_Flag for another process: each
+ * bitmap is then flattened into the ring once, and referred to by its heap slot after that.
+ */
+class SharedMemoryPipeController : public SkGPipeController {
+public:
+    /**
+     * Returns the number of bytes of shared memory needed for a ring of ringBytes, which must be
+     * a power of two at least kMinRingBytes.
+     */
+    static size_t MemorySize(size_t ringBytes);
+
+    /**
+     * Lays out an empty ring in memory, which must be 4-byte aligned and bytes long, as given by
+     * MemorySize(). Call this once, before making the controller and reader.
+     */
+    static bool Initialize(void* memory, size_t bytes);
+
+    enum {
+        kMinRingBytes = 64 * 1024
+    };
+
+    explicit SharedMemoryPipeController(void* memory);
+
+    /** Tells the reader there is nothing more to come. */
+    virtual ~SharedMemoryPipeController();
+
+    virtual void* requestBlock(size_t minRequest, size_t* actual) SK_OVERRIDE;
+    virtual void notifyWritten(size_t bytes) SK_OVERRIDE;
+
+private:
+    void publish(uint32_t bytes);
+    // Waits until at least bytes of the ring are free, returning false if the reader gave up.
+    bool waitForFree(uint32_t bytes, uint32_t* tail);
+
+    PipeRingHeader* fHeader;
+    uint8_t*        fRing;
+    uint32_t        fHead;      // Our copy of the published byte count.
+};
+
+/**
+ * Plays back a pipe written by a SharedMemoryPipeController, freeing the ring as it goes.
+ */
+class SharedMemoryPipeReader {
+public:
+    SharedMemoryPipeReader(void* memory, SkCanvas* target,
+                           SkPicture::InstallPixelRefProc proc = NULL);
+
+    /**
+     * Plays back everything published so far. If there is nothing, and wait is true, waits for
+     * the writer first. Returns kEOF_Status when there may be more to come, and kDone_Status once
+     * the writer is finished.
+     */
+    SkGPipeReader::Status playback(bool wait);
+
+    /** Plays back until the writer is finished, returning false if the stream was bad. */
+    bool playbackUntilDone();
+
+private:
+    void release(uint32_t bytes);
+
+    PipeRingHeader* fHeader;
+    const uint8_t*  fRing;
+    uint32_t        fTail;      // Our copy of the consumed byte count.
+    uint32_t        fWraps;     // Number of skips to the start of the ring we've followed.
+    SkGPipeReader   fReader;
+};
+
+#endif
@@ -10,6 +10,7 @@
 #include "SkBitmap.h"
 #include "SkCanvas.h"
 #include "SkColorPriv.h"
+#include "SkData.h"
 #include "SkDescriptor.h"
 #include "SkFDot6.h"
 #include "SkFloatingPoint.h"
@@ -97,11 +98,17 @@ static bool isLCD(const SkScalerContext::Rec& rec) {
 //////////////////////////////////////////////////////////////////////////
 
 struct SkFaceRec;
+struct SkFontData;
 
+// Guards gFTLibrary and the faces opened with it, which the typeface queries share. Scaler
+// contexts each have their own library and face, so they make glyphs without it.
 SK_DECLARE_STATIC_MUTEX(gFTMutex);
 static int          gFTCount;
 static FT_Library   gFTLibrary;
 static SkFaceRec*   gFaceRecHead;
+
+SK_DECLARE_STATIC_MUTEX(gFontDataMutex);
+static SkFontData*  gFontDataHead;
 static bool         gLCDSupportValid;  // true iff |gLCDSupport| has been set.
 static bool         gLCDSupport;  // true iff LCD is supported by the runtime.
 static int          gLCDExtra;  // number of extra pixels for filtering.
@@ -117,48 +124,56 @@ static int          gLCDExtra;  // number of extra pixels for filtering.
 // Android >= Gingerbread (good)
 typedef FT_Error (*FT_Library_SetLcdFilterWeightsProc)(FT_Library, unsigned char*);
 
-// Caller must lock gFTMutex before calling this function.
-static bool InitFreetype() {
-    FT_Error err = FT_Init_FreeType(&gFTLibrary);
-    if (err) {
-        return false;
-    }
-
-    // Setup LCD filtering. This reduces color fringes for LCD smoothed glyphs.
+// Sets up LCD filtering, which reduces color fringes for LCD smoothed glyphs.
+// Returns false if the library has no LCD filter.
+static bool set_lcd_filter(FT_Library library) {
 #ifdef FT_LCD_FILTER_H
     // Use default { 0x10, 0x40, 0x70, 0x40, 0x10 }, as it adds up to 0x110, simulating ink spread.
     // SetLcdFilter must be called before SetLcdFilterWeights.
-    err = FT_Library_SetLcdFilter(gFTLibrary, FT_LCD_FILTER_DEFAULT);
-    if (0 == err) {
-        gLCDSupport = true;
-        gLCDExtra = 2; //Using a filter adds one full pixel to each side.
+    FT_Error err = FT_Library_SetLcdFilter(library, FT_LCD_FILTER_DEFAULT);
+    if (err) {
+        return false;
+    }
 
 #ifdef SK_FONTHOST_FREETYPE_USE_NORMAL_LCD_FILTER
-        // This also adds to 0x110 simulating ink spread, but provides better results than default.
-        static unsigned char gGaussianLikeHeavyWeights[] = { 0x1A, 0x43, 0x56, 0x43, 0x1A, };
+    // This also adds to 0x110 simulating ink spread, but provides better results than default.
+    static unsigned char gGaussianLikeHeavyWeights[] = { 0x1A, 0x43, 0x56, 0x43, 0x1A, };
 
 #if defined(SK_FONTHOST_FREETYPE_RUNTIME_VERSION) && \
-            SK_FONTHOST_FREETYPE_RUNTIME_VERSION > 0x020400
-        err = FT_Library_SetLcdFilterWeights(gFTLibrary, gGaussianLikeHeavyWeights);
+        SK_FONTHOST_FREETYPE_RUNTIME_VERSION > 0x020400
+    err = FT_Library_SetLcdFilterWeights(library, gGaussianLikeHeavyWeights);
 #elif defined(SK_CAN_USE_DLOPEN) && SK_CAN_USE_DLOPEN == 1
-        //The FreeType library is already loaded, so symbols are available in process.
-        void* self = dlopen(NULL, RTLD_LAZY);
-        if (NULL != self) {
-            FT_Library_SetLcdFilterWeightsProc setLcdFilterWeights;
-            //The following cast is non-standard, but safe for POSIX.
-            *reinterpret_cast<void**>(&setLcdFilterWeights) = dlsym(self, "FT_Library_SetLcdFilterWeights");
-            dlclose(self);
-
-            if (NULL != setLcdFilterWeights) {
-                err = setLcdFilterWeights(gFTLibrary, gGaussianLikeHeavyWeights);
-            }
+    //The FreeType library is already loaded, so symbols are available in process.
+    void* self = dlopen(NULL, RTLD_LAZY);
+    if (NULL != self) {
+        FT_Library_SetLcdFilterWeightsProc setLcdFilterWeights;
+        //The following cast is non-standard, but safe for POSIX.
+        *reinterpret_cast<void**>(&setLcdFilterWeights) = dlsym(self, "FT_Library_SetLcdFilterWeights");
+        dlclose(self);
+
+        if (NULL != setLcdFilterWeights) {
+            err = setLcdFilterWeights(library, gGaussianLikeHeavyWeights);
         }
+    }
 #endif
 #endif
-    }
+    return true;
 #else
-    gLCDSupport = false;
+    return false;
 #endif
+}
+
+// Caller must lock gFTMutex before calling this function.
+static bool InitFreetype() {
+    FT_Error err = FT_Init_FreeType(&gFTLibrary);
+    if (err) {
+        return false;
+    }
+
+    gLCDSupport = set_lcd_filter(gFTLibrary);
+    if (gLCDSupport) {
+        gLCDExtra = 2; //Using a filter adds one full pixel to each side.
+    }
     gLCDSupportValid = true;
 
     return true;
@@ -184,11 +199,11 @@ static bool is_lcd_supported() {
 
 class SkScalerContext_FreeType : public SkScalerContext_FreeType_Base {
 public:
-    SkScalerContext_FreeType(SkTypeface*, const SkDescriptor* desc);
+    SkScalerContext_FreeType(SkTypeface_FreeType*, const SkDescriptor* desc);
     virtual ~SkScalerContext_FreeType();
 
     bool success() const {
-        return fFaceRec != NULL &&
+        return fFontData != NULL &&
                fFTSize != NULL &&
                fFace != NULL;
     }
@@ -205,9 +220,10 @@ protected:
     virtual SkUnichar generateGlyphToChar(uint16_t glyph) SK_OVERRIDE;
 
 private:
-    SkFaceRec*  fFaceRec;
-    FT_Face     fFace;              // reference to shared face in gFaceRecHead
-    FT_Size     fFTSize;            // our own copy
+    FT_Library  fLibrary;           // our own, so no other context uses it or fFace
+    SkFontData* fFontData;          // shared with other contexts on the typeface
+    FT_Face     fFace;              // our own, opened on fFontData
+    FT_Size     fFTSize;
     FT_Int      fStrikeIndex;
     SkFixed     fScaleX, fScaleY;
     FT_Matrix   fMatrix22;
@@ -223,9 +239,7 @@ private:
     void getBBoxForCurrentGlyph(SkGlyph* glyph, FT_BBox* bbox,
                                 bool snapToPixelBoundary = false);
     bool getCBoxForLetter(char letter, FT_BBox* bbox);
-    // Caller must lock gFTMutex before calling this function.
     void updateGlyphIfLCD(SkGlyph* glyph);
-    // Caller must lock gFTMutex before calling this function.
     // update FreeType2 glyph slot with glyph emboldened
     void emboldenIfNeeded(FT_Face face, FT_GlyphSlot glyph);
 };
@@ -233,21 +247,6 @@ private:
 ///////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////
 
-struct SkFaceRec {
-    SkFaceRec*      fNext;
-    FT_Face         fFace;
-    FT_StreamRec    fFTStream;
-    SkStream*       fSkStream;
-    uint32_t        fRefCnt;
-    uint32_t        fFontID;
-
-    // assumes ownership of the stream, will call unref() when its done
-    SkFaceRec(SkStream* strm, uint32_t fontID);
-    ~SkFaceRec() {
-        fSkStream->unref();
-    }
-};
-
 extern "C" {
     static unsigned long sk_stream_read(FT_Stream       stream,
                                         unsigned long   offset,
@@ -279,20 +278,85 @@ extern "C" {
     static void sk_stream_close(FT_Stream) {}
 }
 
-SkFaceRec::SkFaceRec(SkStream* strm, uint32_t fontID)
-        : fNext(NULL), fSkStream(strm), fRefCnt(1), fFontID(fontID) {
-//    SkDEBUGF(("SkFaceRec: opening %s (%p)\n", key.c_str(), strm));
+/**
+ *  A typeface's font, read or mapped into memory once and shared by every FT_Face opened on it,
+ *  whichever FT_Library they belong to.
+ */
+struct SkFontData {
+    SkFontData*     fNext;
+    SkData*         fData;
+    int             fFaceIndex;
+    uint32_t        fRefCnt;        // Guarded by gFontDataMutex.
+    uint32_t        fFontID;
+};
 
-    sk_bzero(&fFTStream, sizeof(fFTStream));
-    fFTStream.size = fSkStream->getLength();
-    fFTStream.descriptor.pointer = fSkStream;
-    fFTStream.read  = sk_stream_read;
-    fFTStream.close = sk_stream_close;
+// Will return NULL on failure.
+static SkFontData* ref_font_data(const SkTypeface_FreeType* typeface) {
+    const SkFontID fontID = typeface->uniqueID();
+    SkAutoMutexAcquire ac(gFontDataMutex);
+    for (SkFontData* rec = gFontDataHead; rec; rec = rec->fNext) {
+        if (rec->fFontID == fontID) {
+            rec->fRefCnt += 1;
+            return rec;
+        }
+    }
+
+    int faceIndex;
+    SkData* data = typeface->openData(&faceIndex);
+    if (NULL == data) {
+        return NULL;
+    }
+
+    SkFontData* rec = SkNEW(SkFontData);
+    rec->fData = data;
+    rec->fFaceIndex = faceIndex;
+    rec->fRefCnt = 1;
+    rec->fFontID = fontID;
+    rec->fNext = gFontDataHead;
+    gFontDataHead = rec;
+    return rec;
+}
+
+static void unref_font_data(SkFontData* data) {
+    SkAutoMutexAcquire ac(gFontDataMutex);
+    if (--data->fRefCnt > 0) {
+        return;
+    }
+    SkFontData** prev = &gFontDataHead;
+    while (*prev != data) {
+        SkASSERT(*prev);
+        prev = &(*prev)->fNext;
+    }
+    *prev = data->fNext;
+    data->fData->unref();
+    SkDELETE(data);
+}
+
+// The caller must not use library on any other thread until this returns.
+static FT_Error open_face(FT_Library library, const SkFontData* data, FT_Face* face) {
+    FT_Open_Args    args;
+    memset(&args, 0, sizeof(args));
+    args.flags = FT_OPEN_MEMORY;
+    args.memory_base = (const FT_Byte*)data->fData->data();
+    args.memory_size = data->fData->size();
+    FT_Error err = FT_Open_Face(library, &args, data->fFaceIndex, face);
+    if (err) {
+        fprintf(stderr, "ERROR: unable to open font '%x'\n", data->fFontID);
+    }
+    return err;
 }
 
+struct SkFaceRec {
+    SkFaceRec*      fNext;
+    FT_Face         fFace;
+    SkFontData*     fData;
+    uint32_t        fRefCnt;
+    uint32_t        fFontID;
+};
+
 // Will return 0 on failure
 // Caller must lock gFTMutex before calling this function.
-static SkFaceRec* ref_ft_face(const SkTypeface* typeface) {
+static SkFaceRec* ref_ft_face(const SkTypeface_FreeType* typeface) {
     const SkFontID fontID = typeface->uniqueID();
     SkFaceRec* rec = gFaceRecHead;
     while (rec) {
@@ -304,42 +368,22 @@ static SkFaceRec* ref_ft_face(const SkTypeface* typeface) {
         rec = rec->fNext;
     }
 
-    int face_index;
-    SkStream* strm = typeface->openStream(&face_index);
-    if (NULL == strm) {
+    SkFontData* data = ref_font_data(typeface);
+    if (NULL == data) {
         return NULL;
     }
-
-    // this passes ownership of strm to the rec
-    rec = SkNEW_ARGS(SkFaceRec, (strm, fontID));
-
-    FT_Open_Args    args;
-    memset(&args, 0, sizeof(args));
-    const void* memoryBase = strm->getMemoryBase();
-
-    if (NULL != memoryBase) {
-//printf("mmap(%s)\n", keyString.c_str());
-        args.flags = FT_OPEN_MEMORY;
-        args.memory_base = (const FT_Byte*)memoryBase;
-        args.memory_size = strm->getLength();
-    } else {
-//printf("fopen(%s)\n", keyString.c_str());
-        args.flags = FT_OPEN_STREAM;
-        args.stream = &rec->fFTStream;
-    }
-
-    FT_Error err = FT_Open_Face(gFTLibrary, &args, face_index, &rec->fFace);
-    if (err) {    // bad filename, try the default font
-        fprintf(stderr, "ERROR: unable to open font '%x'\n", fontID);
+    rec = SkNEW(SkFaceRec);
+    rec->fData = data;
+    rec->fRefCnt = 1;
+    rec->fFontID = fontID;
+    if (open_face(gFTLibrary, data, &rec->fFace)) {
+        unref_font_data(data);
         SkDELETE(rec);
         return NULL;
-    } else {
-        SkASSERT(rec->fFace);
-        //fprintf(stderr, "Opened font '%s'\n", filename.c_str());
-        rec->fNext = gFaceRecHead;
-        gFaceRecHead = rec;
-        return rec;
     }
+    rec->fNext = gFaceRecHead;
+    gFaceRecHead = rec;
+    return rec;
 }
 
 // Caller must lock gFTMutex before calling this function.
@@ -356,6 +400,7 @@ static void unref_ft_face(FT_Face face) {
                     gFaceRecHead = next;
                 }
                 FT_Done_Face(face);
+                unref_font_data(rec->fData);
                 SkDELETE(rec);
             }
             return;
@@ -368,7 +413,7 @@ static void unref_ft_face(FT_Face face) {
 
 class AutoFTAccess {
 public:
-    AutoFTAccess(const SkTypeface* tf) : fRec(NULL), fFace(NULL) {
+    AutoFTAccess(const SkTypeface_FreeType* tf) : fRec(NULL), fFace(NULL) {
         gFTMutex.acquire();
         if (1 == ++gFTCount) {
             if (!InitFreetype()) {
@@ -707,6 +752,31 @@ static bool isAxisAligned(const SkScalerContext::Rec& rec) {
             bothZero(rec.fPost2x2[0][0], rec.fPost2x2[1][1]));
 }
 
+static void unref_stream(const void*, size_t, void* stream) {
+    static_cast<SkStream*>(stream)->unref();
+}
+
+SkData* SkTypeface_FreeType::onOpenData(int* ttcIndex) const {
+    SkStream* strm = this->openStream(ttcIndex);
+    if (NULL == strm) {
+        return NULL;
+    }
+    size_t length = strm->getLength();
+    const void* memoryBase = strm->getMemoryBase();
+    if (NULL != memoryBase) {
+        // The data keeps the stream, and so its memory, alive.
+        return SkData::NewWithProc(memoryBase, length, unref_stream, strm);
+    }
+
+    SkAutoMalloc storage(length);
+    size_t read = strm->read(storage.get(), length);
+    strm->unref();
+    if (read != length) {
+        return NULL;
+    }
+    return SkData::NewFromMalloc(storage.detach(), length);
+}
+
 SkScalerContext* SkTypeface_FreeType::onCreateScalerContext(
                                                const SkDescriptor* desc) const {
     SkScalerContext_FreeType* c = SkNEW_ARGS(SkScalerContext_FreeType,
@@ -827,27 +897,34 @@ static FT_Int chooseBitmapStrike(FT_Face face, SkFixed scaleY) {
     return chosenStrikeIndex;
 }
 
-SkScalerContext_FreeType::SkScalerContext_FreeType(SkTypeface* typeface,
+SkScalerContext_FreeType::SkScalerContext_FreeType(SkTypeface_FreeType* typeface,
                                                    const SkDescriptor* desc)
         : SkScalerContext_FreeType_Base(typeface, desc) {
-    SkAutoMutexAcquire  ac(gFTMutex);
+    fStrikeIndex = -1;
+    fFTSize = NULL;
+    fFace = NULL;
+    fFontData = NULL;
 
-    if (gFTCount == 0) {
-        if (!InitFreetype()) {
-            sk_throw();
-        }
+    // Sets gLCDExtra, which generateMetrics() pads LCD glyphs by, if it isn't set already.
+    is_lcd_supported();
+
+    // FreeType lets different threads use different libraries at once, so with a library and
+    // face of our own, we can make glyphs while other contexts do too. Only the font is shared.
+    if (FT_Init_FreeType(&fLibrary)) {
+        fLibrary = NULL;
+        return;
     }
-    ++gFTCount;
+    set_lcd_filter(fLibrary);
 
     // load the font file
-    fStrikeIndex = -1;
-    fFTSize = NULL;
-    fFace = NULL;
-    fFaceRec = ref_ft_face(typeface);
-    if (NULL == fFaceRec) {
+    fFontData = ref_font_data(typeface);
+    if (NULL == fFontData) {
+        return;
+    }
+    if (open_face(fLibrary, fFontData, &fFace)) {
+        fFace = NULL;
         return;
     }
-    fFace = fFaceRec->fFace;
 
     // A is the total matrix.
     SkMatrix A;
@@ -1020,29 +1097,23 @@ SkScalerContext_FreeType::SkScalerContext_FreeType(SkTypeface* typeface,
 }
 
 SkScalerContext_FreeType::~SkScalerContext_FreeType() {
-    SkAutoMutexAcquire  ac(gFTMutex);
-
-    if (fFTSize != NULL) {
-        FT_Done_Size(fFTSize);
-    }
-
-    if (fFace != NULL) {
-        unref_ft_face(fFace);
+    // This also frees our face and its sizes.
+    if (fLibrary != NULL) {
+        FT_Done_FreeType(fLibrary);
     }
-    if (--gFTCount == 0) {
-        FT_Done_FreeType(gFTLibrary);
-        SkDEBUGCODE(gFTLibrary = NULL;)
+    if (fFontData != NULL) {
+        unref_font_data(fFontData);
     }
 }
 
-/*  We call this before each use of the fFace, since we may be sharing
-    this face with other context (at different sizes).
+/*  We call this before each use of the fFace, to be sure fFTSize is the
+    active size.
 */
 FT_Error SkScalerContext_FreeType::setupSize() {
     FT_Error err = FT_Activate_Size(fFTSize);
     if (err != 0) {
         SkDEBUGF(("SkScalerContext_FreeType::FT_Activate_Size(%x, 0x%x, 0x%x) returned 0x%x\n",
-                  fFaceRec->fFontID, fScaleX, fScaleY, err));
+                  fFontData->fFontID, fScaleX, fScaleY, err));
         fFTSize = NULL;
         return err;
     }
@@ -1082,8 +1153,6 @@ void SkScalerContext_FreeType::generateAdvance(SkGlyph* glyph) {
     * which are very cheap to compute with some font formats...
     */
     if (fDoLinearMetrics) {
-        SkAutoMutexAcquire  ac(gFTMutex);
-
         if (this->setupSize()) {
             glyph->zeroMetrics();
             return;
@@ -1183,8 +1252,6 @@ inline void scaleGlyphMetrics(SkGlyph& glyph, SkScalar scale) {
 }
 
 void SkScalerContext_FreeType::generateMetrics(SkGlyph* glyph) {
-    SkAutoMutexAcquire  ac(gFTMutex);
-
     glyph->fRsbDelta = 0;
     glyph->fLsbDelta = 0;
 
@@ -1198,7 +1265,7 @@ void SkScalerContext_FreeType::generateMetrics(SkGlyph* glyph) {
     if (err != 0) {
 #if 0
         SkDEBUGF(("SkScalerContext_FreeType::generateMetrics(%x): FT_Load_Glyph(glyph:%d flags:%x) returned 0x%x\n",
-                    fFaceRec->fFontID, glyph->getGlyphID(fBaseGlyphCount), fLoadGlyphFlags, err));
+                    fFontData->fFontID, glyph->getGlyphID(fBaseGlyphCount), fLoadGlyphFlags, err));
 #endif
     ERROR:
         glyph->zeroMetrics();
@@ -1288,8 +1355,6 @@ void SkScalerContext_FreeType::generateMetrics(SkGlyph* glyph) {
 
 
 void SkScalerContext_FreeType::generateImage(const SkGlyph& glyph) {
-    SkAutoMutexAcquire  ac(gFTMutex);
-
     FT_Error    err;
 
     if (this->setupSize()) {
@@ -1312,8 +1377,6 @@ void SkScalerContext_FreeType::generateImage(const SkGlyph& glyph) {
 
 void SkScalerContext_FreeType::generatePath(const SkGlyph& glyph,
                                             SkPath* path) {
-    SkAutoMutexAcquire  ac(gFTMutex);
-
     SkASSERT(&glyph && path);
 
     if (this->setupSize()) {
@@ -1354,8 +1417,6 @@ void SkScalerContext_FreeType::generateFontMetrics(SkPaint::FontMetrics* mx,
         return;
     }
 
-    SkAutoMutexAcquire  ac(gFTMutex);
-
     if (this->setupSize()) {
         ERROR:
         if (mx) {
@@ -16,6 +16,8 @@
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
+class SkData;
+
 #ifdef SK_DEBUG
     #define SkASSERT_CONTINUE(pred)                                                         \
         do {                                                                                \
@@ -45,6 +47,10 @@ private:
 };
 
 class SkTypeface_FreeType : public SkTypeface {
+public:
+    /** Returns the font's bytes and sets *ttcIndex, or NULL on failure.  The caller must unref. */
+    SkData* openData(int* ttcIndex) const { return this->onOpenData(ttcIndex); }
+
 protected:
     SkTypeface_FreeType(Style style, SkFontID uniqueID, bool isFixedPitch)
         : INHERITED(style, uniqueID, isFixedPitch)
@@ -70,6 +76,12 @@ protected:
     virtual size_t onGetTableData(SkFontTableTag, size_t offset,
                                   size_t length, void* data) const SK_OVERRIDE;
 
+    /**
+     *  Shares openStream()'s memory when it has some, and copies the stream otherwise.
+     *  Typefaces backed by a file should override this to map the file instead.
+     */
+    virtual SkData* onOpenData(int* ttcIndex) const;
+
 private:
     mutable int fGlyphCount;
 
@@ -5,6 +5,7 @@
  * found in the LICENSE file.
  */
 
+#include "SkData.h"
 #include "SkFontHost.h"
 #include "SkFontHost_FreeType_common.h"
 #include "SkFontDescriptor.h"
@@ -118,6 +119,15 @@ protected:
         return SkStream::NewFromFile(fPath.c_str());
     }
 
+    virtual SkData* onOpenData(int* ttcIndex) const SK_OVERRIDE {
+        SkData* data = SkData::NewFromFileName(fPath.c_str());
+        if (NULL == data) {
+            return INHERITED::onOpenData(ttcIndex);  // Couldn't map it; read it instead.
+        }
+        *ttcIndex = 0;
+        return data;
+    }
+
 private:
     SkString fPath;
 
@@ -7,12 +7,100 @@
 
 #include "SkRecordDraw.h"
 
-void SkRecordDraw(const SkRecord& record, SkCanvas* canvas) {
-    for (SkRecords::Draw draw(canvas); draw.index() < record.count(); draw.next()) {
-        record.visit<void>(draw.index(), draw);
+#include "SkThreadPool.h"
+#include "SkTSort.h"
+
+void SkRecordDraw(const SkRecord& record, SkCanvas* canvas, SkBBoxHierarchy* bbh) {
+    if (NULL == bbh) {
+        for (SkRecords::Draw draw(canvas); draw.index() < record.count(); draw.next()) {
+            record.visit<void>(draw.index(), draw);
+        }
+        return;
+    }
+
+    // The BBH was filled in the record's own coordinate space, which is the canvas's local space.
+    SkRect clipBounds;
+    if (!canvas->getClipBounds(&clipBounds)) {
+        return;  // Nothing we could draw would be visible.
+    }
+    SkIRect query;
+    clipBounds.roundOut(&query);
+
+    SkTDArray<void*> ops;
+    bbh->search(query, &ops);
+    if (ops.isEmpty()) {
+        return;
+    }
+    // Not all BBHs return their results in insertion order, but we must play back in order.
+    SkTQSort(ops.begin(), ops.end() - 1, SkTCompareLT<void*>());
+
+    // If we skip a Restore the BBH thought we wouldn't need, make sure we don't leave it unbalanced.
+    SkAutoCanvasRestore saveRestore(canvas, true /*save now, restore at exit*/);
+
+    SkRecords::Draw draw(canvas);
+    for (int i = 0; i < ops.count(); i++) {
+        const unsigned index = (unsigned)(uintptr_t)ops[i];
+        if (index < draw.index()) {
+            continue;  // Skipped over by a quick-rejected PairedPushCull.
+        }
+        draw.setIndex(index);
+        record.visit<void>(index, draw);
+        draw.next();
     }
 }
 
+namespace {
+
+// Plays back an SkRecord into one tile of a larger bitmap.
+class DrawTileTask : public SkRunnable {
+public:
+    DrawTileTask(const SkRecord& record, SkBBoxHierarchy* bbh,
+                 const SkBitmap& dst, const SkIRect& tile)
+        : fRecord(record), fBBH(bbh), fDst(dst), fTile(tile) {}
+
+    virtual void run() SK_OVERRIDE {
+        // The subset shares dst's pixels, so each tile draws straight into its corner of dst.
+        // Tiles never overlap, so no two threads ever write the same pixels.
+        SkBitmap tile;
+        if (!fDst.extractSubset(&tile, fTile)) {
+            return;
+        }
+        SkCanvas canvas(tile);
+        canvas.translate(-SkIntToScalar(fTile.fLeft), -SkIntToScalar(fTile.fTop));
+        SkRecordDraw(fRecord, &canvas, fBBH);
+    }
+
+private:
+    const SkRecord& fRecord;
+    SkBBoxHierarchy* fBBH;
+    const SkBitmap& fDst;
+    const SkIRect fTile;
+};
+
+}  // namespace
+
+void SkRecordDrawTiled(const SkRecord& record, SkBBoxHierarchy* bbh, const SkBitmap& dst,
+                       int tileWidth, int tileHeight, int threadCount) {
+    SkASSERT(tileWidth > 0 && tileHeight > 0);
+    SkAutoLockPixels lock(dst);
+
+    SkTDArray<DrawTileTask*> tasks;
+    for (int y = 0; y < dst.height(); y += tileHeight) {
+        for (int x = 0; x < dst.width(); x += tileWidth) {
+            const SkIRect tile = SkIRect::MakeXYWH(x, y, tileWidth, tileHeight);
+            *tasks.append() = SkNEW_ARGS(DrawTileTask, (record, bbh, dst, tile));
+        }
+    }
+
+    SkThreadPool pool(threadCount);
+    for (int i = 0; i < tasks.count(); i++) {
+        pool.add(tasks[i]);
+    }
+    pool.wait();
+
+    tasks.deleteAll();
+}
+
 namespace SkRecords {
 
 bool Draw::skip(const PairedPushCull& r) {
@@ -27,6 +115,24 @@ bool Draw::skip(const BoundedDrawPosTextH& r) {
     return fCanvas->quickRejectY(r.minY, r.maxY);
 }
 
+bool Draw::skip(const DrawRectBatch& r) {
+    // One quick reject for the whole batch.  Each drawRect() will still check its own rect.
+    SkRect storage;
+    return r.paint.canComputeFastBounds() &&
+           fCanvas->quickReject(r.paint.computeFastBounds(r.bounds, &storage));
+}
+
+bool Draw::skip(const DrawBitmapRectBatch& r) {
+    // Likewise, one quick reject for the whole batch.
+    const SkPaint* paint = r.base->paint;
+    if (NULL == paint) {
+        return fCanvas->quickReject(r.bounds);
+    }
+    SkRect storage;
+    return paint->canComputeFastBounds() &&
+           fCanvas->quickReject(paint->computeFastBounds(r.bounds, &storage));
+}
+
 // NoOps draw nothing.
 template <> void Draw::draw(const NoOp&) {}
 
@@ -67,5 +173,414 @@ DRAW(DrawVertices, drawVertices(r.vmode, r.vertexCount, r.vertices, r.texs, r.co
 
 template <> void Draw::draw(const PairedPushCull& r) { this->draw(*r.base); }
 template <> void Draw::draw(const BoundedDrawPosTextH& r) { this->draw(*r.base); }
+template <> void Draw::draw(const DrawRectBatch& r) {
+    for (unsigned i = 0; i < r.count; i++) {
+        fCanvas->drawRect(r.rects[i], r.paint);
+    }
+}
+template <> void Draw::draw(const DrawBitmapRectBatch& r) {
+    const DrawBitmapRectToRect& base = *r.base;
+    for (unsigned i = 0; i < r.count; i++) {
+        fCanvas->drawBitmapRectToRect(base.bitmap, r.srcs ? &r.srcs[i] : NULL, r.dsts[i],
+                                      base.paint, base.flags);
+    }
+}
+
+// This is an SkRecord visitor that fills an SkBBoxHierarchy.
+//
+// The interesting part here is how to calculate bounds for ops which don't have intrinsic bounds.
+// What is the bounds of a Save or a Concat?  We answer this by thinking about a particular
+// definition of bounds: if I don't execute this op, pixels in this rectangle might draw incorrectly.
+// So the bounds of a Save, a Concat, a Restore, etc. are the union of the bounds of the drawing ops
+// they might have an effect on.  For any given Save/Restore block, the bounds of the Save, the
+// Restore, and any other non-drawing ("control") ops inside are exactly the union of the bounds of
+// the drawing ops inside that block.  Control ops outside any Save/Restore block affect everything.
+//
+// To implement this, we keep a stack of active Save blocks.  As we consume ops inside the block,
+// drawing ops are unioned with the bounds of the block, and control ops are stashed away for later.
+// When we finish the block with a Restore, our bounds are complete, and we go back and fill them in
+// for all the control ops we stashed away.
+//
+// Along the way we track the matrix and a conservative device-space clip bounds ourselves, so we
+// can map each drawing op into device space and trim it to what could possibly be visible.
+class FillBounds : SkNoncopyable {
+public:
+    FillBounds(const SkRecord& record, SkBBoxHierarchy* bbh)
+        : fBounds(record.count()), fCurrentOp(0) {
+        // Calculate bounds for all ops.  This won't go quite in order, so we'll need
+        // to store the bounds separately then feed them in to the BBH later in order.
+        const SkIRect largest = SkIRect::MakeLargest();
+        fCTM.setIdentity();
+        fCurrentClipBounds = largest;
+        for (fCurrentOp = 0; fCurrentOp < record.count(); fCurrentOp++) {
+            record.visit<void>(fCurrentOp, *this);
+        }
+
+        // If we have any lingering unpaired Saves, simulate restores to make
+        // sure all ops in those Save blocks have their bounds calculated.
+        while (!fSaveStack.isEmpty()) {
+            this->popSaveBlock();
+        }
+
+        // Any control ops not part of any Save/Restore block draw everywhere.
+        while (!fControlIndices.isEmpty()) {
+            this->popControl(largest);
+        }
+
+        // Finally feed all stored bounds into the BBH.  They'll be returned in this order.
+        SkASSERT(NULL != bbh);
+        for (uintptr_t i = 0; i < record.count(); i++) {
+            if (!fBounds[i].isEmpty()) {
+                bbh->insert((void*)i, fBounds[i], true/*ok to defer*/);
+            }
+        }
+        bbh->flushDeferredInserts();
+    }
+
+    template <typename T> void operator()(const T& op) {
+        this->updateClipBounds(op);
+        this->trackBounds(op);
+    }
+
+private:
+    struct SaveBounds {
+        int controlOps;        // Number of control ops in this Save block, including the Save.
+        SkIRect bounds;        // Bounds of everything in the block.
+        const SkPaint* paint;  // Unowned.  If set, this block is a layer drawn with this paint.
+        SkMatrix ctm;          // Matrix and clip bounds in effect at the Save, restored at Restore.
+        SkIRect clipBounds;
+    };
+
+    // Only clips change the clip bounds.  Other ops leave them alone.
+    template <typename T> void updateClipBounds(const T&) {}
+    void updateClipBounds(const ClipPath& op) {
+        this->clip(op.path.isInverseFillType() ? SkIRect::MakeLargest()
+                                                : this->mapToDevice(op.path.getBounds()),
+                   op.op);
+    }
+    void updateClipBounds(const ClipRRect& op) {
+        this->clip(this->mapToDevice(op.rrect.getBounds()), op.op);
+    }
+    void updateClipBounds(const ClipRect& op) { this->clip(this->mapToDevice(op.rect), op.op); }
+    void updateClipBounds(const ClipRegion& op) {
+        // Regions are already in device space.
+        this->clip(op.region.getBounds(), op.op);
+    }
+
+    void clip(const SkIRect& shape, SkRegion::Op op) {
+        switch (op) {
+            case SkRegion::kIntersect_Op:
+                if (!fCurrentClipBounds.intersect(shape)) {
+                    fCurrentClipBounds.setEmpty();
+                }
+                break;
+            case SkRegion::kReplace_Op:
+                fCurrentClipBounds = shape;
+                break;
+            case SkRegion::kDifference_Op:
+                // Can only shrink the clip, but we don't know by how much.
+                break;
+            case SkRegion::kUnion_Op:
+            case SkRegion::kXOR_Op:
+            case SkRegion::kReverseDifference_Op:
+                fCurrentClipBounds.join(shape);
+                break;
+        }
+    }
+
+    void trackBounds(const Save&)          { this->pushSaveBlock(NULL); }
+    void trackBounds(const SaveLayer& op)  { this->pushSaveBlock(op.paint); }
+    void trackBounds(const Restore&) {
+        if (fSaveStack.isEmpty()) {
+            // An unbalanced Restore is a no-op on SkCanvas, but treat it like any other control op.
+            this->pushControl();
+            return;
+        }
+        fBounds[fCurrentOp] = this->popSaveBlock();
+    }
+
+    void trackBounds(const Concat& op)          { fCTM.preConcat(op.matrix); this->pushControl(); }
+    void trackBounds(const SetMatrix& op)       { fCTM = op.matrix;          this->pushControl(); }
+    void trackBounds(const ClipRect&)           { this->pushControl(); }
+    void trackBounds(const ClipRRect&)          { this->pushControl(); }
+    void trackBounds(const ClipPath&)           { this->pushControl(); }
+    void trackBounds(const ClipRegion&)         { this->pushControl(); }
+    void trackBounds(const PushCull&)           { this->pushControl(); }
+    void trackBounds(const PopCull&)            { this->pushControl(); }
+    void trackBounds(const PairedPushCull&)     { this->pushControl(); }
+
+    // For all other ops, we can calculate and store the bounds directly now.
+    template <typename T> void trackBounds(const T& op) {
+        fBounds[fCurrentOp] = this->bounds(op);
+        this->updateSaveBounds(fBounds[fCurrentOp]);
+    }
+
+    void pushSaveBlock(const SkPaint* paint) {
+        // Starting a new Save block.  Push a new entry to represent that.
+        SaveBounds sb = { 0, SkIRect::MakeEmpty(), paint, fCTM, fCurrentClipBounds };
+        fSaveStack.push(sb);
+        this->pushControl();
+    }
+
+    SkIRect popSaveBlock() {
+        // We're done the Save block.  Apply the block's bounds to all control ops inside it.
+        SaveBounds sb;
+        fSaveStack.pop(&sb);
+        fCTM = sb.ctm;
+        fCurrentClipBounds = sb.clipBounds;
+
+        // A layer whose paint can turn transparent black into something else draws its whole clip.
+        if (PaintMayAffectTransparentBlack(sb.paint)) {
+            sb.bounds = fCurrentClipBounds;
+        }
+
+        while (sb.controlOps --> 0) {
+            this->popControl(sb.bounds);
+        }
+
+        // This whole Save block may be part another Save block.
+        this->updateSaveBounds(sb.bounds);
+
+        // If called from a real Restore (not a phony one for balance), it'll need the bounds.
+        return sb.bounds;
+    }
+
+    void pushControl() {
+        fControlIndices.push(fCurrentOp);
+        if (!fSaveStack.isEmpty()) {
+            fSaveStack.top().controlOps++;
+        }
+    }
+
+    void popControl(const SkIRect& bounds) {
+        fBounds[fControlIndices.top()] = bounds;
+        fControlIndices.pop();
+    }
+
+    void updateSaveBounds(const SkIRect& bounds) {
+        // If we're in a Save block, expand its bounds to cover these bounds too.
+        if (!fSaveStack.isEmpty()) {
+            fSaveStack.top().bounds.join(bounds);
+        }
+    }
+
+    static bool PaintMayAffectTransparentBlack(const SkPaint* paint) {
+        if (NULL == paint) {
+            return false;
+        }
+        // Color filters and image filters may produce color from nothing.
+        if (paint->getColorFilter() || paint->getImageFilter()) {
+            return true;
+        }
+        SkXfermode::Mode mode;
+        if (!SkXfermode::AsMode(paint->getXfermode(), &mode)) {
+            return true;  // A custom xfermode could do anything.
+        }
+        switch (mode) {
+            // For each of these transfer modes, a source alpha of zero (transparent black) does not
+            // leave the destination unchanged.
+            case SkXfermode::kClear_Mode:
+            case SkXfermode::kSrc_Mode:
+            case SkXfermode::kSrcIn_Mode:
+            case SkXfermode::kDstIn_Mode:
+            case SkXfermode::kSrcOut_Mode:
+            case SkXfermode::kDstATop_Mode:
+            case SkXfermode::kModulate_Mode:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // Does any enclosing layer spread its contents out beyond where they were drawn?
+    bool insideSpreadingLayer() const {
+        for (int i = 0; i < fSaveStack.count(); i++) {
+            const SkPaint* paint = fSaveStack[i].paint;
+            if (paint && (paint->getImageFilter() || paint->getMaskFilter() ||
+                          paint->getLooper())) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Map a local-space rect into device space, outset by a pixel for antialiasing.
+    SkIRect mapToDevice(const SkRect& rect) const {
+        SkRect devRect;
+        fCTM.mapRect(&devRect, rect);
+        devRect.outset(SK_Scalar1, SK_Scalar1);
+        // Keep clear of integer overflow for very large (or non-finite) rects.
+        if (!devRect.intersect(SkRect::Make(SkIRect::MakeLargest()))) {
+            return SkIRect::MakeEmpty();
+        }
+        SkIRect devIRect;
+        devRect.roundOut(&devIRect);
+        return devIRect;
+    }
+
+    // Adjust rect for all the paint effects that might make it draw outside itself,
+    // map it into device space, and trim it to the current clip.
+    SkIRect adjustAndMap(const SkRect& rect, const SkPaint* paint) const {
+        if (this->insideSpreadingLayer()) {
+            return fCurrentClipBounds;
+        }
+        SkRect storage;
+        const SkRect* adjusted = &rect;
+        if (paint) {
+            if (!paint->canComputeFastBounds()) {
+                return fCurrentClipBounds;
+            }
+            adjusted = &paint->computeFastBounds(rect, &storage);
+        }
+        return this->trim(this->mapToDevice(*adjusted));
+    }
+
+    SkIRect trim(const SkIRect& devBounds) const {
+        SkIRect trimmed = devBounds;
+        if (!trimmed.intersect(fCurrentClipBounds)) {
+            return SkIRect::MakeEmpty();
+        }
+        return trimmed;
+    }
+
+    // We don't have precise text bounds without rasterizing, so pad the positions of the glyph
+    // origins out generously by the text size to cover the glyphs drawn there.
+    static void AdjustTextForFontMetrics(SkRect* rect, const SkPaint& paint) {
+        const SkScalar yPad = 2 * paint.getTextSize(),
+                       xPad = 2 * yPad;
+        rect->outset(xPad, yPad);
+    }
+
+    // Unbounded ops draw everywhere they're allowed to.
+    SkIRect bounds(const NoOp&) const { return SkIRect::MakeEmpty(); }  // NoOps don't draw.
+    SkIRect bounds(const Clear&) const { return fCurrentClipBounds; }
+    SkIRect bounds(const DrawPaint&) const { return fCurrentClipBounds; }
+
+    SkIRect bounds(const DrawRect& op) const { return this->adjustAndMap(op.rect, &op.paint); }
+    SkIRect bounds(const DrawRectBatch& op) const {
+        return this->adjustAndMap(op.bounds, &op.paint);
+    }
+    SkIRect bounds(const DrawOval& op) const { return this->adjustAndMap(op.oval, &op.paint); }
+    SkIRect bounds(const DrawRRect& op) const {
+        return this->adjustAndMap(op.rrect.rect(), &op.paint);
+    }
+    SkIRect bounds(const DrawDRRect& op) const {
+        return this->adjustAndMap(op.outer.rect(), &op.paint);
+    }
+    SkIRect bounds(const DrawPath& op) const {
+        return op.path.isInverseFillType() ? fCurrentClipBounds
+                                           : this->adjustAndMap(op.path.getBounds(), &op.paint);
+    }
+    SkIRect bounds(const DrawPoints& op) const {
+        SkRect dst;
+        dst.set(op.pts, SkToInt(op.count));
+        // Points are drawn stroked, so pad them out by the stroke.
+        SkRect storage;
+        if (!op.paint.canComputeFastBounds() || this->insideSpreadingLayer()) {
+            return fCurrentClipBounds;
+        }
+        return this->trim(this->mapToDevice(op.paint.computeFastStrokeBounds(dst, &storage)));
+    }
+    SkIRect bounds(const DrawVertices& op) const {
+        SkRect dst;
+        dst.set(op.vertices, op.vertexCount);
+        return this->adjustAndMap(dst, &op.paint);
+    }
+
+    SkIRect bounds(const DrawBitmap& op) const {
+        const SkBitmap& bm = op.bitmap;
+        return this->adjustAndMap(SkRect::MakeXYWH(op.left, op.top,
+                                                   SkIntToScalar(bm.width()),
+                                                   SkIntToScalar(bm.height())),
+                                  op.paint);
+    }
+    SkIRect bounds(const DrawBitmapMatrix& op) const {
+        const SkBitmap& bm = op.bitmap;
+        SkRect dst;
+        op.matrix.mapRect(&dst, SkRect::MakeWH(SkIntToScalar(bm.width()),
+                                               SkIntToScalar(bm.height())));
+        return this->adjustAndMap(dst, op.paint);
+    }
+    SkIRect bounds(const DrawBitmapNine& op) const {
+        return this->adjustAndMap(op.dst, op.paint);
+    }
+    SkIRect bounds(const DrawBitmapRectToRect& op) const {
+        return this->adjustAndMap(op.dst, op.paint);
+    }
+    SkIRect bounds(const DrawBitmapRectBatch& op) const {
+        return this->adjustAndMap(op.bounds, op.base->paint);
+    }
+    SkIRect bounds(const DrawSprite& op) const {
+        // Sprites ignore the matrix: they're positioned directly in device space.
+        const SkBitmap& bm = op.bitmap;
+        if (this->insideSpreadingLayer() ||
+            (op.paint && !op.paint->canComputeFastBounds())) {
+            return fCurrentClipBounds;
+        }
+        SkRect dst = SkRect::MakeXYWH(SkIntToScalar(op.left), SkIntToScalar(op.top),
+                                      SkIntToScalar(bm.width()), SkIntToScalar(bm.height()));
+        SkRect storage;
+        if (op.paint) {
+            dst = op.paint->computeFastBounds(dst, &storage);
+        }
+        SkIRect devBounds;
+        dst.roundOut(&devBounds);
+        return this->trim(devBounds);
+    }
+
+    SkIRect bounds(const DrawText& op) const {
+        if (op.paint.isVerticalText()) {
+            return fCurrentClipBounds;
+        }
+        // Depending on alignment, the text may run left or right of x.
+        const SkScalar width = op.paint.measureText(op.text, op.byteLength);
+        SkRect dst = SkRect::MakeLTRB(op.x - width, op.y, op.x + width, op.y);
+        AdjustTextForFontMetrics(&dst, op.paint);
+        return this->adjustAndMap(dst, &op.paint);
+    }
+    SkIRect bounds(const DrawPosText& op) const {
+        const int N = op.paint.countText(op.text, op.byteLength);
+        if (N == 0) {
+            return SkIRect::MakeEmpty();
+        }
+        SkRect dst;
+        dst.set(op.pos, N);
+        AdjustTextForFontMetrics(&dst, op.paint);
+        return this->adjustAndMap(dst, &op.paint);
+    }
+    SkIRect bounds(const DrawPosTextH& op) const {
+        const int N = op.paint.countText(op.text, op.byteLength);
+        if (N == 0) {
+            return SkIRect::MakeEmpty();
+        }
+        SkRect dst = SkRect::MakeLTRB(op.xpos[0], op.y, op.xpos[0], op.y);
+        for (int i = 1; i < N; i++) {
+            dst.fLeft  = SkMinScalar(dst.fLeft,  op.xpos[i]);
+            dst.fRight = SkMaxScalar(dst.fRight, op.xpos[i]);
+        }
+        AdjustTextForFontMetrics(&dst, op.paint);
+        return this->adjustAndMap(dst, &op.paint);
+    }
+    SkIRect bounds(const BoundedDrawPosTextH& op) const { return this->bounds(*op.base); }
+    SkIRect bounds(const DrawTextOnPath& op) const {
+        SkRect dst = op.path.getBounds();
+        if (op.matrix) {
+            op.matrix->mapRect(&dst);
+        }
+        AdjustTextForFontMetrics(&dst, op.paint);
+        return this->adjustAndMap(dst, &op.paint);
+    }
+
+    SkAutoTMalloc<SkIRect> fBounds;  // One for each op in the record.
+    SkMatrix fCTM;
+    SkIRect fCurrentClipBounds;
+    unsigned fCurrentOp;
+    SkTDArray<SaveBounds> fSaveStack;
+    SkTDArray<unsigned> fControlIndices;
+};
 
 }  // namespace SkRecords
+
+void SkRecordFillBounds(const SkRecord& record, SkBBoxHierarchy* bbh) {
+    SkRecords::FillBounds(record, bbh);
+}
@@ -8,11 +8,26 @@
 #ifndef SkRecordDraw_DEFINED
 #define SkRecordDraw_DEFINED
 
-#include "SkRecord.h"
+#include "SkBBoxHierarchy.h"
 #include "SkCanvas.h"
+#include "SkRecord.h"
+
+// Fill a BBH to be used by SkRecordDraw to accelerate playback.
+// Each op is inserted with its index into the SkRecord as its data pointer.
+void SkRecordFillBounds(const SkRecord&, SkBBoxHierarchy*);
 
 // Draw an SkRecord into an SkCanvas.  A convenience wrapper around SkRecords::Draw.
-void SkRecordDraw(const SkRecord&, SkCanvas*);
+// If bbh is non-NULL, it must have been filled by SkRecordFillBounds() for this same SkRecord, and
+// we'll only visit the ops which may affect pixels inside the canvas's current clip.
+void SkRecordDraw(const SkRecord&, SkCanvas*, SkBBoxHierarchy* bbh = NULL);
+
+// Draw an SkRecord into a raster SkBitmap, splitting it into tileWidth x tileHeight tiles which are
+// played back in parallel on threadCount threads (one per core if threadCount is negative, or
+// synchronously on this thread if threadCount is 0).  Every thread shares the same SkRecord and
+// BBH, which must not be modified until this returns.  The BBH is optional, but strongly
+// recommended: without it, every tile visits every command.
+void SkRecordDrawTiled(const SkRecord&, SkBBoxHierarchy* bbh, const SkBitmap& dst,
+                       int tileWidth, int tileHeight, int threadCount);
 
 namespace SkRecords {
 
@@ -23,6 +38,7 @@ public:
         : fInitialCTM(canvas->getTotalMatrix()), fCanvas(canvas), fIndex(0) {}
 
     unsigned index() const { return fIndex; }
+    void setIndex(unsigned index) { fIndex = index; }
     void next() { ++fIndex; }
 
     template <typename T> void operator()(const T& r) {
@@ -44,6 +60,8 @@ private:
     // We add our own quick rejects for commands added by optimizations.
     bool skip(const PairedPushCull&);
     bool skip(const BoundedDrawPosTextH&);
+    bool skip(const DrawRectBatch&);
+    bool skip(const DrawBitmapRectBatch&);
 
     const SkMatrix fInitialCTM;
     SkCanvas* fCanvas;
@@ -19,10 +19,15 @@ void SkRecordOptimize(SkRecord* record) {
     SkRecordNoopSaveRestores(record);
     // TODO(mtklein): figure out why we draw differently and reenable
     //SkRecordNoopSaveLayerDrawRestores(record);
+    SkRecordFoldOpaqueSaveLayers(record);
+    SkRecordCollapseMatrices(record);
+    SkRecordNoopRedundantClips(record);
+    SkRecordNoopSaveRestores(record);  // The last two may have left more empty Save/Restores.
 
     SkRecordAnnotateCullingPairs(record);
     SkRecordReduceDrawPosTextStrength(record);  // Helpful to run this before BoundDrawPosTextH.
     SkRecordBoundDrawPosTextH(record);
+    SkRecordBatchDrawRects(record);
 }
 
 // Most of the optimizations in this file are pattern-based.  These are all defined as structs with:
@@ -171,6 +176,71 @@ void SkRecordNoopSaveLayerDrawRestores(SkRecord* record) {
     apply(&pass, record);
 }
 
+// For SaveLayer-[drawing command]-Restore patterns where the SaveLayer's paint is just an opaque
+// alpha, the layer is composited back exactly as the draw would have blended, so fold the layer
+// into the draw by no-oping the SaveLayer and Restore.  Unlike SkRecordNoopSaveLayerDrawRestores,
+// this never changes the draw's paint, so it draws the same pixels.
+// Matches draws that cover their geometry with nothing but the paint's color, and stores the paint.
+class IsColorFill {
+public:
+    IsColorFill() : fPaint(NULL) {}
+
+    typedef SkPaint type;
+    type* get() { return fPaint; }
+
+    bool operator()(DrawRect* draw)   { return this->set(&draw->paint); }
+    bool operator()(DrawOval* draw)   { return this->set(&draw->paint); }
+    bool operator()(DrawRRect* draw)  { return this->set(&draw->paint); }
+    bool operator()(DrawDRRect* draw) { return this->set(&draw->paint); }
+    bool operator()(DrawPath* draw)   { return this->set(&draw->paint); }
+
+    template <typename T>
+    bool operator()(T*) {
+        fPaint = NULL;
+        return false;
+    }
+
+private:
+    bool set(SkPaint* paint) {
+        fPaint = paint;
+        return true;
+    }
+
+    type* fPaint;
+};
+
+struct OpaqueSaveLayerFolder {
+    typedef Pattern3<Is<SaveLayer>, IsColorFill, Is<Restore> > Pattern;
+
+    bool onMatch(SkRecord* record, Pattern* pattern, unsigned begin, unsigned end) {
+        SaveLayer* saveLayer = pattern->first<SaveLayer>();
+        if (saveLayer->bounds != NULL) {
+            // The bounds clip the draw.
+            return false;
+        }
+
+        const SkPaint* layerPaint = saveLayer->paint;
+        if (layerPaint && (layerPaint->getColor() != SK_ColorBLACK ||
+                           SaveLayerDrawRestoreNooper::HasAnyEffect(*layerPaint))) {
+            return false;
+        }
+
+        // Restoring the layer blends each pixel with what's below a second time.  The result only
+        // matches drawing directly when every pixel the draw touches is fully opaque or untouched.
+        const SkPaint* drawPaint = pattern->second<SkPaint>();
+        if (drawPaint->getAlpha() != 0xFF ||
+            drawPaint->isAntiAlias() ||
+            SaveLayerDrawRestoreNooper::HasAnyEffect(*drawPaint)) {
+            return false;
+        }
+        return SaveLayerDrawRestoreNooper::KillSaveLayerAndRestore(record, begin);
+    }
+};
+void SkRecordFoldOpaqueSaveLayers(SkRecord* record) {
+    OpaqueSaveLayerFolder pass;
+    apply(&pass, record);
+}
+
 
 // Replaces DrawPosText with DrawPosTextH when all Y coordinates are equal.
 struct StrengthReducer {
@@ -301,3 +371,342 @@ void SkRecordAnnotateCullingPairs(SkRecord* record) {
     CullAnnotator pass;
     pass.apply(record);
 }
+
+// Collapses runs of SetMatrix and Concat into one command.  Any SetMatrix makes everything in the
+// run before it moot, and any number of Concats (following a SetMatrix or not) fold into one.
+// Like CullAnnotator, this carries state from command to command, so it's a custom pass.
+class MatrixCollapser {
+public:
+    // Anything else (NoOps aside) ends the run.
+    template <typename T> void operator()(T*) { fPending = false; }
+    void operator()(NoOp*) {}
+
+    void operator()(SetMatrix* set) {
+        if (fPending) {
+            fRecord->replace<NoOp>(fPendingIndex);
+        }
+        this->setPending(set->matrix, true);
+    }
+
+    void operator()(Concat* concat) {
+        if (concat->matrix.isIdentity()) {
+            fRecord->replace<NoOp>(fIndex);
+            return;
+        }
+        if (!fPending) {
+            this->setPending(concat->matrix, false);
+            return;
+        }
+
+        SkMatrix merged;
+        merged.setConcat(fPendingMatrix, concat->matrix);
+        fRecord->replace<NoOp>(fPendingIndex);
+        // This replace destroys concat, so don't use it after here.
+        if (fPendingIsSet) {
+            SkNEW_PLACEMENT_ARGS(fRecord->replace<SetMatrix>(fIndex), SetMatrix, (merged));
+        } else {
+            SkNEW_PLACEMENT_ARGS(fRecord->replace<Concat>(fIndex), Concat, (merged));
+        }
+        this->setPending(merged, fPendingIsSet);
+    }
+
+    void apply(SkRecord* record) {
+        fPending = false;
+        for (fRecord = record, fIndex = 0; fIndex < record->count(); fIndex++) {
+            fRecord->mutate<void>(fIndex, *this);
+        }
+    }
+
+private:
+    void setPending(const SkMatrix& matrix, bool isSet) {
+        fPending       = true;
+        fPendingIndex  = fIndex;
+        fPendingMatrix = matrix;
+        fPendingIsSet  = isSet;
+    }
+
+    SkRecord* fRecord;
+    unsigned fIndex;
+
+    bool fPending;          // Is there a SetMatrix or Concat we might still merge into?
+    unsigned fPendingIndex; // If so, this is where it is,
+    SkMatrix fPendingMatrix;// this is its matrix,
+    bool fPendingIsSet;     // and this is true for SetMatrix, false for Concat.
+};
+void SkRecordCollapseMatrices(SkRecord* record) {
+    MatrixCollapser pass;
+    pass.apply(record);
+}
+
+// Tracks a conservative bound on the clip through Save/Restore, and NoOps ClipRects that intersect
+// the clip with a rect already covering it.  We work in the space of the matrix the record is played
+// back under, which we don't know, so we can't tell which pixels anti-aliasing touches.  We only
+// trust that aliased clips hit the same pixels for any playback matrix: if one rect contains
+// another, it contains every pixel center the other does.  So only aliased ClipRects are ever
+// NoOp'd, and only when every clip bounding the current one was aliased too.
+class ClipNooper {
+public:
+    ClipNooper() {
+        State* state = fStates.append();
+        state->matrix.reset();
+        state->clip.setEmpty();
+        state->clipKnown = false;
+        state->clipAA = false;
+        state->flags = SkCanvas::kMatrixClip_SaveFlag;
+    }
+
+    // Draws don't change the matrix or clip.
+    template <typename T> void operator()(T*) {}
+
+    void operator()(Save* save)           { this->push(save->flags); }
+    void operator()(SaveLayer* saveLayer) { this->push(saveLayer->flags); }
+    void operator()(Restore*) {
+        if (fStates.count() < 2) {
+            return;  // Unbalanced; SkCanvas ignores this Restore too.
+        }
+        const State inner = fStates.top();
+        fStates.pop();
+        // Whatever the Save didn't save isn't restored.
+        State& outer = fStates.top();
+        if (!(inner.flags & SkCanvas::kMatrix_SaveFlag)) {
+            outer.matrix = inner.matrix;
+        }
+        if (!(inner.flags & SkCanvas::kClip_SaveFlag)) {
+            outer.clip      = inner.clip;
+            outer.clipKnown = inner.clipKnown;
+            outer.clipAA    = inner.clipAA;
+        }
+    }
+
+    void operator()(SetMatrix* op) { fStates.top().matrix = op->matrix; }
+    void operator()(Concat* op)    { fStates.top().matrix.preConcat(op->matrix); }
+
+    void operator()(ClipRect* op) {
+        const State& state = fStates.top();
+        SkRect rect;
+        state.matrix.mapRect(&rect, op->rect);
+
+        if (SkRegion::kIntersect_Op == op->op && !op->doAA &&
+                state.clipKnown && !state.clipAA && state.matrix.rectStaysRect() &&
+                rect.contains(state.clip)) {
+            fRecord->replace<NoOp>(fIndex);
+            return;
+        }
+        this->clip(rect, op->op, op->doAA, false);
+    }
+    void operator()(ClipRRect* op) {
+        SkRect rect;
+        fStates.top().matrix.mapRect(&rect, op->rrect.getBounds());
+        this->clip(rect, op->op, op->doAA, false);
+    }
+    void operator()(ClipPath* op) {
+        SkRect rect;
+        fStates.top().matrix.mapRect(&rect, op->path.getBounds());
+        this->clip(rect, op->op, op->doAA, op->path.isInverseFillType());
+    }
+    void operator()(ClipRegion* op) {
+        // Regions are in device space, not ours, so all we can use is that intersecting shrinks.
+        State& state = fStates.top();
+        if (SkRegion::kIntersect_Op != op->op && SkRegion::kDifference_Op != op->op) {
+            state.clipKnown = false;
+        }
+    }
+
+    void apply(SkRecord* record) {
+        for (fRecord = record, fIndex = 0; fIndex < record->count(); fIndex++) {
+            fRecord->mutate<void>(fIndex, *this);
+        }
+    }
+
+private:
+    struct State {
+        SkMatrix matrix;    // Relative to the matrix at the start of playback.
+        SkRect clip;        // If clipKnown, the clip is somewhere inside this.
+        bool clipKnown;
+        bool clipAA;        // Might an anti-aliased clip have touched pixels just outside clip?
+        SkCanvas::SaveFlags flags;  // What the Save that pushed us will restore.
+    };
+
+    void push(SkCanvas::SaveFlags flags) {
+        const State top = fStates.top();
+        State* state = fStates.append();
+        *state = top;
+        state->flags = flags;
+    }
+
+    // Update our clip bound after clipping with something bounded by bounds.
+    void clip(const SkRect& bounds, SkRegion::Op op, bool doAA, bool inverse) {
+        State& state = fStates.top();
+        switch (op) {
+            case SkRegion::kIntersect_Op:
+                if (inverse) {
+                    break;  // The clip can only shrink, but we don't know by how much.
+                }
+                if (!state.clipKnown) {
+                    state.clip = bounds;
+                    state.clipKnown = true;
+                    state.clipAA = doAA;
+                } else {
+                    if (!state.clip.intersect(bounds)) {
+                        state.clip.setEmpty();
+                    }
+                    state.clipAA |= doAA;
+                }
+                break;
+            case SkRegion::kDifference_Op:
+                break;  // Can only shrink.
+            case SkRegion::kReplace_Op:
+                state.clip = bounds;
+                state.clipKnown = !inverse;
+                state.clipAA = doAA;
+                break;
+            default:
+                state.clipKnown = false;  // Union, XOR, and ReverseDifference can grow the clip.
+                break;
+        }
+    }
+
+    SkTDArray<State> fStates;
+    SkRecord* fRecord;
+    unsigned fIndex;
+};
+void SkRecordNoopRedundantClips(SkRecord* record) {
+    ClipNooper pass;
+    pass.apply(record);
+}
+
+// Replaces each run of two or more DrawRects with identical paints (NoOps between them are fine)
+// with one DrawRectBatch, saving a dispatch and a quickReject per rect when it's off screen.
+// Runs of DrawBitmapRectToRects of the same bitmap, with identical paints and flags, become one
+// DrawBitmapRectBatch the same way.
+class RectBatcher {
+public:
+    // Anything else (NoOps aside) ends the run.
+    template <typename T> void operator()(T*) { this->flush(); }
+    void operator()(NoOp*) {}
+
+    void operator()(DrawRect* draw) {
+        if (!fBitmapRun.isEmpty() || (!fRun.isEmpty() && !(fRun[0].draw->paint == draw->paint))) {
+            this->flush();
+        }
+        Entry<DrawRect>* entry = fRun.append();
+        entry->index = fIndex;
+        entry->draw = draw;
+    }
+
+    void operator()(DrawBitmapRectToRect* draw) {
+        if (!fRun.isEmpty() ||
+            (!fBitmapRun.isEmpty() && !SameBatch(*fBitmapRun[0].draw, *draw))) {
+            this->flush();
+        }
+        Entry<DrawBitmapRectToRect>* entry = fBitmapRun.append();
+        entry->index = fIndex;
+        entry->draw = draw;
+    }
+
+    void apply(SkRecord* record) {
+        for (fRecord = record, fIndex = 0; fIndex < record->count(); fIndex++) {
+            fRecord->mutate<void>(fIndex, *this);
+        }
+        this->flush();
+    }
+
+private:
+    template <typename T>
+    struct Entry {
+        unsigned index;
+        T* draw;
+    };
+
+    // The same bitmap, paint and flags, and either both or neither with a src rect.
+    static bool SameBatch(DrawBitmapRectToRect& a, DrawBitmapRectToRect& b) {
+        const SkBitmap& bitmapA = a.bitmap;
+        const SkBitmap& bitmapB = b.bitmap;
+        const SkPaint* paintA = a.paint;
+        const SkPaint* paintB = b.paint;
+        return bitmapA.pixelRef() == bitmapB.pixelRef() &&
+               bitmapA.pixelRefOrigin() == bitmapB.pixelRefOrigin() &&
+               bitmapA.info() == bitmapB.info() &&
+               (paintA ? paintB && *paintA == *paintB : NULL == paintB) &&
+               a.flags == b.flags &&
+               (NULL == a.src) == (NULL == b.src);
+    }
+
+    // Rects may be unsorted, so look at both corners.
+    static void JoinUnsorted(SkRect* bounds, const SkRect& r) {
+        bounds->fLeft   = SkTMin(bounds->fLeft,   SkTMin(r.fLeft,  r.fRight));
+        bounds->fRight  = SkTMax(bounds->fRight,  SkTMax(r.fLeft,  r.fRight));
+        bounds->fTop    = SkTMin(bounds->fTop,    SkTMin(r.fTop,   r.fBottom));
+        bounds->fBottom = SkTMax(bounds->fBottom, SkTMax(r.fTop,   r.fBottom));
+    }
+
+    void flush() {
+        this->flushRects();
+        this->flushBitmapRects();
+    }
+
+    void flushRects() {
+        const unsigned count = fRun.count();
+        if (count < 2) {
+            fRun.rewind();
+            return;
+        }
+
+        SkRect* rects = fRecord->alloc<SkRect>(count);
+        SkRect bounds = fRun[0].draw->rect;
+        bounds.sort();
+        for (unsigned i = 0; i < count; i++) {
+            rects[i] = fRun[i].draw->rect;
+            JoinUnsorted(&bounds, rects[i]);
+        }
+
+        for (unsigned i = 1; i < count; i++) {
+            fRecord->replace<NoOp>(fRun[i].index);
+        }
+        // Extend lifetime of the first DrawRect so we can copy its paint.
+        Adopted<DrawRect> adopted(fRun[0].draw);
+        SkNEW_PLACEMENT_ARGS(fRecord->replace<DrawRectBatch>(fRun[0].index, adopted),
+                             DrawRectBatch, (adopted->paint, rects, count, bounds));
+        fRun.rewind();
+    }
+
+    void flushBitmapRects() {
+        const unsigned count = fBitmapRun.count();
+        if (count < 2) {
+            fBitmapRun.rewind();
+            return;
+        }
+
+        const bool hasSrcs = NULL != fBitmapRun[0].draw->src;
+        SkRect* srcs = hasSrcs ? fRecord->alloc<SkRect>(count) : NULL;
+        SkRect* dsts = fRecord->alloc<SkRect>(count);
+        SkRect bounds = fBitmapRun[0].draw->dst;
+        bounds.sort();
+        for (unsigned i = 0; i < count; i++) {
+            DrawBitmapRectToRect* draw = fBitmapRun[i].draw;
+            if (hasSrcs) {
+                srcs[i] = *draw->src;
+            }
+            dsts[i] = draw->dst;
+            JoinUnsorted(&bounds, dsts[i]);
+        }
+
+        for (unsigned i = 1; i < count; i++) {
+            fRecord->replace<NoOp>(fBitmapRun[i].index);
+        }
+        // The first DrawBitmapRectToRect keeps the bitmap, paint and flags for the batch.
+        Adopted<DrawBitmapRectToRect> adopted(fBitmapRun[0].draw);
+        SkNEW_PLACEMENT_ARGS(fRecord->replace<DrawBitmapRectBatch>(fBitmapRun[0].index, adopted),
+                             DrawBitmapRectBatch, (&adopted, srcs, dsts, count, bounds));
+        fBitmapRun.rewind();
+    }
+
+    SkTDArray<Entry<DrawRect> > fRun;
+    SkTDArray<Entry<DrawBitmapRectToRect> > fBitmapRun;
+    SkRecord* fRecord;
+    unsigned fIndex;
+};
+void SkRecordBatchDrawRects(SkRecord* record) {
+    RectBatcher pass;
+    pass.apply(record);
+}
@@ -23,6 +23,16 @@ void SkRecordNoopSaveRestores(SkRecord*);
 // draw, and no-op the SaveLayer and Restore.
 void SkRecordNoopSaveLayerDrawRestores(SkRecord*);
 
+// For SaveLayer-[opaque aliased fill]-Restore patterns whose SaveLayer paint is only an opaque alpha,
+// no-op the SaveLayer and Restore, drawing the same pixels.
+void SkRecordFoldOpaqueSaveLayers(SkRecord*);
+
+// Collapses runs of SetMatrix and Concat, with nothing but NoOps between them, into a single command.
+void SkRecordCollapseMatrices(SkRecord*);
+
+// NoOps away aliased intersecting ClipRects that can't shrink an aliased clip any further.
+void SkRecordNoopRedundantClips(SkRecord*);
+
 // Annotates PushCull commands with the relative offset of their paired PopCull.
 void SkRecordAnnotateCullingPairs(SkRecord*);
 
@@ -32,4 +42,8 @@ void SkRecordReduceDrawPosTextStrength(SkRecord*);
 // Calculate min and max Y bounds for DrawPosTextH commands, for use with SkCanvas::quickRejectY.
 void SkRecordBoundDrawPosTextH(SkRecord*);
 
+// Replace runs of DrawRects sharing a paint with a single DrawRectBatch, and runs of
+// DrawBitmapRectToRects sharing a bitmap, paint and flags with a single DrawBitmapRectBatch.
+void SkRecordBatchDrawRects(SkRecord*);
+
 #endif//SkRecordOpts_DEFINED
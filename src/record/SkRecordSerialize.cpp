@@ -0,0 +1,1100 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkRecordSerialize.h"
+
+#include "SkChecksum.h"
+#include "SkChunkAlloc.h"
+#include "SkData.h"
+#include "SkPictureFlat.h"  // SkFactoryPlayback, SkTypefacePlayback
+#include "SkPtrRecorder.h"
+#include "SkRRect.h"
+#include "SkReadBuffer.h"
+#include "SkStream.h"
+#include "SkTArray.h"
+#include "SkTDynamicHash.h"
+#include "SkTypeface.h"
+#include "SkWriteBuffer.h"
+#include "SkWriter32.h"
+#include "SkXfermode.h"
+
+// Format notes!
+//
+// Everything is 4-byte aligned and in native byte order.  After the Header come these sections:
+//   types       fCount bytes, one SkRecords::Type per command, padded to a multiple of 4.
+//   offsets     fCount uint32_ts, where each command's arguments start in the payload section.
+//   payload     The arguments to each command.  Plain data (rects, matrices, text, point arrays)
+//               is stored inline; paints, paths, bitmaps, and xfermodes are stored as int32_t
+//               indices into the side tables, or -1 where an optional argument is NULL.
+//   factories   Names of SkFlattenable factories used by the side tables, as SkWriter32 strings.
+//   typefaces   SkTypeface::serialize() output for typefaces used by the paints.
+//   tables      Each table in Table order, each entry a uint32_t size then SkWriteBuffer bytes.
+//
+// Commands are read back into ordinary SkRecords structs, so the optimized forms that
+// SkRecordOptimize produces (PairedPushCull, BoundedDrawPosTextH, the batches) round trip too.
+
+namespace {
+
+enum Table {
+    kPaint_Table,
+    kPath_Table,
+    kBitmap_Table,
+    kXfermode_Table,
+
+    kTableCount
+};
+
+// Bump kVersion whenever the layout of the header, the payload of any command, or a table changes.
+const uint32_t kMagic   = SkSetFourByteTag('s', 'k', 'r', 'c');
+const uint32_t kVersion = 1;
+
+struct Header {
+    uint32_t fMagic;
+    uint32_t fVersion;
+    uint32_t fCount;
+    uint32_t fPayloadBytes;
+    uint32_t fFactoryCount;
+    uint32_t fFactoryBytes;
+    uint32_t fTypefaceCount;
+    uint32_t fTypefaceBytes;
+    uint32_t fTableCount[kTableCount];
+    uint32_t fTableBytes;
+};
+
+#define COUNT(T) + 1
+const int kRecordTypeCount = 0 SK_RECORD_TYPES(COUNT);
+#undef COUNT
+
+// Hands out indices for byte strings in the order they were first seen.
+class Dedup : SkNoncopyable {
+public:
+    Dedup() : fStorage(4096), fCount(0) {}
+
+    // Returns the index of these bytes, setting *isNew if they've not been seen before.
+    // size must be a multiple of 4.
+    int findOrAdd(const void* bytes, size_t size, bool* isNew) {
+        SkASSERT(SkIsAlign4(size));
+        Key key = { (const uint32_t*)bytes, size, SkChecksum::Murmur3((const uint32_t*)bytes, size) };
+        Entry* entry = fHash.find(key);
+        *isNew = (NULL == entry);
+        if (*isNew) {
+            void* copy = fStorage.allocThrow(size);
+            memcpy(copy, bytes, size);
+            entry = (Entry*)fStorage.allocThrow(sizeof(Entry));
+            entry->fKey = key;
+            entry->fKey.fData = (const uint32_t*)copy;
+            entry->fIndex = fCount++;
+            fHash.add(entry);
+        }
+        return entry->fIndex;
+    }
+
+private:
+    struct Key {
+        const uint32_t* fData;
+        size_t fSize;
+        uint32_t fHash;
+
+        bool operator==(const Key& other) const {
+            return fHash == other.fHash
+                && fSize == other.fSize
+                && 0 == memcmp(fData, other.fData, fSize);
+        }
+    };
+
+    struct Entry {
+        Key fKey;
+        int fIndex;
+
+        static const Key& GetKey(const Entry& entry) { return entry.fKey; }
+        static uint32_t Hash(const Key& key) { return key.fHash; }
+    };
+
+    SkChunkAlloc fStorage;  // Holds Entries and the bytes they point to.
+    SkTDynamicHash<Entry, Key> fHash;
+    int fCount;
+};
+
+class Serializer : SkNoncopyable {
+public:
+    Serializer() {
+        sk_bzero(fTableCount, sizeof(fTableCount));
+    }
+
+    // Called by SkRecord::visit.
+    template <typename T>
+    void operator()(const T& record) {
+        *fTypes.append() = SkToU8(T::kType);
+        *fOffsets.append() = SkToU32(fPayload.bytesWritten());
+        this->write(record);
+    }
+
+    SkData* finish() const;
+
+private:
+    int paint(const SkPaint& paint) {
+        SkWriteBuffer buffer(SkWriteBuffer::kCrossProcess_Flag);
+        this->setupBuffer(&buffer);
+        buffer.writePaint(paint);
+        return this->intern(kPaint_Table, buffer);
+    }
+
+    int paint(const SkPaint* paint) { return paint ? this->paint(*paint) : -1; }
+
+    int path(const SkPath& path) {
+        SkWriteBuffer buffer(SkWriteBuffer::kCrossProcess_Flag);
+        buffer.writePath(path);
+        return this->intern(kPath_Table, buffer);
+    }
+
+    int bitmap(const SkBitmap& bitmap) {
+        // Recorded bitmaps are immutable, so we can key them on their pixels' identity and
+        // skip flattening any we've seen before.
+        const uint32_t key[] = {
+            bitmap.getGenerationID(),
+            SkToU32(bitmap.pixelRefOrigin().x()),
+            SkToU32(bitmap.pixelRefOrigin().y()),
+            SkToU32(bitmap.width()),
+            SkToU32(bitmap.height()),
+            SkToU32(bitmap.colorType()),
+            SkToU32(bitmap.alphaType()),
+        };
+        bool isNew;
+        const int index = fDedup[kBitmap_Table].findOrAdd(key, sizeof(key), &isNew);
+        if (isNew) {
+            SkWriteBuffer buffer(SkWriteBuffer::kCrossProcess_Flag);
+            this->setupBuffer(&buffer);
+            buffer.writeBitmap(bitmap);
+            this->append(kBitmap_Table, buffer);
+        }
+        return index;
+    }
+
+    int xfermode(const SkXfermode* xfermode) {
+        if (NULL == xfermode) {
+            return -1;
+        }
+        SkWriteBuffer buffer(SkWriteBuffer::kCrossProcess_Flag);
+        this->setupBuffer(&buffer);
+        buffer.writeFlattenable(xfermode);
+        return this->append(kXfermode_Table, buffer);
+    }
+
+    void setupBuffer(SkWriteBuffer* buffer) {
+        buffer->setFactoryRecorder(&fFactories);
+        buffer->setTypefaceRecorder(&fTypefaces);
+    }
+
+    // Append buffer to table, returning its index there.
+    int append(Table table, SkWriteBuffer& buffer) {
+        const size_t size = buffer.bytesWritten();
+        fTables[table].write32(SkToU32(size));
+        buffer.writeToMemory(fTables[table].reserve(size));
+        return fTableCount[table]++;
+    }
+
+    // Like append, but reuses an existing entry with the same bytes if there is one.
+    int intern(Table table, SkWriteBuffer& buffer) {
+        const size_t size = buffer.bytesWritten();
+        SkAutoSMalloc<512> bytes(size);
+        buffer.writeToMemory(bytes.get());
+        bool isNew;
+        const int index = fDedup[table].findOrAdd(bytes.get(), size, &isNew);
+        if (isNew) {
+            fTables[table].write32(SkToU32(size));
+            fTables[table].write(bytes.get(), size);
+            fTableCount[table]++;
+        }
+        return index;
+    }
+
+    void writeBool(bool b) { fPayload.writeBool(b); }
+    void write32(int32_t x) { fPayload.write32(x); }
+    void writeScalar(SkScalar x) { fPayload.writeScalar(x); }
+    void writeRect(const SkRect& r) { fPayload.writeRect(r); }
+    void writeMatrix(const SkMatrix& m) { fPayload.writeMatrix(m); }
+
+    void writeRect(const SkRect* r) {
+        this->writeBool(NULL != r);
+        if (r) { this->writeRect(*r); }
+    }
+
+    void writeMatrix(const SkMatrix* m) {
+        this->writeBool(NULL != m);
+        if (m) { this->writeMatrix(*m); }
+    }
+
+    template <typename T>
+    void writeArray(const T* array, unsigned count) {
+        this->write32(count);
+        fPayload.writePad(array, count * sizeof(T));
+    }
+
+    void writeText(const char* text, size_t byteLength) {
+        this->writeArray(text, SkToU32(byteLength));
+    }
+
+    void write(const SkRecords::NoOp&) {}
+    void write(const SkRecords::Restore&) {}
+    void write(const SkRecords::Save& r) { this->write32(r.flags); }
+    void write(const SkRecords::SaveLayer& r) {
+        this->writeRect(r.bounds);
+        this->write32(this->paint(r.paint));
+        this->write32(r.flags);
+    }
+
+    void write(const SkRecords::PushCull& r) { this->writeRect(r.rect); }
+    void write(const SkRecords::PopCull&) {}
+    void write(const SkRecords::PairedPushCull& r) {
+        this->writeRect(r.base->rect);
+        this->write32(r.skip);
+    }
+
+    void write(const SkRecords::Concat& r) { this->writeMatrix(r.matrix); }
+    void write(const SkRecords::SetMatrix& r) { this->writeMatrix(r.matrix); }
+
+    void write(const SkRecords::ClipPath& r) {
+        this->write32(this->path(r.path));
+        this->write32(r.op);
+        this->writeBool(r.doAA);
+    }
+    void write(const SkRecords::ClipRRect& r) {
+        fPayload.writeRRect(r.rrect);
+        this->write32(r.op);
+        this->writeBool(r.doAA);
+    }
+    void write(const SkRecords::ClipRect& r) {
+        this->writeRect(r.rect);
+        this->write32(r.op);
+        this->writeBool(r.doAA);
+    }
+    void write(const SkRecords::ClipRegion& r) {
+        fPayload.writeRegion(r.region);
+        this->write32(r.op);
+    }
+
+    void write(const SkRecords::Clear& r) { this->write32(r.color); }
+
+    void write(const SkRecords::DrawBitmap& r) {
+        this->write32(this->paint(r.paint));
+        this->write32(this->bitmap(r.bitmap));
+        this->writeScalar(r.left);
+        this->writeScalar(r.top);
+    }
+    void write(const SkRecords::DrawBitmapMatrix& r) {
+        this->write32(this->paint(r.paint));
+        this->write32(this->bitmap(r.bitmap));
+        this->writeMatrix(r.matrix);
+    }
+    void write(const SkRecords::DrawBitmapNine& r) {
+        this->write32(this->paint(r.paint));
+        this->write32(this->bitmap(r.bitmap));
+        fPayload.writeIRect(r.center);
+        this->writeRect(r.dst);
+    }
+    void write(const SkRecords::DrawBitmapRectToRect& r) {
+        this->write32(this->paint(r.paint));
+        this->write32(this->bitmap(r.bitmap));
+        this->writeRect(r.src);
+        this->writeRect(r.dst);
+        this->write32(r.flags);
+    }
+    void write(const SkRecords::DrawDRRect& r) {
+        this->write32(this->paint(r.paint));
+        fPayload.writeRRect(r.outer);
+        fPayload.writeRRect(r.inner);
+    }
+    void write(const SkRecords::DrawOval& r) {
+        this->write32(this->paint(r.paint));
+        this->writeRect(r.oval);
+    }
+    void write(const SkRecords::DrawPaint& r) { this->write32(this->paint(r.paint)); }
+    void write(const SkRecords::DrawPath& r) {
+        this->write32(this->paint(r.paint));
+        this->write32(this->path(r.path));
+    }
+    void write(const SkRecords::DrawPoints& r) {
+        this->write32(this->paint(r.paint));
+        this->write32(r.mode);
+        this->writeArray(r.pts, SkToU32(r.count));
+    }
+    void write(const SkRecords::DrawPosText& r) {
+        this->write32(this->paint(r.paint));
+        this->writeText(r.text, r.byteLength);
+        this->writeArray<SkPoint>(r.pos, r.paint.countText(r.text, r.byteLength));
+    }
+    void write(const SkRecords::DrawPosTextH& r) {
+        this->write32(this->paint(r.paint));
+        this->writeText(r.text, r.byteLength);
+        this->writeArray<SkScalar>(r.xpos, r.paint.countText(r.text, r.byteLength));
+        this->writeScalar(r.y);
+    }
+    void write(const SkRecords::DrawRRect& r) {
+        this->write32(this->paint(r.paint));
+        fPayload.writeRRect(r.rrect);
+    }
+    void write(const SkRecords::DrawRect& r) {
+        this->write32(this->paint(r.paint));
+        this->writeRect(r.rect);
+    }
+    void write(const SkRecords::DrawSprite& r) {
+        this->write32(this->paint(r.paint));
+        this->write32(this->bitmap(r.bitmap));
+        this->write32(r.left);
+        this->write32(r.top);
+    }
+    void write(const SkRecords::DrawText& r) {
+        this->write32(this->paint(r.paint));
+        this->writeText(r.text, r.byteLength);
+        this->writeScalar(r.x);
+        this->writeScalar(r.y);
+    }
+    void write(const SkRecords::DrawTextOnPath& r) {
+        this->write32(this->paint(r.paint));
+        this->writeText(r.text, r.byteLength);
+        this->write32(this->path(r.path));
+        this->writeMatrix(r.matrix);
+    }
+    void write(const SkRecords::DrawVertices& r) {
+        this->write32(this->paint(r.paint));
+        this->write32(r.vmode);
+        this->writeArray<SkPoint>(r.vertices, r.vertexCount);
+        this->writeBool(NULL != r.texs);
+        if (r.texs) {
+            this->writeArray<SkPoint>(r.texs, r.vertexCount);
+        }
+        this->writeBool(NULL != r.colors);
+        if (r.colors) {
+            this->writeArray<SkColor>(r.colors, r.vertexCount);
+        }
+        this->write32(this->xfermode(r.xmode.get()));
+        this->writeArray<uint16_t>(r.indices, r.indexCount);
+    }
+
+    void write(const SkRecords::BoundedDrawPosTextH& r) {
+        const SkRecords::DrawPosTextH* base = r.base;
+        this->write(*base);
+        this->writeScalar(r.minY);
+        this->writeScalar(r.maxY);
+    }
+    void write(const SkRecords::DrawRectBatch& r) {
+        this->write32(this->paint(r.paint));
+        this->writeArray<SkRect>(r.rects, r.count);
+        this->writeRect(r.bounds);
+    }
+    void write(const SkRecords::DrawBitmapRectBatch& r) {
+        const SkRecords::DrawBitmapRectToRect* base = r.base;
+        this->write(*base);
+        if (r.srcs) {
+            this->writeArray<SkRect>(r.srcs, r.count);
+        }
+        this->writeArray<SkRect>(r.dsts, r.count);
+        this->writeRect(r.bounds);
+    }
+
+    SkTDArray<uint8_t> fTypes;
+    SkTDArray<uint32_t> fOffsets;
+    SkWriter32 fPayload;
+
+    SkFactorySet fFactories;
+    SkRefCntSet fTypefaces;
+
+    SkWriter32 fTables[kTableCount];
+    int fTableCount[kTableCount];
+    Dedup fDedup[kTableCount];
+};
+
+SkData* Serializer::finish() const {
+    SkWriter32 factories;
+    {
+        SkAutoTMalloc<SkFlattenable::Factory> array(fFactories.count());
+        fFactories.copyToArray(array.get());
+        for (int i = 0; i < fFactories.count(); i++) {
+            factories.writeString(SkFlattenable::FactoryToName(array[i]));
+        }
+    }
+
+    SkDynamicMemoryWStream typefaces;
+    {
+        SkAutoTMalloc<SkTypeface*> array(fTypefaces.count());
+        fTypefaces.copyToArray((SkRefCnt**)array.get());
+        for (int i = 0; i < fTypefaces.count(); i++) {
+            array[i]->serialize(&typefaces);
+        }
+        static const char kZeros[4] = { 0, 0, 0, 0 };
+        typefaces.write(kZeros, SkAlign4(typefaces.bytesWritten()) - typefaces.bytesWritten());
+    }
+
+    Header header;
+    header.fMagic         = kMagic;
+    header.fVersion       = kVersion;
+    header.fCount         = fTypes.count();
+    header.fPayloadBytes  = SkToU32(fPayload.bytesWritten());
+    header.fFactoryCount  = fFactories.count();
+    header.fFactoryBytes  = SkToU32(factories.bytesWritten());
+    header.fTypefaceCount = fTypefaces.count();
+    header.fTypefaceBytes = SkToU32(typefaces.bytesWritten());
+    header.fTableBytes    = 0;
+    for (int i = 0; i < kTableCount; i++) {
+        header.fTableCount[i] = fTableCount[i];
+        header.fTableBytes += SkToU32(fTables[i].bytesWritten());
+    }
+
+    SkWriter32 out;
+    out.write(&header, sizeof(header));
+    out.writePad(fTypes.begin(), fTypes.count());
+    out.write(fOffsets.begin(), fOffsets.count() * sizeof(uint32_t));
+    fPayload.flatten(out.reserve(fPayload.bytesWritten()));
+    factories.flatten(out.reserve(factories.bytesWritten()));
+    typefaces.copyTo(out.reserve(typefaces.bytesWritten()));
+    for (int i = 0; i < kTableCount; i++) {
+        fTables[i].flatten(out.reserve(fTables[i].bytesWritten()));
+    }
+    return out.snapshotAsData();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Like SkReader32, but fails gracefully instead of asserting when asked to read past the end.
+class SafeReader {
+public:
+    SafeReader(const void* data, size_t size) : fReader(data, size), fValid(true) {}
+
+    bool isValid() const { return fValid; }
+
+    bool validate(bool ok) {
+        fValid = fValid && ok;
+        return fValid;
+    }
+
+    // Returns a pointer to the next size bytes and moves past them (and any padding),
+    // or NULL if there aren't that many left.
+    const void* skip(size_t size) {
+        if (!this->validate(size <= fReader.available() &&
+                            SkAlign4(size) <= fReader.available())) {
+            return NULL;
+        }
+        return fReader.skip(size);
+    }
+
+    uint32_t readU32() {
+        const void* p = this->skip(sizeof(uint32_t));
+        return p ? *(const uint32_t*)p : 0;
+    }
+
+    int32_t readInt() { return (int32_t)this->readU32(); }
+    bool readBool() { return 0 != this->readU32(); }
+
+    SkScalar readScalar() {
+        const void* p = this->skip(sizeof(SkScalar));
+        return p ? *(const SkScalar*)p : 0;
+    }
+
+    // For plain old data like SkRect and SkIRect.
+    template <typename T>
+    void readPOD(T* dst) {
+        const void* p = this->skip(sizeof(T));
+        if (p) {
+            memcpy(dst, p, sizeof(T));
+        }
+    }
+
+    // For types with readFromMemory(), like SkMatrix, SkRRect, and SkRegion.
+    template <typename T>
+    void readObject(T* dst) {
+        if (!fValid) {
+            return;
+        }
+        const size_t size = dst->readFromMemory(fReader.peek(), fReader.available());
+        if (this->validate(size > 0 && SkIsAlign4(size) && size <= fReader.available())) {
+            fReader.skip(size);
+        }
+    }
+
+    // Reads an array written by Serializer::writeArray, returning a pointer to its elements
+    // inside the data, or NULL if it's empty or invalid.
+    template <typename T>
+    const T* readArray(unsigned* count) {
+        *count = this->readU32();
+        if (!this->validate(*count <= fReader.available() / sizeof(T))) {
+            *count = 0;
+            return NULL;
+        }
+        return (const T*)this->skip(*count * sizeof(T));
+    }
+
+    // Reads a string written by SkWriter32::writeString.
+    const char* readString() {
+        const uint32_t len = this->readU32();
+        if (!this->validate(len < fReader.available())) {
+            return NULL;
+        }
+        const char* str = (const char*)this->skip(len + 1);
+        return this->validate(str && '\0' == str[len]) ? str : NULL;
+    }
+
+private:
+    SkReader32 fReader;
+    bool fValid;
+};
+
+class Deserializer : SkNoncopyable {
+public:
+    explicit Deserializer(SkRecord* record) : fRecord(record), fFactories(NULL) {}
+    ~Deserializer() {
+        SkDELETE(fFactories);
+        fXfermodes.safeUnrefAll();
+    }
+
+    bool read(const void* data, size_t length);
+
+private:
+    bool readFactories(const void* data, const Header&);
+    bool readTypefaces(const void* data, const Header&);
+    bool readTables(const void* data, const Header&);
+    bool readCommand(SkRecords::Type, SafeReader*);
+
+    void setupBuffer(SkReadBuffer* buffer) const {
+        buffer->setFlags(buffer->getFlags() | SkReadBuffer::kCrossProcess_Flag);
+        fFactories->setupBuffer(*buffer);
+        fTypefaces.setupBuffer(*buffer);
+    }
+
+    // Each of these reads an index into a side table, returning the entry it points to.
+    // They return NULL and fail r if the index is out of range, or for optional entries written
+    // as -1 just return NULL.
+    template <typename T>
+    static const T* Lookup(SafeReader* r, const SkTArray<T>& table, bool optional) {
+        const int index = r->readInt();
+        if (optional && -1 == index) {
+            return NULL;
+        }
+        return r->validate(index >= 0 && index < table.count()) ? &table[index] : NULL;
+    }
+    const SkPaint* paint(SafeReader* r) const { return Lookup(r, fPaints, false); }
+    const SkPaint* optionalPaint(SafeReader* r) const { return Lookup(r, fPaints, true); }
+    const SkPath* path(SafeReader* r) const { return Lookup(r, fPaths, false); }
+    const SkBitmap* bitmap(SafeReader* r) const { return Lookup(r, fBitmaps, false); }
+    SkXfermode* xfermode(SafeReader* r) const {
+        const int index = r->readInt();
+        if (-1 == index) {
+            return NULL;
+        }
+        return r->validate(index >= 0 && index < fXfermodes.count()) ? fXfermodes[index] : NULL;
+    }
+
+    SkRegion::Op readOp(SafeReader* r) const {
+        const uint32_t op = r->readU32();
+        r->validate(op <= SkRegion::kReplace_Op);
+        return (SkRegion::Op)op;
+    }
+
+    // Copy optional arguments and arrays into fRecord, as SkRecorder does.
+    template <typename T>
+    T* copy(const T* src) {
+        if (NULL == src) {
+            return NULL;
+        }
+        return SkNEW_PLACEMENT_ARGS(fRecord->alloc<T>(), T, (*src));
+    }
+
+    template <typename T>
+    T* copy(const T src[], unsigned count) {
+        if (NULL == src) {
+            return NULL;
+        }
+        T* dst = fRecord->alloc<T>(count);
+        memcpy(dst, src, count * sizeof(T));
+        return dst;
+    }
+
+    SkRecord* fRecord;
+    SkFactoryPlayback* fFactories;
+    SkTypefacePlayback fTypefaces;
+    SkTArray<SkPaint> fPaints;
+    SkTArray<SkPath> fPaths;
+    SkTArray<SkBitmap> fBitmaps;
+    SkTDArray<SkXfermode*> fXfermodes;
+};
+
+bool Deserializer::read(const void* data, size_t length) {
+    SafeReader reader(data, length);
+
+    Header header;
+    reader.readPOD(&header);
+    if (!reader.isValid() || header.fMagic != kMagic || header.fVersion != kVersion) {
+        return false;
+    }
+
+    if (header.fCount > length / sizeof(uint32_t)) {
+        return false;
+    }
+    const uint8_t* types = (const uint8_t*)reader.skip(header.fCount);
+    const uint32_t* offsets = (const uint32_t*)reader.skip(header.fCount * sizeof(uint32_t));
+    const void* payload   = reader.skip(header.fPayloadBytes);
+    const void* factories = reader.skip(header.fFactoryBytes);
+    const void* typefaces = reader.skip(header.fTypefaceBytes);
+    const void* tables    = reader.skip(header.fTableBytes);
+    if (!reader.isValid()
+            || !SkIsAlign4(header.fPayloadBytes)
+            || !SkIsAlign4(header.fFactoryBytes)
+            || !SkIsAlign4(header.fTypefaceBytes)
+            || !SkIsAlign4(header.fTableBytes)) {
+        return false;
+    }
+
+    if (!this->readFactories(factories, header) ||
+        !this->readTypefaces(typefaces, header) ||
+        !this->readTables(tables, header)) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < header.fCount; i++) {
+        const uint32_t start = offsets[i],
+                       stop  = i+1 < header.fCount ? offsets[i+1] : header.fPayloadBytes;
+        if (types[i] >= kRecordTypeCount
+                || !SkIsAlign4(start)
+                || start > stop
+                || stop > header.fPayloadBytes) {
+            return false;
+        }
+        SafeReader command((const char*)payload + start, stop - start);
+        if (!this->readCommand((SkRecords::Type)types[i], &command)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Deserializer::readFactories(const void* data, const Header& header) {
+    SafeReader reader(data, header.fFactoryBytes);
+    if (!reader.validate(header.fFactoryCount <= header.fFactoryBytes / sizeof(uint32_t))) {
+        return false;
+    }
+    fFactories = SkNEW_ARGS(SkFactoryPlayback, (header.fFactoryCount));
+    for (uint32_t i = 0; i < header.fFactoryCount; i++) {
+        const char* name = reader.readString();
+        // An unknown name leaves a NULL factory, and whatever used it will unflatten as NULL.
+        fFactories->base()[i] = name ? SkFlattenable::NameToFactory(name) : NULL;
+    }
+    return reader.isValid();
+}
+
+bool Deserializer::readTypefaces(const void* data, const Header& header) {
+    if (header.fTypefaceCount > header.fTypefaceBytes) {
+        return false;
+    }
+    SkMemoryStream stream(data, header.fTypefaceBytes, false/*don't copy*/);
+    fTypefaces.setCount(header.fTypefaceCount);
+    for (uint32_t i = 0; i < header.fTypefaceCount; i++) {
+        SkAutoTUnref<SkTypeface> typeface(SkTypeface::Deserialize(&stream));
+        if (NULL == typeface.get()) {
+            // Like SkPicture, fall back to the default typeface rather than fail outright.
+            typeface.reset(SkTypeface::RefDefault());
+        }
+        fTypefaces.set(i, typeface);
+    }
+    return true;
+}
+
+bool Deserializer::readTables(const void* data, const Header& header) {
+    SafeReader reader(data, header.fTableBytes);
+    for (int table = 0; table < kTableCount; table++) {
+        if (!reader.validate(header.fTableCount[table] <= header.fTableBytes / sizeof(uint32_t))) {
+            return false;
+        }
+        for (uint32_t i = 0; i < header.fTableCount[table]; i++) {
+            const uint32_t size = reader.readU32();
+            const void* bytes = reader.skip(size);
+            if (!reader.validate(NULL != bytes && SkIsAlign4(size))) {
+                return false;
+            }
+
+            SkReadBuffer buffer(bytes, size);
+            this->setupBuffer(&buffer);
+            switch (table) {
+                case kPaint_Table:
+                    buffer.readPaint(&fPaints.push_back());
+                    break;
+                case kPath_Table:
+                    buffer.readPath(&fPaths.push_back());
+                    break;
+                case kBitmap_Table: {
+                    SkBitmap* bitmap = &fBitmaps.push_back();
+                    buffer.readBitmap(bitmap);
+                    // Keeps SkRecords::ImmutableBitmap from copying the pixels for each command.
+                    bitmap->setImmutable();
+                } break;
+                case kXfermode_Table:
+                    *fXfermodes.append() = buffer.readXfermode();
+                    break;
+            }
+        }
+    }
+    return true;
+}
+
+// Playback indexes the vertex arrays with these unchecked.
+static bool indices_in_range(const uint16_t indices[], unsigned indexCount, unsigned vertexCount) {
+    for (unsigned i = 0; i < indexCount; i++) {
+        if (indices[i] >= vertexCount) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// To make appending to fRecord a little less verbose.
+#define APPEND(T, ...) \
+        SkNEW_PLACEMENT_ARGS(fRecord->append<SkRecords::T>(), SkRecords::T, (__VA_ARGS__))
+
+bool Deserializer::readCommand(SkRecords::Type type, SafeReader* r) {
+    // Each case reads and validates all its arguments before appending anything to fRecord.
+    switch (type) {
+        case SkRecords::NoOp_Type:    APPEND(NoOp);    return true;
+        case SkRecords::Restore_Type: APPEND(Restore); return true;
+        case SkRecords::PopCull_Type: APPEND(PopCull); return true;
+
+        case SkRecords::Save_Type: {
+            const SkCanvas::SaveFlags flags = (SkCanvas::SaveFlags)r->readU32();
+            if (!r->isValid()) { return false; }
+            APPEND(Save, flags);
+        } return true;
+
+        case SkRecords::SaveLayer_Type: {
+            SkRect bounds;
+            const bool hasBounds = r->readBool();
+            if (hasBounds) { r->readPOD(&bounds); }
+            const SkPaint* paint = this->optionalPaint(r);
+            const SkCanvas::SaveFlags flags = (SkCanvas::SaveFlags)r->readU32();
+            if (!r->isValid()) { return false; }
+            APPEND(SaveLayer, this->copy(hasBounds ? &bounds : NULL), this->copy(paint), flags);
+        } return true;
+
+        case SkRecords::PushCull_Type: {
+            SkRect rect;
+            r->readPOD(&rect);
+            if (!r->isValid()) { return false; }
+            APPEND(PushCull, rect);
+        } return true;
+
+        case SkRecords::PairedPushCull_Type: {
+            SkRect rect;
+            r->readPOD(&rect);
+            const unsigned skip = r->readU32();
+            if (!r->isValid()) { return false; }
+            SkRecords::PushCull* base =
+                SkNEW_PLACEMENT_ARGS(fRecord->alloc<SkRecords::PushCull>(),
+                                     SkRecords::PushCull, (rect));
+            APPEND(PairedPushCull, base, skip);
+        } return true;
+
+        case SkRecords::Concat_Type:
+        case SkRecords::SetMatrix_Type: {
+            SkMatrix matrix;
+            r->readObject(&matrix);
+            if (!r->isValid()) { return false; }
+            if (SkRecords::Concat_Type == type) {
+                APPEND(Concat, matrix);
+            } else {
+                APPEND(SetMatrix, matrix);
+            }
+        } return true;
+
+        case SkRecords::ClipPath_Type: {
+            const SkPath* path = this->path(r);
+            const SkRegion::Op op = this->readOp(r);
+            const bool doAA = r->readBool();
+            if (!r->isValid()) { return false; }
+            APPEND(ClipPath, *path, op, doAA);
+        } return true;
+
+        case SkRecords::ClipRRect_Type: {
+            SkRRect rrect;
+            r->readObject(&rrect);
+            const SkRegion::Op op = this->readOp(r);
+            const bool doAA = r->readBool();
+            if (!r->isValid()) { return false; }
+            APPEND(ClipRRect, rrect, op, doAA);
+        } return true;
+
+        case SkRecords::ClipRect_Type: {
+            SkRect rect;
+            r->readPOD(&rect);
+            const SkRegion::Op op = this->readOp(r);
+            const bool doAA = r->readBool();
+            if (!r->isValid()) { return false; }
+            APPEND(ClipRect, rect, op, doAA);
+        } return true;
+
+        case SkRecords::ClipRegion_Type: {
+            SkRegion region;
+            r->readObject(&region);
+            const SkRegion::Op op = this->readOp(r);
+            if (!r->isValid()) { return false; }
+            APPEND(ClipRegion, region, op);
+        } return true;
+
+        case SkRecords::Clear_Type: {
+            const SkColor color = r->readU32();
+            if (!r->isValid()) { return false; }
+            APPEND(Clear, color);
+        } return true;
+
+        case SkRecords::DrawBitmap_Type: {
+            const SkPaint* paint = this->optionalPaint(r);
+            const SkBitmap* bitmap = this->bitmap(r);
+            const SkScalar left = r->readScalar(),
+                           top  = r->readScalar();
+            if (!r->isValid()) { return false; }
+            APPEND(DrawBitmap, this->copy(paint), *bitmap, left, top);
+        } return true;
+
+        case SkRecords::DrawBitmapMatrix_Type: {
+            const SkPaint* paint = this->optionalPaint(r);
+            const SkBitmap* bitmap = this->bitmap(r);
+            SkMatrix matrix;
+            r->readObject(&matrix);
+            if (!r->isValid()) { return false; }
+            APPEND(DrawBitmapMatrix, this->copy(paint), *bitmap, matrix);
+        } return true;
+
+        case SkRecords::DrawBitmapNine_Type: {
+            const SkPaint* paint = this->optionalPaint(r);
+            const SkBitmap* bitmap = this->bitmap(r);
+            SkIRect center;
+            SkRect dst;
+            r->readPOD(&center);
+            r->readPOD(&dst);
+            if (!r->isValid()) { return false; }
+            APPEND(DrawBitmapNine, this->copy(paint), *bitmap, center, dst);
+        } return true;
+
+        case SkRecords::DrawBitmapRectToRect_Type:
+        case SkRecords::DrawBitmapRectBatch_Type: {
+            const SkPaint* paint = this->optionalPaint(r);
+            const SkBitmap* bitmap = this->bitmap(r);
+            SkRect src, dst;
+            const bool hasSrc = r->readBool();
+            if (hasSrc) { r->readPOD(&src); }
+            r->readPOD(&dst);
+            const SkCanvas::DrawBitmapRectFlags flags = (SkCanvas::DrawBitmapRectFlags)r->readU32();
+            if (SkRecords::DrawBitmapRectToRect_Type == type) {
+                if (!r->isValid()) { return false; }
+                APPEND(DrawBitmapRectToRect,
+                       this->copy(paint), *bitmap, this->copy(hasSrc ? &src : NULL), dst, flags);
+                return true;
+            }
+            unsigned srcCount = 0, count;
+            const SkRect* srcs = hasSrc ? r->readArray<SkRect>(&srcCount) : NULL;
+            const SkRect* dsts = r->readArray<SkRect>(&count);
+            SkRect bounds;
+            r->readPOD(&bounds);
+            if (!r->isValid() || !r->validate(count > 0 && (!hasSrc || srcCount == count))) {
+                return false;
+            }
+            SkRecords::DrawBitmapRectToRect* base =
+                SkNEW_PLACEMENT_ARGS(fRecord->alloc<SkRecords::DrawBitmapRectToRect>(),
+                                     SkRecords::DrawBitmapRectToRect,
+                                     (this->copy(paint), *bitmap,
+                                      this->copy(hasSrc ? &src : NULL), dst, flags));
+            APPEND(DrawBitmapRectBatch,
+                   base, this->copy(srcs, count), this->copy(dsts, count), count, bounds);
+        } return true;
+
+        case SkRecords::DrawDRRect_Type: {
+            const SkPaint* paint = this->paint(r);
+            SkRRect outer, inner;
+            r->readObject(&outer);
+            r->readObject(&inner);
+            if (!r->isValid()) { return false; }
+            APPEND(DrawDRRect, *paint, outer, inner);
+        } return true;
+
+        case SkRecords::DrawOval_Type: {
+            const SkPaint* paint = this->paint(r);
+            SkRect oval;
+            r->readPOD(&oval);
+            if (!r->isValid()) { return false; }
+            APPEND(DrawOval, *paint, oval);
+        } return true;
+
+        case SkRecords::DrawPaint_Type: {
+            const SkPaint* paint = this->paint(r);
+            if (!r->isValid()) { return false; }
+            APPEND(DrawPaint, *paint);
+        } return true;
+
+        case SkRecords::DrawPath_Type: {
+            const SkPaint* paint = this->paint(r);
+            const SkPath* path = this->path(r);
+            if (!r->isValid()) { return false; }
+            APPEND(DrawPath, *paint, *path);
+        } return true;
+
+        case SkRecords::DrawPoints_Type: {
+            const SkPaint* paint = this->paint(r);
+            const SkCanvas::PointMode mode = (SkCanvas::PointMode)r->readU32();
+            unsigned count;
+            const SkPoint* pts = r->readArray<SkPoint>(&count);
+            if (!r->validate(mode <= SkCanvas::kPolygon_PointMode)) { return false; }
+            APPEND(DrawPoints, *paint, mode, count, this->copy(pts, count));
+        } return true;
+
+        case SkRecords::DrawPosText_Type: {
+            const SkPaint* paint = this->paint(r);
+            unsigned byteLength, points;
+            const char* text = r->readArray<char>(&byteLength);
+            const SkPoint* pos = r->readArray<SkPoint>(&points);
+            // Playback reads one position per glyph, whatever the array we were given.
+            if (!r->isValid() || !r->validate((int)points == paint->countText(text, byteLength))) {
+                return false;
+            }
+            APPEND(DrawPosText,
+                   *paint, this->copy(text, byteLength), byteLength, this->copy(pos, points));
+        } return true;
+
+        case SkRecords::DrawPosTextH_Type:
+        case SkRecords::BoundedDrawPosTextH_Type: {
+            const SkPaint* paint = this->paint(r);
+            unsigned byteLength, points;
+            const char* text = r->readArray<char>(&byteLength);
+            const SkScalar* xpos = r->readArray<SkScalar>(&points);
+            const SkScalar y = r->readScalar();
+            SkScalar minY = 0, maxY = 0;
+            if (SkRecords::BoundedDrawPosTextH_Type == type) {
+                minY = r->readScalar();
+                maxY = r->readScalar();
+            }
+            if (!r->isValid() || !r->validate((int)points == paint->countText(text, byteLength))) {
+                return false;
+            }
+            if (SkRecords::DrawPosTextH_Type == type) {
+                APPEND(DrawPosTextH,
+                       *paint, this->copy(text, byteLength), byteLength,
+                       this->copy(xpos, points), y);
+            } else {
+                SkRecords::DrawPosTextH* base =
+                    SkNEW_PLACEMENT_ARGS(fRecord->alloc<SkRecords::DrawPosTextH>(),
+                                         SkRecords::DrawPosTextH,
+                                         (*paint, this->copy(text, byteLength), byteLength,
+                                          this->copy(xpos, points), y));
+                APPEND(BoundedDrawPosTextH, base, minY, maxY);
+            }
+        } return true;
+
+        case SkRecords::DrawRRect_Type: {
+            const SkPaint* paint = this->paint(r);
+            SkRRect rrect;
+            r->readObject(&rrect);
+            if (!r->isValid()) { return false; }
+            APPEND(DrawRRect, *paint, rrect);
+        } return true;
+
+        case SkRecords::DrawRect_Type: {
+            const SkPaint* paint = this->paint(r);
+            SkRect rect;
+            r->readPOD(&rect);
+            if (!r->isValid()) { return false; }
+            APPEND(DrawRect, *paint, rect);
+        } return true;
+
+        case SkRecords::DrawRectBatch_Type: {
+            const SkPaint* paint = this->paint(r);
+            unsigned count;
+            const SkRect* rects = r->readArray<SkRect>(&count);
+            SkRect bounds;
+            r->readPOD(&bounds);
+            if (!r->isValid()) { return false; }
+            APPEND(DrawRectBatch, *paint, this->copy(rects, count), count, bounds);
+        } return true;
+
+        case SkRecords::DrawSprite_Type: {
+            const SkPaint* paint = this->optionalPaint(r);
+            const SkBitmap* bitmap = this->bitmap(r);
+            const int left = r->readInt(),
+                      top  = r->readInt();
+            if (!r->isValid()) { return false; }
+            APPEND(DrawSprite, this->copy(paint), *bitmap, left, top);
+        } return true;
+
+        case SkRecords::DrawText_Type: {
+            const SkPaint* paint = this->paint(r);
+            unsigned byteLength;
+            const char* text = r->readArray<char>(&byteLength);
+            const SkScalar x = r->readScalar(),
+                           y = r->readScalar();
+            if (!r->isValid()) { return false; }
+            APPEND(DrawText, *paint, this->copy(text, byteLength), byteLength, x, y);
+        } return true;
+
+        case SkRecords::DrawTextOnPath_Type: {
+            const SkPaint* paint = this->paint(r);
+            unsigned byteLength;
+            const char* text = r->readArray<char>(&byteLength);
+            const SkPath* path = this->path(r);
+            SkMatrix matrix;
+            const bool hasMatrix = r->readBool();
+            if (hasMatrix) { r->readObject(&matrix); }
+            if (!r->isValid()) { return false; }
+            APPEND(DrawTextOnPath, *paint, this->copy(text, byteLength), byteLength, *path,
+                                   this->copy(hasMatrix ? &matrix : NULL));
+        } return true;
+
+        case SkRecords::DrawVertices_Type: {
+            const SkPaint* paint = this->paint(r);
+            const SkCanvas::VertexMode vmode = (SkCanvas::VertexMode)r->readU32();
+            unsigned vertexCount, texCount = 0, colorCount = 0, indexCount;
+            const SkPoint* vertices = r->readArray<SkPoint>(&vertexCount);
+            const SkPoint* texs = r->readBool() ? r->readArray<SkPoint>(&texCount) : NULL;
+            const SkColor* colors = r->readBool() ? r->readArray<SkColor>(&colorCount) : NULL;
+            SkXfermode* xmode = this->xfermode(r);
+            const uint16_t* indices = r->readArray<uint16_t>(&indexCount);
+            if (!r->validate(vmode <= SkCanvas::kTriangleFan_VertexMode
+                             && (NULL == texs || texCount == vertexCount)
+                             && (NULL == colors || colorCount == vertexCount)
+                             && indices_in_range(indices, indexCount, vertexCount))) {
+                return false;
+            }
+            APPEND(DrawVertices, *paint, vmode, vertexCount,
+                                 this->copy(vertices, vertexCount),
+                                 this->copy(texs, texCount),
+                                 this->copy(colors, colorCount),
+                                 xmode,
+                                 this->copy(indices, indexCount),
+                                 indexCount);
+        } return true;
+    }
+    return false;
+}
+
+#undef APPEND
+
+}  // namespace
+
+SkData* SkRecordSerialize(const SkRecord& record) {
+    Serializer serializer;
+    for (unsigned i = 0; i < record.count(); i++) {
+        record.visit<void>(i, serializer);
+    }
+    return serializer.finish();
+}
+
+bool SkRecordDeserialize(const void* data, size_t length, SkRecord* record) {
+    SkASSERT(NULL != record);
+    if (NULL == data) {
+        return false;
+    }
+    // Everything inside is 4-byte aligned, relative to the start.  If the start isn't, make it so.
+    SkAutoMalloc aligned;
+    if (!SkIsAlign4((intptr_t)data)) {
+        data = memcpy(aligned.reset(length), data, length);
+    }
+    // A well formed blob is a multiple of 4 bytes long.  Anything past that is truncated data.
+    Deserializer deserializer(record);
+    return deserializer.read(data, length & ~(size_t)3);
+}
@@ -0,0 +1,28 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkRecordSerialize_DEFINED
+#define SkRecordSerialize_DEFINED
+
+#include "SkRecord.h"
+
+class SkData;
+
+// Serialize an SkRecord into a compact, versioned blob suitable for shipping to another process.
+//
+// The blob is laid out so a reader can map it and find any command without parsing the others:
+// a header, then a packed array of command types, a parallel array of 4-byte offsets into an
+// aligned payload section holding each command's fixed-size arguments, and finally side tables.
+// Paints, paths, and bitmaps are deduplicated into those side tables and referenced by index.
+SkData* SkRecordSerialize(const SkRecord&);
+
+// Append the commands serialized in data to record, which is normally empty.
+// Returns false if data is truncated, malformed, or from an incompatible version.  On failure
+// record may hold some prefix of the serialized commands.
+bool SkRecordDeserialize(const void* data, size_t length, SkRecord*);
+
+#endif//SkRecordSerialize_DEFINED
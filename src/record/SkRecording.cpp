@@ -7,32 +7,60 @@
 
 #include "SkRecording.h"
 
+#include "SkBBHFactory.h"
+#include "SkBBoxHierarchy.h"
 #include "SkRecord.h"
 #include "SkRecordOpts.h"
 #include "SkRecordDraw.h"
+#include "SkRecordSerialize.h"
 #include "SkRecorder.h"
 
 namespace EXPERIMENTAL {
 
-SkPlayback::SkPlayback(const SkRecord* record) : fRecord(record) {}
+SkPlayback::SkPlayback(const SkRecord* record, SkBBoxHierarchy* bbh)
+    : fRecord(record), fBBH(SkSafeRef(bbh)) {}
 
 SkPlayback::~SkPlayback() {}
 
 void SkPlayback::draw(SkCanvas* canvas) const {
     SkASSERT(fRecord.get() != NULL);
-    SkRecordDraw(*fRecord, canvas);
+    SkRecordDraw(*fRecord, canvas, fBBH.get());
 }
 
-SkRecording::SkRecording(int width, int height)
+void SkPlayback::drawTiled(const SkBitmap& dst,
+                           int tileWidth, int tileHeight, int threadCount) const {
+    SkASSERT(fRecord.get() != NULL);
+    SkRecordDrawTiled(*fRecord, fBBH.get(), dst, tileWidth, tileHeight, threadCount);
+}
+
+SkData* SkPlayback::serialize() const {
+    SkASSERT(fRecord.get() != NULL);
+    return SkRecordSerialize(*fRecord);
+}
+
+SkPlayback* SkPlayback::Deserialize(const void* data, size_t length) {
+    SkAutoTDelete<SkRecord> record(SkNEW(SkRecord));
+    if (!SkRecordDeserialize(data, length, record.get())) {
+        return NULL;
+    }
+    return SkNEW_ARGS(SkPlayback, (record.detach(), NULL));
+}
+
+SkRecording::SkRecording(int width, int height, SkBBHFactory* bbhFactory)
     : fRecord(SkNEW(SkRecord))
     , fRecorder(SkNEW_ARGS(SkRecorder, (fRecord.get(), width, height)))
+    , fBBH(bbhFactory ? (*bbhFactory)(width, height) : NULL)
     {}
 
 SkPlayback* SkRecording::releasePlayback() {
     SkASSERT(fRecorder->unique());
     fRecorder->forgetRecord();
     SkRecordOptimize(fRecord.get());
-    return SkNEW_ARGS(SkPlayback, (fRecord.detach()));
+    if (fBBH.get()) {
+        // Bounds must be computed after optimization, which may rewrite commands.
+        SkRecordFillBounds(*fRecord, fBBH.get());
+    }
+    return SkNEW_ARGS(SkPlayback, (fRecord.detach(), fBBH.get()));
 }
 
 SkRecording::~SkRecording() {}
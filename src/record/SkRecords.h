@@ -54,7 +54,9 @@ namespace SkRecords {
     M(DrawText)                                                     \
     M(DrawTextOnPath)                                               \
     M(DrawVertices)                                                 \
-    M(BoundedDrawPosTextH)    /*From SkRecordBoundDrawPosTextH*/
+    M(BoundedDrawPosTextH)    /*From SkRecordBoundDrawPosTextH*/    \
+    M(DrawRectBatch)          /*From SkRecordBatchDrawRects*/   \
+    M(DrawBitmapRectBatch)    /*From SkRecordBatchDrawRects*/
 
 // Defines SkRecords::Type, an enum of all record types.
 #define ENUM(T) T##_Type,
@@ -278,6 +280,15 @@ struct DrawVertices {
 // Records added by optimizations.
 RECORD2(PairedPushCull, Adopted<PushCull>, base, unsigned, skip);
 RECORD3(BoundedDrawPosTextH, Adopted<DrawPosTextH>, base, SkScalar, minY, SkScalar, maxY);
+// Draws count rects in order with the same paint.  bounds is the union of rects, before the paint.
+RECORD4(DrawRectBatch, SkPaint, paint, PODArray<SkRect>, rects, unsigned, count, SkRect, bounds);
+// Draws base's bitmap count times in order, from srcs[i] (or all of it if srcs is NULL) to dsts[i],
+// with base's paint and flags.  bounds is the union of dsts, before the paint.
+RECORD5(DrawBitmapRectBatch, Adopted<DrawBitmapRectToRect>, base,
+                             PODArray<SkRect>, srcs,
+                             PODArray<SkRect>, dsts,
+                             unsigned, count,
+                             SkRect, bounds);
 
 #undef RECORD0
 #undef RECORD1
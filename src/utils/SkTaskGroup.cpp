@@ -0,0 +1,215 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkTaskGroup.h"
+
+#include "SkDeque.h"
+#include "SkThread.h"
+#include "SkThreadPool.h"  // num_cores()
+#include "SkThreadUtils.h"
+#include "SkTLS.h"
+
+struct SkTaskScheduler::Work {
+    SkRunnable* fRunnable;  // Unowned.
+    int32_t*    fPending;   // Decremented once fRunnable has run.
+};
+
+struct SkTaskScheduler::Deque {
+    Deque() : fScheduler(NULL), fIndex(0), fWork(sizeof(Work), kWorkPerBlock) {}
+
+    SkTaskScheduler* fScheduler;
+    int              fIndex;
+    SkMutex          fMutex;  // Protects fWork.
+    SkDeque          fWork;   // Owner pushes and pops at the back, thieves pop from the front.
+
+    static const int kWorkPerBlock = 32;
+};
+
+namespace {
+
+// Records which SkTaskScheduler (if any) the current thread belongs to, and which Deque is its own.
+struct WorkerSlot {
+    WorkerSlot() : fScheduler(NULL), fIndex(0) {}
+    const SkTaskScheduler* fScheduler;
+    int fIndex;
+};
+
+void* create_worker_slot() { return SkNEW(WorkerSlot); }
+void delete_worker_slot(void* slot) { SkDELETE((WorkerSlot*)slot); }
+
+}  // namespace
+
+SkTaskScheduler::SkTaskScheduler(int count) : fQueued(0), fSleepers(0), fStopping(false) {
+    if (count < 0) {
+        count = num_cores();
+    }
+    fDeques = SkNEW_ARRAY(Deque, count + 1);
+    for (int i = 0; i <= count; i++) {
+        fDeques[i].fScheduler = this;
+        fDeques[i].fIndex = i;
+    }
+    // Create count threads, all running SkTaskScheduler::Loop, each with its own Deque.
+    for (int i = 0; i < count; i++) {
+        SkThread* thread = SkNEW_ARGS(SkThread, (&SkTaskScheduler::Loop, &fDeques[i]));
+        *fThreads.append() = thread;
+        thread->start();
+    }
+}
+
+SkTaskScheduler::~SkTaskScheduler() {
+    fReady.lock();
+    fStopping = true;
+    fReady.broadcast();
+    fReady.unlock();
+
+    // Threads drain all queued work before they notice they should stop.
+    for (int i = 0; i < fThreads.count(); i++) {
+        fThreads[i]->join();
+        SkDELETE(fThreads[i]);
+    }
+    SkASSERT(0 == fQueued);
+    SkDELETE_ARRAY(fDeques);
+}
+
+int SkTaskScheduler::currentDeque() const {
+    const WorkerSlot* slot = (const WorkerSlot*)SkTLS::Find(create_worker_slot);
+    if (NULL != slot && this == slot->fScheduler) {
+        return slot->fIndex;
+    }
+    return fThreads.count();
+}
+
+void SkTaskScheduler::add(SkRunnable* r, int32_t* pending) {
+    Deque& deque = fDeques[this->currentDeque()];
+    {
+        SkAutoMutexAcquire lock(deque.fMutex);
+        Work* work = (Work*)deque.fWork.push_back();
+        work->fRunnable = r;
+        work->fPending = pending;
+    }
+
+    // sk_atomic_inc is a full barrier, so either we see a sleeper here and wake it,
+    // or it will see fQueued > 0 before it goes to sleep.  (See sleep() for the other side.)
+    sk_atomic_inc(&fQueued);
+    if (sk_acquire_load(&fSleepers) > 0) {
+        fReady.lock();
+        fReady.signal();
+        fReady.unlock();
+    }
+}
+
+bool SkTaskScheduler::tryRunOne(int self) {
+    const int deques = fThreads.count() + 1;
+    Work work;
+    bool found = false;
+
+    // Our own work first, newest first; it's most likely to still be in cache.
+    // (Threads outside the scheduler share the last deque, which everyone treats as a victim.)
+    if (self < fThreads.count()) {
+        Deque& mine = fDeques[self];
+        SkAutoMutexAcquire lock(mine.fMutex);
+        if (!mine.fWork.empty()) {
+            work = *(const Work*)mine.fWork.back();
+            mine.fWork.pop_back();
+            found = true;
+        }
+    }
+
+    // Otherwise steal the oldest work from someone else, starting with our neighbor.
+    for (int i = 1; !found && i <= deques; i++) {
+        Deque& victim = fDeques[(self + i) % deques];
+        if (victim.fIndex == self && self < fThreads.count()) {
+            continue;  // Already looked there.
+        }
+        SkAutoMutexAcquire lock(victim.fMutex);
+        if (!victim.fWork.empty()) {
+            work = *(const Work*)victim.fWork.front();
+            victim.fWork.pop_front();
+            found = true;
+        }
+    }
+
+    if (!found) {
+        return false;
+    }
+    sk_atomic_dec(&fQueued);
+
+    work.fRunnable->run();  // This may delete the runnable, so don't touch it after.
+
+    // If that finished a group, wake anyone who might be waiting on it.
+    // Like in add(), the full barrier pairs with the one in sleep().
+    if (1 == sk_atomic_dec(work.fPending) && sk_acquire_load(&fSleepers) > 0) {
+        fReady.lock();
+        fReady.broadcast();
+        fReady.unlock();
+    }
+    return true;
+}
+
+bool SkTaskScheduler::sleep(const int32_t* pending) {
+    fReady.lock();
+    sk_atomic_inc(&fSleepers);
+    while (0 == sk_acquire_load(&fQueued)) {
+        if (NULL == pending ? fStopping : 0 == sk_acquire_load(pending)) {
+            break;
+        }
+        // wait yields the lock while waiting, but will have it again when awoken.
+        fReady.wait();
+    }
+    sk_atomic_dec(&fSleepers);
+    const bool stop = NULL == pending && fStopping && 0 == sk_acquire_load(&fQueued);
+    fReady.unlock();
+    return stop;
+}
+
+void SkTaskScheduler::wait(int32_t* pending) {
+    const int self = this->currentDeque();
+    while (sk_acquire_load(pending) > 0) {
+        // Help out while we wait.  The work we run may well be our own group's.
+        if (!this->tryRunOne(self)) {
+            this->sleep(pending);
+        }
+    }
+}
+
+/*static*/ void SkTaskScheduler::Loop(void* arg) {
+    Deque* mine = static_cast<Deque*>(arg);
+    SkTaskScheduler* scheduler = mine->fScheduler;
+
+    WorkerSlot* slot = (WorkerSlot*)SkTLS::Get(create_worker_slot, delete_worker_slot);
+    slot->fScheduler = scheduler;
+    slot->fIndex = mine->fIndex;
+
+    while (true) {
+        if (!scheduler->tryRunOne(mine->fIndex) && scheduler->sleep(NULL)) {
+            break;
+        }
+    }
+    slot->fScheduler = NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+SkTaskGroup::SkTaskGroup(SkTaskScheduler* scheduler) : fScheduler(scheduler), fPending(0) {}
+
+void SkTaskGroup::add(SkRunnable* r) {
+    if (NULL == r) {
+        return;
+    }
+    if (NULL == fScheduler || 0 == fScheduler->threadCount()) {
+        r->run();
+        return;
+    }
+    sk_atomic_inc(&fPending);
+    fScheduler->add(r, &fPending);
+}
+
+void SkTaskGroup::wait() {
+    if (NULL != fScheduler) {
+        fScheduler->wait(&fPending);
+    }
+}
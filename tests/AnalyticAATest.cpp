@@ -0,0 +1,210 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBitmap.h"
+#include "SkBlitter.h"
+#include "SkPaint.h"
+#include "SkPath.h"
+#include "SkRasterClip.h"
+#include "SkScan.h"
+#include "Test.h"
+
+static const int kW = 64, kH = 64;
+
+// Fill path into a fresh A8 bitmap with the given scan converter.
+static void fill(const SkPath& path, SkScan::AAType type, const SkRegion& clip, SkBitmap* bm) {
+    bm->allocPixels(SkImageInfo::MakeA8(kW, kH));
+    bm->eraseColor(SK_ColorTRANSPARENT);
+
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    SkTBlitterAllocator allocator;
+    SkBlitter* blitter = SkBlitter::Choose(*bm, SkMatrix::I(), paint, &allocator);
+
+    SkRasterClip rc(clip.getBounds());
+    rc.op(clip, SkRegion::kIntersect_Op);
+    SkScan::AntiFillPath(path, rc, blitter, type);
+}
+
+static void fill(const SkPath& path, SkScan::AAType type, SkBitmap* bm) {
+    fill(path, type, SkRegion(SkIRect::MakeWH(kW, kH)), bm);
+}
+
+static int coverage(const SkBitmap& bm, int x, int y) {
+    return *bm.getAddr8(x, y);
+}
+
+static int total_coverage(const SkBitmap& bm) {
+    int sum = 0;
+    for (int y = 0; y < kH; ++y) {
+        for (int x = 0; x < kW; ++x) {
+            sum += coverage(bm, x, y);
+        }
+    }
+    return sum;
+}
+
+// Returns the largest per-pixel difference between a and b (inside clip, if given),
+// and the total difference in coverage through sumDiff.
+static int max_diff(const SkBitmap& a, const SkBitmap& b, int* sumDiff,
+                    const SkRegion* clip = NULL) {
+    int maxDiff = 0;
+    *sumDiff = 0;
+    for (int y = 0; y < kH; ++y) {
+        for (int x = 0; x < kW; ++x) {
+            int ca = coverage(a, x, y),
+                cb = coverage(b, x, y);
+            if (clip && !clip->contains(x, y)) {
+                cb = 0;
+            }
+            *sumDiff += ca - cb;
+            maxDiff = SkTMax(maxDiff, SkAbs32(ca - cb));
+        }
+    }
+    return maxDiff;
+}
+
+DEF_TEST(AnalyticAA_Exact, reporter) {
+    // Not a rect as far as SkScan is concerned; it just walks the edges.
+    SkPath path;
+    path.moveTo(1.5f, 1.25f);
+    path.lineTo(5.25f, 1.25f);
+    path.lineTo(5.25f, 3);
+    path.lineTo(1.5f, 3);
+    path.close();
+
+    SkBitmap bm;
+    fill(path, SkScan::kAnalytic_AAType, &bm);
+
+    REPORTER_ASSERT(reporter,   0 == coverage(bm, 0, 1));
+    REPORTER_ASSERT(reporter,  96 == coverage(bm, 1, 1));  // 1/2 x 3/4
+    REPORTER_ASSERT(reporter, 191 == coverage(bm, 2, 1));  //   1 x 3/4
+    REPORTER_ASSERT(reporter,  48 == coverage(bm, 5, 1));  // 1/4 x 3/4
+    REPORTER_ASSERT(reporter, 128 == coverage(bm, 1, 2));  // 1/2 x   1
+    REPORTER_ASSERT(reporter, 255 == coverage(bm, 3, 2));
+    REPORTER_ASSERT(reporter,  64 == coverage(bm, 5, 2));  // 1/4 x   1
+    REPORTER_ASSERT(reporter,   0 == coverage(bm, 6, 2));
+    REPORTER_ASSERT(reporter,   0 == coverage(bm, 3, 3));
+
+    // A diagonal through a single pixel covers half of it.
+    path.reset();
+    path.moveTo(10, 10);
+    path.lineTo(11, 10);
+    path.lineTo(11, 11);
+    path.close();
+    fill(path, SkScan::kAnalytic_AAType, &bm);
+    REPORTER_ASSERT(reporter, 128 == coverage(bm, 10, 10));
+    REPORTER_ASSERT(reporter,   0 == coverage(bm, 9, 10));
+    REPORTER_ASSERT(reporter,   0 == coverage(bm, 11, 10));
+}
+
+static void make_paths(SkTArray<SkPath>* paths) {
+    paths->push_back().addCircle(30.3f, 31.7f, 20.2f);
+    paths->push_back().addOval(SkRect::MakeLTRB(-10.5f, 5.25f, 40.1f, 70.9f));
+    paths->push_back().addRoundRect(SkRect::MakeLTRB(3.3f, 4.4f, 60.6f, 50.5f), 9, 13);
+
+    SkPath& tri = paths->push_back();
+    tri.moveTo(2.1f, 60.3f);
+    tri.lineTo(33.3f, 1.7f);
+    tri.lineTo(70.2f, 48.8f);
+    tri.close();
+
+    // Self-intersecting, with overlapping winding.
+    SkPath& star = paths->push_back();
+    star.moveTo(32, 2);
+    for (int i = 1; i < 5; ++i) {
+        SkScalar angle = SK_ScalarPI * 4 * i / 5;
+        star.lineTo(32 + 28 * sk_float_sin(angle), 32 - 28 * sk_float_cos(angle));
+    }
+    star.close();
+
+    SkPath& curvy = paths->push_back();
+    curvy.moveTo(5, 5);
+    curvy.cubicTo(80, 10, -20, 40, 55, 60);
+    curvy.quadTo(20, 70, 8, 50);
+    curvy.conicTo(-4, 30, 5, 5, 0.7f);
+    curvy.close();
+}
+
+DEF_TEST(AnalyticAA_MatchesSupersample, reporter) {
+    SkTArray<SkPath> paths;
+    make_paths(&paths);
+
+    for (int i = 0; i < paths.count(); ++i) {
+        // The supersampler flattens conics to within about two pixels, too coarse to compare.
+        if (paths[i].getSegmentMasks() & SkPath::kConic_SegmentMask) {
+            continue;
+        }
+        SkBitmap analytic, supersampled;
+        fill(paths[i], SkScan::kAnalytic_AAType, &analytic);
+        fill(paths[i], SkScan::kSupersample_AAType, &supersampled);
+
+        // Supersampling quantizes coverage to 1/16ths, and each flattens curves differently,
+        // so allow a quarter pixel's difference anywhere and 1% overall.
+        int sumDiff;
+        int maxDiff = max_diff(analytic, supersampled, &sumDiff);
+        REPORTER_ASSERT_MESSAGE(reporter, maxDiff <= 64, "path differs too much");
+        REPORTER_ASSERT_MESSAGE(reporter, SkAbs32(sumDiff) <= total_coverage(supersampled) / 100,
+                                "total coverage differs");
+    }
+}
+
+DEF_TEST(AnalyticAA_Area, reporter) {
+    // Total coverage should match the true area closely, curves included.
+    const SkScalar r = 20.2f;
+    SkPath circle;
+    circle.addCircle(30.3f, 31.7f, r);
+
+    SkBitmap bm;
+    fill(circle, SkScan::kAnalytic_AAType, &bm);
+    const float area = total_coverage(bm) / 255.0f;
+    REPORTER_ASSERT(reporter, sk_float_abs(area - SK_ScalarPI * r * r) < 1.0f);
+}
+
+DEF_TEST(AnalyticAA_Clip, reporter) {
+    SkTArray<SkPath> paths;
+    make_paths(&paths);
+
+    // A rect clip cutting through the middle, and a complex clip.
+    SkRegion clips[2];
+    clips[0].setRect(SkIRect::MakeLTRB(13, 9, 41, 50));
+    clips[1].setRect(SkIRect::MakeLTRB(0, 0, 20, 30));
+    clips[1].op(SkIRect::MakeLTRB(30, 25, 64, 64), SkRegion::kUnion_Op);
+
+    for (int i = 0; i < paths.count(); ++i) {
+        SkBitmap unclipped;
+        fill(paths[i], SkScan::kAnalytic_AAType, &unclipped);
+        for (int j = 0; j < (int)SK_ARRAY_COUNT(clips); ++j) {
+            SkBitmap clipped;
+            fill(paths[i], SkScan::kAnalytic_AAType, clips[j], &clipped);
+
+            // Splitting lines at the clip may round a little differently.
+            int sumDiff;
+            int maxDiff = max_diff(clipped, unclipped, &sumDiff, &clips[j]);
+            REPORTER_ASSERT_MESSAGE(reporter, maxDiff <= 1, "clipping changed coverage");
+        }
+    }
+}
+
+DEF_TEST(AnalyticAA_Fallback, reporter) {
+    SkTArray<SkPath> paths;
+    make_paths(&paths);
+
+    for (int i = 0; i < paths.count(); ++i) {
+        SkPath path = paths[i];
+        path.setFillType(SkPath::kEvenOdd_FillType);
+        for (int inverse = 0; inverse < 2; ++inverse) {
+            SkBitmap analytic, supersampled;
+            fill(path, SkScan::kAnalytic_AAType, &analytic);
+            fill(path, SkScan::kSupersample_AAType, &supersampled);
+
+            int sumDiff;
+            REPORTER_ASSERT(reporter, 0 == max_diff(analytic, supersampled, &sumDiff));
+            path.toggleInverseFillType();
+        }
+    }
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBitmapProcState.h"
+#include "SkBitmapScaler.h"
+#include "SkColorPriv.h"
+#include "SkRandom.h"
+#include "SkTaskGroup.h"
+#include "Test.h"
+
+static void make_source(SkBitmap* bm, int width, int height, bool opaque) {
+    bm->allocN32Pixels(width, height, opaque);
+    SkRandom rand;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            SkColor c = rand.nextU();
+            if (opaque) {
+                c = SkColorSetA(c, 0xFF);
+            }
+            *bm->getAddr32(x, y) = SkPreMultiplyColor(c);
+        }
+    }
+}
+
+static bool resize(SkBitmap* dst, const SkBitmap& src, int width, int height,
+                   const SkConvolutionProcs& procs, SkTaskScheduler* scheduler) {
+    return SkBitmapScaler::Resize(dst, src, SkBitmapScaler::RESIZE_BEST,
+                                  SkIntToScalar(width), SkIntToScalar(height), procs,
+                                  NULL, scheduler);
+}
+
+static bool bitmaps_equal(const SkBitmap& a, const SkBitmap& b) {
+    if (a.width() != b.width() || a.height() != b.height()) {
+        return false;
+    }
+    SkAutoLockPixels alpa(a), alpb(b);
+    for (int y = 0; y < a.height(); ++y) {
+        if (memcmp(a.getAddr32(0, y), b.getAddr32(0, y), a.width() * sizeof(SkPMColor))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The platform's vertical pass (with short and long filters) must match the portable one, and
+// splitting the rows into bands across threads must not change the results.
+DEF_TEST(BitmapScaler, reporter) {
+    static const struct {
+        int fSrcWidth, fSrcHeight;
+        int fDstWidth, fDstHeight;
+    } gSizes[] = {
+        {  300,  280,   37,  29 },  // Long filters.
+        {  300,  280,  150, 140 },
+        {  300,  280,  601, 563 },  // Short filters, and enough pixels to use threads.
+        { 1203, 1001,  300, 255 },  // Long filters, and enough pixels to use threads.
+    };
+
+    SkConvolutionProcs portable, vertical, platform;
+    sk_bzero(&portable, sizeof(portable));
+    sk_bzero(&platform, sizeof(platform));
+    SkBitmapProcState state;
+    state.platformConvolutionProcs(&platform);
+    vertical = portable;
+    vertical.fConvolveVertically = platform.fConvolveVertically;
+
+    SkTaskScheduler scheduler(3);
+    for (size_t i = 0; i < SK_ARRAY_COUNT(gSizes); ++i) {
+        for (int opaque = 0; opaque < 2; ++opaque) {
+            SkBitmap src;
+            make_source(&src, gSizes[i].fSrcWidth, gSizes[i].fSrcHeight, SkToBool(opaque));
+            const int w = gSizes[i].fDstWidth, h = gSizes[i].fDstHeight;
+
+            SkBitmap expected, actual;
+            REPORTER_ASSERT(reporter, resize(&expected, src, w, h, portable, NULL));
+            REPORTER_ASSERT(reporter, resize(&actual, src, w, h, vertical, NULL));
+            REPORTER_ASSERT(reporter, bitmaps_equal(expected, actual));
+
+            REPORTER_ASSERT(reporter, resize(&expected, src, w, h, platform, NULL));
+            REPORTER_ASSERT(reporter, resize(&actual, src, w, h, platform, &scheduler));
+            REPORTER_ASSERT(reporter, bitmaps_equal(expected, actual));
+        }
+    }
+}
@@ -6,10 +6,13 @@
  */
 
 #include "SkBitmap.h"
+#include "SkBlitRow.h"
 #include "SkCanvas.h"
 #include "SkColorPriv.h"
 #include "SkGradientShader.h"
+#include "SkRandom.h"
 #include "SkRect.h"
+#include "SkUtils.h"
 #include "Test.h"
 
 // these are in the same order as the SkColorType enum
@@ -262,3 +265,90 @@ DEF_TEST(BlitRow, reporter) {
     test_00_FF(reporter);
     test_diagonal(reporter);
 }
+
+static SkBlitRow::Proc32 factory32(unsigned flags, int simdLevelCap) {
+    int prevCap = SkSetSIMDLevelCap(simdLevelCap);
+    SkBlitRow::Proc32 proc = SkBlitRow::Factory32(flags);
+    SkSetSIMDLevelCap(prevCap);
+    return proc;
+}
+
+static void random_pmcolors(SkRandom* rand, SkPMColor colors[], int count) {
+    for (int i = 0; i < count; i++) {
+        U8CPU a = 0 == i % 5 ? 0xFF : rand->nextU() & 0xFF;
+        colors[i] = SkPreMultiplyColor(SkColorSetA(rand->nextU(), a));
+    }
+}
+
+// The widest SIMD blit rows must match the SSE2 ones bit for bit, whatever the alignment and length.
+static void test_simd_blitrow(skiatest::Reporter* reporter) {
+    static const int N = 83;
+    SkPMColor src[N], dst[N], expected[N], actual[N];
+    SkRandom rand;
+    random_pmcolors(&rand, src, N);
+    random_pmcolors(&rand, dst, N);
+
+    // Callers only ask for global alpha when it's not 0xFF.
+    static const U8CPU gAlphas[] = { 0, 1, 0x80, 0xFE };
+    for (unsigned flags = 0; flags < 4; flags++) {  // Global alpha and/or source alpha.
+        SkBlitRow::Proc32 sse2 = factory32(flags, SK_CPU_SSE_LEVEL_SSE2);
+        SkBlitRow::Proc32 best = factory32(flags, SK_MaxS32);
+        for (size_t a = 0; a < SK_ARRAY_COUNT(gAlphas); a++) {
+            const U8CPU alpha = (flags & SkBlitRow::kGlobalAlpha_Flag32) ? gAlphas[a] : 0xFF;
+            for (int offset = 0; offset < 8; offset++) {
+                const int count = N - offset - rand.nextULessThan(16);
+                memcpy(expected, dst, sizeof(dst));
+                memcpy(actual, dst, sizeof(dst));
+                sse2(expected + offset, src + offset, count, alpha);
+                best(actual + offset, src + offset, count, alpha);
+                REPORTER_ASSERT(reporter, 0 == memcmp(expected, actual, sizeof(dst)));
+            }
+        }
+    }
+}
+
+static void draw_filtered(const SkBitmap& src, U8CPU alpha, int simdLevelCap, SkBitmap* dst) {
+    dst->allocN32Pixels(101, 37);
+    dst->eraseColor(SK_ColorTRANSPARENT);
+
+    SkCanvas canvas(*dst);
+    canvas.scale(1.37f, 1.21f);
+    canvas.translate(0.3f, 0.45f);
+    SkPaint paint;
+    paint.setFilterLevel(SkPaint::kLow_FilterLevel);
+    paint.setAlpha(alpha);
+    paint.setXfermodeMode(SkXfermode::kSrc_Mode);
+
+    int prevCap = SkSetSIMDLevelCap(simdLevelCap);
+    canvas.drawBitmap(src, 0, 0, &paint);
+    SkSetSIMDLevelCap(prevCap);
+}
+
+// Likewise for the bilinear samplers.
+static void test_simd_filter(skiatest::Reporter* reporter) {
+    SkBitmap src;
+    src.allocN32Pixels(71, 29);
+    SkRandom rand;
+    for (int y = 0; y < src.height(); y++) {
+        random_pmcolors(&rand, src.getAddr32(0, y), src.width());
+    }
+
+    static const U8CPU gAlphas[] = { 0x80, 0xFF };
+    for (size_t a = 0; a < SK_ARRAY_COUNT(gAlphas); a++) {
+        SkBitmap expected, actual;
+        draw_filtered(src, gAlphas[a], SK_CPU_SSE_LEVEL_SSE2, &expected);
+        draw_filtered(src, gAlphas[a], SK_MaxS32, &actual);
+
+        bool same = true;
+        for (int y = 0; y < expected.height(); y++) {
+            same &= 0 == memcmp(expected.getAddr32(0, y), actual.getAddr32(0, y),
+                                expected.width() * sizeof(SkPMColor));
+        }
+        REPORTER_ASSERT(reporter, same);
+    }
+}
+
+DEF_TEST(BlitRow_SIMDLevels, reporter) {
+    test_simd_blitrow(reporter);
+    test_simd_filter(reporter);
+}
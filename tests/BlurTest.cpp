@@ -11,8 +11,14 @@
 #include "SkLayerDrawLooper.h"
 #include "SkEmbossMaskFilter.h"
 #include "SkCanvas.h"
+#include "SkChecksum.h"
+#include "SkGraphics.h"
 #include "SkMath.h"
 #include "SkPaint.h"
+#include "SkRandom.h"
+#include "SkRRect.h"
+#include "SkTaskGroup.h"
+#include "SkUtils.h"
 #include "Test.h"
 
 #if SK_SUPPORT_GPU
@@ -562,8 +568,132 @@ static void test_asABlur(skiatest::Reporter* reporter) {
 
 ///////////////////////////////////////////////////////////////////////////////////////////
 
+static bool box_blur(SkMask* dst, const SkMask& src, SkScalar sigma, SkBlurQuality quality,
+                     int simdLevelCap, SkTaskScheduler* scheduler) {
+    int prevCap = SkSetSIMDLevelCap(simdLevelCap);
+    bool success = SkBlurMask::BoxBlur(dst, src, sigma, kNormal_SkBlurStyle, quality,
+                                       NULL, false, scheduler);
+    SkSetSIMDLevelCap(prevCap);
+    return success;
+}
+
+static uint32_t mask_checksum(const SkMask& mask) {
+    const int width = mask.fBounds.width(), height = mask.fBounds.height();
+    SkAutoTMalloc<uint32_t> storage((width * height + 3) / 4);
+    uint8_t* pixels = (uint8_t*)storage.get();
+    sk_bzero(pixels, SkAlign4(width * height));
+    for (int y = 0; y < height; ++y) {
+        memcpy(pixels + y * width, mask.fImage + y * mask.fRowBytes, width);
+    }
+    return SkChecksum::Murmur3(storage.get(), SkAlign4(width * height));
+}
+
+static bool masks_equal(const SkMask& a, const SkMask& b) {
+    if (a.fBounds != b.fBounds) {
+        return false;
+    }
+    for (int y = 0; y < a.fBounds.height(); ++y) {
+        if (memcmp(a.fImage + y * a.fRowBytes, b.fImage + y * b.fRowBytes, a.fBounds.width())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// BoxBlur must give the same results with or without SIMD, and whether or not it's split into
+// bands across threads.  The sizes straddle the 16 column SIMD width and the threading cutoff,
+// and the sigmas cover kernels that fit 16-bit sums and ones that don't.
+static void test_box_blur_procs(skiatest::Reporter* reporter) {
+    static const SkISize gSizes[] = {
+        { 5, 3 }, { 37, 19 }, { 300, 280 }
+    };
+    static const SkScalar gSigmas[] = { 0.8f, 3, 20, 60 };
+    static const SkBlurQuality gQualities[] = { kLow_SkBlurQuality, kHigh_SkBlurQuality };
+    // mask_checksum() of each blur as the scalar BoxBlur made it before there were platform procs.
+    static const uint32_t gChecksums[][SK_ARRAY_COUNT(gSigmas)][SK_ARRAY_COUNT(gQualities)] = {
+        { { 0x1621F197, 0x1621F197 }, { 0x8FD1C02F, 0x5EEB0EDF },
+          { 0xBE648F9B, 0x04969F64 }, { 0xD5C73091, 0x6AA333F5 } },
+        { { 0x20C950C4, 0x20C950C4 }, { 0xF15FC544, 0xE0549F4D },
+          { 0x3A644650, 0x618C495A }, { 0x4A4714B4, 0x087DDE6A } },
+        { { 0x63B3C1D7, 0x63B3C1D7 }, { 0x39D95904, 0x7596D89E },
+          { 0x3F778A32, 0x5568F8A6 }, { 0x9EE429D8, 0xEEC21E93 } },
+    };
+    SK_COMPILE_ASSERT(SK_ARRAY_COUNT(gChecksums) == SK_ARRAY_COUNT(gSizes), checksum_per_size);
+
+    SkTaskScheduler scheduler(3);
+    SkRandom rand;
+    for (size_t i = 0; i < SK_ARRAY_COUNT(gSizes); ++i) {
+        SkMask src;
+        src.fFormat = SkMask::kA8_Format;
+        src.fBounds.set(0, 0, gSizes[i].width(), gSizes[i].height());
+        src.fRowBytes = src.fBounds.width() + 3;
+        src.fImage = SkMask::AllocImage(src.computeImageSize());
+        SkAutoMaskFreeImage autoSrc(src.fImage);
+        for (size_t j = 0; j < src.computeImageSize(); ++j) {
+            src.fImage[j] = rand.nextU() & 0xFF;
+        }
+
+        for (size_t j = 0; j < SK_ARRAY_COUNT(gSigmas); ++j) {
+            for (size_t k = 0; k < SK_ARRAY_COUNT(gQualities); ++k) {
+                SkMask expected, simd, threaded;
+                REPORTER_ASSERT(reporter, box_blur(&expected, src, gSigmas[j], gQualities[k],
+                                                   0, NULL));
+                REPORTER_ASSERT(reporter, box_blur(&simd, src, gSigmas[j], gQualities[k],
+                                                   SK_MaxS32, NULL));
+                REPORTER_ASSERT(reporter, box_blur(&threaded, src, gSigmas[j], gQualities[k],
+                                                   SK_MaxS32, &scheduler));
+                SkAutoMaskFreeImage autoExpected(expected.fImage),
+                                    autoSimd(simd.fImage),
+                                    autoThreaded(threaded.fImage);
+                REPORTER_ASSERT(reporter, gChecksums[i][j][k] == mask_checksum(expected));
+                REPORTER_ASSERT(reporter, masks_equal(expected, simd));
+                REPORTER_ASSERT(reporter, masks_equal(expected, threaded));
+            }
+        }
+    }
+}
+
+// Blurred round rects are drawn as nine-patches whose masks are cached.  Drawing one again, here
+// or elsewhere, must find the cached mask and give the same pixels.
+static void test_blur_rrect_cache(skiatest::Reporter* reporter) {
+    SkRRect rrect;
+    rrect.setRectXY(SkRect::MakeXYWH(10, 10, 100, 80), 10, 10);
+
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    paint.setMaskFilter(SkBlurMaskFilter::Create(kNormal_SkBlurStyle, 3.25f))->unref();
+
+    SkBitmap first, second;
+    first.allocN32Pixels(200, 200);
+    second.allocN32Pixels(200, 200);
+    first.eraseColor(SK_ColorWHITE);
+    second.eraseColor(SK_ColorWHITE);
+
+    SkCanvas(first).drawRRect(rrect, paint);
+
+    uint64_t hitsBefore, hitsAfter;
+    SkGraphics::GetImageCacheStats(&hitsBefore, NULL, NULL);
+    {
+        SkCanvas canvas(second);
+        canvas.translate(50, 60);
+        canvas.drawRRect(rrect, paint);
+    }
+    SkGraphics::GetImageCacheStats(&hitsAfter, NULL, NULL);
+    REPORTER_ASSERT(reporter, hitsAfter > hitsBefore);
+
+    SkAutoLockPixels alp0(first), alp1(second);
+    for (int y = 0; y < 140; ++y) {
+        REPORTER_ASSERT(reporter, 0 == memcmp(first.getAddr32(0, y), second.getAddr32(50, y + 60),
+                                              150 * sizeof(SkPMColor)));
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+
 DEF_GPUTEST(Blur, reporter, factory) {
     test_blur_drawing(reporter);
     test_sigma_range(reporter, factory);
     test_asABlur(reporter);
+    test_box_blur_procs(reporter);
+    test_blur_rrect_cache(reporter);
 }
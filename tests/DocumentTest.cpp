@@ -96,10 +96,27 @@ static void test_close(skiatest::Reporter* reporter) {
     REPORTER_ASSERT(reporter, stream.bytesWritten() != 0);
 }
 
+static void test_streaming(skiatest::Reporter* reporter) {
+    SkDynamicMemoryWStream stream;
+    SkAutoTUnref<SkDocument> doc(SkDocument::CreateStreamingPDF(&stream));
+
+    SkCanvas* canvas = doc->beginPage(100, 100);
+    canvas->drawColor(SK_ColorRED);
+    doc->endPage();
+
+    // The page is written before the document is closed.
+    size_t pageBytes = stream.bytesWritten();
+    REPORTER_ASSERT(reporter, pageBytes != 0);
+
+    REPORTER_ASSERT(reporter, doc->close());
+    REPORTER_ASSERT(reporter, stream.bytesWritten() > pageBytes);
+}
+
 DEF_TEST(document_tests, reporter) {
     test_empty(reporter);
     test_abort(reporter);
     test_abortWithFile(reporter);
     test_file(reporter);
     test_close(reporter);
+    test_streaming(reporter);
 }
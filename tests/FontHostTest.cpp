@@ -5,12 +5,19 @@
  * found in the LICENSE file.
  */
 
+#include "SkBitmap.h"
+#include "SkCanvas.h"
 #include "SkEndian.h"
 #include "SkFontStream.h"
+#include "SkGlyphCache.h"
+#include "SkGraphics.h"
 #include "SkOSFile.h"
 #include "SkPaint.h"
 #include "SkStream.h"
+#include "SkTDArray.h"
+#include "SkThreadUtils.h"
 #include "SkTypeface.h"
+#include "SkUtils.h"
 #include "Test.h"
 
 //#define DUMP_TABLES
@@ -110,6 +117,71 @@ static void test_charsToGlyphs(skiatest::Reporter* reporter, SkTypeface* face) {
     }
 }
 
+// Test charsToGlyphs and textToGlyphs on text that switches between ASCII runs of every length
+// and other unichars, against the glyph cache's own lookup of each unichar.
+static void test_charsToGlyphs_mixed(skiatest::Reporter* reporter, SkTypeface* face) {
+    static const SkUnichar gOthers[] = { 0x00E9, 0x0416, 0x4E2D, 0xFFFD, 0x1D11E };
+
+    SkTDArray<SkUnichar> unichars;
+    for (int run = 0; run < 40; ++run) {
+        for (int i = 0; i < run; ++i) {
+            *unichars.append() = 'a' + (run + i) % 26;
+        }
+        *unichars.append() = gOthers[run % SK_ARRAY_COUNT(gOthers)];
+    }
+    const int count = unichars.count();
+
+    SkPaint paint;
+    paint.setTypeface(face);
+    SkAutoTMalloc<uint16_t> expected(count);
+    {
+        SkAutoGlyphCache autoCache(paint, NULL, NULL);
+        for (int i = 0; i < count; ++i) {
+            expected[i] = autoCache.getCache()->unicharToGlyph(unichars[i]);
+        }
+    }
+
+    SkTDArray<char> utf8;
+    SkTDArray<uint16_t> utf16;
+    for (int i = 0; i < count; ++i) {
+        SkUTF8_FromUnichar(unichars[i], utf8.append(SkToInt(SkUTF8_FromUnichar(unichars[i]))));
+        SkUTF16_FromUnichar(unichars[i], utf16.append(SkToInt(SkUTF16_FromUnichar(unichars[i]))));
+    }
+    const struct {
+        const void*             fChars;
+        size_t                  fByteLength;
+        SkTypeface::Encoding    fEncoding;
+    } gRecs[] = {
+        { utf8.begin(),     SkToSizeT(utf8.count()),            SkTypeface::kUTF8_Encoding  },
+        { utf16.begin(),    utf16.count() * sizeof(uint16_t),   SkTypeface::kUTF16_Encoding },
+        { unichars.begin(), count * sizeof(SkUnichar),          SkTypeface::kUTF32_Encoding },
+    };
+
+    SkAutoTMalloc<uint16_t> glyphs(count);
+    int firstMissing = count;
+    for (int i = 0; i < count; ++i) {
+        if (0 == expected[i]) {
+            firstMissing = i;
+            break;
+        }
+    }
+    for (size_t r = 0; r < SK_ARRAY_COUNT(gRecs); ++r) {
+        int result = face->charsToGlyphs(gRecs[r].fChars, gRecs[r].fEncoding, glyphs, count);
+        REPORTER_ASSERT(reporter, firstMissing == result);
+        REPORTER_ASSERT(reporter, 0 == memcmp(expected, glyphs, count * sizeof(uint16_t)));
+        REPORTER_ASSERT(reporter, firstMissing ==
+                        face->charsToGlyphs(gRecs[r].fChars, gRecs[r].fEncoding, NULL, count));
+
+        paint.setTextEncoding((SkPaint::TextEncoding)gRecs[r].fEncoding);
+        sk_bzero(glyphs, count * sizeof(uint16_t));
+        REPORTER_ASSERT(reporter, count ==
+                        paint.textToGlyphs(gRecs[r].fChars, gRecs[r].fByteLength, glyphs));
+        REPORTER_ASSERT(reporter, 0 == memcmp(expected, glyphs, count * sizeof(uint16_t)));
+        REPORTER_ASSERT(reporter, (firstMissing == count) ==
+                        paint.containsText(gRecs[r].fChars, gRecs[r].fByteLength));
+    }
+}
+
 static void test_fontstream(skiatest::Reporter* reporter,
                             SkStream* stream, int ttcIndex) {
     int n = SkFontStream::GetTableTags(stream, ttcIndex, NULL);
@@ -224,6 +296,7 @@ static void test_tables(skiatest::Reporter* reporter) {
             test_unitsPerEm(reporter, face);
             test_countGlyphs(reporter, face);
             test_charsToGlyphs(reporter, face);
+            test_charsToGlyphs_mixed(reporter, face);
         }
     }
 }
@@ -305,4 +378,53 @@ DEF_TEST(FontHost, reporter) {
     test_advances(reporter);
 }
 
+static const int kThreadedSizes = 4;
+
+struct TextDrawer {
+    SkBitmap fBitmap;
+    int      fTextSize;
+
+    static void Draw(void* data) {
+        TextDrawer* drawer = static_cast<TextDrawer*>(data);
+        drawer->fBitmap.allocN32Pixels(320, 48);
+        drawer->fBitmap.eraseColor(SK_ColorWHITE);
+        SkCanvas canvas(drawer->fBitmap);
+        SkPaint paint;
+        paint.setAntiAlias(true);
+        paint.setTextSize(SkIntToScalar(drawer->fTextSize));
+        static const char kText[] = "Scaling glyphs 0123456789";
+        canvas.drawText(kText, sizeof(kText) - 1, 0, SkIntToScalar(40), paint);
+    }
+};
+
+// Glyphs scaled for several strikes at once, each on its own thread, should come out just as
+// they do one strike at a time.
+DEF_TEST(FontHost_threaded, reporter) {
+    TextDrawer expected[kThreadedSizes], actual[kThreadedSizes];
+    SkGraphics::PurgeFontCache();
+    for (int i = 0; i < kThreadedSizes; ++i) {
+        expected[i].fTextSize = 12 + 7 * i;
+        TextDrawer::Draw(&expected[i]);
+    }
+
+    SkGraphics::PurgeFontCache();
+    SkThread* threads[kThreadedSizes];
+    for (int i = 0; i < kThreadedSizes; ++i) {
+        actual[i].fTextSize = expected[i].fTextSize;
+        threads[i] = SkNEW_ARGS(SkThread, (TextDrawer::Draw, &actual[i]));
+        REPORTER_ASSERT(reporter, threads[i]->start());
+    }
+    for (int i = 0; i < kThreadedSizes; ++i) {
+        threads[i]->join();
+        SkDELETE(threads[i]);
+    }
+
+    for (int i = 0; i < kThreadedSizes; ++i) {
+        SkAutoLockPixels alpExpected(expected[i].fBitmap), alpActual(actual[i].fBitmap);
+        REPORTER_ASSERT(reporter, 0 == memcmp(expected[i].fBitmap.getPixels(),
+                                              actual[i].fBitmap.getPixels(),
+                                              expected[i].fBitmap.getSize()));
+    }
+}
+
 // need tests for SkStrSearch
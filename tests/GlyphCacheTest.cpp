@@ -0,0 +1,394 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBitmapDevice.h"
+#include "SkCanvas.h"
+#include "SkDistanceFieldGen.h"
+#include "SkDraw.h"
+#include "SkGlyphCache.h"
+#include "SkGraphics.h"
+#include "SkPaint.h"
+#include "SkScalerContext.h"
+#include "SkSharedGlyphImages.h"
+#include "SkTaskGroup.h"
+#include "SkTypeface.h"
+#include "Test.h"
+
+static const char kText[] = "The quick brown fox jumps over the lazy dog.";
+
+static void setup_paint(SkPaint* paint, SkScalar textSize) {
+    paint->setAntiAlias(true);
+    paint->setTextSize(textSize);
+    paint->setTextEncoding(SkPaint::kGlyphID_TextEncoding);
+}
+
+DEF_TEST(GlyphCache_SharedStrike, r) {
+    SkPaint paint;
+    setup_paint(&paint, 17);
+
+    // While the first cache is detached, asking for the same descriptor again gives us another
+    // cache, but the two share their glyphs.
+    SkAutoGlyphCache autoCache1(paint, NULL, NULL);
+    SkAutoGlyphCache autoCache2(paint, NULL, NULL);
+    SkGlyphCache* cache1 = autoCache1.getCache();
+    SkGlyphCache* cache2 = autoCache2.getCache();
+    REPORTER_ASSERT(r, cache1 != cache2);
+    REPORTER_ASSERT(r, cache1->getDescriptor().equals(cache2->getDescriptor()));
+
+    for (uint16_t glyphID = 0; glyphID < 32; glyphID++) {
+        const SkGlyph& advance = cache1->getGlyphIDAdvance(glyphID);
+        const SkGlyph& metrics = cache2->getGlyphIDMetrics(glyphID);
+        REPORTER_ASSERT(r, &advance == &metrics);
+        REPORTER_ASSERT(r, advance.isFullMetrics());
+        REPORTER_ASSERT(r, &metrics == &cache1->getGlyphIDMetrics(glyphID));
+        REPORTER_ASSERT(r, cache1->findImage(metrics) == cache2->findImage(metrics));
+    }
+}
+
+namespace {
+
+// Draws kText at a few sizes, which the other TextDrawers share.
+class TextDrawer : public SkRunnable {
+public:
+    virtual void run() SK_OVERRIDE {
+        fBitmap.allocN32Pixels(256, 128);
+        fBitmap.eraseColor(SK_ColorWHITE);
+        SkCanvas canvas(fBitmap);
+
+        SkPaint paint;
+        paint.setAntiAlias(true);
+        for (int size = 10; size < 20; size += 3) {
+            paint.setTextSize(SkIntToScalar(size));
+            canvas.drawText(kText, strlen(kText), 0, SkIntToScalar(size * 5), paint);
+        }
+    }
+
+    SkBitmap fBitmap;
+};
+
+}  // namespace
+
+static bool same_pixels(const SkBitmap& a, const SkBitmap& b) {
+    SkAutoLockPixels lockA(a), lockB(b);
+    return a.getSize() == b.getSize() && 0 == memcmp(a.getPixels(), b.getPixels(), a.getSize());
+}
+
+DEF_TEST(GlyphCache_Threads, r) {
+    // Start cold, so the threads race to create the same glyphs.
+    SkGraphics::PurgeFontCache();
+
+    static const int kDrawers = 8;
+    TextDrawer drawers[kDrawers];
+    {
+        SkTaskScheduler scheduler(4);
+        SkTaskGroup group(&scheduler);
+        for (int i = 0; i < kDrawers; i++) {
+            group.add(&drawers[i]);
+        }
+        group.wait();
+    }
+
+    TextDrawer expected;
+    expected.run();
+    for (int i = 0; i < kDrawers; i++) {
+        REPORTER_ASSERT(r, same_pixels(expected.fBitmap, drawers[i].fBitmap));
+    }
+}
+
+DEF_TEST(GlyphCache_SharedImages, r) {
+    uint32_t memory[64 * 1024 / 4];
+    REPORTER_ASSERT(r, !SkGraphics::InitSharedGlyphImageCache(memory, 256));
+    REPORTER_ASSERT(r, SkGraphics::InitSharedGlyphImageCache(memory, sizeof(memory)));
+
+    uint8_t pixels[8 * 8], found[8 * 8];
+    for (size_t i = 0; i < sizeof(pixels); i++) {
+        pixels[i] = SkToU8(i * 3);
+    }
+    SkGlyph glyph;
+    glyph.init(SkGlyph::MakeID(7));
+    glyph.fWidth = glyph.fHeight = 8;
+    glyph.fMaskFormat = SkMask::kA8_Format;
+    glyph.fImage = found;
+
+    const uint32_t key[2] = { 0x12345678, 0x9ABCDEF0 };
+    const uint32_t otherKey[2] = { 0x12345678, 0x9ABCDEF1 };
+    REPORTER_ASSERT(r, !SkSharedGlyphImages::Find(memory, key, glyph));
+    glyph.fImage = pixels;
+    SkSharedGlyphImages::Add(memory, key, glyph);
+    glyph.fImage = found;
+    REPORTER_ASSERT(r, SkSharedGlyphImages::Find(memory, key, glyph));
+    REPORTER_ASSERT(r, 0 == memcmp(pixels, found, sizeof(pixels)));
+    REPORTER_ASSERT(r, !SkSharedGlyphImages::Find(memory, otherKey, glyph));
+
+    // Filling it up empties it, rather than failing.
+    for (uint16_t id = 0; id < 4096; id++) {
+        glyph.init(SkGlyph::MakeID(id));
+        glyph.fWidth = glyph.fHeight = 8;
+        glyph.fMaskFormat = SkMask::kA8_Format;
+        glyph.fImage = pixels;
+        SkSharedGlyphImages::Add(memory, otherKey, glyph);
+        glyph.fImage = found;
+        REPORTER_ASSERT(r, SkSharedGlyphImages::Find(memory, otherKey, glyph));
+    }
+    REPORTER_ASSERT(r, !SkSharedGlyphImages::Find(memory, key, glyph));
+
+    // A process that died while adding a glyph leaves the store's sequence number (its second
+    // word) odd.  Nobody waits for it; the store just stops finding and adding glyphs.
+    glyph.fImage = pixels;
+    SkSharedGlyphImages::Add(memory, key, glyph);
+    glyph.fImage = found;
+    REPORTER_ASSERT(r, SkSharedGlyphImages::Find(memory, key, glyph));
+    memory[1] |= 1;
+    REPORTER_ASSERT(r, !SkSharedGlyphImages::Find(memory, key, glyph));
+    glyph.fImage = pixels;
+    SkSharedGlyphImages::Add(memory, otherKey, glyph);
+    glyph.fImage = found;
+    REPORTER_ASSERT(r, !SkSharedGlyphImages::Find(memory, otherKey, glyph));
+}
+
+DEF_TEST(GlyphCache_SharedImagesText, r) {
+    // Never freed: other threads' scaler contexts may still be looking at it when we uninstall.
+    static uint32_t gMemory[256 * 1024 / 4];
+    REPORTER_ASSERT(r, SkGraphics::InitSharedGlyphImageCache(gMemory, sizeof(gMemory)));
+    SkGraphics::SetSharedGlyphImageCache(gMemory);
+
+    // Text drawn from shared images matches text rasterized here.
+    SkGraphics::PurgeFontCache();
+    TextDrawer rasterized;
+    rasterized.run();
+    SkGraphics::PurgeFontCache();
+    TextDrawer shared;
+    shared.run();
+    REPORTER_ASSERT(r, same_pixels(rasterized.fBitmap, shared.fBitmap));
+
+    SkGraphics::SetSharedGlyphImageCache(NULL);
+}
+
+DEF_TEST(GlyphCache_Prewarm, r) {
+    SkPaint paint;
+    setup_paint(&paint, 23);
+    uint16_t glyphIDs[80];
+    for (int i = 0; i < 80; i++) {
+        glyphIDs[i] = SkToU16((i * 7) % 64);    // With repeats, in no order.
+    }
+    const unsigned flags = SkGlyphCache::kImage_PrewarmFlag | SkGlyphCache::kPath_PrewarmFlag;
+
+    SkTaskScheduler scheduler(3);
+    SkGraphics::PurgeFontCache();
+    SkAutoGlyphCache autoCache(paint, NULL, NULL);
+    SkGlyphCache* cache = autoCache.getCache();
+    // Start with one glyph cached, and another with just its advance.
+    cache->getGlyphIDMetrics(5);
+    cache->getGlyphIDAdvance(12);
+    cache->prewarmGlyphIDs(glyphIDs, SK_ARRAY_COUNT(glyphIDs), flags, &scheduler);
+
+    // They match glyphs generated one at a time.
+    SkTypeface* typeface = cache->getScalerContext()->getTypeface();
+    SkAutoTDelete<SkScalerContext> ctx(typeface->createScalerContext(&cache->getDescriptor()));
+    for (uint16_t glyphID = 0; glyphID < 64; glyphID++) {
+        const SkGlyph& glyph = cache->getGlyphIDMetrics(glyphID);
+        REPORTER_ASSERT(r, glyph.isFullMetrics());
+
+        SkGlyph expected;
+        expected.init(SkGlyph::MakeID(glyphID));
+        ctx->getMetrics(&expected);
+        REPORTER_ASSERT(r, glyph.fWidth == expected.fWidth);
+        REPORTER_ASSERT(r, glyph.fHeight == expected.fHeight);
+        REPORTER_ASSERT(r, glyph.fAdvanceX == expected.fAdvanceX);
+        if (0 == glyph.fWidth) {
+            continue;
+        }
+        REPORTER_ASSERT(r, NULL != glyph.fImage && NULL != glyph.fPath);
+
+        SkAutoMalloc image(expected.computeImageSize());
+        expected.fImage = image.get();
+        ctx->getImage(expected);
+        REPORTER_ASSERT(r, 0 == memcmp(glyph.fImage, image.get(), expected.computeImageSize()));
+        SkPath path;
+        ctx->getPath(expected, &path);
+        REPORTER_ASSERT(r, path == *glyph.fPath);
+    }
+}
+
+DEF_TEST(GlyphCache_PrewarmText, r) {
+    SkGraphics::PurgeFontCache();
+    TextDrawer cold;
+    cold.run();
+
+    SkTaskScheduler scheduler(2);
+    SkGraphics::PurgeFontCache();
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    for (int size = 10; size < 20; size += 3) {
+        paint.setTextSize(SkIntToScalar(size));
+        paint.prewarmText(kText, strlen(kText), NULL, &scheduler);
+    }
+
+    TextDrawer warm;
+    warm.run();
+    REPORTER_ASSERT(r, same_pixels(cold.fBitmap, warm.fBitmap));
+}
+
+DEF_TEST(GlyphCache_PrewarmDistanceFields, r) {
+    SkPaint paint;
+    setup_paint(&paint, 32);
+    paint.setSubpixelText(true);
+    uint16_t glyphIDs[64];
+    for (int i = 0; i < 64; i++) {
+        glyphIDs[i] = SkToU16(i);
+    }
+
+    SkTaskScheduler scheduler(3);
+    SkGraphics::PurgeFontCache();
+    SkAutoGlyphCache autoCache(paint, NULL, NULL);
+    SkGlyphCache* cache = autoCache.getCache();
+    cache->prewarmGlyphIDs(glyphIDs, SK_ARRAY_COUNT(glyphIDs),
+                           SkGlyphCache::kDistanceField_PrewarmFlag, &scheduler);
+
+    // The fields match those made one at a time from the images.
+    for (uint16_t glyphID = 0; glyphID < 64; glyphID++) {
+        const SkGlyph& glyph = cache->getGlyphIDMetrics(glyphID);
+        if (0 == glyph.fWidth || SkMask::kA8_Format != glyph.fMaskFormat) {
+            continue;
+        }
+        REPORTER_ASSERT(r, NULL != glyph.fImage && NULL != glyph.fDistanceField);
+
+        size_t size = SkComputeDistanceFieldSize(glyph.fWidth, glyph.fHeight);
+        SkAutoMalloc field(size);
+        SkGenerateDistanceFieldFromA8Image((unsigned char*)field.get(),
+                                           (const unsigned char*)glyph.fImage,
+                                           glyph.fWidth, glyph.fHeight, glyph.rowBytes());
+        REPORTER_ASSERT(r, 0 == memcmp(glyph.fDistanceField, field.get(), size));
+    }
+}
+
+// The total alpha of bitmap, the bounds of its non-zero alpha, and where that alpha is centered.
+struct Coverage {
+    int     fTotal;
+    SkIRect fBounds;
+    SkPoint fCenter;
+};
+
+static void measure_coverage(const SkBitmap& bitmap, Coverage* coverage) {
+    int64_t sumX = 0, sumY = 0;
+    coverage->fTotal = 0;
+    coverage->fBounds.setEmpty();
+    for (int y = 0; y < bitmap.height(); y++) {
+        for (int x = 0; x < bitmap.width(); x++) {
+            int alpha = SkGetPackedA32(*bitmap.getAddr32(x, y));
+            if (alpha > 0) {
+                coverage->fTotal += alpha;
+                coverage->fBounds.join(x, y, x + 1, y + 1);
+                sumX += alpha * x;
+                sumY += alpha * y;
+            }
+        }
+    }
+    if (coverage->fTotal > 0) {
+        coverage->fCenter.set(SkIntToScalar(sumX) / coverage->fTotal,
+                              SkIntToScalar(sumY) / coverage->fTotal);
+    } else {
+        coverage->fCenter.set(0, 0);
+    }
+}
+
+enum DistanceFieldTextCase {
+    kLeft_DistanceFieldTextCase,
+    kCenter_DistanceFieldTextCase,
+    kRight_DistanceFieldTextCase,
+    kPosText_DistanceFieldTextCase,
+    kScaled_DistanceFieldTextCase,
+    kClipped_DistanceFieldTextCase,
+
+    kDistanceFieldTextCaseCount
+};
+
+static void draw_text_case(SkCanvas* canvas, SkPaint paint, DistanceFieldTextCase textCase) {
+    static const char kString[] = "Hamburgefons";
+    const size_t length = sizeof(kString) - 1;
+    const SkScalar size = paint.getTextSize();
+    const SkScalar width = SkIntToScalar(canvas->getDeviceSize().width());
+    SkScalar x = size / 2;
+    const SkScalar y = size * 3 / 2;
+
+    switch (textCase) {
+        case kCenter_DistanceFieldTextCase:
+            paint.setTextAlign(SkPaint::kCenter_Align);
+            x = width / 2;
+            break;
+        case kRight_DistanceFieldTextCase:
+            paint.setTextAlign(SkPaint::kRight_Align);
+            x = width - size / 2;
+            break;
+        case kScaled_DistanceFieldTextCase:
+            canvas->scale(SkDoubleToScalar(1.5), SkDoubleToScalar(1.25));
+            break;
+        case kClipped_DistanceFieldTextCase:
+            canvas->clipRect(SkRect::MakeLTRB(size, size, width / 2, y));
+            break;
+        case kPosText_DistanceFieldTextCase: {
+            // Each glyph twice as far along as it'd normally be, so they're apart.
+            SkScalar widths[length];
+            paint.getTextWidths(kString, length, widths);
+            SkPoint pos[length];
+            for (size_t i = 0; i < length; i++) {
+                pos[i].set(x, y - (i & 1) * size / 4);
+                x += 2 * widths[i];
+            }
+            canvas->drawPosText(kString, length, pos, paint);
+            return;
+        }
+        default:
+            break;
+    }
+    canvas->drawText(kString, length, x, y, paint);
+}
+
+// Distance field text scaled from a field isn't the same as rasterized, but it's close.  Its
+// advances are a little off, which moves the centered, right aligned and positioned text a pixel or
+// two; a glyph drawn in the wrong place moves it by tens.
+DEF_TEST(GlyphCache_DistanceFieldText, r) {
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    REPORTER_ASSERT(r, SkDraw::ShouldDrawTextAsDistanceFields(paint, SkMatrix::I()) == false);
+
+    SkTaskScheduler scheduler(3);
+    for (int size = 20; size <= 100; size += 40) {
+        paint.setTextSize(SkIntToScalar(size));
+        for (int c = 0; c < kDistanceFieldTextCaseCount; c++) {
+            DistanceFieldTextCase textCase = (DistanceFieldTextCase)c;
+            // Rasterized, from distance fields, and from distance fields made on threads.
+            SkBitmap bitmaps[3];
+            for (int i = 0; i < 3; i++) {
+                paint.setDistanceFieldTextTEMP(i > 0);
+                bitmaps[i].allocN32Pixels(size * 12, size * 3);
+                bitmaps[i].eraseColor(SK_ColorTRANSPARENT);
+                SkAutoTUnref<SkBitmapDevice> device(SkNEW_ARGS(SkBitmapDevice, (bitmaps[i])));
+                if (2 == i) {
+                    SkGraphics::PurgeFontCache();
+                    device->setTaskScheduler(&scheduler);
+                }
+                SkCanvas canvas(device);
+                draw_text_case(&canvas, paint, textCase);
+            }
+            REPORTER_ASSERT(r, SkDraw::ShouldDrawTextAsDistanceFields(paint, SkMatrix::I()));
+            REPORTER_ASSERT(r, same_pixels(bitmaps[1], bitmaps[2]));
+
+            Coverage expected, actual;
+            measure_coverage(bitmaps[0], &expected);
+            measure_coverage(bitmaps[1], &actual);
+            REPORTER_ASSERT(r, expected.fTotal > 0);
+            REPORTER_ASSERT(r, SkTAbs(actual.fTotal - expected.fTotal) < expected.fTotal / 6);
+            REPORTER_ASSERT(r, SkTAbs(actual.fBounds.fLeft - expected.fBounds.fLeft) <= 3);
+            REPORTER_ASSERT(r, SkTAbs(actual.fBounds.fTop - expected.fBounds.fTop) <= 3);
+            REPORTER_ASSERT(r, SkTAbs(actual.fBounds.fRight - expected.fBounds.fRight) <= 3);
+            REPORTER_ASSERT(r, SkTAbs(actual.fBounds.fBottom - expected.fBounds.fBottom) <= 3);
+            REPORTER_ASSERT(r, SkScalarAbs(actual.fCenter.fX - expected.fCenter.fX) < 3);
+            REPORTER_ASSERT(r, SkScalarAbs(actual.fCenter.fY - expected.fCenter.fY) < 3);
+        }
+    }
+}
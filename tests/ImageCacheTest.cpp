@@ -6,6 +6,7 @@
  */
 
 #include "SkDiscardableMemory.h"
+#include "SkFloatBits.h"
 #include "SkScaledImageCache.h"
 #include "Test.h"
 
@@ -16,8 +17,9 @@ static void make_bm(SkBitmap* bm, int w, int h) {
 static const int COUNT = 10;
 static const int DIM = 256;
 
-static void test_cache(skiatest::Reporter* reporter, SkScaledImageCache& cache,
-                       bool testPurge) {
+// Cache is SkScaledImageCache or SkShardedScaledImageCache.
+template <typename Cache>
+static void test_cache(skiatest::Reporter* reporter, Cache& cache, bool testPurge) {
     SkScaledImageCache::ID* id;
 
     SkBitmap bm[COUNT];
@@ -105,6 +107,183 @@ DEF_TEST(ImageCache, reporter) {
     }
 }
 
+DEF_TEST(ImageCache_sharded, reporter) {
+    static const size_t defLimit = DIM * DIM * 4 * COUNT + 1024;    // 1K slop
+
+    {
+        SkShardedScaledImageCache cache(defLimit);
+        test_cache(reporter, cache, true);
+    }
+    {
+        SkAutoTUnref<SkDiscardableMemoryPool> pool(
+                SkDiscardableMemoryPool::Create(defLimit, NULL));
+        gPool = pool.get();
+        SkShardedScaledImageCache cache(pool_factory);
+        test_cache(reporter, cache, true);
+    }
+    {
+        SkShardedScaledImageCache cache(SkDiscardableMemory::Create);
+        test_cache(reporter, cache, false);
+    }
+}
+
+DEF_TEST(ImageCache_stats, reporter) {
+    SkScaledImageCache cache(DIM * DIM * 4 + 1024);  // Room for one bitmap.
+
+    SkBitmap original[2], scaled;
+    make_bm(&original[0], DIM, DIM);
+    make_bm(&original[1], DIM, DIM);
+    make_bm(&scaled, DIM, DIM);
+
+    SkBitmap tmp;
+    REPORTER_ASSERT(reporter, NULL == cache.findAndLock(original[0], 2, 2, &tmp));
+    cache.unlock(cache.addAndLock(original[0], 2, 2, scaled));
+    SkScaledImageCache::ID* id = cache.findAndLock(original[0], 2, 2, &tmp);
+    REPORTER_ASSERT(reporter, NULL != id);
+    cache.unlock(id);
+
+    // This pushes out the first one.
+    cache.unlock(cache.addAndLock(original[1], 2, 2, scaled));
+
+    SkScaledImageCache::Stats stats;
+    cache.getStats(&stats);
+    REPORTER_ASSERT(reporter, 1 == stats.fHits);
+    REPORTER_ASSERT(reporter, 1 == stats.fMisses);
+    REPORTER_ASSERT(reporter, 1 == stats.fEvictions);
+}
+
+// Keys of words match only the same words, and never bitmap keys.
+template <typename Cache>
+static void test_key_cache(skiatest::Reporter* reporter, Cache& cache) {
+    SkBitmap original, a, b, tmp;
+    make_bm(&original, DIM, DIM);
+    make_bm(&a, DIM, DIM);
+    make_bm(&b, DIM, DIM);
+
+    const uint32_t keyA[] = { 1, 2, 3 };
+    const uint32_t keyB[] = { 1, 2, 4 };
+    REPORTER_ASSERT(reporter, NULL == cache.findAndLock(keyA, 3, &tmp));
+    cache.unlock(cache.addAndLock(keyA, 3, a));
+    cache.unlock(cache.addAndLock(keyB, 3, b));
+
+    SkScaledImageCache::ID* id = cache.findAndLock(keyA, 3, &tmp);
+    REPORTER_ASSERT(reporter, NULL != id);
+    REPORTER_ASSERT(reporter, a.pixelRef() == tmp.pixelRef());
+    cache.unlock(id);
+
+    id = cache.findAndLock(keyB, 3, &tmp);
+    REPORTER_ASSERT(reporter, NULL != id);
+    REPORTER_ASSERT(reporter, b.pixelRef() == tmp.pixelRef());
+    cache.unlock(id);
+
+    REPORTER_ASSERT(reporter, NULL == cache.findAndLock(keyA, 2, &tmp));
+
+    // The same words as a bitmap key.
+    const uint32_t genID = original.getGenerationID();
+    const uint32_t bitmapKey[] = {
+        genID, (uint32_t)SkFloat2Bits(1), (uint32_t)SkFloat2Bits(1), 0, 0, DIM, DIM
+    };
+    cache.unlock(cache.addAndLock(bitmapKey, SK_ARRAY_COUNT(bitmapKey), a));
+    REPORTER_ASSERT(reporter, NULL == cache.findAndLock(genID, DIM, DIM, &tmp));
+
+    cache.setByteLimit(0);
+}
+
+DEF_TEST(ImageCache_keys, reporter) {
+    {
+        SkScaledImageCache cache(4 * DIM * DIM * 4);
+        test_key_cache(reporter, cache);
+    }
+    {
+        SkShardedScaledImageCache cache(4 * DIM * DIM * 4);
+        test_key_cache(reporter, cache);
+    }
+}
+
+DEF_TEST(ImageCache_shardedBudget, reporter) {
+    // The byte limit covers all the shards together, not each shard.
+    static const size_t kBytes = DIM * DIM * 4;
+    SkShardedScaledImageCache cache(COUNT * kBytes + 1024);
+
+    SkBitmap original[2 * COUNT], scaled;
+    make_bm(&scaled, DIM, DIM);
+    for (int i = 0; i < 2 * COUNT; ++i) {
+        make_bm(&original[i], DIM, DIM);
+        cache.unlock(cache.addAndLock(original[i], 2, 2, scaled));
+        REPORTER_ASSERT(reporter, cache.getBytesUsed() <= cache.getByteLimit());
+    }
+    REPORTER_ASSERT(reporter, COUNT * kBytes == cache.getBytesUsed());
+
+    SkScaledImageCache::Stats stats;
+    cache.getStats(&stats);
+    REPORTER_ASSERT(reporter, COUNT == stats.fEvictions);
+
+    // Locked entries survive purging.
+    SkBitmap tmp;
+    SkScaledImageCache::ID* id = cache.findAndLock(original[2 * COUNT - 1], 2, 2, &tmp);
+    REPORTER_ASSERT(reporter, NULL != id);
+    cache.setByteLimit(0);
+    REPORTER_ASSERT(reporter, kBytes == cache.getBytesUsed());
+    cache.unlock(id);
+    REPORTER_ASSERT(reporter, 0 == cache.getBytesUsed());
+}
+
+#include "SkTaskGroup.h"
+
+namespace {
+
+// Hammers a shared SkShardedScaledImageCache with lookups and adds for a few images.
+class CacheUser : public SkRunnable {
+public:
+    CacheUser() : fCache(NULL), fOriginals(NULL) {}
+
+    virtual void run() SK_OVERRIDE {
+        for (int i = 0; i < 100; ++i) {
+            const SkBitmap& original = fOriginals[i % COUNT];
+            SkBitmap tmp;
+            SkScaledImageCache::ID* id = fCache->findAndLock(original, 2, 2, &tmp);
+            if (NULL == id) {
+                make_bm(&tmp, DIM / 4, DIM / 4);
+                id = fCache->addAndLock(original, 2, 2, tmp);
+            }
+            fCache->unlock(id);
+        }
+    }
+
+    SkShardedScaledImageCache* fCache;
+    const SkBitmap* fOriginals;
+};
+
+}  // namespace
+
+DEF_TEST(ImageCache_shardedThreads, reporter) {
+    static const size_t kBytes = DIM / 4 * DIM / 4 * 4;
+    SkShardedScaledImageCache cache(COUNT / 2 * kBytes);  // Room for half of them.
+
+    SkBitmap originals[COUNT];
+    for (int i = 0; i < COUNT; ++i) {
+        make_bm(&originals[i], DIM, DIM);
+    }
+
+    static const int kUsers = 8;
+    CacheUser users[kUsers];
+    {
+        SkTaskScheduler scheduler(4);
+        SkTaskGroup group(&scheduler);
+        for (int i = 0; i < kUsers; ++i) {
+            users[i].fCache = &cache;
+            users[i].fOriginals = originals;
+            group.add(&users[i]);
+        }
+        group.wait();
+    }
+
+    REPORTER_ASSERT(reporter, cache.getBytesUsed() <= cache.getByteLimit());
+    SkScaledImageCache::Stats stats;
+    cache.getStats(&stats);
+    REPORTER_ASSERT(reporter, kUsers * 100 == stats.fHits + stats.fMisses);
+}
+
 DEF_TEST(ImageCache_doubleAdd, r) {
     // Adding the same key twice should be safe.
     SkScaledImageCache cache(4096);
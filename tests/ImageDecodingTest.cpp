@@ -521,6 +521,145 @@ DEF_TEST(ImprovedBitmapFactory, reporter) {
 }
 
 
+// Area-averages src down to dst's size, in floating point.
+static void area_average(const SkBitmap& src, SkBitmap* dst) {
+    SkAutoLockPixels alpSrc(src), alpDst(*dst);
+    const double sx = (double)src.width() / dst->width();
+    const double sy = (double)src.height() / dst->height();
+    for (int y = 0; y < dst->height(); y++) {
+        for (int x = 0; x < dst->width(); x++) {
+            double sums[4] = { 0, 0, 0, 0 };
+            for (int j = (int)(y * sy); j < src.height() && j < (y + 1) * sy; j++) {
+                double h = SkTMin<double>(j + 1, (y + 1) * sy) - SkTMax<double>(j, y * sy);
+                for (int i = (int)(x * sx); i < src.width() && i < (x + 1) * sx; i++) {
+                    double w = SkTMin<double>(i + 1, (x + 1) * sx) - SkTMax<double>(i, x * sx);
+                    SkPMColor c = *src.getAddr32(i, j);
+                    sums[0] += SkGetPackedA32(c) * w * h;
+                    sums[1] += SkGetPackedR32(c) * w * h;
+                    sums[2] += SkGetPackedG32(c) * w * h;
+                    sums[3] += SkGetPackedB32(c) * w * h;
+                }
+            }
+            const double area = sx * sy;
+            *dst->getAddr32(x, y) = SkPackARGB32((int)(sums[0] / area + 0.5),
+                                                 (int)(sums[1] / area + 0.5),
+                                                 (int)(sums[2] / area + 0.5),
+                                                 (int)(sums[3] / area + 0.5));
+        }
+    }
+}
+
+// Returns the largest difference in any channel of any pixel, and the mean difference.
+static int compare_pixels(const SkBitmap& a, const SkBitmap& b, double* mean) {
+    SkAutoLockPixels alpA(a), alpB(b);
+    int maxDiff = 0;
+    double total = 0;
+    for (int y = 0; y < a.height(); y++) {
+        for (int x = 0; x < a.width(); x++) {
+            SkPMColor ca = *a.getAddr32(x, y), cb = *b.getAddr32(x, y);
+            for (int shift = 0; shift < 32; shift += 8) {
+                int diff = SkAbs32((int)((ca >> shift) & 0xFF) - (int)((cb >> shift) & 0xFF));
+                maxDiff = SkMax32(maxDiff, diff);
+                total += diff;
+            }
+        }
+    }
+    *mean = total / (4.0 * a.width() * a.height());
+    return maxDiff;
+}
+
+static void test_target_size(skiatest::Reporter* reporter, const SkString& path,
+                             int width, int height, int maxDiff, double maxMean) {
+    SkAutoTUnref<SkData> data(SkData::NewFromFileName(path.c_str()));
+    if (NULL == data.get()) {
+        return;
+    }
+    SkBitmap full;
+    if (!SkImageDecoder::DecodeMemory(data->data(), data->size(), &full,
+                                      SkBitmap::kARGB_8888_Config,
+                                      SkImageDecoder::kDecodePixels_Mode)) {
+        ERRORF(reporter, "failed to decode %s", path.c_str());
+        return;
+    }
+    SkBitmap expected;
+    expected.allocPixels(SkImageInfo::MakeN32Premul(width, height));
+    area_average(full, &expected);
+
+    // Straight from the decoder.
+    SkMemoryStream stream(data);
+    SkAutoTDelete<SkImageDecoder> decoder(SkImageDecoder::Factory(&stream));
+    REPORTER_ASSERT(reporter, NULL != decoder.get());
+    decoder->setTargetSize(width, height);
+    SkBitmap bounds;
+    REPORTER_ASSERT(reporter, decoder->decode(&stream, &bounds, SkBitmap::kARGB_8888_Config,
+                                              SkImageDecoder::kDecodeBounds_Mode));
+    REPORTER_ASSERT(reporter, bounds.width() == width && bounds.height() == height);
+    stream.rewind();
+    SkBitmap decoded;
+    REPORTER_ASSERT(reporter, decoder->decode(&stream, &decoded, SkBitmap::kARGB_8888_Config,
+                                              SkImageDecoder::kDecodePixels_Mode));
+    if (decoded.width() != width || decoded.height() != height) {
+        ERRORF(reporter, "%s decoded to %dx%d, not %dx%d", path.c_str(),
+               decoded.width(), decoded.height(), width, height);
+        return;
+    }
+    double mean;
+    int diff = compare_pixels(decoded, expected, &mean);
+    if (diff > maxDiff || mean > maxMean) {
+        ERRORF(reporter, "%s at %dx%d is off by up to %d, %g on average",
+               path.c_str(), width, height, diff, mean);
+    }
+
+    // Through SkImageGenerator::getPixels(), which should match.
+    SkAutoTDelete<SkImageGenerator> gen(SkDecodingImageGenerator::Create(
+            data, SkDecodingImageGenerator::Options(1, true, kN32_SkColorType)));
+    REPORTER_ASSERT(reporter, NULL != gen.get());
+    SkImageInfo info;
+    REPORTER_ASSERT(reporter, gen->getInfo(&info));
+    SkBitmap generated;
+    generated.allocPixels(SkImageInfo::Make(width, height, info.colorType(), info.alphaType()));
+    SkAutoLockPixels alp(generated);
+    REPORTER_ASSERT(reporter, gen->getPixels(generated.info(), generated.getPixels(),
+                                             generated.rowBytes()));
+    REPORTER_ASSERT(reporter, 0 == compare_pixels(generated, decoded, &mean));
+
+    // Bigger than the image is not supported.
+    SkImageInfo bigger = info;
+    bigger.fWidth += 1;
+    REPORTER_ASSERT(reporter, !gen->getPixels(bigger, generated.getPixels(),
+                                              generated.rowBytes()));
+}
+
+/**
+ *  SkImageDecoder::setTargetSize() should area-average JPEGs and PNGs as they are decoded.
+ */
+DEF_TEST(ImageDecoding_targetSize, reporter) {
+    SkString resourcePath = skiatest::Test::GetResourcePath();
+    const struct {
+        const char* fName;
+        int fWidth, fHeight;
+        int fMaxDiff;
+        double fMaxMean;
+    } gRecs[] = {
+        // These average exactly what a full decode produces.
+        { "randPixels.png", 3, 5, 1, 0.5 },
+        { "randPixels.jpg", 5, 3, 1, 0.5 },
+        { "baby_tux.png", 100, 61, 1, 0.5 },
+        { "mandrill_512.png", 512, 511, 1, 0.5 },
+        { "mandrill_512.png", 37, 200, 1, 0.5 },
+        { "mandrill_512.png", 1, 1, 1, 0.5 },
+        // This one lets libjpeg scale it by 1/4 first.  That blurs sharp edges differently,
+        // but should be close on average.
+        { "CMYK.jpg", 150, 100, 255, 2 },
+    };
+    for (size_t i = 0; i < SK_ARRAY_COUNT(gRecs); i++) {
+        SkString path = SkOSPath::SkPathJoin(resourcePath.c_str(), gRecs[i].fName);
+        test_target_size(reporter, path, gRecs[i].fWidth, gRecs[i].fHeight,
+                         gRecs[i].fMaxDiff, gRecs[i].fMaxMean);
+    }
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 
 #if defined(SK_BUILD_FOR_ANDROID) || defined(SK_BUILD_FOR_UNIX)
@@ -13,10 +13,13 @@
 #include "SkMatrix.h"
 #include "SkPDFCatalog.h"
 #include "SkPDFDevice.h"
+#include "SkPDFDocument.h"
 #include "SkPDFStream.h"
 #include "SkPDFTypes.h"
+#include "SkRandom.h"
 #include "SkScalar.h"
 #include "SkStream.h"
+#include "SkTaskGroup.h"
 #include "SkTypes.h"
 #include "Test.h"
 
@@ -322,6 +325,127 @@ static void TestImages(skiatest::Reporter* reporter) {
     TestDCTDecode(reporter);
 }
 
+static int count_images(const SkDynamicMemoryWStream& stream) {
+    SkAutoDataUnref data(stream.copyToData());
+    const char kImage[] = "/Subtype /Image\n";
+    const size_t len = strlen(kImage);
+    int count = 0;
+    for (size_t offset = 0; offset + len <= data->size(); offset++) {
+        if (memcmp(data->bytes() + offset, kImage, len) == 0) {
+            count++;
+        }
+    }
+    return count;
+}
+
+static int count_images_in_document(const SkBitmap bitmaps[], int bitmapCount) {
+    SkPDFDocument doc;
+    for (int i = 0; i < bitmapCount; i++) {
+        SkISize pageSize = SkISize::Make(100, 100);
+        SkAutoTUnref<SkPDFDevice> dev(new SkPDFDevice(pageSize, pageSize, SkMatrix::I()));
+        SkCanvas c(dev);
+        c.drawBitmap(bitmaps[i], 0, 0, NULL);
+        c.drawBitmap(bitmaps[i], 50, 50, NULL);
+        doc.appendPage(dev);
+    }
+    SkDynamicMemoryWStream stream;
+    doc.emitPDF(&stream);
+    return count_images(stream);
+}
+
+// Images are shared by every page that draws the same pixels.
+static void TestImageCanonicalization(skiatest::Reporter* reporter) {
+    SkBitmap bitmaps[4];
+    setup_bitmap(&bitmaps[0], 10, 10);
+    bitmaps[1] = bitmaps[0];
+    REPORTER_ASSERT(reporter, 1 == count_images_in_document(bitmaps, 2));
+
+    // A copy keeps the generation ID, so it shares the image too.
+    bitmaps[0].deepCopyTo(&bitmaps[2]);
+    REPORTER_ASSERT(reporter, 1 == count_images_in_document(bitmaps, 3));
+
+    // A different part of the same pixel ref.
+    bitmaps[0].extractSubset(&bitmaps[3], SkIRect::MakeXYWH(2, 2, 5, 5));
+    REPORTER_ASSERT(reporter, 2 == count_images_in_document(bitmaps, 4));
+
+    // Pixels changed between pages.
+    SkBitmap changed;
+    bitmaps[0].deepCopyTo(&changed);
+    SkPDFDocument doc;
+    for (int i = 0; i < 2; i++) {
+        SkISize pageSize = SkISize::Make(100, 100);
+        SkAutoTUnref<SkPDFDevice> dev(new SkPDFDevice(pageSize, pageSize, SkMatrix::I()));
+        SkCanvas c(dev);
+        c.drawBitmap(changed, 0, 0, NULL);
+        doc.appendPage(dev);
+        changed.eraseColor(SK_ColorBLACK);
+    }
+    SkDynamicMemoryWStream stream;
+    doc.emitPDF(&stream);
+    REPORTER_ASSERT(reporter, 2 == count_images(stream));
+
+    // A translucent image shares its soft mask too; one drawn in a layer is
+    // shared with the page; and a streaming document shares images as well.
+    SkBitmap translucent;
+    translucent.allocN32Pixels(10, 10);
+    translucent.eraseColor(0x80FFFFFF);
+    SkDynamicMemoryWStream streamed;
+    SkPDFDocument streamingDoc(&streamed);
+    for (int i = 0; i < 2; i++) {
+        SkISize pageSize = SkISize::Make(100, 100);
+        SkAutoTUnref<SkPDFDevice> dev(new SkPDFDevice(pageSize, pageSize, SkMatrix::I()));
+        SkCanvas c(dev);
+        c.drawBitmap(translucent, 0, 0, NULL);
+        c.saveLayer(NULL, NULL);
+        c.drawBitmap(translucent, 50, 50, NULL);
+        c.restore();
+        streamingDoc.appendPage(dev);
+    }
+    streamingDoc.emitPDF(&streamed);
+    REPORTER_ASSERT(reporter, 2 == count_images(streamed));
+}
+
+static size_t document_size(const SkBitmap bitmaps[], int bitmapCount) {
+    SkPDFDocument doc;
+    for (int i = 0; i < bitmapCount; i++) {
+        SkISize pageSize = SkISize::Make(100, 100);
+        SkAutoTUnref<SkPDFDevice> dev(new SkPDFDevice(pageSize, pageSize, SkMatrix::I()));
+        SkCanvas c(dev);
+        c.drawBitmap(bitmaps[i], 0, 0, NULL);
+        doc.appendPage(dev);
+    }
+    SkDynamicMemoryWStream stream;
+    doc.emitPDF(&stream);
+    return stream.bytesWritten();
+}
+
+// Every page after the first that shares an image saves the whole image.
+static void TestImageSharingSize(skiatest::Reporter* reporter) {
+    static const int kPages = 4;
+    static const int kSize = 64;
+    SkBitmap shared[kPages], unique[kPages];
+    shared[0].allocN32Pixels(kSize, kSize, true);
+    SkRandom rand;
+    for (int y = 0; y < kSize; y++) {
+        for (int x = 0; x < kSize; x++) {
+            // Noise, which doesn't compress.
+            *shared[0].getAddr32(x, y) = rand.nextU() | 0xFF000000;
+        }
+    }
+    for (int i = 0; i < kPages; i++) {
+        shared[i] = shared[0];
+        // Not copyTo(), which would give the copy the same generation ID.
+        unique[i].allocN32Pixels(kSize, kSize, true);
+        memcpy(unique[i].getPixels(), shared[0].getPixels(), shared[0].getSize());
+    }
+
+    const size_t imageSize = kSize * kSize * 3;
+    const size_t sharedSize = document_size(shared, kPages);
+    const size_t uniqueSize = document_size(unique, kPages);
+    REPORTER_ASSERT(reporter, uniqueSize > (kPages - 1) * imageSize);
+    REPORTER_ASSERT(reporter, uniqueSize - sharedSize > (kPages - 1) * imageSize * 9 / 10);
+}
+
 // This test used to assert without the fix submitted for
 // http://code.google.com/p/skia/issues/detail?id=1083.
 // SKP files might have invalid glyph ids. This test ensures they are ignored,
@@ -344,6 +468,126 @@ static void test_issue1083() {
     doc.emitPDF(&stream);
 }
 
+static SkPDFDevice* make_page(int page, const SkBitmap& logo) {
+    SkISize pageSize = SkISize::Make(200, 100);
+    SkPDFDevice* dev = new SkPDFDevice(pageSize, pageSize, SkMatrix::I());
+    SkCanvas c(dev);
+    SkPaint paint;
+    paint.setColor(SK_ColorBLUE);
+    c.drawRect(SkRect::MakeXYWH(10, 10, SkIntToScalar(10 + page), 10), paint);
+    c.drawBitmap(logo, 50, 50, NULL);
+    SkString text;
+    text.printf("Page %d", page);
+    c.drawText(text.c_str(), text.size(), 10, 80, paint);
+    return dev;
+}
+
+// Returns the offset of the last match of str in data, or -1.
+static long find_last(const SkData* data, const char* str) {
+    long len = strlen(str);
+    for (long offset = (long)data->size() - len; offset >= 0; offset--) {
+        if (memcmp(data->bytes() + offset, str, len) == 0) {
+            return offset;
+        }
+    }
+    return -1;
+}
+
+static bool data_equals(const SkData* data, long offset, const char* str) {
+    size_t len = strlen(str);
+    return offset >= 0 && offset + len <= data->size() &&
+           memcmp(data->bytes() + offset, str, len) == 0;
+}
+
+// Checks that the cross reference table points at each object in turn.
+static bool xref_is_valid(const SkData* pdf) {
+    long startxref = find_last(pdf, "startxref\n");
+    long trailer = find_last(pdf, "trailer\n");
+    if (startxref < 0 || trailer < 0) {
+        return false;
+    }
+    // What follows startxref is all text.
+    SkString tail((const char*)pdf->bytes() + startxref, pdf->size() - startxref);
+    long xref = atol(tail.c_str() + strlen("startxref\n"));
+    if (!data_equals(pdf, xref, "xref\n0 ") || xref > trailer) {
+        return false;
+    }
+    SkString table((const char*)pdf->bytes() + xref, pdf->size() - xref);
+    int count = atoi(table.c_str() + strlen("xref\n0 "));
+    const char* entries = strchr(table.c_str(), '\n') + 1;
+    entries = strchr(entries, '\n') + 1;
+    for (int i = 1; i < count; i++) {
+        long offset = atol(entries + 20 * i);
+        SkString expected;
+        expected.printf("%d 0 obj\n", i);
+        if (offset >= xref || !data_equals(pdf, offset, expected.c_str())) {
+            return false;
+        }
+    }
+    SkString size;
+    size.printf("/Size %d\n", count);
+    return count > 1 && strstr(table.c_str(), size.c_str()) != NULL;
+}
+
+static SkData* emit_document(SkPDFDocument* doc, SkDynamicMemoryWStream* stream,
+                             const SkBitmap& logo, int firstPage, int pageCount) {
+    for (int i = firstPage; i < pageCount; i++) {
+        SkAutoTUnref<SkPDFDevice> dev(make_page(i, logo));
+        doc->appendPage(dev);
+    }
+    if (!doc->emitPDF(stream)) {
+        return NULL;
+    }
+    return stream->copyToData();
+}
+
+static void TestStreamingDocument(skiatest::Reporter* reporter) {
+    SkBitmap logo;
+    logo.allocN32Pixels(16, 16);
+    logo.eraseColor(SK_ColorRED);
+    const int kPageCount = 10;
+
+    SkDynamicMemoryWStream batchStream;
+    SkAutoTUnref<SkData> batch;
+    {
+        SkPDFDocument doc;
+        batch.reset(emit_document(&doc, &batchStream, logo, 0, kPageCount));
+    }
+    REPORTER_ASSERT(reporter, batch.get() && xref_is_valid(batch));
+
+    // Without a scheduler, pages are written as soon as they're appended.
+    SkDynamicMemoryWStream serialStream;
+    SkAutoTUnref<SkData> serial;
+    {
+        SkPDFDocument doc(&serialStream);
+        SkAutoTUnref<SkPDFDevice> dev(make_page(0, logo));
+        doc.appendPage(dev);
+        REPORTER_ASSERT(reporter, stream_contains(serialStream, "%PDF-1.4"));
+        REPORTER_ASSERT(reporter, stream_contains(serialStream, " 0 obj\n"));
+
+        SkDynamicMemoryWStream otherStream;
+        REPORTER_ASSERT(reporter, !doc.emitPDF(&otherStream));
+        REPORTER_ASSERT(reporter, !doc.setPage(1, dev));
+
+        serial.reset(emit_document(&doc, &serialStream, logo, 1, kPageCount));
+        REPORTER_ASSERT(reporter, !doc.emitPDF(&serialStream));
+    }
+    REPORTER_ASSERT(reporter, serial.get() && xref_is_valid(serial));
+
+    // Compressing on other threads may write pages' objects in another order,
+    // but doesn't change them.
+    SkTaskScheduler scheduler(3);
+    SkDynamicMemoryWStream threadedStream;
+    SkAutoTUnref<SkData> threaded;
+    {
+        SkPDFDocument doc(&threadedStream, (SkPDFDocument::Flags)0, &scheduler);
+        threaded.reset(emit_document(&doc, &threadedStream, logo, 0, kPageCount));
+    }
+    REPORTER_ASSERT(reporter, threaded.get() && xref_is_valid(threaded));
+    REPORTER_ASSERT(reporter, threaded.get() && serial.get() &&
+                              threaded->size() == serial->size());
+}
+
 DEF_TEST(PDFPrimitives, reporter) {
     SkAutoTUnref<SkPDFInt> int42(new SkPDFInt(42));
     SimpleCheckObjectOutput(reporter, int42.get(), "42");
@@ -427,4 +671,7 @@ DEF_TEST(PDFPrimitives, reporter) {
     test_issue1083();
 
     TestImages(reporter);
+    TestImageCanonicalization(reporter);
+    TestImageSharingSize(reporter);
+    TestStreamingDocument(reporter);
 }
@@ -5,13 +5,17 @@
  * found in the LICENSE file.
  */
 
+#include "SkBitmap.h"
 #include "SkBlurMask.h"
 #include "SkBlurMaskFilter.h"
+#include "SkCanvas.h"
+#include "SkGraphics.h"
 #include "SkLayerDrawLooper.h"
 #include "SkPaint.h"
 #include "SkPath.h"
 #include "SkRandom.h"
 #include "SkReadBuffer.h"
+#include "SkString.h"
 #include "SkTypeface.h"
 #include "SkUtils.h"
 #include "SkWriteBuffer.h"
@@ -313,6 +317,151 @@ DEF_TEST(Paint_regression_measureText, reporter) {
     REPORTER_ASSERT(reporter, r.isEmpty());
 }
 
+struct TextMeasurements {
+    SkScalar    fWidth;
+    SkScalar    fWidths[64];
+    size_t      fBreakBytes[2][4];
+    SkScalar    fBreakWidths[2][4];
+
+    void measure(const SkPaint& paint, const void* text, size_t length) {
+        sk_bzero(this, sizeof(*this));
+        fWidth = paint.measureText(text, length);
+        SkASSERT(paint.countText(text, length) <= (int)SK_ARRAY_COUNT(fWidths));
+        paint.getTextWidths(text, length, fWidths);
+        // SkUTF8_PrevUnichar() only steps back over ASCII, so only break UTF-16 backwards.
+        const int dirs = SkPaint::kUTF8_TextEncoding == paint.getTextEncoding() ? 1 : 2;
+        for (int dir = 0; dir < dirs; ++dir) {
+            for (int i = 0; i < 4; ++i) {
+                fBreakBytes[dir][i] = paint.breakText(text, length, fWidth * (i + 1) / 4,
+                                                      &fBreakWidths[dir][i],
+                                                      (SkPaint::TextBufferDirection)dir);
+            }
+        }
+    }
+};
+
+// Text measured through the text measure cache must come out just as it does without it.
+DEF_TEST(Paint_TextMeasureCache, reporter) {
+    static const char gText8[] = "Hello, w\xC3\xB6rld \xE2\x80\x94 AVAST, To.";
+    uint16_t text16[64];
+    int count16 = 0;
+    for (const char* utf8 = gText8; *utf8;) {
+        count16 += SkToInt(SkUTF16_FromUnichar(SkUTF8_NextUnichar(&utf8), text16 + count16));
+    }
+
+    static const uint32_t gFlags[] = {
+        0,
+        SkPaint::kAntiAlias_Flag,
+        SkPaint::kDevKernText_Flag,
+        SkPaint::kLinearText_Flag | SkPaint::kDevKernText_Flag,
+        SkPaint::kVerticalText_Flag,
+    };
+    static const SkScalar gSizes[] = { 12, 31, 300 };
+
+    size_t prevLimit = SkGraphics::SetTextMeasureCacheLimit(0);
+    for (size_t f = 0; f < SK_ARRAY_COUNT(gFlags); ++f) {
+        for (size_t s = 0; s < SK_ARRAY_COUNT(gSizes); ++s) {
+            for (int utf16 = 0; utf16 < 2; ++utf16) {
+                SkPaint paint;
+                paint.setFlags(gFlags[f]);
+                paint.setTextSize(gSizes[s]);
+                paint.setTextEncoding(utf16 ? SkPaint::kUTF16_TextEncoding
+                                            : SkPaint::kUTF8_TextEncoding);
+                const void* text = utf16 ? (const void*)text16 : (const void*)gText8;
+                size_t length = utf16 ? count16 * sizeof(uint16_t) : strlen(gText8);
+
+                TextMeasurements expected, actual;
+                SkGraphics::SetTextMeasureCacheLimit(0);
+                expected.measure(paint, text, length);
+
+                SkGraphics::SetTextMeasureCacheLimit(64 * 1024);
+                // Once to fill the cache, and once from it.
+                for (int pass = 0; pass < 2; ++pass) {
+                    actual.measure(paint, text, length);
+                    REPORTER_ASSERT(reporter, 0 == memcmp(&expected, &actual, sizeof(actual)));
+                }
+            }
+        }
+    }
+
+    // Likewise for text measured again after a small cache has dropped some of it.
+    // Other tests share the cache, so we check what we measure, not how many bytes it holds.
+    static const int kLines = 100;
+    SkPaint paint;
+    SkString text;
+    SkScalar expected[kLines];
+    SkGraphics::SetTextMeasureCacheLimit(0);
+    for (int i = 0; i < kLines; ++i) {
+        text.printf("line %d of the text", i);
+        expected[i] = paint.measureText(text.c_str(), text.size());
+    }
+    SkGraphics::SetTextMeasureCacheLimit(2048);
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int i = 0; i < kLines; ++i) {
+            text.printf("line %d of the text", i);
+            REPORTER_ASSERT(reporter, expected[i] == paint.measureText(text.c_str(), text.size()));
+        }
+    }
+    SkGraphics::SetTextMeasureCacheLimit(prevLimit);
+}
+
+// ASCII and Latin-1 text looked up through the typeface's cmap cache must measure and draw just
+// as the same text does as glyph IDs.
+DEF_TEST(Paint_Latin1Glyphs, reporter) {
+    static const char gText8[] = "Hello, w\xC3\xB6rld \xE2\x80\x94 AVAST, To.";
+    uint16_t text16[64];
+    int count16 = 0;
+    for (const char* utf8 = gText8; *utf8;) {
+        count16 += SkToInt(SkUTF16_FromUnichar(SkUTF8_NextUnichar(&utf8), text16 + count16));
+    }
+
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    paint.setSubpixelText(true);
+    paint.setTextSize(31);
+    uint16_t glyphs[64];
+    const int glyphCount = paint.textToGlyphs(gText8, strlen(gText8), glyphs);
+
+    size_t prevLimit = SkGraphics::SetTextMeasureCacheLimit(0);
+    TextMeasurements expected;
+    paint.setTextEncoding(SkPaint::kGlyphID_TextEncoding);
+    expected.measure(paint, glyphs, glyphCount * sizeof(uint16_t));
+    SkRect expectedBounds;
+    paint.measureText(glyphs, glyphCount * sizeof(uint16_t), &expectedBounds);
+
+    SkBitmap expectedBitmap;
+    expectedBitmap.allocN32Pixels(640, 48);
+    expectedBitmap.eraseColor(SK_ColorWHITE);
+    SkCanvas(expectedBitmap).drawText(glyphs, glyphCount * sizeof(uint16_t), 3.5f, 36, paint);
+
+    for (int utf16 = 0; utf16 < 2; ++utf16) {
+        paint.setTextEncoding(utf16 ? SkPaint::kUTF16_TextEncoding
+                                    : SkPaint::kUTF8_TextEncoding);
+        const void* text = utf16 ? (const void*)text16 : (const void*)gText8;
+        size_t length = utf16 ? count16 * sizeof(uint16_t) : strlen(gText8);
+
+        TextMeasurements actual;
+        actual.measure(paint, text, length);
+        REPORTER_ASSERT(reporter, expected.fWidth == actual.fWidth);
+        REPORTER_ASSERT(reporter, 0 == memcmp(expected.fWidths, actual.fWidths,
+                                              sizeof(actual.fWidths)));
+        REPORTER_ASSERT(reporter, 0 == memcmp(expected.fBreakWidths[0], actual.fBreakWidths[0],
+                                              sizeof(actual.fBreakWidths[0])));
+        SkRect bounds;
+        paint.measureText(text, length, &bounds);
+        REPORTER_ASSERT(reporter, expectedBounds == bounds);
+
+        SkBitmap bitmap;
+        bitmap.allocN32Pixels(640, 48);
+        bitmap.eraseColor(SK_ColorWHITE);
+        SkCanvas(bitmap).drawText(text, length, 3.5f, 36, paint);
+        SkAutoLockPixels lockExpected(expectedBitmap), lock(bitmap);
+        REPORTER_ASSERT(reporter, 0 == memcmp(expectedBitmap.getPixels(), bitmap.getPixels(),
+                                              bitmap.getSize()));
+    }
+    SkGraphics::SetTextMeasureCacheLimit(prevLimit);
+}
+
 #define ASSERT(expr) REPORTER_ASSERT(r, expr)
 
 DEF_TEST(Paint_FlatteningTraits, r) {
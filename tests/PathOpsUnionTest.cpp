@@ -0,0 +1,111 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "PathOpsExtendedTest.h"
+#include "SkRandom.h"
+#include "SkRegion.h"
+#include "SkTaskGroup.h"
+
+// Overlapping polygons of 3 to 12 sides, like building outlines on a map.
+static void make_polygons(SkRandom* rand, int count, SkTArray<SkPath>* polygons) {
+    for (int index = 0; index < count; ++index) {
+        SkScalar cx = rand->nextRangeScalar(20, 236);
+        SkScalar cy = rand->nextRangeScalar(20, 236);
+        SkScalar radius = rand->nextRangeScalar(5, 20);
+        SkScalar start = rand->nextRangeScalar(0, SK_ScalarPI);
+        int sides = rand->nextRangeU(3, 12);
+        SkPath& polygon = polygons->push_back();
+        for (int side = 0; side < sides; ++side) {
+            SkScalar angle = start + 2 * SK_ScalarPI * side / sides;
+            SkScalar r = radius * rand->nextRangeScalar(0.7f, 1);
+            SkPoint pt = SkPoint::Make(cx + r * SkScalarCos(angle), cy + r * SkScalarSin(angle));
+            if (0 == side) {
+                polygon.moveTo(pt);
+            } else {
+                polygon.lineTo(pt);
+            }
+        }
+        polygon.close();
+    }
+}
+
+// Counts the pixels covered by exactly one of the paths.
+static int count_different_pixels(const SkPath& one, const SkPath& two) {
+    SkRegion clip(SkIRect::MakeWH(256, 256));
+    SkRegion oneRegion, twoRegion;
+    oneRegion.setPath(one, clip);
+    twoRegion.setPath(two, clip);
+    SkRegion diff;
+    diff.op(oneRegion, twoRegion, SkRegion::kXOR_Op);
+    int pixels = 0;
+    for (SkRegion::Iterator iter(diff); !iter.done(); iter.next()) {
+        pixels += iter.rect().width() * iter.rect().height();
+    }
+    return pixels;
+}
+
+DEF_TEST(PathOpsUnion, reporter) {
+    SkRandom rand;
+    SkTArray<SkPath> polygons;
+    make_polygons(&rand, 101, &polygons);
+    SkPath all;
+    for (int index = 0; index < polygons.count(); ++index) {
+        all.addPath(polygons[index]);
+    }
+
+    SkPath simplified;
+    REPORTER_ASSERT(reporter, Simplify(all, &simplified));
+    SkPath result;
+    REPORTER_ASSERT(reporter, Union(polygons.begin(), polygons.count(), &result));
+    REPORTER_ASSERT(reporter, 0 == count_different_pixels(simplified, result));
+
+    SkTaskScheduler scheduler(2);
+    SkPath parallel;
+    REPORTER_ASSERT(reporter, Union(polygons.begin(), polygons.count(), &parallel, &scheduler));
+    REPORTER_ASSERT(reporter, parallel == result);
+
+    REPORTER_ASSERT(reporter, Union(polygons.begin(), 0, &result));
+    REPORTER_ASSERT(reporter, result.isEmpty());
+    REPORTER_ASSERT(reporter, Union(polygons.begin(), 1, &result));
+    REPORTER_ASSERT(reporter, 0 == count_different_pixels(polygons[0], result));
+}
+
+// Contours with enough segments that AddIntersectTs() sweeps for the pairs to intersect.
+DEF_TEST(PathOpsSweep, reporter) {
+    SkPath star;
+    const int points = 101;
+    for (int index = 0; index < points; ++index) {
+        SkScalar angle = 2 * SK_ScalarPI * (index * 3 % points) / points;
+        SkPoint pt = SkPoint::Make(128 + 100 * SkScalarCos(angle), 128 + 100 * SkScalarSin(angle));
+        if (0 == index) {
+            star.moveTo(pt);
+        } else {
+            star.lineTo(pt);
+        }
+    }
+    star.close();
+    testSimplify(reporter, star, "sweepStar");
+
+    SkRandom rand;
+    SkPath jagged[2];
+    for (int path = 0; path < 2; ++path) {
+        for (int index = 0; index < 60; ++index) {
+            SkScalar angle = 2 * SK_ScalarPI * index / 60;
+            SkScalar r = rand.nextRangeScalar(60, 100);
+            SkPoint pt = SkPoint::Make(100 + 30 * path + r * SkScalarCos(angle),
+                                       100 + r * SkScalarSin(angle));
+            if (0 == index) {
+                jagged[path].moveTo(pt);
+            } else {
+                jagged[path].lineTo(pt);
+            }
+        }
+        jagged[path].close();
+    }
+    testPathOp(reporter, jagged[0], jagged[1], kUnion_PathOp, "sweepUnion");
+    testPathOp(reporter, jagged[0], jagged[1], kIntersect_PathOp, "sweepIntersect");
+    testPathOp(reporter, jagged[0], jagged[1], kDifference_PathOp, "sweepDifference");
+}
@@ -3514,3 +3514,58 @@ DEF_TEST(Paths, reporter) {
     PathTest_Private::TestPathTo(reporter);
     PathRefTest_Private::TestPathRef(reporter);
 }
+
+DEF_TEST(Paths_bulkAppend, reporter) {
+    SkPoint pts[40];
+    SkRandom rand;
+    for (size_t i = 0; i < SK_ARRAY_COUNT(pts); ++i) {
+        pts[i].fX = rand.nextSScalar1();
+        pts[i].fY = rand.nextSScalar1();
+    }
+    const int counts[] = { 3, 0, 1, 7, 12, 2, 15 };
+
+    for (int doClose = 0; doClose <= 1; ++doClose) {
+        SkPath polys, expected;
+        polys.incReserve(50, SK_ARRAY_COUNT(pts));
+        REPORTER_ASSERT(reporter, polys.isEmpty());
+        polys.addPolys(SkPath::kLine_Verb, pts, counts, SK_ARRAY_COUNT(counts),
+                       SkToBool(doClose));
+        const SkPoint* contour = pts;
+        for (size_t i = 0; i < SK_ARRAY_COUNT(counts); ++i) {
+            if (counts[i] > 0) {
+                expected.moveTo(contour[0]);
+                for (int j = 1; j < counts[i]; ++j) {
+                    expected.lineTo(contour[j]);
+                }
+                if (doClose) {
+                    expected.close();
+                }
+            }
+            contour += counts[i];
+        }
+        REPORTER_ASSERT(reporter, polys == expected);
+        REPORTER_ASSERT(reporter, polys.getBounds() == expected.getBounds());
+
+        for (int count = 1; count <= 10; ++count) {
+            SkPath quads, cubics, expectedQuads, expectedCubics;
+            quads.addPolys(SkPath::kQuad_Verb, pts, &count, 1, SkToBool(doClose));
+            cubics.addPolys(SkPath::kCubic_Verb, pts, &count, 1, SkToBool(doClose));
+            expectedQuads.moveTo(pts[0]);
+            expectedCubics.moveTo(pts[0]);
+            for (int i = 1; i + 1 < count; i += 2) {
+                expectedQuads.quadTo(pts[i], pts[i + 1]);
+            }
+            for (int i = 1; i + 2 < count; i += 3) {
+                expectedCubics.cubicTo(pts[i], pts[i + 1], pts[i + 2]);
+            }
+            if (doClose) {
+                expectedQuads.close();
+                expectedCubics.close();
+            }
+            REPORTER_ASSERT(reporter, quads == expectedQuads);
+            REPORTER_ASSERT(reporter, cubics == expectedCubics);
+            REPORTER_ASSERT(reporter, quads.getSegmentMasks() == expectedQuads.getSegmentMasks());
+            REPORTER_ASSERT(reporter, cubics.getSegmentMasks() == expectedCubics.getSegmentMasks());
+        }
+    }
+}
@@ -8,6 +8,7 @@
 #include "Test.h"
 #include "RecordTestUtils.h"
 
+#include "SkBBHFactory.h"
 #include "SkDebugCanvas.h"
 #include "SkRecord.h"
 #include "SkRecordOpts.h"
@@ -103,3 +104,152 @@ DEF_TEST(RecordDraw_SetMatrixClobber, r) {
     expected.postConcat(translate);
     REPORTER_ASSERT(r, setMatrix->matrix == expected);
 }
+
+DEF_TEST(RecordDraw_BBH, r) {
+    SkRecord record;
+    SkRecorder recorder(&record, W, H);
+
+    recorder.drawRect(SkRect::MakeWH(10, 10), SkPaint());      // Inside the clip below.
+    recorder.save();
+        recorder.translate(1000, 1000);
+        recorder.drawRect(SkRect::MakeWH(10, 10), SkPaint());  // Outside.
+    recorder.restore();
+    recorder.save();
+        recorder.clipRect(SkRect::MakeLTRB(500, 500, 600, 600));
+        recorder.drawRect(SkRect::MakeWH(100, 100), SkPaint());  // Clipped out entirely.
+    recorder.restore();
+    recorder.drawPaint(SkPaint());                              // Unbounded.
+
+    SkRTreeFactory factory;
+    SkAutoTUnref<SkBBoxHierarchy> bbh(factory(W, H));
+    SkRecordFillBounds(record, bbh);
+
+    SkRecord clipped;
+    SkRecorder clippedRecorder(&clipped, W, H);
+    clippedRecorder.clipRect(SkRect::MakeWH(50, 50));
+    SkRecordDraw(record, &clippedRecorder, bbh);
+
+    // Our clipRect, SkRecordDraw's save, the first drawRect, the drawPaint, SkRecordDraw's restore.
+    REPORTER_ASSERT(r, 5 == clipped.count());
+    assert_type<SkRecords::ClipRect>(r, clipped, 0);
+    assert_type<SkRecords::Save>    (r, clipped, 1);
+    assert_type<SkRecords::DrawRect>(r, clipped, 2);
+    assert_type<SkRecords::DrawPaint>(r, clipped, 3);
+    assert_type<SkRecords::Restore> (r, clipped, 4);
+}
+
+DEF_TEST(RecordDraw_BBHTransparentBlackLayer, r) {
+    SkRecord record;
+    SkRecorder recorder(&record, W, H);
+
+    // kSrc_Mode layers affect every pixel in their clip, no matter where we draw into them.
+    SkPaint paint;
+    paint.setXfermodeMode(SkXfermode::kSrc_Mode);
+    recorder.saveLayer(NULL, &paint);
+        recorder.drawRect(SkRect::MakeLTRB(1000, 1000, 1010, 1010), SkPaint());
+    recorder.restore();
+
+    SkRTreeFactory factory;
+    SkAutoTUnref<SkBBoxHierarchy> bbh(factory(W, H));
+    SkRecordFillBounds(record, bbh);
+
+    SkRecord clipped;
+    SkRecorder clippedRecorder(&clipped, W, H);
+    clippedRecorder.clipRect(SkRect::MakeWH(50, 50));
+    SkRecordDraw(record, &clippedRecorder, bbh);
+
+    // Our clipRect, SkRecordDraw's save, the saveLayer and its restore, SkRecordDraw's restore.
+    // The drawRect itself can still be skipped.
+    REPORTER_ASSERT(r, 5 == clipped.count());
+    assert_type<SkRecords::SaveLayer>(r, clipped, 2);
+    assert_type<SkRecords::Restore>  (r, clipped, 3);
+}
+
+// Blending, antialiasing, and rotation can all legitimately round differently when drawn translated
+// into a tile, so stick to opaque, aliased drawing of exactly representable geometry here.
+static void draw_tiled_scene(SkCanvas* canvas) {
+    SkPaint paint;
+    for (int i = 0; i < 20; i++) {
+        paint.setColor(SkColorSetARGB(0xFF, 13*i, 255 - 11*i, 7*i));
+        canvas->save();
+            canvas->translate(SkIntToScalar(9*i), SkIntToScalar(5*i));
+            canvas->drawRect(SkRect::MakeXYWH(0.25f, 0.75f, 60.5f, 30.25f), paint);
+        canvas->restore();
+    }
+    canvas->clipRect(SkRect::MakeLTRB(50, 50, 150, 150));
+    SkPath triangle;
+    triangle.moveTo(0, 0);
+    triangle.lineTo(200, 40);
+    triangle.lineTo(60, 200);
+    paint.setColor(SK_ColorBLUE);
+    canvas->drawPath(triangle, paint);
+}
+
+DEF_TEST(RecordDraw_Tiled, r) {
+    static const int kW = 250, kH = 180;
+    SkRecord record;
+    SkRecorder recorder(&record, kW, kH);
+    draw_tiled_scene(&recorder);
+
+    SkBitmap expected;
+    expected.allocN32Pixels(kW, kH);
+    expected.eraseColor(SK_ColorWHITE);
+    SkCanvas canvas(expected);
+    SkRecordDraw(record, &canvas);
+
+    SkRTreeFactory factory;
+    SkAutoTUnref<SkBBoxHierarchy> bbh(factory(kW, kH));
+    SkRecordFillBounds(record, bbh);
+
+    for (int useBBH = 0; useBBH < 2; useBBH++) {
+        SkBitmap tiled;
+        tiled.allocN32Pixels(kW, kH);
+        tiled.eraseColor(SK_ColorWHITE);
+        // Tiles that don't evenly divide the bitmap, on a few threads.
+        SkRecordDrawTiled(record, useBBH ? bbh.get() : NULL, tiled, 64, 48, 3);
+
+        SkAutoLockPixels lockExpected(expected), lockTiled(tiled);
+        REPORTER_ASSERT(r, 0 == memcmp(expected.getPixels(), tiled.getPixels(), expected.getSize()));
+    }
+}
+
+DEF_TEST(RecordDraw_BBHTileGrid, r) {
+    SkRecord record;
+    SkRecorder recorder(&record, W, H);
+
+    // Op 0 is stored in the BBH as a NULL datum, and each rect lands in a different tile.
+    const SkRect rects[] = {
+        SkRect::MakeLTRB( 0,  0, 10, 10),
+        SkRect::MakeLTRB(70,  0, 80, 10),
+        SkRect::MakeLTRB( 0, 70, 10, 80),
+        SkRect::MakeLTRB(70, 70, 80, 80),
+    };
+    for (size_t i = 0; i < SK_ARRAY_COUNT(rects); i++) {
+        recorder.drawRect(rects[i], SkPaint());
+    }
+    recorder.drawRect(SkRect::MakeLTRB(1000, 1000, 1010, 1010), SkPaint());  // Outside.
+
+    SkTileGridFactory::TileGridInfo info;
+    info.fTileInterval.set(64, 64);
+    info.fMargin.setEmpty();
+    info.fOffset.setZero();
+    SkTileGridFactory factory(info);
+    SkAutoTUnref<SkBBoxHierarchy> bbh(factory(W, H));
+    SkRecordFillBounds(record, bbh);
+
+    // This clip spans four tiles, so the tile grid has to merge their contents.
+    SkRecord clipped;
+    SkRecorder clippedRecorder(&clipped, W, H);
+    clippedRecorder.clipRect(SkRect::MakeWH(100, 100));
+    SkRecordDraw(record, &clippedRecorder, bbh);
+
+    // Our clipRect, SkRecordDraw's save, the four drawRects in order, SkRecordDraw's restore.
+    REPORTER_ASSERT(r, 7 == clipped.count());
+    assert_type<SkRecords::ClipRect>(r, clipped, 0);
+    assert_type<SkRecords::Save>    (r, clipped, 1);
+    for (unsigned i = 0; i < SK_ARRAY_COUNT(rects); i++) {
+        const SkRecords::DrawRect* drawRect = assert_type<SkRecords::DrawRect>(r, clipped, 2+i);
+        REPORTER_ASSERT(r, NULL != drawRect && drawRect->rect == rects[i]);
+    }
+    assert_type<SkRecords::Restore> (r, clipped, 6);
+}
@@ -8,7 +8,9 @@
 #include "Test.h"
 #include "RecordTestUtils.h"
 
+#include "SkCanvas.h"
 #include "SkRecord.h"
+#include "SkRecordDraw.h"
 #include "SkRecordOpts.h"
 #include "SkRecorder.h"
 #include "SkRecords.h"
@@ -243,3 +245,281 @@ DEF_TEST(RecordOpts_NoopSaveLayerDrawRestore, r) {
     REPORTER_ASSERT(r, drawRect != NULL);
     REPORTER_ASSERT(r, drawRect->paint.getColor() == 0x03020202);
 }
+
+static void draw_record(const SkRecord& record, SkBitmap* bitmap) {
+    bitmap->allocN32Pixels(200, 100);
+    bitmap->eraseColor(SK_ColorTRANSPARENT);
+    SkCanvas canvas(*bitmap);
+    SkRecordDraw(record, &canvas);
+}
+
+static bool same_pixels(const SkBitmap& a, const SkBitmap& b) {
+    SkAutoLockPixels lockA(a), lockB(b);
+    return 0 == memcmp(a.getPixels(), b.getPixels(), a.getSize());
+}
+
+DEF_TEST(RecordOpts_FoldOpaqueSaveLayers, r) {
+    SkRecord record;
+    SkRecorder recorder(&record, W, H);
+
+    SkPaint opaqueLayerPaint, alphaLayerPaint, colorLayerPaint;
+    opaqueLayerPaint.setColor(SK_ColorBLACK);  // Only an opaque alpha.
+    alphaLayerPaint.setColor(0x80000000);      // Not opaque.
+    colorLayerPaint.setColor(SK_ColorRED);     // Not only alpha.
+
+    SkPaint background, wash, opaque, translucent, antialiased, effect;
+    background.setColor(0xFF336699);
+    wash.setColor(0x40996633);
+    opaque.setColor(0xFFFF8000);
+    translucent.setColor(0x80FF8000);
+    antialiased.setColor(0xFFFF8000);
+    antialiased.setAntiAlias(true);
+    effect.setColor(SK_ColorBLUE);
+    effect.setXfermodeMode(SkXfermode::kDstOut_Mode);
+
+    // Something to blend with, partly translucent itself.
+    recorder.drawRect(SkRect::MakeLTRB(0, 0, 100, 100), background);
+    recorder.drawRect(SkRect::MakeLTRB(50, 0, 150, 50), wash);
+
+    // Folded: the layer paint is only an opaque alpha.
+    recorder.saveLayer(NULL, &opaqueLayerPaint);
+        recorder.drawOval(SkRect::MakeLTRB(10, 10, 90, 60), opaque);
+    recorder.restore();
+
+    // Folded: no paint at all.
+    recorder.saveLayer(NULL, NULL);
+        recorder.drawCircle(50, 60, 30.5f, opaque);
+    recorder.restore();
+
+    // No change: bounds clip the draw.
+    SkRect bounds = SkRect::MakeLTRB(0, 0, 40, 40);
+    recorder.saveLayer(&bounds, &opaqueLayerPaint);
+        recorder.drawRect(SkRect::MakeLTRB(20, 20, 80, 80), opaque);
+    recorder.restore();
+
+    // No change: layer paint isn't opaque.
+    recorder.saveLayer(NULL, &alphaLayerPaint);
+        recorder.drawRect(SkRect::MakeLTRB(110, 10, 190, 90), opaque);
+    recorder.restore();
+
+    // No change: layer paint isn't only alpha.
+    recorder.saveLayer(NULL, &colorLayerPaint);
+        recorder.drawRect(SkRect::MakeLTRB(120, 20, 180, 80), opaque);
+    recorder.restore();
+
+    // No change: the draw blends with the layer, not what's below it.
+    recorder.saveLayer(NULL, &opaqueLayerPaint);
+        recorder.drawRect(SkRect::MakeLTRB(30, 30, 70, 70), effect);
+    recorder.restore();
+
+    // No change: translucent pixels would be blended twice.
+    recorder.saveLayer(NULL, NULL);
+        recorder.drawOval(SkRect::MakeLTRB(110, 10, 190, 60), translucent);
+    recorder.restore();
+
+    // No change: so would antialiased edges.
+    recorder.saveLayer(NULL, NULL);
+        recorder.drawCircle(150, 60, 30.5f, antialiased);
+    recorder.restore();
+
+    SkBitmap expected;
+    draw_record(record, &expected);
+
+    SkRecordFoldOpaqueSaveLayers(&record);
+    for (unsigned i = 2; i <= 5; i += 3) {
+        assert_type<SkRecords::NoOp>(r, record, i);
+        assert_type<SkRecords::NoOp>(r, record, i+2);
+    }
+    for (unsigned i = 8; i <= 23; i += 3) {
+        assert_type<SkRecords::SaveLayer>(r, record, i);
+        assert_type<SkRecords::Restore>(r, record, i+2);
+    }
+
+    SkBitmap actual;
+    draw_record(record, &actual);
+    REPORTER_ASSERT(r, same_pixels(expected, actual));
+}
+
+DEF_TEST(RecordOpts_CollapseMatrices, r) {
+    SkRecord record;
+    SkRecorder recorder(&record, W, H);
+
+    SkMatrix translate, scale, identity;
+    translate.setTranslate(10, 20);
+    scale.setScale(2, 3);
+    identity.reset();
+
+    // Only the last SetMatrix matters.
+    recorder.setMatrix(scale);
+    recorder.concat(translate);
+    recorder.setMatrix(translate);
+
+    recorder.drawRect(SkRect::MakeWH(10, 10), SkPaint());
+
+    // Identity concats are dropped, and others fold together.
+    // (SkCanvas won't record an identity concat, so we add it ourselves.)
+    SkNEW_PLACEMENT_ARGS(record.append<SkRecords::Concat>(), SkRecords::Concat, (identity));
+    recorder.concat(translate);
+    recorder.concat(scale);
+
+    recorder.drawRect(SkRect::MakeWH(10, 10), SkPaint());
+
+    // A SetMatrix absorbs the Concats after it.
+    recorder.setMatrix(scale);
+    recorder.concat(translate);
+
+    SkRecordCollapseMatrices(&record);
+
+    assert_type<SkRecords::NoOp>(r, record, 0);
+    assert_type<SkRecords::NoOp>(r, record, 1);
+    REPORTER_ASSERT(r, assert_type<SkRecords::SetMatrix>(r, record, 2)->matrix == translate);
+    assert_type<SkRecords::DrawRect>(r, record, 3);
+
+    SkMatrix expected;
+    expected.setConcat(translate, scale);
+    assert_type<SkRecords::NoOp>(r, record, 4);
+    assert_type<SkRecords::NoOp>(r, record, 5);
+    REPORTER_ASSERT(r, assert_type<SkRecords::Concat>(r, record, 6)->matrix == expected);
+    assert_type<SkRecords::DrawRect>(r, record, 7);
+
+    expected.setConcat(scale, translate);
+    assert_type<SkRecords::NoOp>(r, record, 8);
+    REPORTER_ASSERT(r, assert_type<SkRecords::SetMatrix>(r, record, 9)->matrix == expected);
+}
+
+DEF_TEST(RecordOpts_NoopRedundantClips, r) {
+    SkRecord record;
+    SkRecorder recorder(&record, W, H);
+
+    recorder.clipRect(SkRect::MakeWH(100, 100));    // Kept: we don't know the clip yet.
+    recorder.save();
+        recorder.clipRect(SkRect::MakeWH(200, 200));  // Noop'd: contains the clip.
+        recorder.clipRect(SkRect::MakeWH(50, 50));    // Kept: shrinks the clip.
+        recorder.clipRect(SkRect::MakeWH(60, 60));    // Noop'd.
+        recorder.drawRect(SkRect::MakeWH(10, 10), SkPaint());
+    recorder.restore();
+    recorder.clipRect(SkRect::MakeWH(60, 60));        // Kept: the clip is 100x100 again.
+
+    recorder.scale(2, 2);
+    recorder.clipRect(SkRect::MakeWH(31, 31));        // Noop'd: maps to 62x62.
+    recorder.clipRect(SkRect::MakeWH(29.5f, 29.5f));  // Kept: shrinks the clip.
+
+    recorder.clipRect(SkRect::MakeWH(31, 31), SkRegion::kIntersect_Op, true);  // Kept: AA.
+    recorder.clipRect(SkRect::MakeWH(31, 31));        // Kept: the clip may have AA fringe now.
+
+    recorder.clipRect(SkRect::MakeWH(500, 500), SkRegion::kUnion_Op);  // Kept, and we lose track.
+    recorder.clipRect(SkRect::MakeWH(600, 600));      // Kept.
+
+    SkRecordNoopRedundantClips(&record);
+
+    assert_type<SkRecords::ClipRect>(r, record, 0);
+    assert_type<SkRecords::Save>(r, record, 1);
+    assert_type<SkRecords::NoOp>(r, record, 2);
+    assert_type<SkRecords::ClipRect>(r, record, 3);
+    assert_type<SkRecords::NoOp>(r, record, 4);
+    assert_type<SkRecords::DrawRect>(r, record, 5);
+    assert_type<SkRecords::Restore>(r, record, 6);
+    assert_type<SkRecords::ClipRect>(r, record, 7);
+    assert_type<SkRecords::Concat>(r, record, 8);
+    assert_type<SkRecords::NoOp>(r, record, 9);
+    assert_type<SkRecords::ClipRect>(r, record, 10);
+    assert_type<SkRecords::ClipRect>(r, record, 11);
+    assert_type<SkRecords::ClipRect>(r, record, 12);
+    assert_type<SkRecords::ClipRect>(r, record, 13);
+    assert_type<SkRecords::ClipRect>(r, record, 14);
+}
+
+DEF_TEST(RecordOpts_BatchDrawRects, r) {
+    SkRecord record;
+    SkRecorder recorder(&record, W, H);
+
+    SkPaint red, blue;
+    red.setColor(SK_ColorRED);
+    blue.setColor(SK_ColorBLUE);
+
+    recorder.drawRect(SkRect::MakeXYWH(10, 10, 10, 10), red);
+    recorder.drawRect(SkRect::MakeXYWH(0, 0, 10, 10), blue);
+    recorder.drawRect(SkRect::MakeLTRB(40, 40, 30, 30), red);  // Unsorted rects are fine.
+    recorder.drawRect(SkRect::MakeXYWH(0, 0, 10, 10), blue);   // Different paint, new run.
+    recorder.drawRect(SkRect::MakeXYWH(0, 0, 10, 10), blue);
+    recorder.clipRect(SkRect::MakeWH(100, 100));               // Anything else ends a run.
+    recorder.drawRect(SkRect::MakeXYWH(0, 0, 10, 10), blue);   // Alone, so left alone.
+
+    record.replace<SkRecords::NoOp>(1);  // NoOps should be allowed.
+
+    SkRecordBatchDrawRects(&record);
+
+    const SkRecords::DrawRectBatch* batch = assert_type<SkRecords::DrawRectBatch>(r, record, 0);
+    REPORTER_ASSERT(r, 2 == batch->count);
+    REPORTER_ASSERT(r, batch->paint == red);
+    REPORTER_ASSERT(r, batch->rects[1] == SkRect::MakeLTRB(40, 40, 30, 30));
+    REPORTER_ASSERT(r, batch->bounds == SkRect::MakeLTRB(10, 10, 40, 40));
+    assert_type<SkRecords::NoOp>(r, record, 1);
+    assert_type<SkRecords::NoOp>(r, record, 2);
+
+    batch = assert_type<SkRecords::DrawRectBatch>(r, record, 3);
+    REPORTER_ASSERT(r, 2 == batch->count);
+    REPORTER_ASSERT(r, batch->paint == blue);
+    assert_type<SkRecords::NoOp>(r, record, 4);
+    assert_type<SkRecords::ClipRect>(r, record, 5);
+    assert_type<SkRecords::DrawRect>(r, record, 6);
+}
+
+DEF_TEST(RecordOpts_BatchDrawBitmapRects, r) {
+    SkRecord record;
+    SkRecorder recorder(&record, W, H);
+
+    SkBitmap bitmap, other;
+    bitmap.allocN32Pixels(8, 8);
+    bitmap.eraseColor(SK_ColorGREEN);
+    bitmap.setImmutable();
+    other.allocN32Pixels(8, 8);
+    other.eraseColor(SK_ColorGREEN);
+    other.setImmutable();
+
+    SkPaint translucent;
+    translucent.setAlpha(0x80);
+    const SkRect src = SkRect::MakeWH(4, 4);
+
+    recorder.drawBitmapRectToRect(bitmap, &src, SkRect::MakeXYWH(10, 10, 10, 10));
+    recorder.drawBitmapRectToRect(bitmap, &src, SkRect::MakeLTRB(40, 40, 30, 30));
+    recorder.drawBitmapRectToRect(bitmap, NULL, SkRect::MakeXYWH(0, 0, 10, 10));  // No src.
+    recorder.drawBitmapRectToRect(bitmap, NULL, SkRect::MakeXYWH(0, 10, 10, 10));
+    recorder.drawBitmapRectToRect(bitmap, NULL, SkRect::MakeXYWH(0, 0, 10, 10), &translucent);
+    recorder.drawBitmapRectToRect(bitmap, NULL, SkRect::MakeXYWH(0, 10, 10, 10), &translucent);
+    recorder.drawBitmapRectToRect(other, NULL, SkRect::MakeXYWH(0, 20, 10, 10), &translucent);
+    recorder.drawRect(SkRect::MakeXYWH(0, 0, 10, 10), translucent);  // Other draws end a run.
+    recorder.drawBitmapRectToRect(other, NULL, SkRect::MakeXYWH(0, 30, 10, 10), &translucent);
+
+    SkBitmap expected;
+    draw_record(record, &expected);
+
+    SkRecordBatchDrawRects(&record);
+
+    const SkRecords::DrawBitmapRectBatch* batch =
+        assert_type<SkRecords::DrawBitmapRectBatch>(r, record, 0);
+    REPORTER_ASSERT(r, 2 == batch->count);
+    REPORTER_ASSERT(r, NULL == batch->base->paint);
+    REPORTER_ASSERT(r, batch->srcs[1] == src);
+    REPORTER_ASSERT(r, batch->dsts[1] == SkRect::MakeLTRB(40, 40, 30, 30));
+    REPORTER_ASSERT(r, batch->bounds == SkRect::MakeLTRB(10, 10, 40, 40));
+    assert_type<SkRecords::NoOp>(r, record, 1);
+
+    batch = assert_type<SkRecords::DrawBitmapRectBatch>(r, record, 2);
+    REPORTER_ASSERT(r, 2 == batch->count);
+    REPORTER_ASSERT(r, NULL == batch->srcs);
+    assert_type<SkRecords::NoOp>(r, record, 3);
+
+    batch = assert_type<SkRecords::DrawBitmapRectBatch>(r, record, 4);
+    REPORTER_ASSERT(r, 2 == batch->count);
+    REPORTER_ASSERT(r, *batch->base->paint == translucent);
+    assert_type<SkRecords::NoOp>(r, record, 5);
+
+    assert_type<SkRecords::DrawBitmapRectToRect>(r, record, 6);
+    assert_type<SkRecords::DrawRect>(r, record, 7);
+    assert_type<SkRecords::DrawBitmapRectToRect>(r, record, 8);
+
+    SkBitmap actual;
+    draw_record(record, &actual);
+    REPORTER_ASSERT(r, same_pixels(expected, actual));
+}
@@ -0,0 +1,237 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Test.h"
+#include "RecordTestUtils.h"
+
+#include "SkData.h"
+#include "SkRecord.h"
+#include "SkRecordDraw.h"
+#include "SkRecordOpts.h"
+#include "SkRecordSerialize.h"
+#include "SkRecorder.h"
+#include "SkShader.h"
+
+static const int W = 256, H = 256;
+
+static void draw_scene(SkCanvas* canvas) {
+    SkBitmap bitmap;
+    bitmap.allocN32Pixels(8, 8);
+    bitmap.eraseColor(SK_ColorGREEN);
+    bitmap.setImmutable();
+
+    SkPaint paint;
+    paint.setColor(SK_ColorBLUE);
+
+    SkPaint shaded;
+    shaded.setShader(SkShader::CreateBitmapShader(bitmap, SkShader::kRepeat_TileMode,
+                                                          SkShader::kRepeat_TileMode))->unref();
+
+    SkPath path;
+    path.moveTo(10, 10);
+    path.lineTo(100, 30);
+    path.lineTo(40, 120);
+    path.close();
+
+    canvas->clear(SK_ColorWHITE);
+    canvas->save();
+        canvas->clipRect(SkRect::MakeWH(200, 200));
+        canvas->translate(5, 5);
+        canvas->drawRect(SkRect::MakeWH(50, 50), paint);
+        canvas->drawRect(SkRect::MakeXYWH(60, 0, 20, 20), paint);
+        canvas->drawPath(path, shaded);
+        canvas->drawBitmap(bitmap, 100, 100);
+        canvas->drawBitmapRectToRect(bitmap, NULL, SkRect::MakeXYWH(120, 10, 30, 30), &paint);
+        canvas->drawBitmapRectToRect(bitmap, NULL, SkRect::MakeXYWH(160, 10, 30, 30), &paint);
+        const SkRect src = SkRect::MakeWH(4, 4);
+        canvas->drawBitmapRectToRect(bitmap, &src, SkRect::MakeXYWH(120, 50, 30, 30));
+        canvas->drawBitmapRectToRect(bitmap, &src, SkRect::MakeXYWH(160, 50, 30, 30));
+        canvas->saveLayer(NULL, NULL);
+            canvas->drawOval(SkRect::MakeXYWH(60, 60, 80, 40), paint);
+            canvas->drawText("Hello", 5, 20, 180, paint);
+            const SkScalar xpos[] = { 0, 10, 20, 30, 40 };
+            canvas->drawPosTextH("World", 5, xpos, 200, paint);
+        canvas->restore();
+    canvas->restore();
+    SkRRect rrect;
+    rrect.setOval(SkRect::MakeXYWH(150, 150, 50, 50));
+    canvas->pushCull(SkRect::MakeWH(100, 100));
+        canvas->drawRRect(rrect, paint);
+    canvas->popCull();
+}
+
+static void draw(const SkRecord& record, SkBitmap* bitmap) {
+    bitmap->allocN32Pixels(W, H);
+    bitmap->eraseColor(SK_ColorTRANSPARENT);
+    SkCanvas canvas(*bitmap);
+    SkRecordDraw(record, &canvas);
+}
+
+static bool same_pixels(const SkBitmap& a, const SkBitmap& b) {
+    SkAutoLockPixels lockA(a), lockB(b);
+    return a.getSize() == b.getSize() && 0 == memcmp(a.getPixels(), b.getPixels(), a.getSize());
+}
+
+DEF_TEST(RecordSerialize_RoundTrip, r) {
+    SkRecord record;
+    SkRecorder recorder(&record, W, H);
+    draw_scene(&recorder);
+    // Make sure the optimized forms round trip too.
+    SkRecordOptimize(&record);
+
+    SkAutoTUnref<SkData> data(SkRecordSerialize(record));
+    REPORTER_ASSERT(r, NULL != data.get());
+
+    SkRecord copy;
+    REPORTER_ASSERT(r, SkRecordDeserialize(data->data(), data->size(), &copy));
+    REPORTER_ASSERT(r, record.count() == copy.count());
+
+    assert_type<SkRecords::PairedPushCull>(r, copy, record.count() - 3);
+    assert_type<SkRecords::DrawRectBatch>(r, copy, 4);
+    assert_type<SkRecords::DrawBitmapRectBatch>(r, copy, 8);
+    assert_type<SkRecords::DrawBitmapRectBatch>(r, copy, 10);
+    assert_type<SkRecords::BoundedDrawPosTextH>(r, copy, 15);
+
+    SkBitmap expected, actual;
+    draw(record, &expected);
+    draw(copy, &actual);
+    REPORTER_ASSERT(r, same_pixels(expected, actual));
+
+    // Serializing the copy should give us the same bytes back.
+    SkAutoTUnref<SkData> again(SkRecordSerialize(copy));
+    REPORTER_ASSERT(r, data->equals(again));
+}
+
+DEF_TEST(RecordSerialize_Dedup, r) {
+    // Repeated paints and paths should be stored once.
+    SkRecord same, different;
+    SkRecorder sameRecorder(&same, W, H), differentRecorder(&different, W, H);
+
+    SkPath path;
+    path.addCircle(50, 50, 20);
+    for (int i = 0; i < 100; i++) {
+        SkPaint paint;
+        sameRecorder.drawPath(path, paint);
+        paint.setColor(0xFF000000 | i);
+        differentRecorder.drawPath(path, paint);
+    }
+
+    SkAutoTUnref<SkData> sameData(SkRecordSerialize(same)),
+                         differentData(SkRecordSerialize(different));
+    REPORTER_ASSERT(r, sameData->size() < differentData->size());
+    // Past the single copy of the paint and path, each command costs its type, offset, and indices.
+    REPORTER_ASSERT(r, sameData->size() < 1024 + 100 * (1 + 4 + 2*4));
+}
+
+DEF_TEST(RecordSerialize_Malformed, r) {
+    SkRecord record;
+    SkRecorder recorder(&record, W, H);
+    draw_scene(&recorder);
+    SkAutoTUnref<SkData> data(SkRecordSerialize(record));
+
+    // No truncation of a valid blob should be accepted (or crash).
+    for (size_t length = 0; length < data->size(); length += 4) {
+        SkRecord copy;
+        REPORTER_ASSERT(r, !SkRecordDeserialize(data->data(), length, &copy));
+    }
+
+    // Neither should a blob with the wrong magic or version.
+    SkAutoMalloc storage(data->size());
+    uint32_t* words = (uint32_t*)memcpy(storage.get(), data->data(), data->size());
+    for (int i = 0; i < 2; i++) {
+        words[i] ^= 1;
+        SkRecord copy;
+        REPORTER_ASSERT(r, !SkRecordDeserialize(words, data->size(), &copy));
+        words[i] ^= 1;
+    }
+
+    // An empty SkRecord round trips fine.
+    SkRecord empty, emptyCopy;
+    SkAutoTUnref<SkData> emptyData(SkRecordSerialize(empty));
+    REPORTER_ASSERT(r, SkRecordDeserialize(emptyData->data(), emptyData->size(), &emptyCopy));
+    REPORTER_ASSERT(r, 0 == emptyCopy.count());
+}
+
+// Returns the index of the first 4-byte word of data where needle starts, or -1.
+static int find_words(const SkData* data, const uint32_t needle[], int count) {
+    const uint32_t* words = (const uint32_t*)data->data();
+    const int wordCount = SkToInt(data->size() / 4);
+    for (int i = 0; i + count <= wordCount; i++) {
+        if (0 == memcmp(words + i, needle, count * sizeof(uint32_t))) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Overwrites word index of data with each of values in turn, asserting the result is rejected.
+static void assert_rejected(skiatest::Reporter* r, const SkData* data, int index,
+                            const uint32_t values[], int count) {
+    REPORTER_ASSERT(r, index >= 0);
+    if (index < 0) {
+        return;
+    }
+    SkAutoMalloc storage(data->size());
+    uint32_t* words = (uint32_t*)memcpy(storage.get(), data->data(), data->size());
+    for (int i = 0; i < count; i++) {
+        words[index] = values[i];
+        SkRecord copy;
+        REPORTER_ASSERT(r, !SkRecordDeserialize(words, data->size(), &copy));
+    }
+}
+
+DEF_TEST(RecordSerialize_MismatchedCounts, r) {
+    // Position arrays must hold exactly one position per glyph.
+    {
+        SkRecord record;
+        SkRecorder recorder(&record, W, H);
+        const SkPoint pos[] = { {1.5f, 2.5f}, {3.5f, 4.5f}, {5.5f, 6.5f} };
+        recorder.drawPosText("abc", 3, pos, SkPaint());
+        const SkScalar xpos[] = { 7.5f, 8.5f, 9.5f };
+        recorder.drawPosTextH("abc", 3, xpos, 10, SkPaint());
+        SkAutoTUnref<SkData> data(SkRecordSerialize(record));
+
+        SkRecord copy;
+        REPORTER_ASSERT(r, SkRecordDeserialize(data->data(), data->size(), &copy));
+
+        // Each array is its count followed by its elements.  Shrinking the count makes the
+        // array too short for the text; growing it borrows the words that follow.
+        const uint32_t counts[] = { 0, 1, 2, 4 };
+        const uint32_t posArray[] = {
+            3, (uint32_t)SkFloat2Bits(1.5f), (uint32_t)SkFloat2Bits(2.5f)
+        };
+        assert_rejected(r, data, find_words(data, posArray, SK_ARRAY_COUNT(posArray)),
+                        counts, SK_ARRAY_COUNT(counts));
+        const uint32_t xposArray[] = {
+            3, (uint32_t)SkFloat2Bits(7.5f), (uint32_t)SkFloat2Bits(8.5f)
+        };
+        assert_rejected(r, data, find_words(data, xposArray, SK_ARRAY_COUNT(xposArray)),
+                        counts, SK_ARRAY_COUNT(counts));
+    }
+
+    // Vertex indices must stay inside the vertex arrays.
+    {
+        SkRecord record;
+        SkRecorder recorder(&record, W, H);
+        const SkPoint verts[] = { {0, 0}, {10, 0}, {0, 10} };
+        const SkColor colors[] = { SK_ColorRED, SK_ColorGREEN, SK_ColorBLUE };
+        const uint16_t indices[] = { 0, 1, 2, 1 };
+        recorder.drawVertices(SkCanvas::kTriangles_VertexMode, 3, verts, NULL, colors,
+                              NULL, indices, 4, SkPaint());
+        SkAutoTUnref<SkData> data(SkRecordSerialize(record));
+
+        SkRecord copy;
+        REPORTER_ASSERT(r, SkRecordDeserialize(data->data(), data->size(), &copy));
+
+        // The index array is its count, then the indices two to a word.
+        const uint32_t indexArray[] = { 4, 0 | (1 << 16), 2 | (1 << 16) };
+        const int index = find_words(data, indexArray, SK_ARRAY_COUNT(indexArray));
+        const uint32_t badIndices[] = { 3 | (1 << 16), 2 | (3 << 16), 0xFFFFFFFF };
+        assert_rejected(r, data, index < 0 ? -1 : index + 2,
+                        badIndices, SK_ARRAY_COUNT(badIndices));
+    }
+}
@@ -7,6 +7,8 @@
 
 #include "Test.h"
 
+#include "SkBBHFactory.h"
+#include "SkData.h"
 #include "SkRecording.h"
 
 // Minimally exercise the public SkRecording API.
@@ -26,4 +28,19 @@ DEF_TEST(RecordingTest, r) {
     // However pointless, this should be safe.
     EXPERIMENTAL::SkRecording pointless(1920, 1080);
     pointless.canvas()->clipRect(SkRect::MakeWH(320, 240));
+
+    // A recording with a BBH should play back the same way.
+    SkRTreeFactory factory;
+    EXPERIMENTAL::SkRecording withBBH(1920, 1080, &factory);
+    withBBH.canvas()->drawRect(SkRect::MakeWH(320, 240), SkPaint());
+    SkAutoTDelete<const EXPERIMENTAL::SkPlayback> bbhPlayback(withBBH.releasePlayback());
+    bbhPlayback->draw(&target);
+
+    // Playbacks can be serialized and loaded back.
+    SkAutoTUnref<SkData> data(bbhPlayback->serialize());
+    SkAutoTDelete<const EXPERIMENTAL::SkPlayback> loaded(
+            EXPERIMENTAL::SkPlayback::Deserialize(data->data(), data->size()));
+    REPORTER_ASSERT(r, NULL != loaded.get());
+    loaded->draw(&target);
+    REPORTER_ASSERT(r, NULL == EXPERIMENTAL::SkPlayback::Deserialize(data->data(), 4));
 }
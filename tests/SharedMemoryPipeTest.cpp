@@ -0,0 +1,111 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SharedMemoryPipeController.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkGPipe.h"
+#include "SkPaint.h"
+#include "SkRandom.h"
+#include "SkThreadUtils.h"
+#include "Test.h"
+
+// Enough drawing, and enough distinct bitmaps, to go around a minimum size ring several times.
+static void draw_lots(SkCanvas* canvas) {
+    SkRandom rand;
+    SkBitmap bitmaps[20];
+    for (size_t i = 0; i < SK_ARRAY_COUNT(bitmaps); ++i) {
+        bitmaps[i].allocN32Pixels(32, 32);
+        bitmaps[i].eraseColor(rand.nextU() | 0xFF000000);
+    }
+    SkPaint paint;
+    for (int i = 0; i < 5000; ++i) {
+        paint.setColor(rand.nextU() | 0xFF000000);
+        SkRect r = SkRect::MakeXYWH(rand.nextRangeScalar(0, 48), rand.nextRangeScalar(0, 48),
+                                    16, 16);
+        canvas->drawRect(r, paint);
+        if (0 == i % 100) {
+            canvas->drawBitmap(bitmaps[(i / 100) % SK_ARRAY_COUNT(bitmaps)],
+                               rand.nextRangeScalar(0, 32), rand.nextRangeScalar(0, 32));
+        }
+    }
+}
+
+struct SharedMemoryPlayback {
+    void*     fMemory;
+    SkCanvas* fCanvas;
+    bool      fSucceeded;
+};
+
+static void play_shared_memory_pipe(void* data) {
+    SharedMemoryPlayback* playback = static_cast<SharedMemoryPlayback*>(data);
+    SharedMemoryPipeReader reader(playback->fMemory, playback->fCanvas);
+    playback->fSucceeded = reader.playbackUntilDone();
+}
+
+// Bitmaps big enough that, flattened, they plus the skip to the start of the ring need more than
+// a whole minimum size ring unless they happen to land near its start.
+static void draw_large_bitmaps(SkCanvas* canvas) {
+    SkRandom rand;
+    SkBitmap bitmaps[4];
+    for (size_t i = 0; i < SK_ARRAY_COUNT(bitmaps); ++i) {
+        bitmaps[i].allocN32Pixels(112, 112);  // About 49KB.
+        bitmaps[i].eraseColor(rand.nextU() | 0xFF000000);
+    }
+    SkPaint paint;
+    for (int i = 0; i < 2000; ++i) {
+        paint.setColor(rand.nextU() | 0xFF000000);
+        canvas->drawRect(SkRect::MakeXYWH(rand.nextRangeScalar(0, 48),
+                                          rand.nextRangeScalar(0, 48), 16, 16), paint);
+        if (699 == i % 700) {
+            canvas->drawBitmap(bitmaps[(i / 700) % SK_ARRAY_COUNT(bitmaps)],
+                               -rand.nextRangeScalar(0, 48), -rand.nextRangeScalar(0, 48));
+        }
+    }
+}
+
+static void test_shared_memory_pipe(skiatest::Reporter* reporter, void (*draw)(SkCanvas*)) {
+    size_t bytes = SharedMemoryPipeController::MemorySize(SharedMemoryPipeController::kMinRingBytes);
+    SkAutoTDelete<SharedMemory> shared(SharedMemory::Create(NULL, bytes));
+    if (NULL == shared.get()) {
+        return;  // Not supported on this platform.
+    }
+    REPORTER_ASSERT(reporter, SharedMemoryPipeController::Initialize(shared->memory(), bytes));
+
+    SkBitmap expected, actual;
+    expected.allocN32Pixels(64, 64);
+    expected.eraseColor(SK_ColorWHITE);
+    actual.allocN32Pixels(64, 64);
+    actual.eraseColor(SK_ColorWHITE);
+    {
+        SkCanvas canvas(expected);
+        draw(&canvas);
+    }
+
+    SkCanvas canvas(actual);
+    SharedMemoryPlayback playback = { shared->memory(), &canvas, false };
+    SkThread reader(play_shared_memory_pipe, &playback);
+    reader.start();
+    {
+        SharedMemoryPipeController controller(shared->memory());
+        SkGPipeWriter writer;
+        SkCanvas* pipeCanvas = writer.startRecording(&controller,
+                                                     SkGPipeWriter::kCrossProcess_Flag, 64, 64);
+        draw(pipeCanvas);
+        writer.endRecording();
+    }
+    reader.join();
+
+    REPORTER_ASSERT(reporter, playback.fSucceeded);
+    REPORTER_ASSERT(reporter, 0 == memcmp(expected.getPixels(), actual.getPixels(),
+                                          expected.getSize()));
+}
+
+DEF_TEST(Pipe_SharedMemory, reporter) {
+    test_shared_memory_pipe(reporter, draw_lots);
+    test_shared_memory_pipe(reporter, draw_large_bitmaps);
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkTaskGroup.h"
+#include "SkThread.h"
+#include "Test.h"
+
+namespace {
+
+class Increment : public SkRunnable {
+public:
+    Increment() : fCount(NULL) {}
+    int32_t* fCount;
+
+    virtual void run() SK_OVERRIDE { sk_atomic_inc(fCount); }
+};
+
+// Spawns two children into its own group until depth runs out, waiting on them before finishing.
+// Every node counts itself, so a tree of depth d counts 2^(d+1) - 1.
+class Fork : public SkRunnable {
+public:
+    Fork(SkTaskScheduler* scheduler, int depth, int32_t* count)
+        : fScheduler(scheduler), fDepth(depth), fCount(count) {}
+
+    virtual void run() SK_OVERRIDE {
+        if (fDepth > 0) {
+            Fork left(fScheduler, fDepth - 1, fCount),
+                 right(fScheduler, fDepth - 1, fCount);
+            SkTaskGroup children(fScheduler);
+            children.add(&left);
+            children.add(&right);
+            children.wait();
+        }
+        sk_atomic_inc(fCount);
+    }
+
+private:
+    SkTaskScheduler* fScheduler;
+    int fDepth;
+    int32_t* fCount;
+};
+
+}  // namespace
+
+static void test_groups(skiatest::Reporter* r, SkTaskScheduler* scheduler) {
+    static const int kTasks = 100;
+    Increment a[kTasks], b[kTasks];
+    int32_t countA = 0, countB = 0;
+    for (int i = 0; i < kTasks; i++) {
+        a[i].fCount = &countA;
+        b[i].fCount = &countB;
+    }
+
+    // Two groups sharing a scheduler can be waited on independently.
+    SkTaskGroup groupA(scheduler), groupB(scheduler);
+    for (int i = 0; i < kTasks; i++) {
+        groupA.add(&a[i]);
+        groupB.add(&b[i]);
+    }
+    groupA.wait();
+    REPORTER_ASSERT(r, kTasks == sk_acquire_load(&countA));
+    groupB.wait();
+    REPORTER_ASSERT(r, kTasks == sk_acquire_load(&countB));
+
+    // Groups can be reused after wait().
+    for (int i = 0; i < kTasks; i++) {
+        groupA.add(&a[i]);
+    }
+    groupA.wait();
+    REPORTER_ASSERT(r, 2*kTasks == sk_acquire_load(&countA));
+
+    // Work may add work to its own groups and wait on them.
+    int32_t nodes = 0;
+    Fork root(scheduler, 8, &nodes);
+    SkTaskGroup tree(scheduler);
+    tree.add(&root);
+    tree.add(NULL);  // Should be a no-op.
+    tree.wait();
+    REPORTER_ASSERT(r, (1 << 9) - 1 == sk_acquire_load(&nodes));
+}
+
+DEF_TEST(TaskGroup, r) {
+    test_groups(r, NULL);
+
+    SkTaskScheduler synchronous(0);
+    REPORTER_ASSERT(r, 0 == synchronous.threadCount());
+    test_groups(r, &synchronous);
+
+    SkTaskScheduler one(1);
+    test_groups(r, &one);
+
+    SkTaskScheduler many(4);
+    REPORTER_ASSERT(r, 4 == many.threadCount());
+    test_groups(r, &many);
+}
@@ -219,3 +219,30 @@ DEF_TEST(Utils, reporter) {
     test_autounref(reporter);
     test_autostarray(reporter);
 }
+
+DEF_TEST(Utils_CountLeading, reporter) {
+    char utf8[40];
+    uint16_t utf16[40];
+    memset(utf8, 'a', sizeof(utf8));
+    for (int i = 0; i < 40; i++) {
+        utf16[i] = SkToU16(0x4E00 + i);
+    }
+    // Put the first non-ASCII byte, or surrogate, at each index in turn, and look at each prefix.
+    for (int stop = 0; stop <= 40; stop++) {
+        if (stop < 40) {
+            utf8[stop] = '\xC3';
+            utf16[stop] = 0xD834;
+        }
+        for (int count = 0; count <= 40; count++) {
+            REPORTER_ASSERT(reporter, SkUTF8_CountLeadingASCII(utf8, count) == SkTMin(stop, count));
+            REPORTER_ASSERT(reporter, SkUTF16_CountLeadingNonSurrogates(utf16, count) ==
+                                      SkTMin(stop, count));
+        }
+        if (stop < 40) {
+            utf8[stop] = 'a';
+            utf16[stop] = 0xDFFF;   // Low surrogates stop it too.
+            REPORTER_ASSERT(reporter, SkUTF16_CountLeadingNonSurrogates(utf16, 40) == stop);
+            utf16[stop] = 0xE000;   // But the next value up doesn't.
+        }
+    }
+}
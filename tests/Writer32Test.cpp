@@ -312,3 +312,78 @@ DEF_TEST(Writer32_snapshot_dynamic, reporter) {
     // test it triggered COW anyway
     REPORTER_ASSERT(reporter, writer.contiguousArray() != beforeData);
 }
+
+static void test_segments(skiatest::Reporter* reporter) {
+    SkChunkAlloc arena(64);
+    uint32_t storage[4];
+    SkWriter32 writer(storage, sizeof(storage));
+    writer.useSegments(32, &arena);
+    REPORTER_ASSERT(reporter, writer.isSegmented());
+
+    int32_t expected[100];
+    for (int i = 0; i < 100; ++i) {
+        expected[i] = i;
+        writer.writeInt(i);
+    }
+    // A record larger than a segment gets one of its own.
+    const SkRect rects[4] = { SkRect::MakeWH(1, 2), SkRect::MakeWH(3, 4),
+                              SkRect::MakeWH(5, 6), SkRect::MakeWH(7, 8) };
+    writer.write(rects, sizeof(rects));
+    REPORTER_ASSERT(reporter, writer.bytesWritten() == sizeof(expected) + sizeof(rects));
+
+    // The first segment is the external storage, and nothing has been copied.
+    SkTDArray<SkWriter32::Segment> segments;
+    writer.getSegments(&segments);
+    REPORTER_ASSERT(reporter, segments.count() > 2);
+    REPORTER_ASSERT(reporter, segments[0].fData == storage);
+    REPORTER_ASSERT(reporter, segments[0].fSize == sizeof(storage));
+    REPORTER_ASSERT(reporter, !memcmp(segments.top().fData, rects, sizeof(rects)));
+    size_t total = 0;
+    for (int i = 0; i < segments.count(); ++i) {
+        REPORTER_ASSERT(reporter, !memcmp(segments[i].fData, (const char*)expected + total,
+                                          SkTMin(segments[i].fSize, sizeof(expected) - total)));
+        total += segments[i].fSize;
+    }
+    REPORTER_ASSERT(reporter, total == writer.bytesWritten());
+
+    // Records in earlier segments can still be read and patched.
+    for (int i = 0; i < 100; ++i) {
+        REPORTER_ASSERT(reporter, writer.readTAt<int32_t>(i * 4) == i);
+    }
+    writer.overwriteTAt<int32_t>(13 * 4, -13);
+    expected[13] = -13;
+    REPORTER_ASSERT(reporter, writer.readTAt<int32_t>(13 * 4) == -13);
+    REPORTER_ASSERT(reporter, writer.readTAt<SkRect>(sizeof(expected) + sizeof(SkRect)) ==
+                              rects[1]);
+
+    // Rewinding into an earlier segment carries on writing from there.
+    writer.rewindToOffset(50 * 4);
+    for (int i = 50; i < 100; ++i) {
+        expected[i] = -i;
+        writer.writeInt(-i);
+    }
+    check_contents(reporter, writer, expected, sizeof(expected));
+
+    SkDynamicMemoryWStream stream;
+    REPORTER_ASSERT(reporter, writer.writeToStream(&stream));
+    SkAutoDataUnref streamed(stream.copyToData());
+    REPORTER_ASSERT(reporter, streamed->equals(SkAutoDataUnref(writer.snapshotAsData())));
+    REPORTER_ASSERT(reporter, !memcmp(streamed->data(), expected, sizeof(expected)));
+
+    // Segmented mode lasts across reset(), and an owned arena works the same.
+    writer.reset();
+    REPORTER_ASSERT(reporter, writer.isSegmented());
+    test2(reporter, &writer);
+
+    SkWriter32 owned;
+    owned.useSegments(16);
+    test1(reporter, &owned);
+    owned.reset();
+    testWritePad(reporter, &owned);
+    owned.reset();
+    testOverwriteT(reporter, &owned);
+}
+
+DEF_TEST(Writer32_segmented, reporter) {
+    test_segments(reporter);
+}
@@ -6,7 +6,11 @@
  */
 
 #include "SkColor.h"
+#include "SkColorPriv.h"
+#include "SkRandom.h"
+#include "SkUtils.h"
 #include "SkXfermode.h"
+#include "SkXfermode_proccoeff.h"
 #include "Test.h"
 
 #define ILLEGAL_MODE    ((SkXfermode::Mode)-1)
@@ -55,3 +59,53 @@ DEF_TEST(Xfermode, reporter) {
     test_asMode(reporter);
     test_IsMode(reporter);
 }
+
+extern SkProcCoeffXfermode* SkPlatformXfermodeFactory(const ProcCoeff& rec, SkXfermode::Mode mode);
+
+static SkProcCoeffXfermode* create_platform_xfermode(SkXfermode::Mode mode, int simdLevelCap) {
+    ProcCoeff rec;
+    rec.fProc = SkXfermode::GetProc(mode);
+    if (!SkXfermode::ModeAsCoeff(mode, &rec.fSC, &rec.fDC)) {
+        rec.fSC = rec.fDC = CANNOT_USE_COEFF;
+    }
+    int prevCap = SkSetSIMDLevelCap(simdLevelCap);
+    SkProcCoeffXfermode* xfer = SkPlatformXfermodeFactory(rec, mode);
+    SkSetSIMDLevelCap(prevCap);
+    return xfer;
+}
+
+// The widest SIMD xfermodes must match the SSE2 ones bit for bit, whatever the alignment and length.
+DEF_TEST(Xfermode_SIMDLevels, reporter) {
+    static const int N = 67;
+    SkPMColor src[N], dst[N], expected[N], actual[N];
+    SkAlpha aa[N];
+    SkRandom rand;
+    for (int i = 0; i < N; i++) {
+        U8CPU a = 0 == i % 7 ? 0xFF : rand.nextU() & 0xFF;
+        src[i] = SkPreMultiplyColor(SkColorSetA(rand.nextU(), a));
+        dst[i] = SkPreMultiplyColor(rand.nextU());
+        aa[i] = rand.nextU() & 0xFF;
+    }
+
+    for (int m = 0; m <= SkXfermode::kLastMode; m++) {
+        SkXfermode::Mode mode = (SkXfermode::Mode)m;
+        SkAutoTUnref<SkProcCoeffXfermode> sse2(create_platform_xfermode(mode,
+                                                                        SK_CPU_SSE_LEVEL_SSE2));
+        SkAutoTUnref<SkProcCoeffXfermode> best(create_platform_xfermode(mode, SK_MaxS32));
+        if (NULL == sse2.get() || NULL == best.get()) {
+            continue;
+        }
+        for (int offset = 0; offset < 8; offset++) {
+            for (int useAA = 0; useAA < 2; useAA++) {
+                const int count = N - offset;
+                const SkAlpha* coverage = useAA ? aa + offset : NULL;
+                memcpy(expected, dst, sizeof(dst));
+                memcpy(actual, dst, sizeof(dst));
+                sse2->xfer32(expected + offset, src + offset, count, coverage);
+                best->xfer32(actual + offset, src + offset, count, coverage);
+                REPORTER_ASSERT_MESSAGE(reporter, 0 == memcmp(expected, actual, sizeof(dst)),
+                                        SkXfermode::ModeName(mode));
+            }
+        }
+    }
+}
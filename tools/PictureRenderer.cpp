@@ -709,7 +709,7 @@ class CloneData : public SkRunnable {
 
 public:
     CloneData(SkPicture* clone, SkCanvas* canvas, SkTDArray<SkRect>& rects, int start, int end,
-              SkRunnable* done, ImageResultsAndExpectations* jsonSummaryPtr,
+              ImageResultsAndExpectations* jsonSummaryPtr,
               bool useChecksumBasedFilenames, bool enableWrites)
         : fClone(clone)
         , fCanvas(canvas)
@@ -718,11 +718,8 @@ public:
         , fStart(start)
         , fEnd(end)
         , fSuccess(NULL)
-        , fDone(done)
         , fJsonSummaryPtr(jsonSummaryPtr)
-        , fUseChecksumBasedFilenames(useChecksumBasedFilenames) {
-        SkASSERT(fDone != NULL);
-    }
+        , fUseChecksumBasedFilenames(useChecksumBasedFilenames) {}
 
     virtual void run() SK_OVERRIDE {
         SkGraphics::SetTLSFontCacheLimit(1024 * 1024);
@@ -756,7 +753,6 @@ public:
                 }
             }
         }
-        fDone->run();
     }
 
     void setPathsAndSuccess(const SkString& writePath, const SkString& mismatchPath,
@@ -786,7 +782,6 @@ private:
     const int          fEnd;
     bool*              fSuccess;    // Only meaningful if path is non-null. Shared by all threads,
                                     // and only set to false upon failure to write to a PNG.
-    SkRunnable*        fDone;
     SkBitmap*          fBitmap;
     ImageResultsAndExpectations* fJsonSummaryPtr;
     bool               fUseChecksumBasedFilenames;
@@ -794,8 +789,7 @@ private:
 
 MultiCorePictureRenderer::MultiCorePictureRenderer(int threadCount)
 : fNumThreads(threadCount)
-, fThreadPool(threadCount)
-, fCountdown(threadCount) {
+, fScheduler(threadCount) {
     // Only need to create fNumThreads - 1 clones, since one thread will use the base
     // picture.
     fPictureClones = SkNEW_ARRAY(SkPicture, fNumThreads - 1);
@@ -827,8 +821,8 @@ void MultiCorePictureRenderer::init(SkPicture *pict, const SkString* writePath,
         const int start = i * chunkSize;
         const int end = SkMin32(start + chunkSize, fTileRects.count());
         fCloneData[i] = SkNEW_ARGS(CloneData,
-                                   (pic, fCanvasPool[i], fTileRects, start, end, &fCountdown,
-                                    fJsonSummaryPtr, useChecksumBasedFilenames, fEnableWrites));
+                                   (pic, fCanvasPool[i], fTileRects, start, end, fJsonSummaryPtr,
+                                    useChecksumBasedFilenames, fEnableWrites));
     }
 }
 
@@ -852,11 +846,11 @@ bool MultiCorePictureRenderer::render(SkBitmap** out) {
         }
     }
 
-    fCountdown.reset(fNumThreads);
+    SkTaskGroup tiles(&fScheduler);
     for (int i = 0; i < fNumThreads; i++) {
-        fThreadPool.add(fCloneData[i]);
+        tiles.add(fCloneData[i]);
     }
-    fCountdown.wait();
+    tiles.wait();
 
     return success;
 }
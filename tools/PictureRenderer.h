@@ -9,7 +9,6 @@
 #define PictureRenderer_DEFINED
 
 #include "SkCanvas.h"
-#include "SkCountdown.h"
 #include "SkDrawFilter.h"
 #include "SkMath.h"
 #include "SkPaint.h"
@@ -19,8 +18,8 @@
 #include "SkRefCnt.h"
 #include "SkRunnable.h"
 #include "SkString.h"
+#include "SkTaskGroup.h"
 #include "SkTDArray.h"
-#include "SkThreadPool.h"
 #include "SkTypes.h"
 
 #if SK_SUPPORT_GPU
@@ -623,10 +622,9 @@ private:
 
     const int            fNumThreads;
     SkTDArray<SkCanvas*> fCanvasPool;
-    SkThreadPool         fThreadPool;
+    SkTaskScheduler      fScheduler;
     SkPicture*           fPictureClones;
     CloneData**          fCloneData;
-    SkCountdown          fCountdown;
 
     typedef TiledPictureRenderer INHERITED;
 };
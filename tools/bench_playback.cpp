@@ -6,12 +6,17 @@
  */
 
 #include "BenchTimer.h"
+#include "SkBitmap.h"
 #include "SkCommandLineFlags.h"
 #include "SkForceLinking.h"
 #include "SkGraphics.h"
 #include "SkOSFile.h"
 #include "SkPicture.h"
 #include "SkPictureRecorder.h"
+#include "SkRecord.h"
+#include "SkRecordDraw.h"
+#include "SkRecordOpts.h"
+#include "SkRecorder.h"
 #include "SkRecording.h"
 #include "SkStream.h"
 #include "SkString.h"
@@ -21,7 +26,11 @@ __SK_FORCE_IMAGE_DECODER_LINKING;
 DEFINE_string2(skps, r, "skps", "Directory containing SKPs to read and re-record.");
 DEFINE_int32(loops, 10, "Number of times to play back each SKP.");
 DEFINE_bool(skr, false, "Play via SkRecord instead of SkPicture.");
+DEFINE_bool(skrbbh, true, "When playing via SkRecord, use a tile grid BBH like SkPicture does.");
 DEFINE_int32(tile, 1000000000, "Simulated tile size.");
+DEFINE_int32(threads, 0, "If positive, play via SkRecord, drawing all tiles on this many threads.");
+DEFINE_bool(opts, false, "Play each SKP via SkRecord once per SkRecordOpts pass, "
+                        "and once with all of them, to see what each pass buys us.");
 DEFINE_string(match, "", "The usual filters on file names of SKPs to bench.");
 DEFINE_string(timescale, "ms", "Print times in ms, us, or ns");
 
@@ -31,12 +40,16 @@ static double scale_time(double ms) {
     return ms;
 }
 
-static SkPicture* rerecord_with_tilegrid(SkPicture& src) {
+static SkTileGridFactory::TileGridInfo tile_grid_info() {
     SkTileGridFactory::TileGridInfo info;
     info.fTileInterval.set(FLAGS_tile, FLAGS_tile);
     info.fMargin.setEmpty();
     info.fOffset.setZero();
-    SkTileGridFactory factory(info);
+    return info;
+}
+
+static SkPicture* rerecord_with_tilegrid(SkPicture& src) {
+    SkTileGridFactory factory(tile_grid_info());
 
     SkPictureRecorder recorder;
     src.draw(recorder.beginRecording(src.width(), src.height(), &factory,
@@ -45,7 +58,10 @@ static SkPicture* rerecord_with_tilegrid(SkPicture& src) {
 }
 
 static EXPERIMENTAL::SkPlayback* rerecord_with_skr(SkPicture& src) {
-    EXPERIMENTAL::SkRecording recording(src.width(), src.height());
+    SkTileGridFactory factory(tile_grid_info());
+
+    EXPERIMENTAL::SkRecording recording(src.width(), src.height(),
+                                        FLAGS_skrbbh ? &factory : NULL);
     src.draw(recording.canvas());
     return recording.releasePlayback();
 }
@@ -60,10 +76,16 @@ static void bench(SkPMColor* scratch, SkPicture& src, const char* name) {
                                                                 src.width() * sizeof(SkPMColor)));
     canvas->clipRect(SkRect::MakeWH(SkIntToScalar(FLAGS_tile), SkIntToScalar(FLAGS_tile)));
 
+    SkBitmap bitmap;
+    bitmap.installPixels(SkImageInfo::MakeN32Premul(src.width(), src.height()),
+                         scratch, src.width() * sizeof(SkPMColor));
+
     BenchTimer timer;
     timer.start();
     for (int i = 0; i < FLAGS_loops; i++) {
-        if (FLAGS_skr) {
+        if (FLAGS_threads > 0) {
+            record->drawTiled(bitmap, FLAGS_tile, FLAGS_tile, FLAGS_threads);
+        } else if (FLAGS_skr) {
             record->draw(canvas.get());
         } else {
             picture->draw(canvas.get());
@@ -75,6 +97,62 @@ static void bench(SkPMColor* scratch, SkPicture& src, const char* name) {
     printf("%f\t%s\n", scale_time(msPerLoop), name);
 }
 
+static const struct {
+    const char* name;
+    void (*pass)(SkRecord*);
+} kPasses[] = {
+    { "none",                NULL },
+    { "noopCulls",           SkRecordNoopCulls },
+    { "noopSaveRestores",    SkRecordNoopSaveRestores },
+    { "noopSaveLayers",      SkRecordNoopSaveLayerDrawRestores },
+    { "collapseMatrices",    SkRecordCollapseMatrices },
+    { "noopRedundantClips",  SkRecordNoopRedundantClips },
+    { "annotateCulls",       SkRecordAnnotateCullingPairs },
+    { "reduceText",          SkRecordReduceDrawPosTextStrength },
+    { "boundText",           SkRecordBoundDrawPosTextH },
+    { "batchDrawRects",      SkRecordBatchDrawRects },
+    { "all",                 SkRecordOptimize },
+};
+
+struct NonNoOpCounter {
+    NonNoOpCounter() : count(0) {}
+    template <typename T> void operator()(const T&) { count++; }
+    void operator()(const SkRecords::NoOp&) {}
+    unsigned count;
+};
+
+static void bench_opts(SkPMColor* scratch, SkPicture& src, const char* name) {
+    SkAutoTDelete<SkCanvas> canvas(SkCanvas::NewRasterDirectN32(src.width(),
+                                                                src.height(),
+                                                                scratch,
+                                                                src.width() * sizeof(SkPMColor)));
+    canvas->clipRect(SkRect::MakeWH(SkIntToScalar(FLAGS_tile), SkIntToScalar(FLAGS_tile)));
+
+    for (size_t i = 0; i < SK_ARRAY_COUNT(kPasses); i++) {
+        SkRecord record;
+        SkRecorder recorder(&record, src.width(), src.height());
+        src.draw(&recorder);
+        if (kPasses[i].pass) {
+            kPasses[i].pass(&record);
+        }
+
+        NonNoOpCounter ops;
+        for (unsigned j = 0; j < record.count(); j++) {
+            record.visit<void>(j, ops);
+        }
+
+        BenchTimer timer;
+        timer.start();
+        for (int j = 0; j < FLAGS_loops; j++) {
+            SkRecordDraw(record, canvas.get());
+        }
+        timer.end();
+
+        const double msPerLoop = timer.fCpu / (double)FLAGS_loops;
+        printf("%f\t%s\t%s\t%u ops\n", scale_time(msPerLoop), name, kPasses[i].name, ops.count);
+    }
+}
+
 int tool_main(int argc, char** argv);
 int tool_main(int argc, char** argv) {
     SkCommandLineFlags::Parse(argc, argv);
@@ -114,7 +192,11 @@ int tool_main(int argc, char** argv) {
             continue;
         }
 
-        bench(scratch.get(), *src, filename.c_str());
+        if (FLAGS_opts) {
+            bench_opts(scratch.get(), *src, filename.c_str());
+        } else {
+            bench(scratch.get(), *src, filename.c_str());
+        }
     }
     return failed ? 1 : 0;
 }